@@ -16,6 +16,8 @@
 #include <mbgl/android/native_map_view.hpp>
 #include <mbgl/map/map.hpp>
 #include <mbgl/platform/android/log_android.hpp>
+#include <mbgl/platform/android/trace_android.hpp>
+#include <mbgl/platform/async_log.hpp>
 #include <mbgl/platform/event.hpp>
 #include <mbgl/platform/log.hpp>
 
@@ -709,7 +711,8 @@ nativeSetReachability(JNIEnv *env, jobject obj, jlong nativeMapViewPtr, jboolean
 extern "C" {
 
 extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
-    mbgl::Log::Set<mbgl::AndroidLogBackend>();
+    mbgl::Log::Set<mbgl::AsyncLogBackend>(mbgl::util::make_unique<mbgl::AndroidLogBackend>());
+    mbgl::Trace::Set<mbgl::AndroidTraceBackend>();
 
     mbgl::Log::Debug(mbgl::Event::JNI, "JNI_OnLoad");
 
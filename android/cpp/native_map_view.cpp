@@ -613,6 +613,59 @@ void NativeMapView::loadExtensions() {
         assert(gl::IsVertexArray != nullptr);
     }
 
+    if (extensions.find("GL_EXT_instanced_arrays") != std::string::npos) {
+        mbgl::Log::Info(mbgl::Event::OpenGL, "Using GL_EXT_instanced_arrays.");
+        gl::VertexAttribDivisor = reinterpret_cast<gl::PFNGLVERTEXATTRIBDIVISORPROC>(
+            eglGetProcAddress("glVertexAttribDivisorEXT"));
+        gl::DrawArraysInstanced = reinterpret_cast<gl::PFNGLDRAWARRAYSINSTANCEDPROC>(
+            eglGetProcAddress("glDrawArraysInstancedEXT"));
+        assert(gl::VertexAttribDivisor != nullptr);
+        assert(gl::DrawArraysInstanced != nullptr);
+    } else if (extensions.find("GL_ANGLE_instanced_arrays") != std::string::npos) {
+        mbgl::Log::Info(mbgl::Event::OpenGL, "Using GL_ANGLE_instanced_arrays.");
+        gl::VertexAttribDivisor = reinterpret_cast<gl::PFNGLVERTEXATTRIBDIVISORPROC>(
+            eglGetProcAddress("glVertexAttribDivisorANGLE"));
+        gl::DrawArraysInstanced = reinterpret_cast<gl::PFNGLDRAWARRAYSINSTANCEDPROC>(
+            eglGetProcAddress("glDrawArraysInstancedANGLE"));
+        assert(gl::VertexAttribDivisor != nullptr);
+        assert(gl::DrawArraysInstanced != nullptr);
+    }
+
+    if (extensions.find("GL_OES_get_program_binary") != std::string::npos) {
+        mbgl::Log::Info(mbgl::Event::OpenGL, "Using GL_OES_get_program_binary.");
+        gl::GetProgramBinary = reinterpret_cast<gl::PFNGLGETPROGRAMBINARYPROC>(
+            eglGetProcAddress("glGetProgramBinaryOES"));
+        gl::ProgramBinary = reinterpret_cast<gl::PFNGLPROGRAMBINARYPROC>(
+            eglGetProcAddress("glProgramBinaryOES"));
+        assert(gl::GetProgramBinary != nullptr);
+        assert(gl::ProgramBinary != nullptr);
+    }
+
+    if (extensions.find("GL_EXT_disjoint_timer_query") != std::string::npos) {
+        mbgl::Log::Info(mbgl::Event::OpenGL, "Using GL_EXT_disjoint_timer_query.");
+        gl::GenQueries = reinterpret_cast<gl::PFNGLGENQUERIESPROC>(
+            eglGetProcAddress("glGenQueriesEXT"));
+        gl::DeleteQueries = reinterpret_cast<gl::PFNGLDELETEQUERIESPROC>(
+            eglGetProcAddress("glDeleteQueriesEXT"));
+        gl::BeginQuery = reinterpret_cast<gl::PFNGLBEGINQUERYPROC>(
+            eglGetProcAddress("glBeginQueryEXT"));
+        gl::EndQuery = reinterpret_cast<gl::PFNGLENDQUERYPROC>(
+            eglGetProcAddress("glEndQueryEXT"));
+        gl::GetQueryObjectuiv = reinterpret_cast<gl::PFNGLGETQUERYOBJECTUIVPROC>(
+            eglGetProcAddress("glGetQueryObjectuivEXT"));
+        gl::GetQueryObjectui64v = reinterpret_cast<gl::PFNGLGETQUERYOBJECTUI64VPROC>(
+            eglGetProcAddress("glGetQueryObjectui64vEXT"));
+        gl::isTimerQueryDisjointSupported = true;
+        assert(gl::isTimerQuerySupported());
+    }
+
+    if (extensions.find("GL_EXT_texture_filter_anisotropic") != std::string::npos) {
+        mbgl::Log::Info(mbgl::Event::OpenGL, "Using GL_EXT_texture_filter_anisotropic.");
+        MBGL_CHECK_ERROR(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &gl::maxTextureAnisotropy));
+    }
+
+    gl::detectCompressedTextureSupport(extensions);
+
     if (extensions.find("GL_OES_packed_depth_stencil") != std::string::npos) {
         mbgl::Log::Info(mbgl::Event::OpenGL, "Using GL_OES_packed_depth_stencil.");
         gl::isPackedDepthStencilSupported = true;
@@ -627,6 +680,11 @@ void NativeMapView::loadExtensions() {
         }
     }
 
+    if (extensions.find("GL_OES_element_index_uint") != std::string::npos) {
+        mbgl::Log::Info(mbgl::Event::OpenGL, "Using GL_OES_element_index_uint.");
+        gl::isElementIndexUintSupported = true;
+    }
+
     if (extensions.find("GL_KHR_debug") != std::string::npos) {
         mbgl::Log::Info(mbgl::Event::OpenGL, "Using GL_KHR_debug.");
         gl::DebugMessageControl = reinterpret_cast<gl::PFNGLDEBUGMESSAGECONTROLPROC>(
@@ -0,0 +1,431 @@
+#include <mbgl/map/map.hpp>
+#include <mbgl/util/std.hpp>
+#include <mbgl/util/io.hpp>
+#include <mbgl/util/time.hpp>
+#include <mbgl/util/allocation_tracker.hpp>
+
+#include <rapidjson/document.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <mbgl/platform/default/headless_view.hpp>
+#include <mbgl/platform/default/headless_display.hpp>
+#include <mbgl/storage/caching_http_file_source.hpp>
+
+#if __APPLE__
+#include <mbgl/platform/darwin/log_nslog.hpp>
+#else
+#include <mbgl/platform/default/log_stderr.hpp>
+#endif
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace mbgl;
+
+// Every allocation of the process is counted, so that the benchmark can report how many
+// allocations a frame takes once its tiles are loaded. Builds that track allocations by subsystem
+// replace operator new themselves.
+#if !defined(MBGL_TRACK_ALLOCATIONS)
+namespace {
+std::atomic<uint64_t> allocations { 0 };
+}
+
+void *operator new(std::size_t size) {
+    allocations++;
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+#endif
+
+namespace {
+
+typedef rapidjson::PrettyWriter<rapidjson::StringBuffer> Writer;
+
+struct Camera {
+    double lon = 0, lat = 0, zoom = 0, bearing = 0;
+};
+
+struct Scenario {
+    std::string name;
+    std::string style;
+    std::vector<std::string> classes;
+    uint16_t width = 512, height = 512;
+    float pixelRatio = 1;
+    std::vector<Camera> path;
+};
+
+std::string directory(const std::string &path) {
+    const size_t slash = path.rfind('/');
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+double number(const rapidjson::Value &value, const char *name, double fallback) {
+    return value.HasMember(name) && value[name].IsNumber() ? value[name].GetDouble() : fallback;
+}
+
+// Styles are found relative to the scenario file.
+std::vector<Scenario> readScenarios(const std::string &file) {
+    const std::string json = util::read_file(file);
+    rapidjson::Document document;
+    document.Parse<0>(json.c_str());
+    if (document.HasParseError() || !document.IsObject() || !document.HasMember("scenarios") ||
+        !document["scenarios"].IsArray()) {
+        throw std::runtime_error("Scenario file doesn't contain a \"scenarios\" array");
+    }
+
+    std::vector<Scenario> scenarios;
+    const rapidjson::Value &list = document["scenarios"];
+    for (rapidjson::SizeType i = 0; i < list.Size(); i++) {
+        const rapidjson::Value &value = list[i];
+        if (!value.IsObject() || !value.HasMember("name") || !value.HasMember("style") ||
+            !value.HasMember("path") || !value["path"].IsArray()) {
+            throw std::runtime_error("Scenarios need a name, a style and a camera path");
+        }
+
+        Scenario scenario;
+        scenario.name = value["name"].GetString();
+        scenario.style = directory(file) + value["style"].GetString();
+        scenario.width = number(value, "width", scenario.width);
+        scenario.height = number(value, "height", scenario.height);
+        scenario.pixelRatio = number(value, "pixelRatio", scenario.pixelRatio);
+        if (value.HasMember("classes") && value["classes"].IsArray()) {
+            const rapidjson::Value &classes = value["classes"];
+            for (rapidjson::SizeType j = 0; j < classes.Size(); j++) {
+                scenario.classes.push_back(classes[j].GetString());
+            }
+        }
+
+        const rapidjson::Value &path = value["path"];
+        for (rapidjson::SizeType j = 0; j < path.Size(); j++) {
+            Camera camera;
+            camera.lon = number(path[j], "lon", 0);
+            camera.lat = number(path[j], "lat", 0);
+            camera.zoom = number(path[j], "zoom", 0);
+            camera.bearing = number(path[j], "bearing", 0);
+            scenario.path.push_back(camera);
+        }
+        scenarios.push_back(scenario);
+    }
+    return scenarios;
+}
+
+double milliseconds(timestamp duration) {
+    return duration / 1e6;
+}
+
+uint64_t allocationCount() {
+#if defined(MBGL_TRACK_ALLOCATIONS)
+    uint64_t count = 0;
+    for (const AllocationUsage &usage : AllocationTracker::total().subsystems) {
+        count += usage.count;
+    }
+    return count;
+#else
+    return allocations;
+#endif
+}
+
+// The average allocations of each subsystem in a frame.
+void writeSubsystemAllocations(Writer &writer, const AllocationTracker::Counts &counts, double frames) {
+    writer.StartObject();
+    for (const auto &subsystem : counts.toMap()) {
+        writer.String(subsystem.first.c_str());
+        writer.StartObject();
+        writer.String("count");
+        writer.Double(subsystem.second.count / frames);
+        writer.String("bytes");
+        writer.Double(subsystem.second.bytes / frames);
+        writer.EndObject();
+    }
+    writer.EndObject();
+}
+
+uint64_t peakResidentBytes() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if __APPLE__
+    return usage.ru_maxrss;
+#else
+    return uint64_t(usage.ru_maxrss) * 1024;
+#endif
+}
+
+// Writes the median, 90th percentile and maximum of the durations.
+void writeDistribution(Writer &writer, std::vector<timestamp> durations) {
+    std::sort(durations.begin(), durations.end());
+    writer.StartObject();
+    if (!durations.empty()) {
+        writer.String("p50");
+        writer.Double(milliseconds(durations[(durations.size() - 1) / 2]));
+        writer.String("p90");
+        writer.Double(milliseconds(durations[(durations.size() - 1) * 9 / 10]));
+        writer.String("max");
+        writer.Double(milliseconds(durations.back()));
+    }
+    writer.EndObject();
+}
+
+// Returns the largest number of allocations of a frame rendered with all of its tiles in place.
+uint64_t runScenario(Writer &writer, const Scenario &scenario, CachingHTTPFileSource &fileSource,
+                     unsigned int threads, unsigned int frames) {
+    HeadlessView view;
+    Map map(view, fileSource);
+    map.setWorkerCount(threads);
+    map.setGPUTiming(true);
+
+    map.setStyleJSON(util::read_file(scenario.style), directory(scenario.style));
+    map.setClasses(scenario.classes);
+    view.resize(scenario.width, scenario.height, scenario.pixelRatio);
+    map.resize(scenario.width, scenario.height, scenario.pixelRatio);
+
+    writer.StartObject();
+    writer.String("name");
+    writer.String(scenario.name.c_str());
+
+    // Each stop of the path is rendered once the tiles it needs are loaded, then again a number of
+    // times with everything in place to measure the cost of a frame.
+    timestamp loading = 0;
+    std::vector<timestamp> frameTimes;
+    uint64_t maxFrameAllocations = 0;
+    writer.String("path");
+    writer.StartArray();
+    for (const Camera &camera : scenario.path) {
+        map.setLonLatZoom(camera.lon, camera.lat, camera.zoom);
+        map.setBearing(camera.bearing);
+
+        timestamp start = util::now();
+        map.run();
+        const timestamp loaded = util::now() - start;
+        loading += loaded;
+
+        std::vector<timestamp> stopTimes;
+        uint64_t stopAllocations = 0;
+        const AllocationTracker::Counts subsystemsAllocated = AllocationTracker::total();
+        for (unsigned int i = 0; i < frames; i++) {
+            const uint64_t allocated = allocationCount();
+            start = util::now();
+            map.run();
+            stopTimes.push_back(util::now() - start);
+            stopAllocations = std::max<uint64_t>(stopAllocations, allocationCount() - allocated);
+        }
+        const AllocationTracker::Counts stopSubsystemAllocations = AllocationTracker::total() - subsystemsAllocated;
+        maxFrameAllocations = std::max(maxFrameAllocations, stopAllocations);
+        frameTimes.insert(frameTimes.end(), stopTimes.begin(), stopTimes.end());
+
+        writer.StartObject();
+        writer.String("lon");
+        writer.Double(camera.lon);
+        writer.String("lat");
+        writer.Double(camera.lat);
+        writer.String("zoom");
+        writer.Double(camera.zoom);
+        writer.String("bearing");
+        writer.Double(camera.bearing);
+        writer.String("loadedMs");
+        writer.Double(milliseconds(loaded));
+        writer.String("frameMs");
+        writeDistribution(writer, stopTimes);
+        writer.String("frameAllocations");
+        writer.Uint64(stopAllocations);
+        if (AllocationTracker::isEnabled()) {
+            writer.String("frameSubsystemAllocations");
+            writeSubsystemAllocations(writer, stopSubsystemAllocations, std::max(1u, frames));
+        }
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    writer.String("loadedMs");
+    writer.Double(milliseconds(loading));
+    writer.String("frameMs");
+    writeDistribution(writer, frameTimes);
+    writer.String("frameAllocations");
+    writer.Uint64(maxFrameAllocations);
+
+    writer.String("cpuPhasesMs");
+    writer.StartObject();
+    for (const FrameProfiler::Summary &summary : map.getFrameProfiler().summarize()) {
+        writer.String(FrameProfiler::phaseName(summary.phase));
+        writer.StartObject();
+        writer.String("p50");
+        writer.Double(milliseconds(summary.p50));
+        writer.String("p90");
+        writer.Double(milliseconds(summary.p90));
+        writer.String("p99");
+        writer.Double(milliseconds(summary.p99));
+        writer.String("max");
+        writer.Double(milliseconds(summary.max));
+        writer.EndObject();
+    }
+    writer.EndObject();
+
+    // Since the first run of the map. The style is set before that, so it shows up as 0.
+    writer.String("startupMs");
+    writer.StartObject();
+    const StartupProfiler &startup = map.getStartupProfiler();
+    for (size_t i = 0; i < StartupProfiler::stageCount; i++) {
+        const StartupProfiler::Stage stage = StartupProfiler::Stage(i);
+        if (startup.reached(stage)) {
+            writer.String(StartupProfiler::stageName(stage));
+            writer.Double(milliseconds(startup.elapsed(stage)));
+        }
+    }
+    writer.EndObject();
+
+    const std::pair<double, double> overdraw = map.getOverdraw();
+    writer.String("overdraw");
+    writer.StartObject();
+    writer.String("opaque");
+    writer.Double(overdraw.first);
+    writer.String("translucent");
+    writer.Double(overdraw.second);
+    writer.EndObject();
+
+    writer.String("gpuLayersMs");
+    writer.StartObject();
+    for (const auto &layer : map.getGPUTimes()) {
+        writer.String(layer.first.c_str());
+        writer.Double(layer.second);
+    }
+    writer.EndObject();
+
+    // Parsing runs on all worker threads, so this is the throughput of a single worker.
+    LatencyHistogram::Snapshot parse;
+    for (const auto &source : map.getTileLatencies()) {
+        const auto it = source.second.find("parse");
+        if (it != source.second.end()) {
+            parse += it->second;
+        }
+    }
+    writer.String("parse");
+    writer.StartObject();
+    writer.String("tiles");
+    writer.Uint64(parse.count);
+    writer.String("totalMs");
+    writer.Double(milliseconds(parse.total));
+    writer.String("tilesPerSecond");
+    writer.Double(parse.total ? parse.count / (parse.total / 1e9) : 0);
+    writer.EndObject();
+
+    // The memory usage is reported while the next frame is prepared.
+    MapMemoryUsage memory;
+    map.getMemoryUsage([&memory](const MapMemoryUsage &usage) { memory = usage; });
+    map.run();
+    writer.String("memoryBytes");
+    writer.StartObject();
+    writer.String("cpu");
+    writer.Uint64(memory.total.cpu);
+    writer.String("gpu");
+    writer.Uint64(memory.total.gpu);
+    writer.EndObject();
+
+    // The high-water mark of the whole process, including the scenarios that ran before.
+    writer.String("peakResidentBytes");
+    writer.Uint64(peakResidentBytes());
+
+    writer.EndObject();
+    return maxFrameAllocations;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::string scenarios_path;
+    std::string cache = "cache.sqlite";
+    std::string output;
+    std::string token;
+    unsigned int threads = 0;
+    unsigned int frames = 10;
+    int64_t maxAllocations = -1;
+    bool network = false;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("scenarios,s", po::value(&scenarios_path)->required()->value_name("json"), "Scenario file")
+        ("cache,d", po::value(&cache)->value_name("file")->default_value(cache), "Pre-seeded cache database file name")
+        ("output,o", po::value(&output)->value_name("file"), "Results file name (default: stdout)")
+        ("token,t", po::value(&token)->value_name("key")->default_value(token), "Mapbox access token")
+        ("threads,j", po::value(&threads)->value_name("number")->default_value(threads), "Tile worker threads (0 = one per core)")
+        ("frames,f", po::value(&frames)->value_name("number")->default_value(frames), "Frames rendered at every stop of a path")
+        ("network,n", po::bool_switch(&network), "Fetch resources that aren't in the cache")
+        ("max-frame-allocations,a", po::value(&maxAllocations)->value_name("number")->default_value(maxAllocations), "Fail if a frame with loaded tiles allocates more often (-1 = no limit)")
+    ;
+
+    try {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    } catch(std::exception& e) {
+        std::cout << "Error: " << e.what() << std::endl << desc;
+        exit(1);
+    }
+
+#if __APPLE__
+    Log::Set<NSLogBackend>();
+#else
+    Log::Set<StderrLogBackend>();
+#endif
+
+    std::vector<Scenario> scenarios;
+    try {
+        scenarios = readScenarios(scenarios_path);
+    } catch (std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        exit(1);
+    }
+
+    // Results only compare between runs if every run sees the same data.
+    CachingHTTPFileSource fileSource(cache);
+    fileSource.setNetworkEnabled(network);
+
+    if (!token.size()) {
+        const char *token_ptr = getenv("MAPBOX_ACCESS_TOKEN");
+        if (token_ptr) {
+            token = token_ptr;
+        }
+    }
+    if (token.size()) {
+        fileSource.setAccessToken(std::string(token));
+    }
+
+    rapidjson::StringBuffer buffer;
+    Writer writer(buffer);
+    writer.StartObject();
+    writer.String("scenarios");
+    writer.StartArray();
+    uint64_t frameAllocations = 0;
+    for (const Scenario &scenario : scenarios) {
+        frameAllocations = std::max(frameAllocations, runScenario(writer, scenario, fileSource, threads, frames));
+    }
+    writer.EndArray();
+    writer.EndObject();
+
+    if (output.empty()) {
+        std::cout << buffer.GetString() << std::endl;
+    } else {
+        util::write_file(output, buffer.GetString());
+    }
+
+    // The counts include worker threads, but those are idle once the tiles of a stop are loaded.
+    if (maxAllocations >= 0 && frameAllocations > uint64_t(maxAllocations)) {
+        std::cerr << "Error: a frame allocated " << frameAllocations << " times, more than the "
+                  << maxAllocations << " allowed" << std::endl;
+        exit(1);
+    }
+}
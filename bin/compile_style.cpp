@@ -0,0 +1,72 @@
+#include <mbgl/style/style_binary.hpp>
+#include <mbgl/style/style_parser.hpp>
+#include <mbgl/util/io.hpp>
+
+#if __APPLE__
+#include <mbgl/platform/darwin/log_nslog.hpp>
+#else
+#include <mbgl/platform/default/log_stderr.hpp>
+#endif
+
+#include <rapidjson/document.h>
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace mbgl;
+
+int main(int argc, char *argv[]) {
+    std::string style_path;
+    std::string output;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("style,s", po::value(&style_path)->required()->value_name("json"), "Map stylesheet")
+        ("output,o", po::value(&output)->required()->value_name("file"), "Compiled style file name")
+    ;
+
+    try {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    } catch(std::exception& e) {
+        std::cout << "Error: " << e.what() << std::endl << desc;
+        exit(1);
+    }
+
+#if __APPLE__
+    Log::Set<NSLogBackend>();
+#else
+    Log::Set<StderrLogBackend>();
+#endif
+
+    try {
+        const std::string json = util::read_file(style_path);
+        rapidjson::Document doc;
+        doc.Parse<0>(json.c_str());
+        if (doc.HasParseError()) {
+            std::cerr << "Error parsing style JSON at " << doc.GetErrorOffset() << ": " << doc.GetParseError() << std::endl;
+            exit(1);
+        }
+
+        const std::string binary = StyleBinary::compile(doc);
+
+        // Parsing the compiled style reports the same warnings as the app would get at runtime.
+        rapidjson::Document compiled;
+        if (!StyleBinary::decode(binary.data(), binary.size(), compiled)) {
+            std::cerr << "Error: the compiled style doesn't decode" << std::endl;
+            exit(1);
+        }
+        StyleParser parser;
+        parser.parse(compiled);
+
+        util::write_file(output, binary);
+        std::cout << style_path << ": " << json.size() << " bytes of JSON, " << binary.size() << " bytes compiled" << std::endl;
+    } catch (std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        exit(1);
+    }
+}
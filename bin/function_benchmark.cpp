@@ -0,0 +1,93 @@
+#include <mbgl/style/function_properties.hpp>
+#include <mbgl/style/types.hpp>
+#include <mbgl/util/io.hpp>
+#include <mbgl/util/time.hpp>
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace mbgl;
+
+namespace {
+
+typedef rapidjson::PrettyWriter<rapidjson::StringBuffer> Writer;
+
+// Keeps the compiler from dropping evaluations whose results aren't used otherwise.
+volatile float sink = 0;
+
+inline float use(float value) { return value; }
+inline float use(const Color &value) { return value[0]; }
+inline float use(const std::vector<float> &value) { return value.empty() ? 0 : value[0]; }
+
+// Evaluates the function at zoom levels 0 to 22 in steps of 1/256, like a zoom animation would.
+template <typename T>
+void run(Writer &writer, const char *name, const StopsFunction<T> &function, unsigned int iterations) {
+    const unsigned int steps = 22 * 256;
+    float total = 0;
+    const timestamp start = util::now();
+    for (unsigned int i = 0; i < iterations; i++) {
+        for (unsigned int step = 0; step <= steps; step++) {
+            total += use(function.evaluate(step / 256.0f));
+        }
+    }
+    const timestamp duration = util::now() - start;
+    sink = total;
+
+    writer.String(name);
+    writer.StartObject();
+    writer.String("evaluations");
+    writer.Uint64(uint64_t(iterations) * (steps + 1));
+    writer.String("nsPerEvaluation");
+    writer.Double(double(duration) / (uint64_t(iterations) * (steps + 1)));
+    writer.EndObject();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::string output;
+    unsigned int iterations = 1000;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("output,o", po::value(&output)->value_name("file"), "Results file name (default: stdout)")
+        ("iterations,i", po::value(&iterations)->value_name("number")->default_value(iterations), "Sweeps over all zoom levels per function")
+    ;
+
+    try {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    } catch(std::exception& e) {
+        std::cout << "Error: " << e.what() << std::endl << desc;
+        exit(1);
+    }
+
+    // Functions shaped like the ones in the default styles: road widths grow exponentially over a
+    // handful of stops, colors fade linearly, and dash arrays switch at a single zoom level.
+    const StopsFunction<float> width({ { 5, 0.5 }, { 10, 1 }, { 13, 2 }, { 15, 6 }, { 17, 12 }, { 20, 40 } }, 1.5);
+    const StopsFunction<float> linear({ { 0, 0 }, { 22, 1 } }, 1);
+    const StopsFunction<Color> color({ { 8, {{ 0.9, 0.9, 0.9, 1 }} }, { 12, {{ 1, 1, 1, 1 }} }, { 16, {{ 1, 0.8, 0.6, 1 }} } }, 1);
+    const StopsFunction<std::vector<float>> dashes({ { 0, { 2, 1 } }, { 14, { 2, 1 } }, { 15, { 1, 1 } } }, 1);
+
+    rapidjson::StringBuffer buffer;
+    Writer writer(buffer);
+    writer.StartObject();
+    run(writer, "width", width, iterations);
+    run(writer, "linear", linear, iterations);
+    run(writer, "color", color, iterations);
+    run(writer, "dashes", dashes, iterations);
+    writer.EndObject();
+
+    if (output.empty()) {
+        std::cout << buffer.GetString() << std::endl;
+    } else {
+        util::write_file(output, buffer.GetString());
+    }
+}
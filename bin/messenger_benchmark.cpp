@@ -0,0 +1,110 @@
+#include <mbgl/util/uv-messenger.h>
+#include <mbgl/util/uv_detail.hpp>
+#include <mbgl/util/io.hpp>
+#include <mbgl/util/time.hpp>
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+typedef rapidjson::PrettyWriter<rapidjson::StringBuffer> Writer;
+
+struct Counter {
+    uint64_t received = 0;
+    uint64_t expected = 0;
+    uv_messenger_t messenger;
+};
+
+// Sends /messages/ messages from each of /threads/ threads at once and measures how long it takes
+// until the loop thread received all of them.
+void run(Writer &writer, unsigned int threads, unsigned int messages) {
+    uv::loop loop;
+
+    Counter counter;
+    counter.expected = uint64_t(threads) * messages;
+    counter.messenger.data = &counter;
+
+    uv_messenger_init(*loop, &counter.messenger, [](void *ptr) {
+        Counter *c = reinterpret_cast<Counter *>(ptr);
+        if (++c->received == c->expected) {
+            uv_messenger_stop(&c->messenger, [](uv_messenger_t *) {});
+        }
+    });
+
+    const timestamp start = util::now();
+
+    std::vector<std::thread> producers;
+    for (unsigned int i = 0; i < threads; i++) {
+        producers.emplace_back([&counter, messages] {
+            for (unsigned int j = 0; j < messages; j++) {
+                uv_messenger_send(&counter.messenger, &counter);
+            }
+        });
+    }
+
+    uv_run(*loop, UV_RUN_DEFAULT);
+    const timestamp duration = util::now() - start;
+
+    for (std::thread &producer : producers) {
+        producer.join();
+    }
+
+    writer.StartObject();
+    writer.String("threads");
+    writer.Uint(threads);
+    writer.String("messages");
+    writer.Uint64(counter.received);
+    writer.String("nsPerMessage");
+    writer.Double(double(duration) / counter.received);
+    writer.EndObject();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::string output;
+    unsigned int messages = 100000;
+    unsigned int maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("output,o", po::value(&output)->value_name("file"), "Results file name (default: stdout)")
+        ("messages,m", po::value(&messages)->value_name("number")->default_value(messages), "Messages sent per thread")
+        ("threads,t", po::value(&maxThreads)->value_name("number")->default_value(maxThreads), "Largest number of sending threads")
+    ;
+
+    try {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    } catch(std::exception& e) {
+        std::cout << "Error: " << e.what() << std::endl << desc;
+        exit(1);
+    }
+
+    rapidjson::StringBuffer buffer;
+    Writer writer(buffer);
+    writer.StartArray();
+    for (unsigned int threads = 1; threads <= maxThreads; threads *= 2) {
+        run(writer, threads, messages);
+    }
+    writer.EndArray();
+
+    if (output.empty()) {
+        std::cout << buffer.GetString() << std::endl;
+    } else {
+        util::write_file(output, buffer.GetString());
+    }
+}
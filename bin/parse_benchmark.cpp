@@ -0,0 +1,415 @@
+#include <mbgl/map/vector_tile_data.hpp>
+#include <mbgl/map/sprite.hpp>
+#include <mbgl/style/style.hpp>
+#include <mbgl/style/style_layer.hpp>
+#include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/style/style_bucket.hpp>
+#include <mbgl/style/style_source.hpp>
+#include <mbgl/geometry/glyph_atlas.hpp>
+#include <mbgl/geometry/sprite_atlas.hpp>
+#include <mbgl/text/glyph_store.hpp>
+#include <mbgl/util/texture_pool.hpp>
+#include <mbgl/util/uv_detail.hpp>
+#include <mbgl/util/std.hpp>
+#include <mbgl/util/io.hpp>
+#include <mbgl/util/time.hpp>
+#include <mbgl/util/allocation_tracker.hpp>
+
+#include <rapidjson/document.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <mbgl/storage/caching_http_file_source.hpp>
+
+#if __APPLE__
+#include <mbgl/platform/darwin/log_nslog.hpp>
+#else
+#include <mbgl/platform/default/log_stderr.hpp>
+#endif
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <thread>
+
+using namespace mbgl;
+
+// Every allocation of the process is counted, so that the benchmark can report how many
+// allocations parsing a tile takes. Builds that track allocations by subsystem replace operator
+// new themselves.
+#if !defined(MBGL_TRACK_ALLOCATIONS)
+namespace {
+std::atomic<uint64_t> allocations { 0 };
+}
+
+void *operator new(std::size_t size) {
+    allocations++;
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+#endif
+
+namespace {
+
+typedef rapidjson::PrettyWriter<rapidjson::StringBuffer> Writer;
+
+// The maximum zoom level of a map that wasn't configured otherwise.
+const float mapMaxZoom = 18;
+
+// A tile whose data was read from a file instead of requested from its source.
+class FixtureTileData : public VectorTileData {
+public:
+    FixtureTileData(const Tile::ID &id_, const std::shared_ptr<const std::string> &data_,
+                    util::ptr<Style> style_, GlyphAtlas &glyphAtlas_, GlyphStore &glyphStore_,
+                    SpriteAtlas &spriteAtlas_, util::ptr<Sprite> sprite_, TexturePool &texturePool_,
+                    const SourceInfo &source_)
+        : VectorTileData(id_, mapMaxZoom, style_, glyphAtlas_, glyphStore_, spriteAtlas_, sprite_,
+                         texturePool_, source_, nullptr) {
+        data = data_;
+        state = State::loaded;
+    }
+
+    // Whether the last parse left out the symbol buckets because glyphs weren't loaded yet.
+    inline bool missingGlyphs() const {
+        return glyphGeneration != 0;
+    }
+};
+
+struct Fixture {
+    std::string path;
+    Tile::ID id;
+    std::shared_ptr<const std::string> data;
+};
+
+struct Result {
+    std::vector<timestamp> parseTimes;
+    BucketParseTimes bucketTimes;
+    uint64_t allocations = 0;
+    AllocationTracker::Counts subsystemAllocations;
+};
+
+// Tiles are named after their ID, either as z/x/y.pbf or as z-x-y.pbf.
+Tile::ID parseTileID(const std::string &path) {
+    const size_t dot = path.rfind('.');
+    const std::string stem = path.substr(0, dot == std::string::npos ? path.size() : dot);
+
+    std::vector<int32_t> numbers;
+    size_t end = stem.size();
+    while (numbers.size() < 3 && end > 0) {
+        size_t start = stem.find_last_of("/-", end - 1);
+        start = start == std::string::npos ? 0 : start + 1;
+        const std::string part = stem.substr(start, end - start);
+        if (part.empty() || part.find_first_not_of("0123456789") != std::string::npos) {
+            break;
+        }
+        numbers.push_back(std::atoi(part.c_str()));
+        end = start ? start - 1 : 0;
+    }
+
+    if (numbers.size() < 3) {
+        throw std::runtime_error("Tile file names need to end in z/x/y.pbf or z-x-y.pbf: " + path);
+    }
+    return Tile::ID(numbers[2], numbers[1], numbers[0]);
+}
+
+std::string directory(const std::string &path) {
+    const size_t slash = path.rfind('/');
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+// Tiles are parsed for the first vector source of the style.
+const SourceInfo *findVectorSource(const util::ptr<StyleLayerGroup> &group) {
+    if (!group) {
+        return nullptr;
+    }
+    for (const util::ptr<StyleLayer> &layer : group->layers) {
+        if (layer->bucket && layer->bucket->style_source &&
+            layer->bucket->style_source->info.type == SourceType::Vector) {
+            return &layer->bucket->style_source->info;
+        }
+    }
+    return nullptr;
+}
+
+// Runs the loop until /done/ returns true or a few seconds passed. Returns whether it is done.
+bool runUntil(uv_loop_t *loop, std::function<bool()> done) {
+    const timestamp deadline = util::now() + 30_seconds;
+    while (!done()) {
+        if (util::now() > deadline) {
+            return false;
+        }
+        uv_run(loop, UV_RUN_NOWAIT);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+double milliseconds(timestamp duration) {
+    return duration / 1e6;
+}
+
+void writeBucketTimes(Writer &writer, const BucketParseTimes &times, double tiles) {
+    writer.StartObject();
+    writer.String("fill");
+    writer.Double(milliseconds(times.fill) / tiles);
+    writer.String("line");
+    writer.Double(milliseconds(times.line) / tiles);
+    writer.String("circle");
+    writer.Double(milliseconds(times.circle) / tiles);
+    writer.String("symbol");
+    writer.Double(milliseconds(times.symbol) / tiles);
+    writer.EndObject();
+}
+
+uint64_t allocationCount() {
+#if defined(MBGL_TRACK_ALLOCATIONS)
+    uint64_t count = 0;
+    for (const AllocationUsage &usage : AllocationTracker::total().subsystems) {
+        count += usage.count;
+    }
+    return count;
+#else
+    return allocations;
+#endif
+}
+
+void writeSubsystemAllocations(Writer &writer, const AllocationTracker::Counts &counts, double tiles) {
+    writer.StartObject();
+    for (const auto &subsystem : counts.toMap()) {
+        writer.String(subsystem.first.c_str());
+        writer.StartObject();
+        writer.String("count");
+        writer.Double(subsystem.second.count / tiles);
+        writer.String("bytes");
+        writer.Double(subsystem.second.bytes / tiles);
+        writer.EndObject();
+    }
+    writer.EndObject();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::string style_path;
+    std::vector<std::string> tile_paths;
+    std::string cache = "cache.sqlite";
+    std::string output;
+    std::string token;
+    unsigned int iterations = 20;
+    float pixelRatio = 1;
+    bool network = false;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("style,s", po::value(&style_path)->required()->value_name("json"), "Map stylesheet")
+        ("tiles", po::value(&tile_paths)->required()->value_name("pbf"), "Vector tiles, named z/x/y.pbf or z-x-y.pbf")
+        ("cache,d", po::value(&cache)->value_name("file")->default_value(cache), "Cache database file name for glyphs and sprites")
+        ("output,o", po::value(&output)->value_name("file"), "Results file name (default: stdout)")
+        ("token,t", po::value(&token)->value_name("key")->default_value(token), "Mapbox access token")
+        ("iterations,i", po::value(&iterations)->value_name("number")->default_value(iterations), "Parses of every tile")
+        ("ratio,r", po::value(&pixelRatio)->value_name("number")->default_value(pixelRatio), "Image scale factor of the sprite")
+        ("network,n", po::bool_switch(&network), "Fetch glyphs and sprites that aren't in the cache")
+    ;
+
+    po::positional_options_description positional;
+    positional.add("tiles", -1);
+
+    try {
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
+        po::notify(vm);
+    } catch(std::exception& e) {
+        std::cout << "Error: " << e.what() << std::endl << desc;
+        exit(1);
+    }
+
+#if __APPLE__
+    Log::Set<NSLogBackend>();
+#else
+    Log::Set<StderrLogBackend>();
+#endif
+
+    std::vector<Fixture> fixtures;
+    try {
+        for (const std::string &path : tile_paths) {
+            fixtures.push_back({ path, parseTileID(path), std::make_shared<const std::string>(util::read_file(path)) });
+        }
+    } catch (std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        exit(1);
+    }
+
+    // Glyphs and sprites are loaded through the file source, just like the map does.
+    uv::loop loop;
+    CachingHTTPFileSource fileSource(cache);
+    fileSource.setLoop(*loop);
+    fileSource.setNetworkEnabled(network);
+    fileSource.setBase(directory(style_path));
+
+    if (!token.size()) {
+        const char *token_ptr = getenv("MAPBOX_ACCESS_TOKEN");
+        if (token_ptr) {
+            token = token_ptr;
+        }
+    }
+    if (token.size()) {
+        fileSource.setAccessToken(std::string(token));
+    }
+
+    const std::string styleJSON = util::read_file(style_path);
+    util::ptr<Style> style = std::make_shared<Style>();
+    style->loadJSON((const uint8_t *)styleJSON.c_str());
+    style->cascadeClasses({});
+
+    const SourceInfo *source = findVectorSource(style->layers);
+    if (!source) {
+        std::cerr << "Error: The style doesn't use a vector source" << std::endl;
+        exit(1);
+    }
+
+    GlyphAtlas glyphAtlas(1024, 1024);
+    GlyphStore glyphStore(fileSource);
+    glyphStore.setURL(style->glyph_url);
+    SpriteAtlas spriteAtlas(512, 512);
+    TexturePool texturePool;
+
+    uv::worker worker(*loop, 1);
+    util::ptr<Sprite> sprite = Sprite::Create(style->getSpriteURL(), pixelRatio, fileSource, worker);
+    if (!runUntil(*loop, [&] { return sprite->isLoaded(); })) {
+        std::cerr << "Error: Failed to load the sprite" << std::endl;
+        exit(1);
+    }
+    spriteAtlas.setSprite(sprite);
+
+    const auto createTile = [&](const Fixture &fixture) {
+        return util::make_unique<FixtureTileData>(fixture.id, fixture.data, style, glyphAtlas,
+                                                  glyphStore, spriteAtlas, sprite, texturePool,
+                                                  *source);
+    };
+
+    // The first parse of every tile requests the glyphs it needs, and isn't measured. Tiles are
+    // parsed again until all of their labels could be placed.
+    for (const Fixture &fixture : fixtures) {
+        auto tile = createTile(fixture);
+        tile->parse();
+        while (tile->missingGlyphs()) {
+            const uint64_t generation = glyphStore.getGeneration();
+            if (!runUntil(*loop, [&] { return glyphStore.getGeneration() != generation; })) {
+                std::cerr << "Warning: Glyphs for " << fixture.path << " didn't load; its labels are left out" << std::endl;
+                break;
+            }
+            tile = createTile(fixture);
+            tile->parse();
+        }
+    }
+
+    // Every iteration parses all tiles from scratch, so that kept buckets of an earlier parse
+    // don't shortcut the work. Buckets are built, but never uploaded.
+    std::vector<Result> results(fixtures.size());
+    for (unsigned int i = 0; i < iterations; i++) {
+        for (size_t j = 0; j < fixtures.size(); j++) {
+            auto tile = createTile(fixtures[j]);
+
+            const uint64_t allocated = allocationCount();
+            const AllocationTracker::Counts subsystemsAllocated = AllocationTracker::thread();
+            const timestamp start = util::now();
+            tile->parse();
+            results[j].parseTimes.push_back(util::now() - start);
+            results[j].allocations += allocationCount() - allocated;
+            results[j].subsystemAllocations += AllocationTracker::thread() - subsystemsAllocated;
+
+            results[j].bucketTimes.fill += tile->parseTimes.fill;
+            results[j].bucketTimes.line += tile->parseTimes.line;
+            results[j].bucketTimes.circle += tile->parseTimes.circle;
+            results[j].bucketTimes.symbol += tile->parseTimes.symbol;
+        }
+    }
+
+    rapidjson::StringBuffer buffer;
+    Writer writer(buffer);
+    writer.StartObject();
+
+    timestamp total = 0;
+    uint64_t totalAllocations = 0;
+    AllocationTracker::Counts totalSubsystemAllocations;
+    BucketParseTimes totalBucketTimes;
+    const double runs = std::max(1u, iterations);
+
+    writer.String("tiles");
+    writer.StartArray();
+    for (size_t j = 0; j < fixtures.size(); j++) {
+        Result &result = results[j];
+        std::sort(result.parseTimes.begin(), result.parseTimes.end());
+        for (timestamp time : result.parseTimes) {
+            total += time;
+        }
+        totalAllocations += result.allocations;
+        totalSubsystemAllocations += result.subsystemAllocations;
+        totalBucketTimes.fill += result.bucketTimes.fill;
+        totalBucketTimes.line += result.bucketTimes.line;
+        totalBucketTimes.circle += result.bucketTimes.circle;
+        totalBucketTimes.symbol += result.bucketTimes.symbol;
+
+        writer.StartObject();
+        writer.String("path");
+        writer.String(fixtures[j].path.c_str());
+        writer.String("bytes");
+        writer.Uint64(fixtures[j].data->size());
+        writer.String("parseMs");
+        writer.StartObject();
+        if (!result.parseTimes.empty()) {
+            writer.String("p50");
+            writer.Double(milliseconds(result.parseTimes[(result.parseTimes.size() - 1) / 2]));
+            writer.String("min");
+            writer.Double(milliseconds(result.parseTimes.front()));
+        }
+        writer.EndObject();
+        writer.String("bucketMs");
+        writeBucketTimes(writer, result.bucketTimes, runs);
+        writer.String("allocations");
+        writer.Double(result.allocations / runs);
+        if (AllocationTracker::isEnabled()) {
+            writer.String("subsystemAllocations");
+            writeSubsystemAllocations(writer, result.subsystemAllocations, runs);
+        }
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    // Averages over all parses of all tiles.
+    const double parses = std::max<double>(1, runs * fixtures.size());
+    writer.String("tilesPerSecond");
+    writer.Double(total ? parses / (total / 1e9) : 0);
+    writer.String("parseMsPerTile");
+    writer.Double(milliseconds(total) / parses);
+    writer.String("bucketMsPerTile");
+    writeBucketTimes(writer, totalBucketTimes, parses);
+    writer.String("allocationsPerTile");
+    writer.Double(totalAllocations / parses);
+    if (AllocationTracker::isEnabled()) {
+        writer.String("subsystemAllocationsPerTile");
+        writeSubsystemAllocations(writer, totalSubsystemAllocations, parses);
+    }
+
+    writer.EndObject();
+
+    if (output.empty()) {
+        std::cout << buffer.GetString() << std::endl;
+    } else {
+        util::write_file(output, buffer.GetString());
+    }
+}
@@ -1,7 +1,10 @@
 #include <mbgl/map/map.hpp>
 #include <mbgl/util/image.hpp>
+#include <mbgl/util/constants.hpp>
+#include <mbgl/util/math.hpp>
 #include <mbgl/util/std.hpp>
 #include <mbgl/util/io.hpp>
+#include <mbgl/util/sqlite3.hpp>
 
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
@@ -20,9 +23,568 @@
 #include <boost/program_options.hpp>
 namespace po = boost::program_options;
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace mbgl;
+
+namespace {
+
+struct Job {
+    std::string style;
+    std::vector<std::string> classes;
+    double lon = 0, lat = 0, zoom = 0, bearing = 0;
+    uint16_t width = 256, height = 256;
+    float pixelRatio = 1;
+    std::string output;
+};
+
+// How rendered images are stored.
+struct Encoding {
+    enum class Format { PNG, JPEG };
+    Format format = Format::PNG;
+    util::PNGOptions png;
+    int jpegQuality = 90;
+};
+
+// The rows of /pixels/ are bottom-up, as HeadlessView reads them.
+std::string encode(const Encoding &encoding, unsigned int width, unsigned int height, uint32_t *pixels) {
+    if (encoding.format == Encoding::Format::JPEG) {
+        return util::compress_jpeg(width, height, pixels, encoding.jpegQuality, true);
+    }
+    util::PNGOptions options = encoding.png;
+    options.flipY = true;
+    return util::compress_png(width, height, pixels, options);
+}
+
+// Compresses and writes the rendered images on a pool of threads, so that the next jobs can be
+// rendered in the meantime. Reports every finished job on stdout; with more than one thread,
+// jobs may finish out of order. May be used from several threads.
+class ImageWriter {
+public:
+    // Stores an encoded image under its path. Called on the encoding threads.
+    typedef std::function<void (const std::string &path, const std::string &data)> Store;
+
+    ImageWriter(const Encoding &encoding_, unsigned int threads, Store store_ = util::write_file)
+        : encoding(encoding_),
+          store(store_),
+          maxQueued(std::max(8u, threads * 2)) {
+        for (unsigned int i = 0; i < threads; i++) {
+            encoders.emplace_back([this] { run(); });
+        }
+    }
+
+    ~ImageWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            done = true;
+        }
+        changed.notify_all();
+        for (std::thread &encoder : encoders) {
+            encoder.join();
+        }
+    }
+
+    // Returns a buffer for an image of this many pixels, reusing one that was written before.
+    // Blocks while too many images wait to be written, so that a fast renderer doesn't pile
+    // them up in memory.
+    std::unique_ptr<uint32_t[]> buffer(size_t pixels) {
+        std::unique_lock<std::mutex> lock(mtx);
+        changed.wait(lock, [this] { return queue.size() < maxQueued; });
+        for (auto it = spare.begin(); it != spare.end(); ++it) {
+            if (it->first == pixels) {
+                std::unique_ptr<uint32_t[]> result = std::move(it->second);
+                spare.erase(it);
+                return result;
+            }
+        }
+        return util::make_unique<uint32_t[]>(pixels);
+    }
+
+    // The rows of /pixels/ are bottom-up, as HeadlessView reads them.
+    void write(const std::string &path, unsigned int width, unsigned int height,
+               std::unique_ptr<uint32_t[]> pixels) {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push_back({ path, width, height, std::move(pixels), "" });
+        changed.notify_all();
+    }
+
+    void fail(const std::string &path, const std::string &error) {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push_back({ path, 0, 0, nullptr, error });
+        changed.notify_all();
+    }
+
+private:
+    struct Image {
+        std::string path;
+        unsigned int width, height;
+        std::unique_ptr<uint32_t[]> pixels;
+        std::string error;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            changed.wait(lock, [this] { return done || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+
+            Image image = std::move(queue.front());
+            queue.pop_front();
+            changed.notify_all();
+            lock.unlock();
+
+            if (image.pixels) {
+                try {
+                    const std::string data = encode(encoding, image.width, image.height, image.pixels.get());
+                    if (data.empty()) {
+                        throw std::runtime_error("Couldn't encode the image");
+                    }
+                    store(image.path, data);
+                } catch (const std::exception &e) {
+                    image.error = e.what();
+                }
+            }
+
+            lock.lock();
+            report(image);
+            if (image.pixels) {
+                if (spare.size() == maxQueued) {
+                    spare.pop_front();
+                }
+                spare.emplace_back(size_t(image.width) * image.height, std::move(image.pixels));
+            }
+        }
+    }
+
+    static void report(const Image &image) {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        writer.StartObject();
+        writer.String("output");
+        writer.String(image.path.c_str());
+        if (!image.error.empty()) {
+            writer.String("error");
+            writer.String(image.error.c_str());
+        }
+        writer.EndObject();
+        std::cout << buffer.GetString() << std::endl;
+    }
+
+    const Encoding encoding;
+    const Store store;
+    const size_t maxQueued;
+
+    std::deque<Image> queue;
+    std::deque<std::pair<size_t, std::unique_ptr<uint32_t[]>>> spare;
+    bool done = false;
+    std::mutex mtx;
+    std::condition_variable changed;
+    std::vector<std::thread> encoders;
+};
+
+Encoding parseEncoding(const std::string &format, int compression, const std::string &filter,
+                       int quality) {
+    Encoding encoding;
+    if (format == "jpeg" || format == "jpg") {
+        encoding.format = Encoding::Format::JPEG;
+    } else if (format == "png8") {
+        encoding.png.quantize = true;
+    } else if (format != "png") {
+        throw std::runtime_error("unknown format '" + format + "'");
+    }
+
+    encoding.png.compressionLevel = compression;
+    if (filter == "none") {
+        encoding.png.filter = util::PNGOptions::Filter::None;
+    } else if (filter == "sub") {
+        encoding.png.filter = util::PNGOptions::Filter::Sub;
+    } else if (filter == "up") {
+        encoding.png.filter = util::PNGOptions::Filter::Up;
+    } else if (filter == "average") {
+        encoding.png.filter = util::PNGOptions::Filter::Average;
+    } else if (filter == "paeth") {
+        encoding.png.filter = util::PNGOptions::Filter::Paeth;
+    } else if (filter != "adaptive") {
+        throw std::runtime_error("unknown filter '" + filter + "'");
+    }
+
+    encoding.jpegQuality = quality;
+    return encoding;
+}
+
+// Stores tiles in an MBTiles file, keyed by their "z/x/y" path. All tiles go into one transaction
+// that is committed when the writer goes away, since committing every tile would take longer than
+// rendering it. May be used from several threads.
+class MBTilesWriter {
+public:
+    MBTilesWriter(const std::string &path, const std::string &format,
+                  const std::array<double, 4> &bounds, int minZoom, int maxZoom)
+        : db(path, mapbox::sqlite::ReadWrite | mapbox::sqlite::Create) {
+        db.exec("PRAGMA synchronous = OFF");
+        db.exec("CREATE TABLE IF NOT EXISTS metadata (name TEXT, value TEXT)");
+        db.exec("CREATE TABLE IF NOT EXISTS tiles (zoom_level INTEGER, tile_column INTEGER, tile_row INTEGER, tile_data BLOB)");
+        db.exec("CREATE UNIQUE INDEX IF NOT EXISTS name ON metadata (name)");
+        db.exec("CREATE UNIQUE INDEX IF NOT EXISTS tile_index ON tiles (zoom_level, tile_column, tile_row)");
+        db.exec("BEGIN");
+
+        std::ostringstream bbox;
+        bbox << bounds[0] << "," << bounds[1] << "," << bounds[2] << "," << bounds[3];
+        const std::vector<std::pair<std::string, std::string>> metadata = {
+            { "name", path },
+            { "type", "baselayer" },
+            { "version", "1.0.0" },
+            { "format", format },
+            { "bounds", bbox.str() },
+            { "minzoom", std::to_string(minZoom) },
+            { "maxzoom", std::to_string(maxZoom) },
+        };
+        mapbox::sqlite::Statement stmt = db.prepare("INSERT OR REPLACE INTO metadata (name, value) VALUES (?1, ?2)");
+        for (const auto &entry : metadata) {
+            stmt.bind(1, entry.first.c_str());
+            stmt.bind(2, entry.second.c_str());
+            stmt.run();
+            stmt.reset();
+        }
+    }
+
+    ~MBTilesWriter() {
+        try {
+            db.exec("COMMIT");
+        } catch (const std::exception &e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    void put(const std::string &path, const std::string &data) {
+        int z = 0, x = 0, y = 0;
+        if (std::sscanf(path.c_str(), "%d/%d/%d", &z, &x, &y) != 3) {
+            throw std::runtime_error("Not a tile path: " + path);
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        mapbox::sqlite::Statement &stmt = db.prepareCached("INSERT OR REPLACE INTO tiles (zoom_level, tile_column, tile_row, tile_data) VALUES (?1, ?2, ?3, ?4)");
+        stmt.bind(1, z);
+        stmt.bind(2, x);
+        // Rows count from the south in MBTiles.
+        stmt.bind(3, (1 << z) - 1 - y);
+        stmt.bind(4, data, false);
+        stmt.run();
+        stmt.reset();
+    }
+
+private:
+    std::mutex mtx;
+    mapbox::sqlite::Database db;
+};
+
+// A block of tiles at one zoom level that is rendered in a single frame, so that style setup,
+// clipping and label placement happen once for all of them, and labels don't conflict at the
+// seams between them.
+struct Metatile {
+    int32_t z = 0;
+    // The top left tile.
+    int32_t x = 0, y = 0;
+    int32_t cols = 0, rows = 0;
+};
+
+// Splits the tiles that cover the bounds at each zoom level into metatiles of at most
+// size x size tiles, aligned to multiples of size. May be used from several threads.
+class Pyramid {
+public:
+    Pyramid(const std::array<double, 4> &bounds_, int minZoom, int maxZoom_, int size_)
+        : bounds(bounds_), maxZoom(maxZoom_), size(size_) {
+        setZoom(minZoom);
+    }
+
+    bool next(Metatile &metatile) {
+        std::lock_guard<std::mutex> lock(mtx);
+        while (z <= maxZoom) {
+            if (my > ymax / size) {
+                setZoom(z + 1);
+                continue;
+            }
+
+            metatile.z = z;
+            metatile.x = std::max(mx * size, xmin);
+            metatile.y = std::max(my * size, ymin);
+            metatile.cols = std::min(mx * size + size - 1, xmax) - metatile.x + 1;
+            metatile.rows = std::min(my * size + size - 1, ymax) - metatile.y + 1;
+
+            if (++mx > xmax / size) {
+                mx = xmin / size;
+                my++;
+            }
+            return true;
+        }
+        return false;
+    }
+
+private:
+    void setZoom(int zoom) {
+        z = zoom;
+        const double n = std::pow(2, z);
+        const auto column = [n](double lon) {
+            return int32_t(util::clamp(std::floor((lon + 180) / 360 * n), 0.0, n - 1));
+        };
+        const auto row = [n](double lat) {
+            const double sin = std::sin(lat * M_PI / 180);
+            const double y = 0.5 - 0.25 * std::log((1 + sin) / (1 - sin)) / M_PI;
+            return int32_t(util::clamp(std::floor(y * n), 0.0, n - 1));
+        };
+        xmin = column(bounds[0]);
+        xmax = column(bounds[2]);
+        ymin = row(bounds[3]);
+        ymax = row(bounds[1]);
+        mx = xmin / size;
+        my = ymin / size;
+    }
+
+    const std::array<double, 4> bounds;
+    const int maxZoom;
+    const int32_t size;
+
+    int32_t z = 0;
+    int32_t xmin = 0, xmax = 0, ymin = 0, ymax = 0;
+    int32_t mx = 0, my = 0;
+    std::mutex mtx;
+};
+
+// How the tiles of a pyramid are rendered.
+struct PyramidOptions {
+    uint16_t tileSize = 256;
+    float pixelRatio = 1;
+    // Pixels that are rendered around each metatile, so that labels close to its edges are
+    // placed like labels inside it would be.
+    uint16_t buffer = 128;
+};
+
+// Renders the metatiles of the pyramid with one map and slices them into tiles named "z/x/y".
+// The pixels of a metatile are read back while the next one renders. Several maps can share
+// the pyramid and the writer.
+void runPyramid(Map &map, HeadlessView &view, ImageWriter &writer, Pyramid &pyramid,
+                const PyramidOptions &options) {
+    const double tileSize = options.tileSize;
+    const double ratio = options.pixelRatio;
+    const unsigned int tilePixels = std::round(tileSize * ratio);
+
+    struct Frame {
+        Metatile metatile;
+        unsigned int width, height;
+        // The top of the first row of tiles, in logical pixels from the top of the view.
+        double top;
+    };
+    std::deque<Frame> reading;
+    std::vector<uint32_t> frame;
+
+    const auto finishRead = [&] {
+        const Frame &read = reading.front();
+        const unsigned int width = std::round(read.width * ratio);
+        const unsigned int height = std::round(read.height * ratio);
+        frame.resize(size_t(width) * height);
+        view.finishReadPixels(frame.data());
+
+        for (int32_t row = 0; row < read.metatile.rows; row++) {
+            for (int32_t col = 0; col < read.metatile.cols; col++) {
+                const unsigned int left = std::round((options.buffer + col * tileSize) * ratio);
+                const unsigned int top = std::round((read.top + row * tileSize) * ratio);
+
+                // Both images are bottom-up.
+                std::unique_ptr<uint32_t[]> pixels = writer.buffer(size_t(tilePixels) * tilePixels);
+                for (unsigned int y = 0; y < tilePixels; y++) {
+                    const size_t source = size_t(height - top - tilePixels + y) * width + left;
+                    std::memcpy(&pixels[size_t(y) * tilePixels], &frame[source], tilePixels * sizeof(uint32_t));
+                }
+
+                const std::string path = std::to_string(read.metatile.z) + "/" +
+                                         std::to_string(read.metatile.x + col) + "/" +
+                                         std::to_string(read.metatile.y + row);
+                writer.write(path, tilePixels, tilePixels, std::move(pixels));
+            }
+        }
+        reading.pop_front();
+    };
+
+    uint16_t width = 0, height = 0;
+    Metatile metatile;
+    while (pyramid.next(metatile)) {
+        // The view can wrap around the antimeridian, but can't extend beyond the poles.
+        const double world = tileSize * std::pow(2, metatile.z);
+        const double left = metatile.x * tileSize - options.buffer;
+        const double right = (metatile.x + metatile.cols) * tileSize + options.buffer;
+        const double top = std::max(0.0, metatile.y * tileSize - options.buffer);
+        const double bottom = std::min(world, (metatile.y + metatile.rows) * tileSize + options.buffer);
+
+        if (uint16_t(right - left) != width || uint16_t(bottom - top) != height) {
+            // Resizing drops the pending reads.
+            while (!reading.empty()) {
+                finishRead();
+            }
+            width = right - left;
+            height = bottom - top;
+            view.resize(width, height, options.pixelRatio);
+            map.resize(width, height, options.pixelRatio);
+        }
+
+        const double x = (left + right) / 2 / world;
+        const double y = (top + bottom) / 2 / world;
+        const double lon = x * 360 - 180;
+        const double lat = 360 / M_PI * std::atan(std::exp((1 - 2 * y) * M_PI)) - 90;
+        map.setLonLatZoom(lon, lat, metatile.z + std::log2(tileSize / util::tileSize));
+        map.run();
+
+        view.startReadPixels();
+        reading.push_back({ metatile, width, height, metatile.y * tileSize - top });
+        if (view.pendingReads() > 1) {
+            finishRead();
+        }
+    }
+
+    while (!reading.empty()) {
+        finishRead();
+    }
+}
+
+double number(const rapidjson::Value &value, const char *name, double fallback) {
+    return value.HasMember(name) && value[name].IsNumber() ? value[name].GetDouble() : fallback;
+}
+
+// Fields that a job leaves out are taken from /defaults/.
+Job parseJob(const std::string &line, const Job &defaults) {
+    rapidjson::Document document;
+    document.Parse<0>(line.c_str());
+    if (document.HasParseError() || !document.IsObject()) {
+        throw std::runtime_error("Jobs need to be JSON objects");
+    }
+    if (!document.HasMember("output") || !document["output"].IsString()) {
+        throw std::runtime_error("Jobs need an output file name");
+    }
+
+    Job job = defaults;
+    job.output = document["output"].GetString();
+    if (document.HasMember("style") && document["style"].IsString()) {
+        job.style = document["style"].GetString();
+    }
+    if (document.HasMember("classes") && document["classes"].IsArray()) {
+        const rapidjson::Value &classes = document["classes"];
+        job.classes.clear();
+        for (rapidjson::SizeType i = 0; i < classes.Size(); i++) {
+            job.classes.push_back(classes[i].GetString());
+        }
+    }
+    job.lon = number(document, "lon", job.lon);
+    job.lat = number(document, "lat", job.lat);
+    job.zoom = number(document, "zoom", job.zoom);
+    job.bearing = number(document, "bearing", job.bearing);
+    job.width = number(document, "width", job.width);
+    job.height = number(document, "height", job.height);
+    job.pixelRatio = number(document, "pixelRatio", job.pixelRatio);
+    return job;
+}
+
+// Renders jobs read from stdin, one per line, with the same map, so that shaders, styles, sprites,
+// glyphs and tiles are only loaded once for all of them. The pixels of a job are read back while
+// the next one renders. Several maps can share stdin and the writer; /input/ guards stdin.
+void runBatch(Map &map, HeadlessView &view, ImageWriter &writer, std::mutex &input,
+              const Job &defaults) {
+    std::string style;
+    std::vector<std::string> classes;
+    uint16_t width = 0, height = 0;
+    float pixelRatio = 0;
+
+    // The jobs whose pixels are being read, oldest first.
+    std::deque<Job> reading;
+    const auto finishRead = [&] {
+        const Job &job = reading.front();
+        const unsigned int w = job.width * job.pixelRatio;
+        const unsigned int h = job.height * job.pixelRatio;
+        std::unique_ptr<uint32_t[]> pixels = writer.buffer(w * h);
+        view.finishReadPixels(pixels.get());
+        writer.write(job.output, w, h, std::move(pixels));
+        reading.pop_front();
+    };
+
+    const auto nextLine = [&input](std::string &line) -> bool {
+        std::lock_guard<std::mutex> lock(input);
+        return bool(std::getline(std::cin, line));
+    };
+
+    std::string line;
+    while (nextLine(line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        Job job;
+        try {
+            job = parseJob(line, defaults);
+            if (job.style.empty()) {
+                throw std::runtime_error("Jobs need a style");
+            }
+
+            // Only what changed since the last job is set up again.
+            if (job.style != style) {
+                map.setStyleJSON(util::read_file(job.style), ".");
+                map.setClasses(job.classes);
+                style = job.style;
+                classes = job.classes;
+            } else if (job.classes != classes) {
+                map.setClasses(job.classes);
+                classes = job.classes;
+            }
+            if (job.width != width || job.height != height || job.pixelRatio != pixelRatio) {
+                // Resizing drops the pending reads.
+                while (!reading.empty()) {
+                    finishRead();
+                }
+                view.resize(job.width, job.height, job.pixelRatio);
+                map.resize(job.width, job.height, job.pixelRatio);
+                width = job.width;
+                height = job.height;
+                pixelRatio = job.pixelRatio;
+            }
+        } catch (const std::exception &e) {
+            // Don't keep a style around that failed to load.
+            style.clear();
+            // Jobs are reported in order.
+            while (!reading.empty()) {
+                finishRead();
+            }
+            writer.fail(job.output, e.what());
+            continue;
+        }
+
+        map.setLonLatZoom(job.lon, job.lat, job.zoom);
+        map.setBearing(job.bearing);
+        map.run();
+
+        view.startReadPixels();
+        reading.push_back(job);
+        if (view.pendingReads() > 1) {
+            finishRead();
+        }
+    }
+
+    while (!reading.empty()) {
+        finishRead();
+    }
+}
+
+}
 
 int main(int argc, char *argv[]) {
 
@@ -38,10 +600,27 @@ int main(int argc, char *argv[]) {
     std::string cache = "cache.sqlite";
     std::vector<std::string> classes;
     std::string token;
+    unsigned int threads = 0;
+    bool batch = false;
+    unsigned int contexts = 1;
+    int device = -1;
+    std::string format = "png";
+    int compression = -1;
+    std::string filter = "adaptive";
+    int quality = 90;
+    unsigned int encoders = 1;
+    Encoding encoding;
+    std::string mbtiles;
+    std::string boundsOption = "-180,-85.0511,180,85.0511";
+    std::array<double, 4> bounds;
+    int minZoom = 1;
+    int maxZoom = 6;
+    int metatile = 8;
+    PyramidOptions pyramidOptions;
 
     po::options_description desc("Allowed options");
     desc.add_options()
-        ("style,s", po::value(&style_path)->required()->value_name("json"), "Map stylesheet")
+        ("style,s", po::value(&style_path)->value_name("json"), "Map stylesheet")
         ("lon,x", po::value(&lon)->value_name("degrees")->default_value(lon), "Longitude")
         ("lat,y", po::value(&lat)->value_name("degrees")->default_value(lat), "Latitude in degrees")
         ("zoom,z", po::value(&zoom)->value_name("number")->default_value(zoom), "Zoom level")
@@ -52,21 +631,62 @@ int main(int argc, char *argv[]) {
         ("token,t", po::value(&token)->value_name("key")->default_value(token), "Mapbox access token")
         ("output,o", po::value(&output)->value_name("file")->default_value(output), "Output file name")
         ("cache,d", po::value(&cache)->value_name("file")->default_value(cache), "Cache database file name")
+        ("threads,j", po::value(&threads)->value_name("number")->default_value(threads), "Tile worker threads (0 = one per core)")
+        ("batch", po::bool_switch(&batch), "Render the jobs read from stdin, one JSON object per line; options are their defaults")
+        ("format,f", po::value(&format)->value_name("png|png8|jpeg")->default_value(format), "Image format; png8 stores at most 256 colors")
+        ("compression", po::value(&compression)->value_name("0-9")->default_value(compression), "PNG compression level (-1 = default)")
+        ("filter", po::value(&filter)->value_name("name")->default_value(filter), "PNG row filter: adaptive, none, sub, up, average or paeth")
+        ("quality,q", po::value(&quality)->value_name("0-100")->default_value(quality), "JPEG quality")
+        ("encoders", po::value(&encoders)->value_name("number")->default_value(encoders), "Threads that encode batch images")
+        ("contexts", po::value(&contexts)->value_name("number")->default_value(contexts), "Maps that render batch jobs or metatiles in parallel, each on its own thread and GL context")
+        ("device", po::value(&device)->value_name("index")->default_value(device), "Index of the GPU to render on, which needs no X server (-1 = default display; EGL builds only)")
+        ("mbtiles", po::value(&mbtiles)->value_name("file"), "Render a tile pyramid into this MBTiles file")
+        ("bounds", po::value(&boundsOption)->value_name("w,s,e,n")->default_value(boundsOption), "Area of the tile pyramid in degrees")
+        ("minzoom", po::value(&minZoom)->value_name("number")->default_value(minZoom), "Lowest zoom level of the tile pyramid")
+        ("maxzoom", po::value(&maxZoom)->value_name("number")->default_value(maxZoom), "Highest zoom level of the tile pyramid")
+        ("metatile", po::value(&metatile)->value_name("tiles")->default_value(metatile), "Tiles per side of the blocks that are rendered in one frame")
+        ("tile-size", po::value(&pyramidOptions.tileSize)->value_name("pixels")->default_value(pyramidOptions.tileSize), "Size of the pyramid's tiles")
+        ("buffer", po::value(&pyramidOptions.buffer)->value_name("pixels")->default_value(pyramidOptions.buffer), "Pixels rendered around each metatile for label placement")
     ;
 
     try {
         po::variables_map vm;
         po::store(po::parse_command_line(argc, argv, desc), vm);
         po::notify(vm);
+        if (!batch && style_path.empty()) {
+            throw std::runtime_error("the option '--style' is required");
+        }
+        if (contexts == 0 || encoders == 0) {
+            throw std::runtime_error("the options '--contexts' and '--encoders' need to be at least 1");
+        }
+        encoding = parseEncoding(format, compression, filter, quality);
+
+        if (!mbtiles.empty()) {
+            char separator;
+            std::istringstream stream(boundsOption);
+            if (!(stream >> bounds[0] >> separator >> bounds[1] >> separator >> bounds[2] >> separator >> bounds[3]) ||
+                bounds[0] > bounds[2] || bounds[1] > bounds[3]) {
+                throw std::runtime_error("the option '--bounds' needs to be west,south,east,north");
+            }
+            if (metatile < 1 || pyramidOptions.tileSize == 0) {
+                throw std::runtime_error("the options '--metatile' and '--tile-size' need to be at least 1");
+            }
+
+            // The map doesn't zoom out beyond a world of util::tileSize pixels, nor in beyond its
+            // maximum zoom level.
+            const double offset = std::log2(pyramidOptions.tileSize / util::tileSize);
+            if (minZoom + offset < 0 || maxZoom + offset > 18 || minZoom > maxZoom) {
+                throw std::runtime_error("tiles of " + std::to_string(pyramidOptions.tileSize) +
+                                         " pixels can be rendered from zoom level " + std::to_string(int(std::ceil(-offset))) +
+                                         " to " + std::to_string(int(std::floor(18 - offset))));
+            }
+            pyramidOptions.pixelRatio = pixelRatio;
+        }
     } catch(std::exception& e) {
         std::cout << "Error: " << e.what() << std::endl << desc;
         exit(1);
     }
 
-    std::string style = mbgl::util::read_file(style_path);
-
-    using namespace mbgl;
-
 
 #if __APPLE__
     Log::Set<NSLogBackend>();
@@ -74,8 +694,6 @@ int main(int argc, char *argv[]) {
     Log::Set<StderrLogBackend>();
 #endif
 
-    CachingHTTPFileSource fileSource(cache);
-
     // Try to load the token from the environment.
     if (!token.size()) {
         const char *token_ptr = getenv("MAPBOX_ACCESS_TOKEN");
@@ -84,14 +702,84 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if (batch || !mbtiles.empty()) {
+        Job defaults;
+        defaults.style = style_path;
+        defaults.classes = classes;
+        defaults.lon = lon;
+        defaults.lat = lat;
+        defaults.zoom = zoom;
+        defaults.bearing = bearing;
+        defaults.width = width;
+        defaults.height = height;
+        defaults.pixelRatio = pixelRatio;
+
+        // The views are created up front on this thread, since creating one loads the GL
+        // extensions for the whole process. They share GL objects with the first one.
+        auto display = std::make_shared<HeadlessDisplay>(device);
+        std::vector<std::unique_ptr<HeadlessView>> views;
+        views.push_back(util::make_unique<HeadlessView>(display));
+        for (unsigned int i = 1; i < contexts; i++) {
+            views.push_back(util::make_unique<HeadlessView>(display, *views.front()));
+        }
+
+        // Tiles are encoded like images, but stored in the MBTiles file, which has to outlive the
+        // writer.
+        std::unique_ptr<MBTilesWriter> tiles;
+        std::unique_ptr<Pyramid> pyramid;
+        ImageWriter::Store store = util::write_file;
+        if (!mbtiles.empty()) {
+            const std::string tileFormat = encoding.format == Encoding::Format::JPEG ? "jpg" : "png";
+            tiles = util::make_unique<MBTilesWriter>(mbtiles, tileFormat, bounds, minZoom, maxZoom);
+            pyramid = util::make_unique<Pyramid>(bounds, minZoom, maxZoom, metatile);
+            MBTilesWriter *tileWriter = tiles.get();
+            store = [tileWriter](const std::string &path, const std::string &data) {
+                tileWriter->put(path, data);
+            };
+        }
+
+        ImageWriter writer(encoding, encoders, store);
+        std::mutex input;
+        std::vector<std::thread> renderers;
+        for (auto &view : views) {
+            HeadlessView *renderView = view.get();
+            renderers.emplace_back([&, renderView] {
+                // A file source serves the thread it was created on, so every map gets its own.
+                // They share the cache database.
+                CachingHTTPFileSource renderSource(cache);
+                if (token.size()) {
+                    renderSource.setAccessToken(std::string(token));
+                }
+
+                Map map(*renderView, renderSource);
+                map.setWorkerCount(threads);
+                if (pyramid) {
+                    map.setStyleJSON(util::read_file(style_path), ".");
+                    map.setClasses(classes);
+                    runPyramid(map, *renderView, writer, *pyramid, pyramidOptions);
+                } else {
+                    runBatch(map, *renderView, writer, input, defaults);
+                }
+            });
+        }
+        for (std::thread &renderer : renderers) {
+            renderer.join();
+        }
+        return 0;
+    }
+
+    CachingHTTPFileSource fileSource(cache);
+
     // Set access token if present
     if (token.size()) {
         fileSource.setAccessToken(std::string(token));
     }
 
-    HeadlessView view;
+    HeadlessView view(std::make_shared<HeadlessDisplay>(device));
     Map map(view, fileSource);
+    map.setWorkerCount(threads);
 
+    std::string style = util::read_file(style_path);
     map.setStyleJSON(style, ".");
     map.setClasses(classes);
 
@@ -100,16 +788,16 @@ int main(int argc, char *argv[]) {
     map.setLonLatZoom(lon, lat, zoom);
     map.setBearing(bearing);
 
-    std::unique_ptr<uint32_t[]> pixels;
-
     // Run the loop. It will terminate when we don't have any further listeners.
     map.run();
 
-    // Get the data from the GPU.
-    pixels = view.readPixels();
-
+    // Get the data from the GPU. The rows are flipped while encoding.
     const unsigned int w = width * pixelRatio;
     const unsigned int h = height * pixelRatio;
-    const std::string image = util::compress_png(w, h, pixels.get());
+    auto pixels = util::make_unique<uint32_t[]>(w * h);
+    view.startReadPixels();
+    view.finishReadPixels(pixels.get());
+
+    const std::string image = encode(encoding, w, h, pixels.get());
     util::write_file(output, image);
 }
@@ -50,5 +50,330 @@
         '../mapboxgl.gyp:copy_certificate_bundle',
       ],
     },
+    {
+      'target_name': 'mbgl-benchmark',
+      'product_name': 'mbgl-benchmark',
+      'type': 'executable',
+      'sources': [
+        './benchmark.cpp',
+      ],
+      'variables' : {
+        'cflags': [
+          '<@(uv_cflags)',
+          '<@(png_cflags)',
+          '-I<(boost_root)/include',
+        ],
+        'ldflags': [
+          '<@(glfw3_ldflags)',
+          '<@(uv_ldflags)',
+          '<@(sqlite3_static_libs)',
+          '<@(sqlite3_ldflags)',
+          '<@(curl_ldflags)',
+          '<@(png_ldflags)',
+          '<@(uv_static_libs)',
+          '-L<(boost_root)/lib',
+          '-lboost_program_options'
+        ],
+      },
+      'conditions': [
+        # add libuv include path and OpenGL libs
+        ['OS == "mac"',
+          {
+            'xcode_settings': {
+              'OTHER_CPLUSPLUSFLAGS': ['<@(cflags)'],
+              'OTHER_LDFLAGS': ['<@(ldflags)'],
+            },
+          },
+          {
+            'cflags': ['<@(cflags)'],
+            'libraries': ['<@(ldflags)'],
+          }],
+      ],
+      'include_dirs': [ '../src' ],
+      'dependencies': [
+        '../mapboxgl.gyp:mbgl-standalone',
+        '../mapboxgl.gyp:mbgl-headless',
+        '../mapboxgl.gyp:mbgl-<(platform)',
+        '../mapboxgl.gyp:copy_certificate_bundle',
+      ],
+    },
+    {
+      'target_name': 'mbgl-parse-benchmark',
+      'product_name': 'mbgl-parse-benchmark',
+      'type': 'executable',
+      'sources': [
+        './parse_benchmark.cpp',
+      ],
+      'variables' : {
+        'cflags': [
+          '<@(uv_cflags)',
+          '<@(png_cflags)',
+          '-I<(boost_root)/include',
+        ],
+        'ldflags': [
+          '<@(glfw3_ldflags)',
+          '<@(uv_ldflags)',
+          '<@(sqlite3_static_libs)',
+          '<@(sqlite3_ldflags)',
+          '<@(curl_ldflags)',
+          '<@(png_ldflags)',
+          '<@(uv_static_libs)',
+          '-L<(boost_root)/lib',
+          '-lboost_program_options'
+        ],
+      },
+      'conditions': [
+        # add libuv include path and OpenGL libs
+        ['OS == "mac"',
+          {
+            'xcode_settings': {
+              'OTHER_CPLUSPLUSFLAGS': ['<@(cflags)'],
+              'OTHER_LDFLAGS': ['<@(ldflags)'],
+            },
+          },
+          {
+            'cflags': ['<@(cflags)'],
+            'libraries': ['<@(ldflags)'],
+          }],
+      ],
+      'include_dirs': [ '../src' ],
+      'dependencies': [
+        '../mapboxgl.gyp:mbgl-standalone',
+        '../mapboxgl.gyp:mbgl-headless',
+        '../mapboxgl.gyp:mbgl-<(platform)',
+        '../mapboxgl.gyp:copy_certificate_bundle',
+      ],
+    },
+    {
+      'target_name': 'mbgl-symbol-benchmark',
+      'product_name': 'mbgl-symbol-benchmark',
+      'type': 'executable',
+      'sources': [
+        './symbol_benchmark.cpp',
+      ],
+      'variables' : {
+        'cflags': [
+          '<@(uv_cflags)',
+          '<@(png_cflags)',
+          '-I<(boost_root)/include',
+        ],
+        'ldflags': [
+          '<@(glfw3_ldflags)',
+          '<@(uv_ldflags)',
+          '<@(sqlite3_static_libs)',
+          '<@(sqlite3_ldflags)',
+          '<@(curl_ldflags)',
+          '<@(png_ldflags)',
+          '<@(uv_static_libs)',
+          '-L<(boost_root)/lib',
+          '-lboost_program_options'
+        ],
+      },
+      'conditions': [
+        # add libuv include path and OpenGL libs
+        ['OS == "mac"',
+          {
+            'xcode_settings': {
+              'OTHER_CPLUSPLUSFLAGS': ['<@(cflags)'],
+              'OTHER_LDFLAGS': ['<@(ldflags)'],
+            },
+          },
+          {
+            'cflags': ['<@(cflags)'],
+            'libraries': ['<@(ldflags)'],
+          }],
+      ],
+      'include_dirs': [ '../src' ],
+      'dependencies': [
+        '../mapboxgl.gyp:mbgl-standalone',
+        '../mapboxgl.gyp:mbgl-headless',
+        '../mapboxgl.gyp:mbgl-<(platform)',
+        '../mapboxgl.gyp:copy_certificate_bundle',
+      ],
+    },
+    {
+      'target_name': 'mbgl-function-benchmark',
+      'product_name': 'mbgl-function-benchmark',
+      'type': 'executable',
+      'sources': [
+        './function_benchmark.cpp',
+      ],
+      'variables' : {
+        'cflags': [
+          '<@(uv_cflags)',
+          '<@(png_cflags)',
+          '-I<(boost_root)/include',
+        ],
+        'ldflags': [
+          '<@(glfw3_ldflags)',
+          '<@(uv_ldflags)',
+          '<@(sqlite3_static_libs)',
+          '<@(sqlite3_ldflags)',
+          '<@(curl_ldflags)',
+          '<@(png_ldflags)',
+          '<@(uv_static_libs)',
+          '-L<(boost_root)/lib',
+          '-lboost_program_options'
+        ],
+      },
+      'conditions': [
+        # add libuv include path and OpenGL libs
+        ['OS == "mac"',
+          {
+            'xcode_settings': {
+              'OTHER_CPLUSPLUSFLAGS': ['<@(cflags)'],
+              'OTHER_LDFLAGS': ['<@(ldflags)'],
+            },
+          },
+          {
+            'cflags': ['<@(cflags)'],
+            'libraries': ['<@(ldflags)'],
+          }],
+      ],
+      'include_dirs': [ '../src' ],
+      'dependencies': [
+        '../mapboxgl.gyp:mbgl-standalone',
+        '../mapboxgl.gyp:mbgl-headless',
+        '../mapboxgl.gyp:mbgl-<(platform)',
+      ],
+    },
+    {
+      'target_name': 'mbgl-compile-style',
+      'product_name': 'mbgl-compile-style',
+      'type': 'executable',
+      'sources': [
+        './compile_style.cpp',
+      ],
+      'variables' : {
+        'cflags': [
+          '<@(uv_cflags)',
+          '<@(png_cflags)',
+          '-I<(boost_root)/include',
+        ],
+        'ldflags': [
+          '<@(glfw3_ldflags)',
+          '<@(uv_ldflags)',
+          '<@(sqlite3_static_libs)',
+          '<@(sqlite3_ldflags)',
+          '<@(curl_ldflags)',
+          '<@(png_ldflags)',
+          '<@(uv_static_libs)',
+          '-L<(boost_root)/lib',
+          '-lboost_program_options'
+        ],
+      },
+      'conditions': [
+        # add libuv include path and OpenGL libs
+        ['OS == "mac"',
+          {
+            'xcode_settings': {
+              'OTHER_CPLUSPLUSFLAGS': ['<@(cflags)'],
+              'OTHER_LDFLAGS': ['<@(ldflags)'],
+            },
+          },
+          {
+            'cflags': ['<@(cflags)'],
+            'libraries': ['<@(ldflags)'],
+          }],
+      ],
+      'include_dirs': [ '../src' ],
+      'dependencies': [
+        '../mapboxgl.gyp:mbgl-standalone',
+        '../mapboxgl.gyp:mbgl-headless',
+        '../mapboxgl.gyp:mbgl-<(platform)',
+      ],
+    },
+    {
+      'target_name': 'mbgl-messenger-benchmark',
+      'product_name': 'mbgl-messenger-benchmark',
+      'type': 'executable',
+      'sources': [
+        './messenger_benchmark.cpp',
+      ],
+      'variables' : {
+        'cflags': [
+          '<@(uv_cflags)',
+          '<@(png_cflags)',
+          '-I<(boost_root)/include',
+        ],
+        'ldflags': [
+          '<@(glfw3_ldflags)',
+          '<@(uv_ldflags)',
+          '<@(sqlite3_static_libs)',
+          '<@(sqlite3_ldflags)',
+          '<@(curl_ldflags)',
+          '<@(png_ldflags)',
+          '<@(uv_static_libs)',
+          '-L<(boost_root)/lib',
+          '-lboost_program_options'
+        ],
+      },
+      'conditions': [
+        # add libuv include path and OpenGL libs
+        ['OS == "mac"',
+          {
+            'xcode_settings': {
+              'OTHER_CPLUSPLUSFLAGS': ['<@(cflags)'],
+              'OTHER_LDFLAGS': ['<@(ldflags)'],
+            },
+          },
+          {
+            'cflags': ['<@(cflags)'],
+            'libraries': ['<@(ldflags)'],
+          }],
+      ],
+      'include_dirs': [ '../src' ],
+      'dependencies': [
+        '../mapboxgl.gyp:mbgl-standalone',
+        '../mapboxgl.gyp:mbgl-headless',
+        '../mapboxgl.gyp:mbgl-<(platform)',
+      ],
+    },
+    {
+      'target_name': 'mbgl-storage-benchmark',
+      'product_name': 'mbgl-storage-benchmark',
+      'type': 'executable',
+      'sources': [
+        './storage_benchmark.cpp',
+        # The benchmark brings its own HTTP implementation, so it only takes the platform
+        # sources that the storage layer needs besides that.
+        '../platform/default/asset_request_libuv.cpp',
+      ],
+      'variables' : {
+        'cflags': [
+          '<@(uv_cflags)',
+          '<@(sqlite3_cflags)',
+          '-I<(boost_root)/include',
+        ],
+        'ldflags': [
+          '<@(uv_ldflags)',
+          '<@(sqlite3_static_libs)',
+          '<@(sqlite3_ldflags)',
+          '<@(zlib_ldflags)',
+          '<@(uv_static_libs)',
+          '-L<(boost_root)/lib',
+          '-lboost_program_options'
+        ],
+      },
+      'conditions': [
+        ['OS == "mac"',
+          {
+            'sources': [ '../platform/darwin/application_root.mm' ],
+            'xcode_settings': {
+              'OTHER_CPLUSPLUSFLAGS': ['<@(cflags)'],
+              'OTHER_LDFLAGS': ['<@(ldflags)', '-framework Foundation'],
+            },
+          },
+          {
+            'sources': [ '../platform/default/application_root.cpp' ],
+            'cflags': ['<@(cflags)'],
+            'libraries': ['<@(ldflags)'],
+          }],
+      ],
+      'include_dirs': [ '../src' ],
+      'dependencies': [
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+    },
   ],
 }
@@ -0,0 +1,538 @@
+#include <mbgl/storage/caching_http_file_source.hpp>
+#include <mbgl/storage/http_request_baton.hpp>
+#include <mbgl/storage/request.hpp>
+#include <mbgl/storage/sqlite_store.hpp>
+#include <mbgl/util/io.hpp>
+#include <mbgl/util/std.hpp>
+#include <mbgl/util/time.hpp>
+#include <mbgl/util/uv_detail.hpp>
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+typedef rapidjson::PrettyWriter<rapidjson::StringBuffer> Writer;
+
+// Stands in for the platform's HTTP implementation, so that the benchmark measures the storage
+// layer instead of the network: requests are answered from a table of resources on a thread of
+// its own, after a fixed delay.
+class MockServer {
+public:
+    struct Resource {
+        std::shared_ptr<const std::string> data;
+        // Answered with an expiration date in the past, so that the cached entry has to be
+        // revalidated when it is requested again.
+        bool expired = false;
+    };
+
+    static MockServer &shared() {
+        static MockServer server;
+        return server;
+    }
+
+    ~MockServer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_one();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    // May only be changed while no request is in flight.
+    std::unordered_map<std::string, Resource> resources;
+    timestamp latency = 0;
+
+    // Requests that were answered, not counting canceled ones.
+    std::atomic<uint64_t> answered { 0 };
+
+    void start(const util::ptr<HTTPRequestBaton> &baton) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!thread.joinable()) {
+                thread = std::thread([this] { run(); });
+            }
+            // All requests take equally long, so the queue stays ordered by due time.
+            queue.emplace_back(util::now() + latency, baton);
+        }
+        condition.notify_one();
+    }
+
+    void stop(const util::ptr<HTTPRequestBaton> &baton) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = std::find_if(queue.begin(), queue.end(), [&](const Pending &pending) {
+            return pending.second == baton;
+        });
+        if (it != queue.end()) {
+            queue.erase(it);
+            baton->type = HTTPResponseType::Canceled;
+            uv_async_send(baton->async);
+            baton->async = nullptr;
+        }
+    }
+
+private:
+    typedef std::pair<timestamp, util::ptr<HTTPRequestBaton>> Pending;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            if (queue.empty()) {
+                condition.wait(lock);
+                continue;
+            }
+            const timestamp now = util::now();
+            if (queue.front().first > now) {
+                condition.wait_for(lock, std::chrono::nanoseconds(queue.front().first - now));
+                continue;
+            }
+            const util::ptr<HTTPRequestBaton> baton = queue.front().second;
+            queue.pop_front();
+            answer(*baton);
+            uv_async_send(baton->async);
+            baton->async = nullptr;
+            answered++;
+        }
+    }
+
+    void answer(HTTPRequestBaton &baton) {
+        const auto it = resources.find(baton.path);
+        if (it == resources.end()) {
+            baton.type = HTTPResponseType::PermanentError;
+            baton.response = util::make_unique<Response>();
+            baton.response->code = 404;
+            return;
+        }
+
+        const int64_t expires = it->second.expired ? 1 : std::time(nullptr) + 3600;
+        if (baton.response && baton.response->etag == etag) {
+            // Revalidation of the cached entry.
+            baton.type = HTTPResponseType::NotModified;
+            baton.response->expires = expires;
+        } else {
+            baton.type = HTTPResponseType::Successful;
+            baton.response = util::make_unique<Response>();
+            baton.response->code = 200;
+            baton.response->etag = etag;
+            baton.response->expires = expires;
+            baton.response->data = it->second.data;
+        }
+    }
+
+    const std::string etag = "\"mock\"";
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Pending> queue;
+    bool stopping = false;
+};
+
+// Runs the loop until /done/ returns true or a minute passed. Returns whether it is done.
+bool runUntil(uv_loop_t *loop, std::function<bool()> done) {
+    const timestamp deadline = util::now() + 60_seconds;
+    while (!done()) {
+        if (util::now() > deadline) {
+            return false;
+        }
+        uv_run(loop, UV_RUN_ONCE);
+    }
+    return true;
+}
+
+double milliseconds(timestamp duration) {
+    return duration / 1e6;
+}
+
+// Writes the median and 99th percentile of the durations.
+void writeDistribution(Writer &writer, std::vector<timestamp> durations) {
+    std::sort(durations.begin(), durations.end());
+    writer.StartObject();
+    if (!durations.empty()) {
+        writer.String("p50");
+        writer.Double(milliseconds(durations[(durations.size() - 1) / 2]));
+        writer.String("p99");
+        writer.Double(milliseconds(durations[(durations.size() - 1) * 99 / 100]));
+    }
+    writer.EndObject();
+}
+
+// A cache database of its own for every run, so that runs don't see each other's entries.
+std::string databasePath(const std::string &directory, const std::string &name) {
+    const std::string path = directory + "/mbgl-storage-benchmark-" + std::to_string(getpid()) +
+                             "-" + name + ".db";
+    std::remove(path.c_str());
+    return path;
+}
+
+uint64_t fileSize(const std::string &path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? uint64_t(info.st_size) : 0;
+}
+
+// Random letters, which zlib compresses to a bit more than half of their size.
+std::shared_ptr<const std::string> makeBody(size_t size, std::mt19937 &random) {
+    std::uniform_int_distribution<int> letter('a', 'p');
+    std::string body(size, ' ');
+    for (char &c : body) {
+        c = char(letter(random));
+    }
+    return std::make_shared<const std::string>(std::move(body));
+}
+
+std::string resourceURL(ResourceType type, unsigned int i) {
+    std::ostringstream url;
+    if (type == ResourceType::Tile) {
+        url << "http://storage.benchmark/v4/14/" << i << "/" << i << ".pbf";
+    } else {
+        url << "http://storage.benchmark/json/" << i << ".json";
+    }
+    return url.str();
+}
+
+struct Workload {
+    std::string directory;
+    unsigned int requests = 1000;
+    unsigned int concurrency = 32;
+    size_t smallSize = 2 * 1024;
+    size_t largeSize = 128 * 1024;
+    double largeRatio = 0.1;
+    double revalidateRatio = 0.2;
+};
+
+// Requests /workload.requests/ distinct resources through the file source, keeping up to
+// /workload.concurrency/ of them in flight. The given fraction of them is in the cache already;
+// some of those expired and are revalidated after they were handed out. Tiles are stored raw,
+// JSON compressed, so /type/ picks the kind of rows that are read and written.
+void runFileSource(Writer &writer, const Workload &workload, ResourceType type, double hitRatio) {
+    MockServer &server = MockServer::shared();
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    std::vector<std::string> urls;
+    std::vector<bool> cached;
+    server.resources.clear();
+    for (unsigned int i = 0; i < workload.requests; i++) {
+        urls.push_back(resourceURL(type, i));
+        cached.push_back(uniform(random) < hitRatio);
+        MockServer::Resource &resource = server.resources[urls.back()];
+        const bool large = uniform(random) < workload.largeRatio;
+        resource.data = makeBody(large ? workload.largeSize : workload.smallSize, random);
+        resource.expired = cached.back() && uniform(random) < workload.revalidateRatio;
+    }
+
+    const std::string path = databasePath(workload.directory, "file-source");
+    uv::loop loop;
+    CachingHTTPFileSource fileSource(path);
+    fileSource.setLoop(*loop);
+
+    // Fills the cache, then drops what the store kept in memory so that hits read the database.
+    std::vector<std::unique_ptr<Request>> requests;
+    unsigned int warmed = 0;
+    for (unsigned int i = 0; i < workload.requests; i++) {
+        if (cached[i]) {
+            requests.push_back(fileSource.request(type, urls[i]));
+            requests.back()->onload([&warmed](const Response &) { warmed++; });
+        }
+    }
+    const size_t warming = requests.size();
+    if (!runUntil(*loop, [&] { return warmed == warming; })) {
+        std::cerr << "Warning: The cache couldn't be filled" << std::endl;
+    }
+    requests.clear();
+    fileSource.releaseMemory();
+
+    // The revalidations answer with fresh expiration dates.
+    unsigned int expired = 0;
+    for (auto &pair : server.resources) {
+        expired += pair.second.expired;
+        pair.second.expired = false;
+    }
+
+    const FileSourceStatistics before = fileSource.getStatistics();
+    const uint64_t answered = server.answered;
+    std::vector<timestamp> latencies(workload.requests);
+    std::vector<bool> done(workload.requests);
+    unsigned int started = 0, completed = 0;
+
+    // Requests stay alive until the end of the run, so that stale responses are revalidated.
+    std::function<void()> startNext = [&] {
+        const unsigned int i = started++;
+        const timestamp start = util::now();
+        requests.push_back(fileSource.request(type, urls[i]));
+        requests.back()->onload([&, i, start](const Response &) {
+            if (done[i]) {
+                return;
+            }
+            done[i] = true;
+            latencies[i] = util::now() - start;
+            completed++;
+            if (started < workload.requests) {
+                startNext();
+            }
+        });
+    };
+
+    const timestamp start = util::now();
+    while (started < std::min(workload.concurrency, workload.requests)) {
+        startNext();
+    }
+    if (!runUntil(*loop, [&] { return completed == workload.requests; })) {
+        std::cerr << "Warning: " << (workload.requests - completed) << " requests didn't complete" << std::endl;
+    }
+    const timestamp duration = util::now() - start;
+
+    runUntil(*loop, [&] {
+        return server.answered - answered ==
+               fileSource.getStatistics().cacheMisses - before.cacheMisses;
+    });
+    const FileSourceStatistics after = fileSource.getStatistics();
+
+    requests.clear();
+    fileSource.clearLoop();
+    uv_run(*loop, UV_RUN_DEFAULT);
+    std::remove(path.c_str());
+
+    writer.StartObject();
+    writer.String("resources");
+    writer.String(type == ResourceType::Tile ? "tiles" : "json");
+    writer.String("rows");
+    writer.String(type == ResourceType::Tile ? "raw" : "zlib");
+    writer.String("hitRatio");
+    writer.Double(hitRatio);
+    writer.String("requests");
+    writer.Uint(completed);
+    writer.String("requestsPerSecond");
+    writer.Double(completed / (duration / 1e9));
+    writer.String("latencyMs");
+    writeDistribution(writer, latencies);
+    writer.String("cacheHits");
+    writer.Uint64(after.cacheHits - before.cacheHits);
+    writer.String("cacheMisses");
+    writer.Uint64(after.cacheMisses - before.cacheMisses);
+    writer.String("revalidated");
+    writer.Uint(expired);
+    writer.EndObject();
+}
+
+struct Read {
+    timestamp start;
+    std::function<void(timestamp, bool)> *done;
+};
+
+// Writes /workload.requests/ tiles of /size/ bytes to a store in batches of the store's default
+// size, then reads them back in random order with up to /workload.concurrency/ reads in flight.
+// The write lag is the time from the first put of a batch until its last entry could be read,
+// which waits until the batch is written.
+void runStore(Writer &writer, const Workload &workload, SQLiteStore::Codec codec, size_t size) {
+    const size_t batchSize = 64;
+    std::mt19937 random(2);
+
+    std::vector<std::shared_ptr<const std::string>> bodies;
+    for (unsigned int i = 0; i < 16; i++) {
+        bodies.push_back(makeBody(size, random));
+    }
+    std::vector<std::string> urls;
+    for (unsigned int i = 0; i < workload.requests; i++) {
+        urls.push_back(resourceURL(ResourceType::Tile, i));
+    }
+
+    const std::string path = databasePath(workload.directory, "store");
+    uv::loop loop;
+    std::vector<timestamp> lags, latencies;
+    timestamp writing = 0, reading = 0;
+    unsigned int missing = 0;
+    {
+        // Without a memory cache every get reads the database, and without eviction every entry
+        // stays in it.
+        SQLiteStore store(*loop, path, batchSize, 250, 0, 0);
+        store.setCodec(ResourceType::Tile, codec);
+
+        Response response;
+        response.code = 200;
+        response.etag = "\"mock\"";
+        response.expires = std::time(nullptr) + 3600;
+
+        for (size_t i = 0; i < urls.size(); i += batchSize) {
+            const size_t end = std::min(i + batchSize, urls.size());
+            bool written = false;
+            const timestamp start = util::now();
+            for (size_t j = i; j < end; j++) {
+                response.data = bodies[j % bodies.size()];
+                store.put(urls[j], ResourceType::Tile, response);
+            }
+            store.get(urls[end - 1], [](std::unique_ptr<Response> &&, void *ptr) {
+                *reinterpret_cast<bool *>(ptr) = true;
+            }, &written);
+            runUntil(*loop, [&] { return written; });
+            lags.push_back(util::now() - start);
+            writing += lags.back();
+        }
+
+        store.releaseMemory();
+        std::shuffle(urls.begin(), urls.end(), random);
+
+        size_t started = 0, completed = 0;
+        std::function<void(timestamp, bool)> done;
+        const auto startNext = [&] {
+            store.get(urls[started++], [](std::unique_ptr<Response> &&entry, void *ptr) {
+                std::unique_ptr<Read> read { reinterpret_cast<Read *>(ptr) };
+                (*read->done)(read->start, bool(entry));
+            }, new Read { util::now(), &done });
+        };
+        done = [&](timestamp start, bool found) {
+            latencies.push_back(util::now() - start);
+            missing += !found;
+            completed++;
+            if (started < urls.size()) {
+                startNext();
+            }
+        };
+
+        const timestamp start = util::now();
+        while (started < std::min<size_t>(workload.concurrency, urls.size())) {
+            startNext();
+        }
+        if (!runUntil(*loop, [&] { return completed == urls.size(); })) {
+            std::cerr << "Warning: " << (urls.size() - completed) << " reads didn't complete" << std::endl;
+        }
+        reading = util::now() - start;
+    }
+    uv_run(*loop, UV_RUN_DEFAULT);
+    const uint64_t databaseSize = fileSize(path);
+    std::remove(path.c_str());
+
+    if (missing) {
+        std::cerr << "Warning: " << missing << " entries weren't found" << std::endl;
+    }
+
+    writer.StartObject();
+    writer.String("rows");
+    writer.String(codec == SQLiteStore::Codec::Zlib ? "zlib" : "raw");
+    writer.String("bodyBytes");
+    writer.Uint64(size);
+    writer.String("entries");
+    writer.Uint64(urls.size());
+    writer.String("databaseBytes");
+    writer.Uint64(databaseSize);
+    writer.String("putsPerSecond");
+    writer.Double(urls.size() / (writing / 1e9));
+    writer.String("writeLagMs");
+    writeDistribution(writer, lags);
+    writer.String("getsPerSecond");
+    writer.Double(urls.size() / (reading / 1e9));
+    writer.String("getLatencyMs");
+    writeDistribution(writer, latencies);
+    writer.EndObject();
+}
+
+}
+
+// The benchmark replaces the platform's HTTP implementation with the mock server.
+namespace mbgl {
+
+void HTTPRequestBaton::start(const util::ptr<HTTPRequestBaton> &ptr) {
+    MockServer::shared().start(ptr);
+}
+
+void HTTPRequestBaton::stop(const util::ptr<HTTPRequestBaton> &ptr) {
+    MockServer::shared().stop(ptr);
+}
+
+void HTTPRequestBaton::setMaxHostConnections(unsigned) {
+}
+
+void HTTPRequestBaton::setBackgroundSessionIdentifier(const std::string &) {
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::string output;
+    Workload workload;
+    workload.directory = "/tmp";
+    unsigned int latency = 20;
+    std::vector<double> hitRatios;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("output,o", po::value(&output)->value_name("file"), "Results file name (default: stdout)")
+        ("directory,d", po::value(&workload.directory)->value_name("path")->default_value(workload.directory), "Directory for the cache databases")
+        ("requests,n", po::value(&workload.requests)->value_name("number")->default_value(workload.requests), "Distinct resources requested per run")
+        ("concurrency,c", po::value(&workload.concurrency)->value_name("number")->default_value(workload.concurrency), "Requests in flight at once")
+        ("latency,l", po::value(&latency)->value_name("ms")->default_value(latency), "Time the mock server takes to answer")
+        ("hit-ratio", po::value(&hitRatios)->value_name("fraction")->multitoken(), "Fractions of the requests that are cached already (default: 0 0.5 0.9 1)")
+        ("revalidate-ratio", po::value(&workload.revalidateRatio)->value_name("fraction")->default_value(workload.revalidateRatio), "Fraction of the cached resources that expired")
+        ("large-ratio", po::value(&workload.largeRatio)->value_name("fraction")->default_value(workload.largeRatio), "Fraction of the resources with large bodies")
+        ("small-size", po::value(&workload.smallSize)->value_name("bytes")->default_value(workload.smallSize), "Size of small bodies")
+        ("large-size", po::value(&workload.largeSize)->value_name("bytes")->default_value(workload.largeSize), "Size of large bodies")
+    ;
+
+    try {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    } catch(std::exception& e) {
+        std::cout << "Error: " << e.what() << std::endl << desc;
+        exit(1);
+    }
+
+    if (hitRatios.empty()) {
+        hitRatios = { 0, 0.5, 0.9, 1 };
+    }
+    MockServer::shared().latency = latency * 1_millisecond;
+
+    rapidjson::StringBuffer buffer;
+    Writer writer(buffer);
+    writer.StartObject();
+
+    writer.String("fileSource");
+    writer.StartArray();
+    for (ResourceType type : { ResourceType::Tile, ResourceType::JSON }) {
+        for (double hitRatio : hitRatios) {
+            runFileSource(writer, workload, type, hitRatio);
+        }
+    }
+    writer.EndArray();
+
+    writer.String("sqliteStore");
+    writer.StartArray();
+    for (SQLiteStore::Codec codec : { SQLiteStore::Codec::Raw, SQLiteStore::Codec::Zlib }) {
+        for (size_t size : { workload.smallSize, workload.largeSize }) {
+            runStore(writer, workload, codec, size);
+        }
+    }
+    writer.EndArray();
+
+    writer.EndObject();
+
+    if (output.empty()) {
+        std::cout << buffer.GetString() << std::endl;
+    } else {
+        util::write_file(output, buffer.GetString());
+    }
+}
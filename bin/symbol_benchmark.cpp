@@ -0,0 +1,468 @@
+#include <mbgl/map/vector_tile.hpp>
+#include <mbgl/map/vector_tile_data.hpp>
+#include <mbgl/map/sprite.hpp>
+#include <mbgl/renderer/symbol_bucket.hpp>
+#include <mbgl/style/style.hpp>
+#include <mbgl/style/style_layer.hpp>
+#include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/style/style_bucket.hpp>
+#include <mbgl/style/style_source.hpp>
+#include <mbgl/geometry/glyph_atlas.hpp>
+#include <mbgl/geometry/sprite_atlas.hpp>
+#include <mbgl/text/collision.hpp>
+#include <mbgl/text/glyph_store.hpp>
+#include <mbgl/util/uv_detail.hpp>
+#include <mbgl/util/std.hpp>
+#include <mbgl/util/io.hpp>
+#include <mbgl/util/time.hpp>
+#include <mbgl/util/allocation_tracker.hpp>
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <mbgl/storage/caching_http_file_source.hpp>
+
+#if __APPLE__
+#include <mbgl/platform/darwin/log_nslog.hpp>
+#else
+#include <mbgl/platform/default/log_stderr.hpp>
+#endif
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <set>
+#include <thread>
+
+using namespace mbgl;
+
+// Every allocation of the process is counted, so that the benchmark can report how many
+// allocations the symbol buckets of a tile take. Builds that track allocations by subsystem
+// replace operator new themselves, and count the allocations of every stage, too.
+#if !defined(MBGL_TRACK_ALLOCATIONS)
+namespace {
+std::atomic<uint64_t> allocations { 0 };
+}
+
+void *operator new(std::size_t size) {
+    allocations++;
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+#endif
+
+namespace {
+
+typedef rapidjson::PrettyWriter<rapidjson::StringBuffer> Writer;
+typedef SymbolBucket::Profile Profile;
+
+struct Fixture {
+    std::string path;
+    Tile::ID id;
+    std::shared_ptr<const std::string> data;
+};
+
+struct Result {
+    std::vector<timestamp> symbolTimes;
+    Profile profile;
+    uint64_t allocations = 0;
+};
+
+// Tiles are named after their ID, either as z/x/y.pbf or as z-x-y.pbf.
+Tile::ID parseTileID(const std::string &path) {
+    const size_t dot = path.rfind('.');
+    const std::string stem = path.substr(0, dot == std::string::npos ? path.size() : dot);
+
+    std::vector<int32_t> numbers;
+    size_t end = stem.size();
+    while (numbers.size() < 3 && end > 0) {
+        size_t start = stem.find_last_of("/-", end - 1);
+        start = start == std::string::npos ? 0 : start + 1;
+        const std::string part = stem.substr(start, end - start);
+        if (part.empty() || part.find_first_not_of("0123456789") != std::string::npos) {
+            break;
+        }
+        numbers.push_back(std::atoi(part.c_str()));
+        end = start ? start - 1 : 0;
+    }
+
+    if (numbers.size() < 3) {
+        throw std::runtime_error("Tile file names need to end in z/x/y.pbf or z-x-y.pbf: " + path);
+    }
+    return Tile::ID(numbers[2], numbers[1], numbers[0]);
+}
+
+std::string directory(const std::string &path) {
+    const size_t slash = path.rfind('/');
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+// Tiles are parsed for the first vector source of the style.
+const SourceInfo *findVectorSource(const util::ptr<StyleLayerGroup> &group) {
+    if (!group) {
+        return nullptr;
+    }
+    for (const util::ptr<StyleLayer> &layer : group->layers) {
+        if (layer->bucket && layer->bucket->style_source &&
+            layer->bucket->style_source->info.type == SourceType::Vector) {
+            return &layer->bucket->style_source->info;
+        }
+    }
+    return nullptr;
+}
+
+// The symbol buckets of the source, in the order in which the tile parser places them.
+std::vector<util::ptr<StyleBucket>> findSymbolBuckets(const util::ptr<StyleLayerGroup> &group,
+                                                      const SourceInfo &source) {
+    std::vector<util::ptr<StyleBucket>> buckets;
+    std::set<std::string> names;
+    for (const util::ptr<StyleLayer> &layer : group->layers) {
+        const util::ptr<StyleBucket> &bucket = layer->bucket;
+        if (bucket && bucket->style_source && &bucket->style_source->info == &source &&
+            bucket->render.is<StyleBucketSymbol>() && names.insert(bucket->name).second) {
+            buckets.push_back(bucket);
+        }
+    }
+    return buckets;
+}
+
+// Adds the glyph ranges of the font stack that lie in /directory/ as <font stack>/<range>.pbf,
+// the way glyph URLs are laid out. Returns how many there were.
+unsigned int loadGlyphs(GlyphStore &glyphStore, const std::string &directory,
+                        const std::string &fontStack) {
+    unsigned int loaded = 0;
+    for (uint32_t start = 0; start < 65536; start += 256) {
+        const GlyphRange range(start, start + 255);
+        const std::string path = directory + "/" + fontStack + "/" + std::to_string(range.first) +
+                                 "-" + std::to_string(range.second) + ".pbf";
+        try {
+            glyphStore.addGlyphRange(fontStack, range, std::make_shared<const std::string>(util::read_file(path)));
+            loaded++;
+        } catch (std::exception &) {
+            // The range isn't there; labels are shaped without its glyphs.
+        }
+    }
+    return loaded;
+}
+
+// Runs the loop until /done/ returns true or a few seconds passed. Returns whether it is done.
+bool runUntil(uv_loop_t *loop, std::function<bool()> done) {
+    const timestamp deadline = util::now() + 30_seconds;
+    while (!done()) {
+        if (util::now() > deadline) {
+            return false;
+        }
+        uv_run(loop, UV_RUN_NOWAIT);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+double milliseconds(timestamp duration) {
+    return duration / 1e6;
+}
+
+void add(Profile &profile, const Profile &rhs) {
+    const auto stage = [](Profile::Stage &lhs, const Profile::Stage &other) {
+        lhs.time += other.time;
+        lhs.allocations += other.allocations;
+    };
+    stage(profile.features, rhs.features);
+    stage(profile.shaping, rhs.shaping);
+    stage(profile.anchors, rhs.anchors);
+    stage(profile.quads, rhs.quads);
+    stage(profile.buffers, rhs.buffers);
+    stage(profile.placement, rhs.placement);
+}
+
+void writeStages(Writer &writer, const Profile &profile,
+                 std::function<void(const Profile::Stage &)> writeStage) {
+    writer.StartObject();
+    const std::pair<const char *, const Profile::Stage *> stages[] = {
+        { "features", &profile.features },
+        { "shaping", &profile.shaping },
+        { "anchors", &profile.anchors },
+        { "quads", &profile.quads },
+        { "buffers", &profile.buffers },
+        { "placement", &profile.placement },
+    };
+    for (const auto &stage : stages) {
+        writer.String(stage.first);
+        writeStage(*stage.second);
+    }
+    writer.EndObject();
+}
+
+void writeStageTimes(Writer &writer, const Profile &profile, double tiles) {
+    writeStages(writer, profile, [&](const Profile::Stage &stage) {
+        writer.Double(milliseconds(stage.time) / tiles);
+    });
+}
+
+void writeStageAllocations(Writer &writer, const Profile &profile, double tiles) {
+    writeStages(writer, profile, [&](const Profile::Stage &stage) {
+        writer.StartObject();
+        writer.String("count");
+        writer.Double(stage.allocations.count / tiles);
+        writer.String("bytes");
+        writer.Double(stage.allocations.bytes / tiles);
+        writer.EndObject();
+    });
+}
+
+uint64_t allocationCount() {
+#if defined(MBGL_TRACK_ALLOCATIONS)
+    return AllocationTracker::total().sum().count;
+#else
+    return allocations;
+#endif
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::string style_path;
+    std::vector<std::string> tile_paths;
+    std::string glyphs;
+    std::string cache = "cache.sqlite";
+    std::string output;
+    std::string token;
+    unsigned int iterations = 20;
+    float pixelRatio = 1;
+    bool network = false;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("style,s", po::value(&style_path)->required()->value_name("json"), "Map stylesheet")
+        ("tiles", po::value(&tile_paths)->required()->value_name("pbf"), "Vector tiles, named z/x/y.pbf or z-x-y.pbf")
+        ("glyphs,g", po::value(&glyphs)->value_name("directory"), "Glyph PBFs, as <font stack>/<range>.pbf")
+        ("cache,d", po::value(&cache)->value_name("file")->default_value(cache), "Cache database file name for sprites and other glyphs")
+        ("output,o", po::value(&output)->value_name("file"), "Results file name (default: stdout)")
+        ("token,t", po::value(&token)->value_name("key")->default_value(token), "Mapbox access token")
+        ("iterations,i", po::value(&iterations)->value_name("number")->default_value(iterations), "Runs over every tile")
+        ("ratio,r", po::value(&pixelRatio)->value_name("number")->default_value(pixelRatio), "Image scale factor of the sprite")
+        ("network,n", po::bool_switch(&network), "Fetch sprites and glyphs that aren't in the cache")
+    ;
+
+    po::positional_options_description positional;
+    positional.add("tiles", -1);
+
+    try {
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
+        po::notify(vm);
+    } catch(std::exception& e) {
+        std::cout << "Error: " << e.what() << std::endl << desc;
+        exit(1);
+    }
+
+#if __APPLE__
+    Log::Set<NSLogBackend>();
+#else
+    Log::Set<StderrLogBackend>();
+#endif
+
+    std::vector<Fixture> fixtures;
+    try {
+        for (const std::string &path : tile_paths) {
+            fixtures.push_back({ path, parseTileID(path), std::make_shared<const std::string>(util::read_file(path)) });
+        }
+    } catch (std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        exit(1);
+    }
+
+    // The sprite, and glyphs that weren't given, are loaded through the file source.
+    uv::loop loop;
+    CachingHTTPFileSource fileSource(cache);
+    fileSource.setLoop(*loop);
+    fileSource.setNetworkEnabled(network);
+    fileSource.setBase(directory(style_path));
+
+    if (!token.size()) {
+        const char *token_ptr = getenv("MAPBOX_ACCESS_TOKEN");
+        if (token_ptr) {
+            token = token_ptr;
+        }
+    }
+    if (token.size()) {
+        fileSource.setAccessToken(std::string(token));
+    }
+
+    const std::string styleJSON = util::read_file(style_path);
+    util::ptr<Style> style = std::make_shared<Style>();
+    style->loadJSON((const uint8_t *)styleJSON.c_str());
+    style->cascadeClasses({});
+
+    const SourceInfo *source = findVectorSource(style->layers);
+    if (!source) {
+        std::cerr << "Error: The style doesn't use a vector source" << std::endl;
+        exit(1);
+    }
+    const std::vector<util::ptr<StyleBucket>> buckets = findSymbolBuckets(style->layers, *source);
+    if (buckets.empty()) {
+        std::cerr << "Error: The style doesn't have symbol layers" << std::endl;
+        exit(1);
+    }
+
+    GlyphAtlas glyphAtlas(1024, 1024);
+    GlyphStore glyphStore(fileSource);
+    glyphStore.setURL(style->glyph_url);
+    SpriteAtlas spriteAtlas(512, 512);
+
+    if (!glyphs.empty()) {
+        std::set<std::string> fontStacks;
+        for (const util::ptr<StyleBucket> &bucket : buckets) {
+            fontStacks.insert(bucket->render.get<StyleBucketSymbol>().text.font);
+        }
+        for (const std::string &fontStack : fontStacks) {
+            if (!loadGlyphs(glyphStore, glyphs, fontStack)) {
+                std::cerr << "Warning: There are no glyphs for " << fontStack << " in " << glyphs << std::endl;
+            }
+        }
+    }
+
+    uv::worker worker(*loop, 1);
+    util::ptr<Sprite> sprite = Sprite::Create(style->getSpriteURL(), pixelRatio, fileSource, worker);
+    if (!runUntil(*loop, [&] { return sprite->isLoaded(); })) {
+        std::cerr << "Error: Failed to load the sprite" << std::endl;
+        exit(1);
+    }
+    spriteAtlas.setSprite(sprite);
+
+    // Builds the symbol buckets of the tile the way the tile parser does, without the other
+    // buckets. Returns false if glyphs are missing.
+    const auto build = [&](const Fixture &fixture, Result *result) {
+        VectorTile tile(fixture.data);
+        std::vector<std::shared_ptr<const VectorTileLayer>> layers;
+        for (const util::ptr<StyleBucket> &bucket : buckets) {
+            // Decodes the layer, which isn't part of the measurement.
+            layers.push_back(tile.getLayer(bucket->source_layer));
+        }
+
+        TileBuffers tileBuffers;
+        Collision collision(fixture.id.z, 4096, source->tile_size);
+        std::vector<std::unique_ptr<SymbolBucket>> symbolBuckets;
+        Profile profile;
+        bool complete = true;
+
+        const uint64_t allocated = allocationCount();
+        const timestamp start = util::now();
+        for (size_t i = 0; i < buckets.size(); i++) {
+            if (layers[i]) {
+                symbolBuckets.push_back(util::make_unique<SymbolBucket>(buckets[i]->render.get<StyleBucketSymbol>(), collision, tileBuffers));
+                symbolBuckets.back()->setProfile(&profile);
+                complete &= symbolBuckets.back()->prepareFeatures(*layers[i], buckets[i]->compiled_filter, glyphStore);
+            }
+        }
+        if (complete) {
+            for (const std::unique_ptr<SymbolBucket> &bucket : symbolBuckets) {
+                bucket->addFeatures(fixture.id, spriteAtlas, *sprite, glyphAtlas, glyphStore);
+            }
+        }
+        if (result) {
+            result->symbolTimes.push_back(util::now() - start);
+            result->allocations += allocationCount() - allocated;
+            add(result->profile, profile);
+        }
+        return complete;
+    };
+
+    // The first run over every tile loads the glyphs it needs, and isn't measured. The later runs
+    // shape labels that the glyph store has cached already, as in a map that showed the tile before.
+    for (const Fixture &fixture : fixtures) {
+        while (!build(fixture, nullptr)) {
+            const uint64_t generation = glyphStore.getGeneration();
+            if (!runUntil(*loop, [&] { return glyphStore.getGeneration() != generation; })) {
+                std::cerr << "Warning: Glyphs for " << fixture.path << " didn't load; its labels are left out" << std::endl;
+                break;
+            }
+        }
+    }
+
+    std::vector<Result> results(fixtures.size());
+    for (unsigned int i = 0; i < iterations; i++) {
+        for (size_t j = 0; j < fixtures.size(); j++) {
+            build(fixtures[j], &results[j]);
+        }
+    }
+
+    rapidjson::StringBuffer buffer;
+    Writer writer(buffer);
+    writer.StartObject();
+
+    timestamp total = 0;
+    uint64_t totalAllocations = 0;
+    Profile totalProfile;
+    const double runs = std::max(1u, iterations);
+
+    writer.String("tiles");
+    writer.StartArray();
+    for (size_t j = 0; j < fixtures.size(); j++) {
+        Result &result = results[j];
+        std::sort(result.symbolTimes.begin(), result.symbolTimes.end());
+        for (timestamp time : result.symbolTimes) {
+            total += time;
+        }
+        totalAllocations += result.allocations;
+        add(totalProfile, result.profile);
+
+        writer.StartObject();
+        writer.String("path");
+        writer.String(fixtures[j].path.c_str());
+        writer.String("symbolMs");
+        writer.StartObject();
+        if (!result.symbolTimes.empty()) {
+            writer.String("p50");
+            writer.Double(milliseconds(result.symbolTimes[(result.symbolTimes.size() - 1) / 2]));
+            writer.String("min");
+            writer.Double(milliseconds(result.symbolTimes.front()));
+        }
+        writer.EndObject();
+        writer.String("stageMs");
+        writeStageTimes(writer, result.profile, runs);
+        writer.String("allocations");
+        writer.Double(result.allocations / runs);
+        if (AllocationTracker::isEnabled()) {
+            writer.String("stageAllocations");
+            writeStageAllocations(writer, result.profile, runs);
+        }
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    // Averages over all runs over all tiles.
+    const double tiles = std::max<double>(1, runs * fixtures.size());
+    writer.String("symbolMsPerTile");
+    writer.Double(milliseconds(total) / tiles);
+    writer.String("stageMsPerTile");
+    writeStageTimes(writer, totalProfile, tiles);
+    writer.String("allocationsPerTile");
+    writer.Double(totalAllocations / tiles);
+    if (AllocationTracker::isEnabled()) {
+        writer.String("stageAllocationsPerTile");
+        writeStageAllocations(writer, totalProfile, tiles);
+    }
+
+    writer.EndObject();
+
+    if (output.empty()) {
+        std::cout << buffer.GetString() << std::endl;
+    } else {
+        util::write_file(output, buffer.GetString());
+    }
+}
@@ -6,21 +6,33 @@
 #include <mbgl/util/time.hpp>
 #include <mbgl/util/uv.hpp>
 #include <mbgl/util/ptr.hpp>
+#include <mbgl/util/memory_usage.hpp>
+#include <mbgl/util/frame_profiler.hpp>
+#include <mbgl/util/allocation_tracker.hpp>
+#include <mbgl/util/startup_profiler.hpp>
+#include <mbgl/util/latency_histogram.hpp>
 
+#include <cmath>
 #include <cstdint>
 #include <atomic>
 #include <thread>
 #include <iosfwd>
+#include <deque>
+#include <map>
 #include <set>
+#include <string>
 #include <vector>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 
 namespace mbgl {
 
 class Painter;
 class GlyphStore;
+class GlyphRasterizer;
+class BucketCache;
 class LayerDescription;
 class Sprite;
 class Style;
@@ -33,6 +45,54 @@ class View;
 class GlyphAtlas;
 class SpriteAtlas;
 class LineAtlas;
+class TileTrace;
+
+// A feature that a layer draws at a point of the map.
+struct RenderedFeature {
+    std::string layer;
+    std::string sourceLayer;
+
+    // 0 if the feature doesn't have an id.
+    uint64_t id = 0;
+
+    // The values are converted to strings.
+    std::map<std::string, std::string> properties;
+};
+
+// The state of the tile worker threads.
+struct WorkerStatistics {
+    // Threads that are running, at most the worker count, and the most that ran at once.
+    unsigned int threads = 0;
+    unsigned int peakThreads = 0;
+    // Tile jobs that wait for a thread.
+    size_t queued = 0;
+    // Tile jobs that were done, and the nanoseconds that threads spent on them.
+    uint64_t completed = 0;
+    uint64_t busyTime = 0;
+};
+
+// The GL calls that drew the last frame.
+struct FrameStatistics {
+    size_t drawCalls = 0;
+    // Changes of the GL state that reached the driver, and those that were dropped because the
+    // value was already set.
+    size_t stateChanges = 0;
+    size_t redundantStateChanges = 0;
+};
+
+// What Map::renderSnapshot() draws. Unset values are taken from the map's view.
+struct SnapshotOptions {
+    // Pixels of the image are width * pixelRatio by height * pixelRatio.
+    uint16_t width = 0;
+    uint16_t height = 0;
+    float pixelRatio = 0;
+
+    double lat = NAN;
+    double lon = NAN;
+    double zoom = NAN;
+    // In degrees, clockwise from north.
+    double bearing = NAN;
+};
 
 class Map : private util::noncopyable {
 public:
@@ -57,14 +117,35 @@ public:
     // Runs the map event loop. ONLY run this function when you want to get render a single frame
     // with this map object. It will *not* spawn a separate thread and instead block until the
     // frame is completely rendered.
+    //
+    // The frame is rendered as soon as the map is complete (see onComplete()), or once nothing
+    // is loading anymore, e.g. because a tile failed to load; requests that are still running
+    // then are canceled.
     void run();
 
+    // Calls the callback on the map thread right after the first frame that shows everything
+    // the view needs: the style, the sprite, and all tiles that the view requires, parsed with
+    // the glyphs of their labels. Tiles that failed to load count as complete. A static map
+    // calls it after its only frame, complete or not.
+    typedef std::function<void ()> CompleteCallback;
+    void onComplete(CompleteCallback callback);
+
     // Triggers a lazy rerender: only performs a render when the map is not clean.
     void rerender();
 
     // Forces a map update: always triggers a rerender.
     void update();
 
+    // Caps the number of frames per second that the render thread renders. 0, the default, renders
+    // as often as the view swaps buffers.
+    void setMaximumFrameRate(unsigned int fps);
+    unsigned int getMaximumFrameRate() const;
+
+    // Draws frames at a lower resolution while the map moves and frames take longer than the
+    // display's refresh interval, and at full resolution again once the map settles. Off by default.
+    void setAdaptiveResolution(bool value);
+    bool getAdaptiveResolution() const;
+
     // Releases resources immediately
     void terminate();
 
@@ -87,8 +168,29 @@ public:
     uint64_t getDefaultTransitionDuration();
     void setStyleURL(const std::string &url);
     void setStyleJSON(std::string newStyleJSON, const std::string &base = "");
+    // Loads a style that was precompiled with mbgl-compile-style, which skips parsing JSON.
+    void setStyleBinary(const std::string &path, const std::string &base = "");
     std::string getStyleJSON() const;
 
+    // Change a layer of the loaded style without reloading it. Values are JSON, like in the style.
+    // Paint properties go into the default class if /klass/ is empty, and are only evaluated
+    // again. Layout properties rebuild the layer's buckets in all tiles. Return false if the
+    // layer or the property doesn't exist.
+    bool setPaintProperty(const std::string &layer, const std::string &name,
+                          const std::string &value, const std::string &klass = "");
+    bool setLayoutProperty(const std::string &layer, const std::string &name,
+                           const std::string &value);
+    bool setLayerVisible(const std::string &layer, bool visible);
+
+    // Replaces the data of a GeoJSON source of the style with a FeatureCollection, a Feature or
+    // a geometry. The data is cut into tiles on a worker thread. Data of a source that no visible
+    // layer uses waits until one does.
+    void setGeoJSONSourceData(const std::string &source, const std::string &json);
+    // Changes single features of a GeoJSON source: a feature replaces the feature with the same
+    // id, or removes it if its geometry is null, and features without an id are added. Only the
+    // tiles that the changed features touch are cut and parsed again.
+    void updateGeoJSONSourceFeatures(const std::string &source, const std::string &json);
+
     // Transition
     void cancelTransitions();
 
@@ -123,13 +225,113 @@ public:
     void startRotating();
     void stopRotating();
 
+    // Threading
+    // Sets the maximum number of tile worker threads. 0 uses one thread per hardware thread.
+    // Threads are started when tile jobs queue up and exit when they had nothing to do for a
+    // while. Only has an effect before the map starts loading tiles.
+    void setWorkerCount(unsigned int count);
+
+    // The tile worker threads as of the last frame. May be called from any thread.
+    WorkerStatistics getWorkerStatistics() const;
+
+    // Memory
+    // Sets how many bytes parsed tiles that went out of view may take up, so that they can be
+    // shown again without reloading them. The budget is split evenly between the sources.
+    void setTileCacheSize(size_t bytes);
+    size_t getTileCacheSize() const;
+    // Keeps decoded glyph ranges in an existing directory, so that later runs don't have to
+    // download and decode them again. Only affects glyph ranges that weren't loaded yet.
+    void setGlyphCacheDirectory(const std::string &directory);
+    // Keeps the fill and line geometry of parsed tiles in an existing directory, so that later
+    // runs don't have to parse the tiles again. Only affects tiles that weren't loaded yet.
+    void setBucketCacheDirectory(const std::string &directory);
+    // Keeps the geometry of parsed tiles in memory after it was uploaded, so that the tiles can be
+    // uploaded again instead of reparsed when the GL context was lost, e.g. while the application
+    // was in the background. Costs about as much memory as the tiles take on the GPU. Only
+    // affects tiles that weren't loaded yet.
+    void setTileBufferRetention(bool retain);
+    bool getTileBufferRetention() const;
+    // Antialiases the edges of fills with a fringe of triangles around their outlines that the
+    // fill shader fades out, instead of drawing the outlines as lines in a separate pass.
+    // Translucent fills then take a single draw call. Costs a vertex and two triangles per vertex
+    // of the outlines. Only affects tiles that weren't loaded yet.
+    void setFillFringes(bool enabled);
+    bool getFillFringes() const;
+    // Draws the glyphs of ranges that lie within the code point ranges with fonts of the device,
+    // instead of downloading them. Only affects glyph ranges that weren't loaded yet.
+    void setLocalGlyphRasterizer(std::unique_ptr<GlyphRasterizer> rasterizer,
+                                 const std::vector<std::pair<char32_t, char32_t>> &codePoints);
+    // Frees memory when the system asks the application to, once the next frame is prepared.
+    // Moderate pressure drops the tiles that aren't needed for the current view, the decoded
+    // layers that tiles keep for reparsing, the buffer arrays kept for reuse and the caches of
+    // the file source. Critical pressure additionally deletes the textures that are kept for
+    // reuse. The callback, if any, is called on the map thread with the bytes freed, keyed by
+    // "tiles", "decodedLayers", "buffers", "fileSource", "textures" and "tileTextures". May be
+    // called from any thread.
+    enum class MemoryPressure : uint8_t { Moderate, Critical };
+    typedef std::function<void (const std::map<std::string, MemoryUsage> &)> LowMemoryCallback;
+    void onLowMemory(MemoryPressure pressure = MemoryPressure::Critical,
+                     LowMemoryCallback callback = nullptr);
+    // Reports how many bytes the tiles of every source and the atlases take up, in memory and on
+    // the GPU. The callback is called on the map thread when the next frame is prepared.
+    typedef std::function<void (const MapMemoryUsage &)> MemoryUsageCallback;
+    void getMemoryUsage(MemoryUsageCallback callback);
+
+    // Queries
+    // Finds the features that the visible layers draw within /radius/ pixels of a point of the
+    // view, in pixels from the top left. The features come from an index that the tiles build
+    // while they are parsed, so the query doesn't decode whole tiles. The callback is called on the
+    // map thread when the next frame is prepared, with the features of the topmost layer first.
+    typedef std::function<void (const std::vector<RenderedFeature> &)> QueryCallback;
+    void queryRenderedFeatures(double x, double y, double radius, QueryCallback callback);
+
+    // Snapshots
+    // Draws the map into an offscreen image, e.g. for a thumbnail or for sharing, without touching
+    // what the view shows. The snapshot uses the style, glyphs and sprite of the map, and the tiles
+    // it already loaded; tiles that the snapshot needs beyond those are loaded first. The callback
+    // is called on the map thread with the pixels, RGBA with premultiplied alpha and the top row
+    // first, and their width and height; the pixels are nullptr if the image couldn't be drawn.
+    typedef std::function<void (std::unique_ptr<uint32_t[]>, uint16_t, uint16_t)> SnapshotCallback;
+    void renderSnapshot(const SnapshotOptions &options, SnapshotCallback callback);
+
     // Debug
     void setDebug(bool value);
     void toggleDebug();
     bool getDebug() const;
 
+    // Measures how long the GPU takes to draw each layer, if the driver has timer queries. The
+    // times are shown on the map in debug mode.
+    void setGPUTiming(bool value);
+    bool getGPUTiming() const;
+    // Milliseconds per frame for each layer and for the clipping and debug passes, averaged over
+    // the last frames and sorted by cost. May be called from any thread.
+    std::vector<std::pair<std::string, double>> getGPUTimes() const;
+    // Fragments written per pixel in the opaque and in the translucent pass, averaged over the last
+    // frames that were timed. Needs occlusion queries. May be called from any thread.
+    std::pair<double, double> getOverdraw() const;
+
+    // The draw calls and GL state changes of the last frame. May be called from any thread.
+    FrameStatistics getFrameStatistics() const;
+
+    // How long the phases of recent frames took on the CPU. It may be read from any thread.
+    inline const FrameProfiler &getFrameProfiler() const { return profiler; }
+
+    // When the stages of the startup were reached, up to the first frame with tiles. May be read
+    // from any thread.
+    inline const StartupProfiler &getStartupProfiler() const { return startup; }
+
+    // How long the tiles of each source took to load, split up by phase, since the map was
+    // created. May be called from any thread.
+    TileLatencies getTileLatencies() const;
+
     inline const TransformState &getState() const { return state; }
+    // Where the map is heading to; sources prefetch the tiles for this state.
+    inline const TransformState &getPredictedState() const { return predictedState; }
+    // The view of the next snapshot; sources load its tiles. Has no size without a snapshot.
+    inline const TransformState &getSnapshotState() const { return snapshotState; }
     inline timestamp getTime() const { return animationTime; }
+    inline const util::ptr<TileTrace> &getTileTrace() const { return tileTrace; }
+    util::ptr<BucketCache> getBucketCache() const;
 
 private:
     util::ptr<Sprite> getSprite();
@@ -140,10 +342,19 @@ private:
 
     // Setup
     void setup();
+    // Applies the classes and resources of a style that was just loaded.
+    void styleLoaded(const std::string &base);
 
     void updateTiles();
+    void releaseMemory(MemoryPressure pressure, const std::vector<LowMemoryCallback> &callbacks);
     void updateSources();
     void updateSources(const util::ptr<StyleLayerGroup> &group);
+    // Hands the GeoJSON that the app set since the last frame to the sources.
+    void updateGeoJSONSources();
+
+    // Starts loading the glyphs that labels in the style need for Latin text, before any tile
+    // asks for them.
+    void prefetchGlyphs(const util::ptr<StyleLayerGroup> &group);
 
     // Prepares a map render by updating the tiles we need for the current view, as well as updating
     // the stylesheet.
@@ -152,6 +363,19 @@ private:
     // Unconditionally performs a render with the current map state.
     void render();
 
+    // Whether the next frame would show everything that the view needs; see onComplete().
+    bool isComplete() const;
+
+    // Draws the next snapshot if all of its tiles are there.
+    void renderSnapshot();
+    bool isSnapshotComplete() const;
+
+    // Picks the resolution of the next frame from how long the last frames took.
+    void updateResolution();
+
+    MapMemoryUsage memoryUsage() const;
+    std::vector<RenderedFeature> queryRenderedFeatures(double x, double y, double radius) const;
+
     enum class Mode : uint8_t {
         None, // we're not doing any processing
         Continuous, // continually updating map
@@ -162,9 +386,21 @@ private:
 
     std::unique_ptr<uv::loop> loop;
     std::unique_ptr<uv::worker> workers;
+    unsigned int workerCount = 0;
+    mutable std::mutex mutexWorkerStatistics;
+    WorkerStatistics workerStatistics;
+    mutable std::mutex mutexFrameStatistics;
+    FrameStatistics frameStatistics;
     std::thread thread;
     std::unique_ptr<uv::async> asyncTerminate;
     std::unique_ptr<uv::async> asyncRender;
+    // Triggers the next frame when it is due later, e.g. for a delayed transition or because of
+    // the frame rate cap.
+    std::unique_ptr<uv::timer> frameTimer;
+    // Defers updates in static mode until the loop has processed all pending events, so that
+    // tiles finishing in the same loop iteration are prepared once. It only keeps the loop alive
+    // while an update is pending.
+    std::unique_ptr<uv::async> asyncPrepare;
 
     bool terminating = false;
     bool pausing = false;
@@ -198,6 +434,8 @@ private:
 
     Transform transform;
     TransformState state;
+    TransformState predictedState;
+    TransformState snapshotState;
 
     FileSource& fileSource;
 
@@ -209,17 +447,77 @@ private:
     const std::unique_ptr<LineAtlas> lineAtlas;
     util::ptr<TexturePool> texturePool;
 
+    FrameProfiler profiler;
+    StartupProfiler startup;
+    // The allocations of all threads at the end of the last frame, and during that frame.
+    AllocationTracker::Counts frameEndAllocations;
+    AllocationTracker::Counts frameAllocations;
+    const util::ptr<TileTrace> tileTrace;
     const std::unique_ptr<Painter> painter;
 
     std::string styleURL;
+    // Set when the style URL changed while the map is running; the next frame loads it.
+    bool styleURLChanged = false;
+    mutable std::mutex mutexStyleURL;
     std::string styleJSON = "";
+    // Set when a new style was loaded whose glyphs weren't prefetched yet.
+    bool glyphsPending = false;
     std::vector<std::string> classes;
 
+    struct GeoJSONUpdate {
+        std::string source;
+        std::string json;
+        bool replace;
+    };
+    std::mutex mutexGeoJSON;
+    std::vector<GeoJSONUpdate> geojsonUpdates;
+
     std::atomic_uint_fast64_t defaultTransitionDuration;
 
+    std::atomic<size_t> tileCacheSize;
+    mutable std::mutex mutexBucketCache;
+    util::ptr<BucketCache> bucketCache;
+    std::atomic<bool> tileBufferRetention { false };
+    std::atomic<bool> fillFringes { false };
+    std::mutex mutexMemoryUsage;
+    std::vector<MemoryUsageCallback> memoryUsageCallbacks;
+
+    struct Query {
+        double x, y, radius;
+        QueryCallback callback;
+    };
+    std::mutex mutexQuery;
+    std::vector<Query> queries;
+    std::mutex mutexComplete;
+    std::vector<CompleteCallback> completeCallbacks;
+    struct Snapshot {
+        SnapshotOptions options;
+        SnapshotCallback callback;
+    };
+    // Drawn one after another, in the order they were requested.
+    std::mutex mutexSnapshot;
+    std::deque<Snapshot> snapshots;
+    // The highest memory pressure reported since the last frame, if any.
+    bool lowMemory = false;
+    MemoryPressure memoryPressure = MemoryPressure::Moderate;
+    std::vector<LowMemoryCallback> lowMemoryCallbacks;
+
     bool debug = false;
+    bool gpuTiming = false;
     timestamp animationTime = 0;
 
+    std::atomic_uint maximumFrameRate { 0 };
+    std::atomic<bool> adaptiveResolution { false };
+    // The resolution of frames while the map moves, the time between the last moving frames,
+    // smoothed, and when the last one was drawn.
+    float movingResolution = 1;
+    timestamp frameInterval = 0;
+    timestamp lastMovingFrame = 0;
+    // How long frames have been fast enough to try a higher resolution.
+    timestamp fastFrames = 0;
+    // When the render thread last rendered a frame.
+    timestamp frameTime = 0;
+
     std::set<util::ptr<StyleSource>> activeSources;
 };
 
@@ -10,6 +10,7 @@
 #include <cmath>
 #include <cstdint>
 #include <forward_list>
+#include <functional>
 #include <iosfwd>
 #include <string>
 
@@ -59,6 +60,14 @@ public:
             return y < rhs.y;
         }
 
+        // For unordered containers. The wrap w follows from x and z.
+        struct Hash {
+            inline size_t operator()(const ID& id) const {
+                return std::hash<uint64_t>()((uint64_t(uint32_t(id.x)) << 32) ^
+                                             (uint64_t(uint32_t(id.y)) << 5) ^ uint8_t(id.z));
+            }
+        };
+
         ID parent(int8_t z) const;
         ID normalized() const;
         std::forward_list<ID> children(int32_t z) const;
@@ -74,6 +83,8 @@ public:
 public:
     const Tile::ID id;
     ClipID clip;
+    // Whether other tiles cover this tile entirely in the current frame.
+    bool occluded = false;
     mat4 matrix;
     util::ptr<TileData> data;
 };
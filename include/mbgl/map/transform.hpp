@@ -4,6 +4,7 @@
 #include <mbgl/util/time.hpp>
 #include <mbgl/map/transform_state.hpp>
 #include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/seqlock.hpp>
 
 #include <cstdint>
 #include <cmath>
@@ -57,11 +58,20 @@ public:
     void updateTransitions(timestamp now);
     void cancelTransitions();
 
-    // Transform state
+    // Transform state. These and the getters above don't lock, so they never wait for a gesture
+    // or the map thread.
     const TransformState currentState() const;
     const TransformState finalState() const;
 
+    // Where the map is going to be: the end of running transitions, or, while panning, where the
+    // map will be after the given time if it keeps moving at the same speed.
+    const TransformState predictedState(timestamp ahead) const;
+
 private:
+    // Locks the transform for a change, and publishes the changed states when it goes out of
+    // scope.
+    class Change;
+
     // Functions prefixed with underscores will *not* perform any locks. It is the caller's
     // responsibility to lock this object.
     void _moveBy(double dx, double dy, timestamp duration = 0);
@@ -87,6 +97,10 @@ private:
     // This reflects the final position of the transform, after all possible transition took place.
     TransformState final;
 
+    // Copies of current and final for the getters, updated after every change.
+    util::SeqLock<TransformState> publishedCurrent;
+    util::SeqLock<TransformState> publishedFinal;
+
     // Limit the amount of zooming possible on the map.
     const double min_scale = std::pow(2, 0);
     const double max_scale = std::pow(2, 18);
@@ -98,6 +112,10 @@ private:
     util::ptr<util::transition> scale_timeout;
     util::ptr<util::transition> rotate_timeout;
     util::ptr<util::transition> pan_timeout;
+
+    // Velocity of the last pan gesture, in pixels per nanosecond.
+    timestamp pan_time = 0;
+    double pan_velocity_x = 0, pan_velocity_y = 0;
 };
 
 }
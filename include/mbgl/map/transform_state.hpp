@@ -17,7 +17,13 @@ class TransformState {
 public:
     // Matrix
     void matrixFor(mat4& matrix, const Tile::ID& id) const;
+    // Like matrixFor() followed by multiplying projMatrix with the result, but computed directly
+    // from the columns of projMatrix, since the tile matrix only rotates, translates and scales.
+    void matrixFor(mat4& matrix, const Tile::ID& id, const mat4& projMatrix) const;
     box cornersToBox(uint32_t z) const;
+    // The fractional tile coordinates at zoom level /z/ of a point of the view, in pixels from the
+    // top left.
+    std::array<double, 2> pointCoordinate(double px, double py, uint32_t z) const;
 
     // Dimensions
     bool hasSize() const;
@@ -28,6 +34,15 @@ public:
     const std::array<uint16_t, 2> getFramebufferDimensions() const;
     float getPixelRatio() const;
 
+    // The same camera with a viewport of the given logical size, e.g. to draw into a texture. A
+    // pixel ratio of 0 keeps the current one.
+    TransformState resized(uint16_t width, uint16_t height, float pixelRatio = 0) const;
+    // The same viewport, looking at another place. The angle is in radians, like getAngle().
+    TransformState moved(double lon, double lat, double zoom, double angle) const;
+    // The same view at a fraction of the framebuffer's resolution, as if the screen had a lower
+    // pixel ratio.
+    TransformState scaled(float resolution) const;
+
     float worldSize() const;
     float lngX(float lon) const;
     float latY(float lat) const;
@@ -0,0 +1,32 @@
+#ifndef MBGL_PLATFORM_ANDROID_TRACE_ANDROID
+#define MBGL_PLATFORM_ANDROID_TRACE_ANDROID
+
+#include <mbgl/platform/trace.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+namespace mbgl {
+
+// Sends the scopes to systrace and Perfetto with ATrace. The functions are looked up at runtime,
+// since they only exist from API level 23 on, and asynchronous sections from API level 29 on.
+// Scopes cost next to nothing while no trace is recorded.
+class AndroidTraceBackend : public TraceBackend, private util::noncopyable {
+public:
+    AndroidTraceBackend();
+    ~AndroidTraceBackend();
+
+    void begin(const char *name);
+    void end();
+    void beginAsync(const char *name, uint64_t cookie);
+    void endAsync(const char *name, uint64_t cookie);
+
+private:
+    void *library = nullptr;
+    void (*beginSection)(const char *) = nullptr;
+    void (*endSection)() = nullptr;
+    void (*beginAsyncSection)(const char *, int32_t) = nullptr;
+    void (*endAsyncSection)(const char *, int32_t) = nullptr;
+};
+
+}
+
+#endif
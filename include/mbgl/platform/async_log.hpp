@@ -0,0 +1,91 @@
+#ifndef MBGL_PLATFORM_ASYNC_LOG
+#define MBGL_PLATFORM_ASYNC_LOG
+
+#include <mbgl/platform/log.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/time.hpp>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace mbgl {
+
+// Forwards log messages to another backend on a background thread, so that threads that log never
+// block on I/O. Messages are formatted by the logging thread and queued in a fixed size ring buffer
+// without taking a lock; they are dropped when the buffer is full.
+//
+// Each event may log /burst/ messages per second; further messages of that event are dropped and
+// reported in a summary once the next second starts. Errors are never rate limited.
+class AsyncLogBackend : public LogBackend, private util::noncopyable {
+public:
+    AsyncLogBackend(std::unique_ptr<LogBackend> backend, uint32_t burst = 20);
+
+    // Writes all queued messages before it returns.
+    ~AsyncLogBackend();
+
+    void record(EventSeverity severity, Event event, const std::string &msg);
+    void record(EventSeverity severity, Event event, const char* format, ...);
+    void record(EventSeverity severity, Event event, int64_t code);
+    void record(EventSeverity severity, Event event, int64_t code, const std::string &msg);
+
+    // Blocks until all messages queued so far went to the backend.
+    void flush();
+
+    // Messages that were rate limited or didn't fit into the buffer.
+    inline uint64_t dropped() const {
+        return droppedCount;
+    }
+
+    // Longer messages are truncated.
+    static const size_t maxLength = 256;
+    static const size_t capacity = 1024;
+
+private:
+    struct Entry {
+        // Equals the position of the entry when it's free to write, and the position + 1 once a
+        // message was written to it.
+        std::atomic<size_t> sequence;
+        EventSeverity severity;
+        Event event;
+        bool hasCode;
+        int64_t code;
+        char message[maxLength];
+    };
+
+    struct RateLimit {
+        // The second of the current window.
+        std::atomic<timestamp> window { 0 };
+        std::atomic<uint32_t> count { 0 };
+        std::atomic<uint64_t> suppressed { 0 };
+    };
+
+    bool admit(EventSeverity severity, Event event);
+    void push(EventSeverity severity, Event event, bool hasCode, int64_t code, const char *message);
+    bool pop();
+    void run();
+
+    const std::unique_ptr<LogBackend> backend;
+    const uint32_t burst;
+
+    std::unique_ptr<Entry[]> entries;
+    std::atomic<size_t> head { 0 };
+
+    // Only used by the background thread.
+    size_t tail = 0;
+    std::atomic<size_t> written { 0 };
+
+    std::array<RateLimit, 256> limits;
+    std::atomic<uint64_t> droppedCount { 0 };
+
+    std::atomic<bool> running { true };
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::thread thread;
+};
+
+}
+
+#endif
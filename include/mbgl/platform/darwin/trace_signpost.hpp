@@ -0,0 +1,23 @@
+#ifndef MBGL_PLATFORM_DARWIN_TRACE_SIGNPOST
+#define MBGL_PLATFORM_DARWIN_TRACE_SIGNPOST
+
+#include <mbgl/platform/trace.hpp>
+
+namespace mbgl {
+
+// Sends the scopes to Instruments as signpost intervals in the Points of Interest category.
+// Does nothing on systems older than macOS 10.14 and iOS 12, and next to nothing while no
+// recording is running.
+class SignpostTraceBackend : public TraceBackend {
+public:
+    inline ~SignpostTraceBackend() = default;
+
+    void begin(const char *name);
+    void end();
+    void beginAsync(const char *name, uint64_t cookie);
+    void endAsync(const char *name, uint64_t cookie);
+};
+
+}
+
+#endif
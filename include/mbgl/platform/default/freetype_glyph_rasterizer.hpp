@@ -0,0 +1,28 @@
+#ifndef MBGL_PLATFORM_DEFAULT_FREETYPE_GLYPH_RASTERIZER
+#define MBGL_PLATFORM_DEFAULT_FREETYPE_GLYPH_RASTERIZER
+
+#include <mbgl/platform/glyph_rasterizer.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace mbgl {
+
+// Draws glyphs with FreeType from a list of font files, taking each glyph from the first font
+// that has it. Font stacks are only used to pick a weight: stacks with "Bold" in their name are
+// drawn emboldened.
+class FreeTypeGlyphRasterizer : public GlyphRasterizer {
+public:
+    explicit FreeTypeGlyphRasterizer(const std::vector<std::string> &fontFiles);
+    ~FreeTypeGlyphRasterizer();
+
+    bool rasterize(const std::string &fontStack, char32_t glyph, GlyphBitmap &bitmap);
+
+private:
+    struct Impl;
+    const std::unique_ptr<Impl> impl;
+};
+
+}
+
+#endif
@@ -7,7 +7,9 @@ namespace mbgl {
 
 class HeadlessDisplay {
 public:
-    HeadlessDisplay();
+    // Opens the GPU with the index /device/, or the default one if it is negative. Only the EGL
+    // backend can choose a GPU, through EGL_EXT_platform_device.
+    explicit HeadlessDisplay(int device = -1);
     ~HeadlessDisplay();
 
 #if MBGL_USE_CGL
@@ -18,6 +20,13 @@ public:
     Display *xDisplay = nullptr;
     GLXFBConfig *fbConfigs = nullptr;
 #endif
+
+#if MBGL_USE_EGL
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    EGLConfig eglConfig = nullptr;
+    // Whether contexts can be made current without a surface (EGL_KHR_surfaceless_context).
+    bool surfaceless = false;
+#endif
 };
 
 }
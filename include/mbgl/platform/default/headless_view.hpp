@@ -3,6 +3,12 @@
 
 #ifdef __APPLE__
 #define MBGL_USE_CGL 1
+#elif MBGL_USE_EGL
+#define GL_GLEXT_PROTOTYPES
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #else
 #define GL_GLEXT_PROTOTYPES
 #include <mbgl/platform/default/glx.h>
@@ -22,14 +28,25 @@ class HeadlessView : public View {
 public:
     HeadlessView();
     HeadlessView(std::shared_ptr<HeadlessDisplay> display);
+    // Shares textures, buffers and programs with the context of /share/, which needs to be on
+    // the same display. Every view can render on its own thread.
+    HeadlessView(std::shared_ptr<HeadlessDisplay> display, const HeadlessView &share);
     ~HeadlessView();
 
-    void createContext();
+    void createContext(const HeadlessView *share = nullptr);
     void loadExtensions();
 
     void resize(uint16_t width, uint16_t height, float pixelRatio);
     std::unique_ptr<uint32_t[]> readPixels();
 
+    // Reads the pixels of frames back without waiting for the GPU, where pixel buffer objects are
+    // supported. startReadPixels() queues a read of the current frame, and finishReadPixels()
+    // copies the oldest queued read into /pixels/, which must hold a full frame. Rows are stored
+    // bottom-up; see compress_png(). At most two reads can be queued; resize() drops them.
+    void startReadPixels();
+    void finishReadPixels(uint32_t *pixels);
+    inline size_t pendingReads() const { return readCount; }
+
     void notify();
     void notifyMapChange(MapChange change, timestamp delay = 0);
     void activate();
@@ -56,9 +73,25 @@ private:
     GLXPbuffer glxPbuffer = 0;
 #endif
 
+#if MBGL_USE_EGL
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    EGLContext glContext = EGL_NO_CONTEXT;
+    // Only used where the display can't make a context current without a surface.
+    EGLSurface eglSurface = EGL_NO_SURFACE;
+#endif
+
     GLuint fbo = 0;
     GLuint fboDepthStencil = 0;
     GLuint fboColor = 0;
+
+    static const size_t maxPendingReads = 2;
+    bool pixelBufferObjects = false;
+    // Used for the reads in flight; the CPU buffers replace them where pixel buffer objects
+    // aren't supported.
+    GLuint pixelBuffers[maxPendingReads] = {};
+    std::unique_ptr<uint32_t[]> readBuffers[maxPendingReads];
+    size_t firstRead = 0;
+    size_t readCount = 0;
 };
 
 }
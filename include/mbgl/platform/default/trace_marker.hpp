@@ -0,0 +1,35 @@
+#ifndef MBGL_PLATFORM_DEFAULT_TRACE_MARKER
+#define MBGL_PLATFORM_DEFAULT_TRACE_MARKER
+
+#include <mbgl/platform/trace.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+namespace mbgl {
+
+// Writes the scopes into the ftrace marker of the kernel in the format of atrace, which Perfetto,
+// systrace and trace-cmd understand; perf records them as ftrace:print events. Does nothing when
+// the marker can't be opened, which usually takes root or access to tracefs.
+class TraceMarkerBackend : public TraceBackend, private util::noncopyable {
+public:
+    TraceMarkerBackend();
+    ~TraceMarkerBackend();
+
+    inline bool isOpen() const {
+        return fd >= 0;
+    }
+
+    void begin(const char *name);
+    void end();
+    void beginAsync(const char *name, uint64_t cookie);
+    void endAsync(const char *name, uint64_t cookie);
+
+private:
+    void write(const char *format, ...);
+
+    int fd = -1;
+    const int pid;
+};
+
+}
+
+#endif
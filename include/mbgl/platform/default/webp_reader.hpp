@@ -0,0 +1,40 @@
+#ifndef MBGL_UTIL_WEBP_READER_HPP
+#define MBGL_UTIL_WEBP_READER_HPP
+
+#include <mbgl/platform/default/image_reader.hpp>
+
+// webp
+extern "C"
+{
+#include <webp/decode.h>
+}
+
+namespace mbgl { namespace util {
+
+template <typename T>
+class WebpReader : public ImageReader
+{
+public:
+    using source_type = T;
+private:
+    // libwebp decodes from memory, so the data is used in place instead of through a stream.
+    char const* data_;
+    size_t size_;
+    unsigned width_;
+    unsigned height_;
+    bool has_alpha_;
+public:
+    WebpReader(char const* data, size_t size);
+    ~WebpReader();
+    unsigned width() const;
+    unsigned height() const;
+    inline bool hasAlpha() const { return has_alpha_; }
+    inline bool premultipliedAlpha() const { return true; }
+    void read(unsigned x,unsigned y, unsigned w, unsigned h, char *image);
+private:
+    void init();
+};
+
+}}
+
+#endif // MBGL_UTIL_WEBP_READER_HPP
@@ -1,6 +1,7 @@
 #ifndef MBGL_RENDERER_GL
 #define MBGL_RENDERER_GL
 
+#include <cstdint>
 #include <string>
 #include <stdexcept>
 
@@ -28,6 +29,19 @@
     #include <GL/glext.h>
 #endif
 
+// The legacy OS X headers only have framebuffer objects through GL_EXT_framebuffer_object.
+// GL_FRAMEBUFFER itself is defined with the GL_KHR_debug names below.
+#if !defined(GL_FRAMEBUFFER_COMPLETE) && defined(GL_FRAMEBUFFER_COMPLETE_EXT)
+    #define GL_FRAMEBUFFER_BINDING GL_FRAMEBUFFER_BINDING_EXT
+    #define GL_FRAMEBUFFER_COMPLETE GL_FRAMEBUFFER_COMPLETE_EXT
+    #define GL_COLOR_ATTACHMENT0 GL_COLOR_ATTACHMENT0_EXT
+    #define glGenFramebuffers glGenFramebuffersEXT
+    #define glBindFramebuffer glBindFramebufferEXT
+    #define glDeleteFramebuffers glDeleteFramebuffersEXT
+    #define glFramebufferTexture2D glFramebufferTexture2DEXT
+    #define glCheckFramebufferStatus glCheckFramebufferStatusEXT
+#endif
+
 namespace mbgl {
 namespace gl {
 
@@ -144,6 +158,68 @@ extern PFNGLDELETEVERTEXARRAYSPROC DeleteVertexArrays;
 extern PFNGLGENVERTEXARRAYSPROC GenVertexArrays;
 extern PFNGLISVERTEXARRAYPROC IsVertexArray;
 
+// GL_ARB_instanced_arrays / GL_EXT_instanced_arrays / GL_ANGLE_instanced_arrays
+typedef void (* PFNGLVERTEXATTRIBDIVISORPROC) (GLuint index, GLuint divisor);
+typedef void (* PFNGLDRAWARRAYSINSTANCEDPROC) (GLenum mode, GLint first, GLsizei count, GLsizei primcount);
+extern PFNGLVERTEXATTRIBDIVISORPROC VertexAttribDivisor;
+extern PFNGLDRAWARRAYSINSTANCEDPROC DrawArraysInstanced;
+
+// Instanced drawing keeps the attribute divisors in vertex array objects, so it needs both.
+bool isInstancingSupported();
+
+// GL_ARB_get_program_binary / GL_OES_get_program_binary
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+typedef void (* PFNGLGETPROGRAMBINARYPROC) (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (* PFNGLPROGRAMBINARYPROC) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (* PFNGLPROGRAMPARAMETERIPROC) (GLuint program, GLenum pname, GLint value);
+extern PFNGLGETPROGRAMBINARYPROC GetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC ProgramBinary;
+// Only in GL_ARB_get_program_binary; ES drivers always keep the binary retrievable.
+extern PFNGLPROGRAMPARAMETERIPROC ProgramParameteri;
+
+// GL_ARB_timer_query / GL_EXT_disjoint_timer_query
+#define GL_TIME_ELAPSED 0x88BF
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+typedef void (* PFNGLGENQUERIESPROC) (GLsizei n, GLuint *ids);
+typedef void (* PFNGLDELETEQUERIESPROC) (GLsizei n, const GLuint *ids);
+typedef void (* PFNGLBEGINQUERYPROC) (GLenum target, GLuint id);
+typedef void (* PFNGLENDQUERYPROC) (GLenum target);
+typedef void (* PFNGLGETQUERYOBJECTUIVPROC) (GLuint id, GLenum pname, GLuint *params);
+typedef void (* PFNGLGETQUERYOBJECTUI64VPROC) (GLuint id, GLenum pname, uint64_t *params);
+extern PFNGLGENQUERIESPROC GenQueries;
+extern PFNGLDELETEQUERIESPROC DeleteQueries;
+extern PFNGLBEGINQUERYPROC BeginQuery;
+extern PFNGLENDQUERYPROC EndQuery;
+extern PFNGLGETQUERYOBJECTUIVPROC GetQueryObjectuiv;
+extern PFNGLGETQUERYOBJECTUI64VPROC GetQueryObjectui64v;
+// Only GL_EXT_disjoint_timer_query reports when results are unusable, e.g. after a power state
+// change.
+extern bool isTimerQueryDisjointSupported;
+bool isTimerQuerySupported();
+
+// GL_ARB_pixel_buffer_object with GL_ARB_map_buffer_range / OpenGL ES 3: glReadPixels into a
+// buffer object returns right away, and mapping the buffer later only waits if the GPU isn't done.
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#define GL_STREAM_READ 0x88E1
+#define GL_MAP_READ_BIT 0x0001
+typedef void *(* PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (* PFNGLUNMAPBUFFERPROC) (GLenum target);
+extern PFNGLMAPBUFFERRANGEPROC MapBufferRange;
+extern PFNGLUNMAPBUFFERPROC UnmapBuffer;
+bool isPixelBufferObjectSupported();
+
+// GL_SAMPLES_PASSED occlusion queries, through the query functions above; desktop GL only
+#define GL_SAMPLES_PASSED 0x8914
+extern bool isSamplesQuerySupported;
+
+// GL_EXT_texture_filter_anisotropic; 0 if unavailable
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+extern float maxTextureAnisotropy;
+
 // GL_EXT_packed_depth_stencil / GL_OES_packed_depth_stencil
 extern bool isPackedDepthStencilSupported;
 #define GL_DEPTH24_STENCIL8 0x88F0
@@ -152,6 +228,35 @@ extern bool isPackedDepthStencilSupported;
 extern bool isDepth24Supported;
 #define GL_DEPTH_COMPONENT24 0x81A6
 
+// GL_OES_element_index_uint; always available on desktop GL
+extern bool isElementIndexUintSupported;
+
+// Compressed texture formats, which raster tiles may come in as KTX files. Set by
+// detectCompressedTextureSupport() from the extensions of the context.
+// GL_EXT_texture_compression_s3tc
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+extern bool isS3TCSupported;
+// GL_OES_compressed_ETC1_RGB8_texture
+#define GL_ETC1_RGB8_OES 0x8D64
+extern bool isETC1Supported;
+// OpenGL ES 3 / GL_ARB_ES3_compatibility
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9276
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+extern bool isETC2Supported;
+// GL_KHR_texture_compression_astc_ldr; all block sizes from 4x4 to 12x12
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+#define GL_COMPRESSED_RGBA_ASTC_12x12_KHR 0x93BD
+extern bool isASTCSupported;
+// Must be called with the context current.
+void detectCompressedTextureSupport(const std::string &extensions);
+// Whether textures with this compressed internal format can be uploaded. May be called on any
+// thread once the context was set up.
+bool isCompressedFormatSupported(GLenum internalFormat);
+
 // Debug group markers, useful for debugging on iOS
 #if defined(DEBUG)
 // static int indent = 0;
@@ -183,6 +288,14 @@ struct group {
     ~group() { end_group(); };
 };
 
+// Opens a debug group until the end of the scope. The label isn't evaluated in release builds, so
+// labels built per tile don't allocate strings in every frame.
+#if defined(DEBUG)
+#define MBGL_GL_GROUP(label) ::mbgl::gl::group _gl_group(label)
+#else
+#define MBGL_GL_GROUP(label) ((void)0)
+#endif
+
 }
 }
 
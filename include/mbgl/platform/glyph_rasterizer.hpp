@@ -0,0 +1,37 @@
+#ifndef MBGL_PLATFORM_GLYPH_RASTERIZER
+#define MBGL_PLATFORM_GLYPH_RASTERIZER
+
+#include <cstdint>
+#include <string>
+
+namespace mbgl {
+
+// A glyph drawn with a font of the device, at 24 pixels per em.
+struct GlyphBitmap {
+    // Coverage of each pixel, row by row from the top, with 255 for pixels inside of the glyph.
+    std::string coverage;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    // Offset of the bitmap from the pen position. Like in glyph PBFs, /top/ is measured from the
+    // ascender line of the font, and is negative below it.
+    int32_t left = 0;
+    int32_t top = 0;
+    uint32_t advance = 0;
+};
+
+// Draws glyphs with the fonts that are installed on the device. Scripts with many glyphs, like CJK,
+// need dozens of glyph ranges from the glyph URL for the labels of a single tile; ranges that are
+// drawn locally don't have to be downloaded at all.
+class GlyphRasterizer {
+public:
+    virtual ~GlyphRasterizer() = default;
+
+    // Draws a glyph for a label of the font stack. Returns false if no font has the glyph. Called
+    // on worker threads, but never from more than one thread at a time.
+    virtual bool rasterize(const std::string &fontStack, char32_t glyph, GlyphBitmap &bitmap) = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef MBGL_PLATFORM_TRACE
+#define MBGL_PLATFORM_TRACE
+
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <cstdint>
+#include <memory>
+
+namespace mbgl {
+
+// Passes the timing scopes of the engine on to the tracing tool of the platform, so that they show
+// up next to the GPU driver and the rest of the system.
+class TraceBackend {
+public:
+    virtual inline ~TraceBackend() = default;
+
+    // Scopes nest, and end on the thread that began them.
+    virtual void begin(const char *name) = 0;
+    virtual void end() = 0;
+
+    // Intervals that may end on another thread. /cookie/ tells apart intervals of the same name
+    // that overlap.
+    virtual void beginAsync(const char *name, uint64_t cookie) = 0;
+    virtual void endAsync(const char *name, uint64_t cookie) = 0;
+};
+
+class Trace {
+public:
+    // Without a backend, every trace point costs a single branch.
+    static inline bool isEnabled() {
+        return bool(Backend);
+    }
+
+    static inline void BeginAsync(const char *name, uint64_t cookie) {
+        if (Backend) {
+            Backend->beginAsync(name, cookie);
+        }
+    }
+
+    static inline void EndAsync(const char *name, uint64_t cookie) {
+        if (Backend) {
+            Backend->endAsync(name, cookie);
+        }
+    }
+
+    // Traces the lifetime of the scope. /name/ must outlive it.
+    class Scope : private util::noncopyable {
+    public:
+        inline Scope(const char *name) : backend(Backend.get()) {
+            if (backend) {
+                backend->begin(name);
+            }
+        }
+
+        inline ~Scope() {
+            if (backend) {
+                backend->end();
+            }
+        }
+
+    private:
+        TraceBackend *const backend;
+    };
+
+    // Must be called before any map is created, while no scope is open.
+    template<typename T, typename ...Args>
+    static inline const T &Set(Args&& ...args) {
+        Backend = util::make_unique<T>(::std::forward<Args>(args)...);
+        return *dynamic_cast<T *>(Backend.get());
+    }
+
+private:
+    static std::unique_ptr<TraceBackend> Backend;
+};
+
+}
+
+#endif
@@ -2,7 +2,9 @@
 #define MBGL_STORAGE_CACHING_HTTP_FILE_SOURCE
 
 #include <mbgl/storage/file_source.hpp>
+#include <mbgl/util/latency_histogram.hpp>
 
+#include <cstdint>
 #include <thread>
 #include <unordered_map>
 
@@ -12,6 +14,27 @@ namespace mbgl {
 
 class BaseRequest;
 class SQLiteStore;
+class MBTilesSource;
+class TimerWheel;
+struct RequestCounters;
+
+struct FileSourceStatistics {
+    // Calls to request().
+    uint64_t requests = 0;
+    // Requests that were attached to an identical request that was still in flight.
+    uint64_t coalesced = 0;
+    // HTTP requests that were answered from the cache without touching the network.
+    uint64_t cacheHits = 0;
+    // HTTP requests that went to the network, including revalidations of expired entries.
+    uint64_t cacheMisses = 0;
+
+    // How long reads from the disk cache and single attempts to reach the server took.
+    LatencyHistogram::Snapshot cacheLatency;
+    LatencyHistogram::Snapshot networkLatency;
+
+    // See FileSource::getBandwidth().
+    uint64_t bandwidth = 0;
+};
 
 class CachingHTTPFileSource : public FileSource {
 public:
@@ -36,9 +59,28 @@ public:
 
     void prepare(std::function<void()> fn);
 
+    size_t releaseMemory();
+
+    // Keeps the cached response for this URL from being evicted, e.g. because it belongs to an
+    // offline region. Call this after the request for the URL completed.
+    void pin(ResourceType type, const std::string &url);
+
     // Call this when the network status reachability changed.
     void setReachability(bool reachable);
 
+    // When disabled, HTTP requests are only answered from the cache, even if the cached entries
+    // expired, and fail otherwise. Only affects requests that are made afterwards.
+    void setNetworkEnabled(bool enabled);
+
+    // May be called from any thread.
+    FileSourceStatistics getStatistics() const;
+
+    uint64_t getBandwidth();
+
+private:
+    // Makes the URL absolute and resolves mapbox:// URLs.
+    std::string normalizeURL(ResourceType type, const std::string &url) const;
+
 private:
     std::thread::id threadId;
 
@@ -53,8 +95,13 @@ private:
 
     std::unordered_map<std::string, std::weak_ptr<BaseRequest>> pending;
     util::ptr<SQLiteStore> store;
+    util::ptr<RequestCounters> counters;
+    std::unique_ptr<MBTilesSource> mbtiles;
+    // Schedules the retries of all HTTP requests.
+    util::ptr<TimerWheel> timers;
     uv_loop_t *loop = nullptr;
     uv_messenger_t *queue = nullptr;
+    bool networkEnabled = true;
 };
 
 }
@@ -5,6 +5,7 @@
 #include <mbgl/storage/resource_type.hpp>
 #include <mbgl/storage/request.hpp>
 
+#include <cstdint>
 #include <string>
 #include <functional>
 
@@ -24,6 +25,15 @@ public:
     virtual void setBase(std::string) = 0;
     virtual std::unique_ptr<Request> request(ResourceType type, const std::string &url) = 0;
     virtual void prepare(std::function<void()> fn) = 0;
+
+    // Frees the memory that caches hold, e.g. on a low-memory warning. Must be called on the
+    // thread of the loop. Returns the number of bytes freed.
+    virtual size_t releaseMemory() = 0;
+
+    // The throughput of the network in bytes per second as measured by recent requests, or 0 if
+    // it isn't known. Maps load less detailed tiles first when it's low. May be called from any
+    // thread.
+    virtual uint64_t getBandwidth() { return 0; }
 };
 
 }
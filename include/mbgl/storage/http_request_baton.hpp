@@ -4,6 +4,8 @@
 #include <mbgl/storage/response.hpp>
 #include <mbgl/util/ptr.hpp>
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <thread>
 
@@ -57,16 +59,43 @@ struct HTTPRequestBaton {
     HTTPResponseType type = HTTPResponseType::Unknown;
     std::unique_ptr<Response> response;
 
+    // Requests with lower values are started first when the implementation has to queue them.
+    // Written on the main thread, read by the implementation.
+    std::atomic<float> priority;
+
+    // Whether the implementation should hand out the body in parts while it downloads. Written
+    // on the main thread, read by the implementation. Implementations that don't support it
+    // only deliver the complete response.
+    std::atomic<bool> progress { false };
+
+    // The parts of the body that arrived since the main thread last collected them, and where
+    // they start in the body. The implementation appends to progressData and signals
+    // progressAsync, as long as the main thread didn't close it yet. Guarded by progressMutex.
+    std::mutex progressMutex;
+    uv_async_t *progressAsync = nullptr;
+    std::string progressData;
+    size_t progressOffset = 0;
+
     // Implementation specific use.
     void *ptr = nullptr;
 
-    // IMPLEMENT THESE 3 PLATFORM SPECIFIC FUNCTIONS:
+    // IMPLEMENT THESE 4 PLATFORM SPECIFIC FUNCTIONS:
 
     // Begin the HTTP request. Platform-specific implementation.
     static void start(const util::ptr<HTTPRequestBaton> &ptr);
 
     // This will be called to stop/cancel the HTTP request (if possible). Platform-specific implementation.
     static void stop(const util::ptr<HTTPRequestBaton> &ptr);
+
+    // Limits the number of simultaneous connections to a single host. Requests over HTTP/2 are
+    // multiplexed on one connection where possible, so this mostly affects HTTP/1.1 hosts.
+    // Platform-specific implementation; may only take effect before the first request.
+    static void setMaxHostConnections(unsigned count);
+
+    // Offline downloads are handed to a system download service under this identifier, if the
+    // platform has one, so that they continue while the app is suspended. Platform-specific
+    // implementation; may only take effect before the first offline request.
+    static void setBackgroundSessionIdentifier(const std::string &identifier);
 };
 
 }
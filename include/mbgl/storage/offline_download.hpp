@@ -0,0 +1,115 @@
+#ifndef MBGL_STORAGE_OFFLINE_DOWNLOAD
+#define MBGL_STORAGE_OFFLINE_DOWNLOAD
+
+#include <mbgl/storage/resource_type.hpp>
+#include <mbgl/map/tile.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/ptr.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace mbgl {
+
+class CachingHTTPFileSource;
+class Request;
+class Response;
+class StyleSource;
+
+// The part of the world that should be available offline.
+struct OfflineRegion {
+    std::string styleURL;
+
+    // Bounding box in degrees.
+    double north = 85.0511, west = -180, south = -85.0511, east = 180;
+
+    // Map zoom levels; tile zoom levels are derived per source like the map does.
+    double minZoom = 0, maxZoom = 22;
+
+    float pixelRatio = 1;
+};
+
+// Downloads everything a map needs to render a region: the style, its sprite, the glyph ranges of
+// all font stacks used by symbol layers, the TileJSON of every source and every tile that covers
+// the region. Resources are requested through the file source, so they end up in its cache, and
+// are pinned there so that eviction never drops them.
+//
+// Restarting an interrupted download with the same region doesn't download everything again:
+// cached resources that are still fresh are served without touching the network, and expired ones
+// are only revalidated. While the network is unreachable, requests wait for
+// CachingHTTPFileSource::setReachability().
+//
+// Runs on the file source's loop and doesn't need a View or a Map.
+class OfflineDownload : private util::noncopyable {
+public:
+    struct Progress {
+        // Grows as the style and TileJSON documents are parsed.
+        uint64_t requiredResources = 0;
+        uint64_t completedResources = 0;
+        uint64_t failedResources = 0;
+        uint64_t completedBytes = 0;
+        bool complete = false;
+    };
+
+    // Called after every finished resource. The download must not be destroyed from within.
+    typedef std::function<void(const Progress &)> ProgressCallback;
+
+    OfflineDownload(CachingHTTPFileSource &fileSource, const OfflineRegion &region,
+                    ProgressCallback callback, size_t maxConcurrentRequests = 8);
+    ~OfflineDownload();
+
+    void start();
+    void cancel();
+
+    const Progress &getProgress() const;
+
+private:
+    // What to do with a resource once it arrived.
+    enum class Kind : uint8_t { Style, TileJSON, Tile, Other };
+
+    struct Resource {
+        inline Resource(Kind kind_, ResourceType type_, const std::string &url_,
+                        const util::ptr<StyleSource> &source_, const Tile::ID &id_)
+            : kind(kind_), type(type_), url(url_), source(source_), id(id_) {}
+
+        const Kind kind;
+        const ResourceType type;
+        // Tile URLs are only filled in from the source once the tile is requested.
+        const std::string url;
+        const util::ptr<StyleSource> source;
+        const Tile::ID id;
+    };
+
+    void add(Kind kind, ResourceType type, const std::string &url,
+             const util::ptr<StyleSource> &source = nullptr);
+    void addTiles(const util::ptr<StyleSource> &source);
+    void pump();
+    void finish(const Resource &resource, const std::string &url, const Response &res);
+    bool parseStyle(const std::string &data);
+    bool parseTileJSON(const util::ptr<StyleSource> &source, const std::string &data);
+
+private:
+    const std::thread::id threadId;
+    CachingHTTPFileSource &fileSource;
+    const OfflineRegion region;
+    const ProgressCallback callback;
+    const size_t maxConcurrentRequests;
+
+    // Directory of the style URL, for resolving relative URLs in the style.
+    std::string base;
+
+    Progress progress;
+    std::deque<Resource> queue;
+    std::list<std::unique_ptr<Request>> active;
+    bool started = false;
+    bool pumping = false;
+};
+
+}
+
+#endif
@@ -15,6 +15,12 @@ namespace mbgl {
 
 class BaseRequest;
 
+// Network requests are scheduled in ascending priority order. Tiles use their distance from the
+// viewport center, which stays well below these offsets, so that visible tiles always go first,
+// followed by prefetched tiles and finally by offline downloads.
+const float PrefetchRequestPriority = 1000;
+const float OfflineRequestPriority = 2000;
+
 class Request {
 private:
     Request(const Request &) = delete;
@@ -28,8 +34,17 @@ public:
 
     void onload(CompletedCallback cb);
     void oncancel(AbortedCallback cb);
+
+    // Hands out the body in parts as it arrives from the network, before onload() receives the
+    // complete response. Parts that arrived before this was called aren't repeated, and a retry
+    // starts over at offset 0. Responses from the cache and requests that can't deliver parts
+    // don't call it at all.
+    void onprogress(ProgressCallback cb);
     void cancel();
 
+    // May be called repeatedly while the request is in progress, e.g. when the viewport moves.
+    void setPriority(float priority);
+
 private:
     const std::thread::id thread_id;
     util::ptr<BaseRequest> base;
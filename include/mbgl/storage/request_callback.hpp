@@ -4,6 +4,7 @@
 #include <mbgl/util/variant.hpp>
 
 #include <functional>
+#include <string>
 
 namespace mbgl {
 
@@ -12,9 +13,14 @@ class Response;
 using CompletedCallback = std::function<void(const Response &)>;
 using AbortedCallback = std::function<void()>;
 
+// Receives the next part of the response body while it is still downloading, along with where
+// the part starts in the body.
+using ProgressCallback = std::function<void(const std::string &data, size_t offset)>;
+
 using Callback = mapbox::util::variant<
     CompletedCallback,
-    AbortedCallback
+    AbortedCallback,
+    ProgressCallback
 >;
 
 }
@@ -1,7 +1,10 @@
 #ifndef MBGL_STORAGE_RESPONSE
 #define MBGL_STORAGE_RESPONSE
 
+#include <mbgl/util/time.hpp>
+
 #include <string>
+#include <memory>
 #include <ctime>
 
 namespace mbgl {
@@ -14,10 +17,22 @@ public:
     int64_t modified = 0;
     int64_t expires = 0;
     std::string etag;
-    std::string data;
+
+    // The body is immutable once the response has been created, so that it can be handed on to
+    // parsers and caches without copying it.
+    std::shared_ptr<const std::string> data = std::make_shared<const std::string>();
 
     std::string message;
 
+    // Set on a cached response that expired and is handed out while it is being revalidated.
+    // Listeners are called again if the revalidation turns up different data.
+    bool stale = false;
+
+    // Nanoseconds that the request spent reading the disk cache and waiting for the server, in all
+    // attempts. Time spent waiting for a retry counts towards neither.
+    timestamp cacheTime = 0;
+    timestamp networkTime = 0;
+
     static int64_t parseCacheControl(const char *value);
 };
 
@@ -0,0 +1,104 @@
+#ifndef MBGL_STORAGE_SHARED_FILE_SOURCE
+#define MBGL_STORAGE_SHARED_FILE_SOURCE
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/caching_http_file_source.hpp>
+#include <mbgl/util/uv.hpp>
+#include <mbgl/util/ptr.hpp>
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace mbgl {
+
+class BaseRequest;
+struct SharedRequestBaton;
+struct SharedMailbox;
+
+// One CachingHTTPFileSource with its own thread and loop that serves any number of Maps, e.g. in a
+// tile server that renders on several threads. Identical requests are coalesced across all Maps
+// while they are in flight, and the responses share their data.
+//
+// Maps can't use this object directly; every Map gets its own Client:
+//
+//     SharedFileSource shared("cache.db");
+//     SharedFileSource::Client fileSource(shared);
+//     Map map(view, fileSource);
+//
+// All Clients must be destroyed before the SharedFileSource.
+class SharedFileSource : private util::noncopyable {
+public:
+    SharedFileSource(const std::string &path);
+    ~SharedFileSource();
+
+    // These may be called from any thread.
+    void setAccessToken(std::string);
+    void setReachability(bool reachable);
+    void releaseMemory();
+    FileSourceStatistics getStatistics() const;
+
+    class Client : public FileSource {
+    public:
+        Client(SharedFileSource &shared);
+        ~Client();
+
+        void setLoop(uv_loop_t*);
+        bool hasLoop();
+        void clearLoop();
+
+        // Relative URLs are resolved per Client; mapbox:// URLs use the shared access token.
+        void setBase(std::string);
+
+        std::unique_ptr<Request> request(ResourceType type, const std::string &url);
+        void prepare(std::function<void()> fn);
+
+        // Frees the caches of the SharedFileSource. They belong to the shared thread, so they
+        // are freed asynchronously and this always returns 0.
+        size_t releaseMemory();
+
+        uint64_t getBandwidth();
+
+    private:
+        SharedFileSource &shared;
+        std::thread::id threadId;
+        std::string base;
+        uv_loop_t *loop = nullptr;
+        util::ptr<SharedMailbox> mailbox;
+
+        // Coalesces identical requests of this Map without a round trip to the shared thread.
+        std::unordered_map<std::string, std::weak_ptr<BaseRequest>> pending;
+    };
+
+private:
+    void run();
+
+    // Only called on the shared thread.
+    void start(const util::ptr<SharedRequestBaton> &baton, ResourceType type, const std::string &url);
+    void stop(const util::ptr<SharedRequestBaton> &baton);
+
+    // Runs the function on the shared thread.
+    void invoke(std::function<void()> fn);
+
+    friend class SharedRequest;
+
+private:
+    const std::string path;
+    std::thread thread;
+    std::unique_ptr<CachingHTTPFileSource> fileSource;
+    std::unique_ptr<uv::async> asyncTerminate;
+
+    // Requests that are in flight on the shared thread.
+    std::set<util::ptr<SharedRequestBaton>> active;
+
+    // Requests that were coalesced by a Client before they reached the shared thread.
+    std::atomic<uint64_t> requests { 0 };
+    std::atomic<uint64_t> coalesced { 0 };
+};
+
+}
+
+#endif
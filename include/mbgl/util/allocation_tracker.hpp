@@ -0,0 +1,84 @@
+#ifndef MBGL_UTIL_ALLOCATION_TRACKER
+#define MBGL_UTIL_ALLOCATION_TRACKER
+
+#include <mbgl/util/memory_usage.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace mbgl {
+
+// Counts the heap allocations of the subsystems, to tell where allocation churn comes from. Only
+// builds with MBGL_TRACK_ALLOCATIONS defined (make TRACK_ALLOCATIONS=1) count anything: they
+// replace the global operator new, which costs a thread local lookup and two atomic additions per
+// allocation. In all other builds the scopes compile to nothing and every count stays zero.
+class AllocationTracker : private util::noncopyable {
+public:
+    enum class Subsystem : uint8_t {
+        Other,
+        TileParser,
+        SymbolBucket,
+        StyleParser,
+        SQLiteStore,
+        Painter,
+    };
+    static const size_t subsystemCount = size_t(Subsystem::Painter) + 1;
+    static const char *subsystemName(Subsystem);
+
+    struct Counts {
+        std::array<AllocationUsage, subsystemCount> subsystems;
+
+        inline const AllocationUsage &operator[](Subsystem subsystem) const {
+            return subsystems[size_t(subsystem)];
+        }
+
+        Counts &operator+=(const Counts &rhs);
+        Counts operator-(const Counts &rhs) const;
+
+        // All subsystems together.
+        AllocationUsage sum() const;
+
+        // Keyed by subsystem name; subsystems without allocations are left out.
+        std::map<std::string, AllocationUsage> toMap() const;
+    };
+
+    // Attributes the allocations of the current thread to /subsystem/ until the scope ends. Scopes
+    // nest; the innermost one wins.
+    class Scope : private util::noncopyable {
+    public:
+#if defined(MBGL_TRACK_ALLOCATIONS)
+        explicit Scope(Subsystem subsystem);
+        ~Scope();
+
+    private:
+        const Subsystem previous;
+#else
+        inline explicit Scope(Subsystem) {}
+#endif
+    };
+
+    static constexpr bool isEnabled() {
+#if defined(MBGL_TRACK_ALLOCATIONS)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Allocations of all threads since the process started.
+    static Counts total();
+
+    // Allocations of the calling thread since it started.
+    static Counts thread();
+
+    // Adds allocations that other threads made on behalf of the calling thread, like the tasks it
+    // handed off, to the counts of the calling thread. total() has them already.
+    static void adopt(const Counts &counts);
+};
+
+}
+
+#endif
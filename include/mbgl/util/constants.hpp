@@ -2,12 +2,44 @@
 #define MBGL_UTIL_CONSTANTS
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 
 namespace mbgl {
 
 namespace util {
 
 extern const float tileSize;
+
+// Maximum number of bytes of decoded layer data a vector tile keeps between parses.
+extern const size_t decodedTileCacheSize;
+
+// Default number of bytes a map keeps in parsed tiles that are out of view.
+extern const size_t tileCacheSize;
+
+// Number of bytes of tile geometry and images a continuously rendering map uploads per frame.
+extern const size_t uploadBudget;
+
+// Nanoseconds that the map thread spends in finished tile jobs before it lets a due frame render.
+extern const uint64_t afterWorkBudget;
+
+// Nanoseconds that a tile worker thread waits for work before it exits.
+extern const uint64_t workerIdleTimeout;
+
+// Tile units around the tile extent that fill and line geometry is clipped to; large enough to
+// keep clipped line caps and joins out of view.
+extern const int16_t tileClipBuffer;
+
+// Seconds that missing and empty responses are cached for when the server doesn't set an expiration.
+extern const int64_t negativeCacheTTL;
+
+// Bytes per second below which maps load the tiles one zoom level up before the tiles that the
+// viewport needs.
+extern const uint64_t lowBandwidth;
+
+// Name of the layer in the tiles of GeoJSON sources. Layers of such a source read it, whatever
+// their source-layer is.
+extern const char *geojsonLayerName;
 }
 
 namespace debug {
@@ -0,0 +1,90 @@
+#ifndef MBGL_UTIL_FRAME_PROFILER
+#define MBGL_UTIL_FRAME_PROFILER
+
+#include <mbgl/platform/trace.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/time.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mbgl {
+
+// Records how long the phases of each frame take on the CPU. The map thread writes into a fixed
+// ring buffer without locking; any other thread may read the recent samples at the same time.
+class FrameProfiler : private util::noncopyable {
+public:
+    enum class Phase : uint8_t {
+        UpdateSources,
+        UpdateTiles,
+        UpdateProperties,
+        Upload,
+        ClipIDs,
+        TileTextures,
+        OpaquePass,
+        TranslucentPass,
+        Swap,
+    };
+    static const size_t phaseCount = size_t(Phase::Swap) + 1;
+    static const char *phaseName(Phase);
+
+    // Measures a phase from construction until destruction, and traces it when tracing is on.
+    class Scope : private util::noncopyable {
+    public:
+        inline Scope(FrameProfiler &profiler_, Phase phase_)
+            : profiler(profiler_), phase(phase_), start(util::now()), trace(phaseName(phase_)) {}
+        inline ~Scope() { profiler.record(phase, start, util::now()); }
+
+    private:
+        FrameProfiler &profiler;
+        const Phase phase;
+        const timestamp start;
+        const Trace::Scope trace;
+    };
+
+    struct Summary {
+        Phase phase;
+        size_t count = 0;
+        // In nanoseconds.
+        timestamp p50 = 0, p90 = 0, p99 = 0, max = 0;
+    };
+
+    // Must only be called by one thread at a time.
+    void record(Phase phase, timestamp start, timestamp end);
+
+    // Percentiles of each phase over the samples in the buffer. Phases without samples are left
+    // out.
+    std::vector<Summary> summarize() const;
+
+    // The samples in the buffer in the Chrome trace event format, for chrome://tracing.
+    std::string toChromeTrace() const;
+
+private:
+    struct Sample {
+        Phase phase;
+        timestamp start;
+        timestamp duration;
+    };
+
+    // Copies the samples that weren't overwritten while they were read, oldest first.
+    std::vector<Sample> samples() const;
+
+    // Each slot is guarded by a sequence number that is odd while the slot is written.
+    struct Slot {
+        std::atomic<uint64_t> sequence { 0 };
+        std::atomic<uint8_t> phase { 0 };
+        std::atomic<uint64_t> start { 0 };
+        std::atomic<uint64_t> duration { 0 };
+    };
+
+    static const size_t capacity = 4096;
+    std::array<Slot, capacity> slots;
+    std::atomic<uint64_t> written { 0 };
+};
+
+}
+
+#endif
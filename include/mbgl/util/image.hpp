@@ -1,30 +1,63 @@
 #ifndef MBGL_UTIL_IMAGE
 #define MBGL_UTIL_IMAGE
 
+#include <cstdint>
 #include <string>
 #include <memory>
 
 namespace mbgl {
 namespace util {
 
-std::string compress_png(int width, int height, void *rgba);
+struct PNGOptions {
+    // The row filters the encoder chooses from. Fewer filters encode faster, but compress worse.
+    enum class Filter : uint8_t { Adaptive, None, Sub, Up, Average, Paeth };
+
+    // The zlib level from 0 (fastest) to 9 (smallest); -1 keeps the encoder's default.
+    int compressionLevel = -1;
+    Filter filter = Filter::Adaptive;
+
+    // Stores the image with a palette of at most 256 colors. Colors are merged when the image
+    // has more.
+    bool quantize = false;
+
+    // The rows of the image are stored bottom-up, as OpenGL reads them back.
+    bool flipY = false;
+};
+
+// Options that the platform's encoder doesn't support are ignored.
+std::string compress_png(int width, int height, void *rgba, const PNGOptions &options);
+
+// With /flipY/, the rows of /rgba/ are stored bottom-up, as OpenGL reads them back.
+std::string compress_png(int width, int height, void *rgba, bool flipY = false);
+
+// JPEG has no alpha channel; the image is stored as if it was drawn on black. /quality/ goes
+// from 0 to 100.
+std::string compress_jpeg(int width, int height, void *rgba, int quality = 90, bool flipY = false);
 
 
 class Image {
 public:
     Image(const std::string &img);
 
-    inline const char *getData() const { return img.get(); }
+    inline const char *getData() const { return img.empty() ? nullptr : img.data(); }
     inline uint32_t getWidth() const { return width; }
     inline uint32_t getHeight() const { return height; }
-    inline operator bool() const { return img && width && height; }
+    inline operator bool() const { return !img.empty() && width && height; }
+
+    // Moves the decoded pixels out, so that they can be kept without a copy. The image is empty
+    // afterwards.
+    inline std::string takeData() {
+        std::string result;
+        result.swap(img);
+        return result;
+    }
 
 private:
     // loaded image dimensions
     uint32_t width = 0, height = 0;
 
-    // the raw image data
-    std::unique_ptr<char[]> img;
+    // the raw image data, decoded in place
+    std::string img;
 };
 
 
@@ -0,0 +1,28 @@
+#ifndef MBGL_UTIL_IMAGE_KERNELS
+#define MBGL_UTIL_IMAGE_KERNELS
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mbgl {
+namespace util {
+
+// Per-pixel loops over RGBA images, with 16 bytes at a time where the target has SSE2 or NEON,
+// like pbf::varints. All of them give the same results as a pixel-by-pixel loop.
+
+// Whether every pixel has full alpha.
+bool isOpaque(const uint8_t *rgba, size_t pixels);
+
+// Drops alpha and rounds the colors to 5, 6 and 5 bits. /dst/ may be the same buffer as /src/.
+void convertRGBAToRGB565(const uint8_t *src, uint16_t *dst, size_t pixels);
+
+// Drops alpha. /dst/ may be the same buffer as /src/.
+void convertRGBAToRGB(const uint8_t *src, uint8_t *dst, size_t pixels);
+
+// Reverses the order of the rows, like turning what OpenGL reads back into top row first.
+void flipRows(uint32_t *pixels, size_t width, size_t height);
+
+}
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef MBGL_UTIL_LATENCY_HISTOGRAM
+#define MBGL_UTIL_LATENCY_HISTOGRAM
+
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/time.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace mbgl {
+
+// Counts durations in buckets that double in width, from below a microsecond up to half an hour.
+// Durations may be added from any thread while others take snapshots.
+class LatencyHistogram : private util::noncopyable {
+public:
+    static const size_t bucketCount = 32;
+
+    struct Snapshot {
+        // Bucket 0 holds durations below one microsecond; bucket i those below 2^i microseconds.
+        std::array<uint64_t, bucketCount> buckets {};
+        uint64_t count = 0;
+        // In nanoseconds.
+        timestamp total = 0;
+
+        timestamp mean() const;
+        // The upper bound of the bucket in which the given fraction of the durations lies, e.g.
+        // 0.9 for the 90th percentile. Returns 0 if there are no durations.
+        timestamp percentile(double fraction) const;
+
+        Snapshot &operator+=(const Snapshot &rhs);
+    };
+
+    LatencyHistogram();
+
+    void add(timestamp duration);
+    Snapshot snapshot() const;
+
+    // The exclusive upper bound of the durations in a bucket.
+    static timestamp bucketLimit(size_t bucket);
+
+private:
+    std::array<std::atomic<uint64_t>, bucketCount> buckets;
+    std::atomic<uint64_t> total;
+};
+
+// Keyed by the source name in the style, then by the phase of the tile pipeline:
+//   "request": from requesting the tile until its data arrived, including retries.
+//   "cache":   reading the tile from the disk cache.
+//   "network": waiting for the server; absent for tiles that were only read from the cache.
+//   "queue":   waiting for a worker thread to start parsing.
+//   "parse":   parsing on the worker thread.
+//   "upload":  from the end of parsing until the tile was first uploaded to the GPU.
+typedef std::map<std::string, std::map<std::string, LatencyHistogram::Snapshot>> TileLatencies;
+
+}
+
+#endif
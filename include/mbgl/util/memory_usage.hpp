@@ -0,0 +1,108 @@
+#ifndef MBGL_UTIL_MEMORY_USAGE
+#define MBGL_UTIL_MEMORY_USAGE
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace mbgl {
+
+// Number of bytes held in main memory and in GL buffers and textures.
+struct MemoryUsage {
+    uint64_t cpu = 0;
+    uint64_t gpu = 0;
+
+    inline MemoryUsage() {}
+    inline MemoryUsage(uint64_t cpu_, uint64_t gpu_) : cpu(cpu_), gpu(gpu_) {}
+
+    inline uint64_t total() const {
+        return cpu + gpu;
+    }
+
+    inline MemoryUsage &operator+=(const MemoryUsage &rhs) {
+        cpu += rhs.cpu;
+        gpu += rhs.gpu;
+        return *this;
+    }
+
+    inline MemoryUsage operator+(const MemoryUsage &rhs) const {
+        return MemoryUsage(cpu + rhs.cpu, gpu + rhs.gpu);
+    }
+
+    // Stops at zero, so that the difference of two measurements never wraps around.
+    inline MemoryUsage operator-(const MemoryUsage &rhs) const {
+        return MemoryUsage(cpu > rhs.cpu ? cpu - rhs.cpu : 0, gpu > rhs.gpu ? gpu - rhs.gpu : 0);
+    }
+};
+
+// Number of heap allocations and the bytes they asked for. Only counted in builds that track
+// allocations; see AllocationTracker.
+struct AllocationUsage {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+
+    inline AllocationUsage() {}
+    inline AllocationUsage(uint64_t count_, uint64_t bytes_) : count(count_), bytes(bytes_) {}
+
+    inline AllocationUsage &operator+=(const AllocationUsage &rhs) {
+        count += rhs.count;
+        bytes += rhs.bytes;
+        return *this;
+    }
+
+    inline AllocationUsage operator-(const AllocationUsage &rhs) const {
+        return AllocationUsage(count > rhs.count ? count - rhs.count : 0, bytes > rhs.bytes ? bytes - rhs.bytes : 0);
+    }
+};
+
+struct TileMemoryUsage {
+    MemoryUsage total;
+
+    // The raw tile data and its decoded layers.
+    MemoryUsage data;
+
+    // Keyed by bucket type, i.e. "fill", "line", "symbol", "raster" and "debug". The buffers that
+    // the buckets of a tile share are split up by the bytes each bucket uses; unused capacity only
+    // shows up in the total.
+    std::map<std::string, MemoryUsage> buckets;
+
+    // Whether the tile is out of view and only kept in the cache.
+    bool cached = false;
+
+    // Made by the last parse of the tile, keyed by subsystem, e.g. "TileParser" and "SymbolBucket".
+    std::map<std::string, AllocationUsage> allocations;
+};
+
+struct SourceMemoryUsage {
+    MemoryUsage total;
+
+    // The part of the total that is held by cached tiles.
+    MemoryUsage cached;
+
+    // Keyed by tile ID, e.g. "14/8800/5373".
+    std::map<std::string, TileMemoryUsage> tiles;
+
+    // Sum of the bucket types of all tiles.
+    std::map<std::string, MemoryUsage> buckets;
+};
+
+struct MapMemoryUsage {
+    MemoryUsage total;
+
+    // Keyed by the source name in the style.
+    std::map<std::string, SourceMemoryUsage> sources;
+
+    // Shared by all sources; keyed by "glyphs", "sprites", "lines", "textures" and "buffers". The
+    // latter two are textures of removed raster tiles and buffer arrays of uploaded tiles that are
+    // kept for reuse.
+    std::map<std::string, MemoryUsage> atlases;
+
+    // Made by all threads from the end of the frame before the last one until the end of the last
+    // frame, keyed by subsystem:
+    // "TileParser", "SymbolBucket", "StyleParser", "SQLiteStore", "Painter" and "Other".
+    std::map<std::string, AllocationUsage> allocations;
+};
+
+}
+
+#endif
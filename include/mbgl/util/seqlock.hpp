@@ -0,0 +1,67 @@
+#ifndef MBGL_UTIL_SEQLOCK
+#define MBGL_UTIL_SEQLOCK
+
+#include <mbgl/util/noncopyable.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace mbgl {
+namespace util {
+
+// Publishes a value from one writer to any number of readers without a lock. Readers never block
+// the writer; they retry while a write is in progress. Writes must not run concurrently.
+template <typename T>
+class SeqLock : private noncopyable {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock values must be trivially copyable");
+
+public:
+    inline SeqLock() {
+        store(T());
+    }
+
+    void store(const T &value) {
+        uint64_t words[wordCount] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        const uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < wordCount; i++) {
+            data[i].store(words[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    T load() const {
+        uint64_t words[wordCount];
+        uint64_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < wordCount; i++) {
+                words[i] = data[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static const size_t wordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // Odd while a write is in progress.
+    std::atomic<uint64_t> sequence { 0 };
+    std::array<std::atomic<uint64_t>, wordCount> data;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef MBGL_UTIL_STARTUP_PROFILER
+#define MBGL_UTIL_STARTUP_PROFILER
+
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/time.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace mbgl {
+
+// Records when the map first reached each stage of its startup, so that the time to the first
+// frame can be broken down. The map thread writes; any other thread may read at the same time.
+class StartupProfiler : private util::noncopyable {
+public:
+    enum class Stage : uint8_t {
+        Start,      // The map thread started running.
+        Shaders,    // All shaders are compiled.
+        Style,      // The style is parsed.
+        Sprite,     // The sprite image and JSON are loaded.
+        Sources,    // The TileJSON of every source is loaded.
+        FirstFrame, // The first frame with tiles of any source was rendered.
+    };
+    static const size_t stageCount = size_t(Stage::FirstFrame) + 1;
+    static const char *stageName(Stage);
+
+    StartupProfiler();
+
+    // Starts over; the next call to record(Stage::Start) begins a new startup.
+    void reset();
+
+    // Records the current time for the stage, unless the stage was reached before.
+    void record(Stage stage);
+
+    inline bool reached(Stage stage) const {
+        return times[size_t(stage)].load(std::memory_order_acquire) != 0;
+    }
+
+    // Nanoseconds from the start until the stage was reached, or 0 if it wasn't reached yet.
+    timestamp elapsed(Stage stage) const;
+
+private:
+    std::array<std::atomic<uint64_t>, stageCount> times;
+};
+
+}
+
+#endif
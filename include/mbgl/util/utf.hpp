@@ -17,6 +17,14 @@ class utf8_to_utf32 {
         boost::u8_to_u32_iterator<std::string::const_iterator> end(utf8.end());
         return std::u32string(begin,end);
     }
+
+    // Decodes into an existing string, reusing its storage.
+    static void convert(std::string const& utf8, std::u32string& utf32)
+    {
+        boost::u8_to_u32_iterator<std::string::const_iterator> begin(utf8.begin());
+        boost::u8_to_u32_iterator<std::string::const_iterator> end(utf8.end());
+        utf32.assign(begin,end);
+    }
 };
 
 }}
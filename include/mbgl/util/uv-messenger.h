@@ -12,16 +12,27 @@ typedef void (*uv_messenger_cb)(void *arg);
 typedef void (*uv_messenger_stop_cb)(uv_messenger_t *msgr);
 
 struct uv_messenger_s {
-    uv_mutex_t mutex;
     uv_async_t async;
     uv_messenger_cb callback;
     uv_messenger_stop_cb stop_callback;
     void *data;
-    void *queue[2];
+
+    // The most recently sent message that the loop hasn't taken yet. Only accessed atomically.
+    void *head;
+
+    // Messages that the loop took, but didn't deliver yet because the budget was used up. Only
+    // accessed on the loop thread.
+    void *backlog;
+    uint64_t budget;
 };
 
 int uv_messenger_init(uv_loop_t *loop, uv_messenger_t *msgr, uv_messenger_cb callback);
 void uv_messenger_send(uv_messenger_t *msgr, void *arg);
+
+// Limits the time that one wakeup spends delivering messages to /budget/ nanoseconds (0 = no
+// limit). The remaining messages are delivered in the next loop iteration, after the other
+// handles of the loop had their turn.
+void uv_messenger_set_budget(uv_messenger_t *msgr, uint64_t budget);
 void uv_messenger_stop(uv_messenger_t *msgr, uv_messenger_stop_cb stop_callback);
 void uv_messenger_ref(uv_messenger_t *msgr);
 void uv_messenger_unref(uv_messenger_t *msgr);
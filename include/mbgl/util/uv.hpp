@@ -15,6 +15,7 @@ std::string cwd();
 class rwlock;
 class loop;
 class async;
+class timer;
 class worker;
 class mutex;
 class cond;
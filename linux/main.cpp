@@ -4,6 +4,9 @@
 #include <mbgl/platform/default/settings_json.hpp>
 #include <mbgl/platform/default/glfw_view.hpp>
 #include <mbgl/platform/default/log_stderr.hpp>
+#include <mbgl/platform/default/trace_marker.hpp>
+#include <mbgl/platform/default/freetype_glyph_rasterizer.hpp>
+#include <mbgl/platform/async_log.hpp>
 #include <mbgl/storage/caching_http_file_source.hpp>
 
 #include <signal.h>
@@ -25,20 +28,27 @@ void quit_handler(int) {
 }
 
 int main(int argc, char *argv[]) {
-    mbgl::Log::Set<mbgl::StderrLogBackend>();
+    mbgl::Log::Set<mbgl::AsyncLogBackend>(mbgl::util::make_unique<mbgl::StderrLogBackend>());
+
+    // Every trace event is a system call, so tracing is only on when asked for.
+    if (getenv("MBGL_TRACE")) {
+        mbgl::Trace::Set<mbgl::TraceMarkerBackend>();
+    }
 
     int fullscreen_flag = 0;
     std::string style;
+    std::vector<std::string> localFonts;
 
     const struct option long_options[] = {
         {"fullscreen", no_argument, &fullscreen_flag, 'f'},
         {"style", required_argument, 0, 's'},
+        {"local-font", required_argument, 0, 'l'},
         {0, 0, 0, 0}
     };
 
     while (true) {
         int option_index = 0;
-        int opt = getopt_long(argc, argv, "fs:", long_options, &option_index);
+        int opt = getopt_long(argc, argv, "fs:l:", long_options, &option_index);
         if (opt == -1) break;
         switch (opt)
         {
@@ -50,6 +60,10 @@ int main(int argc, char *argv[]) {
             break;
         case 's':
             style = std::string("asset://") + std::string(optarg);
+            break;
+        case 'l':
+            localFonts.push_back(optarg);
+            break;
         default:
             break;
         }
@@ -73,6 +87,17 @@ int main(int argc, char *argv[]) {
     map.setBearing(settings.bearing);
     map.setDebug(settings.debug);
 
+    // Draw CJK glyphs with the given fonts instead of downloading them.
+    if (!localFonts.empty()) {
+        map.setLocalGlyphRasterizer(mbgl::util::make_unique<mbgl::FreeTypeGlyphRasterizer>(localFonts), {
+            { 0x3000, 0x30FF },  // CJK Symbols and Punctuation, Hiragana, Katakana
+            { 0x3400, 0x4DBF },  // CJK Unified Ideographs Extension A
+            { 0x4E00, 0x9FFF },  // CJK Unified Ideographs
+            { 0xAC00, 0xD7FF },  // Hangul Syllables
+            { 0xF900, 0xFAFF },  // CJK Compatibility Ideographs
+        });
+    }
+
     // Set access token if present
     const char *token = getenv("MAPBOX_ACCESS_TOKEN");
     if (token == nullptr) {
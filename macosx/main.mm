@@ -1,6 +1,8 @@
 #include <mbgl/platform/platform.hpp>
 #include <mbgl/platform/darwin/settings_nsuserdefaults.hpp>
 #include <mbgl/platform/darwin/log_nslog.hpp>
+#include <mbgl/platform/darwin/trace_signpost.hpp>
+#include <mbgl/platform/async_log.hpp>
 #include <mbgl/platform/darwin/Reachability.h>
 #include <mbgl/platform/default/glfw_view.hpp>
 #include <mbgl/storage/caching_http_file_source.hpp>
@@ -71,7 +73,8 @@
 @end
 
 int main() {
-    mbgl::Log::Set<mbgl::NSLogBackend>();
+    mbgl::Log::Set<mbgl::AsyncLogBackend>(mbgl::util::make_unique<mbgl::NSLogBackend>());
+    mbgl::Trace::Set<mbgl::SignpostTraceBackend>();
 
     GLFWView view;
     mbgl::CachingHTTPFileSource fileSource(mbgl::platform::defaultCacheDatabase());
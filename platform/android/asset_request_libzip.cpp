@@ -5,6 +5,7 @@
 #include <mbgl/util/std.hpp>
 
 #include <cerrno>
+#include <mutex>
 // NOTE a bug in the Android NDK breaks std::errno
 // See https://code.google.com/p/android/issues/detail?id=72349
 // After this is fixed change usage errno to std::errno
@@ -12,6 +13,28 @@
 
 namespace mbgl {
 
+// The APK is opened once and shared by all requests, so that its central directory is only parsed
+// a single time. libzip archives aren't thread-safe, and requests may run on several loops.
+struct APK {
+    std::mutex mtx;
+    struct zip *archive = nullptr;
+
+    // Must be called with the mutex held. Returns nullptr and sets error if the APK can't be opened;
+    // we'll try again on the next request.
+    struct zip *open(int &error) {
+        if (!archive) {
+            archive = zip_open(mbgl::android::apkPath.c_str(), 0, &error);
+        }
+        return archive;
+    }
+};
+
+APK &sharedAPK() {
+    // Never destructed, so that requests on other threads can't outlive it during shutdown.
+    static APK *apk = new APK;
+    return *apk;
+}
+
 struct AssetRequestBaton {
     AssetRequestBaton(AssetRequest *request_, const std::string &path, uv_loop_t *loop);
     ~AssetRequestBaton();
@@ -24,7 +47,7 @@ struct AssetRequestBaton {
 
     void cancel();
     static void notifyError(AssetRequestBaton *ptr, const int code, const char *message);
-    static void notifySuccess(AssetRequestBaton *ptr, const std::string body);
+    static void notifySuccess(AssetRequestBaton *ptr, std::string body);
     static void cleanup(AssetRequestBaton *ptr);
     static void run(AssetRequestBaton *ptr);
 };
@@ -59,13 +82,13 @@ void AssetRequestBaton::notifyError(AssetRequestBaton *ptr, const int code, cons
     }
 }
 
-void AssetRequestBaton::notifySuccess(AssetRequestBaton *ptr, const std::string body) {
+void AssetRequestBaton::notifySuccess(AssetRequestBaton *ptr, std::string body) {
     assert(std::this_thread::get_id() == ptr->threadId);
 
     if (ptr->request && !ptr->canceled) {
         ptr->request->response = std::unique_ptr<Response>(new Response);
         ptr->request->response->code = 200;
-        ptr->request->response->data = body;
+        ptr->request->response->data = std::make_shared<const std::string>(std::move(body));
         ptr->request->notify();
     }
 }
@@ -93,70 +116,60 @@ void AssetRequestBaton::run(AssetRequestBaton *ptr) {
         return;
     }
 
+    APK &shared = sharedAPK();
+    std::unique_lock<std::mutex> lock(shared.mtx);
+
     int error = 0;
-    struct zip *apk = zip_open(mbgl::android::apkPath.c_str(), 0, &error);
-    if ((apk == nullptr) || ptr->canceled || !ptr->request) {
-        // Opening the APK failed or was canceled. There isn't much left we can do.
+    struct zip *apk = shared.open(error);
+    if (apk == nullptr) {
+        // Opening the APK failed. There isn't much left we can do.
         const int messageSize = zip_error_to_str(nullptr, 0, error, errno);
         const std::unique_ptr<char[]> message = mbgl::util::make_unique<char[]>(messageSize);
         zip_error_to_str(message.get(), 0, error, errno);
+        lock.unlock();
         notifyError(ptr, 500, message.get());
         cleanup(ptr);
         return;
     }
 
     std::string apkFilePath = "assets/" + ptr->path;
-    struct zip_file *apkFile = zip_fopen(apk, apkFilePath.c_str(), ZIP_FL_NOCASE);
-    if ((apkFile == nullptr) || ptr->canceled || !ptr->request) {
-        // Opening the asset failed or was canceled. We already have an open file handle
-        // though, which we'll have to close.
-        zip_error_get(apk, &error, nullptr);
-        notifyError(ptr, error == ZIP_ER_NOENT ? 404 : 500, zip_strerror(apk));
-        zip_close(apk);
-        apk = nullptr;
-        cleanup(ptr);
-        return;
-    }
-
     struct zip_stat stat;
-    if ((zip_stat(apk, apkFilePath.c_str(), ZIP_FL_NOCASE, &stat) != 0) || ptr->canceled || !ptr->request) {
-        // Stating failed or was canceled. We already have an open file handle
-        // though, which we'll have to close.
-        notifyError(ptr, 500, zip_strerror(apk));
-        zip_fclose(apkFile);
-        apkFile = nullptr;
-        zip_close(apk);
-        apk = nullptr;
+    if (zip_stat(apk, apkFilePath.c_str(), ZIP_FL_NOCASE, &stat) != 0) {
+        // The asset doesn't exist; this is a lookup in the central directory we already parsed.
+        zip_error_get(apk, &error, nullptr);
+        const std::string message = zip_strerror(apk);
+        lock.unlock();
+        notifyError(ptr, error == ZIP_ER_NOENT ? 404 : 500, message.c_str());
         cleanup(ptr);
         return;
     }
 
-    const std::unique_ptr<char[]> data = mbgl::util::make_unique<char[]>(stat.size);
-
-    if (static_cast<zip_uint64_t>(zip_fread(apkFile, reinterpret_cast<void *>(data.get()), stat.size)) != stat.size || ptr->canceled || !ptr->request) {
-        // Reading failed or was canceled. We already have an open file handle
-        // though, which we'll have to close.
-        notifyError(ptr, 500, zip_file_strerror(apkFile));
-        zip_fclose(apkFile);
-        apkFile = nullptr;
-        zip_close(apk);
-        apk = nullptr;
+    struct zip_file *apkFile = zip_fopen_index(apk, stat.index, 0);
+    if (apkFile == nullptr) {
+        const std::string message = zip_strerror(apk);
+        lock.unlock();
+        notifyError(ptr, 500, message.c_str());
         cleanup(ptr);
         return;
     }
 
-    std::string body(data.get(), stat.size);
-    notifySuccess(ptr, body);
+    // Read straight into the string that becomes the response body.
+    std::string body(stat.size, '\0');
+    const bool success = static_cast<zip_uint64_t>(zip_fread(apkFile, &body[0], stat.size)) == stat.size;
+    const std::string message = success ? "" : zip_file_strerror(apkFile);
 
     if (zip_fclose(apkFile) != 0) {
         // Closing the asset failed. But there isn't anything we can do.
     }
     apkFile = nullptr;
+    lock.unlock();
 
-    if (zip_close(apk) != 0) {
-        // Closing the APK failed. But there isn't anything we can do.
+    // The archive stays open for subsequent requests.
+    if (!success) {
+        notifyError(ptr, 500, message.c_str());
+    } else {
+        notifySuccess(ptr, std::move(body));
     }
-    apk = nullptr;
 
     cleanup(ptr);
 }
@@ -0,0 +1,59 @@
+#include <mbgl/platform/android/trace_android.hpp>
+
+#include <dlfcn.h>
+
+namespace mbgl {
+
+AndroidTraceBackend::AndroidTraceBackend() {
+    library = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+    if (!library) {
+        return;
+    }
+
+    beginSection = reinterpret_cast<void (*)(const char *)>(dlsym(library, "ATrace_beginSection"));
+    endSection = reinterpret_cast<void (*)()>(dlsym(library, "ATrace_endSection"));
+    if (!beginSection || !endSection) {
+        beginSection = nullptr;
+        endSection = nullptr;
+    }
+
+    beginAsyncSection = reinterpret_cast<void (*)(const char *, int32_t)>(dlsym(library, "ATrace_beginAsyncSection"));
+    endAsyncSection = reinterpret_cast<void (*)(const char *, int32_t)>(dlsym(library, "ATrace_endAsyncSection"));
+    if (!beginAsyncSection || !endAsyncSection) {
+        beginAsyncSection = nullptr;
+        endAsyncSection = nullptr;
+    }
+}
+
+AndroidTraceBackend::~AndroidTraceBackend() {
+    if (library) {
+        dlclose(library);
+    }
+}
+
+void AndroidTraceBackend::begin(const char *name) {
+    if (beginSection) {
+        beginSection(name);
+    }
+}
+
+void AndroidTraceBackend::end() {
+    if (endSection) {
+        endSection();
+    }
+}
+
+// ATrace cookies are 32 bits wide; folding the halves keeps pointers apart well enough.
+void AndroidTraceBackend::beginAsync(const char *name, uint64_t cookie) {
+    if (beginAsyncSection) {
+        beginAsyncSection(name, int32_t(cookie ^ (cookie >> 32)));
+    }
+}
+
+void AndroidTraceBackend::endAsync(const char *name, uint64_t cookie) {
+    if (endAsyncSection) {
+        endAsyncSection(name, int32_t(cookie ^ (cookie >> 32)));
+    }
+}
+
+}
@@ -1,4 +1,5 @@
 #include <mbgl/storage/http_request_baton.hpp>
+#include <mbgl/storage/request.hpp>
 #include <mbgl/util/std.hpp>
 #include <mbgl/util/parsedate.h>
 #include <mbgl/util/time.hpp>
@@ -10,6 +11,78 @@
 
 #import <Foundation/Foundation.h>
 
+#include <mutex>
+#include <unordered_map>
+
+namespace mbgl {
+void completeRequest(const util::ptr<HTTPRequestBaton> &baton, NSData *data, NSURLResponse *res, NSError *error);
+}
+
+// Background sessions don't take completion handlers, so their download tasks report here.
+@interface MBGLBackgroundSessionDelegate : NSObject <NSURLSessionDownloadDelegate>
+@end
+
+namespace mbgl {
+
+// Offline downloads go through the background session once an identifier is set, so that they
+// continue while the app is suspended. Tasks are matched to their batons by their identifier.
+std::string backgroundIdentifier;
+NSURLSession *backgroundSession = nullptr;
+std::mutex backgroundMutex;
+std::unordered_map<NSUInteger, util::ptr<HTTPRequestBaton>> backgroundBatons;
+std::unordered_map<NSUInteger, NSData *> backgroundData;
+
+void HTTPRequestBaton::setBackgroundSessionIdentifier(const std::string &identifier) {
+    // Like the session configuration, this only has an effect before the first offline request.
+    backgroundIdentifier = identifier;
+}
+
+}
+
+@implementation MBGLBackgroundSessionDelegate
+
+- (void)URLSession:(NSURLSession *)session downloadTask:(NSURLSessionDownloadTask *)task didFinishDownloadingToURL:(NSURL *)location {
+    // The file is removed once this method returns.
+    NSData *data = [NSData dataWithContentsOfURL:location];
+    if (data) {
+        std::lock_guard<std::mutex> lock(mbgl::backgroundMutex);
+        mbgl::backgroundData[task.taskIdentifier] = data;
+    }
+}
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didCompleteWithError:(NSError *)error {
+    mbgl::util::ptr<mbgl::HTTPRequestBaton> baton;
+    NSData *data = nil;
+    {
+        std::lock_guard<std::mutex> lock(mbgl::backgroundMutex);
+        auto it = mbgl::backgroundBatons.find(task.taskIdentifier);
+        if (it == mbgl::backgroundBatons.end()) {
+            // Left over from a previous launch of the app; the download requests it again.
+            return;
+        }
+        baton = it->second;
+        mbgl::backgroundBatons.erase(it);
+
+        auto data_it = mbgl::backgroundData.find(task.taskIdentifier);
+        if (data_it != mbgl::backgroundData.end()) {
+            data = data_it->second;
+            mbgl::backgroundData.erase(data_it);
+        }
+    }
+
+    mbgl::completeRequest(baton, data ? data : [NSData data], task.response, error);
+}
+
+- (void)URLSessionDidFinishEventsForBackgroundURLSession:(NSURLSession *)session {
+    // Apps call the completion handler they got in -application:handleEventsForBackgroundURLSession:
+    // completionHandler: when they receive this.
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [[NSNotificationCenter defaultCenter] postNotificationName:@"MBGLBackgroundSessionDidFinishEvents" object:nil];
+    });
+}
+
+@end
+
 namespace mbgl {
 
 dispatch_once_t request_initialize = 0;
@@ -17,6 +90,99 @@ NSURLSession *session = nullptr;
 
 NSString *userAgent = nil;
 
+// NSURLSession uses HTTP/2 automatically when the server supports it.
+unsigned maxHostConnections = 8;
+
+void HTTPRequestBaton::setMaxHostConnections(unsigned count) {
+    // The session configuration is copied when the session is created, so this only has an
+    // effect before the first request.
+    maxHostConnections = count;
+}
+
+void completeRequest(const util::ptr<HTTPRequestBaton> &baton, NSData *data, NSURLResponse *res, NSError *error) {
+    if (error) {
+        if ([error code] == NSURLErrorCancelled) {
+            // The response code remains at 0 to indicate cancelation.
+            // In addition, we don't need any response object.
+            baton->response.reset();
+            baton->type = HTTPResponseType::Canceled;
+        } else {
+            // TODO: Use different codes for host not found, timeout, invalid URL etc.
+            // These can be categorized in temporary and permanent errors.
+            baton->response = util::make_unique<Response>();
+            baton->response->code = [(NSHTTPURLResponse *)res statusCode];
+            baton->response->message = [[error localizedDescription] UTF8String];
+
+            switch ([error code]) {
+                case NSURLErrorBadServerResponse: // 5xx errors
+                    baton->type = HTTPResponseType::TemporaryError;
+                    break;
+
+                case NSURLErrorTimedOut:
+                case NSURLErrorUserCancelledAuthentication:
+                    baton->type = HTTPResponseType::SingularError; // retry immediately
+                    break;
+
+                case NSURLErrorNetworkConnectionLost:
+                case NSURLErrorCannotFindHost:
+                case NSURLErrorCannotConnectToHost:
+                case NSURLErrorDNSLookupFailed:
+                case NSURLErrorNotConnectedToInternet:
+                case NSURLErrorInternationalRoamingOff:
+                case NSURLErrorCallIsActive:
+                case NSURLErrorDataNotAllowed:
+                    baton->type = HTTPResponseType::ConnectionError;
+                    break;
+
+                default:
+                    baton->type = HTTPResponseType::PermanentError;
+            }
+        }
+    } else if ([res isKindOfClass:[NSHTTPURLResponse class]]) {
+        const long code = [(NSHTTPURLResponse *)res statusCode];
+        if (code == 304) {
+            // Assume a Response object already exists.
+            assert(baton->response);
+        } else {
+            baton->response = util::make_unique<Response>();
+            baton->response->code = code;
+            baton->response->data = std::make_shared<const std::string>((const char *)[data bytes], [data length]);
+        }
+
+        if (code == 304) {
+            baton->type = HTTPResponseType::NotModified;
+        } else if (code == 200 || code == 204) {
+            baton->type = HTTPResponseType::Successful;
+        } else {
+            baton->type = HTTPResponseType::PermanentError;
+        }
+
+        NSDictionary *headers = [(NSHTTPURLResponse *)res allHeaderFields];
+        NSString *cache_control = [headers objectForKey:@"Cache-Control"];
+        if (cache_control) {
+            baton->response->expires = Response::parseCacheControl([cache_control UTF8String]);
+        }
+
+        NSString *last_modified = [headers objectForKey:@"Last-Modified"];
+        if (last_modified) {
+            baton->response->modified = parse_date([last_modified UTF8String]);
+        }
+
+        NSString *etag = [headers objectForKey:@"ETag"];
+        if (etag) {
+            baton->response->etag = [etag UTF8String];
+        }
+    } else {
+        // This should never happen.
+        baton->type = HTTPResponseType::PermanentError;
+        baton->response = util::make_unique<Response>();
+        baton->response->code = -1;
+        baton->response->message = "response class is not NSHTTPURLResponse";
+    }
+
+    uv_async_send(baton->async);
+}
+
 void HTTPRequestBaton::start(const util::ptr<HTTPRequestBaton> &ptr) {
     assert(std::this_thread::get_id() == ptr->threadId);
 
@@ -26,7 +192,7 @@ void HTTPRequestBaton::start(const util::ptr<HTTPRequestBaton> &ptr) {
     dispatch_once(&request_initialize, ^{
         NSURLSessionConfiguration *sessionConfig = [NSURLSessionConfiguration defaultSessionConfiguration];
         sessionConfig.timeoutIntervalForResource = 30;
-        sessionConfig.HTTPMaximumConnectionsPerHost = 8;
+        sessionConfig.HTTPMaximumConnectionsPerHost = maxHostConnections;
         sessionConfig.requestCachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
         sessionConfig.URLCache = nil;
 
@@ -53,90 +219,39 @@ void HTTPRequestBaton::start(const util::ptr<HTTPRequestBaton> &ptr) {
 
     [request addValue:userAgent forHTTPHeaderField:@"User-Agent"];
 
-    NSURLSessionDataTask *task = [session dataTaskWithRequest:request
-                                            completionHandler:^(NSData *data, NSURLResponse *res, NSError *error) {
-        if (error) {
-            if ([error code] == NSURLErrorCancelled) {
-                // The response code remains at 0 to indicate cancelation.
-                // In addition, we don't need any response object.
-                baton->response.reset();
-                baton->type = HTTPResponseType::Canceled;
-            } else {
-                // TODO: Use different codes for host not found, timeout, invalid URL etc.
-                // These can be categorized in temporary and permanent errors.
-                baton->response = util::make_unique<Response>();
-                baton->response->code = [(NSHTTPURLResponse *)res statusCode];
-                baton->response->message = [[error localizedDescription] UTF8String];
-
-                switch ([error code]) {
-                    case NSURLErrorBadServerResponse: // 5xx errors
-                        baton->type = HTTPResponseType::TemporaryError;
-                        break;
-
-                    case NSURLErrorTimedOut:
-                    case NSURLErrorUserCancelledAuthentication:
-                        baton->type = HTTPResponseType::SingularError; // retry immediately
-                        break;
-
-                    case NSURLErrorNetworkConnectionLost:
-                    case NSURLErrorCannotFindHost:
-                    case NSURLErrorCannotConnectToHost:
-                    case NSURLErrorDNSLookupFailed:
-                    case NSURLErrorNotConnectedToInternet:
-                    case NSURLErrorInternationalRoamingOff:
-                    case NSURLErrorCallIsActive:
-                    case NSURLErrorDataNotAllowed:
-                        baton->type = HTTPResponseType::ConnectionError;
-                        break;
-
-                    default:
-                        baton->type = HTTPResponseType::PermanentError;
-                }
-            }
-        } else if ([res isKindOfClass:[NSHTTPURLResponse class]]) {
-            const long code = [(NSHTTPURLResponse *)res statusCode];
-            if (code == 304) {
-                // Assume a Response object already exists.
-                assert(baton->response);
-            } else {
-                baton->response = util::make_unique<Response>();
-                baton->response->code = code;
-                baton->response->data = {(const char *)[data bytes], [data length]};
-            }
+    const float priority = baton->priority;
+    NSURLSessionTask *task = nil;
+    if (priority >= OfflineRequestPriority && !backgroundIdentifier.empty()) {
+        static dispatch_once_t background_initialize = 0;
+        dispatch_once(&background_initialize, ^{
+            NSString *identifier = @(backgroundIdentifier.c_str());
+            NSURLSessionConfiguration *sessionConfig =
+                [NSURLSessionConfiguration respondsToSelector:@selector(backgroundSessionConfigurationWithIdentifier:)]
+                    ? [NSURLSessionConfiguration backgroundSessionConfigurationWithIdentifier:identifier]
+                    : [NSURLSessionConfiguration backgroundSessionConfiguration:identifier];
+            sessionConfig.HTTPMaximumConnectionsPerHost = maxHostConnections;
+            sessionConfig.requestCachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+            sessionConfig.URLCache = nil;
 
-            if (code == 304) {
-                baton->type = HTTPResponseType::NotModified;
-            } else if (code == 200) {
-                baton->type = HTTPResponseType::Successful;
-            } else {
-                baton->type = HTTPResponseType::PermanentError;
-            }
-
-            NSDictionary *headers = [(NSHTTPURLResponse *)res allHeaderFields];
-            NSString *cache_control = [headers objectForKey:@"Cache-Control"];
-            if (cache_control) {
-                baton->response->expires = Response::parseCacheControl([cache_control UTF8String]);
-            }
+            backgroundSession = [NSURLSession sessionWithConfiguration:sessionConfig
+                                                              delegate:[MBGLBackgroundSessionDelegate new]
+                                                         delegateQueue:nil];
+        });
 
-            NSString *last_modified = [headers objectForKey:@"Last-Modified"];
-            if (last_modified) {
-                baton->response->modified = parse_date([last_modified UTF8String]);
-            }
-
-            NSString *etag = [headers objectForKey:@"ETag"];
-            if (etag) {
-                baton->response->etag = [etag UTF8String];
-            }
-        } else {
-            // This should never happen.
-            baton->type = HTTPResponseType::PermanentError;
-            baton->response = util::make_unique<Response>();
-            baton->response->code = -1;
-            baton->response->message = "response class is not NSHTTPURLResponse";
-        }
+        task = [backgroundSession downloadTaskWithRequest:request];
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        backgroundBatons[task.taskIdentifier] = baton;
+    } else {
+        task = [session dataTaskWithRequest:request
+                          completionHandler:^(NSData *data, NSURLResponse *res, NSError *error) {
+            completeRequest(baton, data, res, error);
+        }];
+    }
 
-        uv_async_send(baton->async);
-    }];
+    // NSURLSession expects a value between 0 and 1 where higher goes first.
+    if ([task respondsToSelector:@selector(setPriority:)]) {
+        task.priority = 1.0f / (1.0f + (priority > 0 ? priority : 0));
+    }
 
     [task resume];
 
@@ -147,7 +262,7 @@ void HTTPRequestBaton::stop(const util::ptr<HTTPRequestBaton> &ptr) {
     assert(std::this_thread::get_id() == ptr->threadId);
     assert(ptr->ptr);
 
-    NSURLSessionDataTask *task = CFBridgingRelease(ptr->ptr);
+    NSURLSessionTask *task = CFBridgingRelease(ptr->ptr);
     ptr->ptr = nullptr;
     [task cancel];
 }
@@ -1,6 +1,9 @@
 #include <mbgl/util/image.hpp>
 #include <mbgl/util/std.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 #import <ImageIO/ImageIO.h>
 
 #if TARGET_OS_IPHONE
@@ -12,7 +15,22 @@
 namespace mbgl {
 namespace util {
 
-std::string compress_png(int width, int height, void *rgba) {
+namespace {
+
+// Encodes with ImageIO into the format of /type/. Without /alpha/, the alpha channel is skipped.
+std::string encode(int width, int height, void *rgba, bool flipY, CFStringRef type, bool alpha,
+                   CFDictionaryRef properties) {
+    // CGImage can't read rows bottom-up, so those are flipped into a copy.
+    std::unique_ptr<char[]> flipped;
+    if (flipY) {
+        const size_t stride = width * 4;
+        flipped = util::make_unique<char[]>(stride * height);
+        for (int i = 0; i < height; i++) {
+            std::memcpy(flipped.get() + stride * i, reinterpret_cast<char *>(rgba) + stride * (height - 1 - i), stride);
+        }
+        rgba = flipped.get();
+    }
+
     CGDataProviderRef provider = CGDataProviderCreateWithData(NULL, rgba, width * height * 4, NULL);
     if (!provider) {
         return "";
@@ -25,7 +43,7 @@ std::string compress_png(int width, int height, void *rgba) {
     }
 
     CGImageRef image = CGImageCreate(width, height, 8, 32, 4 * width, color_space,
-        kCGBitmapByteOrderDefault | kCGImageAlphaLast, provider, NULL, false,
+        kCGBitmapByteOrderDefault | (alpha ? kCGImageAlphaLast : kCGImageAlphaNoneSkipLast), provider, NULL, false,
         kCGRenderingIntentDefault);
     if (!image) {
         CGColorSpaceRelease(color_space);
@@ -41,7 +59,7 @@ std::string compress_png(int width, int height, void *rgba) {
         return "";
     }
 
-    CGImageDestinationRef image_destination = CGImageDestinationCreateWithData(data, kUTTypePNG, 1, NULL);
+    CGImageDestinationRef image_destination = CGImageDestinationCreateWithData(data, type, 1, NULL);
     if (!image_destination) {
         CFRelease(data);
         CGImageRelease(image);
@@ -50,7 +68,7 @@ std::string compress_png(int width, int height, void *rgba) {
         return "";
     }
 
-    CGImageDestinationAddImage(image_destination, image, NULL);
+    CGImageDestinationAddImage(image_destination, image, properties);
     CGImageDestinationFinalize(image_destination);
 
     const std::string result {
@@ -67,6 +85,30 @@ std::string compress_png(int width, int height, void *rgba) {
     return result;
 }
 
+}
+
+// ImageIO doesn't expose the zlib level, the row filters or palettes, so only flipY is used.
+std::string compress_png(int width, int height, void *rgba, const PNGOptions &options) {
+    return encode(width, height, rgba, options.flipY, kUTTypePNG, true, NULL);
+}
+
+std::string compress_png(int width, int height, void *rgba, bool flipY) {
+    return encode(width, height, rgba, flipY, kUTTypePNG, true, NULL);
+}
+
+std::string compress_jpeg(int width, int height, void *rgba, int quality, bool flipY) {
+    const float compression = std::max(0, std::min(quality, 100)) / 100.0f;
+    CFNumberRef number = CFNumberCreate(kCFAllocatorDefault, kCFNumberFloatType, &compression);
+    const void *keys[] = { kCGImageDestinationLossyCompressionQuality };
+    const void *values[] = { number };
+    CFDictionaryRef properties = CFDictionaryCreate(kCFAllocatorDefault, keys, values, 1,
+        &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    const std::string result = encode(width, height, rgba, flipY, kUTTypeJPEG, false, properties);
+    CFRelease(properties);
+    CFRelease(number);
+    return result;
+}
+
 Image::Image(const std::string &source_data) {
     CFDataRef data = CFDataCreateWithBytesNoCopy(kCFAllocatorDefault, reinterpret_cast<const unsigned char *>(source_data.data()), source_data.size(), kCFAllocatorNull);
     if (!data) {
@@ -98,8 +140,8 @@ Image::Image(const std::string &source_data) {
     height = uint32_t(CGImageGetHeight(image));
     CGRect rect = {{ 0, 0 }, { static_cast<CGFloat>(width), static_cast<CGFloat>(height) }};
 
-    img = util::make_unique<char[]>(width * height * 4);
-    CGContextRef context = CGBitmapContextCreate(img.get(), width, height, 8, width * 4,
+    img.resize(size_t(width) * height * 4);
+    CGContextRef context = CGBitmapContextCreate(&img[0], width, height, 8, width * 4,
         color_space, kCGImageAlphaPremultipliedLast);
     if (!context) {
         CGColorSpaceRelease(color_space);
@@ -108,7 +150,7 @@ Image::Image(const std::string &source_data) {
         CFRelease(data);
         width = 0;
         height = 0;
-        img.release();
+        img.clear();
         return;
     }
 
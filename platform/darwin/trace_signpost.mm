@@ -0,0 +1,76 @@
+#include <mbgl/platform/darwin/trace_signpost.hpp>
+
+#include <pthread.h>
+
+#if __has_include(<os/signpost.h>)
+#include <os/signpost.h>
+#define MBGL_HAS_SIGNPOST 1
+#endif
+
+namespace mbgl {
+
+#if MBGL_HAS_SIGNPOST
+
+namespace {
+
+API_AVAILABLE(macos(10.14), ios(12.0))
+os_log_t signpostLog() {
+    static os_log_t log = os_log_create("com.mapbox.mbgl", "PointsOfInterest");
+    return log;
+}
+
+// The depth of the open scopes of each thread. A scope is identified by its thread and depth, so
+// that begin and end agree on the signpost id without allocating anything.
+pthread_key_t depthKey;
+pthread_once_t depthKeyOnce = PTHREAD_ONCE_INIT;
+
+os_signpost_id_t scopeID(uintptr_t depth) {
+    uint64_t thread = 0;
+    pthread_threadid_np(nullptr, &thread);
+    return os_signpost_id_t(thread << 8 | (depth & 0xFF));
+}
+
+}
+
+void SignpostTraceBackend::begin(const char *name) {
+    if (@available(macOS 10.14, iOS 12.0, *)) {
+        pthread_once(&depthKeyOnce, [] { pthread_key_create(&depthKey, nullptr); });
+        const uintptr_t depth = uintptr_t(pthread_getspecific(depthKey)) + 1;
+        pthread_setspecific(depthKey, reinterpret_cast<void *>(depth));
+        os_signpost_interval_begin(signpostLog(), scopeID(depth), "mbgl", "%{public}s", name);
+    }
+}
+
+void SignpostTraceBackend::end() {
+    if (@available(macOS 10.14, iOS 12.0, *)) {
+        const uintptr_t depth = uintptr_t(pthread_getspecific(depthKey));
+        if (depth) {
+            os_signpost_interval_end(signpostLog(), scopeID(depth), "mbgl");
+            pthread_setspecific(depthKey, reinterpret_cast<void *>(depth - 1));
+        }
+    }
+}
+
+// Asynchronous intervals have a name of their own, so that their ids can't collide with scopes.
+void SignpostTraceBackend::beginAsync(const char *name, uint64_t cookie) {
+    if (@available(macOS 10.14, iOS 12.0, *)) {
+        os_signpost_interval_begin(signpostLog(), os_signpost_id_t(cookie), "mbgl async", "%{public}s", name);
+    }
+}
+
+void SignpostTraceBackend::endAsync(const char *, uint64_t cookie) {
+    if (@available(macOS 10.14, iOS 12.0, *)) {
+        os_signpost_interval_end(signpostLog(), os_signpost_id_t(cookie), "mbgl async");
+    }
+}
+
+#else
+
+void SignpostTraceBackend::begin(const char *) {}
+void SignpostTraceBackend::end() {}
+void SignpostTraceBackend::beginAsync(const char *, uint64_t) {}
+void SignpostTraceBackend::endAsync(const char *, uint64_t) {}
+
+#endif
+
+}
@@ -5,180 +5,143 @@
 
 #include <uv.h>
 
-#include <limits>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace mbgl {
 
+// Files at least this large are mapped instead of read so that the kernel can read ahead the
+// whole file while we copy it out.
+const size_t AssetMapThreshold = 64 * 1024;
+
 struct AssetRequestBaton {
     AssetRequestBaton(AssetRequest *request_, const std::string &path, uv_loop_t *loop);
-    ~AssetRequestBaton();
 
     void cancel();
-    static void fileOpened(uv_fs_t *req);
-    static void fileStated(uv_fs_t *req);
-    static void fileRead(uv_fs_t *req);
-    static void fileClosed(uv_fs_t *req);
-    static void notifyError(uv_fs_t *req);
-    static void cleanup(uv_fs_t *req);
+    static void run(uv_work_t *req);
+    static void after(uv_work_t *req, int status);
+    static int load(AssetRequestBaton &baton, int fd);
 
     const std::thread::id threadId;
     AssetRequest *request = nullptr;
-    uv_fs_t req;
-    uv_file fd = -1;
-    bool canceled = false;
+    const std::string path;
+    uv_work_t req;
+
+    // Set on the loop thread, read on the thread pool.
+    std::atomic<bool> canceled { false };
+
+    // Only touched on the thread pool until after() is called.
+    int error = 0;
     std::string body;
-    uv_buf_t buffer;
 };
 
-AssetRequestBaton::AssetRequestBaton(AssetRequest *request_, const std::string &path, uv_loop_t *loop)
-    : threadId(std::this_thread::get_id()), request(request_) {
+AssetRequestBaton::AssetRequestBaton(AssetRequest *request_, const std::string &path_, uv_loop_t *loop)
+    : threadId(std::this_thread::get_id()), request(request_), path(path_) {
     req.data = this;
-    uv_fs_open(loop, &req, path.c_str(), O_RDONLY, S_IRUSR, fileOpened);
-}
 
-AssetRequestBaton::~AssetRequestBaton() {
+    // Opening, stating, reading and closing the file all happen in a single job on the thread
+    // pool, so many assets load in parallel without bouncing back to the loop between steps.
+    uv_queue_work(loop, &req, run, after);
 }
 
 void AssetRequestBaton::cancel() {
     canceled = true;
 
-    // uv_cancel fails frequently when the request has already been started.
-    // In that case, we have to let it complete and check the canceled bool
-    // instead.
+    // uv_cancel fails when the job has already been started. In that case, we have to let it
+    // complete and check the canceled bool instead.
     uv_cancel((uv_req_t *)&req);
 }
 
-void AssetRequestBaton::notifyError(uv_fs_t *req) {
-    AssetRequestBaton *ptr = reinterpret_cast<AssetRequestBaton *>(req->data);
-    assert(std::this_thread::get_id() == ptr->threadId);
-
-    if (ptr->request && req->result < 0 && !ptr->canceled && req->result != UV_ECANCELED) {
-        ptr->request->response = util::make_unique<Response>();
-        ptr->request->response->code = req->result == UV_ENOENT ? 404 : 500;
-#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
-        ptr->request->response->message = uv_strerror(uv_last_error(req->loop));
-#else
-        ptr->request->response->message = uv_strerror(int(req->result));
-#endif
-        ptr->request->notify();
+void AssetRequestBaton::run(uv_work_t *req) {
+    AssetRequestBaton &baton = *reinterpret_cast<AssetRequestBaton *>(req->data);
+    if (baton.canceled) {
+        return;
     }
-}
 
-void AssetRequestBaton::fileOpened(uv_fs_t *req) {
-    AssetRequestBaton *ptr = reinterpret_cast<AssetRequestBaton *>(req->data);
-    assert(std::this_thread::get_id() == ptr->threadId);
+    int fd;
+    do {
+        fd = open(baton.path.c_str(), O_RDONLY);
+    } while (fd < 0 && errno == EINTR);
 
-    if (req->result < 0) {
-        // Opening failed or was canceled. There isn't much left we can do.
-        notifyError(req);
-        cleanup(req);
-    } else {
-        const uv_file fd = uv_file(req->result);
-
-        // We're going to reuse this handle, so we need to cleanup first.
-        uv_fs_req_cleanup(req);
-
-        if (ptr->canceled || !ptr->request) {
-            // Either the AssetRequest object has been destructed, or the
-            // request was canceled.
-            uv_fs_close(req->loop, req, fd, fileClosed);
-        } else {
-            ptr->fd = fd;
-            uv_fs_fstat(req->loop, req, fd, fileStated);
-        }
+    if (fd < 0) {
+        baton.error = errno;
+        return;
     }
-}
-
-void AssetRequestBaton::fileStated(uv_fs_t *req) {
-    AssetRequestBaton *ptr = reinterpret_cast<AssetRequestBaton *>(req->data);
-    assert(std::this_thread::get_id() == ptr->threadId);
-
-    if (req->result != 0 || ptr->canceled || !ptr->request) {
-        // Stating failed or was canceled. We already have an open file handle
-        // though, which we'll have to close.
-        notifyError(req);
 
-        uv_fs_req_cleanup(req);
-        uv_fs_close(req->loop, req, ptr->fd, fileClosed);
-    } else {
-#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
-        const uv_statbuf_t *stat = static_cast<const uv_statbuf_t *>(req->ptr);
-#else
-        const uv_stat_t *stat = static_cast<const uv_stat_t *>(req->ptr);
-#endif
-        if (stat->st_size > std::numeric_limits<int>::max()) {
-            // File is too large for us to open this way because uv_buf's only support unsigned
-            // ints as maximum size.
-            if (ptr->request) {
-                ptr->request->response = util::make_unique<Response>();
-                ptr->request->response->code = UV_EFBIG;
-#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
-                ptr->request->response->message = uv_strerror(uv_err_t {UV_EFBIG, 0});
-#else
-                ptr->request->response->message = uv_strerror(UV_EFBIG);
-#endif
-                ptr->request->notify();
-            }
-
-            uv_fs_req_cleanup(req);
-            uv_fs_close(req->loop, req, ptr->fd, fileClosed);
-        } else {
-            const unsigned int size = (unsigned int)(stat->st_size);
-            ptr->body.resize(size);
-            ptr->buffer = uv_buf_init(const_cast<char *>(ptr->body.data()), size);
-            uv_fs_req_cleanup(req);
-#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
-            uv_fs_read(req->loop, req, ptr->fd, ptr->buffer.base, ptr->buffer.len, -1, fileRead);
-#else
-            uv_fs_read(req->loop, req, ptr->fd, &ptr->buffer, 1, 0, fileRead);
-#endif
-        }
+    baton.error = load(baton, fd);
+    if (close(fd) != 0) {
+        // Closing the file failed. But there isn't anything we can do.
     }
 }
 
-void AssetRequestBaton::fileRead(uv_fs_t *req) {
-    AssetRequestBaton *ptr = reinterpret_cast<AssetRequestBaton *>(req->data);
-    assert(std::this_thread::get_id() == ptr->threadId);
-
-    if (req->result < 0 || ptr->canceled || !ptr->request) {
-        // Reading failed or was canceled. We already have an open file handle
-        // though, which we'll have to close.
-        notifyError(req);
-    } else {
-        // File was successfully read.
-        if (ptr->request) {
-            ptr->request->response = util::make_unique<Response>();
-            ptr->request->response->code = 200;
-            ptr->request->response->data = std::move(ptr->body);
-            ptr->request->notify();
-        }
+int AssetRequestBaton::load(AssetRequestBaton &baton, int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return errno;
     }
 
-    uv_fs_req_cleanup(req);
-    uv_fs_close(req->loop, req, ptr->fd, fileClosed);
-}
+    if (baton.canceled) {
+        return ECANCELED;
+    }
 
-void AssetRequestBaton::fileClosed(uv_fs_t *req) {
-    assert(std::this_thread::get_id() == (reinterpret_cast<AssetRequestBaton *>(req->data))->threadId);
+    const size_t size = size_t(st.st_size);
+    if (S_ISREG(st.st_mode) && size >= AssetMapThreshold) {
+        void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            madvise(addr, size, MADV_SEQUENTIAL);
+            baton.body.assign(reinterpret_cast<const char *>(addr), size);
+            munmap(addr, size);
+            return 0;
+        }
+        // Some file systems can't be mapped; fall back to reading the file.
+    }
 
-    if (req->result < 0) {
-        // Closing the file failed. But there isn't anything we can do.
+    baton.body.resize(size);
+    size_t offset = 0;
+    while (offset < size) {
+        const ssize_t result = read(fd, &baton.body[offset], size - offset);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        } else if (result == 0) {
+            // The file was truncated while we were reading it.
+            baton.body.resize(offset);
+            break;
+        }
+        offset += size_t(result);
     }
 
-    cleanup(req);
+    return 0;
 }
 
-void AssetRequestBaton::cleanup(uv_fs_t *req) {
-    AssetRequestBaton *ptr = reinterpret_cast<AssetRequestBaton *>(req->data);
+void AssetRequestBaton::after(uv_work_t *req, int) {
+    std::unique_ptr<AssetRequestBaton> ptr { reinterpret_cast<AssetRequestBaton *>(req->data) };
     assert(std::this_thread::get_id() == ptr->threadId);
 
-    if (ptr->request) {
-        ptr->request->ptr = nullptr;
+    AssetRequest *request = ptr->request;
+    if (!request || ptr->canceled) {
+        // Either the AssetRequest object has been destructed, or the request was canceled.
+        return;
     }
 
-    uv_fs_req_cleanup(req);
-    delete ptr;
-    ptr = nullptr;
+    request->ptr = nullptr;
+    request->response = util::make_unique<Response>();
+    if (ptr->error) {
+        request->response->code = ptr->error == ENOENT ? 404 : 500;
+        request->response->message = std::strerror(ptr->error);
+    } else {
+        request->response->code = 200;
+        request->response->data = std::make_shared<const std::string>(std::move(ptr->body));
+    }
+    request->notify();
 }
 
 
@@ -193,7 +156,7 @@ AssetRequest::AssetRequest(const std::string &path_, uv_loop_t *loop)
         response->message = "Path is outside the application bundle";
         notify();
     } else {
-        // Note: The AssetRequestBaton object is deleted in AssetRequestBaton::cleanup().
+        // Note: The AssetRequestBaton object is deleted in AssetRequestBaton::after().
         ptr = new AssetRequestBaton(this, platform::applicationRoot() + "/" + path, loop);
     }
 }
@@ -204,7 +167,7 @@ void AssetRequest::cancel() {
     if (ptr) {
         ptr->cancel();
 
-        // When deleting a AssetRequest object with a uv_fs_* call is in progress, we are making sure
+        // When deleting a AssetRequest object while the file is being loaded, we are making sure
         // that the callback doesn't accidentally reference this object again.
         ptr->request = nullptr;
         ptr = nullptr;
@@ -217,7 +180,7 @@ AssetRequest::~AssetRequest() {
     assert(std::this_thread::get_id() == threadId);
     cancel();
 
-    // Note: The AssetRequestBaton object is deleted in AssetRequestBaton::cleanup().
+    // Note: The AssetRequestBaton object is deleted in AssetRequestBaton::after().
 }
 
 }
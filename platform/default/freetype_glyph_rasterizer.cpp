@@ -0,0 +1,86 @@
+#include <mbgl/platform/default/freetype_glyph_rasterizer.hpp>
+#include <mbgl/platform/log.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_SYNTHESIS_H
+
+namespace mbgl {
+
+namespace {
+
+// Glyph PBFs are drawn at the same size.
+const FT_UInt pixelsPerEm = 24;
+
+}
+
+struct FreeTypeGlyphRasterizer::Impl {
+    FT_Library library = nullptr;
+    std::vector<FT_Face> faces;
+};
+
+FreeTypeGlyphRasterizer::FreeTypeGlyphRasterizer(const std::vector<std::string> &fontFiles)
+    : impl(util::make_unique<Impl>()) {
+    if (FT_Init_FreeType(&impl->library)) {
+        Log::Error(Event::General, "Couldn't initialize FreeType");
+        impl->library = nullptr;
+        return;
+    }
+
+    for (const std::string &file : fontFiles) {
+        FT_Face face = nullptr;
+        if (FT_New_Face(impl->library, file.c_str(), 0, &face) ||
+            FT_Set_Pixel_Sizes(face, 0, pixelsPerEm)) {
+            Log::Warning(Event::General, "Couldn't load font %s", file.c_str());
+            if (face) {
+                FT_Done_Face(face);
+            }
+            continue;
+        }
+        impl->faces.push_back(face);
+    }
+}
+
+FreeTypeGlyphRasterizer::~FreeTypeGlyphRasterizer() {
+    for (FT_Face face : impl->faces) {
+        FT_Done_Face(face);
+    }
+    if (impl->library) {
+        FT_Done_FreeType(impl->library);
+    }
+}
+
+bool FreeTypeGlyphRasterizer::rasterize(const std::string &fontStack, char32_t glyph, GlyphBitmap &bitmap) {
+    for (FT_Face face : impl->faces) {
+        const FT_UInt index = FT_Get_Char_Index(face, glyph);
+        if (!index || FT_Load_Glyph(face, index, FT_LOAD_DEFAULT)) {
+            continue;
+        }
+
+        FT_GlyphSlot slot = face->glyph;
+        if (fontStack.find("Bold") != std::string::npos) {
+            FT_GlyphSlot_Embolden(slot);
+        }
+        if (FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL)) {
+            continue;
+        }
+
+        const FT_Bitmap &source = slot->bitmap;
+        bitmap.width = source.width;
+        bitmap.height = source.rows;
+        bitmap.coverage.resize(bitmap.width * bitmap.height);
+        for (uint32_t y = 0; y < bitmap.height; y++) {
+            const unsigned char *row = source.buffer + int32_t(y) * source.pitch;
+            std::copy(row, row + bitmap.width, &bitmap.coverage[y * bitmap.width]);
+        }
+
+        bitmap.left = slot->bitmap_left;
+        bitmap.top = slot->bitmap_top - int32_t(face->size->metrics.ascender >> 6);
+        bitmap.advance = uint32_t(slot->advance.x >> 6);
+        return true;
+    }
+    return false;
+}
+
+}
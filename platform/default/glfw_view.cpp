@@ -149,9 +149,51 @@ void GLFWView::initialize(mbgl::Map *map_) {
             assert(gl::IsVertexArray != nullptr);
         }
 
+        if (extensions.find("GL_ARB_instanced_arrays") != std::string::npos) {
+            gl::VertexAttribDivisor = reinterpret_cast<gl::PFNGLVERTEXATTRIBDIVISORPROC>(glfwGetProcAddress("glVertexAttribDivisorARB"));
+            gl::DrawArraysInstanced = reinterpret_cast<gl::PFNGLDRAWARRAYSINSTANCEDPROC>(glfwGetProcAddress("glDrawArraysInstancedARB"));
+            assert(gl::VertexAttribDivisor != nullptr);
+            assert(gl::DrawArraysInstanced != nullptr);
+        }
+
+        if (extensions.find("GL_ARB_get_program_binary") != std::string::npos) {
+            gl::GetProgramBinary = reinterpret_cast<gl::PFNGLGETPROGRAMBINARYPROC>(glfwGetProcAddress("glGetProgramBinary"));
+            gl::ProgramBinary = reinterpret_cast<gl::PFNGLPROGRAMBINARYPROC>(glfwGetProcAddress("glProgramBinary"));
+            gl::ProgramParameteri = reinterpret_cast<gl::PFNGLPROGRAMPARAMETERIPROC>(glfwGetProcAddress("glProgramParameteri"));
+            assert(gl::GetProgramBinary != nullptr);
+            assert(gl::ProgramBinary != nullptr);
+            assert(gl::ProgramParameteri != nullptr);
+        }
+
+        if (extensions.find("GL_ARB_timer_query") != std::string::npos) {
+            gl::GenQueries = reinterpret_cast<gl::PFNGLGENQUERIESPROC>(glfwGetProcAddress("glGenQueries"));
+            gl::DeleteQueries = reinterpret_cast<gl::PFNGLDELETEQUERIESPROC>(glfwGetProcAddress("glDeleteQueries"));
+            gl::BeginQuery = reinterpret_cast<gl::PFNGLBEGINQUERYPROC>(glfwGetProcAddress("glBeginQuery"));
+            gl::EndQuery = reinterpret_cast<gl::PFNGLENDQUERYPROC>(glfwGetProcAddress("glEndQuery"));
+            gl::GetQueryObjectuiv = reinterpret_cast<gl::PFNGLGETQUERYOBJECTUIVPROC>(glfwGetProcAddress("glGetQueryObjectuiv"));
+            gl::GetQueryObjectui64v = reinterpret_cast<gl::PFNGLGETQUERYOBJECTUI64VPROC>(glfwGetProcAddress("glGetQueryObjectui64v"));
+            assert(gl::isTimerQuerySupported());
+            gl::isSamplesQuerySupported = true;
+        }
+
+        if (extensions.find("GL_ARB_pixel_buffer_object") != std::string::npos &&
+            extensions.find("GL_ARB_map_buffer_range") != std::string::npos) {
+            gl::MapBufferRange = reinterpret_cast<gl::PFNGLMAPBUFFERRANGEPROC>(glfwGetProcAddress("glMapBufferRange"));
+            gl::UnmapBuffer = reinterpret_cast<gl::PFNGLUNMAPBUFFERPROC>(glfwGetProcAddress("glUnmapBuffer"));
+            assert(gl::isPixelBufferObjectSupported());
+        }
+
+        if (extensions.find("GL_EXT_texture_filter_anisotropic") != std::string::npos) {
+            MBGL_CHECK_ERROR(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &gl::maxTextureAnisotropy));
+        }
+
+        gl::detectCompressedTextureSupport(extensions);
+
         // Require packed depth stencil
         gl::isPackedDepthStencilSupported = true;
         gl::isDepth24Supported = true;
+
+        gl::isElementIndexUintSupported = true;
     }
 
     glfwMakeContextCurrent(nullptr);
@@ -2,10 +2,18 @@
 
 #include <cstring>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace mbgl {
 
-HeadlessDisplay::HeadlessDisplay() {
+HeadlessDisplay::HeadlessDisplay(int device) {
+#if !MBGL_USE_EGL
+    if (device > 0) {
+        throw std::runtime_error("Choosing a GPU requires the EGL backend.");
+    }
+#endif
+
 #if MBGL_USE_CGL
     // TODO: test if OpenGL 4.1 with GL_ARB_ES2_compatibility is supported
     // If it is, use kCGLOGLPVersion_3_2_Core and enable that extension.
@@ -64,6 +72,58 @@ HeadlessDisplay::HeadlessDisplay() {
         throw std::runtime_error("No Framebuffer configurations.");
     }
 #endif
+
+#if MBGL_USE_EGL
+    if (device < 0) {
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    } else {
+        // Opens the GPU directly, without any window system.
+        const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (!clientExtensions || !strstr(clientExtensions, "EGL_EXT_platform_device")) {
+            throw std::runtime_error("Extension EGL_EXT_platform_device was not found.");
+        }
+        auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (!queryDevices || !getPlatformDisplay) {
+            throw std::runtime_error("Cannot find eglQueryDevicesEXT.");
+        }
+
+        EGLint count = 0;
+        if (!queryDevices(0, nullptr, &count) || device >= count) {
+            throw std::runtime_error("GPU " + std::to_string(device) + " not found; there are " +
+                                     std::to_string(count) + ".");
+        }
+        std::vector<EGLDeviceEXT> devices(count);
+        queryDevices(count, devices.data(), &count);
+        eglDisplay = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[device], nullptr);
+    }
+    if (eglDisplay == EGL_NO_DISPLAY) {
+        throw std::runtime_error("Failed to open EGL display.");
+    }
+
+    EGLint major = 0, minor = 0;
+    if (!eglInitialize(eglDisplay, &major, &minor)) {
+        throw std::runtime_error("Failed to eglInitialize.");
+    }
+
+    const char *extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+    surfaceless = extensions && strstr(extensions, "EGL_KHR_surfaceless_context");
+
+    // Without surfaceless contexts, we need a dummy pbuffer like with GLX.
+    const EGLint attributes[] = {
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+
+    EGLint configs = 0;
+    if (!eglChooseConfig(eglDisplay, attributes, &eglConfig, 1, &configs)) {
+        throw std::runtime_error("Failed to eglChooseConfig.");
+    }
+    if (configs <= 0) {
+        throw std::runtime_error("No EGL configurations for OpenGL.");
+    }
+#endif
 }
 
 HeadlessDisplay::~HeadlessDisplay() {
@@ -75,6 +135,12 @@ HeadlessDisplay::~HeadlessDisplay() {
     XFree(fbConfigs);
     XCloseDisplay(xDisplay);
 #endif
+
+#if MBGL_USE_EGL
+    // EGL returns the same display for every HeadlessDisplay of a GPU, so this ends the
+    // contexts of all of them.
+    eglTerminate(eglDisplay);
+#endif
 }
 
 }
@@ -3,6 +3,7 @@
 #include <mbgl/platform/log.hpp>
 
 #include <mbgl/util/std.hpp>
+#include <mbgl/util/image_kernels.hpp>
 
 #include <stdexcept>
 #include <sstream>
@@ -30,6 +31,17 @@ CGLProc CGLGetProcAddress(const char *proc) {
 }
 #endif
 
+#if MBGL_USE_GLX || MBGL_USE_EGL
+typedef void (* GLProc)(void);
+static GLProc getProcAddress(const char *proc) {
+#if MBGL_USE_GLX
+    return glXGetProcAddress(reinterpret_cast<const GLubyte *>(proc));
+#else
+    return eglGetProcAddress(proc);
+#endif
+}
+#endif
+
 namespace mbgl {
 
 
@@ -45,6 +57,13 @@ HeadlessView::HeadlessView(std::shared_ptr<HeadlessDisplay> display)
     loadExtensions();
 }
 
+HeadlessView::HeadlessView(std::shared_ptr<HeadlessDisplay> display, const HeadlessView &share)
+    : display_(display) {
+    assert(display_ == share.display_);
+    createContext(&share);
+    loadExtensions();
+}
+
 void HeadlessView::loadExtensions() {
     activate();
     const char *extensionPtr = reinterpret_cast<const char *>(MBGL_CHECK_ERROR(glGetString(GL_EXTENSIONS)));
@@ -63,31 +82,75 @@ void HeadlessView::loadExtensions() {
             assert(gl::GenVertexArrays != nullptr);
             assert(gl::IsVertexArray != nullptr);
         }
+        if (extensions.find("GL_ARB_instanced_arrays") != std::string::npos) {
+            gl::VertexAttribDivisor = reinterpret_cast<gl::PFNGLVERTEXATTRIBDIVISORPROC>(CGLGetProcAddress("glVertexAttribDivisorARB"));
+            gl::DrawArraysInstanced = reinterpret_cast<gl::PFNGLDRAWARRAYSINSTANCEDPROC>(CGLGetProcAddress("glDrawArraysInstancedARB"));
+            assert(gl::VertexAttribDivisor != nullptr);
+            assert(gl::DrawArraysInstanced != nullptr);
+        }
 #endif
-#ifdef MBGL_USE_GLX
+#if MBGL_USE_GLX || MBGL_USE_EGL
         if (extensions.find("GL_ARB_vertex_array_object") != std::string::npos) {
-            gl::BindVertexArray = reinterpret_cast<gl::PFNGLBINDVERTEXARRAYPROC>(glXGetProcAddress((const GLubyte *)"glBindVertexArray"));
-            gl::DeleteVertexArrays = reinterpret_cast<gl::PFNGLDELETEVERTEXARRAYSPROC>(glXGetProcAddress((const GLubyte *)"glDeleteVertexArrays"));
-            gl::GenVertexArrays = reinterpret_cast<gl::PFNGLGENVERTEXARRAYSPROC>(glXGetProcAddress((const GLubyte *)"glGenVertexArrays"));
-            gl::IsVertexArray = reinterpret_cast<gl::PFNGLISVERTEXARRAYPROC>(glXGetProcAddress((const GLubyte *)"glIsVertexArray"));
+            gl::BindVertexArray = reinterpret_cast<gl::PFNGLBINDVERTEXARRAYPROC>(getProcAddress("glBindVertexArray"));
+            gl::DeleteVertexArrays = reinterpret_cast<gl::PFNGLDELETEVERTEXARRAYSPROC>(getProcAddress("glDeleteVertexArrays"));
+            gl::GenVertexArrays = reinterpret_cast<gl::PFNGLGENVERTEXARRAYSPROC>(getProcAddress("glGenVertexArrays"));
+            gl::IsVertexArray = reinterpret_cast<gl::PFNGLISVERTEXARRAYPROC>(getProcAddress("glIsVertexArray"));
             assert(gl::BindVertexArray != nullptr);
             assert(gl::DeleteVertexArrays != nullptr);
             assert(gl::GenVertexArrays != nullptr);
             assert(gl::IsVertexArray != nullptr);
         }
+        if (extensions.find("GL_ARB_instanced_arrays") != std::string::npos) {
+            gl::VertexAttribDivisor = reinterpret_cast<gl::PFNGLVERTEXATTRIBDIVISORPROC>(getProcAddress("glVertexAttribDivisorARB"));
+            gl::DrawArraysInstanced = reinterpret_cast<gl::PFNGLDRAWARRAYSINSTANCEDPROC>(getProcAddress("glDrawArraysInstancedARB"));
+            assert(gl::VertexAttribDivisor != nullptr);
+            assert(gl::DrawArraysInstanced != nullptr);
+        }
+        if (extensions.find("GL_ARB_get_program_binary") != std::string::npos) {
+            gl::GetProgramBinary = reinterpret_cast<gl::PFNGLGETPROGRAMBINARYPROC>(getProcAddress("glGetProgramBinary"));
+            gl::ProgramBinary = reinterpret_cast<gl::PFNGLPROGRAMBINARYPROC>(getProcAddress("glProgramBinary"));
+            gl::ProgramParameteri = reinterpret_cast<gl::PFNGLPROGRAMPARAMETERIPROC>(getProcAddress("glProgramParameteri"));
+            assert(gl::GetProgramBinary != nullptr);
+            assert(gl::ProgramBinary != nullptr);
+            assert(gl::ProgramParameteri != nullptr);
+        }
+        if (extensions.find("GL_ARB_timer_query") != std::string::npos) {
+            gl::GenQueries = reinterpret_cast<gl::PFNGLGENQUERIESPROC>(getProcAddress("glGenQueries"));
+            gl::DeleteQueries = reinterpret_cast<gl::PFNGLDELETEQUERIESPROC>(getProcAddress("glDeleteQueries"));
+            gl::BeginQuery = reinterpret_cast<gl::PFNGLBEGINQUERYPROC>(getProcAddress("glBeginQuery"));
+            gl::EndQuery = reinterpret_cast<gl::PFNGLENDQUERYPROC>(getProcAddress("glEndQuery"));
+            gl::GetQueryObjectuiv = reinterpret_cast<gl::PFNGLGETQUERYOBJECTUIVPROC>(getProcAddress("glGetQueryObjectuiv"));
+            gl::GetQueryObjectui64v = reinterpret_cast<gl::PFNGLGETQUERYOBJECTUI64VPROC>(getProcAddress("glGetQueryObjectui64v"));
+            assert(gl::isTimerQuerySupported());
+            gl::isSamplesQuerySupported = true;
+        }
+        if (extensions.find("GL_ARB_pixel_buffer_object") != std::string::npos &&
+            extensions.find("GL_ARB_map_buffer_range") != std::string::npos) {
+            gl::MapBufferRange = reinterpret_cast<gl::PFNGLMAPBUFFERRANGEPROC>(getProcAddress("glMapBufferRange"));
+            gl::UnmapBuffer = reinterpret_cast<gl::PFNGLUNMAPBUFFERPROC>(getProcAddress("glUnmapBuffer"));
+            assert(gl::isPixelBufferObjectSupported());
+        }
+        if (extensions.find("GL_EXT_texture_filter_anisotropic") != std::string::npos) {
+            MBGL_CHECK_ERROR(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &gl::maxTextureAnisotropy));
+        }
 #endif
+
+        gl::detectCompressedTextureSupport(extensions);
+        pixelBufferObjects = extensions.find("GL_ARB_pixel_buffer_object") != std::string::npos;
     }
 
     // HeadlessView requires packed depth stencil
     gl::isPackedDepthStencilSupported = true;
     gl::isDepth24Supported = true;
 
+    gl::isElementIndexUintSupported = true;
+
     deactivate();
 }
 
-void HeadlessView::createContext() {
+void HeadlessView::createContext(const HeadlessView *share) {
 #if MBGL_USE_CGL
-    CGLError error = CGLCreateContext(display_->pixelFormat, NULL, &glContext);
+    CGLError error = CGLCreateContext(display_->pixelFormat, share ? share->glContext : NULL, &glContext);
     if (error != kCGLNoError) {
         throw std::runtime_error(std::string("Error creating GL context object:") + CGLErrorString(error) + "\n");
     }
@@ -104,7 +167,7 @@ void HeadlessView::createContext() {
 
     if (!glContext) {
         // Try to create a legacy context
-        glContext = glXCreateNewContext(xDisplay, fbConfigs[0], GLX_RGBA_TYPE, 0, True);
+        glContext = glXCreateNewContext(xDisplay, fbConfigs[0], GLX_RGBA_TYPE, share ? share->glContext : 0, True);
         if (glContext) {
             if (!glXIsDirect(xDisplay, glContext)) {
                 mbgl::Log::Error(mbgl::Event::OpenGL, "Failed to create direct OpenGL Legacy context");
@@ -127,6 +190,32 @@ void HeadlessView::createContext() {
     };
     glxPbuffer = glXCreatePbuffer(xDisplay, fbConfigs[0], pbufferAttributes);
 #endif
+
+#if MBGL_USE_EGL
+    eglDisplay = display_->eglDisplay;
+
+    // The API is bound per thread.
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        throw std::runtime_error("Failed to bind the OpenGL API.");
+    }
+
+    glContext = eglCreateContext(eglDisplay, display_->eglConfig, share ? share->glContext : EGL_NO_CONTEXT, nullptr);
+    if (glContext == EGL_NO_CONTEXT) {
+        throw std::runtime_error("Error creating GL context object.");
+    }
+
+    if (!display_->surfaceless) {
+        const EGLint pbufferAttributes[] = {
+            EGL_WIDTH, 8,
+            EGL_HEIGHT, 8,
+            EGL_NONE
+        };
+        eglSurface = eglCreatePbufferSurface(eglDisplay, display_->eglConfig, pbufferAttributes);
+        if (eglSurface == EGL_NO_SURFACE) {
+            throw std::runtime_error("Failed to create EGL pbuffer.");
+        }
+    }
+#endif
 }
 
 void HeadlessView::resize(uint16_t width, uint16_t height, float pixelRatio) {
@@ -185,24 +274,88 @@ std::unique_ptr<uint32_t[]> HeadlessView::readPixels() {
     auto pixels = util::make_unique<uint32_t[]>(w * h);
 
     activate();
-    MBGL_CHECK_ERROR(glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, pixels.get()));
+    MBGL_CHECK_ERROR(glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.get()));
     deactivate();
 
-    const int stride = w * 4;
-    auto tmp = util::make_unique<char[]>(stride);
-    char *rgba = reinterpret_cast<char *>(pixels.get());
-    for (int i = 0, j = height_ - 1; i < j; i++, j--) {
-        std::memcpy(tmp.get(), rgba + i * stride, stride);
-        std::memcpy(rgba + i * stride, rgba + j * stride, stride);
-        std::memcpy(rgba + j * stride, tmp.get(), stride);
-    }
+    util::flipRows(pixels.get(), w, h);
 
     return pixels;
 }
 
+void HeadlessView::startReadPixels() {
+    if (readCount == maxPendingReads) {
+        throw std::runtime_error("Too many pixel reads pending.");
+    }
+
+    const unsigned int w = width_ * pixelRatio_;
+    const unsigned int h = height_ * pixelRatio_;
+    const size_t slot = (firstRead + readCount) % maxPendingReads;
+
+    activate();
+    if (pixelBufferObjects) {
+        // The read goes into the buffer object and returns right away; mapping the buffer later
+        // only waits if the GPU didn't finish the frame by then.
+        if (!pixelBuffers[slot]) {
+            MBGL_CHECK_ERROR(glGenBuffers(1, &pixelBuffers[slot]));
+            MBGL_CHECK_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, pixelBuffers[slot]));
+            MBGL_CHECK_ERROR(glBufferData(GL_PIXEL_PACK_BUFFER_ARB, w * h * 4, nullptr, GL_STREAM_READ));
+        } else {
+            MBGL_CHECK_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, pixelBuffers[slot]));
+        }
+        MBGL_CHECK_ERROR(glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+        MBGL_CHECK_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0));
+    } else {
+        if (!readBuffers[slot]) {
+            readBuffers[slot] = util::make_unique<uint32_t[]>(w * h);
+        }
+        MBGL_CHECK_ERROR(glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, readBuffers[slot].get()));
+    }
+    deactivate();
+
+    readCount++;
+}
+
+void HeadlessView::finishReadPixels(uint32_t *pixels) {
+    if (!readCount) {
+        throw std::runtime_error("No pixel read pending.");
+    }
+
+    const unsigned int w = width_ * pixelRatio_;
+    const unsigned int h = height_ * pixelRatio_;
+    const size_t bytes = w * h * 4;
+    const size_t slot = firstRead;
+
+    if (pixelBufferObjects) {
+        activate();
+        MBGL_CHECK_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, pixelBuffers[slot]));
+        const void *data = MBGL_CHECK_ERROR(glMapBuffer(GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY));
+        if (data) {
+            std::memcpy(pixels, data, bytes);
+        }
+        MBGL_CHECK_ERROR(glUnmapBuffer(GL_PIXEL_PACK_BUFFER_ARB));
+        MBGL_CHECK_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0));
+        deactivate();
+    } else {
+        std::memcpy(pixels, readBuffers[slot].get(), bytes);
+    }
+
+    firstRead = (firstRead + 1) % maxPendingReads;
+    readCount--;
+}
+
 void HeadlessView::clearBuffers() {
     activate();
 
+    for (size_t i = 0; i < maxPendingReads; i++) {
+        if (pixelBuffers[i]) {
+            MBGL_CHECK_ERROR(glDeleteBuffers(1, &pixelBuffers[i]));
+            pixelBuffers[i] = 0;
+        }
+        readBuffers[i].reset();
+    }
+    firstRead = 0;
+    readCount = 0;
+
     MBGL_CHECK_ERROR(glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0));
 
     if (fbo) {
@@ -238,6 +391,15 @@ HeadlessView::~HeadlessView() {
 
     glXDestroyContext(xDisplay, glContext);
 #endif
+
+#if MBGL_USE_EGL
+    if (eglSurface != EGL_NO_SURFACE) {
+        eglDestroySurface(eglDisplay, eglSurface);
+        eglSurface = EGL_NO_SURFACE;
+    }
+
+    eglDestroyContext(eglDisplay, glContext);
+#endif
 }
 
 void HeadlessView::notify() {
@@ -261,6 +423,12 @@ void HeadlessView::activate() {
         throw std::runtime_error("Switching OpenGL context failed.\n");
     }
 #endif
+
+#if MBGL_USE_EGL
+    if (!eglMakeCurrent(eglDisplay, eglSurface, eglSurface, glContext)) {
+        throw std::runtime_error("Switching OpenGL context failed.\n");
+    }
+#endif
 }
 
 void HeadlessView::deactivate() {
@@ -276,6 +444,12 @@ void HeadlessView::deactivate() {
         throw std::runtime_error("Removing OpenGL context failed.\n");
     }
 #endif
+
+#if MBGL_USE_EGL
+    if (!eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT)) {
+        throw std::runtime_error("Removing OpenGL context failed.\n");
+    }
+#endif
 }
 
 void HeadlessView::swap() {}
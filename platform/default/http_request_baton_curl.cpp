@@ -17,7 +17,10 @@
 
 #include <sys/utsname.h>
 
+#include <algorithm>
 #include <queue>
+#include <list>
+#include <atomic>
 #include <cassert>
 #include <cstring>
 #include <thread>
@@ -97,13 +100,37 @@ static CURLSH *share = nullptr;
 // all the time.
 static std::queue<CURL *> handles;
 
+// Maximum number of connections per host. Applied to the multi handle on the CURL thread.
+static std::atomic<unsigned> max_host_connections(8);
+static unsigned applied_max_host_connections = 0;
+
+// Whether the CURL library we're running against was built with HTTP/2 support.
+static bool http2_supported = false;
+
+// Maximum number of transfers that are handed to the multi handle at the same time. Requests
+// beyond this limit wait in a queue and are started in priority order as transfers finish, so
+// that tiles near the viewport center aren't stuck behind prefetching or offline downloads.
+static const size_t max_active_requests = 16;
+static size_t active_requests = 0;
+
 namespace mbgl {
 
+struct Context;
+
+// Requests that are configured but not yet added to the multi handle. Only used in the CURL thread.
+static std::list<Context *> queued_requests;
+
 struct Context {
     const util::ptr<HTTPRequestBaton> baton;
     CURL *handle = nullptr;
     curl_slist *headers = nullptr;
 
+    // Collects the response body until the request completes.
+    std::string body;
+
+    // Whether the handle was added to the multi handle, or is still waiting in queued_requests.
+    bool active = false;
+
     Context(const util::ptr<HTTPRequestBaton> &baton_) : baton(baton_) {
         assert(baton);
         baton->ptr = this;
@@ -124,11 +151,16 @@ struct Context {
             headers = nullptr;
         }
 
-        CURLMcode error = curl_multi_remove_handle(multi, handle);
-        if (error != CURLM_OK) {
-            baton->response = util::make_unique<Response>();
-            baton->response->code = -1;
-            baton->response->message = curl_multi_strerror(error);
+        if (active) {
+            CURLMcode error = curl_multi_remove_handle(multi, handle);
+            if (error != CURLM_OK) {
+                baton->response = util::make_unique<Response>();
+                baton->response->code = -1;
+                baton->response->message = curl_multi_strerror(error);
+            }
+            active_requests--;
+        } else {
+            queued_requests.remove(this);
         }
 
         curl_easy_setopt(handle, CURLOPT_PRIVATE, nullptr);
@@ -187,6 +219,28 @@ void curl_share_unlock(CURL *, curl_lock_data, void *) {
     uv_mutex_unlock(&share_mutex);
 }
 
+// Starts queued requests, lowest priority value first, until we hit the concurrency limit.
+void process_queue() {
+    while (active_requests < max_active_requests && !queued_requests.empty()) {
+        auto next = queued_requests.begin();
+        float best = (*next)->baton->priority;
+        for (auto it = std::next(next); it != queued_requests.end(); ++it) {
+            // Strictly lower, so that requests with equal priority are started in FIFO order.
+            const float priority = (*it)->baton->priority;
+            if (priority < best) {
+                best = priority;
+                next = it;
+            }
+        }
+
+        Context *context = *next;
+        queued_requests.erase(next);
+        context->active = true;
+        active_requests++;
+        curl_multi_add_handle(multi, context->handle);
+    }
+}
+
 void check_multi_info() {
     CURLMsg *message = nullptr;
     int pending = 0;
@@ -229,18 +283,19 @@ void check_multi_info() {
 
                 if (code != 304) {
                     baton->response->code = code;
+                    baton->response->data = std::make_shared<const std::string>(std::move(context->body));
                 }
 
                 if (code == 304) {
                     baton->type = HTTPResponseType::NotModified;
-                } else if (code == 200) {
+                } else if (code == 200 || code == 204) {
                     baton->type = HTTPResponseType::Successful;
                 } else if (code >= 500 && code < 600) {
                     baton->type = HTTPResponseType::TemporaryError;
                 } else if (code >= 400 && code < 500) {
                     baton->type = HTTPResponseType::PermanentError;
                 } else {
-                    assert(!"code must be either 200 or 304");
+                    assert(!"code must be either 200, 204 or 304");
                 }
             }
 
@@ -252,6 +307,9 @@ void check_multi_info() {
             throw std::runtime_error("CURLMSG returned unknown message type");
         }
     }
+
+    // Finished transfers freed up slots for queued requests.
+    process_queue();
 }
 
 void curl_perform(uv_poll_t *req, int /* status */, int events) {
@@ -346,6 +404,23 @@ void thread_init(void *) {
         throw std::runtime_error(std::string("CURL share error: ") + curl_share_strerror(share_error));
     }
 
+    // Share resolved host names and TLS sessions between all easy handles so that repeated
+    // requests to the same host skip DNS lookups and full TLS handshakes. Connections themselves
+    // are kept in the multi handle's connection cache, which all easy handles use.
+    share_error = curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    if (share_error != CURLSHE_OK) {
+        throw std::runtime_error(std::string("CURL share error: ") + curl_share_strerror(share_error));
+    }
+
+    share_error = curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    if (share_error != CURLSHE_OK) {
+        throw std::runtime_error(std::string("CURL share error: ") + curl_share_strerror(share_error));
+    }
+
+#ifdef CURL_VERSION_HTTP2
+    http2_supported = curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP2;
+#endif
+
     CURLMcode multi_error;
     multi = curl_multi_init();
 
@@ -358,6 +433,16 @@ void thread_init(void *) {
         throw std::runtime_error(std::string("CURL multi error: ") + curl_multi_strerror(multi_error));
     }
 
+#if LIBCURL_VERSION_NUM >= 0x072B00 // 7.43.0
+    // Run concurrent requests to the same host as streams on a single HTTP/2 connection.
+    if (http2_supported) {
+        multi_error = curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        if (multi_error != CURLM_OK) {
+            throw std::runtime_error(std::string("CURL multi error: ") + curl_multi_strerror(multi_error));
+        }
+    }
+#endif
+
     // Main event loop. This will not return until the request loop is terminated.
     uv_run(loop, UV_RUN_DEFAULT);
 
@@ -371,11 +456,33 @@ void thread_init(void *) {
 }
 
 // This function is called when we have new data for a request. We just append it to the string
-// containing the previous data.
+// containing the previous data. The string is sized after the Content-Length header when the first
+// chunk arrives, so that it isn't copied over and over while it grows. Compressed responses are
+// larger once they are decoded; they still start out at the right order of magnitude. If the main
+// thread listens for progress, the data of successful responses is handed to it as well.
 size_t curl_write_cb(void *const contents, const size_t size, const size_t nmemb, void *const userp) {
-    auto &response = *(std::unique_ptr<Response> *)userp;
-    assert(response);
-    response->data.append((char *)contents, size * nmemb);
+    auto &context = *(Context *)userp;
+    if (context.body.empty()) {
+        double length = -1;
+        if (curl_easy_getinfo(context.handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &length) == CURLE_OK &&
+            length > 0) {
+            context.body.reserve(std::max(size_t(length), size * nmemb));
+        }
+    }
+    HTTPRequestBaton &baton = *context.baton;
+    long code = 0;
+    if (baton.progress && curl_easy_getinfo(context.handle, CURLINFO_RESPONSE_CODE, &code) == CURLE_OK &&
+        code == 200) {
+        std::lock_guard<std::mutex> lock(baton.progressMutex);
+        if (baton.progressAsync) {
+            if (baton.progressData.empty()) {
+                baton.progressOffset = context.body.size();
+            }
+            baton.progressData.append((char *)contents, size * nmemb);
+            uv_async_send(baton.progressAsync);
+        }
+    }
+    context.body.append((char *)contents, size * nmemb);
     return size * nmemb;
 }
 
@@ -554,6 +661,14 @@ void start_request(void *const ptr) {
         context->baton->response = util::make_unique<Response>();
     }
 
+#if LIBCURL_VERSION_NUM >= 0x071E00 // 7.30.0
+    const unsigned max_connections = max_host_connections;
+    if (max_connections != applied_max_host_connections) {
+        curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, long(max_connections));
+        applied_max_host_connections = max_connections;
+    }
+#endif
+
     // Carry on the shared pointer in the private information of the CURL handle.
     curl_easy_setopt(context->handle, CURLOPT_PRIVATE, context);
 #ifndef __ANDROID__
@@ -565,15 +680,30 @@ void start_request(void *const ptr) {
     curl_easy_setopt(context->handle, CURLOPT_FOLLOWLOCATION, 1);
     curl_easy_setopt(context->handle, CURLOPT_URL, context->baton->path.c_str());
     curl_easy_setopt(context->handle, CURLOPT_WRITEFUNCTION, curl_write_cb);
-    curl_easy_setopt(context->handle, CURLOPT_WRITEDATA, &context->baton->response);
+    curl_easy_setopt(context->handle, CURLOPT_WRITEDATA, context);
     curl_easy_setopt(context->handle, CURLOPT_HEADERFUNCTION, curl_header_cb);
     curl_easy_setopt(context->handle, CURLOPT_HEADERDATA, &context->baton->response);
     curl_easy_setopt(context->handle, CURLOPT_ACCEPT_ENCODING, "gzip, deflate");
     curl_easy_setopt(context->handle, CURLOPT_USERAGENT, userAgent.c_str());
     curl_easy_setopt(context->handle, CURLOPT_SHARE, share);
 
-    // Start requesting the information.
-    curl_multi_add_handle(multi, context->handle);
+    if (http2_supported) {
+#if LIBCURL_VERSION_NUM >= 0x072F00 // 7.47.0
+        // Negotiate HTTP/2 via ALPN for https:// URLs, but keep using HTTP/1.1 for http://.
+        curl_easy_setopt(context->handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+#elif LIBCURL_VERSION_NUM >= 0x072100 // 7.33.0
+        curl_easy_setopt(context->handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072B00 // 7.43.0
+        // Wait for a pending connection to the same host to find out whether it can multiplex
+        // rather than opening another one right away.
+        curl_easy_setopt(context->handle, CURLOPT_PIPEWAIT, 1L);
+#endif
+    }
+
+    // Start requesting the information once there's a free slot.
+    queued_requests.push_back(context);
+    process_queue();
 }
 
 // This function must run in the CURL thread.
@@ -591,6 +721,9 @@ void stop_request(void *const ptr) {
         // We can still stop the request because it is still in progress.
         delete (Context *)baton->ptr;
         assert(!baton->ptr);
+
+        // Canceling an active request frees up a slot.
+        process_queue();
     } else {
         // If the async handle is gone, it means that the actual request has been completed before
         // we got a chance to cancel it. In this case, this is a no-op. It is likely that
@@ -626,4 +759,13 @@ void HTTPRequestBaton::stop(const util::ptr<HTTPRequestBaton> &ptr) {
     uv_messenger_send(&stop_messenger, new util::ptr<HTTPRequestBaton>(ptr));
 }
 
+void HTTPRequestBaton::setMaxHostConnections(unsigned count) {
+    // Picked up by the CURL thread when it starts the next request.
+    max_host_connections = count;
+}
+
+void HTTPRequestBaton::setBackgroundSessionIdentifier(const std::string &) {
+    // Offline downloads only run while the process does.
+}
+
 }
@@ -1,14 +1,24 @@
 #include <mbgl/util/image.hpp>
+#include <mbgl/util/image_kernels.hpp>
 #include <mbgl/platform/log.hpp>
 #include <mbgl/util/string.hpp>
 #include <mbgl/util/std.hpp>
 
 #include <png.h>
 
+extern "C"
+{
+#include <jpeglib.h>
+}
+
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstdlib>
 #include <stdexcept>
 #include <cstring>
+#include <unordered_map>
+#include <vector>
 
 #include <mbgl/platform/default/image_reader.hpp>
 
@@ -28,7 +38,76 @@ const static bool png_version_check = []() {
 namespace mbgl {
 namespace util {
 
-std::string compress_png(int width, int height, void *rgba) {
+namespace {
+
+// A palette of at most 256 colors, and the palette index of every pixel.
+struct Palette {
+    std::vector<png_color> colors;
+    std::vector<png_byte> alphas;
+    std::vector<png_byte> indices;
+};
+
+// Keeps dropping the lowest bit of every channel until the image has at most 256 colors. Every
+// palette color is the average of the pixels that were merged into it.
+Palette quantize(const uint8_t *rgba, size_t pixels) {
+    for (int shift = 0;; shift++) {
+        const uint32_t channelMask = (0xFF << shift) & 0xFF;
+        const uint32_t mask = channelMask * 0x01010101;
+
+        std::unordered_map<uint32_t, png_byte> index;
+        std::vector<std::array<uint64_t, 5>> sums;
+        Palette palette;
+        palette.indices.resize(pixels);
+
+        bool fits = true;
+        for (size_t i = 0; i < pixels; i++) {
+            const uint8_t *pixel = rgba + i * 4;
+            const uint32_t key = (pixel[0] | pixel[1] << 8 | pixel[2] << 16 | uint32_t(pixel[3]) << 24) & mask;
+            auto it = index.find(key);
+            if (it == index.end()) {
+                if (index.size() == 256) {
+                    fits = false;
+                    break;
+                }
+                it = index.emplace(key, png_byte(index.size())).first;
+                sums.push_back({{ 0, 0, 0, 0, 0 }});
+            }
+            std::array<uint64_t, 5> &sum = sums[it->second];
+            sum[0] += pixel[0];
+            sum[1] += pixel[1];
+            sum[2] += pixel[2];
+            sum[3] += pixel[3];
+            sum[4]++;
+            palette.indices[i] = it->second;
+        }
+
+        // With one bit per channel, there are at most 16 colors.
+        if (!fits) {
+            continue;
+        }
+
+        for (const std::array<uint64_t, 5> &sum : sums) {
+            palette.colors.push_back({ png_byte(sum[0] / sum[4]), png_byte(sum[1] / sum[4]), png_byte(sum[2] / sum[4]) });
+            palette.alphas.push_back(png_byte(sum[3] / sum[4]));
+        }
+        return palette;
+    }
+}
+
+int pngFilter(PNGOptions::Filter filter) {
+    switch (filter) {
+        case PNGOptions::Filter::None: return PNG_FILTER_NONE;
+        case PNGOptions::Filter::Sub: return PNG_FILTER_SUB;
+        case PNGOptions::Filter::Up: return PNG_FILTER_UP;
+        case PNGOptions::Filter::Average: return PNG_FILTER_AVG;
+        case PNGOptions::Filter::Paeth: return PNG_FILTER_PAETH;
+        default: return PNG_ALL_FILTERS;
+    }
+}
+
+}
+
+std::string compress_png(int width, int height, void *rgba, const PNGOptions &options) {
     png_voidp error_ptr = 0;
     png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, error_ptr, NULL, NULL);
     if (!png_ptr) {
@@ -43,8 +122,24 @@ std::string compress_png(int width, int height, void *rgba) {
         return "";
     }
 
-    png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
-                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    Palette palette;
+    if (options.quantize) {
+        palette = quantize(reinterpret_cast<const uint8_t *>(rgba), size_t(width) * height);
+        png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE,
+                     PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        png_set_PLTE(png_ptr, info_ptr, palette.colors.data(), int(palette.colors.size()));
+        if (std::any_of(palette.alphas.begin(), palette.alphas.end(), [](png_byte alpha) { return alpha != 0xFF; })) {
+            png_set_tRNS(png_ptr, info_ptr, palette.alphas.data(), int(palette.alphas.size()), NULL);
+        }
+    } else {
+        png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+                     PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    }
+
+    if (options.compressionLevel >= 0) {
+        png_set_compression_level(png_ptr, std::min(options.compressionLevel, 9));
+    }
+    png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, pngFilter(options.filter));
 
     jmp_buf *jmp_context = (jmp_buf *)png_get_error_ptr(png_ptr);
     if (jmp_context) {
@@ -64,8 +159,11 @@ std::string compress_png(int width, int height, void *rgba) {
         png_bytep *rows = nullptr;
     } pointers(height);
 
+    png_bytep data = options.quantize ? palette.indices.data() : (png_bytep)rgba;
+    const size_t stride = options.quantize ? width : width * 4;
     for (int i = 0; i < height; i++) {
-        pointers.rows[i] = (png_bytep)((png_bytep)rgba + width * 4 * i);
+        const int row = options.flipY ? height - 1 - i : i;
+        pointers.rows[i] = data + stride * row;
     }
 
     png_set_rows(png_ptr, info_ptr, pointers.rows);
@@ -75,6 +173,80 @@ std::string compress_png(int width, int height, void *rgba) {
     return result;
 }
 
+std::string compress_png(int width, int height, void *rgba, bool flipY) {
+    PNGOptions options;
+    options.flipY = flipY;
+    return compress_png(width, height, rgba, options);
+}
+
+std::string compress_jpeg(int width, int height, void *rgba, int quality, bool flipY) {
+    // Collects the output in a string, one buffer at a time.
+    struct Destination {
+        jpeg_destination_mgr manager;
+        std::string *result;
+        JOCTET buffer[4096];
+    } destination;
+
+    std::string result;
+    destination.result = &result;
+    destination.manager.init_destination = [](j_compress_ptr cinfo) {
+        Destination *dest = reinterpret_cast<Destination *>(cinfo->dest);
+        dest->manager.next_output_byte = dest->buffer;
+        dest->manager.free_in_buffer = sizeof(dest->buffer);
+    };
+    destination.manager.empty_output_buffer = [](j_compress_ptr cinfo) -> boolean {
+        Destination *dest = reinterpret_cast<Destination *>(cinfo->dest);
+        dest->result->append(reinterpret_cast<char *>(dest->buffer), sizeof(dest->buffer));
+        dest->manager.next_output_byte = dest->buffer;
+        dest->manager.free_in_buffer = sizeof(dest->buffer);
+        return TRUE;
+    };
+    destination.manager.term_destination = [](j_compress_ptr cinfo) {
+        Destination *dest = reinterpret_cast<Destination *>(cinfo->dest);
+        dest->result->append(reinterpret_cast<char *>(dest->buffer), sizeof(dest->buffer) - dest->manager.free_in_buffer);
+    };
+
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jerr.error_exit = [](j_common_ptr cinfo_) {
+        char buffer[JMSG_LENGTH_MAX];
+        (*cinfo_->err->format_message)(cinfo_, buffer);
+        throw std::runtime_error(buffer);
+    };
+
+    jpeg_create_compress(&cinfo);
+    try {
+        cinfo.dest = &destination.manager;
+        cinfo.image_width = width;
+        cinfo.image_height = height;
+        cinfo.input_components = 3;
+        cinfo.in_color_space = JCS_RGB;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, std::max(0, std::min(quality, 100)), TRUE);
+        jpeg_start_compress(&cinfo, TRUE);
+
+        // The pixels are premultiplied, so dropping alpha draws them on black.
+        std::unique_ptr<JSAMPLE[]> line = util::make_unique<JSAMPLE[]>(width * 3);
+        while (cinfo.next_scanline < cinfo.image_height) {
+            const int scanline = int(cinfo.next_scanline);
+            const int row = flipY ? height - 1 - scanline : scanline;
+            const uint8_t *pixel = reinterpret_cast<const uint8_t *>(rgba) + size_t(width) * 4 * row;
+            util::convertRGBAToRGB(pixel, line.get(), width);
+            JSAMPROW rows[] = { line.get() };
+            jpeg_write_scanlines(&cinfo, rows, 1);
+        }
+
+        jpeg_finish_compress(&cinfo);
+    } catch (const std::exception &ex) {
+        Log::Error(Event::Image, "Couldn't encode JPEG: %s", ex.what());
+        result.clear();
+    }
+    jpeg_destroy_compress(&cinfo);
+
+    return result;
+}
+
 Image::Image(std::string const& data)
 {
     try
@@ -82,13 +254,13 @@ Image::Image(std::string const& data)
         auto reader = getImageReader(data.c_str(), data.size());
         width = reader->width();
         height = reader->height();
-        img = util::make_unique<char[]>(width * height * 4);
-        reader->read(0, 0, width, height, img.get());
+        img.resize(size_t(width) * height * 4);
+        reader->read(0, 0, width, height, &img[0]);
     }
     catch (ImageReaderException const& ex)
     {
         fprintf(stderr, "Image: %s\n", ex.what());
-        img.reset();
+        img.clear();
         width = 0;
         height = 0;
 
@@ -96,7 +268,7 @@ Image::Image(std::string const& data)
     catch (...) // catch the rest
     {
         fprintf(stderr, "Image: exception in constructor");
-        img.reset();
+        img.clear();
         width = 0;
         height = 0;
     }
@@ -1,6 +1,7 @@
 #include <mbgl/platform/default/image_reader.hpp>
 #include <mbgl/platform/default/png_reader.hpp>
 #include <mbgl/platform/default/jpeg_reader.hpp>
+#include <mbgl/platform/default/webp_reader.hpp>
 
 #include <boost/optional.hpp>
 #include <boost/iostreams/device/array.hpp>
@@ -55,6 +56,10 @@ std::unique_ptr<ImageReader> getImageReader(char const* data, size_t size)
         {
             return util::make_unique<JpegReader<boost::iostreams::array_source>>(data, size);
         }
+        else if (*type == "webp")
+        {
+            return util::make_unique<WebpReader<boost::iostreams::array_source>>(data, size);
+        }
     }
     throw ImageReaderException("ImageReader: can't determine type from input data");
 }
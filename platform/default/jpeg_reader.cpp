@@ -170,13 +170,14 @@ void JpegReader<T>::read(unsigned x0, unsigned y0, unsigned w, unsigned h, char*
     w = std::min(w,width_ - x0);
     h = std::min(h,height_ - y0);
 
-    const std::unique_ptr<unsigned int[]> out_row(new unsigned int[w]);
+    // Scanlines are converted straight into the image.
     unsigned row = 0;
     while (cinfo.output_scanline < cinfo.output_height)
     {
         jpeg_read_scanlines(&cinfo, buffer, 1);
         if (row >= y0 && row < y0 + h)
         {
+            unsigned char *out = reinterpret_cast<unsigned char *>(image) + (row - y0) * width_ * 4;
             for (unsigned int x = 0; x < w; ++x)
             {
                 unsigned col = x + x0;
@@ -189,9 +190,11 @@ void JpegReader<T>::read(unsigned x0, unsigned y0, unsigned w, unsigned h, char*
                     g = r;
                     b = r;
                 }
-                out_row[x] =  (0xff << 24) | (b << 16) | (g << 8) | r;
+                out[x * 4 + 0] = r;
+                out[x * 4 + 1] = g;
+                out[x * 4 + 2] = b;
+                out[x * 4 + 3] = 0xff;
             }
-            std::copy((char*)out_row.get(), (char*)out_row.get() + w*4, image + (row - y0)*width_*4);
         }
         ++row;
     }
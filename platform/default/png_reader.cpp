@@ -188,7 +188,7 @@ void PngReader<T>::read(unsigned x0, unsigned y0, unsigned w, unsigned h, char *
             png_read_row(png_ptr,row.get(),0);
             if (i >= y0 && i < (y0 + h))
             {
-                std::copy(&row[x0 * 4], &row[x0 * 4] + w * 4, image + i * width_* 4);
+                std::copy(&row[x0 * 4], &row[x0 * 4] + w * 4, image + (i - y0) * width_* 4);
             }
         }
     }
@@ -0,0 +1,66 @@
+#include <mbgl/platform/default/trace_marker.hpp>
+
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace mbgl {
+
+TraceMarkerBackend::TraceMarkerBackend() : pid(getpid()) {
+    for (const char *path : { "/sys/kernel/tracing/trace_marker",
+                              "/sys/kernel/debug/tracing/trace_marker" }) {
+        fd = open(path, O_WRONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            break;
+        }
+    }
+}
+
+TraceMarkerBackend::~TraceMarkerBackend() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void TraceMarkerBackend::begin(const char *name) {
+    write("B|%d|%s", pid, name);
+}
+
+void TraceMarkerBackend::end() {
+    write("E|%d", pid);
+}
+
+void TraceMarkerBackend::beginAsync(const char *name, uint64_t cookie) {
+    write("S|%d|%s|%" PRIu64, pid, name, cookie);
+}
+
+void TraceMarkerBackend::endAsync(const char *name, uint64_t cookie) {
+    write("F|%d|%s|%" PRIu64, pid, name, cookie);
+}
+
+void TraceMarkerBackend::write(const char *format, ...) {
+    if (fd < 0) {
+        return;
+    }
+
+    // Each event has to reach the kernel in a single write, or events of other threads could end
+    // up in between.
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length > 0) {
+        if (size_t(length) >= sizeof(buffer)) {
+            length = sizeof(buffer) - 1;
+        }
+        // Tracing may be switched off at any time, and there's nobody to tell about it.
+        const ssize_t written = ::write(fd, buffer, length);
+        (void)written;
+    }
+}
+
+}
@@ -0,0 +1,117 @@
+#include <mbgl/platform/default/webp_reader.hpp>
+
+// boost
+#include <boost/iostreams/device/array.hpp>
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace mbgl { namespace util {
+
+// Frees the output buffer that libwebp allocated, if any, on all paths.
+struct webp_config_guard
+{
+    webp_config_guard(WebPDecoderConfig * config)
+        : c_(config) {}
+
+    ~webp_config_guard()
+    {
+        WebPFreeDecBuffer(&c_->output);
+    }
+    WebPDecoderConfig * c_;
+};
+
+// ctor
+template <typename T>
+WebpReader<T>::WebpReader(char const* data, size_t size)
+    : data_(data),
+      size_(size),
+      width_(0),
+      height_(0),
+      has_alpha_(false)
+{
+    init();
+}
+
+// dtor
+template <typename T>
+WebpReader<T>::~WebpReader() {}
+
+template <typename T>
+void WebpReader<T>::init()
+{
+    WebPBitstreamFeatures features;
+    if (WebPGetFeatures(reinterpret_cast<const uint8_t*>(data_), size_, &features) != VP8_STATUS_OK)
+    {
+        throw ImageReaderException("WEBP Reader: failed to read header");
+    }
+    if (features.width <= 0 || features.height <= 0)
+    {
+        throw ImageReaderException("WEBP Reader: failed to read image size");
+    }
+    width_ = features.width;
+    height_ = features.height;
+    has_alpha_ = features.has_alpha;
+}
+
+template <typename T>
+unsigned WebpReader<T>::width() const
+{
+    return width_;
+}
+
+template <typename T>
+unsigned WebpReader<T>::height() const
+{
+    return height_;
+}
+
+template <typename T>
+void WebpReader<T>::read(unsigned x0, unsigned y0, unsigned w, unsigned h, char* image)
+{
+    w = std::min(w,width_ - x0);
+    h = std::min(h,height_ - y0);
+
+    WebPDecoderConfig config;
+    if (!WebPInitDecoderConfig(&config))
+    {
+        throw ImageReaderException("WEBP Reader: incompatible libwebp version");
+    }
+    webp_config_guard guard(&config);
+
+    // rgbA premultiplies the color channels, like the PNG reader does.
+    config.output.colorspace = MODE_rgbA;
+
+    // Whole images are decoded straight into the caller's buffer. libwebp may snap the origin of
+    // a crop to even coordinates, so regions are decoded into a buffer of its own and copied.
+    const bool whole = x0 == 0 && y0 == 0 && w == width_ && h == height_;
+    if (whole)
+    {
+        config.output.is_external_memory = 1;
+        config.output.u.RGBA.rgba = reinterpret_cast<uint8_t*>(image);
+        config.output.u.RGBA.stride = width_ * 4;
+        config.output.u.RGBA.size = size_t(width_) * height_ * 4;
+    }
+
+    if (WebPDecode(reinterpret_cast<const uint8_t*>(data_), size_, &config) != VP8_STATUS_OK)
+    {
+        throw ImageReaderException("WEBP Reader: failed to decode image");
+    }
+
+    if (!whole)
+    {
+        const uint8_t* rgba = config.output.u.RGBA.rgba;
+        const int stride = config.output.u.RGBA.stride;
+        for (unsigned row = 0; row < h; ++row)
+        {
+            std::memcpy(image + size_t(row) * width_ * 4,
+                        rgba + size_t(row + y0) * stride + x0 * 4, w * 4);
+        }
+    }
+}
+
+template class WebpReader<boost::iostreams::array_source>;
+
+}}
@@ -1,10 +1,15 @@
 #ifndef MBGL_GEOMETRY_BUFFER
 #define MBGL_GEOMETRY_BUFFER
 
+#include <mbgl/geometry/buffer_pool.hpp>
 #include <mbgl/platform/gl.hpp>
+#include <mbgl/platform/gl_state.hpp>
 #include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/memory_usage.hpp>
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <cassert>
 #include <stdexcept>
 
@@ -18,12 +23,15 @@ template <
 >
 class Buffer : private util::noncopyable {
 public:
+    // Subclasses may pick a different element size at runtime, e.g. for wider indices.
+    Buffer(size_t itemSize_ = item_size) : itemSize(itemSize_) {}
+
     ~Buffer() {
         cleanup();
-        if (buffer != 0) {
-            MBGL_CHECK_ERROR(glDeleteBuffers(1, &buffer));
-            buffer = 0;
+        if (buffer != 0 && !isContextLost()) {
+            gl::State::Get().deleteBuffers(1, &buffer);
         }
+        buffer = 0;
     }
 
     // Returns the number of elements in this buffer. This is not the number of
@@ -36,28 +44,117 @@ public:
         return pos == 0;
     }
 
-    // Transfers this buffer to the GPU and binds the buffer to the GL context.
+    // Returns the number of bytes held by the CPU side array and the uploaded GL buffer.
+    inline MemoryUsage memoryUsage() const {
+        return MemoryUsage(array ? length : 0, buffer ? pos : 0);
+    }
+
+    // Returns the number of bytes that /count/ elements of this buffer take up.
+    inline MemoryUsage memoryUsage(size_t count) const {
+        const size_t bytes = count * itemSize;
+        return MemoryUsage(array ? bytes : 0, buffer ? bytes : 0);
+    }
+
+    // Transfers this buffer to the GPU and binds the buffer to the GL context. A buffer that was
+    // partially uploaded with upload() gets the rest of its data.
     void bind(bool force = false) {
+        recover();
         if (buffer == 0) {
             MBGL_CHECK_ERROR(glGenBuffers(1, &buffer));
+            context = gl::State::getContextGeneration();
             force = true;
         }
-        MBGL_CHECK_ERROR(glBindBuffer(bufferType, buffer));
+        gl::State::Get().bindBuffer(bufferType, buffer);
         if (force) {
             if (array == nullptr) {
                 throw std::runtime_error("Buffer was already deleted or doesn't contain elements");
             }
 
             MBGL_CHECK_ERROR(glBufferData(bufferType, pos, array, GL_STATIC_DRAW));
-            if (!retainAfterUpload) {
+            uploaded = pos;
+            if (!retained) {
                 cleanup();
             }
+        } else if (uploaded < pos) {
+            transfer(pos - uploaded);
+        }
+    }
+
+    // Transfers at most /maxBytes/ (0 = all) of the data that isn't on the GPU yet, without
+    // drawing from the buffer. This spreads the upload of large buffers over several frames.
+    // Leaves the buffer bound; returns the number of bytes transferred.
+    size_t upload(size_t maxBytes) {
+        recover();
+        if (uploaded >= pos) {
+            return 0;
+        }
+        if (array == nullptr) {
+            throw std::runtime_error("Buffer was already deleted or doesn't contain elements");
+        }
+
+        if (buffer == 0) {
+            // Allocate the storage once and fill it piece by piece.
+            MBGL_CHECK_ERROR(glGenBuffers(1, &buffer));
+            context = gl::State::getContextGeneration();
+            gl::State::Get().bindBuffer(bufferType, buffer);
+            MBGL_CHECK_ERROR(glBufferData(bufferType, pos, nullptr, GL_STATIC_DRAW));
+        } else {
+            gl::State::Get().bindBuffer(bufferType, buffer);
+        }
+
+        const size_t remaining = pos - uploaded;
+        return transfer(maxBytes > 0 && maxBytes < remaining ? maxBytes : remaining);
+    }
+
+    // Whether all elements are on the GPU.
+    inline bool isUploaded() const {
+        return uploaded >= pos && !isContextLost();
+    }
+
+    // Keeps the elements on the CPU side after they were uploaded, so that they can be uploaded
+    // again when the GL context is lost. Must be called before the upload.
+    inline void retain() {
+        retained = true;
+    }
+
+    // Whether the GL buffer belongs to a context that was lost, and the elements weren't retained
+    // to upload them again.
+    inline bool isLost() const {
+        return isContextLost() && array == nullptr;
+    }
+
+    // Makes room for at least /count/ more elements, so that adding them doesn't reallocate.
+    void reserve(size_t count) {
+        if (buffer != 0) {
+            throw std::runtime_error("Can't add elements after buffer was bound to GPU");
+        }
+        grow(pos + count * itemSize);
+    }
+
+    // Appends /count/ elements that were copied out of a buffer with the same element size.
+    void append(const void *data, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        const size_t bytes = count * itemSize;
+        reserve(count);
+        std::memcpy(static_cast<char *>(array) + pos, data, bytes);
+        pos += bytes;
+    }
+
+    // Returns the elements from /first/ on, for copying them elsewhere. Only valid while the
+    // buffer still holds its elements on the CPU side.
+    inline const char *data(size_t first) const {
+        if (array == nullptr && pos > 0) {
+            throw std::runtime_error("Buffer was already deleted or doesn't contain elements");
         }
+        return static_cast<const char *>(array) + first * itemSize;
     }
 
+    // Returns the CPU side array to the pool.
     void cleanup() {
         if (array) {
-            free(array);
+            BufferPool::shared().release(array, length);
             array = nullptr;
         }
     }
@@ -72,18 +169,13 @@ protected:
         if (buffer != 0) {
             throw std::runtime_error("Can't add elements after buffer was bound to GPU");
         }
-        if (length < pos + itemSize) {
-            while (length < pos + itemSize) length += defaultLength;
-            array = realloc(array, length);
-            if (array == nullptr) {
-                throw std::runtime_error("Buffer reallocation failed");
-            }
-        }
+        grow(pos + itemSize);
         pos += itemSize;
         return static_cast<char *>(array) + (pos - itemSize);
     }
 
-    // Get a pointer to the item at a given index.
+    // Get a pointer to the item at a given index, for changing it. Buffers that keep their
+    // elements after the upload transfer the changed ones again with the next bind() or upload().
     inline void *getElement(size_t i) {
         if (array == nullptr) {
             throw std::runtime_error("Buffer was already deleted or doesn't contain elements");
@@ -92,12 +184,53 @@ protected:
         if (i * itemSize >= pos) {
             throw new std::runtime_error("Can't get element after array bounds");
         } else {
+            uploaded = std::min(uploaded, i * itemSize);
             return static_cast<char *>(array) + (i * itemSize);
         }
     }
 
 public:
-    static const size_t itemSize = item_size;
+    const size_t itemSize;
+
+private:
+    inline bool isContextLost() const {
+        return buffer != 0 && context != gl::State::getContextGeneration();
+    }
+
+    // Forgets the GL buffer of a lost context, so that the retained elements go into a new one.
+    inline void recover() {
+        if (isContextLost()) {
+            buffer = 0;
+            uploaded = 0;
+        }
+    }
+
+    // Copies the next /bytes/ to the bound GL buffer.
+    size_t transfer(size_t bytes) {
+        MBGL_CHECK_ERROR(glBufferSubData(bufferType, uploaded, bytes, static_cast<char *>(array) + uploaded));
+        uploaded += bytes;
+        if (uploaded >= pos && !retained) {
+            cleanup();
+        }
+        return bytes;
+    }
+
+    // Grows the array to hold at least /required/ bytes. The size at least doubles every time so
+    // that filling a buffer only copies every byte a constant number of times on average. Arrays
+    // come from the pool, so that steady parsing reuses those of the buffers that were uploaded.
+    void grow(size_t required) {
+        if (length >= required) {
+            return;
+        }
+        size_t size = std::max(std::max(length * 2, defaultLength), required);
+        void *next = BufferPool::shared().allocate(size);
+        if (array) {
+            std::memcpy(next, array, pos);
+            BufferPool::shared().release(array, length);
+        }
+        array = next;
+        length = size;
+    }
 
 private:
     // CPU buffer
@@ -109,8 +242,16 @@ private:
     // Number of bytes that are valid in this buffer.
     size_t length = 0;
 
+    // Number of bytes that were transferred to the GL buffer.
+    size_t uploaded = 0;
+
     // GL buffer ID
     GLuint buffer = 0;
+
+    // The generation of the GL context that the buffer belongs to.
+    uint32_t context = 0;
+
+    bool retained = retainAfterUpload;
 };
 
 }
@@ -0,0 +1,96 @@
+#include <mbgl/geometry/buffer_pool.hpp>
+
+#include <cassert>
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace mbgl;
+
+const size_t BufferPool::minimumSize;
+const size_t BufferPool::maximumSize;
+const size_t BufferPool::classCount;
+
+BufferPool::BufferPool(size_t maximumBytes_) : maximumBytes(maximumBytes_) {}
+
+BufferPool::~BufferPool() {
+    clear();
+}
+
+BufferPool &BufferPool::shared() {
+    static BufferPool *pool = new BufferPool();
+    return *pool;
+}
+
+size_t BufferPool::sizeClass(size_t size) {
+    size_t i = 0;
+    while ((minimumSize << i) < size) {
+        i++;
+    }
+    return i;
+}
+
+void *BufferPool::allocate(size_t &size) {
+    if (size > maximumSize) {
+        void *array = std::malloc(size);
+        if (array == nullptr) {
+            throw std::runtime_error("Buffer allocation failed");
+        }
+        return array;
+    }
+
+    const size_t i = sizeClass(size);
+    size = minimumSize << i;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!arrays[i].empty()) {
+            void *array = arrays[i].back();
+            arrays[i].pop_back();
+            bytes -= size;
+            return array;
+        }
+    }
+
+    void *array = std::malloc(size);
+    if (array == nullptr) {
+        throw std::runtime_error("Buffer allocation failed");
+    }
+    return array;
+}
+
+void BufferPool::release(void *array, size_t size) {
+    if (array == nullptr) {
+        return;
+    }
+
+    if (size <= maximumSize) {
+        const size_t i = sizeClass(size);
+        assert(size == minimumSize << i);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (bytes + size <= maximumBytes) {
+            arrays[i].push_back(array);
+            bytes += size;
+            return;
+        }
+    }
+
+    std::free(array);
+}
+
+size_t BufferPool::clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (std::vector<void *> &sized : arrays) {
+        for (void *array : sized) {
+            std::free(array);
+        }
+        sized.clear();
+    }
+    const size_t freed = bytes;
+    bytes = 0;
+    return freed;
+}
+
+size_t BufferPool::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return bytes;
+}
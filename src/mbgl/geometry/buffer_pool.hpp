@@ -0,0 +1,60 @@
+#ifndef MBGL_GEOMETRY_BUFFER_POOL
+#define MBGL_GEOMETRY_BUFFER_POOL
+
+#include <mbgl/util/noncopyable.hpp>
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace mbgl {
+
+// Keeps the CPU side arrays of buffers that were uploaded or destroyed, so that the buffers of the
+// next parses take them over instead of allocating new ones. Arrays are handed out in power of
+// two sizes between minimumSize and maximumSize, so that an array fits all requests of its size
+// class; larger ones go straight to the system allocator. The pool holds at most maximumBytes;
+// arrays that are returned beyond that are freed.
+//
+// Buffers are filled on the worker threads and emptied on the map thread once they're on the
+// GPU, so all threads share one pool.
+class BufferPool : private util::noncopyable {
+public:
+    static const size_t minimumSize = 4 * 1024;
+    static const size_t maximumSize = 16 * 1024 * 1024;
+
+    explicit BufferPool(size_t maximumBytes = 32 * 1024 * 1024);
+    ~BufferPool();
+
+    // The pool that all buffers use. It is never destroyed, so that buffers may return their
+    // arrays during static destruction.
+    static BufferPool &shared();
+
+    // Returns an array of at least /size/ bytes, and sets /size/ to the bytes it has.
+    void *allocate(size_t &size);
+
+    // Takes back an array that allocate() returned with /size/ bytes. May be called on any thread.
+    void release(void *array, size_t size);
+
+    // Frees all arrays in the pool, e.g. when the system runs low on memory. Returns the number of
+    // bytes freed.
+    size_t clear();
+
+    // Bytes held by the arrays in the pool.
+    size_t memoryUsage() const;
+
+private:
+    static const size_t classCount = 13;
+    static_assert(minimumSize << (classCount - 1) == maximumSize, "one size class per power of two");
+    static size_t sizeClass(size_t size);
+
+    const size_t maximumBytes;
+
+    mutable std::mutex mtx;
+    std::array<std::vector<void *>, classCount> arrays;
+    size_t bytes = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,19 @@
+#include <mbgl/geometry/circle_buffer.hpp>
+
+#include <mbgl/platform/gl.hpp>
+
+using namespace mbgl;
+
+void CircleVertexBuffer::add(vertex_type x, vertex_type y) {
+    for (vertex_type corner = 0; corner < 4; corner++) {
+        vertex_type *vertices = static_cast<vertex_type *>(addElement());
+        vertices[0] = x * 2 + (corner & 1);
+        vertices[1] = y * 2 + (corner >> 1);
+    }
+}
+
+void CircleVertexBuffer::addInstance(vertex_type x, vertex_type y) {
+    vertex_type *vertices = static_cast<vertex_type *>(addElement());
+    vertices[0] = x;
+    vertices[1] = y;
+}
@@ -0,0 +1,27 @@
+#ifndef MBGL_GEOMETRY_CIRCLE_BUFFER
+#define MBGL_GEOMETRY_CIRCLE_BUFFER
+
+#include <mbgl/geometry/buffer.hpp>
+
+namespace mbgl {
+
+// Holds the points of circle buckets, either as one instance per point where the GL has
+// instanced arrays, or as four vertices per point that are drawn as two triangles. A vertex
+// stores its position times two, plus the corner of the quad in the lowest bit of each
+// coordinate.
+class CircleVertexBuffer : public Buffer<
+    4 // 2 coordinates per vertex (2 * short == 4 bytes)
+> {
+public:
+    typedef int16_t vertex_type;
+
+    // Adds the four corners of the quad of a point.
+    void add(vertex_type x, vertex_type y);
+
+    // Adds a point as one instance.
+    void addInstance(vertex_type x, vertex_type y);
+};
+
+}
+
+#endif
@@ -0,0 +1,155 @@
+#include <mbgl/geometry/clip.hpp>
+
+#include <cmath>
+
+namespace mbgl {
+
+namespace {
+
+// Intersection of the segment ab with a vertical (axis = 0) or horizontal (axis = 1) line.
+Coordinate intersect(const Coordinate &a, const Coordinate &b, int axis, int16_t value) {
+    if (axis == 0) {
+        const double t = double(value - a.x) / (b.x - a.x);
+        return Coordinate(value, int16_t(std::round(a.y + (b.y - a.y) * t)));
+    } else {
+        const double t = double(value - a.y) / (b.y - a.y);
+        return Coordinate(int16_t(std::round(a.x + (b.x - a.x) * t)), value);
+    }
+}
+
+}
+
+GeometryClipper::GeometryClipper(int16_t min_, int16_t max_) : min(min_), max(max_) {}
+
+bool GeometryClipper::contains(const GeometryCollection &geometry) const {
+    for (const std::vector<Coordinate> &line : geometry) {
+        for (const Coordinate &coord : line) {
+            if (coord.x < min || coord.x > max || coord.y < min || coord.y > max) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+const GeometryCollection& GeometryClipper::clipPolygons(const GeometryCollection &rings) {
+    if (contains(rings)) {
+        return rings;
+    }
+
+    result.clear();
+    for (const std::vector<Coordinate> &ring : rings) {
+        if (ring.size() < 3) {
+            continue;
+        }
+
+        // Decoded rings repeat their first vertex; we work on the open ring and close it again.
+        const bool closed = ring.front() == ring.back();
+        result.emplace_back(ring.begin(), closed ? ring.end() - 1 : ring.end());
+        std::vector<Coordinate> &output = result.back();
+
+        // Clip against every edge of the square in turn.
+        for (int edge = 0; edge < 4 && !output.empty(); edge++) {
+            const int axis = edge % 2;
+            const int16_t value = edge < 2 ? min : max;
+            const auto inside = [&](const Coordinate &c) {
+                const int16_t v = axis == 0 ? c.x : c.y;
+                return edge < 2 ? v >= value : v <= value;
+            };
+
+            // Vertices on the edge would otherwise show up twice.
+            const auto add = [&](const Coordinate &c) {
+                if (output.empty() || !(output.back() == c)) {
+                    output.push_back(c);
+                }
+            };
+
+            scratch.swap(output);
+            output.clear();
+            Coordinate prev = scratch.back();
+            bool prevInside = inside(prev);
+            for (const Coordinate &current : scratch) {
+                const bool currentInside = inside(current);
+                if (currentInside != prevInside) {
+                    add(intersect(prev, current, axis, value));
+                }
+                if (currentInside) {
+                    add(current);
+                }
+                prev = current;
+                prevInside = currentInside;
+            }
+            if (output.size() > 1 && output.front() == output.back()) {
+                output.pop_back();
+            }
+        }
+
+        if (output.size() < 3) {
+            result.pop_back();
+        } else if (closed) {
+            output.push_back(output.front());
+        }
+    }
+    return result;
+}
+
+const GeometryCollection& GeometryClipper::clipLines(const GeometryCollection &lines) {
+    if (contains(lines)) {
+        return lines;
+    }
+
+    enum : uint8_t { left = 1, right = 2, top = 4, bottom = 8 };
+    const auto outcode = [this](const Coordinate &c) {
+        return uint8_t((c.x < min ? left : c.x > max ? right : 0) |
+                       (c.y < min ? top : c.y > max ? bottom : 0));
+    };
+
+    result.clear();
+    for (const std::vector<Coordinate> &line : lines) {
+        // Whether the last clipped segment ended at the end of the original segment, so that the
+        // next one continues the same output line.
+        bool open = false;
+
+        for (size_t i = 1; i < line.size(); i++) {
+            Coordinate a = line[i - 1], b = line[i];
+            uint8_t codeA = outcode(a), codeB = outcode(b);
+            const bool clippedB = codeB != 0;
+
+            while (codeA | codeB) {
+                if (codeA & codeB) {
+                    // Both ends are on the outside of the same edge.
+                    break;
+                }
+
+                const uint8_t code = codeA ? codeA : codeB;
+                Coordinate &c = codeA ? a : b;
+                if (code & left) c = intersect(a, b, 0, min);
+                else if (code & right) c = intersect(a, b, 0, max);
+                else if (code & top) c = intersect(a, b, 1, min);
+                else c = intersect(a, b, 1, max);
+
+                if (codeA) codeA = outcode(a);
+                else codeB = outcode(b);
+            }
+
+            if (codeA | codeB) {
+                open = false;
+                continue;
+            }
+
+            if (!open || !(result.back().back() == a)) {
+                result.emplace_back();
+                result.back().push_back(a);
+            }
+            result.back().push_back(b);
+            open = !clippedB;
+        }
+
+        if (!result.empty() && result.back().size() < 2) {
+            result.pop_back();
+        }
+    }
+    return result;
+}
+
+}
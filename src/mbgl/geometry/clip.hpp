@@ -0,0 +1,37 @@
+#ifndef MBGL_GEOMETRY_CLIP
+#define MBGL_GEOMETRY_CLIP
+
+#include <mbgl/geometry/geometry.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+namespace mbgl {
+
+/*
+ * Clips decoded geometry against a square, e.g. the tile extent plus a buffer, so that buckets
+ * don't build vertices for geometry that is never visible. Geometry that is entirely inside the
+ * square is returned as is. Like GeometryDecoder, the clipper keeps its buffers between calls.
+ */
+class GeometryClipper : private util::noncopyable {
+public:
+    GeometryClipper(int16_t min, int16_t max);
+
+    // Clips every ring on its own (Sutherland-Hodgman); this doesn't change the winding of any
+    // point inside of the square. The returned collection is valid until the next call.
+    const GeometryCollection& clipPolygons(const GeometryCollection &rings);
+
+    // Splits lines where they leave the square (Cohen-Sutherland). The returned collection is
+    // valid until the next call.
+    const GeometryCollection& clipLines(const GeometryCollection &lines);
+
+private:
+    bool contains(const GeometryCollection &geometry) const;
+
+    const int16_t min;
+    const int16_t max;
+    GeometryCollection result;
+    std::vector<Coordinate> scratch;
+};
+
+}
+
+#endif
@@ -6,7 +6,10 @@
 namespace mbgl {
 
 class DebugFontBuffer : public Buffer<
-    4 // 2 bytes per coordinate, 2 coordinates
+    4, // 2 bytes per coordinate, 2 coordinates
+    GL_ARRAY_BUFFER,
+    8192,
+    true // retained, so that it survives the loss of the GL context
 > {
 public:
     void addText(const char *text, double left, double baseline, double scale = 1);
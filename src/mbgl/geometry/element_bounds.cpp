@@ -0,0 +1,52 @@
+#include <mbgl/geometry/element_bounds.hpp>
+
+namespace mbgl {
+
+ElementCuller::ElementCuller(const mat4 &matrix_, float width, float height, float padding_, float extentScale_)
+    : enabled(width > 0 && height > 0),
+      matrix(matrix_),
+      pixelX(width > 0 ? 2.0f / width : 0),
+      pixelY(height > 0 ? 2.0f / height : 0),
+      padding(padding_),
+      extentScale(extentScale_) {
+}
+
+bool ElementCuller::isVisible(const ElementBounds &bounds) const {
+    if (bounds.empty()) {
+        return false;
+    }
+    if (!enabled) {
+        return true;
+    }
+
+    const float pixels = padding + bounds.extent * extentScale;
+    const float padX = pixels * pixelX;
+    const float padY = pixels * pixelY;
+
+    // The group is off screen when all corners of its box are beyond the same edge of the
+    // viewport. The box may be rotated, so all four corners are needed.
+    const float xs[2] = { float(bounds.minX), float(bounds.maxX) };
+    const float ys[2] = { float(bounds.minY), float(bounds.maxY) };
+    bool left = true, right = true, top = true, bottom = true;
+    for (float x : xs) {
+        for (float y : ys) {
+            float cx = matrix[0] * x + matrix[4] * y + matrix[12];
+            float cy = matrix[1] * x + matrix[5] * y + matrix[13];
+            const float w = matrix[3] * x + matrix[7] * y + matrix[15];
+            if (w <= 0) {
+                // Behind the viewer; we can't tell.
+                return true;
+            }
+            cx /= w;
+            cy /= w;
+            left = left && cx < -1 - padX;
+            right = right && cx > 1 + padX;
+            bottom = bottom && cy < -1 - padY;
+            top = top && cy > 1 + padY;
+        }
+    }
+
+    return !(left || right || top || bottom);
+}
+
+}
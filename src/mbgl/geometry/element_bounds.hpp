@@ -0,0 +1,65 @@
+#ifndef MBGL_GEOMETRY_ELEMENT_BOUNDS
+#define MBGL_GEOMETRY_ELEMENT_BOUNDS
+
+#include <mbgl/util/mat4.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace mbgl {
+
+// The bounding box of the vertices of an element group in tile coordinates. Geometry that the
+// shaders extrude in screen space, like line widths and glyph quads, reaches /extent/ beyond it;
+// the unit of the extent is up to the bucket.
+struct ElementBounds {
+    int16_t minX = std::numeric_limits<int16_t>::max();
+    int16_t minY = std::numeric_limits<int16_t>::max();
+    int16_t maxX = std::numeric_limits<int16_t>::min();
+    int16_t maxY = std::numeric_limits<int16_t>::min();
+    float extent = 0;
+
+    inline void extend(int16_t x, int16_t y) {
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+
+    inline void extend(const ElementBounds &other) {
+        minX = std::min(minX, other.minX);
+        minY = std::min(minY, other.minY);
+        maxX = std::max(maxX, other.maxX);
+        maxY = std::max(maxY, other.maxY);
+        extent = std::max(extent, other.extent);
+    }
+
+    inline bool empty() const {
+        return minX > maxX;
+    }
+};
+
+// Tells whether element groups can show in the viewport, so that the ones that are entirely off
+// screen aren't drawn.
+class ElementCuller {
+public:
+    // Culls nothing.
+    ElementCuller() {}
+
+    // /matrix/ transforms tile coordinates to clip space. The bounds are grown by /padding/ plus
+    // their extent times /extentScale/, both in pixels of a viewport of the given size.
+    ElementCuller(const mat4 &matrix, float width, float height, float padding, float extentScale = 0);
+
+    bool isVisible(const ElementBounds &bounds) const;
+
+private:
+    bool enabled = false;
+    mat4 matrix;
+    float pixelX = 0, pixelY = 0;
+    float padding = 0;
+    float extentScale = 0;
+};
+
+}
+
+#endif
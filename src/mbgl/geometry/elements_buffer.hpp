@@ -2,11 +2,15 @@
 #define MBGL_GEOMETRY_TRIANGLE_ELEMENTS_BUFFER
 
 #include <mbgl/geometry/buffer.hpp>
+#include <mbgl/geometry/element_bounds.hpp>
 #include <mbgl/geometry/vao.hpp>
 
 #include <mbgl/util/noncopyable.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <limits>
 
 namespace mbgl {
 
@@ -15,6 +19,7 @@ struct ElementGroup : public util::noncopyable {
     std::array<VertexArrayObject, count> array;
     uint32_t vertex_length;
     uint32_t elements_length;
+    ElementBounds bounds;
 
     ElementGroup() : vertex_length(0), elements_length(0) {}
     ElementGroup(uint32_t vertex_length_, uint32_t elements_length_)
@@ -25,36 +30,65 @@ struct ElementGroup : public util::noncopyable {
     ElementGroup(ElementGroup &&rhs) noexcept
         : array(std::move(rhs.array)),
           vertex_length(rhs.vertex_length),
-          elements_length(rhs.elements_length) {};
+          elements_length(rhs.elements_length),
+          bounds(rhs.bounds) {};
 };
 
-class TriangleElementsBuffer : public Buffer<
-    6, // bytes per triangle (3 * unsigned short == 6 bytes)
+// Elements are stored as unsigned shorts, or as unsigned ints where the GL supports them
+// (OES_element_index_uint on GLES2). With wide indices, element groups don't have to be split
+// every 65k vertices, so buckets need fewer draw calls.
+template <size_t indices>
+class ElementsBuffer : public Buffer<
+    indices * 2,
     GL_ELEMENT_ARRAY_BUFFER
 > {
 public:
-    typedef uint16_t element_type;
+    inline ElementsBuffer(bool wide = false)
+        : Buffer<indices * 2, GL_ELEMENT_ARRAY_BUFFER>(wide ? indices * 4 : indices * 2),
+          elementType(wide ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT) {}
 
-    void add(element_type a, element_type b, element_type c);
+    // Largest number of vertices a group of elements can reference.
+    inline uint32_t maxGroupVertices() const {
+        return elementType == GL_UNSIGNED_INT ? std::numeric_limits<uint32_t>::max() : 65535;
+    }
+
+    // The type to pass to glDrawElements().
+    const GLenum elementType;
+
+protected:
+    inline void addIndices(const std::array<uint32_t, indices> &values) {
+        void *data = this->addElement();
+        if (elementType == GL_UNSIGNED_INT) {
+            std::copy(values.begin(), values.end(), static_cast<uint32_t *>(data));
+        } else {
+            std::copy(values.begin(), values.end(), static_cast<uint16_t *>(data));
+        }
+    }
 };
 
+class TriangleElementsBuffer : public ElementsBuffer<3> {
+public:
+    typedef uint32_t element_type;
 
-class LineElementsBuffer : public Buffer<
-    4, // bytes per triangle (2 * unsigned short == 6 bytes)
-    GL_ELEMENT_ARRAY_BUFFER
-> {
+    inline TriangleElementsBuffer(bool wide = false) : ElementsBuffer<3>(wide) {}
+
+    void add(element_type a, element_type b, element_type c);
+};
+
+class LineElementsBuffer : public ElementsBuffer<2> {
 public:
-    typedef uint16_t element_type;
+    typedef uint32_t element_type;
+
+    inline LineElementsBuffer(bool wide = false) : ElementsBuffer<2>(wide) {}
 
     void add(element_type a, element_type b);
 };
 
-class PointElementsBuffer : public Buffer<
-    2, // bytes per point (1 unsigned short)
-    GL_ELEMENT_ARRAY_BUFFER
-> {
+class PointElementsBuffer : public ElementsBuffer<1> {
 public:
-    typedef uint16_t element_type;
+    typedef uint32_t element_type;
+
+    inline PointElementsBuffer(bool wide = false) : ElementsBuffer<1>(wide) {}
 
     void add(element_type a);
 };
@@ -3,6 +3,7 @@
 #include <mbgl/platform/gl.hpp>
 
 #include <climits>
+#include <cmath>
 
 using namespace mbgl;
 
@@ -11,3 +12,19 @@ void FillVertexBuffer::add(vertex_type x, vertex_type y) {
     vertices[0] = x;
     vertices[1] = y;
 }
+
+void FillColorBuffer::add(const color_type &color) {
+    uint8_t *colors = static_cast<uint8_t *>(addElement());
+    colors[0] = color[0];
+    colors[1] = color[1];
+    colors[2] = color[2];
+    colors[3] = color[3];
+}
+
+void FillFringeBuffer::add(float ex, float ey) {
+    int8_t *extrude = static_cast<int8_t *>(addElement());
+    extrude[0] = std::round(extrudeScale * ex);
+    extrude[1] = std::round(extrudeScale * ey);
+    extrude[2] = 0;
+    extrude[3] = 0;
+}
@@ -2,6 +2,7 @@
 #define MBGL_GEOMETRY_FILL_BUFFER
 
 #include <mbgl/geometry/buffer.hpp>
+#include <array>
 #include <vector>
 #include <cstdint>
 
@@ -16,6 +17,30 @@ public:
     void add(vertex_type x, vertex_type y);
 };
 
+// Holds a premultiplied color for every vertex of the fill buckets that color their features
+// individually.
+class FillColorBuffer : public Buffer<
+    4 // bytes per color (4 * unsigned byte == 4 bytes)
+> {
+public:
+    typedef std::array<uint8_t, 4> color_type;
+
+    void add(const color_type &color);
+};
+
+// Holds the extrusion of the antialiasing fringe for every vertex of the fill buckets that
+// antialias their edges in the shader. Only the vertices on the outer side of the fringe are
+// extruded; all other vertices have a zero extrusion.
+class FillFringeBuffer : public Buffer<
+    4 // bytes per extrusion (2 * signed byte + 2 bytes padding == 4 bytes)
+> {
+public:
+    // Extrusions have a length of up to 2, like the extrusions of line vertices.
+    static const int8_t extrudeScale = 63;
+
+    void add(float ex, float ey);
+};
+
 }
 
 #endif
@@ -3,16 +3,23 @@
 
 #include <mbgl/util/pbf.hpp>
 #include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/vec.hpp>
+#include <mbgl/platform/log.hpp>
 
 #include <cstdlib>
+#include <vector>
 
 namespace mbgl {
 
-class Geometry : private util::noncopyable {
+typedef std::vector<std::vector<Coordinate>> GeometryCollection;
 
+/*
+ * Decodes vector tile geometry fields. The whole packed field is turned into
+ * varints in one pass and then interpreted as drawing commands. The decoder
+ * keeps its buffers between calls, so reuse one instance for many features.
+ */
+class GeometryDecoder : private util::noncopyable {
 public:
-    inline explicit Geometry(pbf& data);
-
     enum command : uint8_t {
         end = 0,
         move_to = 1,
@@ -20,56 +27,69 @@ public:
         close = 7
     };
 
-    inline command next(int32_t &rx, int32_t &ry);
+    // Every move_to starts a new line or ring; close repeats the first vertex of the ring.
+    // The returned collection is valid until the next call to decode().
+    inline const GeometryCollection& decode(pbf data);
 
 private:
-    pbf& data;
-    uint8_t cmd;
-    uint32_t length;
-    int32_t x, y;
-    int32_t ox, oy;
+    std::vector<uint32_t> values;
+    GeometryCollection lines;
 };
 
-Geometry::Geometry(pbf& data_)
-    : data(data_),
-      cmd(1),
-      length(0),
-      x(0), y(0),
-      ox(0), oy(0) {}
-
-Geometry::command Geometry::next(int32_t &rx, int32_t &ry) {
-    if (data.data < data.end) {
-        if (length == 0) {
-            uint32_t cmd_length = static_cast<uint32_t>(data.varint());
-            cmd = cmd_length & 0x7;
-            length = cmd_length >> 3;
+const GeometryCollection& GeometryDecoder::decode(pbf data) {
+    values.clear();
+    data.varints(values);
+
+    size_t count = 0;
+    std::vector<Coordinate> *line = nullptr;
+
+    auto beginLine = [&]() {
+        if (count == lines.size()) {
+            lines.emplace_back();
         }
+        line = &lines[count++];
+        line->clear();
+    };
 
-        --length;
+    const size_t size = values.size();
+    size_t i = 0;
+    int32_t x = 0, y = 0;
+    int32_t ox = 0, oy = 0;
+
+    while (i < size) {
+        const uint8_t cmd = values[i] & 0x7;
+        uint32_t length = values[i] >> 3;
+        ++i;
 
         if (cmd == move_to || cmd == line_to) {
-            rx = (x += data.svarint());
-            ry = (y += data.svarint());
-
-            if (cmd == move_to) {
-                ox = x;
-                oy = y;
-                return move_to;
-            } else {
-                return line_to;
+            // Ignore coordinates that run past the end of the field.
+            length = std::min<size_t>(length, (size - i) / 2);
+            for (uint32_t j = 0; j < length; ++j, i += 2) {
+                x += int32_t((values[i] >> 1) ^ -(values[i] & 1));
+                y += int32_t((values[i + 1] >> 1) ^ -(values[i + 1] & 1));
+
+                if (cmd == move_to) {
+                    ox = x;
+                    oy = y;
+                    beginLine();
+                } else if (!line) {
+                    beginLine();
+                }
+                line->emplace_back(x, y);
             }
         } else if (cmd == close) {
-            rx = ox;
-            ry = oy;
-            return close;
+            for (uint32_t j = 0; j < length && line; ++j) {
+                line->emplace_back(ox, oy);
+            }
         } else {
-            fprintf(stderr, "unknown command: %d\n", cmd);
+            Log::Warning(Event::ParseTile, "unknown command: %d", cmd);
             // TODO: gracefully handle geometry parse failures
-            return end;
+            break;
         }
-    } else {
-        return end;
     }
+
+    lines.resize(count);
+    return lines;
 }
 
 }
@@ -2,7 +2,9 @@
 #include <mbgl/map/vector_tile.hpp>
 
 #include <mbgl/platform/gl.hpp>
+#include <mbgl/platform/gl_state.hpp>
 #include <mbgl/platform/platform.hpp>
+#include <mbgl/platform/log.hpp>
 
 #include <cassert>
 #include <algorithm>
@@ -15,34 +17,42 @@ GlyphAtlas::GlyphAtlas(uint16_t width_, uint16_t height_)
       height(height_),
       bin(width_, height_),
       data(new char[width_ *height_]),
-      dirty(true) {
+      dirty(true),
+      dirtyBottom(height_) {
+    std::fill(data.get(), data.get() + width * height, 0);
+}
+
+uint32_t GlyphAtlas::getFontStackID(const std::string& face_name) {
+    return fontStacks.emplace(face_name, uint32_t(fontStacks.size())).first->second;
 }
 
 Rect<uint16_t> GlyphAtlas::addGlyph(uint64_t tile_id, const std::string& face_name,
-                                    const SDFGlyph& glyph)
+                                    const SDFGlyphRef& glyph)
 {
     std::lock_guard<std::mutex> lock(mtx);
-    return addGlyph_impl(tile_id, face_name, glyph);
+    return addGlyph_impl(tile_id, getFontStackID(face_name), face_name, glyph);
 }
 
-Rect<uint16_t> GlyphAtlas::addGlyph_impl(uint64_t tile_id, const std::string& face_name,
-                                    const SDFGlyph& glyph)
+Rect<uint16_t> GlyphAtlas::addGlyph_impl(uint64_t tile_id, uint32_t face_id, const std::string& face_name,
+                                    const SDFGlyphRef& glyph)
 {
     // Use constant value for now.
     const uint8_t buffer = 3;
 
-    std::map<uint32_t, GlyphValue>& face = index[face_name];
-    std::map<uint32_t, GlyphValue>::iterator it = face.find(glyph.id);
+    const uint64_t key = (uint64_t(face_id) << 32) | glyph.id;
+    auto it = index.find(key);
 
     // The glyph is already in this texture.
-    if (it != face.end()) {
+    if (it != index.end()) {
         GlyphValue& value = it->second;
-        value.ids.insert(tile_id);
+        if (tiles[tile_id].insert(&value).second) {
+            value.refs++;
+        }
         return value.rect;
     }
 
     // The glyph bitmap has zero width.
-    if (!glyph.bitmap.size()) {
+    if (!glyph.bitmapSize) {
         return Rect<uint16_t>{ 0, 0, 0, 0 };
     }
 
@@ -60,19 +70,25 @@ Rect<uint16_t> GlyphAtlas::addGlyph_impl(uint64_t tile_id, const std::string& fa
     pack_height += (4 - pack_height % 4);
 
     Rect<uint16_t> rect = bin.allocate(pack_width, pack_height);
+    if (rect.w == 0 && evictUnused()) {
+        rect = bin.allocate(pack_width, pack_height);
+    }
     if (rect.w == 0) {
-        fprintf(stderr, "glyph bitmap overflow");
+        Log::Warning(Event::OpenGL, "glyph atlas is full, not adding glyph %u of %s", glyph.id,
+                     face_name.c_str());
         return rect;
     }
 
     assert(rect.x + rect.w <= width);
     assert(rect.y + rect.h <= height);
 
-    face.emplace(glyph.id, GlyphValue { rect, tile_id });
+    GlyphValue& value = index.emplace(key, GlyphValue { rect }).first->second;
+    tiles[tile_id].insert(&value);
+    value.refs = 1;
 
     // Copy the bitmap
     char *target = data.get();
-    const char *source = glyph.bitmap.data();
+    const char *source = glyph.bitmap;
     for (uint32_t y = 0; y < buffered_height; y++) {
         uint32_t y1 = width * (rect.y + y) + rect.x;
         uint32_t y2 = buffered_width * y;
@@ -81,24 +97,58 @@ Rect<uint16_t> GlyphAtlas::addGlyph_impl(uint64_t tile_id, const std::string& fa
         }
     }
 
-    dirty = true;
+    markDirty(rect);
 
     return rect;
 }
 
+bool GlyphAtlas::evictUnused() {
+    bool evicted = false;
+    for (auto it = index.begin(); it != index.end(); /* we advance in the body */) {
+        if (!it->second.refs) {
+            clearRect(it->second.rect);
+            bin.release(it->second.rect);
+            it = index.erase(it);
+            evicted = true;
+        } else {
+            ++it;
+        }
+    }
+    return evicted;
+}
+
+void GlyphAtlas::clearRect(const Rect<uint16_t> &rect) {
+    char *target = data.get();
+    for (uint32_t y = 0; y < rect.h; y++) {
+        std::fill(target + width * (rect.y + y) + rect.x,
+                  target + width * (rect.y + y) + rect.x + rect.w, 0);
+    }
+    markDirty(rect);
+}
+
+void GlyphAtlas::markDirty(const Rect<uint16_t> &rect) {
+    if (dirtyTop == dirtyBottom) {
+        dirtyTop = rect.y;
+        dirtyBottom = rect.y + rect.h;
+    } else {
+        dirtyTop = std::min(dirtyTop, rect.y);
+        dirtyBottom = std::max<uint16_t>(dirtyBottom, rect.y + rect.h);
+    }
+    dirty = true;
+}
+
 void GlyphAtlas::addGlyphs(uint64_t tileid, std::u32string const& text, std::string const& stackname, FontStack const& fontStack, GlyphPositions & face)
 {
     std::lock_guard<std::mutex> lock(mtx);
+    const uint32_t face_id = getFontStackID(stackname);
 
-    std::map<uint32_t, SDFGlyph> const& sdfs = fontStack.getSDFs();
     for (uint32_t chr : text)
     {
-        auto sdf_it = sdfs.find(chr);
-        if (sdf_it != sdfs.end())
+        const SDFGlyphRef *sdf = fontStack.getSDF(chr);
+        if (sdf)
         {
-            SDFGlyph const& sdf = sdf_it->second;
-            Rect<uint16_t> rect = addGlyph_impl(tileid, stackname, sdf);
-            face.emplace(chr, Glyph{rect, sdf.metrics});
+            Rect<uint16_t> rect = addGlyph_impl(tileid, face_id, stackname, *sdf);
+            face.emplace(chr, Glyph{rect, sdf->metrics});
         }
     }
 }
@@ -106,44 +156,27 @@ void GlyphAtlas::addGlyphs(uint64_t tileid, std::u32string const& text, std::str
 void GlyphAtlas::removeGlyphs(uint64_t tile_id) {
     std::lock_guard<std::mutex> lock(mtx);
 
-    for (auto& faces : index) {
-        std::map<uint32_t, GlyphValue>& face = faces.second;
-        for (auto it = face.begin(); it != face.end(); /* we advance in the body */) {
-            GlyphValue& value = it->second;
-            value.ids.erase(tile_id);
-
-            if (!value.ids.size()) {
-                const Rect<uint16_t>& rect = value.rect;
-
-                // Clear out the bitmap.
-                char *target = data.get();
-                for (uint32_t y = 0; y < rect.h; y++) {
-                    uint32_t y1 = width * (rect.y + y) + rect.x;
-                    for (uint32_t x = 0; x < rect.w; x++) {
-                        target[y1 + x] = 0;
-                    }
-                }
-
-                dirty = true;
-
-                bin.release(rect);
-
-                // Make sure to post-increment the iterator: This will return the
-                // current iterator, but will go to the next position before we
-                // erase the element from the map. That way, the iterator stays
-                // valid.
-                face.erase(it++);
-            } else {
-                ++it;
-            }
-        }
+    auto it = tiles.find(tile_id);
+    if (it == tiles.end()) {
+        return;
+    }
+    for (GlyphValue *glyph : it->second) {
+        glyph->refs--;
     }
+    tiles.erase(it);
+}
+
+MemoryUsage GlyphAtlas::memoryUsage() const {
+    // One alpha byte per pixel, both in memory and in the texture.
+    const uint64_t bytes = uint64_t(width) * height;
+    return MemoryUsage(bytes, texture ? bytes : 0);
 }
 
 void GlyphAtlas::bind() {
-    if (!texture) {
+    const bool first = !texture;
+    if (first) {
         MBGL_CHECK_ERROR(glGenTextures(1, &texture));
-        MBGL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
+        gl::State::Get().bindTexture(texture);
 #ifndef GL_ES_VERSION_2_0
         MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
 #endif
@@ -152,12 +185,19 @@ void GlyphAtlas::bind() {
         MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
         MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
     } else {
-        MBGL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
+        gl::State::Get().bindTexture(texture);
     }
 
     if (dirty) {
         std::lock_guard<std::mutex> lock(mtx);
-        MBGL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, width, height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, data.get()));
+        if (first) {
+            MBGL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, width, height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, data.get()));
+        } else if (dirtyTop < dirtyBottom) {
+            // OpenGL ES 2 can't upload part of a row from client memory, so we upload whole rows.
+            MBGL_CHECK_ERROR(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirtyTop, width, dirtyBottom - dirtyTop,
+                                             GL_ALPHA, GL_UNSIGNED_BYTE, data.get() + width * dirtyTop));
+        }
+        dirtyTop = dirtyBottom = 0;
         dirty = false;
 
 #if defined(DEBUG)
@@ -1,13 +1,15 @@
 #ifndef MBGL_GEOMETRY_GLYPH_ATLAS
 #define MBGL_GEOMETRY_GLYPH_ATLAS
 
-#include <mbgl/geometry/binpack.hpp>
+#include <mbgl/geometry/shelf_pack.hpp>
 #include <mbgl/text/glyph_store.hpp>
 #include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/memory_usage.hpp>
 
 #include <string>
-#include <set>
-#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <mutex>
 #include <atomic>
 
@@ -18,34 +20,57 @@ public:
 
 private:
     struct GlyphValue {
-        GlyphValue(const Rect<uint16_t>& rect_, uint64_t id)
-            : rect(rect_), ids({ id }) {}
+        GlyphValue(const Rect<uint16_t>& rect_)
+            : rect(rect_) {}
         Rect<uint16_t> rect;
-        std::set<uint64_t> ids;
+        // The number of tiles that use the glyph.
+        uint32_t refs = 0;
     };
 
-    Rect<uint16_t> addGlyph_impl(uint64_t tile_id, const std::string& face_name,
-                                 const SDFGlyph& glyph);
+    // Returns the number that stands for the font stack in the index.
+    uint32_t getFontStackID(const std::string& face_name);
+
+    Rect<uint16_t> addGlyph_impl(uint64_t tile_id, uint32_t face_id, const std::string& face_name,
+                                 const SDFGlyphRef& glyph);
+
+    // Frees the glyphs that no tile uses anymore. Returns whether there were any.
+    bool evictUnused();
+    void clearRect(const Rect<uint16_t> &rect);
+    void markDirty(const Rect<uint16_t> &rect);
 public:
     GlyphAtlas(uint16_t width, uint16_t height);
 
     Rect<uint16_t> addGlyph(uint64_t tile_id, const std::string& face_name,
-                            const SDFGlyph& glyph);
+                            const SDFGlyphRef& glyph);
     void addGlyphs(uint64_t tileid, std::u32string const& text, std::string const& stackname,
                    FontStack const& fontStack, GlyphPositions & face);
+    // Glyphs that no tile uses anymore stay in the atlas, so that they don't have to be copied
+    // again when a tile that uses them comes back, until their space is needed.
     void removeGlyphs(uint64_t tile_id);
+
+    // Uploads the rows that changed since the last call.
     void bind();
 
+    MemoryUsage memoryUsage() const;
+
 public:
     const uint16_t width = 0;
     const uint16_t height = 0;
 
 private:
     std::mutex mtx;
-    BinPack<uint16_t> bin;
-    std::map<std::string, std::map<uint32_t, GlyphValue>> index;
+    ShelfPack<uint16_t> bin;
+    std::unordered_map<std::string, uint32_t> fontStacks;
+    // Keyed by the ID of the font stack in the upper and the code point in the lower 32 bits.
+    std::unordered_map<uint64_t, GlyphValue> index;
+    // The glyphs that each tile uses, so that removing a tile doesn't have to visit all glyphs.
+    // Glyphs are only evicted once no tile uses them, so the pointers stay valid.
+    std::unordered_map<uint64_t, std::unordered_set<GlyphValue *>> tiles;
     std::unique_ptr<char[]> data;
     std::atomic<bool> dirty;
+    // The rows that need to be uploaded, guarded by mtx.
+    uint16_t dirtyTop = 0;
+    uint16_t dirtyBottom = 0;
     uint32_t texture = 0;
 };
 
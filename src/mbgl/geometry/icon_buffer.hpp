@@ -3,17 +3,16 @@
 
 #include <mbgl/geometry/buffer.hpp>
 
-#include <array>
-
 namespace mbgl {
 
+    // Same layout as TextVertexBuffer.
     class IconVertexBuffer : public Buffer<
-    16
+    12
     > {
     public:
         static const double angleFactor;
 
-        size_t add(int16_t x, int16_t y, float ox, float oy, int16_t tx, int16_t ty, float angle, float minzoom, std::array<float, 2> range, float maxzoom, float labelminzoom);
+        size_t add(int16_t x, int16_t y, float ox, float oy, int16_t tx, int16_t ty, float angle, float maxzoom);
 
     };
 
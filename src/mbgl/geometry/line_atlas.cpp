@@ -1,6 +1,8 @@
 #include <mbgl/geometry/line_atlas.hpp>
 #include <mbgl/platform/gl.hpp>
+#include <mbgl/platform/gl_state.hpp>
 #include <mbgl/platform/platform.hpp>
+#include <mbgl/platform/log.hpp>
 
 #include <sstream>
 #include <cmath>
@@ -17,7 +19,7 @@ LineAtlas::LineAtlas(uint16_t w, uint16_t h)
 LineAtlas::~LineAtlas() {
     std::lock_guard<std::recursive_mutex> lock(mtx);
 
-    MBGL_CHECK_ERROR(glDeleteTextures(1, &texture));
+    gl::State::Get().deleteTextures(1, &texture);
     texture = 0;
 }
 
@@ -46,7 +48,7 @@ LinePatternPos LineAtlas::addDash(const std::vector<float> &dasharray, bool roun
     const uint8_t offset = 128;
 
     if (nextRow + dashheight > height) {
-        fprintf(stderr, "[WARNING] line atlas bitmap overflow\n");
+        Log::Warning(Event::OpenGL, "line atlas bitmap overflow");
         return LinePatternPos();
     }
 
@@ -122,20 +124,26 @@ LinePatternPos LineAtlas::addDash(const std::vector<float> &dasharray, bool roun
     return position;
 };
 
+MemoryUsage LineAtlas::memoryUsage() const {
+    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const uint64_t bytes = uint64_t(width) * height;
+    return MemoryUsage(bytes, texture ? bytes : 0);
+}
+
 void LineAtlas::bind() {
     std::lock_guard<std::recursive_mutex> lock(mtx);
 
     bool first = false;
     if (!texture) {
         MBGL_CHECK_ERROR(glGenTextures(1, &texture));
-        MBGL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
+        gl::State::Get().bindTexture(texture);
         MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
         MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
         MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
         MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
         first = true;
     } else {
-        MBGL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
+        gl::State::Get().bindTexture(texture);
     }
 
     if (dirty) {
@@ -151,20 +159,22 @@ void LineAtlas::bind() {
                 GL_UNSIGNED_BYTE, // GLenum type
                 data // const GLvoid * data
             );
-        } else {
+        } else if (dirtyTop < nextRow) {
+            // Dashes are only ever appended, so only the rows after the last upload changed.
             glTexSubImage2D(
                 GL_TEXTURE_2D, // GLenum target
                 0, // GLint level
                 0, // GLint xoffset
-                0, // GLint yoffset
+                dirtyTop, // GLint yoffset
                 width, // GLsizei width
-                height, // GLsizei height
+                nextRow - dirtyTop, // GLsizei height
                 GL_ALPHA, // GLenum format
                 GL_UNSIGNED_BYTE, // GLenum type
-                data // const GLvoid *pixels
+                data + width * dirtyTop // const GLvoid *pixels
             );
         }
 
+        dirtyTop = nextRow;
 
         dirty = false;
     }
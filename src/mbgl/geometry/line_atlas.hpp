@@ -1,6 +1,8 @@
 #ifndef MBGL_GEOMETRY_LINE_ATLAS
 #define MBGL_GEOMETRY_LINE_ATLAS
 
+#include <mbgl/util/memory_usage.hpp>
+
 #include <vector>
 #include <map>
 #include <mutex>
@@ -21,6 +23,8 @@ public:
 
     void bind();
 
+    MemoryUsage memoryUsage() const;
+
     LinePatternPos getDashPosition(const std::vector<float>&, bool);
     LinePatternPos addDash(const std::vector<float> &dasharray, bool round);
 
@@ -28,9 +32,11 @@ public:
     const int height;
 
 private:
-    std::recursive_mutex mtx;
+    mutable std::recursive_mutex mtx;
     char *const data = nullptr;
     std::atomic<bool> dirty;
+    // The rows that were added since the last upload.
+    int dirtyTop = 0;
     uint32_t texture = 0;
     int nextRow = 0;
     std::map<std::string, LinePatternPos> positions;
@@ -2,6 +2,7 @@
 
 #include <mbgl/util/interpolate.hpp>
 
+#include <algorithm>
 #include <cmath>
 
 namespace mbgl {
@@ -25,36 +26,52 @@ Anchors resample(const std::vector<Coordinate> &vertices, float spacing,
     const std::vector<float> &minScales = minScaleArrays[index];
     const size_t len = minScales.size();
 
-    float distance = 0.0f;
-    float markedDistance = 0.0f;
-    int added = start;
-
     Anchors points;
+    if (vertices.size() < 2 || spacing <= 0) {
+        return points;
+    }
 
-    auto end = vertices.end() - 1;
-    int i = 0;
-    for (auto it = vertices.begin(); it != end; it++, i++) {
-        const Coordinate &a = *(it), b = *(it + 1);
+    // The distance along the line at which each vertex is.
+    std::vector<float> distances(vertices.size());
+    distances[0] = 0.0f;
+    for (size_t i = 1; i < vertices.size(); i++) {
+        distances[i] = distances[i - 1] + util::dist<float>(vertices[i - 1], vertices[i]);
+    }
 
-        float segmentDist = util::dist<float>(a, b);
-        float angle = util::angle_to(b, a);
+    // An anchor every /spacing/, up to the end of the line.
+    size_t count = 0;
+    while ((count + 1) * spacing < distances.back()) {
+        count++;
+    }
+    points.reserve(count);
+
+    // The scales of the anchors repeat with the period of /minScales/, so instead of sorting
+    // them, we walk the line once for every scale, lowest first.
+    std::vector<float> scales = minScales;
+    std::sort(scales.begin(), scales.end());
+    scales.erase(std::unique(scales.begin(), scales.end()), scales.end());
+
+    for (const float scale : scales) {
+        size_t segment = 0;
+        for (size_t n = 0; n < count; n++) {
+            if (minScales[(start + n) % len] != scale) {
+                continue;
+            }
 
-        while (markedDistance + spacing < distance + segmentDist) {
-            markedDistance += spacing;
+            const float markedDistance = (n + 1) * spacing;
+            while (distances[segment + 1] <= markedDistance) {
+                segment++;
+            }
 
-            float t = (markedDistance - distance) / segmentDist,
-                  x = util::interpolate(a.x, b.x, t),
-                  y = util::interpolate(a.y, b.y, t),
-                  s = minScales[added % len];
+            const Coordinate &a = vertices[segment], &b = vertices[segment + 1];
+            const float t = (markedDistance - distances[segment]) / (distances[segment + 1] - distances[segment]),
+                        x = util::interpolate(a.x, b.x, t),
+                        y = util::interpolate(a.y, b.y, t);
 
             if (x >= 0 && x < 4096 && y >= 0 && y < 4096) {
-                points.emplace_back(x, y, angle, s, i);
+                points.emplace_back(x, y, util::angle_to(b, a), scale, segment);
             }
-
-            added++;
         }
-
-        distance += segmentDist;
     }
 
     return points;
@@ -6,6 +6,9 @@
 
 namespace mbgl {
 
+// Places anchors along the line every /spacing/ pixels, with the scales at which they show up
+// alternating so that fewer anchors are shown when zoomed out. The anchors are ordered by scale,
+// lowest first, and along the line within a scale.
 Anchors resample(const std::vector<Coordinate> &vertices, float spacing,
                  float minScale, float maxScale, float tilePixelRatio, int start = 0);
 }
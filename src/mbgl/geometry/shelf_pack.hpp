@@ -0,0 +1,158 @@
+#ifndef MBGL_GEOMETRY_SHELF_PACK
+#define MBGL_GEOMETRY_SHELF_PACK
+
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/rect.hpp>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <vector>
+
+namespace mbgl {
+
+// Packs rectangles of similar height, like glyphs, into rows ("shelves") that span the whole
+// width. Released rectangles leave a gap in their shelf that later rectangles of the same height
+// reuse, so unlike a guillotine packer the free space doesn't get chopped into ever smaller
+// pieces. Empty shelves at the bottom are given back, and empty shelves in between are reused for
+// rectangles that are at most as high.
+template <typename T>
+class ShelfPack : private util::noncopyable {
+public:
+    ShelfPack(T width_, T height_) : width(width_), height(height_) {}
+
+    Rect<T> allocate(T w, T h) {
+        if (w == 0 || h == 0 || w > width) {
+            return Rect<T>{ 0, 0, 0, 0 };
+        }
+
+        // Find the shelf that wastes the least height.
+        Shelf *best = nullptr;
+        for (Shelf &shelf : shelves) {
+            if (shelf.h >= h && (!best || shelf.h < best->h) && fits(shelf, w)) {
+                best = &shelf;
+            }
+        }
+
+        // Open a new shelf when the best one would waste more than half of its height.
+        if ((!best || best->h - h > h / 2) && top + h <= height) {
+            shelves.emplace_back(top, h);
+            top += h;
+            best = &shelves.back();
+        }
+
+        if (!best) {
+            return Rect<T>{ 0, 0, 0, 0 };
+        }
+
+        return place(*best, w, h);
+    }
+
+    void release(const Rect<T> &rect) {
+        for (auto it = shelves.begin(); it != shelves.end(); ++it) {
+            Shelf &shelf = *it;
+            if (shelf.y != rect.y) {
+                continue;
+            }
+
+            shelf.count--;
+            if (shelf.count == 0) {
+                shelf.x = 0;
+                shelf.gaps.clear();
+            } else if (rect.x + rect.w == shelf.x) {
+                shelf.x = rect.x;
+                // The gap before the released rectangle may now touch the end of the shelf.
+                if (!shelf.gaps.empty() && shelf.gaps.back().first + shelf.gaps.back().second == shelf.x) {
+                    shelf.x = shelf.gaps.back().first;
+                    shelf.gaps.pop_back();
+                }
+            } else {
+                addGap(shelf, rect.x, rect.w);
+            }
+
+            // Give back empty shelves at the bottom.
+            while (!shelves.empty() && shelves.back().count == 0) {
+                top = shelves.back().y;
+                shelves.pop_back();
+            }
+            return;
+        }
+    }
+
+    void clear() {
+        shelves.clear();
+        top = 0;
+    }
+
+private:
+    struct Shelf {
+        Shelf(T y_, T h_) : y(y_), h(h_) {}
+
+        const T y;
+        const T h;
+        // Where the unused space at the end of the shelf starts.
+        T x = 0;
+        uint32_t count = 0;
+        // Unused pieces before x as (x, width), sorted by x and never adjacent.
+        std::vector<std::pair<T, T>> gaps;
+    };
+
+    bool fits(const Shelf &shelf, T w) const {
+        if (width - shelf.x >= w) {
+            return true;
+        }
+        for (const auto &gap : shelf.gaps) {
+            if (gap.second >= w) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Rect<T> place(Shelf &shelf, T w, T h) {
+        shelf.count++;
+        for (auto it = shelf.gaps.begin(); it != shelf.gaps.end(); ++it) {
+            if (it->second >= w) {
+                const Rect<T> rect { it->first, shelf.y, w, h };
+                it->first += w;
+                it->second -= w;
+                if (it->second == 0) {
+                    shelf.gaps.erase(it);
+                }
+                return rect;
+            }
+        }
+
+        const Rect<T> rect { shelf.x, shelf.y, w, h };
+        shelf.x += w;
+        return rect;
+    }
+
+    void addGap(Shelf &shelf, T x, T w) {
+        auto it = shelf.gaps.begin();
+        while (it != shelf.gaps.end() && it->first < x) {
+            ++it;
+        }
+
+        // Merge with the gaps right before and after.
+        if (it != shelf.gaps.begin() && std::prev(it)->first + std::prev(it)->second == x) {
+            --it;
+            it->second += w;
+        } else {
+            it = shelf.gaps.emplace(it, x, w);
+        }
+        auto next = std::next(it);
+        if (next != shelf.gaps.end() && it->first + it->second == next->first) {
+            it->second += next->second;
+            shelf.gaps.erase(next);
+        }
+    }
+
+    const T width;
+    const T height;
+    T top = 0;
+    std::list<Shelf> shelves;
+};
+
+}
+
+#endif
@@ -1,15 +1,19 @@
 #include <mbgl/geometry/sprite_atlas.hpp>
 #include <mbgl/platform/gl.hpp>
+#include <mbgl/platform/gl_state.hpp>
 #include <mbgl/platform/platform.hpp>
 #include <mbgl/util/math.hpp>
 #include <mbgl/util/std.hpp>
 #include <mbgl/util/constants.hpp>
 
 #include <mbgl/map/sprite.hpp>
+#include <mbgl/platform/log.hpp>
 
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
+#include <vector>
 
 
 using namespace mbgl;
@@ -54,6 +58,7 @@ bool SpriteAtlas::resize(const float newRatio) {
         }
 
         ::operator delete(old_data);
+        resized = true;
         dirty = true;
 
         // Mark all sprite images as in need of update
@@ -71,9 +76,7 @@ void copy_bitmap(const uint32_t *src, const int src_stride, const int src_x, con
     src += src_y * src_stride + src_x;
     dst += dst_y * dst_stride + dst_x;
     for (int y = 0; y < height; y++, src += src_stride, dst += dst_stride) {
-        for (int x = 0; x < width; x++) {
-            dst[x] = src[x];
-        }
+        std::memcpy(dst, src, width * sizeof(uint32_t));
     }
 }
 
@@ -113,7 +116,7 @@ Rect<SpriteAtlas::dimension> SpriteAtlas::getImage(const std::string& name) {
     Rect<dimension> rect = allocateImage(pos.width / pos.pixelRatio, pos.height / pos.pixelRatio);
     if (rect.w == 0) {
         if (debug::spriteWarnings) {
-            fprintf(stderr, "[WARNING] sprite atlas bitmap overflow\n");
+            Log::Warning(Event::Sprite, "sprite atlas bitmap overflow");
         }
         return rect;
     }
@@ -177,6 +180,17 @@ void SpriteAtlas::copy(const Rect<dimension>& dst, const SpritePosition& src) {
         /* icon dimension */ src.height
     );
 
+    markDirty(dst.y * pixelRatio, dst.y * pixelRatio + src.height);
+}
+
+void SpriteAtlas::markDirty(int top, int bottom) {
+    if (dirtyTop == dirtyBottom) {
+        dirtyTop = top;
+        dirtyBottom = bottom;
+    } else {
+        dirtyTop = std::min(dirtyTop, top);
+        dirtyBottom = std::max(dirtyBottom, bottom);
+    }
     dirty = true;
 }
 
@@ -187,12 +201,17 @@ void SpriteAtlas::setSprite(util::ptr<Sprite> sprite_) {
 
     if (!sprite->isLoaded()) return;
 
+    if (preloaded != sprite) {
+        preloaded = sprite;
+        preload();
+    }
+
     util::erase_if(uninitialized, [this](const std::string &name) {
         Rect<dimension> dst = getImage(name);
         const SpritePosition& src = sprite->getSpritePosition(name);
         if (!src) {
             if (debug::spriteWarnings) {
-                fprintf(stderr, "[WARNING] sprite doesn't have image with name '%s'\n", name.c_str());
+                Log::Warning(Event::Sprite, "sprite doesn't have image with name '%s'", name.c_str());
             }
             return true;
         }
@@ -202,18 +221,60 @@ void SpriteAtlas::setSprite(util::ptr<Sprite> sprite_) {
             return true;
         } else {
             if (debug::spriteWarnings) {
-                fprintf(stderr, "[WARNING] sprite icon dimension mismatch\n");
+                Log::Warning(Event::Sprite, "sprite icon dimension mismatch");
             }
             return false;
         }
     });
 }
 
+void SpriteAtlas::preload() {
+    if (!sprite->raster || !sprite->raster->getData() || sprite->pixelRatio != pixelRatio) {
+        return;
+    }
+
+    // A sheet that is larger than the atlas would push out the images that are actually used.
+    if (sprite->raster->getWidth() > width * pixelRatio ||
+        sprite->raster->getHeight() > height * pixelRatio) {
+        return;
+    }
+
+    // Tall images go first, so that the rows of the bin are filled evenly.
+    std::vector<std::pair<const std::string *, const SpritePosition *>> pending;
+    for (const auto &pair : sprite->getSpritePositions()) {
+        if (pair.second.width && pair.second.height && images.find(pair.first) == images.end()) {
+            pending.emplace_back(&pair.first, &pair.second);
+        }
+    }
+    std::sort(pending.begin(), pending.end(), [](const std::pair<const std::string *, const SpritePosition *> &a,
+                                                 const std::pair<const std::string *, const SpritePosition *> &b) {
+        return a.second->height != b.second->height ? a.second->height > b.second->height
+                                                    : *a.first < *b.first;
+    });
+
+    for (const auto &image : pending) {
+        const SpritePosition &pos = *image.second;
+        Rect<dimension> rect = allocateImage(pos.width / pos.pixelRatio, pos.height / pos.pixelRatio);
+        if (rect.w == 0) {
+            // The remaining images are copied when they are first used.
+            return;
+        }
+        images.emplace(*image.first, rect);
+        copy(rect, pos);
+    }
+}
+
+MemoryUsage SpriteAtlas::memoryUsage() const {
+    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const uint64_t bytes = uint64_t(getTextureWidth()) * uint64_t(getTextureHeight()) * sizeof(uint32_t);
+    return MemoryUsage(data ? bytes : 0, texture ? bytes : 0);
+}
+
 void SpriteAtlas::bind(bool linear) {
     bool first = false;
     if (!texture) {
         MBGL_CHECK_ERROR(glGenTextures(1, &texture));
-        MBGL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
+        gl::State::Get().bindTexture(texture);
 #ifndef GL_ES_VERSION_2_0
         MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
 #endif
@@ -221,7 +282,7 @@ void SpriteAtlas::bind(bool linear) {
         MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
         first = true;
     } else {
-        MBGL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
+        gl::State::Get().bindTexture(texture);
     }
 
     GLuint filter_val = linear ? GL_LINEAR : GL_NEAREST;
@@ -235,32 +296,40 @@ void SpriteAtlas::bind(bool linear) {
         std::lock_guard<std::recursive_mutex> lock(mtx);
         allocate();
 
-        if (first) {
+        const int textureWidth = width * pixelRatio;
+        const int textureHeight = height * pixelRatio;
+        dirtyBottom = std::min(dirtyBottom, textureHeight);
+
+        if (first || resized) {
             glTexImage2D(
                 GL_TEXTURE_2D, // GLenum target
                 0, // GLint level
                 GL_RGBA, // GLint internalformat
-                width * pixelRatio, // GLsizei width
-                height * pixelRatio, // GLsizei height
+                textureWidth, // GLsizei width
+                textureHeight, // GLsizei height
                 0, // GLint border
                 GL_RGBA, // GLenum format
                 GL_UNSIGNED_BYTE, // GLenum type
                 data // const GLvoid * data
             );
-        } else {
+        } else if (dirtyTop < dirtyBottom) {
+            // Only upload the rows that changed. OpenGL ES 2 can't upload part of a row from
+            // client memory, so we upload whole rows.
             glTexSubImage2D(
                 GL_TEXTURE_2D, // GLenum target
                 0, // GLint level
                 0, // GLint xoffset
-                0, // GLint yoffset
-                width * pixelRatio, // GLsizei width
-                height * pixelRatio, // GLsizei height
+                dirtyTop, // GLint yoffset
+                textureWidth, // GLsizei width
+                dirtyBottom - dirtyTop, // GLsizei height
                 GL_RGBA, // GLenum format
                 GL_UNSIGNED_BYTE, // GLenum type
-                data // const GLvoid *pixels
+                data + dirtyTop * textureWidth // const GLvoid *pixels
             );
         }
 
+        dirtyTop = dirtyBottom = 0;
+        resized = false;
         dirty = false;
 
         // platform::show_color_debug_image("Sprite Atlas", reinterpret_cast<const char *>(data), width, height, width * pixelRatio, height * pixelRatio);
@@ -270,7 +339,7 @@ void SpriteAtlas::bind(bool linear) {
 SpriteAtlas::~SpriteAtlas() {
     std::lock_guard<std::recursive_mutex> lock(mtx);
 
-    MBGL_CHECK_ERROR(glDeleteTextures(1, &texture));
+    gl::State::Get().deleteTextures(1, &texture);
     texture = 0;
     ::operator delete(data), data = nullptr;
 }
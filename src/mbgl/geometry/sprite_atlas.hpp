@@ -5,6 +5,7 @@
 
 #include <mbgl/util/noncopyable.hpp>
 #include <mbgl/util/ptr.hpp>
+#include <mbgl/util/memory_usage.hpp>
 
 #include <string>
 #include <map>
@@ -39,7 +40,8 @@ public:
     // Changes the pixel ratio.
     bool resize(float newRatio);
 
-    // Changes the source sprite.
+    // Changes the source sprite. Once the sprite is loaded, all of its images are copied into the
+    // atlas in one go if they fit, so that getImage() only has to look them up.
     void setSprite(util::ptr<Sprite> sprite);
 
     // Returns the coordinates of an image that is sourced from the sprite image.
@@ -54,6 +56,8 @@ public:
     // of date.
     void bind(bool linear = false);
 
+    MemoryUsage memoryUsage() const;
+
     inline float getWidth() const { return width; }
     inline float getHeight() const { return height; }
     inline float getTextureWidth() const { return width * pixelRatio; }
@@ -67,15 +71,24 @@ private:
     void allocate();
     Rect<SpriteAtlas::dimension> allocateImage(size_t width, size_t height);
     void copy(const Rect<dimension>& dst, const SpritePosition& src);
+    void preload();
+    void markDirty(int top, int bottom);
 
-    std::recursive_mutex mtx;
+    mutable std::recursive_mutex mtx;
     float pixelRatio = 1.0f;
     BinPack<dimension> bin;
     util::ptr<Sprite> sprite;
     std::map<std::string, Rect<dimension>> images;
     std::set<std::string> uninitialized;
+    // The sprite whose images were all copied by preload(), if any.
+    util::ptr<Sprite> preloaded;
     uint32_t *data = nullptr;
     std::atomic<bool> dirty;
+    // The rows of the texture that need to be uploaded, or the whole texture after it changed its
+    // size.
+    int dirtyTop = 0;
+    int dirtyBottom = 0;
+    bool resized = true;
     uint32_t texture = 0;
     uint32_t filter = 0;
     static const int buffer = 1;
@@ -13,7 +13,8 @@ namespace mbgl {
 class StaticVertexBuffer : public Buffer<
     4, // bytes per vertex (2 * signed short == 4 bytes)
     GL_ARRAY_BUFFER,
-    32 // default length
+    32, // default length
+    true // retained, so that it survives the loss of the GL context
 > {
 public:
     typedef int16_t vertex_type;
@@ -0,0 +1,46 @@
+#include <mbgl/geometry/symbol_instance_buffer.hpp>
+#include <mbgl/platform/gl.hpp>
+
+#include <cmath>
+
+namespace mbgl {
+
+const double SymbolInstanceBuffer::angleFactor = 128.0 / M_PI;
+
+size_t SymbolInstanceBuffer::add(int16_t x, int16_t y, const vec2<float> &tl, const vec2<float> &tr,
+                                 const vec2<float> &bl, const vec2<float> &br, const Rect<uint16_t> &tex,
+                                 float angle, float maxzoom) {
+    const size_t idx = index();
+    void *data = addElement();
+
+    int16_t *shorts = static_cast<int16_t *>(data);
+    shorts[0] /* pos */ = x;
+    shorts[1] /* pos */ = y;
+
+    // a_offset1, a_offset2; use 1/64 pixels for placement
+    shorts[2] /* tl */ = std::round(tl.x * 64);
+    shorts[3] /* tl */ = std::round(tl.y * 64);
+    shorts[4] /* tr */ = std::round(tr.x * 64);
+    shorts[5] /* tr */ = std::round(tr.y * 64);
+    shorts[6] /* bl */ = std::round(bl.x * 64);
+    shorts[7] /* bl */ = std::round(bl.y * 64);
+    shorts[8] /* br */ = std::round(br.x * 64);
+    shorts[9] /* br */ = std::round(br.y * 64);
+
+    uint8_t *ubytes = static_cast<uint8_t *>(data);
+    // a_data1
+    ubytes[20] /* tex */ = tex.x / 4;
+    ubytes[21] /* tex */ = tex.y / 4;
+    ubytes[22] /* tex */ = (tex.x + tex.w) / 4;
+    ubytes[23] /* tex */ = (tex.y + tex.h) / 4;
+
+    // a_data2
+    ubytes[24] /* angle */ = (int16_t)std::round(angle * angleFactor) % 256;
+    ubytes[25] /* maxzoom */ = std::fmin(maxzoom, 25) * 10; // 1/10 zoom levels: z16 == 160.
+    ubytes[26] = 0;
+    ubytes[27] = 0;
+
+    return idx;
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef MBGL_GEOMETRY_SYMBOL_INSTANCE_BUFFER
+#define MBGL_GEOMETRY_SYMBOL_INSTANCE_BUFFER
+
+#include <mbgl/geometry/buffer.hpp>
+#include <mbgl/util/vec.hpp>
+#include <mbgl/util/rect.hpp>
+
+namespace mbgl {
+
+// One element per glyph or icon quad, drawn as instances of a unit quad where the GL has
+// instanced arrays. Instance layout, 28 bytes:
+//   int16 pos.x, pos.y            anchor in tile units
+//   int16 tl, tr, bl, br (x, y)   quad corners relative to the anchor, in 1/64 pixels
+//   uint8 tex tl.x, tl.y, br.x, br.y  atlas rectangle in units of 4 pixels
+//   uint8 angle, maxzoom, 2 bytes padding
+// The encoding of every value is the same as in TextVertexBuffer, which stores a quad in four
+// vertices of 12 bytes plus six indices. The placement of every instance is in a
+// SymbolPlacementBuffer with the same indices.
+class SymbolInstanceBuffer : public Buffer<
+    28,
+    GL_ARRAY_BUFFER,
+    16384
+> {
+public:
+    static const double angleFactor;
+
+    size_t add(int16_t x, int16_t y, const vec2<float> &tl, const vec2<float> &tr,
+               const vec2<float> &bl, const vec2<float> &br, const Rect<uint16_t> &tex,
+               float angle, float maxzoom);
+};
+
+}
+
+#endif
@@ -0,0 +1,41 @@
+#include <mbgl/geometry/symbol_placement_buffer.hpp>
+#include <mbgl/platform/gl.hpp>
+#include <mbgl/util/math.hpp>
+
+#include <cmath>
+
+namespace mbgl {
+
+const double SymbolPlacementBuffer::angleFactor = 128.0 / M_PI;
+
+size_t SymbolPlacementBuffer::add(size_t count) {
+    const size_t idx = index();
+    reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        addElement();
+    }
+    hide(idx, count);
+    return idx;
+}
+
+void SymbolPlacementBuffer::set(size_t first, size_t count, float minzoom, std::array<float, 2> range, float labelminzoom) {
+    uint8_t entry[4];
+    entry[0] /* labelminzoom */ = labelminzoom * 10;
+    entry[1] /* minzoom */ = minzoom * 10; // 1/10 zoom levels: z16 == 160.
+    entry[2] /* rangeend */ = util::max((int16_t)std::round(range[0] * angleFactor), (int16_t)0) % 256;
+    entry[3] /* rangestart */ = util::min((int16_t)std::round(range[1] * angleFactor), (int16_t)255) % 256;
+
+    for (size_t i = first; i < first + count; i++) {
+        std::memcpy(getElement(i), entry, sizeof(entry));
+    }
+}
+
+void SymbolPlacementBuffer::hide(size_t first, size_t count) {
+    // Zoom level 25.5 is beyond the maximum zoom of every vertex.
+    const uint8_t entry[4] = { 255, 255, 0, 0 };
+    for (size_t i = first; i < first + count; i++) {
+        std::memcpy(getElement(i), entry, sizeof(entry));
+    }
+}
+
+}
@@ -0,0 +1,36 @@
+#ifndef MBGL_GEOMETRY_SYMBOL_PLACEMENT_BUFFER
+#define MBGL_GEOMETRY_SYMBOL_PLACEMENT_BUFFER
+
+#include <mbgl/geometry/buffer.hpp>
+
+#include <array>
+
+namespace mbgl {
+
+// The placement of every vertex of a TextVertexBuffer or IconVertexBuffer, or of every instance
+// of a SymbolInstanceBuffer, in a buffer of its own. Layout, 4 bytes:
+//   uint8 labelminzoom, minzoom, rangeend, rangestart
+// with the same encoding as the vertices. Placement overwrites its entries when it runs again,
+// so the buffer keeps them after the upload.
+class SymbolPlacementBuffer : public Buffer<
+    4,
+    GL_ARRAY_BUFFER,
+    8192,
+    true
+> {
+public:
+    static const double angleFactor;
+
+    // Adds /count/ entries for a quad that isn't shown.
+    size_t add(size_t count);
+
+    // Shows the /count/ entries from /first/ on from /minzoom/ on, except at the map angles in
+    // /range/.
+    void set(size_t first, size_t count, float minzoom, std::array<float, 2> range, float labelminzoom);
+
+    void hide(size_t first, size_t count);
+};
+
+}
+
+#endif
@@ -2,12 +2,20 @@
 #define MBGL_GEOMETRY_TEXT_BUFFER
 
 #include <mbgl/geometry/buffer.hpp>
-#include <array>
 
 namespace mbgl {
 
+// Vertex layout, 12 bytes:
+//   int16 pos.x, pos.y    anchor in tile units
+//   int16 offset.x, .y    quad corner relative to the anchor, in 1/64 pixels
+//   uint8 tex.x, tex.y    atlas position in units of 4 pixels
+//   uint8 angle, maxzoom
+// Zoom levels are stored in 1/10 steps and angles in 1/256 turns. All four vertices of a quad
+// carry the same anchor and maximum zoom; where the quad is shown below that depends on the
+// placement, which is in a SymbolPlacementBuffer with the same indices. Where the GL has
+// instanced arrays, symbols go into a SymbolInstanceBuffer instead.
 class TextVertexBuffer : public Buffer <
-    16,
+    12,
     GL_ARRAY_BUFFER,
     32768
 > {
@@ -16,7 +24,7 @@ public:
 
     static const double angleFactor;
 
-    size_t add(int16_t x, int16_t y, float ox, float oy, uint16_t tx, uint16_t ty, float angle, float minzoom, std::array<float, 2> range, float maxzoom, float labelminzoom);
+    size_t add(int16_t x, int16_t y, float ox, float oy, uint16_t tx, uint16_t ty, float angle, float maxzoom);
 };
 
 
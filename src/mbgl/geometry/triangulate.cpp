@@ -0,0 +1,79 @@
+#include <mbgl/geometry/triangulate.hpp>
+
+namespace mbgl {
+
+namespace {
+
+// Twice the signed area of the triangle abc.
+inline ClipperLib::cInt cross(const ClipperLib::IntPoint &a, const ClipperLib::IntPoint &b,
+                              const ClipperLib::IntPoint &c) {
+    return (b.X - a.X) * (c.Y - a.Y) - (b.Y - a.Y) * (c.X - a.X);
+}
+
+// Whether p lies inside of or on the border of the triangle abc, which is oriented like /sign/.
+inline bool inTriangle(const ClipperLib::IntPoint &p, const ClipperLib::IntPoint &a,
+                       const ClipperLib::IntPoint &b, const ClipperLib::IntPoint &c, int sign) {
+    return cross(a, b, p) * sign >= 0 && cross(b, c, p) * sign >= 0 && cross(c, a, p) * sign >= 0;
+}
+
+}
+
+bool triangulate(const ClipperLib::Path &ring, std::vector<uint32_t> &triangles) {
+    const size_t n = ring.size();
+    if (n < 3) {
+        return false;
+    }
+
+    ClipperLib::cInt area = 0;
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        area += (ring[j].X - ring[i].X) * (ring[j].Y + ring[i].Y);
+    }
+    if (area == 0) {
+        return false;
+    }
+    const int sign = area > 0 ? 1 : -1;
+
+    // The vertices that are left form a circular list.
+    std::vector<uint32_t> prev(n), next(n);
+    for (uint32_t i = 0; i < n; i++) {
+        prev[i] = i == 0 ? n - 1 : i - 1;
+        next[i] = i == n - 1 ? 0 : i + 1;
+    }
+
+    const size_t begin = triangles.size();
+    size_t remaining = n;
+    size_t stalled = 0;
+    uint32_t i = 0;
+
+    while (remaining > 3) {
+        const uint32_t a = prev[i], c = next[i];
+
+        // A vertex is an ear if it is convex and no other vertex lies in the triangle it spans.
+        bool ear = cross(ring[a], ring[i], ring[c]) * sign > 0;
+        for (uint32_t v = next[c]; ear && v != a; v = next[v]) {
+            ear = !inTriangle(ring[v], ring[a], ring[i], ring[c], sign);
+        }
+
+        if (ear) {
+            triangles.push_back(a);
+            triangles.push_back(i);
+            triangles.push_back(c);
+            next[a] = c;
+            prev[c] = a;
+            remaining--;
+            stalled = 0;
+        } else if (++stalled > remaining) {
+            // Went around the whole ring without finding an ear.
+            triangles.resize(begin);
+            return false;
+        }
+        i = c;
+    }
+
+    triangles.push_back(prev[i]);
+    triangles.push_back(i);
+    triangles.push_back(next[i]);
+    return true;
+}
+
+}
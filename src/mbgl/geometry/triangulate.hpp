@@ -0,0 +1,19 @@
+#ifndef MBGL_GEOMETRY_TRIANGULATE
+#define MBGL_GEOMETRY_TRIANGULATE
+
+#include <clipper/clipper.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace mbgl {
+
+// Triangulates a simple polygon without holes by clipping ears. This is much cheaper than a full
+// tessellation for the small polygons that most fills consist of, e.g. building footprints.
+// Appends three indices into /ring/ per triangle. Returns false without adding any triangles if
+// the ring is degenerate or touches itself; those need a real tessellator.
+bool triangulate(const ClipperLib::Path &ring, std::vector<uint32_t> &triangles);
+
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include <mbgl/geometry/vao.hpp>
+#include <mbgl/platform/gl_state.hpp>
 #include <mbgl/platform/log.hpp>
 #include <mbgl/util/string.hpp>
 
@@ -7,11 +8,16 @@ namespace mbgl {
 VertexArrayObject::~VertexArrayObject() {
     if (!gl::DeleteVertexArrays) return;
 
-    if (vao) {
-        MBGL_CHECK_ERROR(gl::DeleteVertexArrays(1, &vao));
+    if (vao && context == gl::State::getContextGeneration()) {
+        gl::State::Get().deleteVertexArrays(1, &vao);
     }
 }
 
+void VertexArrayObject::unbind() {
+    if (!gl::BindVertexArray) return;
+    gl::State::Get().bindVertexArray(0);
+}
+
 void VertexArrayObject::bindVertexArrayObject() {
     if (!gl::GenVertexArrays || !gl::BindVertexArray) {
         static bool reported = false;
@@ -22,10 +28,21 @@ void VertexArrayObject::bindVertexArrayObject() {
         return;
     }
 
+    if (vao && context != gl::State::getContextGeneration()) {
+        // The array went away with its context; it is set up again in the new one.
+        vao = 0;
+        bound_shader = 0;
+        bound_shader_name = "";
+        bound_vertex_buffer = 0;
+        bound_elements_buffer = 0;
+        bound_offset = 0;
+    }
+
     if (!vao) {
         MBGL_CHECK_ERROR(gl::GenVertexArrays(1, &vao));
+        context = gl::State::getContextGeneration();
     }
-    MBGL_CHECK_ERROR(gl::BindVertexArray(vao));
+    gl::State::Get().bindVertexArray(vao);
 }
 
 void VertexArrayObject::verifyBinding(Shader &shader, GLuint vertexBuffer, GLuint elementsBuffer,
@@ -15,6 +15,7 @@ public:
 
     inline VertexArrayObject(VertexArrayObject &&rhs) noexcept
         : vao(rhs.vao),
+          context(rhs.context),
           bound_shader(rhs.bound_shader),
           bound_shader_name(rhs.bound_shader_name),
           bound_vertex_buffer(rhs.bound_vertex_buffer),
@@ -50,8 +51,47 @@ public:
         }
     }
 
+    // For shaders that read additional per-vertex or per-instance attributes from a second buffer.
+    template <typename Shader, typename VertexBuffer, typename AttributeBuffer>
+    inline void bind(Shader& shader, VertexBuffer &vertexBuffer, AttributeBuffer &attributeBuffer,
+                     char *offset, char *attributeOffset) {
+        bindVertexArrayObject();
+        if (bound_shader == 0) {
+            vertexBuffer.bind();
+            shader.bind(offset);
+            attributeBuffer.bind();
+            shader.bindAttributes(attributeOffset);
+            if (vao) {
+                storeBinding(shader, vertexBuffer.getID(), 0, offset);
+            }
+        } else {
+            verifyBinding(shader, vertexBuffer.getID(), 0, offset);
+        }
+    }
+
+    template <typename Shader, typename VertexBuffer, typename AttributeBuffer, typename ElementsBuffer>
+    inline void bind(Shader& shader, VertexBuffer &vertexBuffer, AttributeBuffer &attributeBuffer,
+                     ElementsBuffer &elementsBuffer, char *offset, char *attributeOffset) {
+        bindVertexArrayObject();
+        if (bound_shader == 0) {
+            vertexBuffer.bind();
+            shader.bind(offset);
+            attributeBuffer.bind();
+            shader.bindAttributes(attributeOffset);
+            elementsBuffer.bind();
+            if (vao) {
+                storeBinding(shader, vertexBuffer.getID(), elementsBuffer.getID(), offset);
+            }
+        } else {
+            verifyBinding(shader, vertexBuffer.getID(), elementsBuffer.getID(), offset);
+        }
+    }
+
     ~VertexArrayObject();
 
+    // Restores the default vertex array, so that binding buffers doesn't change the last VAO.
+    static void unbind();
+
 private:
     void bindVertexArrayObject();
     void storeBinding(Shader &shader, GLuint vertexBuffer, GLuint elementsBuffer, char *offset);
@@ -59,6 +99,9 @@ private:
 
     GLuint vao = 0;
 
+    // The generation of the GL context that the vertex array belongs to.
+    uint32_t context = 0;
+
     // For debug reasons, we're storing the bind information so that we can
     // detect errors and report
     GLuint bound_shader = 0;
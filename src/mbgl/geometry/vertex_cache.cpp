@@ -0,0 +1,157 @@
+#include <mbgl/geometry/vertex_cache.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace mbgl {
+
+namespace {
+
+// Kept per thread so that the workers don't allocate for every large feature.
+struct VertexCacheState {
+    // The triangles that use a vertex are adjacency[offsets[v]] to adjacency[offsets[v + 1]].
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> adjacency;
+
+    // The number of triangles that use a vertex and haven't been emitted yet.
+    std::vector<uint32_t> live;
+
+    // When a vertex last entered the cache.
+    std::vector<uint32_t> timestamps;
+    std::vector<uint8_t> emitted;
+
+    // Recently used vertices, to continue from when a fan runs out of triangles.
+    std::vector<TESSindex> deadEnd;
+    std::vector<TESSindex> candidates;
+    std::vector<TESSindex> output;
+};
+
+}
+
+bool optimizeVertexCache(std::vector<TESSindex> &elements, size_t vertex_count, size_t cache_size) {
+    const size_t triangle_count = elements.size() / 3;
+    for (const TESSindex index : elements) {
+        if (index < 0 || size_t(index) >= vertex_count) {
+            return false;
+        }
+    }
+    if (triangle_count == 0) {
+        return true;
+    }
+
+    static thread_local VertexCacheState state;
+    std::vector<uint32_t> &offsets = state.offsets;
+    std::vector<uint32_t> &adjacency = state.adjacency;
+    std::vector<uint32_t> &live = state.live;
+    std::vector<uint32_t> &timestamps = state.timestamps;
+    std::vector<TESSindex> &deadEnd = state.deadEnd;
+    std::vector<TESSindex> &candidates = state.candidates;
+    std::vector<TESSindex> &output = state.output;
+
+    offsets.assign(vertex_count + 1, 0);
+    for (size_t i = 0; i < triangle_count * 3; i++) {
+        offsets[elements[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertex_count; v++) {
+        offsets[v + 1] += offsets[v];
+    }
+    live.resize(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++) {
+        live[v] = offsets[v + 1] - offsets[v];
+    }
+
+    // The timestamps serve as insertion cursors while the adjacency is filled in.
+    timestamps.assign(offsets.begin(), offsets.end() - 1);
+    adjacency.resize(triangle_count * 3);
+    for (size_t i = 0; i < triangle_count * 3; i++) {
+        adjacency[timestamps[elements[i]]++] = uint32_t(i / 3);
+    }
+    timestamps.assign(vertex_count, 0);
+    state.emitted.assign(triangle_count, 0);
+    deadEnd.clear();
+    output.clear();
+
+    // Starting past the cache size makes every vertex a miss at first.
+    uint32_t time = uint32_t(cache_size) + 1;
+    size_t cursor = 0;
+    TESSindex fanning = 0;
+
+    while (fanning >= 0) {
+        // Emit all remaining triangles around the fanning vertex.
+        candidates.clear();
+        for (uint32_t k = offsets[fanning]; k < offsets[fanning + 1]; k++) {
+            const uint32_t triangle = adjacency[k];
+            if (state.emitted[triangle]) {
+                continue;
+            }
+            for (size_t j = 0; j < 3; j++) {
+                const TESSindex v = elements[triangle * 3 + j];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - timestamps[v] > cache_size) {
+                    timestamps[v] = time++;
+                }
+            }
+            state.emitted[triangle] = 1;
+        }
+
+        // Continue with the vertex that has been in the cache the longest and is still going to
+        // be in it after its remaining triangles are emitted.
+        fanning = -1;
+        int64_t best_priority = -1;
+        for (const TESSindex v : candidates) {
+            if (live[v] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - timestamps[v] + 2 * live[v] <= cache_size) {
+                priority = time - timestamps[v];
+            }
+            if (priority > best_priority) {
+                best_priority = priority;
+                fanning = v;
+            }
+        }
+
+        if (fanning < 0) {
+            while (!deadEnd.empty()) {
+                const TESSindex v = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[v] > 0) {
+                    fanning = v;
+                    break;
+                }
+            }
+        }
+
+        if (fanning < 0) {
+            while (cursor < vertex_count && live[cursor] == 0) {
+                cursor++;
+            }
+            if (cursor < vertex_count) {
+                fanning = TESSindex(cursor);
+            }
+        }
+    }
+
+    std::copy(output.begin(), output.end(), elements.begin());
+    return true;
+}
+
+size_t vertexCacheMisses(const std::vector<TESSindex> &elements, size_t cache_size) {
+    std::vector<TESSindex> cache(cache_size, -1);
+    size_t next = 0;
+    size_t misses = 0;
+    for (const TESSindex index : elements) {
+        if (std::find(cache.begin(), cache.end(), index) == cache.end()) {
+            cache[next] = index;
+            next = (next + 1) % cache_size;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+}
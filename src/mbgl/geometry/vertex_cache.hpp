@@ -0,0 +1,24 @@
+#ifndef MBGL_GEOMETRY_VERTEX_CACHE
+#define MBGL_GEOMETRY_VERTEX_CACHE
+
+#include <libtess2/tesselator.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace mbgl {
+
+// Reorders the triangles in /elements/ (three indices each, below /vertex_count/) so that the
+// post-transform vertex cache of the GPU runs the vertex shader less often, using the Tipsify
+// algorithm by Sander, Nehab and Barczak. The vertices keep their indices, and the triangles their
+// winding. /cache_size/ is the number of vertices the cache is assumed to hold. Returns false
+// without changing anything if an index is undefined or out of range.
+bool optimizeVertexCache(std::vector<TESSindex> &elements, size_t vertex_count, size_t cache_size = 16);
+
+// The number of times the vertex shader runs for /elements/ with a FIFO cache that holds
+// /cache_size/ vertices.
+size_t vertexCacheMisses(const std::vector<TESSindex> &elements, size_t cache_size = 16);
+
+}
+
+#endif
@@ -0,0 +1,169 @@
+#include <mbgl/map/feature_index.hpp>
+#include <mbgl/util/math.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace mbgl {
+
+namespace {
+
+inline int16_t clampCoordinate(int32_t value) {
+    return util::clamp<int32_t>(value, std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max());
+}
+
+inline double distanceSquared(double x, double y, const Coordinate &a, const Coordinate &b) {
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    const double length = dx * dx + dy * dy;
+    double t = length > 0 ? ((x - a.x) * dx + (y - a.y) * dy) / length : 0;
+    t = util::clamp(t, 0.0, 1.0);
+    const double px = a.x + t * dx - x;
+    const double py = a.y + t * dy - y;
+    return px * px + py * py;
+}
+
+}
+
+FeatureIndex::FeatureIndex(int16_t extent_, uint16_t cellsPerSide_, uint16_t maxCells_)
+    : extent(extent_),
+      cellsPerSide(cellsPerSide_),
+      maxCells(maxCells_),
+      cells(cellsPerSide_ * cellsPerSide_) {
+    assert(cellsPerSide > 0);
+}
+
+uint16_t FeatureIndex::addBucket(const std::string &name) {
+    return buckets.emplace(name, uint16_t(buckets.size())).first->second;
+}
+
+FeatureIndex::Range FeatureIndex::getRange(int32_t x0, int32_t y0, int32_t x1, int32_t y1) const {
+    // Boxes outside of the extent are kept in the border cells, like in CollisionGrid.
+    const int32_t max = cellsPerSide - 1;
+    const int32_t cellSize = extent / cellsPerSide;
+    return Range {
+        uint16_t(util::clamp<int32_t>(x0 / cellSize, 0, max)),
+        uint16_t(util::clamp<int32_t>(y0 / cellSize, 0, max)),
+        uint16_t(util::clamp<int32_t>(x1 / cellSize, 0, max)),
+        uint16_t(util::clamp<int32_t>(y1 / cellSize, 0, max)),
+    };
+}
+
+void FeatureIndex::insert(const GeometryCollection &geometry, uint32_t feature, uint16_t bucket) {
+    int32_t x0 = std::numeric_limits<int32_t>::max(), y0 = x0;
+    int32_t x1 = std::numeric_limits<int32_t>::min(), y1 = x1;
+    for (const auto &line : geometry) {
+        for (const Coordinate &coordinate : line) {
+            x0 = std::min<int32_t>(x0, coordinate.x);
+            y0 = std::min<int32_t>(y0, coordinate.y);
+            x1 = std::max<int32_t>(x1, coordinate.x);
+            y1 = std::max<int32_t>(y1, coordinate.y);
+        }
+    }
+    if (x0 > x1) {
+        return;
+    }
+
+    const uint32_t index = items.size();
+    items.push_back({ clampCoordinate(x0), clampCoordinate(y0), clampCoordinate(x1), clampCoordinate(y1), feature, bucket });
+
+    const Range range = getRange(x0, y0, x1, y1);
+    if ((range.x1 - range.x0 + 1) * (range.y1 - range.y0 + 1) > maxCells) {
+        overflow.push_back(index);
+        return;
+    }
+
+    for (uint16_t y = range.y0; y <= range.y1; y++) {
+        for (uint16_t x = range.x0; x <= range.x1; x++) {
+            cells[y * cellsPerSide + x].push_back(index);
+        }
+    }
+}
+
+void FeatureIndex::query(const std::string &name, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                         std::vector<uint32_t> &result) const {
+    const auto it = buckets.find(name);
+    if (it == buckets.end()) {
+        return;
+    }
+    const uint16_t bucket = it->second;
+
+    const size_t first = result.size();
+    const auto add = [&](const Item &item) {
+        if (item.bucket == bucket && item.x0 <= x1 && item.x1 >= x0 && item.y0 <= y1 && item.y1 >= y0) {
+            result.push_back(item.feature);
+        }
+    };
+
+    const Range range = getRange(x0, y0, x1, y1);
+    for (uint16_t y = range.y0; y <= range.y1; y++) {
+        for (uint16_t x = range.x0; x <= range.x1; x++) {
+            for (const uint32_t index : cells[y * cellsPerSide + x]) {
+                // A box that spans several cells is only reported in the first cell that both it
+                // and the query cover.
+                const Item &item = items[index];
+                const Range stored = getRange(item.x0, item.y0, item.x1, item.y1);
+                if (x == util::max(stored.x0, range.x0) && y == util::max(stored.y0, range.y0)) {
+                    add(item);
+                }
+            }
+        }
+    }
+
+    for (const uint32_t index : overflow) {
+        add(items[index]);
+    }
+
+    // A feature with several geometries has an item for each of them.
+    std::sort(result.begin() + first, result.end());
+    result.erase(std::unique(result.begin() + first, result.end()), result.end());
+}
+
+bool FeatureIndex::intersects(const GeometryCollection &geometry, FeatureType type,
+                              double x, double y, double radius) {
+    const double radius2 = radius * radius;
+    for (const auto &line : geometry) {
+        if (line.size() == 1 || type == FeatureType::Point) {
+            for (const Coordinate &coordinate : line) {
+                if (distanceSquared(x, y, coordinate, coordinate) <= radius2) {
+                    return true;
+                }
+            }
+            continue;
+        }
+        for (size_t i = 1; i < line.size(); i++) {
+            if (distanceSquared(x, y, line[i - 1], line[i]) <= radius2) {
+                return true;
+            }
+        }
+    }
+
+    if (type != FeatureType::Polygon) {
+        return false;
+    }
+
+    // Even-odd rule over all rings, so that holes aren't hit.
+    bool inside = false;
+    for (const auto &ring : geometry) {
+        for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+            const Coordinate &a = ring[i];
+            const Coordinate &b = ring[j];
+            if ((a.y > y) != (b.y > y) && x < double(b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+size_t FeatureIndex::memoryUsage() const {
+    size_t bytes = items.capacity() * sizeof(Item) + overflow.capacity() * sizeof(uint32_t) +
+                   cells.capacity() * sizeof(std::vector<uint32_t>);
+    for (const auto &cell : cells) {
+        bytes += cell.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef MBGL_MAP_FEATURE_INDEX
+#define MBGL_MAP_FEATURE_INDEX
+
+#include <mbgl/map/vector_tile.hpp>
+#include <mbgl/geometry/geometry.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mbgl {
+
+// The bounding boxes of the features that one parse put into the buckets of a tile, in tile
+// coordinates, to find the features that are drawn at a point without decoding the tile again.
+// Features are stored by their position in their source layer, so the index only keeps 16 bytes
+// per feature and bucket, plus the cells it is listed in.
+//
+// Like CollisionGrid, boxes go into a uniform grid over the extent; boxes that cover more than
+// /maxCells/ cells, like large polygons, go to a separate list that every query scans.
+//
+// The parser adds features while it builds the buckets; once the parse finished, the index
+// doesn't change and any number of threads may query it.
+class FeatureIndex : private util::noncopyable {
+public:
+    FeatureIndex(int16_t extent = 4096, uint16_t cellsPerSide = 16, uint16_t maxCells = 16);
+
+    // Returns the number that stands for the bucket in insert().
+    uint16_t addBucket(const std::string &name);
+
+    void insert(const GeometryCollection &geometry, uint32_t feature, uint16_t bucket);
+
+    // Appends the positions of the bucket's features whose bounding boxes intersect the box, in
+    // ascending order.
+    void query(const std::string &bucket, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+               std::vector<uint32_t> &result) const;
+
+    // Whether any part of the geometry lies within /radius/ of the point. Polygons are hit from
+    // inside, too.
+    static bool intersects(const GeometryCollection &geometry, FeatureType type,
+                           double x, double y, double radius);
+
+    size_t memoryUsage() const;
+
+private:
+    struct Item {
+        int16_t x0, y0, x1, y1;
+        uint32_t feature;
+        uint16_t bucket;
+    };
+
+    struct Range {
+        uint16_t x0, y0, x1, y1;
+    };
+
+    Range getRange(int32_t x0, int32_t y0, int32_t x1, int32_t y1) const;
+
+    const int16_t extent;
+    const uint16_t cellsPerSide;
+    const uint16_t maxCells;
+
+    std::unordered_map<std::string, uint16_t> buckets;
+    std::vector<Item> items;
+
+    // Indices into /items/.
+    std::vector<std::vector<uint32_t>> cells;
+    std::vector<uint32_t> overflow;
+};
+
+}
+
+#endif
@@ -0,0 +1,890 @@
+#include <mbgl/map/geojson_tile_index.hpp>
+#include <mbgl/util/constants.hpp>
+#include <mbgl/util/math.hpp>
+#include <mbgl/platform/log.hpp>
+
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace mbgl;
+
+namespace {
+
+// Features are clipped to the tiles only once, down to this zoom level. Deeper tiles are clipped
+// out of their ancestor at this level when they are requested.
+const int8_t indexMaxZoom = 5;
+
+const uint32_t extent = 4096;
+
+// Tile units around the extent that are part of the tile, so that lines and labels continue
+// across the tile edges.
+const double buffer = 64;
+
+// Tile units that the simplified geometry of a tile may deviate from the original.
+const double tolerance = 3;
+
+typedef std::vector<uint32_t> Commands;
+
+inline void writeVarint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out += char((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += char(value);
+}
+
+inline void writeTag(std::string &out, uint32_t field, uint32_t type) {
+    writeVarint(out, (field << 3) | type);
+}
+
+inline void writeBytes(std::string &out, uint32_t field, const std::string &bytes) {
+    writeTag(out, field, 2);
+    writeVarint(out, bytes.size());
+    out += bytes;
+}
+
+inline void writePacked(std::string &out, uint32_t field, const Commands &values) {
+    std::string packed;
+    for (uint32_t value : values) {
+        writeVarint(packed, value);
+    }
+    writeBytes(out, field, packed);
+}
+
+inline uint32_t zigzag(int32_t value) {
+    return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+std::string encodeValue(const Value &value) {
+    std::string out;
+    if (value.is<std::string>()) {
+        writeBytes(out, 1, value.get<std::string>());
+    } else if (value.is<double>()) {
+        const double number = value.get<double>();
+        char bytes[sizeof(double)];
+        std::memcpy(bytes, &number, sizeof(double));
+        writeTag(out, 3, 1);
+        out.append(bytes, sizeof(double));
+    } else if (value.is<uint64_t>()) {
+        writeTag(out, 5, 0);
+        writeVarint(out, value.get<uint64_t>());
+    } else if (value.is<int64_t>()) {
+        const int64_t number = value.get<int64_t>();
+        writeTag(out, 6, 0);
+        writeVarint(out, (uint64_t(number) << 1) ^ uint64_t(number >> 63));
+    } else if (value.is<bool>()) {
+        writeTag(out, 7, 0);
+        writeVarint(out, value.get<bool>());
+    }
+    return out;
+}
+
+}
+
+void GeoJSONTileIndex::Bounds::extend(double x, double y) {
+    minX = std::min(minX, x);
+    minY = std::min(minY, y);
+    maxX = std::max(maxX, x);
+    maxY = std::max(maxY, y);
+}
+
+void GeoJSONTileIndex::Bounds::extend(const Bounds &bounds) {
+    if (!bounds.empty()) {
+        extend(bounds.minX, bounds.minY);
+        extend(bounds.maxX, bounds.maxY);
+    }
+}
+
+bool GeoJSONTileIndex::Bounds::intersects(const Tile::ID &id) const {
+    const double z2 = 1 << id.z;
+    const double k = buffer / extent;
+    return !empty() &&
+           minX <= (id.x + 1 + k) / z2 && maxX >= (id.x - k) / z2 &&
+           minY <= (id.y + 1 + k) / z2 && maxY >= (id.y - k) / z2;
+}
+
+#pragma mark - Parsing
+
+namespace {
+
+bool readPoint(const rapidjson::Value &value, double &x, double &y) {
+    if (!value.IsArray() || value.Size() < 2 ||
+        !value[(rapidjson::SizeType)0].IsNumber() || !value[(rapidjson::SizeType)1].IsNumber()) {
+        return false;
+    }
+
+    // Spherical mercator, with the poles cut off where the world is square.
+    const double lon = value[(rapidjson::SizeType)0].GetDouble();
+    const double lat = util::clamp(value[(rapidjson::SizeType)1].GetDouble(), -85.0511287798, 85.0511287798);
+    const double sine = std::sin(lat * M_PI / 180);
+    x = lon / 360 + 0.5;
+    y = 0.5 - 0.25 * std::log((1 + sine) / (1 - sine)) / M_PI;
+    return true;
+}
+
+// Squared distance of p from the segment ab.
+double segmentDistanceSq(double px, double py, double ax, double ay, double bx, double by) {
+    double dx = bx - ax;
+    double dy = by - ay;
+    if (dx != 0 || dy != 0) {
+        const double t = ((px - ax) * dx + (py - ay) * dy) / (dx * dx + dy * dy);
+        if (t > 1) {
+            ax = bx;
+            ay = by;
+        } else if (t > 0) {
+            ax += dx * t;
+            ay += dy * t;
+        }
+    }
+    dx = px - ax;
+    dy = py - ay;
+    return dx * dx + dy * dy;
+}
+
+}
+
+std::vector<std::shared_ptr<const GeoJSONTileIndex::Feature>> GeoJSONTileIndex::parse(const std::string &json) {
+    std::vector<std::shared_ptr<const Feature>> result;
+
+    rapidjson::Document document;
+    document.Parse<0>(json.c_str());
+    if (document.HasParseError()) {
+        Log::Warning(Event::ParseTile, "invalid GeoJSON: %s", document.GetParseError());
+        return result;
+    }
+
+    // Douglas-Peucker, without a tolerance: each vertex records the distance at which it would
+    // have been dropped. The ends are always kept.
+    const auto simplify = [](Ring &ring) {
+        if (ring.empty()) {
+            return;
+        }
+        ring.front().importance = 1;
+        ring.back().importance = 1;
+
+        std::vector<std::pair<size_t, size_t>> stack;
+        stack.emplace_back(0, ring.size() - 1);
+        while (!stack.empty()) {
+            const size_t first = stack.back().first;
+            const size_t last = stack.back().second;
+            stack.pop_back();
+
+            double maxDistance = 0;
+            size_t index = 0;
+            for (size_t i = first + 1; i < last; i++) {
+                const double distance = segmentDistanceSq(ring[i].x, ring[i].y,
+                                                          ring[first].x, ring[first].y,
+                                                          ring[last].x, ring[last].y);
+                if (distance > maxDistance) {
+                    maxDistance = distance;
+                    index = i;
+                }
+            }
+
+            if (index) {
+                ring[index].importance = maxDistance;
+                stack.emplace_back(first, index);
+                stack.emplace_back(index, last);
+            }
+        }
+    };
+
+    // Reads an array of positions; returns false if any of them is invalid.
+    const auto readRing = [](const rapidjson::Value &value, Ring &ring) {
+        if (!value.IsArray()) {
+            return false;
+        }
+        ring.reserve(value.Size());
+        for (rapidjson::SizeType i = 0; i < value.Size(); i++) {
+            Point point { 0, 0, 0 };
+            if (!readPoint(value[i], point.x, point.y)) {
+                return false;
+            }
+            ring.push_back(point);
+        }
+        return true;
+    };
+
+    const auto readGeometry = [&](const rapidjson::Value &geometry, Feature &feature) {
+        if (!geometry.IsObject() || !geometry.HasMember("type") || !geometry["type"].IsString() ||
+            !geometry.HasMember("coordinates")) {
+            return false;
+        }
+        const std::string type = geometry["type"].GetString();
+        const rapidjson::Value &coordinates = geometry["coordinates"];
+
+        Rings rings;
+        if (type == "Point") {
+            Point point { 0, 0, 1 };
+            if (!readPoint(coordinates, point.x, point.y)) {
+                return false;
+            }
+            rings.emplace_back(1, point);
+            feature.type = FeatureType::Point;
+        } else if (type == "MultiPoint") {
+            rings.emplace_back();
+            if (!readRing(coordinates, rings.back())) {
+                return false;
+            }
+            for (Point &point : rings.back()) {
+                point.importance = 1;
+            }
+            feature.type = FeatureType::Point;
+        } else if (type == "LineString") {
+            rings.emplace_back();
+            if (!readRing(coordinates, rings.back())) {
+                return false;
+            }
+            feature.type = FeatureType::LineString;
+        } else if (type == "MultiLineString" || type == "Polygon" || type == "MultiPolygon") {
+            if (!coordinates.IsArray()) {
+                return false;
+            }
+            for (rapidjson::SizeType i = 0; i < coordinates.Size(); i++) {
+                if (type == "MultiPolygon") {
+                    const rapidjson::Value &polygon = coordinates[i];
+                    if (!polygon.IsArray()) {
+                        return false;
+                    }
+                    for (rapidjson::SizeType j = 0; j < polygon.Size(); j++) {
+                        rings.emplace_back();
+                        if (!readRing(polygon[j], rings.back())) {
+                            return false;
+                        }
+                    }
+                } else {
+                    rings.emplace_back();
+                    if (!readRing(coordinates[i], rings.back())) {
+                        return false;
+                    }
+                }
+            }
+            feature.type = type == "MultiLineString" ? FeatureType::LineString : FeatureType::Polygon;
+        } else {
+            // A GeometryCollection can't be a single feature of a vector tile.
+            return false;
+        }
+
+        for (Ring &ring : rings) {
+            if (feature.type != FeatureType::Point) {
+                simplify(ring);
+            }
+            for (const Point &point : ring) {
+                feature.bounds.extend(point.x, point.y);
+            }
+        }
+        feature.geometry = std::make_shared<const Rings>(std::move(rings));
+        return true;
+    };
+
+    const auto readFeature = [&](const rapidjson::Value &value) {
+        auto feature = std::make_shared<Feature>();
+
+        if (value.HasMember("id")) {
+            const rapidjson::Value &id = value["id"];
+            if (id.IsString()) {
+                feature->key = { id.GetString(), id.GetStringLength() };
+            } else if (id.IsUint64()) {
+                feature->hasID = true;
+                feature->id = id.GetUint64();
+                feature->key = std::to_string(feature->id);
+            } else if (id.IsInt64()) {
+                feature->key = std::to_string(id.GetInt64());
+            } else if (id.IsNumber()) {
+                feature->key = std::to_string(id.GetDouble());
+            }
+        }
+
+        if (value.HasMember("properties") && value["properties"].IsObject()) {
+            const rapidjson::Value &properties = value["properties"];
+            for (auto it = properties.MemberBegin(); it != properties.MemberEnd(); ++it) {
+                // Vector tiles only hold scalar values.
+                if (!it->value.IsNull() && !it->value.IsObject() && !it->value.IsArray()) {
+                    feature->properties.emplace_back(std::string { it->name.GetString(), it->name.GetStringLength() },
+                                                     parseValue(it->value));
+                }
+            }
+        }
+
+        if (!value.HasMember("geometry") || value["geometry"].IsNull()) {
+            // Only useful to remove a feature in an update.
+            if (!feature->key.empty()) {
+                result.push_back(feature);
+            }
+        } else if (readGeometry(value["geometry"], *feature)) {
+            result.push_back(feature);
+        } else {
+            Log::Warning(Event::ParseTile, "skipping GeoJSON feature with invalid geometry");
+        }
+    };
+
+    const std::string type = document.IsObject() && document.HasMember("type") && document["type"].IsString()
+                                 ? document["type"].GetString() : "";
+    if (type == "FeatureCollection") {
+        if (document.HasMember("features") && document["features"].IsArray()) {
+            const rapidjson::Value &features = document["features"];
+            for (rapidjson::SizeType i = 0; i < features.Size(); i++) {
+                if (features[i].IsObject()) {
+                    readFeature(features[i]);
+                }
+            }
+        }
+    } else if (type == "Feature") {
+        readFeature(document);
+    } else if (!type.empty()) {
+        auto feature = std::make_shared<Feature>();
+        if (readGeometry(document, *feature)) {
+            result.push_back(feature);
+        } else {
+            Log::Warning(Event::ParseTile, "invalid GeoJSON geometry");
+        }
+    } else {
+        Log::Warning(Event::ParseTile, "GeoJSON must be a FeatureCollection, a Feature or a geometry");
+    }
+
+    return result;
+}
+
+#pragma mark - Updates
+
+GeoJSONTileIndex::GeoJSONTileIndex(const std::string &json, const GeoJSONTileOptions &options_)
+    : options(options_) {
+    Bounds changed;
+    apply(parse(json), changed);
+    buildClusters();
+}
+
+std::shared_ptr<const GeoJSONTileIndex> GeoJSONTileIndex::update(const std::string &json, Bounds &changed) const {
+    std::shared_ptr<GeoJSONTileIndex> index(new GeoJSONTileIndex(options));
+    index->features = features;
+    index->keys = keys;
+
+    Bounds dirty;
+    const bool pointsChanged = index->apply(parse(json), dirty);
+    changed.extend(dirty);
+
+    // A changed point may move clusters anywhere, up to the lowest zoom level.
+    if (options.cluster && pointsChanged) {
+        index->buildClusters();
+        changed.extend(0, 0);
+        changed.extend(1, 1);
+    } else {
+        index->clusters = clusters;
+    }
+
+    // Tiles that none of the changes touch are still valid.
+    std::lock_guard<std::mutex> lock(mtx);
+    for (const auto &tile : tiles) {
+        if (!dirty.intersects(tile.first)) {
+            index->tiles.emplace(tile.first, tile.second);
+        }
+    }
+
+    return index;
+}
+
+bool GeoJSONTileIndex::apply(const std::vector<std::shared_ptr<const Feature>> &changes, Bounds &changed) {
+    bool removed = false;
+    bool points = false;
+    for (const auto &feature : changes) {
+        auto it = feature->key.empty() ? keys.end() : keys.find(feature->key);
+        points = points || feature->type == FeatureType::Point;
+        if (it != keys.end()) {
+            std::shared_ptr<const Feature> &existing = features[it->second];
+            changed.extend(existing->bounds);
+            points = points || existing->type == FeatureType::Point;
+            if (feature->type == FeatureType::Unknown) {
+                existing.reset();
+                keys.erase(it);
+                removed = true;
+            } else {
+                existing = feature;
+            }
+        } else if (feature->type != FeatureType::Unknown) {
+            if (!feature->key.empty()) {
+                keys.emplace(feature->key, features.size());
+            }
+            features.push_back(feature);
+        }
+        changed.extend(feature->bounds);
+    }
+
+    if (removed) {
+        features.erase(std::remove(features.begin(), features.end(), nullptr), features.end());
+        keys.clear();
+        for (size_t i = 0; i < features.size(); i++) {
+            if (!features[i]->key.empty()) {
+                keys.emplace(features[i]->key, i);
+            }
+        }
+    }
+
+    return points;
+}
+
+#pragma mark - Clusters
+
+bool GeoJSONTileIndex::ClusterOrder::operator()(const Cluster &a, const std::pair<int32_t, int32_t> &b) const {
+    const std::pair<int32_t, int32_t> cell(std::floor(a.x * z2), std::floor(a.y * z2));
+    return cell < b;
+}
+
+bool GeoJSONTileIndex::ClusterOrder::operator()(const std::pair<int32_t, int32_t> &a, const Cluster &b) const {
+    const std::pair<int32_t, int32_t> cell(std::floor(b.x * z2), std::floor(b.y * z2));
+    return a < cell;
+}
+
+bool GeoJSONTileIndex::ClusterOrder::operator()(const Cluster &a, const Cluster &b) const {
+    return operator()(a, std::pair<int32_t, int32_t>(std::floor(b.x * z2), std::floor(b.y * z2)));
+}
+
+// Like supercluster: each level merges the clusters of the level below that are within the
+// radius of a cluster, greedily in their order. A grid with cells of the radius finds them.
+void GeoJSONTileIndex::buildClusters() {
+    clusters.clear();
+    if (!options.cluster) {
+        return;
+    }
+
+    std::vector<Cluster> current;
+    for (const auto &feature : features) {
+        if (feature->type == FeatureType::Point) {
+            for (const Ring &ring : *feature->geometry) {
+                for (const Point &point : ring) {
+                    current.push_back({ point.x, point.y, 1, 0, feature });
+                }
+            }
+        }
+    }
+
+    clusters.resize(options.clusterMaxZoom + 1);
+    std::unordered_map<uint64_t, std::vector<uint32_t>> grid;
+    std::vector<bool> merged;
+    for (int8_t z = options.clusterMaxZoom; z >= 0; z--) {
+        const double radius = double(options.clusterRadius) / (util::tileSize * (1 << z));
+        const double sqRadius = radius * radius;
+        const auto cellOf = [radius](double coordinate) {
+            return int32_t(std::floor(coordinate / radius));
+        };
+        const auto cellKey = [](int32_t cx, int32_t cy) {
+            return (uint64_t(uint32_t(cx)) << 32) | uint32_t(cy);
+        };
+
+        grid.clear();
+        for (uint32_t i = 0; i < current.size(); i++) {
+            grid[cellKey(cellOf(current[i].x), cellOf(current[i].y))].push_back(i);
+        }
+
+        std::vector<Cluster> next;
+        merged.assign(current.size(), false);
+        for (uint32_t i = 0; i < current.size(); i++) {
+            if (merged[i]) {
+                continue;
+            }
+            merged[i] = true;
+
+            const Cluster &cluster = current[i];
+            double sumX = cluster.x * cluster.count;
+            double sumY = cluster.y * cluster.count;
+            uint32_t count = cluster.count;
+
+            const int32_t cx = cellOf(cluster.x);
+            const int32_t cy = cellOf(cluster.y);
+            for (int32_t y = cy - 1; y <= cy + 1; y++) {
+                for (int32_t x = cx - 1; x <= cx + 1; x++) {
+                    auto cell = grid.find(cellKey(x, y));
+                    if (cell == grid.end()) {
+                        continue;
+                    }
+                    for (uint32_t j : cell->second) {
+                        const Cluster &other = current[j];
+                        const double dx = other.x - cluster.x;
+                        const double dy = other.y - cluster.y;
+                        if (!merged[j] && dx * dx + dy * dy <= sqRadius) {
+                            merged[j] = true;
+                            sumX += other.x * other.count;
+                            sumY += other.y * other.count;
+                            count += other.count;
+                        }
+                    }
+                }
+            }
+
+            if (count == cluster.count) {
+                next.push_back(cluster);
+            } else {
+                next.push_back({ sumX / count, sumY / count, count, 0, nullptr });
+            }
+        }
+
+        const ClusterOrder order { double(1 << z) };
+        std::stable_sort(next.begin(), next.end(), order);
+
+        // Cluster ids tell the zoom level and the position in it apart.
+        for (size_t i = 0; i < next.size(); i++) {
+            if (!next[i].feature) {
+                next[i].id = (uint64_t(i) << 5) | uint64_t(z);
+            }
+        }
+
+        clusters[z] = next;
+        current.swap(next);
+    }
+}
+
+#pragma mark - Tiles
+
+std::shared_ptr<const std::string> GeoJSONTileIndex::getTile(const Tile::ID &id) const {
+    std::shared_ptr<const ClippedTile> tile;
+    if (id.z <= indexMaxZoom) {
+        tile = getClippedTile(id.z, id.x, id.y);
+    } else {
+        const int8_t dz = id.z - indexMaxZoom;
+        tile = clip(*getClippedTile(indexMaxZoom, id.x >> dz, id.y >> dz), id.z, id.x, id.y);
+    }
+
+    if (!options.cluster || id.z > options.clusterMaxZoom) {
+        return std::make_shared<const std::string>(encode(*tile, nullptr, id.z, id.x, id.y));
+    }
+
+    // The clusters are sorted by tile, so the ones in the buffer come from the neighbouring tiles.
+    const std::vector<Cluster> &level = clusters[id.z];
+    const double z2 = 1 << id.z;
+    const double k = buffer / extent;
+    std::vector<const Cluster *> inTile;
+    for (int32_t dy = -1; dy <= 1; dy++) {
+        for (int32_t dx = -1; dx <= 1; dx++) {
+            const std::pair<int32_t, int32_t> cell(id.x + dx, id.y + dy);
+            auto range = std::equal_range(level.begin(), level.end(), cell, ClusterOrder { z2 });
+            for (auto it = range.first; it != range.second; ++it) {
+                const double cx = it->x * z2 - id.x;
+                const double cy = it->y * z2 - id.y;
+                if (cx >= -k && cx <= 1 + k && cy >= -k && cy <= 1 + k) {
+                    inTile.push_back(&*it);
+                }
+            }
+        }
+    }
+    return std::make_shared<const std::string>(encode(*tile, &inTile, id.z, id.x, id.y));
+}
+
+std::shared_ptr<const GeoJSONTileIndex::ClippedTile> GeoJSONTileIndex::getClippedTile(int8_t z, int32_t x, int32_t y) const {
+    const Tile::ID id(z, x, y);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = tiles.find(id);
+        if (it != tiles.end()) {
+            return it->second;
+        }
+    }
+
+    std::shared_ptr<const ClippedTile> tile;
+    if (z == 0) {
+        auto root = std::make_shared<ClippedTile>();
+        root->reserve(features.size());
+        for (const auto &feature : features) {
+            root->push_back({ feature, feature->geometry, feature->bounds });
+        }
+        tile = root;
+    } else {
+        tile = clip(*getClippedTile(z - 1, x / 2, y / 2), z, x, y);
+    }
+
+    // Another thread may have clipped the same tile in the meantime.
+    std::lock_guard<std::mutex> lock(mtx);
+    return tiles.emplace(id, tile).first->second;
+}
+
+std::shared_ptr<const GeoJSONTileIndex::ClippedTile> GeoJSONTileIndex::clip(const ClippedTile &parent,
+                                                                              int8_t z, int32_t x, int32_t y) {
+    const double z2 = 1 << z;
+    const double k = buffer / extent;
+    const double min[2] = { (x - k) / z2, (y - k) / z2 };
+    const double max[2] = { (x + 1 + k) / z2, (y + 1 + k) / z2 };
+
+    const auto coordinate = [](const Point &point, int axis) {
+        return axis ? point.y : point.x;
+    };
+
+    const auto intersect = [](const Point &a, const Point &b, double k_, int axis) {
+        if (axis) {
+            return Point { a.x + (b.x - a.x) * (k_ - a.y) / (b.y - a.y), k_, 1 };
+        } else {
+            return Point { k_, a.y + (b.y - a.y) * (k_ - a.x) / (b.x - a.x), 1 };
+        }
+    };
+
+    // Clips the rings to [k1, k2] on one axis. Lines that leave the range are split; polygon
+    // rings are closed along the edge.
+    const auto clipRings = [&](const Rings &rings, FeatureType type, int axis, Rings &result) {
+        const double k1 = min[axis];
+        const double k2 = max[axis];
+        const bool closed = type == FeatureType::Polygon;
+        const size_t minPoints = type == FeatureType::Point ? 1 : closed ? 4 : 2;
+
+        Ring slice;
+        const auto finish = [&]() {
+            if (closed && !slice.empty() &&
+                (slice.front().x != slice.back().x || slice.front().y != slice.back().y)) {
+                slice.push_back(slice.front());
+            }
+            if (slice.size() >= minPoints) {
+                result.push_back(std::move(slice));
+            }
+            slice.clear();
+        };
+
+        for (const Ring &ring : rings) {
+            if (type == FeatureType::Point) {
+                for (const Point &point : ring) {
+                    const double a = coordinate(point, axis);
+                    if (a >= k1 && a <= k2) {
+                        slice.push_back(point);
+                    }
+                }
+                finish();
+                continue;
+            }
+
+            for (size_t i = 0; i + 1 < ring.size(); i++) {
+                const Point &a = ring[i];
+                const Point &b = ring[i + 1];
+                const double ak = coordinate(a, axis);
+                const double bk = coordinate(b, axis);
+
+                if (ak < k1) {
+                    if (bk > k2) {
+                        slice.push_back(intersect(a, b, k1, axis));
+                        slice.push_back(intersect(a, b, k2, axis));
+                        if (!closed) finish();
+                    } else if (bk >= k1) {
+                        slice.push_back(intersect(a, b, k1, axis));
+                    }
+                } else if (ak > k2) {
+                    if (bk < k1) {
+                        slice.push_back(intersect(a, b, k2, axis));
+                        slice.push_back(intersect(a, b, k1, axis));
+                        if (!closed) finish();
+                    } else if (bk <= k2) {
+                        slice.push_back(intersect(a, b, k2, axis));
+                    }
+                } else {
+                    slice.push_back(a);
+                    if (bk < k1) {
+                        slice.push_back(intersect(a, b, k1, axis));
+                        if (!closed) finish();
+                    } else if (bk > k2) {
+                        slice.push_back(intersect(a, b, k2, axis));
+                        if (!closed) finish();
+                    }
+                }
+            }
+
+            if (!ring.empty()) {
+                const Point &last = ring.back();
+                const double lk = coordinate(last, axis);
+                if (lk >= k1 && lk <= k2) {
+                    slice.push_back(last);
+                }
+            }
+            finish();
+        }
+    };
+
+    auto tile = std::make_shared<ClippedTile>();
+    for (const ClippedFeature &clipped : parent) {
+        const Bounds &bounds = clipped.bounds;
+        if (bounds.maxX < min[0] || bounds.minX > max[0] || bounds.maxY < min[1] || bounds.minY > max[1]) {
+            continue;
+        }
+        if (bounds.minX >= min[0] && bounds.maxX <= max[0] && bounds.minY >= min[1] && bounds.maxY <= max[1]) {
+            tile->push_back(clipped);
+            continue;
+        }
+
+        const FeatureType type = clipped.feature->type;
+        Rings horizontal;
+        clipRings(*clipped.geometry, type, 0, horizontal);
+        auto rings = std::make_shared<Rings>();
+        clipRings(horizontal, type, 1, *rings);
+        if (rings->empty()) {
+            continue;
+        }
+
+        Bounds clippedBounds;
+        for (const Ring &ring : *rings) {
+            for (const Point &point : ring) {
+                clippedBounds.extend(point.x, point.y);
+            }
+        }
+        tile->push_back({ clipped.feature, rings, clippedBounds });
+    }
+    return tile;
+}
+
+std::string GeoJSONTileIndex::encode(const ClippedTile &tile, const std::vector<const Cluster *> *clusters,
+                                     int8_t z, int32_t x, int32_t y) {
+    const double z2 = 1 << z;
+    const double sqTolerance = std::pow(tolerance / (z2 * extent), 2);
+
+    std::string layer;
+    writeBytes(layer, 1, util::geojsonLayerName);
+
+    std::vector<std::string> keys;
+    std::unordered_map<std::string, uint32_t> keyIndex;
+    std::vector<std::string> values;
+    std::unordered_map<std::string, uint32_t> valueIndex;
+    size_t featureCount = 0;
+
+    Commands geometry;
+    Commands tags;
+    std::vector<std::pair<int32_t, int32_t>> points;
+
+    const auto writeFeature = [&](const Feature &feature, const Properties &properties) {
+        tags.clear();
+        for (const auto &property : properties) {
+            auto key = keyIndex.emplace(property.first, keys.size());
+            if (key.second) {
+                keys.push_back(property.first);
+            }
+            std::string encoded = encodeValue(property.second);
+            auto value = valueIndex.emplace(encoded, values.size());
+            if (value.second) {
+                values.push_back(std::move(encoded));
+            }
+            tags.push_back(key.first->second);
+            tags.push_back(value.first->second);
+        }
+
+        std::string message;
+        if (feature.hasID) {
+            writeTag(message, 1, 0);
+            writeVarint(message, feature.id);
+        }
+        if (!tags.empty()) {
+            writePacked(message, 2, tags);
+        }
+        writeTag(message, 3, 0);
+        writeVarint(message, uint32_t(feature.type));
+        writePacked(message, 4, geometry);
+        writeBytes(layer, 2, message);
+        featureCount++;
+    };
+
+    for (const ClippedFeature &clipped : tile) {
+        const Feature &feature = *clipped.feature;
+        const bool closed = feature.type == FeatureType::Polygon;
+
+        // Points are drawn as clusters instead.
+        if (clusters && feature.type == FeatureType::Point) {
+            continue;
+        }
+
+        geometry.clear();
+        int32_t cx = 0, cy = 0;
+        for (const Ring &ring : *clipped.geometry) {
+            points.clear();
+            for (const Point &point : ring) {
+                if (feature.type != FeatureType::Point && point.importance <= sqTolerance) {
+                    continue;
+                }
+                const int32_t px = std::round((point.x * z2 - x) * extent);
+                const int32_t py = std::round((point.y * z2 - y) * extent);
+                if (feature.type == FeatureType::Point || points.empty() ||
+                    points.back().first != px || points.back().second != py) {
+                    points.emplace_back(px, py);
+                }
+            }
+
+            // Rings are closed with a command instead of the first vertex.
+            if (closed) {
+                if (points.size() > 1 && points.front() == points.back()) {
+                    points.pop_back();
+                }
+                if (points.size() < 3) {
+                    continue;
+                }
+            } else if (feature.type == FeatureType::LineString && points.size() < 2) {
+                continue;
+            } else if (points.empty()) {
+                continue;
+            }
+
+            const size_t moves = feature.type == FeatureType::Point ? points.size() : 1;
+            for (size_t i = 0; i < points.size(); i++) {
+                if (i == 0) {
+                    geometry.push_back((moves << 3) | 1);
+                } else if (i == moves) {
+                    geometry.push_back(((points.size() - moves) << 3) | 2);
+                }
+                geometry.push_back(zigzag(points[i].first - cx));
+                geometry.push_back(zigzag(points[i].second - cy));
+                cx = points[i].first;
+                cy = points[i].second;
+            }
+            if (closed) {
+                geometry.push_back((1 << 3) | 7);
+            }
+        }
+
+        if (!geometry.empty()) {
+            writeFeature(feature, feature.properties);
+        }
+    }
+
+    if (clusters) {
+        Feature clusterFeature;
+        clusterFeature.type = FeatureType::Point;
+        clusterFeature.hasID = true;
+
+        for (const Cluster *cluster : *clusters) {
+            geometry.clear();
+            geometry.push_back((1 << 3) | 1);
+            geometry.push_back(zigzag(std::round((cluster->x * z2 - x) * extent)));
+            geometry.push_back(zigzag(std::round((cluster->y * z2 - y) * extent)));
+
+            if (cluster->feature) {
+                writeFeature(*cluster->feature, cluster->feature->properties);
+                continue;
+            }
+
+            std::string abbreviated;
+            if (cluster->count >= 10000) {
+                abbreviated = std::to_string((cluster->count + 500) / 1000) + "k";
+            } else if (cluster->count >= 1000) {
+                const uint32_t hundreds = (cluster->count + 50) / 100;
+                abbreviated = std::to_string(hundreds / 10) + "." + std::to_string(hundreds % 10) + "k";
+            } else {
+                abbreviated = std::to_string(cluster->count);
+            }
+
+            clusterFeature.id = cluster->id;
+            Properties properties;
+            properties.emplace_back("cluster", Value(true));
+            properties.emplace_back("cluster_id", Value(cluster->id));
+            properties.emplace_back("point_count", Value(uint64_t(cluster->count)));
+            properties.emplace_back("point_count_abbreviated", Value(abbreviated));
+            writeFeature(clusterFeature, properties);
+        }
+    }
+
+    if (!featureCount) {
+        return "";
+    }
+
+    for (const std::string &key : keys) {
+        writeBytes(layer, 3, key);
+    }
+    for (const std::string &value : values) {
+        writeBytes(layer, 4, value);
+    }
+    writeTag(layer, 5, 0);
+    writeVarint(layer, extent);
+
+    std::string result;
+    writeBytes(result, 3, layer);
+    return result;
+}
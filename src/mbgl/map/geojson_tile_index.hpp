@@ -0,0 +1,160 @@
+#ifndef MBGL_MAP_GEOJSON_TILE_INDEX
+#define MBGL_MAP_GEOJSON_TILE_INDEX
+
+#include <mbgl/map/tile.hpp>
+#include <mbgl/map/vector_tile.hpp>
+#include <mbgl/style/value.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mbgl {
+
+struct GeoJSONTileOptions {
+    // Merges points that are closer than clusterRadius pixels of a tile into a single point, at
+    // each zoom level up to clusterMaxZoom. A cluster has the properties cluster (true),
+    // cluster_id, point_count and point_count_abbreviated; points that aren't merged keep their
+    // own.
+    bool cluster = false;
+    uint16_t clusterRadius = 50;
+    uint8_t clusterMaxZoom = 17;
+};
+
+/*
+ * Cuts GeoJSON into vector tiles on the fly, like geojson-vt. The features are projected and
+ * simplified once when they are added. A tile is clipped out of its parent, which is kept for
+ * the tiles down to indexMaxZoom, and simplified for its zoom level. It is encoded as a vector
+ * tile with the single layer util::geojsonLayerName, so that TileParser reads it like any other
+ * tile. An index doesn't change once it is created; any number of threads may get tiles from it.
+ */
+class GeoJSONTileIndex : private util::noncopyable {
+public:
+    // An area in projected coordinates, where the world spans [0, 1] on both axes.
+    struct Bounds {
+        double minX = 1, minY = 1, maxX = 0, maxY = 0;
+
+        inline bool empty() const { return minX > maxX; }
+        void extend(double x, double y);
+        void extend(const Bounds &bounds);
+
+        // Whether anything in the area shows up in the tile, including its buffer.
+        bool intersects(const Tile::ID &id) const;
+    };
+
+    // Parses a FeatureCollection, a Feature or a bare geometry. Features that can't be read are
+    // skipped with a warning.
+    explicit GeoJSONTileIndex(const std::string &json, const GeoJSONTileOptions &options = GeoJSONTileOptions());
+
+    // Returns an index with the features of /json/ applied on top of the features of this one.
+    // A feature with the id of an existing feature replaces it, or removes it if its geometry is
+    // null; features without an id are added. /changed/ is extended by the areas of all features
+    // that were added, replaced or removed, or by the whole world if the clusters changed. The
+    // clipped tiles outside of the features' areas are shared with this index.
+    std::shared_ptr<const GeoJSONTileIndex> update(const std::string &json, Bounds &changed) const;
+
+    // Returns the tile encoded as a vector tile, which is empty if none of the features is in
+    // the tile. Expects a normalized ID.
+    std::shared_ptr<const std::string> getTile(const Tile::ID &id) const;
+
+    inline size_t getFeatureCount() const { return features.size(); }
+
+private:
+    // A vertex in projected coordinates. Simplification drops it once the tolerance is larger
+    // than its importance, the squared distance Douglas-Peucker found for it.
+    struct Point {
+        double x, y, importance;
+    };
+    typedef std::vector<Point> Ring;
+    typedef std::vector<Ring> Rings;
+
+    struct Feature {
+        // Unknown for a feature that removes the feature with the same key in an update.
+        FeatureType type = FeatureType::Unknown;
+
+        // The GeoJSON id, to find the feature in an update. Empty if the feature doesn't have one.
+        std::string key;
+
+        // Integer ids are kept as the feature id of the vector tile.
+        bool hasID = false;
+        uint64_t id = 0;
+
+        std::vector<std::pair<std::string, Value>> properties;
+
+        // Points of a feature are in one ring. The rings of all polygons of a feature follow each
+        // other, like in a vector tile.
+        std::shared_ptr<const Rings> geometry;
+        Bounds bounds;
+    };
+
+    // The part of a feature that is in a tile. Features that lie in the tile completely share
+    // their geometry with the feature.
+    struct ClippedFeature {
+        std::shared_ptr<const Feature> feature;
+        std::shared_ptr<const Rings> geometry;
+        Bounds bounds;
+    };
+    typedef std::vector<ClippedFeature> ClippedTile;
+
+    typedef std::vector<std::pair<std::string, Value>> Properties;
+
+    // A point that stands for /count/ points at a zoom level.
+    struct Cluster {
+        double x, y;
+        uint32_t count;
+        uint64_t id;
+
+        // The feature of a single point that wasn't merged with any other; null for clusters.
+        std::shared_ptr<const Feature> feature;
+    };
+
+    // Sorts clusters by the tile they are in at a zoom level, rows of tiles first.
+    struct ClusterOrder {
+        double z2;
+        bool operator()(const Cluster &a, const std::pair<int32_t, int32_t> &b) const;
+        bool operator()(const std::pair<int32_t, int32_t> &a, const Cluster &b) const;
+        bool operator()(const Cluster &a, const Cluster &b) const;
+    };
+
+    explicit GeoJSONTileIndex(const GeoJSONTileOptions &options_) : options(options_) {}
+
+    static std::vector<std::shared_ptr<const Feature>> parse(const std::string &json);
+
+    // Adds, replaces or removes the features, and extends /changed/ by their areas. Returns
+    // whether any point feature changed.
+    bool apply(const std::vector<std::shared_ptr<const Feature>> &changes, Bounds &changed);
+
+    void buildClusters();
+
+    // Returns the clipped features of a tile at indexMaxZoom or above, clipping it out of its
+    // parent if it wasn't requested before.
+    std::shared_ptr<const ClippedTile> getClippedTile(int8_t z, int32_t x, int32_t y) const;
+
+    static std::shared_ptr<const ClippedTile> clip(const ClippedTile &parent,
+                                                   int8_t z, int32_t x, int32_t y);
+    // Replaces the point features of the tile with /clusters/, if set.
+    static std::string encode(const ClippedTile &tile, const std::vector<const Cluster *> *clusters,
+                              int8_t z, int32_t x, int32_t y);
+
+    const GeoJSONTileOptions options;
+
+    std::vector<std::shared_ptr<const Feature>> features;
+
+    // Indices of the features that have an id, keyed by it.
+    std::unordered_map<std::string, size_t> keys;
+
+    // The clusters of each zoom level up to options.clusterMaxZoom, sorted by ClusterOrder.
+    std::vector<std::vector<Cluster>> clusters;
+
+    mutable std::mutex mtx;
+    mutable std::map<Tile::ID, std::shared_ptr<const ClippedTile>> tiles;
+};
+
+}
+
+#endif
@@ -1,9 +1,12 @@
 #include <mbgl/map/map.hpp>
 #include <mbgl/map/view.hpp>
 #include <mbgl/platform/platform.hpp>
+#include <mbgl/platform/glyph_rasterizer.hpp>
 #include <mbgl/map/source.hpp>
 #include <mbgl/renderer/painter.hpp>
+#include <mbgl/renderer/bucket_cache.hpp>
 #include <mbgl/map/sprite.hpp>
+#include <mbgl/map/tile_trace.hpp>
 #include <mbgl/util/transition.hpp>
 #include <mbgl/util/time.hpp>
 #include <mbgl/util/math.hpp>
@@ -21,6 +24,7 @@
 #include <mbgl/util/texture_pool.hpp>
 #include <mbgl/geometry/sprite_atlas.hpp>
 #include <mbgl/geometry/line_atlas.hpp>
+#include <mbgl/geometry/buffer_pool.hpp>
 #include <mbgl/storage/file_source.hpp>
 #include <mbgl/platform/log.hpp>
 #include <mbgl/util/string.hpp>
@@ -102,9 +106,13 @@ Map::Map(View& view_, FileSource& fileSource_)
       spriteAtlas(util::make_unique<SpriteAtlas>(512, 512)),
       lineAtlas(util::make_unique<LineAtlas>(512, 512)),
       texturePool(std::make_shared<TexturePool>()),
-      painter(util::make_unique<Painter>(*spriteAtlas, *glyphAtlas, *lineAtlas))
+      tileTrace(std::make_shared<TileTrace>()),
+      painter(util::make_unique<Painter>(*spriteAtlas, *glyphAtlas, *lineAtlas, profiler)),
+      tileCacheSize(util::tileCacheSize)
 {
     view.initialize(this);
+    // Tiles that are waiting for glyphs are reparsed on the next update.
+    glyphStore->setObserver([this] { update(); });
     // Make sure that we're doing an initial drawing in all cases.
     isClean.clear();
     isRendered.clear();
@@ -129,7 +137,18 @@ Map::~Map() {
 
 uv::worker &Map::getWorker() {
     if (!workers) {
-        workers = util::make_unique<uv::worker>(**loop, 4, "Tile Worker");
+        unsigned int count = workerCount;
+        if (!count) {
+            // hardware_concurrency() returns 0 when the number can't be determined.
+            count = std::thread::hardware_concurrency();
+            if (!count) {
+                count = 4;
+            }
+        }
+        workers = util::make_unique<uv::worker>(**loop, count, "Tile Worker");
+        workers->setIdleTimeout(util::workerIdleTimeout);
+        // When many tiles finish at once, frames still render in between.
+        workers->setAfterWorkBudget(util::afterWorkBudget);
     }
     return *workers;
 }
@@ -160,18 +179,34 @@ void Map::start(bool startPaused) {
 
         // Closes all open handles on the loop. This means that the loop will automatically terminate.
         asyncRender.reset();
+        frameTimer.reset();
         asyncTerminate.reset();
     });
 
+    frameTimer = util::make_unique<uv::timer>(**loop, [this]() {
+        update();
+    });
+
     asyncRender = util::make_unique<uv::async>(**loop, [this]() {
         assert(std::this_thread::get_id() == mapThread);
 
         if (state.hasSize()) {
+            // Render requests that come in before the next frame is due only start the frame
+            // timer, so that any number of them result in one frame.
+            const unsigned int fps = maximumFrameRate;
+            const timestamp now = util::now();
+            if (fps && now < frameTime + 1_second / fps) {
+                frameTimer->start(1 + (frameTime + 1_second / fps - now) / 1_millisecond);
+                return;
+            }
+
             if (isRendered.test_and_set() == false) {
                 prepare();
                 if (isClean.test_and_set() == false) {
+                    frameTime = now;
                     render();
                     isSwapped.clear();
+                    FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::Swap);
                     view.swap();
                 } else {
                     // We set the rendered flag in the test above, so we have to reset it
@@ -277,6 +312,8 @@ void Map::run() {
         checkForPause();
     }
 
+    startup.record(StartupProfiler::Stage::Start);
+
     view.activate();
     setup();
     prepare();
@@ -288,16 +325,30 @@ void Map::run() {
             checkForPause();
         }
     } else {
-        uv_run(**loop, UV_RUN_DEFAULT);
+        asyncPrepare = util::make_unique<uv::async>(**loop, [this]() {
+            asyncPrepare->unref();
+            prepare();
+        });
+        asyncPrepare->unref();
+
+        // prepare() stops the loop once the map is complete, before unrelated requests and
+        // timers finish.
+        if (!isComplete() || !isSnapshotComplete()) {
+            uv_run(**loop, UV_RUN_DEFAULT);
+        }
+
+        asyncPrepare.reset();
     }
 
-    // Run the event loop once more to make sure our async delete handlers are called.
-    uv_run(**loop, UV_RUN_ONCE);
+    // Run the event loop once more to make sure our async delete handlers are called. It must not
+    // wait for the requests that a stopped loop still has running.
+    uv_run(**loop, mode == Mode::Static ? UV_RUN_NOWAIT : UV_RUN_ONCE);
 
     // If the map rendering wasn't started asynchronously, we perform one render
     // *after* all events have been processed.
     if (mode == Mode::Static) {
         render();
+        painter->finishReads();
 #ifndef NDEBUG
         mapThread = std::thread::id();
 #endif
@@ -330,7 +381,12 @@ void Map::checkForPause() {
 
 void Map::rerender() {
     if (mode == Mode::Static) {
-        prepare();
+        if (asyncPrepare) {
+            asyncPrepare->ref();
+            asyncPrepare->send();
+        } else {
+            prepare();
+        }
     } else if (mode == Mode::Continuous) {
         // We only send render events if we want to continuously update the map
         // (== async rendering).
@@ -345,6 +401,24 @@ void Map::update() {
     rerender();
 }
 
+void Map::setMaximumFrameRate(unsigned int fps) {
+    maximumFrameRate = fps;
+    update();
+}
+
+unsigned int Map::getMaximumFrameRate() const {
+    return maximumFrameRate;
+}
+
+void Map::setAdaptiveResolution(bool value) {
+    adaptiveResolution = value;
+    update();
+}
+
+bool Map::getAdaptiveResolution() const {
+    return adaptiveResolution;
+}
+
 bool Map::needsSwap() {
     return isSwapped.test_and_set() == false;
 }
@@ -357,7 +431,13 @@ void Map::swapped() {
 void Map::terminate() {
     assert(painter);
     painter->terminate();
+    texturePool->clearTextureIDs();
+    texturePool->collect();
     view.deactivate();
+
+    // The context goes away with everything in it. Tiles whose geometry was retained upload it
+    // again into the next context; all others are reparsed.
+    gl::State::contextLost();
 }
 
 #pragma mark - Setup
@@ -366,16 +446,25 @@ void Map::setup() {
     assert(std::this_thread::get_id() == mapThread);
     assert(painter);
     painter->setup();
+    startup.record(StartupProfiler::Stage::Shaders);
+
+    // A static map renders only once, so it must upload everything right away.
+    painter->setUploadBudget(mode == Mode::Static ? 0 : util::uploadBudget);
+    // A static render draws every tile once, so the textures would never be reused.
+    painter->setTileTextureCaching(mode == Mode::Continuous);
 }
 
 void Map::setStyleURL(const std::string &url) {
-    // TODO: Make threadsafe.
-
-    styleURL = url;
-    if (mode == Mode::Continuous) {
-        stop();
-        start();
+    {
+        std::lock_guard<std::mutex> lock(mutexStyleURL);
+        styleURL = url;
+        styleURLChanged = true;
     }
+    startup.reset();
+
+    // A running map loads the new style into the current one, which keeps the sources and
+    // buckets that are defined the same way.
+    update();
 }
 
 
@@ -388,9 +477,27 @@ void Map::setStyleJSON(std::string newStyleJSON, const std::string &base) {
     }
 
     style->loadJSON((const uint8_t *)styleJSON.c_str());
+    styleLoaded(base);
+}
+
+void Map::setStyleBinary(const std::string &path, const std::string &base) {
+    // TODO: Make threadsafe.
+    styleJSON.clear();
+    sprite.reset();
+    if (!style) {
+        style = std::make_shared<Style>();
+    }
+
+    style->loadBinary(path);
+    styleLoaded(base);
+}
+
+void Map::styleLoaded(const std::string &base) {
     style->cascadeClasses(classes);
     fileSource.setBase(base);
     glyphStore->setURL(style->glyph_url);
+    glyphsPending = true;
+    startup.record(StartupProfiler::Stage::Style);
 
     style->setDefaultTransitionDuration(defaultTransitionDuration);
 
@@ -405,7 +512,9 @@ util::ptr<Sprite> Map::getSprite() {
     const float pixelRatio = state.getPixelRatio();
     const std::string &sprite_url = style->getSpriteURL();
     if (!sprite || sprite->pixelRatio != pixelRatio) {
-        sprite = Sprite::Create(sprite_url, pixelRatio, fileSource);
+        sprite = Sprite::Create(sprite_url, pixelRatio, fileSource, getWorker(), [this] {
+            update();
+        });
     }
 
     return sprite;
@@ -561,6 +670,182 @@ void Map::stopRotating() {
 }
 
 
+#pragma mark - Threading
+
+void Map::setWorkerCount(unsigned int count) {
+    assert(!workers);
+    workerCount = count;
+}
+
+WorkerStatistics Map::getWorkerStatistics() const {
+    std::lock_guard<std::mutex> lock(mutexWorkerStatistics);
+    return workerStatistics;
+}
+
+#pragma mark - Memory
+
+void Map::setTileCacheSize(size_t bytes) {
+    tileCacheSize = bytes;
+    update();
+}
+
+size_t Map::getTileCacheSize() const {
+    return tileCacheSize;
+}
+
+void Map::setGlyphCacheDirectory(const std::string &directory) {
+    glyphStore->setCacheDirectory(directory);
+}
+
+void Map::setBucketCacheDirectory(const std::string &directory) {
+    std::lock_guard<std::mutex> lock(mutexBucketCache);
+    bucketCache = std::make_shared<BucketCache>(directory);
+}
+
+util::ptr<BucketCache> Map::getBucketCache() const {
+    std::lock_guard<std::mutex> lock(mutexBucketCache);
+    return bucketCache;
+}
+
+void Map::setTileBufferRetention(bool retain) {
+    tileBufferRetention = retain;
+}
+
+bool Map::getTileBufferRetention() const {
+    return tileBufferRetention;
+}
+
+void Map::setFillFringes(bool enabled) {
+    fillFringes = enabled;
+}
+
+bool Map::getFillFringes() const {
+    return fillFringes;
+}
+
+void Map::setLocalGlyphRasterizer(std::unique_ptr<GlyphRasterizer> rasterizer,
+                                  const std::vector<std::pair<char32_t, char32_t>> &codePoints) {
+    glyphStore->setLocalGlyphRasterizer(std::move(rasterizer), codePoints);
+}
+
+void Map::onLowMemory(MemoryPressure pressure, LowMemoryCallback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutexMemoryUsage);
+        if (!lowMemory || pressure > memoryPressure) {
+            memoryPressure = pressure;
+        }
+        lowMemory = true;
+        if (callback) {
+            lowMemoryCallbacks.push_back(callback);
+        }
+    }
+    update();
+}
+
+void Map::getMemoryUsage(MemoryUsageCallback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutexMemoryUsage);
+        memoryUsageCallbacks.push_back(callback);
+    }
+    update();
+}
+
+void Map::onComplete(CompleteCallback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutexComplete);
+        completeCallbacks.push_back(callback);
+    }
+    update();
+}
+
+bool Map::isComplete() const {
+    if (!style || !startup.reached(StartupProfiler::Stage::Style) || glyphsPending ||
+        !sprite || !sprite->isDone()) {
+        return false;
+    }
+    return std::all_of(activeSources.begin(), activeSources.end(), [](const util::ptr<StyleSource> &source) {
+        return source->source && source->source->isComplete();
+    });
+}
+
+void Map::queryRenderedFeatures(double x, double y, double radius, QueryCallback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutexQuery);
+        queries.push_back({ x, y, radius, callback });
+    }
+    update();
+}
+
+void Map::renderSnapshot(const SnapshotOptions &options, SnapshotCallback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutexSnapshot);
+        snapshots.push_back({ options, callback });
+    }
+    update();
+}
+
+bool Map::isSnapshotComplete() const {
+    if (!snapshotState.hasSize()) {
+        return true;
+    }
+    if (!style || !startup.reached(StartupProfiler::Stage::Style) || glyphsPending ||
+        !sprite || !sprite->isDone()) {
+        return false;
+    }
+    return std::all_of(activeSources.begin(), activeSources.end(), [](const util::ptr<StyleSource> &source) {
+        return source->source && source->source->isSnapshotComplete();
+    });
+}
+
+std::vector<RenderedFeature> Map::queryRenderedFeatures(double x, double y, double radius) const {
+    assert(std::this_thread::get_id() == mapThread);
+    std::vector<RenderedFeature> result;
+    if (!style || !style->layers) {
+        return result;
+    }
+
+    // Matches the layers that Painter draws, topmost first.
+    const double zoom = state.getZoom();
+    const std::vector<util::ptr<StyleLayer>> &layers = style->layers->layers;
+    for (auto it = layers.rbegin(); it != layers.rend(); ++it) {
+        const util::ptr<StyleLayer> &layer = *it;
+        if (!layer || !layer->bucket || !layer->bucket->style_source || !layer->bucket->style_source->source) {
+            continue;
+        }
+        const StyleBucket &bucket = *layer->bucket;
+        if (bucket.visibility == VisibilityType::None || bucket.min_zoom > zoom || bucket.max_zoom <= zoom) {
+            continue;
+        }
+        bucket.style_source->source->queryFeatures(state, x, y, radius, *layer, result);
+    }
+    return result;
+}
+
+MapMemoryUsage Map::memoryUsage() const {
+    assert(std::this_thread::get_id() == mapThread);
+    MapMemoryUsage usage;
+
+    for (const auto& source : activeSources) {
+        if (source->source) {
+            SourceMemoryUsage& sourceUsage = usage.sources[source->info.id] = source->source->memoryUsage();
+            usage.total += sourceUsage.total;
+        }
+    }
+
+    usage.atlases["glyphs"] = glyphAtlas->memoryUsage();
+    usage.atlases["sprites"] = spriteAtlas->memoryUsage();
+    usage.atlases["lines"] = lineAtlas->memoryUsage();
+    usage.atlases["textures"] = texturePool->memoryUsage();
+    usage.atlases["buffers"] = MemoryUsage(BufferPool::shared().memoryUsage(), 0);
+    for (const auto& atlas : usage.atlases) {
+        usage.total += atlas.second;
+    }
+
+    usage.allocations = frameAllocations.toMap();
+
+    return usage;
+}
+
 #pragma mark - Toggles
 
 void Map::setDebug(bool value) {
@@ -578,6 +863,37 @@ bool Map::getDebug() const {
     return debug;
 }
 
+void Map::setGPUTiming(bool value) {
+    gpuTiming = value;
+    assert(painter);
+    painter->setGPUTiming(gpuTiming);
+    update();
+}
+
+bool Map::getGPUTiming() const {
+    return gpuTiming;
+}
+
+std::vector<std::pair<std::string, double>> Map::getGPUTimes() const {
+    assert(painter);
+    return painter->getGPUTimes();
+}
+
+std::pair<double, double> Map::getOverdraw() const {
+    assert(painter);
+    const Overdraw overdraw = painter->getOverdraw();
+    return { overdraw.opaque, overdraw.translucent };
+}
+
+FrameStatistics Map::getFrameStatistics() const {
+    std::lock_guard<std::mutex> lock(mutexFrameStatistics);
+    return frameStatistics;
+}
+
+TileLatencies Map::getTileLatencies() const {
+    return tileTrace->latencies();
+}
+
 void Map::addClass(const std::string& klass) {
     if (hasClass(klass)) return;
     classes.push_back(klass);
@@ -610,6 +926,44 @@ void Map::setClasses(const std::vector<std::string>& classes_) {
     }
 }
 
+bool Map::setPaintProperty(const std::string &layer, const std::string &name,
+                           const std::string &value, const std::string &klass) {
+    if (!style || !style->setPaintProperty(layer, name, value, klass)) {
+        return false;
+    }
+    update();
+    return true;
+}
+
+bool Map::setLayoutProperty(const std::string &layer, const std::string &name,
+                            const std::string &value) {
+    if (!style || !style->setLayoutProperty(layer, name, value)) {
+        return false;
+    }
+    update();
+    return true;
+}
+
+bool Map::setLayerVisible(const std::string &layer, bool visible) {
+    return setLayoutProperty(layer, "visibility", visible ? "\"visible\"" : "\"none\"");
+}
+
+void Map::setGeoJSONSourceData(const std::string &source, const std::string &json) {
+    {
+        std::lock_guard<std::mutex> lock(mutexGeoJSON);
+        geojsonUpdates.push_back({ source, json, true });
+    }
+    update();
+}
+
+void Map::updateGeoJSONSourceFeatures(const std::string &source, const std::string &json) {
+    {
+        std::lock_guard<std::mutex> lock(mutexGeoJSON);
+        geojsonUpdates.push_back({ source, json, false });
+    }
+    update();
+}
+
 bool Map::hasClass(const std::string& klass) const {
     return std::find(classes.begin(), classes.end(), klass) != classes.end();
 }
@@ -635,6 +989,7 @@ void Map::updateSources() {
     // First, disable all existing sources.
     for (const auto& source : activeSources) {
         source->enabled = false;
+        source->zoom_ranges.clear();
     }
 
     // Then, reenable all of those that we actually use when drawing this layer.
@@ -647,6 +1002,7 @@ void Map::updateSources() {
                 source->source = std::make_shared<Source>(source->info);
                 source->source->load(*this, fileSource);
             }
+            source->source->setZoomRanges(source->zoom_ranges);
         } else {
             source->source.reset();
         }
@@ -658,6 +1014,51 @@ void Map::updateSources() {
     });
 }
 
+void Map::updateGeoJSONSources() {
+    assert(std::this_thread::get_id() == mapThread);
+
+    std::vector<GeoJSONUpdate> updates;
+    {
+        std::lock_guard<std::mutex> lock(mutexGeoJSON);
+        updates.swap(geojsonUpdates);
+    }
+
+    // Data of sources that aren't drawn waits until they are, unless newer data replaces it.
+    std::vector<GeoJSONUpdate> waiting;
+    for (GeoJSONUpdate &update : updates) {
+        auto it = std::find_if(activeSources.begin(), activeSources.end(), [&update](const util::ptr<StyleSource> &source) {
+            return source->info.id == update.source;
+        });
+        if (it == activeSources.end()) {
+            if (update.replace) {
+                util::erase_if(waiting, [&update](const GeoJSONUpdate &other) {
+                    return other.source == update.source;
+                });
+            }
+            waiting.push_back(std::move(update));
+            continue;
+        }
+
+        StyleSource &source = **it;
+        if (source.info.type != SourceType::GeoJSON) {
+            Log::Warning(Event::General, "source '%s' isn't a GeoJSON source", update.source.c_str());
+            continue;
+        }
+
+        if (update.replace) {
+            // The source starts out with this data when it is created again.
+            source.info.url.clear();
+            source.info.geojson = update.json;
+        }
+        source.source->setGeoJSON(update.json, update.replace);
+    }
+
+    if (!waiting.empty()) {
+        std::lock_guard<std::mutex> lock(mutexGeoJSON);
+        geojsonUpdates.insert(geojsonUpdates.begin(), waiting.begin(), waiting.end());
+    }
+}
+
 void Map::updateSources(const util::ptr<StyleLayerGroup> &group) {
     if (!group) {
         return;
@@ -665,13 +1066,91 @@ void Map::updateSources(const util::ptr<StyleLayerGroup> &group) {
     for (const util::ptr<StyleLayer> &layer : group->layers) {
         if (!layer) continue;
         if (layer->bucket && layer->bucket->style_source) {
-            (*activeSources.emplace(layer->bucket->style_source).first)->enabled = true;
+            StyleSource &source = **activeSources.emplace(layer->bucket->style_source).first;
+            source.enabled = true;
+
+            // Layers that are never drawn don't need the tiles of the source. The source stays
+            // enabled so that its tiles are kept for when they are shown again.
+            if (layer->bucket->visibility != VisibilityType::None) {
+                source.zoom_ranges.emplace_back(layer->bucket->min_zoom, layer->bucket->max_zoom);
+            }
+        }
+    }
+}
+
+void Map::prefetchGlyphs(const util::ptr<StyleLayerGroup> &group) {
+    if (!group || style->glyph_url.empty()) {
+        return;
+    }
+    // Basic Latin and Latin-1 cover the labels of most maps.
+    const std::set<GlyphRange> ranges = { GlyphRange { 0, 255 } };
+    for (const util::ptr<StyleLayer> &layer : group->layers) {
+        if (!layer || !layer->bucket || !layer->bucket->render.is<StyleBucketSymbol>()) continue;
+        const StyleBucketSymbol &symbol = layer->bucket->render.get<StyleBucketSymbol>();
+        if (!symbol.text.field.empty()) {
+            glyphStore->requestGlyphRanges(symbol.text.font, ranges);
         }
     }
 }
 
+void Map::releaseMemory(MemoryPressure pressure, const std::vector<LowMemoryCallback> &callbacks) {
+    const auto tileMemory = [this] {
+        MemoryUsage usage;
+        for (const auto& source : activeSources) {
+            usage += source->source->memoryUsage().total;
+        }
+        return usage;
+    };
+
+    std::map<std::string, MemoryUsage> freed;
+
+    MemoryUsage before = tileMemory();
+    for (const auto& source : activeSources) {
+        source->source->clearCache();
+    }
+    MemoryUsage after = tileMemory();
+    freed["tiles"] = before - after;
+
+    for (const auto& source : activeSources) {
+        source->source->releaseMemory();
+    }
+    freed["decodedLayers"] = after - tileMemory();
+
+    // Includes the arrays of the tiles that were just dropped.
+    freed["buffers"] = MemoryUsage(BufferPool::shared().clear(), 0);
+
+    freed["fileSource"] = MemoryUsage(fileSource.releaseMemory(), 0);
+
+    if (pressure == MemoryPressure::Critical) {
+        before = texturePool->memoryUsage();
+        texturePool->clearTextureIDs();
+        freed["textures"] = before - texturePool->memoryUsage();
+        freed["tileTextures"] = painter->releaseTileTextures();
+    }
+
+    for (const LowMemoryCallback& callback : callbacks) {
+        callback(freed);
+    }
+}
+
 void Map::updateTiles() {
+    bool release = false;
+    MemoryPressure pressure;
+    std::vector<LowMemoryCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutexMemoryUsage);
+        release = lowMemory;
+        pressure = memoryPressure;
+        lowMemory = false;
+        callbacks.swap(lowMemoryCallbacks);
+    }
+    if (release) {
+        releaseMemory(pressure, callbacks);
+    }
+
+    const size_t cacheSize = activeSources.empty() ? 0 : tileCacheSize / activeSources.size();
     for (const auto& source : activeSources) {
+        source->source->setCacheSize(cacheSize);
         source->source->update(*this, getWorker(),
                                style, *glyphAtlas, *glyphStore,
                                *spriteAtlas, getSprite(),
@@ -684,19 +1163,39 @@ void Map::prepare() {
         fileSource.setLoop(**loop);
     }
 
+    std::string url;
+    bool loadStyle = false;
+    {
+        std::lock_guard<std::mutex> lock(mutexStyleURL);
+        if (!style || styleURLChanged) {
+            url = styleURL;
+            loadStyle = true;
+            styleURLChanged = false;
+        }
+    }
+
     if (!style) {
         style = std::make_shared<Style>();
+    }
 
-        fileSource.request(ResourceType::JSON, styleURL)->onload([&](const Response &res) {
+    if (loadStyle) {
+        fileSource.request(ResourceType::JSON, url)->onload([this, url](const Response &res) {
             if (res.code == 200) {
                 // Calculate the base
-                const size_t pos = styleURL.rfind('/');
+                const size_t pos = url.rfind('/');
                 std::string base = "";
                 if (pos != std::string::npos) {
-                    base = styleURL.substr(0, pos + 1);
+                    base = url.substr(0, pos + 1);
                 }
 
-                setStyleJSON(res.data, base);
+                setStyleJSON(*res.data, base);
+
+                // Request the TileJSON of the sources, the sprite and the glyphs right away
+                // instead of waiting for the next frame to be prepared.
+                updateSources();
+                getSprite();
+                glyphsPending = false;
+                prefetchGlyphs(style->layers);
             } else {
                 Log::Error(Event::Setup, "loading style failed: %ld (%s)", res.code, res.message.c_str());
             }
@@ -710,24 +1209,223 @@ void Map::prepare() {
     }
 
     state = transform.currentState();
+    predictedState = transform.predictedState(500_milliseconds);
+    {
+        std::lock_guard<std::mutex> lock(mutexSnapshot);
+        if (snapshots.empty()) {
+            snapshotState = TransformState();
+        } else {
+            const SnapshotOptions &options = snapshots.front().options;
+            double lon = 0, lat = 0;
+            state.getLonLat(lon, lat);
+            snapshotState = state.resized(options.width ? options.width : state.getWidth(),
+                                          options.height ? options.height : state.getHeight(),
+                                          options.pixelRatio)
+                                 .moved(std::isnan(options.lon) ? lon : options.lon,
+                                        std::isnan(options.lat) ? lat : options.lat,
+                                        std::isnan(options.zoom) ? state.getZoom() : options.zoom,
+                                        std::isnan(options.bearing) ? state.getAngle() : -options.bearing * M_PI / 180);
+        }
+    }
 
     animationTime = util::now();
-    updateSources();
-    style->updateProperties(state.getNormalizedZoom(), animationTime);
+    {
+        FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::UpdateSources);
+        updateSources();
+        updateGeoJSONSources();
+    }
+    if (glyphsPending) {
+        glyphsPending = false;
+        prefetchGlyphs(style->layers);
+    }
+    {
+        FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::UpdateProperties);
+        style->updateProperties(state.getNormalizedZoom(), animationTime);
+    }
 
     // Allow the sprite atlas to potentially pull new sprite images if needed.
     spriteAtlas->resize(state.getPixelRatio());
     spriteAtlas->setSprite(getSprite());
 
-    updateTiles();
+    {
+        FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::UpdateTiles);
+        updateTiles();
+    }
+
+    if (workers) {
+        const uv_worker_stats_t stats = workers->getStats();
+        std::lock_guard<std::mutex> lock(mutexWorkerStatistics);
+        workerStatistics.threads = stats.threads;
+        workerStatistics.peakThreads = stats.peak_threads;
+        workerStatistics.queued = stats.queued;
+        workerStatistics.completed = stats.completed;
+        workerStatistics.busyTime = stats.busy_time;
+    }
+
+    if (!startup.reached(StartupProfiler::Stage::Sprite) && sprite && sprite->isLoaded()) {
+        startup.record(StartupProfiler::Stage::Sprite);
+    }
+    if (!startup.reached(StartupProfiler::Stage::Sources) && startup.reached(StartupProfiler::Stage::Style) &&
+        std::all_of(activeSources.begin(), activeSources.end(), [](const util::ptr<StyleSource> &source) {
+            return source->source->isLoaded();
+        })) {
+        startup.record(StartupProfiler::Stage::Sources);
+    }
+
+    std::vector<MemoryUsageCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutexMemoryUsage);
+        callbacks.swap(memoryUsageCallbacks);
+    }
+    if (!callbacks.empty()) {
+        const MapMemoryUsage usage = memoryUsage();
+        for (const MemoryUsageCallback& callback : callbacks) {
+            callback(usage);
+        }
+    }
+
+    std::vector<Query> pendingQueries;
+    {
+        std::lock_guard<std::mutex> lock(mutexQuery);
+        pendingQueries.swap(queries);
+    }
+    for (const Query &query : pendingQueries) {
+        query.callback(queryRenderedFeatures(query.x, query.y, query.radius));
+    }
+
+    // A static map renders exactly one frame, as soon as it can show everything.
+    if (mode == Mode::Static && isComplete() && isSnapshotComplete()) {
+        uv_stop(**loop);
+    }
+}
+
+void Map::renderSnapshot() {
+    if (!snapshotState.hasSize() || !isSnapshotComplete()) {
+        return;
+    }
+
+    Snapshot snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutexSnapshot);
+        snapshot = std::move(snapshots.front());
+        snapshots.pop_front();
+    }
+
+    // The sources draw the tiles they loaded for the snapshot, and the style its properties at
+    // the snapshot's zoom level, until the view's frame is drawn again.
+    const std::array<uint16_t, 2> size = snapshotState.getFramebufferDimensions();
+    const SnapshotCallback callback = snapshot.callback;
+    style->updateProperties(snapshotState.getNormalizedZoom(), animationTime);
+    for (const util::ptr<StyleSource> &source : activeSources) {
+        source->source->swapSnapshotTiles();
+    }
+    painter->renderSnapshot(*style, activeSources, snapshotState, animationTime,
+                            [callback, size](std::unique_ptr<uint32_t[]> pixels) {
+        callback(std::move(pixels), size[0], size[1]);
+    });
+    for (const util::ptr<StyleSource> &source : activeSources) {
+        source->source->swapSnapshotTiles();
+    }
+    style->updateProperties(state.getNormalizedZoom(), animationTime);
+
+    // Prepares the next snapshot, or lets the sources drop the tiles of this one.
+    snapshotState = TransformState();
+    update();
+}
+
+void Map::updateResolution() {
+    assert(painter);
+    if (!adaptiveResolution || !state.isChanging()) {
+        // Still frames are always sharp; the next interaction starts from the resolution that
+        // the last one ended with.
+        lastMovingFrame = 0;
+        fastFrames = 0;
+        painter->setResolution(1);
+        return;
+    }
+
+    const timestamp now = util::now();
+    const timestamp interval = lastMovingFrame ? now - lastMovingFrame : 0;
+    lastMovingFrame = now;
+
+    // Gaps between interactions, or frames that waited for input, say nothing about how long
+    // drawing takes.
+    if (interval > 0 && interval <= 100_milliseconds) {
+        frameInterval = frameInterval ? (frameInterval * 3 + interval) / 4 : interval;
+
+        if (frameInterval > 20_milliseconds) {
+            fastFrames = 0;
+            if (movingResolution > 0.5f) {
+                movingResolution = std::max(0.5f, movingResolution - 0.25f);
+                // Let the smoothed interval settle at the new resolution before stepping again.
+                frameInterval = 0;
+            }
+        } else if (frameInterval <= 17500_microseconds && movingResolution < 1) {
+            fastFrames += interval;
+            if (fastFrames >= 2_seconds) {
+                fastFrames = 0;
+                movingResolution = std::min(1.0f, movingResolution + 0.25f);
+                frameInterval = 0;
+            }
+        } else {
+            fastFrames = 0;
+        }
+    }
+
+    painter->setResolution(movingResolution);
 }
 
 void Map::render() {
     assert(painter);
+    // The snapshots that were drawn during the last frame are done by now.
+    painter->finishReads();
+    texturePool->collect();
+    updateResolution();
     painter->render(*style, activeSources,
                    state, animationTime);
-    // Schedule another rerender when we definitely need a next frame.
-    if (transform.needsTransition() || style->hasTransitions()) {
+    {
+        const gl::State::Stats &stats = painter->getFrameStats();
+        std::lock_guard<std::mutex> lock(mutexFrameStatistics);
+        frameStatistics.drawCalls = stats.draws;
+        frameStatistics.stateChanges = stats.calls - stats.redundant;
+        frameStatistics.redundantStateChanges = stats.redundant;
+    }
+    std::vector<CompleteCallback> complete;
+    if (mode == Mode::Static || isComplete()) {
+        std::lock_guard<std::mutex> lock(mutexComplete);
+        complete.swap(completeCallbacks);
+    }
+    for (const CompleteCallback &callback : complete) {
+        callback();
+    }
+    renderSnapshot();
+    if (AllocationTracker::isEnabled()) {
+        const AllocationTracker::Counts allocations = AllocationTracker::total();
+        frameAllocations = allocations - frameEndAllocations;
+        frameEndAllocations = allocations;
+    }
+    if (!startup.reached(StartupProfiler::Stage::FirstFrame) &&
+        std::any_of(activeSources.begin(), activeSources.end(), [](const util::ptr<StyleSource> &source) {
+            return !source->source->getLoadedTiles().empty();
+        })) {
+        startup.record(StartupProfiler::Stage::FirstFrame);
+    }
+    // Schedule the next frame for when something changes on screen. Transitions that are delayed
+    // don't need any frames until they start.
+    timestamp next = style->nextTransition(animationTime);
+    if (transform.needsTransition() || painter->needsAnimation() ||
+        (mode == Mode::Continuous && (painter->hasPendingUploads() || painter->hasPendingReads()))) {
+        next = animationTime;
+    }
+
+    if (next == noTransition) {
+        return;
+    }
+
+    const timestamp now = util::now();
+    if (next <= now || !frameTimer) {
         update();
+    } else {
+        frameTimer->start(1 + (next - now) / 1_millisecond);
     }
 }
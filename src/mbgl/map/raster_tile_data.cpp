@@ -18,17 +18,31 @@ void RasterTileData::parse() {
         return;
     }
 
-    if (bucket.setImage(data)) {
+    if (bucket.setImage(*data)) {
         state = State::parsed;
     } else {
         state = State::invalid;
     }
 }
 
-void RasterTileData::render(Painter &painter, util::ptr<StyleLayer> layer_desc, const mat4 &matrix) {
+void RasterTileData::render(Painter &painter, const util::ptr<StyleLayer> &layer_desc, const mat4 &matrix) {
     bucket.render(painter, layer_desc, id, matrix);
 }
 
 bool RasterTileData::hasData(StyleLayer const& /*layer_desc*/) const {
     return bucket.hasData();
 }
+
+TileMemoryUsage RasterTileData::memoryUsage() const {
+    TileMemoryUsage usage = TileData::memoryUsage();
+    usage.buckets["raster"] = bucket.memoryUsage();
+    usage.total += usage.buckets["raster"];
+    return usage;
+}
+
+size_t RasterTileData::upload(size_t maxBytes) {
+    // Textures are uploaded in one piece, so this may exceed the budget.
+    const size_t bytes = bucket.upload(maxBytes);
+    uploaded = bucket.isUploaded();
+    return bytes;
+}
@@ -20,8 +20,10 @@ public:
     ~RasterTileData();
 
     virtual void parse();
-    virtual void render(Painter &painter, util::ptr<StyleLayer> layer_desc, const mat4 &matrix);
+    virtual void render(Painter &painter, const util::ptr<StyleLayer> &layer_desc, const mat4 &matrix);
     virtual bool hasData(StyleLayer const& layer_desc) const;
+    virtual TileMemoryUsage memoryUsage() const;
+    virtual size_t upload(size_t maxBytes);
 
 protected:
     StyleBucketRaster properties;
@@ -0,0 +1,76 @@
+#include <mbgl/map/shared_buckets.hpp>
+#include <mbgl/map/vector_tile_data.hpp>
+#include <mbgl/renderer/bucket.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace mbgl {
+
+namespace {
+
+struct Shared {
+    std::weak_ptr<const std::string> data;
+    int8_t z;
+    float depth;
+    std::weak_ptr<StyleBucket> bucket_desc;
+    std::weak_ptr<TileBuffers> buffers;
+    std::weak_ptr<Bucket> bucket;
+    std::weak_ptr<const FeatureIndex> featureIndex;
+
+    bool expired() const {
+        return data.expired() || bucket_desc.expired() || buffers.expired() || bucket.expired();
+    }
+};
+
+std::mutex mtx;
+
+// Keyed by the hash of the tile data.
+std::unordered_multimap<size_t, Shared> buckets;
+size_t sweepSize = 64;
+
+}
+
+SharedBuckets::Entry SharedBuckets::find(const std::string &data, size_t hash, int8_t z, float depth,
+                                         const util::ptr<StyleBucket> &bucket_desc) {
+    std::lock_guard<std::mutex> lock(mtx);
+    const auto range = buckets.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const Shared &shared = it->second;
+        if (shared.z != z || shared.depth != depth || shared.bucket_desc.lock() != bucket_desc) {
+            continue;
+        }
+
+        // Buckets are kept alive by the tiles that use them, which also hold on to their data.
+        const std::shared_ptr<const std::string> sharedData = shared.data.lock();
+        Entry entry { shared.buffers.lock(), shared.bucket.lock(), shared.featureIndex.lock() };
+        if (sharedData && entry.buffers && entry.bucket && (sharedData.get() == &data || *sharedData == data)) {
+            return entry;
+        }
+    }
+    return {};
+}
+
+void SharedBuckets::add(const std::shared_ptr<const std::string> &data, size_t hash, int8_t z,
+                        float depth, const util::ptr<StyleBucket> &bucket_desc, const Entry &entry) {
+    std::lock_guard<std::mutex> lock(mtx);
+    const auto range = buckets.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.bucket.lock() == entry.bucket) {
+            // Taken over from another tile.
+            return;
+        }
+    }
+    buckets.emplace(hash, Shared { data, z, depth, bucket_desc, entry.buffers, entry.bucket, entry.featureIndex });
+
+    // Forget the buckets of destroyed tiles once the table doubled in size.
+    if (buckets.size() >= sweepSize) {
+        for (auto it = buckets.begin(); it != buckets.end();) {
+            it = it->second.expired() ? buckets.erase(it) : std::next(it);
+        }
+        sweepSize = std::max(size_t(64), buckets.size() * 2);
+    }
+}
+
+}
@@ -0,0 +1,41 @@
+#ifndef MBGL_MAP_SHARED_BUCKETS
+#define MBGL_MAP_SHARED_BUCKETS
+
+#include <mbgl/util/ptr.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace mbgl {
+
+class Bucket;
+class FeatureIndex;
+class StyleBucket;
+class TileBuffers;
+
+// Fill and line buckets of tiles with byte-identical data, like open ocean or empty land at low
+// zoom levels. Those tiles only differ by their matrix, so they draw the same geometry from the
+// same buffers instead of parsing and uploading it for every tile.
+//
+// Buckets are only added once the parse that created them finished, since the buffers they live
+// in don't change from then on.
+class SharedBuckets {
+public:
+    struct Entry {
+        util::ptr<TileBuffers> buffers;
+        util::ptr<Bucket> bucket;
+        util::ptr<const FeatureIndex> featureIndex;
+    };
+
+    // Returns the bucket of a tile at zoom level /z/ with the same data, or an empty entry.
+    static Entry find(const std::string &data, size_t hash, int8_t z, float depth,
+                      const util::ptr<StyleBucket> &bucket_desc);
+
+    static void add(const std::shared_ptr<const std::string> &data, size_t hash, int8_t z,
+                    float depth, const util::ptr<StyleBucket> &bucket_desc, const Entry &entry);
+};
+
+}
+
+#endif
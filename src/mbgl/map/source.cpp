@@ -14,17 +14,20 @@
 #include <mbgl/util/mapbox.hpp>
 #include <mbgl/geometry/glyph_atlas.hpp>
 #include <mbgl/style/style_layer.hpp>
+#include <mbgl/text/collision.hpp>
 #include <mbgl/platform/log.hpp>
 
 #include <mbgl/map/vector_tile_data.hpp>
 #include <mbgl/map/raster_tile_data.hpp>
+#include <mbgl/util/uv_detail.hpp>
 
 #include <algorithm>
 
 namespace mbgl {
 
 Source::Source(SourceInfo& info_)
-    : info(info_)
+    : info(info_),
+      collisionIndex(std::make_shared<CollisionIndex>())
 {
 }
 
@@ -32,6 +35,11 @@ Source::Source(SourceInfo& info_)
 // The reason this isn't part of the constructor is that calling shared_from_this() in
 // the constructor fails.
 void Source::load(Map& map, FileSource& fileSource) {
+    if (info.type == SourceType::GeoJSON) {
+        loadGeoJSON(map, fileSource);
+        return;
+    }
+
     if (info.url.empty()) {
         loaded = true;
         return;
@@ -46,7 +54,7 @@ void Source::load(Map& map, FileSource& fileSource) {
         }
 
         rapidjson::Document d;
-        d.Parse<0>(res.data.c_str());
+        d.Parse<0>(res.data->c_str());
 
         if (d.HasParseError()) {
             Log::Warning(Event::General, "invalid source TileJSON");
@@ -61,7 +69,118 @@ void Source::load(Map& map, FileSource& fileSource) {
     });
 }
 
-void Source::updateClipIDs(const std::map<Tile::ID, ClipID> &mapping) {
+void Source::loadGeoJSON(Map& map, FileSource& fileSource) {
+    if (info.url.empty()) {
+        setGeoJSON(info.geojson.empty() ? R"({"type":"FeatureCollection","features":[]})" : info.geojson, true);
+        return;
+    }
+
+    util::ptr<Source> source = shared_from_this();
+
+    fileSource.request(ResourceType::JSON, info.url)->onload([source, &map](const Response &res) {
+        if (res.code != 200) {
+            Log::Warning(Event::General, "failed to load GeoJSON source data");
+            return;
+        }
+
+        source->setGeoJSON(*res.data, true);
+        map.update();
+    });
+}
+
+void Source::setGeoJSON(const std::string &json, bool replace) {
+    if (replace) {
+        geojsonQueue.clear();
+    }
+    geojsonQueue.emplace_back(json, replace);
+}
+
+namespace {
+
+struct GeoJSONJob {
+    GeoJSONJob(util::ptr<const GeoJSONTileIndex> index_, std::vector<std::pair<std::string, bool>> &&queue_,
+               const GeoJSONTileOptions &options_)
+        : index(index_), queue(std::move(queue_)), options(options_) {}
+
+    util::ptr<const GeoJSONTileIndex> index;
+    std::vector<std::pair<std::string, bool>> queue;
+    const GeoJSONTileOptions options;
+    GeoJSONTileIndex::Bounds changed;
+    bool replaced = false;
+};
+
+}
+
+void Source::indexGeoJSON(Map& map, uv::worker& worker) {
+    geojsonIndexing = true;
+
+    GeoJSONTileOptions options;
+    options.cluster = info.cluster;
+    options.clusterRadius = info.cluster_radius;
+    options.clusterMaxZoom = std::min<uint16_t>(info.cluster_max_zoom, 24);
+
+    std::weak_ptr<Source> weak_source = shared_from_this();
+    new uv::work<GeoJSONJob>(
+        worker,
+        [](GeoJSONJob& job) {
+            for (const auto &data : job.queue) {
+                if (data.second || !job.index) {
+                    job.index = std::make_shared<const GeoJSONTileIndex>(data.first, job.options);
+                    job.replaced = true;
+                } else {
+                    job.index = job.index->update(data.first, job.changed);
+                }
+            }
+        },
+        [weak_source, &map](GeoJSONJob& job) {
+            util::ptr<Source> source = weak_source.lock();
+            if (!source) {
+                return;
+            }
+
+            source->geojsonIndexing = false;
+            source->geojsonIndex = job.index;
+            source->geojsonReplaced = source->geojsonReplaced || job.replaced;
+            source->geojsonChanged.extend(job.changed);
+            source->loaded = true;
+            map.update();
+        },
+        nullptr,
+        geojsonIndex, std::move(geojsonQueue), options);
+    geojsonQueue.clear();
+}
+
+void Source::generateTile(TileData& data, uv::worker& worker, std::function<void ()> callback) {
+    const util::ptr<const GeoJSONTileIndex> index = geojsonIndex;
+    const Tile::ID id = data.id;
+    data.generate(worker, [index, id]() { return index->getTile(id); }, callback);
+}
+
+void Source::regenerateGeoJSONTiles(uv::worker& worker, std::function<void ()> callback) {
+    const auto outdated = [this](const Tile::ID &id) {
+        return geojsonReplaced || geojsonChanged.intersects(id);
+    };
+
+    // The tiles keep their buckets until the new ones are parsed.
+    for (const auto &pair : tile_data) {
+        const util::ptr<TileData> data = pair.second.lock();
+        if (data && data->state != TileData::State::obsolete && outdated(data->id)) {
+            generateTile(*data, worker, callback);
+        }
+    }
+
+    // Cached tiles are only cut again if they are needed again.
+    for (const util::ptr<TileData> &data : cache.getTiles()) {
+        if (outdated(data->id)) {
+            cache.take(data->id);
+        }
+    }
+
+    geojsonReplaced = false;
+    geojsonChanged = GeoJSONTileIndex::Bounds();
+}
+
+void Source::updateClipIDs(const std::unordered_map<Tile::ID, ClipID, Tile::ID::Hash> &mapping) {
     std::for_each(tiles.begin(), tiles.end(), [&mapping](std::pair<const Tile::ID, std::unique_ptr<Tile>> &pair) {
         Tile &tile = *pair.second;
         auto it = mapping.find(tile.id);
@@ -73,11 +192,50 @@ void Source::updateClipIDs(const std::map<Tile::ID, ClipID> &mapping) {
     });
 }
 
-void Source::updateMatrices(const mat4 &projMatrix, const TransformState &transform) {
+void Source::queryFeatures(const TransformState &state, double x, double y, double radius,
+                           const StyleLayer &layer_desc, std::vector<RenderedFeature> &result) const {
+    if (info.type != SourceType::Vector && info.type != SourceType::GeoJSON) {
+        return;
+    }
+
+    // Where a tile overlaps with tiles of lower zoom levels that are kept while it loads, it is the
+    // one that is drawn.
+    const Tile *hit = nullptr;
+    double tileX = 0, tileY = 0;
+    for (const auto &pair : tiles) {
+        const Tile &tile = *pair.second;
+        if (!tile.data->renderable() || (hit && hit->id.z >= tile.id.z)) {
+            continue;
+        }
+
+        const std::array<double, 2> coordinate = state.pointCoordinate(x, y, tile.id.z);
+        const double px = (coordinate[0] - tile.id.x) * 4096;
+        const double py = (coordinate[1] - tile.id.y) * 4096;
+        if (px >= 0 && py >= 0 && px < 4096 && py < 4096) {
+            hit = &tile;
+            tileX = px;
+            tileY = py;
+        }
+    }
+    if (!hit) {
+        return;
+    }
+
+    const double unitsPerPixel = 4096 * std::pow(2, hit->id.z) / state.worldSize();
+    static_cast<const VectorTileData &>(*hit->data).queryFeatures(layer_desc, tileX, tileY, radius * unitsPerPixel, result);
+}
+
+void Source::updateMatrices(const mat4 &projMatrix, const TransformState &transform,
+                            std::unordered_map<Tile::ID, mat4, Tile::ID::Hash> &matrices) {
     for (std::pair<const Tile::ID, std::unique_ptr<Tile>> &pair : tiles) {
         Tile &tile = *pair.second;
-        transform.matrixFor(tile.matrix, tile.id);
-        matrix::multiply(tile.matrix, projMatrix, tile.matrix);
+        auto it = matrices.find(tile.id);
+        if (it == matrices.end()) {
+            transform.matrixFor(tile.matrix, tile.id, projMatrix);
+            matrices.emplace(tile.id, tile.matrix);
+        } else {
+            tile.matrix = it->second;
+        }
     }
 }
 
@@ -88,28 +246,11 @@ size_t Source::getTileCount() const {
 void Source::drawClippingMasks(Painter &painter) {
     for (std::pair<const Tile::ID, std::unique_ptr<Tile>> &pair : tiles) {
         Tile &tile = *pair.second;
-        gl::group group(std::string { "mask: " } + std::string(tile.id));
+        MBGL_GL_GROUP(std::string { "mask: " } + std::string(tile.id));
         painter.drawClippingMask(tile.matrix, tile.clip);
     }
 }
 
-void Source::render(Painter &painter, util::ptr<StyleLayer> layer_desc) {
-    gl::group group(std::string { "layer: " } + layer_desc->id);
-    for (const std::pair<const Tile::ID, std::unique_ptr<Tile>> &pair : tiles) {
-        Tile &tile = *pair.second;
-        if (tile.data && tile.data->state == TileData::State::parsed) {
-            painter.renderTileLayer(tile, layer_desc, tile.matrix);
-        }
-    }
-}
-
-void Source::render(Painter &painter, util::ptr<StyleLayer> layer_desc, const Tile::ID &id, const mat4 &matrix) {
-    auto it = tiles.find(id);
-    if (it != tiles.end() && it->second->data && it->second->data->state == TileData::State::parsed) {
-        painter.renderTileLayer(*it->second, layer_desc, matrix);
-    }
-}
-
 void Source::finishRender(Painter &painter) {
     for (std::pair<const Tile::ID, std::unique_ptr<Tile>> &pair : tiles) {
         Tile &tile = *pair.second;
@@ -129,22 +270,80 @@ std::forward_list<Tile::ID> Source::getIDs() const {
 
 std::forward_list<Tile *> Source::getLoadedTiles() const {
     std::forward_list<Tile *> ptrs;
-    auto it = ptrs.before_begin();
     for (const auto &pair : tiles) {
-        if (pair.second->data->ready()) {
-            it = ptrs.insert_after(it, pair.second.get());
+        if (pair.second->data->renderable()) {
+            ptrs.push_front(pair.second.get());
         }
     }
+    ptrs.sort([](const Tile *a, const Tile *b) { return a->id < b->id; });
     return ptrs;
 }
 
+std::forward_list<Tile *> Source::getPendingUploads() const {
+    std::forward_list<Tile *> ptrs;
+    for (const auto &pair : tiles) {
+        const TileData &data = *pair.second->data;
+        if (data.needsUpload()) {
+            ptrs.push_front(pair.second.get());
+        }
+    }
+    return ptrs;
+}
+
+
+void Source::setCacheSize(size_t bytes) {
+    cache.setMaxBytes(bytes);
+}
+
+void Source::clearCache() {
+    cache.clear();
+}
+
+void Source::releaseMemory() {
+    for (const auto& pair : tile_data) {
+        const util::ptr<TileData> tile = pair.second.lock();
+        if (tile) {
+            tile->releaseMemory();
+        }
+    }
+}
+
+SourceMemoryUsage Source::memoryUsage() const {
+    SourceMemoryUsage usage;
+
+    const auto add = [&usage](const TileData& tile, bool cached) {
+        TileMemoryUsage& tileUsage = usage.tiles[tile.id] = tile.memoryUsage();
+        tileUsage.cached = cached;
+        usage.total += tileUsage.total;
+        if (cached) {
+            usage.cached += tileUsage.total;
+        }
+        for (const auto& bucket : tileUsage.buckets) {
+            usage.buckets[bucket.first] += bucket.second;
+        }
+    };
+
+    for (const auto& pair : tile_data) {
+        const util::ptr<TileData> tile = pair.second.lock();
+        if (tile) {
+            add(*tile, false);
+        }
+    }
+    for (const util::ptr<TileData>& tile : cache.getTiles()) {
+        add(*tile, true);
+    }
+
+    return usage;
+}
 
 TileData::State Source::hasTile(const Tile::ID& id) {
     auto it = tiles.find(id);
     if (it != tiles.end()) {
         Tile &tile = *it->second;
         if (tile.id == id && tile.data) {
-            return tile.data->state;
+            // Until its geometry is uploaded, the tile can't stand in for its parents or children.
+            const TileData::State state = tile.data->state;
+            return state == TileData::State::parsed && !tile.data->uploaded ? TileData::State::loaded : state;
         }
     }
 
@@ -171,66 +370,248 @@ TileData::State Source::addTile(Map& map, uv::worker& worker,
     // Try to find the associated TileData object.
     const Tile::ID normalized_id = id.normalized();
 
+    new_tile.data = getTileData(normalized_id);
+
+    if (!new_tile.data) {
+        // If we don't find working tile data, we're just going to load it.
+        new_tile.data = loadTileData(map, worker, style, glyphAtlas, glyphStore, spriteAtlas, sprite,
+                                     fileSource, texturePool, normalized_id, 0, callback);
+    }
+
+    return new_tile.data->state;
+}
+
+util::ptr<TileData> Source::getTileData(const Tile::ID& normalized_id) {
+    util::ptr<TileData> data;
+
     auto it = tile_data.find(normalized_id);
     if (it != tile_data.end()) {
         // Create a shared_ptr handle. Note that this might be empty!
-        new_tile.data = it->second.lock();
+        data = it->second.lock();
+    }
+
+    if (!data) {
+        // Tiles we have seen before can be shown right away.
+        data = cache.take(normalized_id);
+        if (data) {
+            tile_data[normalized_id] = data;
+        }
     }
 
-    if (new_tile.data && new_tile.data->state == TileData::State::obsolete) {
+    if (data && data->state == TileData::State::obsolete) {
         // Do not consider the tile if it's already obsolete.
-        new_tile.data.reset();
+        data.reset();
     }
 
-    if (!new_tile.data) {
-        // If we don't find working tile data, we're just going to load it.
-        if (info.type == SourceType::Vector) {
-            new_tile.data = std::make_shared<VectorTileData>(normalized_id, map.getMaxZoom(), style,
-                                                             glyphAtlas, glyphStore,
-                                                             spriteAtlas, sprite,
-                                                             texturePool, info);
-        } else if (info.type == SourceType::Raster) {
-            new_tile.data = std::make_shared<RasterTileData>(normalized_id, texturePool, info);
-        } else {
-            throw std::runtime_error("source type not implemented");
+    return data;
+}
+
+util::ptr<TileData> Source::loadTileData(Map& map, uv::worker& worker,
+                                         util::ptr<Style> style,
+                                         GlyphAtlas& glyphAtlas, GlyphStore& glyphStore,
+                                         SpriteAtlas& spriteAtlas, util::ptr<Sprite> sprite,
+                                         FileSource& fileSource, TexturePool& texturePool,
+                                         const Tile::ID& normalized_id, float priority,
+                                         std::function<void ()> callback) {
+    util::ptr<TileData> data;
+    if (info.type == SourceType::Vector || info.type == SourceType::GeoJSON) {
+        // The tiles of the source's maximum zoom level are placed for the map's maximum zoom
+        // level, which is deeper in the source's zoom levels if its tiles are smaller.
+        const float maxZoom = map.getMaxZoom() + info.getZoomOffset(map.getState().getPixelRatio());
+        auto vectorData = std::make_shared<VectorTileData>(normalized_id, maxZoom, style,
+                                                           glyphAtlas, glyphStore,
+                                                           spriteAtlas, sprite,
+                                                           texturePool, info, collisionIndex);
+        vectorData->setBucketCache(map.getBucketCache());
+        vectorData->setBufferRetention(map.getTileBufferRetention());
+        vectorData->setFillFringes(map.getFillFringes());
+        vectorData->setParseWorker(&worker);
+        data = vectorData;
+    } else if (info.type == SourceType::Raster) {
+        data = std::make_shared<RasterTileData>(normalized_id, texturePool, info);
+    } else {
+        throw std::runtime_error("source type not implemented");
+    }
+
+    data->setPriority(priority);
+    data->setTrace(map.getTileTrace());
+    if (info.type == SourceType::GeoJSON) {
+        generateTile(*data, worker, callback);
+    } else {
+        data->request(worker, fileSource, map.getState().getPixelRatio(), callback);
+    }
+    tile_data[data->id] = data;
+    return data;
+}
+
+void Source::prefetchTiles(Map& map, uv::worker& worker,
+                           util::ptr<Style> style,
+                           GlyphAtlas& glyphAtlas, GlyphStore& glyphStore,
+                           SpriteAtlas& spriteAtlas, util::ptr<Sprite> sprite,
+                           FileSource& fileSource, TexturePool& texturePool,
+                           const std::forward_list<Tile::ID>& required,
+                           std::function<void ()> callback) {
+    const TransformState& predicted = map.getPredictedState();
+    std::unordered_map<Tile::ID, util::ptr<TileData>, Tile::ID::Hash> next;
+
+    if (predicted.hasSize()) {
+        const int32_t zoom = std::floor(getZoom(predicted));
+        const vec2<double> center = predicted.cornersToBox(std::max(zoom, 0)).center;
+
+        for (const Tile::ID& id : coveringTiles(predicted, predictedCovering)) {
+            if (std::find(required.begin(), required.end(), id) != required.end()) {
+                continue;
+            }
+
+            // Prefetched tiles aren't rendered, so we only keep their data around until the map
+            // arrives and addTile() picks it up.
+            const Tile::ID normalized_id = id.normalized();
+            util::ptr<TileData> data = getTileData(normalized_id);
+
+            const float priority = PrefetchRequestPriority + getPriority(id, center, zoom);
+            if (!data) {
+                data = loadTileData(map, worker, style, glyphAtlas, glyphStore, spriteAtlas, sprite,
+                                    fileSource, texturePool, normalized_id, priority, callback);
+            }
+            next.emplace(normalized_id, data);
         }
+    }
+
+    // Tiles that we no longer expect to need are canceled below unless they're in use.
+    prefetched.swap(next);
+}
 
-        new_tile.data->request(worker, fileSource, map.getState().getPixelRatio(), callback);
-        tile_data.emplace(new_tile.data->id, new_tile.data);
+void Source::updateSnapshotTiles(Map& map, uv::worker& worker,
+                                 util::ptr<Style> style,
+                                 GlyphAtlas& glyphAtlas, GlyphStore& glyphStore,
+                                 SpriteAtlas& spriteAtlas, util::ptr<Sprite> sprite,
+                                 FileSource& fileSource, TexturePool& texturePool,
+                                 std::function<void ()> callback) {
+    const TransformState& snapshot = map.getSnapshotState();
+    std::unordered_map<Tile::ID, std::unique_ptr<Tile>, Tile::ID::Hash> next;
+
+    if (snapshot.hasSize()) {
+        const int32_t zoom = std::floor(getZoom(snapshot));
+        const vec2<double> center = snapshot.cornersToBox(std::max(zoom, 0)).center;
+
+        for (const Tile::ID& id : coveringTiles(snapshot, snapshotCovering)) {
+            auto it = snapshotTiles.find(id);
+            if (it != snapshotTiles.end()) {
+                next.emplace(id, std::move(it->second));
+                continue;
+            }
+
+            const Tile::ID normalized_id = id.normalized();
+            std::unique_ptr<Tile> tile = util::make_unique<Tile>(id);
+            tile->data = getTileData(normalized_id);
+            if (!tile->data) {
+                tile->data = loadTileData(map, worker, style, glyphAtlas, glyphStore, spriteAtlas, sprite,
+                                          fileSource, texturePool, normalized_id,
+                                          getPriority(id, center, zoom), callback);
+            }
+            next.emplace(id, std::move(tile));
+        }
+    } else {
+        snapshotCovering = Covering();
     }
 
-    return new_tile.data->state;
+    snapshotTiles.swap(next);
+}
+
+void Source::swapSnapshotTiles() {
+    tiles.swap(snapshotTiles);
+}
+
+bool Source::isSnapshotComplete() const {
+    if (!loaded || !updated || !geojsonQueue.empty() || geojsonIndexing || geojsonReplaced ||
+        !geojsonChanged.empty()) {
+        return false;
+    }
+
+    for (const Tile::ID& id : snapshotCovering.tiles) {
+        const auto it = snapshotTiles.find(id);
+        if (it == snapshotTiles.end() || !it->second->data->isComplete()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+float Source::getPriority(const Tile::ID& id, const vec2<double>& center, int32_t zoom) {
+    // Distance of the tile's center from the viewport center, in tiles. Don't
+    // penalize tiles for being on the other side of the antimeridian.
+    const double dim = std::pow(2, id.z);
+    double dx = std::fmod(std::fabs(id.x + 0.5 - center.x), dim);
+    dx = std::min(dx, dim - dx);
+    const double dy = std::fabs(id.y + 0.5 - center.y);
+
+    // A tile one zoom level off is about as urgent as one two tiles away.
+    return dx + dy + 2 * std::abs(id.z - zoom);
 }
 
 double Source::getZoom(const TransformState& state) const {
-    double offset = std::log(util::tileSize / info.tile_size) / std::log(2);
-    offset += (state.getPixelRatio() > 1.0 ? 1 :0);
-    return state.getZoom() + offset;
+    return state.getZoom() + info.getZoomOffset(state.getPixelRatio());
+}
+
+void Source::setZoomRanges(const std::vector<std::pair<float, float>> &ranges) {
+    zoomRanges = ranges;
+}
+
+// Matches the zoom levels at which Painter draws a layer.
+bool Source::isDrawnAt(double zoom) const {
+    return std::any_of(zoomRanges.begin(), zoomRanges.end(), [zoom](const std::pair<float, float> &range) {
+        return range.first <= zoom && zoom < range.second;
+    });
 }
 
 int32_t Source::coveringZoomLevel(const TransformState& state) const {
     return std::floor(getZoom(state));
 }
 
-std::forward_list<Tile::ID> Source::coveringTiles(const TransformState& state) const {
+namespace {
+
+inline bool operator==(const box& a, const box& b) {
+    return a.tl == b.tl && a.tr == b.tr && a.bl == b.bl && a.br == b.br;
+}
+
+}
+
+const std::forward_list<Tile::ID>& Source::coveringTiles(const TransformState& state, Covering& result) {
     int32_t z = coveringZoomLevel(state);
 
-    if (z < info.min_zoom) return {{}};
+    if (z < info.min_zoom || !isDrawnAt(state.getZoom())) {
+        result.valid = false;
+        result.tiles.clear();
+        return result.tiles;
+    }
+
+    // Beyond the source's maximum zoom level, we keep using its tiles and scale
+    // them up, so every overzoomed view shares one downloaded and decoded tile.
     if (z > info.max_zoom) z = info.max_zoom;
 
     // Map four viewport corners to pixel coordinates
     box points = state.cornersToBox(z);
+    if (result.valid && result.z == z && result.bounds == points) {
+        return result.tiles;
+    }
+
     const vec2<double>& center = points.center;
 
-    std::forward_list<Tile::ID> covering_tiles = Tile::cover(z, points);
+    result.tiles = Tile::cover(z, points);
+    result.tiles.remove_if([this](const Tile::ID& id) {
+        return !info.containsTile(id);
+    });
 
-    covering_tiles.sort([&center](const Tile::ID& a, const Tile::ID& b) {
+    result.tiles.sort([&center](const Tile::ID& a, const Tile::ID& b) {
         // Sorts by distance from the box center
         return std::fabs(a.x - center.x) + std::fabs(a.y - center.y) <
                std::fabs(b.x - center.x) + std::fabs(b.y - center.y);
     });
 
-    return covering_tiles;
+    result.z = z;
+    result.bounds = points;
+    result.valid = true;
+    return result.tiles;
 }
 
 /**
@@ -242,14 +623,14 @@ std::forward_list<Tile::ID> Source::coveringTiles(const TransformState& state) c
  *
  * @return boolean Whether the children found completely cover the tile.
  */
-bool Source::findLoadedChildren(const Tile::ID& id, int32_t maxCoveringZoom, std::forward_list<Tile::ID>& retain) {
+bool Source::findLoadedChildren(const Tile::ID& id, int32_t maxCoveringZoom, TileIDSet& retain) {
     bool complete = true;
     int32_t z = id.z;
     auto ids = id.children(z + 1);
     for (const Tile::ID& child_id : ids) {
         const TileData::State state = hasTile(child_id);
         if (state == TileData::State::parsed) {
-            retain.emplace_front(child_id);
+            retain.insert(child_id);
         } else {
             complete = false;
             if (z < maxCoveringZoom) {
@@ -270,31 +651,56 @@ bool Source::findLoadedChildren(const Tile::ID& id, int32_t maxCoveringZoom, std
  *
  * @return boolean Whether a parent was found.
  */
-bool Source::findLoadedParent(const Tile::ID& id, int32_t minCoveringZoom, std::forward_list<Tile::ID>& retain) {
+bool Source::findLoadedParent(const Tile::ID& id, int32_t minCoveringZoom, TileIDSet& retain) {
     for (int32_t z = id.z - 1; z >= minCoveringZoom; --z) {
         const Tile::ID parent_id = id.parent(z);
         const TileData::State state = hasTile(parent_id);
         if (state == TileData::State::parsed) {
-            retain.emplace_front(parent_id);
+            retain.insert(parent_id);
             return true;
         }
     }
     return false;
 }
 
+bool Source::isComplete() const {
+    if (!loaded || !updated || !geojsonQueue.empty() || geojsonIndexing || geojsonReplaced ||
+        !geojsonChanged.empty()) {
+        return false;
+    }
+
+    // Tiles that wait for their parents on a slow network aren't in /tiles/ yet.
+    for (const Tile::ID& id : covering.tiles) {
+        const auto it = tiles.find(id);
+        if (it == tiles.end() || !it->second->data || !it->second->data->isComplete()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void Source::update(Map& map, uv::worker& worker,
                     util::ptr<Style> style,
                     GlyphAtlas& glyphAtlas, GlyphStore& glyphStore,
                     SpriteAtlas& spriteAtlas, util::ptr<Sprite> sprite,
                     TexturePool& texturePool, FileSource& fileSource,
                     std::function<void ()> callback) {
+    // One index is built at a time; data that arrives in the meantime goes into the next one.
+    if (!geojsonQueue.empty() && !geojsonIndexing) {
+        indexGeoJSON(map, worker);
+    }
+
     if (!loaded || map.getTime() <= updated)
         return;
 
+    if (geojsonReplaced || !geojsonChanged.empty()) {
+        regenerateGeoJSONTiles(worker, callback);
+    }
+
     bool changed = false;
 
     int32_t zoom = std::floor(getZoom(map.getState()));
-    std::forward_list<Tile::ID> required = coveringTiles(map.getState());
+    const std::forward_list<Tile::ID>& required = coveringTiles(map.getState(), covering);
 
     // Determine the overzooming/underzooming amounts.
     int32_t minCoveringZoom = util::clamp<int32_t>(zoom - 10, info.min_zoom, info.max_zoom);
@@ -303,15 +709,51 @@ void Source::update(Map& map, uv::worker& worker,
     // Retain is a list of tiles that we shouldn't delete, even if they are not
     // the most ideal tile for the current viewport. This may include tiles like
     // parent or child tiles that are *already* loaded.
-    std::forward_list<Tile::ID> retain(required);
+    TileIDSet retain(required.begin(), required.end());
+
+    // On a slow network, the tiles one zoom level up are loaded first: each of them covers four
+    // tiles of the viewport at about the size of one. Until all of them are there, the tiles of
+    // the viewport that weren't requested yet wait, and their parents are drawn overzoomed.
+    const uint64_t bandwidth = fileSource.getBandwidth();
+    if (bandwidth) {
+        // Only switches back once the network is clearly faster, so that it doesn't flip.
+        lowBandwidth = bandwidth < (lowBandwidth ? 2 : 1) * util::lowBandwidth;
+    }
+    bool coarseFirst = false;
+    if (lowBandwidth && info.type != SourceType::GeoJSON) {
+        TileIDSet coarse;
+        for (const Tile::ID& id : required) {
+            if (id.z > info.min_zoom && tiles.find(id) == tiles.end()) {
+                coarse.insert(id.parent(id.z - 1));
+            }
+        }
+        for (const Tile::ID& id : coarse) {
+            const TileData::State state = addTile(map, worker, style,
+                                                  glyphAtlas, glyphStore,
+                                                  spriteAtlas, sprite,
+                                                  fileSource, texturePool,
+                                                  id, callback);
+            retain.insert(id);
+            if (state == TileData::State::initial) {
+                changed = true;
+            }
+            // Tiles that failed to load don't hold up the others.
+            if (state == TileData::State::initial || state == TileData::State::loading ||
+                state == TileData::State::loaded) {
+                coarseFirst = true;
+            }
+        }
+    }
 
     // Add existing child/parent tiles if the actual tile is not yet loaded
     for (const Tile::ID& id : required) {
-        const TileData::State state = addTile(map, worker, style,
-                                              glyphAtlas, glyphStore,
-                                              spriteAtlas, sprite,
-                                              fileSource, texturePool,
-                                              id, callback);
+        const TileData::State state = coarseFirst && tiles.find(id) == tiles.end()
+            ? TileData::State::invalid
+            : addTile(map, worker, style,
+                      glyphAtlas, glyphStore,
+                      spriteAtlas, sprite,
+                      fileSource, texturePool,
+                      id, callback);
 
         if (state != TileData::State::parsed) {
             // The tile we require is not yet loaded. Try to find a parent or
@@ -333,12 +775,19 @@ void Source::update(Map& map, uv::worker& worker,
         }
     }
 
+    // Start loading the tiles for where the map is heading at a low priority, so
+    // that they are parsed by the time the map gets there.
+    prefetchTiles(map, worker, style, glyphAtlas, glyphStore, spriteAtlas, sprite,
+                  fileSource, texturePool, required, callback);
+    updateSnapshotTiles(map, worker, style, glyphAtlas, glyphStore, spriteAtlas, sprite,
+                        fileSource, texturePool, callback);
+
     // Remove tiles that we definitely don't need, i.e. tiles that are not on
     // the required list.
-    std::set<Tile::ID> retain_data;
+    TileIDSet retain_data;
     util::erase_if(tiles, [&retain, &retain_data, &changed](std::pair<const Tile::ID, std::unique_ptr<Tile>> &pair) {
         Tile &tile = *pair.second;
-        bool obsolete = std::find(retain.begin(), retain.end(), tile.id) == retain.end();
+        bool obsolete = retain.find(tile.id) == retain.end();
         if (obsolete) {
             changed = true;
         } else {
@@ -347,8 +796,22 @@ void Source::update(Map& map, uv::worker& worker,
         return obsolete;
     });
 
-    // Remove all the expired pointers from the set.
-    util::erase_if(tile_data, [&retain_data](std::pair<const Tile::ID, std::weak_ptr<TileData>> &pair) {
+    for (const auto &pair : snapshotTiles) {
+        retain_data.insert(pair.second->data->id);
+    }
+
+    // Keep the tiles we're prefetching, but only the ones that aren't needed
+    // right now are scheduled after the visible ones.
+    TileIDSet prefetch_data;
+    for (const auto &pair : prefetched) {
+        if (retain_data.insert(pair.first).second) {
+            prefetch_data.insert(pair.first);
+        }
+    }
+
+    // Remove all the expired pointers from the set. Parsed tiles are moved to the
+    // cache in case we need them again; all others are canceled.
+    util::erase_if(tile_data, [this, &retain_data](std::pair<const Tile::ID, std::weak_ptr<TileData>> &pair) {
         const util::ptr<TileData> tile = pair.second.lock();
         if (!tile) {
             return true;
@@ -356,13 +819,55 @@ void Source::update(Map& map, uv::worker& worker,
 
         bool obsolete = retain_data.find(tile->id) == retain_data.end();
         if (obsolete) {
-            tile->cancel();
+            if (tile->state == TileData::State::parsed) {
+                cache.add(tile, tile->memoryUsage().total.total());
+            } else {
+                tile->cancel();
+            }
             return true;
         } else {
             return false;
         }
     });
 
+    // Queued parse jobs are picked up in order of their tile's priority, which
+    // favors tiles close to the center of the viewport and at the ideal zoom level.
+    // Since the queue consults the priority when dequeuing, this also moves jobs
+    // queued for a previous viewport to the back. Tiles that are still loading
+    // pass the priority on to the network request.
+    std::map<int8_t, vec2<double>> centers;
+    for (const auto &pair : tile_data) {
+        const util::ptr<TileData> tile = pair.second.lock();
+        if (tile) {
+            auto center_it = centers.find(tile->id.z);
+            if (center_it == centers.end()) {
+                center_it = centers.emplace(tile->id.z, map.getState().cornersToBox(tile->id.z).center).first;
+            }
+            const float priority = getPriority(tile->id, center_it->second, zoom);
+            const bool prefetch = prefetch_data.find(tile->id) != prefetch_data.end();
+            tile->setPriority(prefetch ? PrefetchRequestPriority + priority : priority);
+        }
+    }
+
+    // Tiles that were parsed with a different sprite, without some of their glyphs, or without
+    // their symbols at all, need their symbol buckets rebuilt. All other buckets are kept as they
+    // are. Tiles that lost their geometry with the GL context are rebuilt entirely, and layers
+    // whose layout changed rebuild only their own buckets.
+    if (info.type == SourceType::Vector || info.type == SourceType::GeoJSON) {
+        for (const auto &pair : tile_data) {
+            const util::ptr<TileData> tile = pair.second.lock();
+            if (!tile) {
+                continue;
+            }
+            VectorTileData &vectorTile = static_cast<VectorTileData &>(*tile);
+            if (vectorTile.checkContextLost() || vectorTile.setSprite(sprite) ||
+                vectorTile.checkGlyphs() || vectorTile.checkDeferredSymbols() ||
+                vectorTile.checkLayout()) {
+                tile->reparse(worker, callback);
+            }
+        }
+    }
+
     updated = map.getTime();
 }
 
@@ -3,17 +3,23 @@
 
 #include <mbgl/map/tile.hpp>
 #include <mbgl/map/tile_data.hpp>
+#include <mbgl/map/tile_cache.hpp>
+#include <mbgl/map/geojson_tile_index.hpp>
 #include <mbgl/style/style_source.hpp>
 
 #include <mbgl/util/noncopyable.hpp>
 #include <mbgl/util/time.hpp>
 #include <mbgl/util/mat4.hpp>
 #include <mbgl/util/ptr.hpp>
+#include <mbgl/util/vec.hpp>
+#include <mbgl/util/box.hpp>
 
 #include <cstdint>
 #include <forward_list>
 #include <iosfwd>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace mbgl {
 
@@ -24,17 +30,29 @@ class SpriteAtlas;
 class Sprite;
 class FileSource;
 class TexturePool;
+class CollisionIndex;
 class Style;
 class Painter;
 class StyleLayer;
 class TransformState;
-struct box;
-
+struct RenderedFeature;
 class Source : public std::enable_shared_from_this<Source>, private util::noncopyable {
 public:
     Source(SourceInfo&);
 
     void load(Map&, FileSource&);
+
+    // Replaces the data of a GeoJSON source, or updates its features as described by
+    // GeoJSONTileIndex::update(). The data is indexed on a worker thread with the next update;
+    // the tiles that changed are cut from the new index.
+    void setGeoJSON(const std::string &json, bool replace);
+
+    // Whether the TileJSON of the source arrived, or the source doesn't need one.
+    inline bool isLoaded() const { return loaded; }
+
+    // Whether all tiles that the last update required are complete, and no GeoJSON waits to be
+    // indexed or cut into tiles.
+    bool isComplete() const;
     void update(Map&, uv::worker&,
                 util::ptr<Style>,
                 GlyphAtlas&, GlyphStore&,
@@ -42,22 +60,60 @@ public:
                 TexturePool&, FileSource&,
                 std::function<void ()> callback);
 
-    void updateMatrices(const mat4 &projMatrix, const TransformState &transform);
+    // Matrices that are already in /matrices/ are reused; new ones are added to it.
+    void updateMatrices(const mat4 &projMatrix, const TransformState &transform,
+                        std::unordered_map<Tile::ID, mat4, Tile::ID::Hash> &matrices);
     void drawClippingMasks(Painter &painter);
     size_t getTileCount() const;
-    void render(Painter &painter, util::ptr<StyleLayer> layer_desc);
-    void render(Painter &painter, util::ptr<StyleLayer> layer_desc, const Tile::ID &id, const mat4 &matrix);
     void finishRender(Painter &painter);
 
     std::forward_list<Tile::ID> getIDs() const;
+    // Sorted by tile ID, which is the order in which tiles are clipped and rendered.
     std::forward_list<Tile *> getLoadedTiles() const;
-    void updateClipIDs(const std::map<Tile::ID, ClipID> &mapping);
+    // Tiles that are parsed, but can't be drawn before their geometry is uploaded, and tiles whose
+    // reparsed buckets wait for their upload.
+    std::forward_list<Tile *> getPendingUploads() const;
+    void updateClipIDs(const std::unordered_map<Tile::ID, ClipID, Tile::ID::Hash> &mapping);
+
+    // Appends the features that the layer draws within /radius/ pixels of a point of the view.
+    void queryFeatures(const TransformState &state, double x, double y, double radius,
+                       const StyleLayer &layer_desc, std::vector<RenderedFeature> &result) const;
+
+    // Sets the number of bytes that parsed tiles outside of the viewport may take up.
+    void setCacheSize(size_t bytes);
+    // Drops all tiles that aren't needed for the viewport, e.g. when the system is low on memory.
+    void clearCache();
+    // Frees the decoded layers that the tiles in use keep for reparsing.
+    void releaseMemory();
+
+    SourceMemoryUsage memoryUsage() const;
+
+    // Sets the zoom ranges of the visible style layers that use this source. Outside of them,
+    // nothing of the source is drawn, so no tiles are loaded.
+    void setZoomRanges(const std::vector<std::pair<float, float>> &ranges);
+
+    // Exchanges the tiles of the view for the ones loaded for Map::getSnapshotState(), so that
+    // the painter draws those; a second call swaps them back.
+    void swapSnapshotTiles();
+    // Like isComplete(), for the tiles of the snapshot.
+    bool isSnapshotComplete() const;
 
 private:
-    bool findLoadedChildren(const Tile::ID& id, int32_t maxCoveringZoom, std::forward_list<Tile::ID>& retain);
-    bool findLoadedParent(const Tile::ID& id, int32_t minCoveringZoom, std::forward_list<Tile::ID>& retain);
+    typedef std::unordered_set<Tile::ID, Tile::ID::Hash> TileIDSet;
+
+    // The tiles covering a viewport, sorted by their distance from its center. They are kept
+    // until the viewport changes, because most updates don't move the map.
+    struct Covering {
+        int32_t z = 0;
+        box bounds {};
+        bool valid = false;
+        std::forward_list<Tile::ID> tiles;
+    };
+
+    bool findLoadedChildren(const Tile::ID& id, int32_t maxCoveringZoom, TileIDSet& retain);
+    bool findLoadedParent(const Tile::ID& id, int32_t minCoveringZoom, TileIDSet& retain);
     int32_t coveringZoomLevel(const TransformState&) const;
-    std::forward_list<Tile::ID> coveringTiles(const TransformState&) const;
+    const std::forward_list<Tile::ID>& coveringTiles(const TransformState&, Covering&);
 
     TileData::State addTile(Map&, uv::worker&,
                             util::ptr<Style>,
@@ -67,18 +123,88 @@ private:
                             const Tile::ID&,
                             std::function<void ()> callback);
 
+    util::ptr<TileData> loadTileData(Map&, uv::worker&,
+                                     util::ptr<Style>,
+                                     GlyphAtlas&, GlyphStore&,
+                                     SpriteAtlas&, util::ptr<Sprite>,
+                                     FileSource&, TexturePool&,
+                                     const Tile::ID& normalized_id, float priority,
+                                     std::function<void ()> callback);
+
+    // Loads the tiles for Map::getPredictedState() that aren't required yet.
+    void prefetchTiles(Map&, uv::worker&,
+                       util::ptr<Style>,
+                       GlyphAtlas&, GlyphStore&,
+                       SpriteAtlas&, util::ptr<Sprite>,
+                       FileSource&, TexturePool&,
+                       const std::forward_list<Tile::ID>& required,
+                       std::function<void ()> callback);
+
+    // Loads the tiles for Map::getSnapshotState() into /snapshotTiles/.
+    void updateSnapshotTiles(Map&, uv::worker&,
+                             util::ptr<Style>,
+                             GlyphAtlas&, GlyphStore&,
+                             SpriteAtlas&, util::ptr<Sprite>,
+                             FileSource&, TexturePool&,
+                             std::function<void ()> callback);
+
     TileData::State hasTile(const Tile::ID& id);
 
+    void loadGeoJSON(Map&, FileSource&);
+    void indexGeoJSON(Map&, uv::worker&);
+    void generateTile(TileData&, uv::worker&, std::function<void ()> callback);
+    // Cuts the tiles again that the last index changed.
+    void regenerateGeoJSONTiles(uv::worker&, std::function<void ()> callback);
+
+    // Returns the data of a tile that is loading or loaded. Tiles that are cached are taken out of
+    // the cache again. Returns nullptr if the tile needs to be loaded.
+    util::ptr<TileData> getTileData(const Tile::ID& normalized_id);
+
     double getZoom(const TransformState &state) const;
+    bool isDrawnAt(double zoom) const;
+    static float getPriority(const Tile::ID& id, const vec2<double>& center, int32_t zoom);
 
     SourceInfo& info;
     bool loaded = false;
 
+    // Minimum and maximum zoom levels of the layers that draw this source.
+    std::vector<std::pair<float, float>> zoomRanges;
+
     // Stores the time when this source was most recently updated.
     timestamp updated = 0;
 
-    std::map<Tile::ID, std::unique_ptr<Tile>> tiles;
-    std::map<Tile::ID, std::weak_ptr<TileData>> tile_data;
+    std::unordered_map<Tile::ID, std::unique_ptr<Tile>, Tile::ID::Hash> tiles;
+    std::unordered_map<Tile::ID, std::weak_ptr<TileData>, Tile::ID::Hash> tile_data;
+
+    // Keeps the data of prefetched tiles alive; keyed by normalized ID.
+    std::unordered_map<Tile::ID, util::ptr<TileData>, Tile::ID::Hash> prefetched;
+
+    // The tiles of the next snapshot. Unlike /tiles/, parents and children don't stand in for
+    // missing tiles, since the snapshot is only drawn once all of them are there.
+    std::unordered_map<Tile::ID, std::unique_ptr<Tile>, Tile::ID::Hash> snapshotTiles;
+
+    // Whether the file source measured a slow network; see update().
+    bool lowBandwidth = false;
+
+    // Of the current and of the predicted viewport.
+    Covering covering;
+    Covering predictedCovering;
+    Covering snapshotCovering;
+
+    // Parsed tiles that were dropped from tile_data; keyed by normalized ID.
+    TileCache cache;
+
+    // GeoJSON data that waits to be indexed, and whether it replaces the data.
+    std::vector<std::pair<std::string, bool>> geojsonQueue;
+    bool geojsonIndexing = false;
+    util::ptr<const GeoJSONTileIndex> geojsonIndex;
+
+    // What the index changed since the tiles were last cut from it.
+    bool geojsonReplaced = false;
+    GeoJSONTileIndex::Bounds geojsonChanged;
+
+    // The labels placed by all vector tiles of this source.
+    const util::ptr<CollisionIndex> collisionIndex;
 };
 
 }
@@ -22,9 +22,10 @@ SpritePosition::SpritePosition(uint16_t x_, uint16_t y_, uint16_t width_, uint16
       sdf(sdf_) {
 }
 
-util::ptr<Sprite> Sprite::Create(const std::string& base_url, float pixelRatio, FileSource& fileSource) {
+util::ptr<Sprite> Sprite::Create(const std::string& base_url, float pixelRatio, FileSource& fileSource,
+                                 uv::worker& worker, std::function<void ()> callback) {
     util::ptr<Sprite> sprite(std::make_shared<Sprite>(Key(), base_url, pixelRatio));
-    sprite->load(fileSource);
+    sprite->load(fileSource, worker, callback);
     return sprite;
 }
 
@@ -51,7 +52,7 @@ Sprite::operator bool() const {
 // Note: This is a separate function that must be called exactly once after creation
 // The reason this isn't part of the constructor is that calling shared_from_this() in
 // the constructor fails.
-void Sprite::load(FileSource& fileSource) {
+void Sprite::load(FileSource& fileSource, uv::worker& worker, std::function<void ()> callback) {
     if (!valid) {
         // Treat a non-existent sprite as a successfully loaded empty sprite.
         loadedImage = true;
@@ -60,39 +61,86 @@ void Sprite::load(FileSource& fileSource) {
         return;
     }
 
-    util::ptr<Sprite> sprite = shared_from_this();
+    // The worker may be gone by the time a response arrives for a sprite that nobody uses anymore.
+    std::weak_ptr<Sprite> weak_sprite = shared_from_this();
 
-    fileSource.request(ResourceType::JSON, jsonURL)->onload([sprite](const Response &res) {
+    fileSource.request(ResourceType::JSON, jsonURL)->onload([weak_sprite, &worker, callback](const Response &res) {
+        util::ptr<Sprite> sprite = weak_sprite.lock();
+        if (!sprite) {
+            return;
+        }
         if (res.code == 200) {
             sprite->body = res.data;
-            sprite->parseJSON();
-            sprite->complete();
+            sprite->parse(worker, callback);
         } else {
             Log::Warning(Event::Sprite, "Failed to load sprite info: Error %d: %s", res.code, res.message.c_str());
-            if (!sprite->future.valid()) {
-                sprite->promise.set_exception(std::make_exception_ptr(std::runtime_error(res.message)));
-            }
+            sprite->fail(res.message);
         }
     });
 
-    fileSource.request(ResourceType::Image, spriteURL)->onload([sprite](const Response &res) {
+    fileSource.request(ResourceType::Image, spriteURL)->onload([weak_sprite, &worker, callback](const Response &res) {
+        util::ptr<Sprite> sprite = weak_sprite.lock();
+        if (!sprite) {
+            return;
+        }
         if (res.code == 200) {
             sprite->image = res.data;
-            sprite->parseImage();
-            sprite->complete();
+            sprite->parse(worker, callback);
         } else {
             Log::Warning(Event::Sprite, "Failed to load sprite image: Error %d: %s", res.code, res.message.c_str());
-            if (!sprite->future.valid()) {
-                sprite->promise.set_exception(std::make_exception_ptr(std::runtime_error(res.message)));
-            }
+            sprite->fail(res.message);
         }
     });
 }
 
-void Sprite::complete() {
-    if (loadedImage && loadedJSON) {
-        Log::Info(Event::Sprite, "loaded %s", spriteURL.c_str());
-        promise.set_value();
+struct Sprite::ParseJob {
+    ParseJob(std::shared_ptr<const std::string> body_, std::shared_ptr<const std::string> image_)
+        : body(std::move(body_)), image(std::move(image_)) {}
+
+    std::shared_ptr<const std::string> body;
+    std::shared_ptr<const std::string> image;
+    std::unordered_map<std::string, SpritePosition> pos;
+    std::unique_ptr<util::Image> raster;
+};
+
+void Sprite::parse(uv::worker& worker, std::function<void ()> callback) {
+    if (!body || !image || failed) {
+        return;
+    }
+
+    // Decoding the image of a @2x sprite takes long enough to hold up frames, so neither the
+    // JSON nor the image are parsed on the map thread. The result is published at once, so that
+    // the sprite atlas and the tiles never see half of it.
+    util::ptr<Sprite> sprite = shared_from_this();
+    new uv::work<ParseJob>(
+        worker,
+        [](ParseJob& job) {
+            parseJSON(job);
+            parseImage(job);
+        },
+        [sprite, callback](ParseJob& job) {
+            sprite->pos = std::move(job.pos);
+            sprite->raster = std::move(job.raster);
+            sprite->loadedJSON = true;
+            sprite->loadedImage = true;
+            Log::Info(Event::Sprite, "loaded %s", sprite->spriteURL.c_str());
+            sprite->promise.set_value();
+            if (callback) {
+                callback();
+            }
+        },
+        nullptr,
+        std::move(body), std::move(image));
+    body.reset();
+    image.reset();
+}
+
+void Sprite::fail(const std::string &message) {
+    body.reset();
+    image.reset();
+    // Unblocks parses that wait for the sprite; they find it without images.
+    if (!failed.exchange(true)) {
+        promise.set_exception(std::make_exception_ptr(std::runtime_error(message)));
     }
 }
 
@@ -100,19 +148,20 @@ bool Sprite::isLoaded() const {
     return loadedImage && loadedJSON;
 }
 
-void Sprite::parseImage() {
-    raster = util::make_unique<util::Image>(image);
-    if (!*raster) {
-        raster.reset();
+bool Sprite::isDone() const {
+    return isLoaded() || failed;
+}
+
+void Sprite::parseImage(ParseJob &job) {
+    job.raster = util::make_unique<util::Image>(*job.image);
+    if (!*job.raster) {
+        job.raster.reset();
     }
-    image.clear();
-    loadedImage = true;
 }
 
-void Sprite::parseJSON() {
+void Sprite::parseJSON(ParseJob &job) {
     rapidjson::Document d;
-    d.Parse<0>(body.c_str());
-    body.clear();
+    d.Parse<0>(job.body->c_str());
 
     if (d.HasParseError()) {
         Log::Warning(Event::Sprite, "sprite JSON is invalid");
@@ -135,14 +184,12 @@ void Sprite::parseJSON() {
                 if (value.HasMember("height")) height = value["height"].GetInt();
                 if (value.HasMember("pixelRatio")) spritePixelRatio = value["pixelRatio"].GetInt();
                 if (value.HasMember("sdf")) sdf = value["sdf"].GetBool();
-                pos.emplace(name, SpritePosition { x, y, width, height, spritePixelRatio, sdf });
+                job.pos.emplace(name, SpritePosition { x, y, width, height, spritePixelRatio, sdf });
             }
         }
     } else {
         Log::Warning(Event::Sprite, "sprite JSON root is not an object");
     }
-
-    loadedJSON = true;
 }
 
 const SpritePosition &Sprite::getSpritePosition(const std::string& name) const {
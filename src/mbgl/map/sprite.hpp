@@ -10,8 +10,13 @@
 #include <iosfwd>
 #include <string>
 #include <unordered_map>
+#include <functional>
 #include <future>
 
+namespace uv {
+class worker;
+}
+
 namespace mbgl {
 
 class FileSource;
@@ -34,16 +39,28 @@ public:
 class Sprite : public std::enable_shared_from_this<Sprite>, private util::noncopyable {
 private:
     struct Key {};
-    void load(FileSource& fileSource);
+    void load(FileSource& fileSource, uv::worker& worker, std::function<void ()> callback);
 
 public:
     Sprite(const Key &, const std::string& base_url, float pixelRatio);
-    static util::ptr<Sprite> Create(const std::string& base_url, float pixelRatio, FileSource& fileSource);
+    // The JSON and the image are parsed on the worker once both arrived; the result is published
+    // on the thread of the file source's loop, and /callback/ is called there afterwards. The
+    // requests only finish while someone holds on to the sprite.
+    static util::ptr<Sprite> Create(const std::string& base_url, float pixelRatio, FileSource& fileSource,
+                                    uv::worker& worker, std::function<void ()> callback = nullptr);
 
     const SpritePosition &getSpritePosition(const std::string& name) const;
 
+    // All images of the sprite, keyed by name. Only valid once the sprite is loaded.
+    inline const std::unordered_map<std::string, SpritePosition> &getSpritePositions() const {
+        return pos;
+    }
+
+    // Returns right away once isDone().
     void waitUntilLoaded() const;
     bool isLoaded() const;
+    // Whether both requests finished, successfully or not.
+    bool isDone() const;
 
     operator bool() const;
 
@@ -57,15 +74,20 @@ public:
     std::unique_ptr<util::Image> raster;
 
 private:
-    void parseJSON();
-    void parseImage();
-    void complete();
+    struct ParseJob;
+    static void parseJSON(ParseJob &job);
+    static void parseImage(ParseJob &job);
+    void parse(uv::worker& worker, std::function<void ()> callback);
+    void fail(const std::string &message);
 
 private:
-    std::string body;
-    std::string image;
+    // The responses, until both of them arrived.
+    std::shared_ptr<const std::string> body;
+    std::shared_ptr<const std::string> image;
     std::atomic<bool> loadedImage;
     std::atomic<bool> loadedJSON;
+    std::atomic<bool> failed { false };
+    // Written before the sprite counts as loaded, and never changed afterwards.
     std::unordered_map<std::string, SpritePosition> pos;
     const SpritePosition empty;
 
@@ -0,0 +1,66 @@
+#include <mbgl/map/tile_cache.hpp>
+#include <mbgl/map/tile_data.hpp>
+
+#include <cassert>
+
+using namespace mbgl;
+
+TileCache::TileCache(size_t maxBytes_) : maxBytes(maxBytes_) {
+}
+
+void TileCache::setMaxBytes(size_t maxBytes_) {
+    maxBytes = maxBytes_;
+    evict();
+}
+
+void TileCache::add(const util::ptr<TileData> &data, size_t bytes_) {
+    assert(data);
+    take(data->id);
+
+    entries.push_front({ data, bytes_ });
+    index.emplace(data->id, entries.begin());
+    bytes += bytes_;
+    evict();
+}
+
+util::ptr<TileData> TileCache::take(const Tile::ID &id) {
+    auto it = index.find(id);
+    if (it == index.end()) {
+        return nullptr;
+    }
+
+    const util::ptr<TileData> data = it->second->data;
+    bytes -= it->second->bytes;
+    entries.erase(it->second);
+    index.erase(it);
+    return data;
+}
+
+bool TileCache::has(const Tile::ID &id) const {
+    return index.find(id) != index.end();
+}
+
+std::forward_list<util::ptr<TileData>> TileCache::getTiles() const {
+    std::forward_list<util::ptr<TileData>> tiles;
+    auto it = tiles.before_begin();
+    for (const Entry &entry : entries) {
+        it = tiles.insert_after(it, entry.data);
+    }
+    return tiles;
+}
+
+void TileCache::clear() {
+    index.clear();
+    entries.clear();
+    bytes = 0;
+}
+
+void TileCache::evict() {
+    while (bytes > maxBytes) {
+        assert(!entries.empty());
+        const Entry &entry = entries.back();
+        bytes -= entry.bytes;
+        index.erase(entry.data->id);
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef MBGL_MAP_TILE_CACHE
+#define MBGL_MAP_TILE_CACHE
+
+#include <mbgl/map/tile.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/ptr.hpp>
+
+#include <cstddef>
+#include <forward_list>
+#include <list>
+#include <map>
+
+namespace mbgl {
+
+class TileData;
+
+// Keeps parsed tiles that are no longer needed for the current viewport, including their buckets
+// and GL buffers, so that they can be shown again right away when the map returns to them. Once
+// the tiles take up more than the budget, the least recently used ones are dropped.
+class TileCache : private util::noncopyable {
+public:
+    TileCache(size_t maxBytes = 0);
+
+    // Evicts tiles right away if they don't fit into the new budget.
+    void setMaxBytes(size_t maxBytes);
+    inline size_t getMaxBytes() const { return maxBytes; }
+
+    // Adds a tile with the given size. Replaces an existing tile with the same ID.
+    void add(const util::ptr<TileData> &data, size_t bytes);
+
+    // Removes the tile from the cache and returns it, or returns nullptr if it isn't cached.
+    util::ptr<TileData> take(const Tile::ID &id);
+
+    bool has(const Tile::ID &id) const;
+    void clear();
+
+    // Returns the cached tiles, most recently used first.
+    std::forward_list<util::ptr<TileData>> getTiles() const;
+
+    inline size_t getBytes() const { return bytes; }
+    inline size_t size() const { return index.size(); }
+
+private:
+    void evict();
+
+    struct Entry {
+        util::ptr<TileData> data;
+        size_t bytes;
+    };
+
+    size_t maxBytes;
+    size_t bytes = 0;
+
+    // Most recently used tiles first.
+    std::list<Entry> entries;
+    std::map<Tile::ID, std::list<Entry>::iterator> index;
+};
+
+}
+
+#endif
@@ -1,18 +1,53 @@
 #include <mbgl/map/tile_data.hpp>
 #include <mbgl/map/map.hpp>
+#include <mbgl/map/tile_trace.hpp>
 #include <mbgl/style/style_source.hpp>
 
-#include <mbgl/util/token.hpp>
-#include <mbgl/util/string.hpp>
 #include <mbgl/storage/file_source.hpp>
 #include <mbgl/util/uv_detail.hpp>
+#include <mbgl/util/time.hpp>
+#include <mbgl/platform/log.hpp>
+#include <mbgl/platform/trace.hpp>
+
+#include <cmath>
 
 using namespace mbgl;
 
+namespace {
+
+struct ParseJob {
+    ParseJob(util::ptr<TileData> tile_) : tile(tile_), queued(util::now()) {
+        Trace::BeginAsync("tile queue", cookie());
+    }
+
+    inline uint64_t cookie() const {
+        return uintptr_t(this);
+    }
+
+    util::ptr<TileData> tile;
+    const timestamp queued;
+    timestamp started = 0;
+    timestamp finished = 0;
+    AllocationTracker::Counts allocations;
+};
+
+
+struct GenerateJob {
+    GenerateJob(util::ptr<TileData> tile_, std::function<std::shared_ptr<const std::string> ()> generator_)
+        : tile(tile_), generator(generator_) {}
+
+    util::ptr<TileData> tile;
+    std::function<std::shared_ptr<const std::string> ()> generator;
+    std::shared_ptr<const std::string> data;
+};
+
+}
+
 TileData::TileData(Tile::ID const& id_, const SourceInfo& source_)
     : id(id_),
       name(id),
       state(State::initial),
+      priority(0),
       source(source_),
       debugBucket(debugFontBuffer) {
     // Initialize tile debug coordinates
@@ -27,31 +62,35 @@ const std::string TileData::toString() const {
     return std::string { "[tile " } + name + "]";
 }
 
+TileMemoryUsage TileData::memoryUsage() const {
+    TileMemoryUsage usage;
+    usage.data.cpu = data ? data->size() : 0;
+    usage.buckets["debug"] = debugBucket.memoryUsage();
+    usage.total = usage.data + usage.buckets["debug"];
+    usage.allocations = parseAllocations.toMap();
+    return usage;
+}
+
+size_t TileData::upload(size_t) {
+    // The debug text is tiny, so it is uploaded when it's drawn.
+    uploaded = true;
+    return 0;
+}
+
 void TileData::request(uv::worker& worker, FileSource& fileSource,
                        float pixelRatio, std::function<void ()> callback) {
-    if (source.tiles.empty())
+    const std::string url = source.tileURL(id, pixelRatio);
+    if (url.empty())
         return;
 
-    std::string url = source.tiles[(id.x + id.y) % source.tiles.size()];
-    url = util::replaceTokens(url, [&](const std::string &token) -> std::string {
-        if (token == "z") return util::toString(id.z);
-        if (token == "x") return util::toString(id.x);
-        if (token == "y") return util::toString(id.y);
-        if (token == "prefix") {
-            std::string prefix { 2 };
-            prefix[0] = "0123456789abcdef"[id.x % 16];
-            prefix[1] = "0123456789abcdef"[id.y % 16];
-            return prefix;
-        }
-        if (token == "ratio") return pixelRatio > 1.0 ? "@2x" : "";
-        return "";
-    });
-
     state = State::loading;
+    requested = util::now();
+    Trace::BeginAsync("tile request", cookie());
 
     // Note: Somehow this feels slower than the change to request_http()
     std::weak_ptr<TileData> weak_tile = shared_from_this();
     req = fileSource.request(ResourceType::Tile, url);
+    req->setPriority(priority);
     req->onload([weak_tile, url, callback, &worker](const Response &res) {
         util::ptr<TileData> tile = weak_tile.lock();
         if (!tile || tile->state == State::obsolete) {
@@ -60,26 +99,103 @@ void TileData::request(uv::worker& worker, FileSource& fileSource,
             return;
         }
 
-        // Clear the request object.
-        tile->req.reset();
+        // Clear the request object, unless we got an expired tile that is being revalidated and
+        // may still be replaced.
+        if (!res.stale) {
+            tile->req.reset();
+        }
+
+        // 204 stands for a tile without any data; it is parsed as an empty tile.
+        if (res.code == 200 || res.code == 204) {
+            if (tile->state == State::loading) {
+                tile->state = State::loaded;
+                Trace::EndAsync("tile request", tile->cookie());
 
-        if (res.code == 200) {
-            tile->state = State::loaded;
+                if (tile->trace) {
+                    const std::string &sourceID = tile->source.id;
+                    tile->trace->add(sourceID, TileTrace::Phase::Request, util::now() - tile->requested);
+                    if (res.cacheTime) {
+                        tile->trace->add(sourceID, TileTrace::Phase::Cache, res.cacheTime);
+                    }
+                    if (res.networkTime) {
+                        tile->trace->add(sourceID, TileTrace::Phase::Network, res.networkTime);
+                    }
+                }
 
-            tile->data = res.data;
+                tile->data = res.data;
 
-            // Schedule tile parsing in another thread
-            tile->reparse(worker, callback);
+                // Schedule tile parsing in another thread
+                tile->reparse(worker, callback);
+            } else if (tile->replaceData(res.data)) {
+                // The revalidation turned up a different tile.
+                tile->reparse(worker, callback);
+            }
         } else {
 #if defined(DEBUG)
-            fprintf(stderr, "[%s] tile loading failed: %ld, %s\n", url.c_str(), res.code, res.message.c_str());
+            Log::Warning(Event::HttpRequest, "[%s] tile loading failed: %ld, %s", url.c_str(), res.code, res.message.c_str());
 #endif
+            // Nothing will arrive for the tile anymore, unless it's a revalidation that failed.
+            if (tile->state == State::loading) {
+                tile->cancel();
+            }
         }
     });
+    if (receivesData()) {
+        req->onprogress([weak_tile, &worker](const std::string &bytes, size_t offset) {
+            util::ptr<TileData> tile = weak_tile.lock();
+            if (tile && tile->state == State::loading) {
+                tile->receiveData(worker, bytes, offset);
+            }
+        });
+    }
+}
+
+void TileData::generate(uv::worker& worker,
+                        std::function<std::shared_ptr<const std::string> ()> generator,
+                        std::function<void ()> callback) {
+    if (state == State::initial) {
+        state = State::loading;
+        requested = util::now();
+        Trace::BeginAsync("tile request", cookie());
+    }
+
+    const uint64_t serial = ++generated;
+    new uv::work<GenerateJob>(
+        worker,
+        [](GenerateJob& job) {
+            if (job.tile->state != State::obsolete) {
+                job.data = job.generator();
+            }
+        },
+        [serial, callback, &worker](GenerateJob& job) {
+            TileData &tile = *job.tile;
+            if (tile.state == State::obsolete || serial != tile.generated || !job.data) {
+                return;
+            }
+
+            if (tile.state == State::loading) {
+                tile.state = State::loaded;
+                Trace::EndAsync("tile request", tile.cookie());
+                if (tile.trace) {
+                    tile.trace->add(tile.source.id, TileTrace::Phase::Request, util::now() - tile.requested);
+                }
+                tile.data = job.data;
+                tile.reparse(worker, callback);
+            } else if (tile.replaceData(job.data)) {
+                tile.reparse(worker, callback);
+            }
+        },
+        [](GenerateJob& job) {
+            return job.tile->state == State::obsolete ? HUGE_VALF : job.tile->priority.load();
+        },
+        shared_from_this(), generator);
 }
 
 void TileData::cancel() {
     if (state != State::obsolete) {
+        if (state == State::loading) {
+            Trace::EndAsync("tile request", cookie());
+        }
         state = State::obsolete;
         if (req) {
             req->cancel();
@@ -88,17 +204,55 @@ void TileData::cancel() {
     }
 }
 
+void TileData::setPriority(float priority_) {
+    priority = priority_;
+    if (req) {
+        req->setPriority(priority_);
+    }
+}
+
+void TileData::setTrace(const util::ptr<TileTrace> &trace_) {
+    trace = trace_;
+}
+
+void TileData::uploadFinished() {
+    if (trace && parsed) {
+        trace->add(source.id, TileTrace::Phase::Upload, util::now() - parsed);
+    }
+}
+
 void TileData::reparse(uv::worker& worker, std::function<void()> callback)
 {
     // We're creating a new work request. The work request deletes itself after it executed
     // the after work handler
-    new uv::work<util::ptr<TileData>>(
+    new uv::work<ParseJob>(
         worker,
-        [](util::ptr<TileData>& tile) {
-            tile->parse();
+        [](ParseJob& job) {
+            job.started = util::now();
+            Trace::EndAsync("tile queue", job.cookie());
+            Trace::Scope scope("tile parse");
+            const AllocationTracker::Counts before = AllocationTracker::thread();
+            job.tile->parse();
+            job.allocations = AllocationTracker::thread() - before;
+            job.finished = util::now();
         },
-        [callback](util::ptr<TileData>&) {
+        [callback, &worker](ParseJob& job) {
+            TileData &tile = *job.tile;
+            tile.parsed = util::now();
+            tile.parseAllocations = job.allocations;
+            if (tile.trace && tile.state != State::obsolete) {
+                tile.trace->add(tile.source.id, TileTrace::Phase::Queue, job.started - job.queued);
+                tile.trace->add(tile.source.id, TileTrace::Phase::Parse, job.finished - job.started);
+            }
+            if (tile.afterParse()) {
+                tile.reparse(worker, callback);
+            }
             callback();
         },
+        [](ParseJob& job) {
+            // Obsolete tiles bail out of parsing immediately, so there's no
+            // point in letting them hold up the tiles we actually need.
+            return job.tile->state == State::obsolete ? HUGE_VALF : job.tile->priority.load();
+        },
         shared_from_this());
 }
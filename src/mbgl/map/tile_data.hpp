@@ -7,6 +7,9 @@
 
 #include <mbgl/util/noncopyable.hpp>
 #include <mbgl/util/ptr.hpp>
+#include <mbgl/util/allocation_tracker.hpp>
+#include <mbgl/util/memory_usage.hpp>
+#include <mbgl/util/time.hpp>
 
 #include <atomic>
 #include <exception>
@@ -26,6 +29,7 @@ class Painter;
 class SourceInfo;
 class StyleLayer;
 class Request;
+class TileTrace;
 
 class TileData : public std::enable_shared_from_this<TileData>,
              private util::noncopyable {
@@ -50,17 +54,70 @@ public:
     ~TileData();
 
     void request(uv::worker&, FileSource&, float pixelRatio, std::function<void ()> callback);
+    // Loads the data from /generator/ on a worker thread instead of the tile URL. Calling it
+    // again replaces the data of the tile; results of earlier calls that finish later are
+    // dropped.
+    void generate(uv::worker&, std::function<std::shared_ptr<const std::string> ()> generator,
+                  std::function<void ()> callback);
     void reparse(uv::worker&, std::function<void ()> callback);
     void cancel();
     const std::string toString() const;
 
+    // Updates the parse priority and reorders the pending network request, if any.
+    void setPriority(float priority);
+
+    // Records where the loading time of this tile goes, if set before request() is called.
+    void setTrace(const util::ptr<TileTrace> &trace);
+
+    // Must be called on the main thread once upload() finished for the first time.
+    void uploadFinished();
+
     inline bool ready() const {
         return state == State::parsed;
     }
 
+    // Whether the tile can be drawn: it is parsed, and its geometry made it to the GPU once.
+    inline bool renderable() const {
+        return state == State::parsed && uploaded;
+    }
+
+    // Number of bytes held by this tile: the raw data, and the geometry and images it was parsed
+    // into. Must be called on the main thread.
+    virtual TileMemoryUsage memoryUsage() const;
+
+    // Uploads at most /maxBytes/ (0 = all) of the parsed geometry and images, and marks the tile
+    // renderable once everything is on the GPU. Returns the number of bytes uploaded. Must be
+    // called on the main thread with a GL context.
+    virtual size_t upload(size_t maxBytes);
+
+    // Whether upload() has work left. Must be called on the main thread.
+    virtual bool needsUpload() const {
+        return ready() && !uploaded;
+    }
+
+    // Whether the tile won't change anymore until something else changes: it is parsed with
+    // everything it needs, or it failed to load or parse. Must be called on the main thread.
+    virtual bool isComplete() const {
+        return state == State::parsed || state == State::obsolete || state == State::invalid;
+    }
+
     // Override this in the child class.
     virtual void parse() = 0;
-    virtual void render(Painter &painter, util::ptr<StyleLayer> layer_desc, const mat4 &matrix) = 0;
+    // Runs on the main thread once parse() finished in a worker thread. Returns true if the tile
+    // needs to be parsed again, e.g. because its data was replaced in the meantime.
+    virtual bool afterParse() { return false; }
+    // Whether request() hands the tile data to receiveData() in parts while it downloads.
+    virtual bool receivesData() const { return false; }
+    // Runs on the main thread for every part of the data that arrives while the tile is loading,
+    // along with where the part starts in the data. A retry starts over at offset 0.
+    virtual void receiveData(uv::worker&, const std::string &, size_t) {}
+    // Swaps in new data for a tile that was loaded before. Returns true if the tile needs to be
+    // reparsed. Must be called on the main thread.
+    virtual bool replaceData(const std::shared_ptr<const std::string> &) { return false; }
+    // Frees whatever the tile keeps around only to speed up a reparse. Must be called on the main
+    // thread.
+    virtual void releaseMemory() {}
+    virtual void render(Painter &painter, const util::ptr<StyleLayer> &layer_desc, const mat4 &matrix) = 0;
     virtual bool hasData(StyleLayer const& layer_desc) const = 0;
 
 
@@ -69,12 +126,37 @@ public:
     const std::string name;
     std::atomic<State> state;
 
+    // Scheduling priority of this tile's parse jobs; lower values are parsed
+    // first. Updated by the source as the viewport moves.
+    std::atomic<float> priority;
+
+    // Set once upload() finished for the first time. Only used on the main thread.
+    bool uploaded = false;
+
+    // Changes whenever the buckets that render() draws are replaced. Only used on the main thread.
+    uint64_t generation = 0;
+
 public:
     const SourceInfo& source;
 
 protected:
     std::unique_ptr<Request> req;
-    std::string data;
+
+    util::ptr<TileTrace> trace;
+    // Tells apart the asynchronous trace intervals of tiles.
+    inline uint64_t cookie() const {
+        return uintptr_t(this);
+    }
+
+    // When request() was called and when the last parse finished. Only used on the main thread.
+    timestamp requested = 0;
+    timestamp parsed = 0;
+    // What the last parse allocated. Only used on the main thread.
+    AllocationTracker::Counts parseAllocations;
+    std::shared_ptr<const std::string> data;
+
+    // Counts the calls to generate(). Only used on the main thread.
+    uint64_t generated = 0;
 
     // Contains the tile ID string for painting debug information.
     DebugFontBuffer debugFontBuffer;
@@ -1,10 +1,14 @@
 #include <mbgl/map/tile_parser.hpp>
 #include <mbgl/map/vector_tile_data.hpp>
+#include <mbgl/map/shared_buckets.hpp>
+#include <mbgl/map/feature_index.hpp>
+#include <mbgl/map/sprite.hpp>
 #include <mbgl/style/style.hpp>
 #include <mbgl/style/style_layer.hpp>
 #include <mbgl/style/style_layer_group.hpp>
 #include <mbgl/renderer/fill_bucket.hpp>
 #include <mbgl/renderer/line_bucket.hpp>
+#include <mbgl/renderer/circle_bucket.hpp>
 #include <mbgl/renderer/symbol_bucket.hpp>
 #include <mbgl/renderer/raster_bucket.hpp>
 #include <mbgl/util/raster.hpp>
@@ -18,8 +22,15 @@
 
 #include <mbgl/util/std.hpp>
 #include <mbgl/util/utf.hpp>
+#include <mbgl/util/time.hpp>
+#include <mbgl/util/allocation_tracker.hpp>
+#include <mbgl/util/parallel.hpp>
+#include <mbgl/platform/log.hpp>
 
+#include <cmath>
 #include <locale>
+#include <map>
+#include <set>
 
 namespace mbgl {
 
@@ -28,14 +39,20 @@ namespace mbgl {
 // its header file.
 TileParser::~TileParser() = default;
 
-TileParser::TileParser(const std::string &data, VectorTileData &tile_,
+TileParser::Builder::Builder(bool retainBuffers)
+    : buffers(std::make_shared<TileBuffers>(retainBuffers)),
+      featureIndex(std::make_shared<FeatureIndex>()),
+      geometryClipper(-util::tileClipBuffer, 4096 + util::tileClipBuffer) {}
+
+TileParser::TileParser(VectorTile &vector_data_, VectorTileData &tile_,
                        const util::ptr<const Style> &style_,
                        GlyphAtlas & glyphAtlas_,
                        GlyphStore & glyphStore_,
                        SpriteAtlas & spriteAtlas_,
                        const util::ptr<Sprite> &sprite_,
-                       TexturePool& texturePool_)
-    : vector_data(pbf((const uint8_t *)data.data(), data.size())),
+                       TexturePool& texturePool_,
+                       uv::worker *pool_)
+    : vector_data(vector_data_),
       tile(tile_),
       style(style_),
       glyphAtlas(glyphAtlas_),
@@ -43,7 +60,13 @@ TileParser::TileParser(const std::string &data, VectorTileData &tile_,
       spriteAtlas(spriteAtlas_),
       sprite(sprite_),
       texturePool(texturePool_),
-      collision(util::make_unique<Collision>(tile.id.z, 4096, tile.source.tile_size, tile.depth)) {
+      pool(pool_),
+      mainBuilder(tile.retainBuffers),
+      idleBuilders({ &mainBuilder }),
+      collision(util::make_unique<Collision>(tile.id, tile.collisionIndex, 4096, tile.source.tile_size, tile.depth)),
+      glyphGeneration(glyphStore.getGeneration()),
+      // Symbols wait for the sprite instead of blocking a worker thread that the sprite may need.
+      deferSymbols(tile.state == TileData::State::loaded || !sprite_->isDone()) {
     assert(&tile != nullptr);
     assert(style);
     assert(sprite);
@@ -51,7 +74,17 @@ TileParser::TileParser(const std::string &data, VectorTileData &tile_,
 }
 
 void TileParser::parse() {
+    AllocationTracker::Scope allocations(AllocationTracker::Subsystem::TileParser);
+    tile.symbolsDeferred = false;
+    loadBucketCache();
     parseStyleLayers(style->layers);
+    placeSymbols();
+    storeBucketCache();
+
+    tile.parseTimes = mainBuilder.times;
+    for (const auto &builder : helperBuilders) {
+        tile.parseTimes += builder->times;
+    }
 }
 
 bool TileParser::obsolete() const { return tile.state == TileData::State::obsolete; }
@@ -61,65 +94,339 @@ void TileParser::parseStyleLayers(util::ptr<StyleLayerGroup> group) {
         return;
     }
 
+    // Collects the buckets that don't exist yet or weren't built from the same inputs. Fill and
+    // line buckets that read the same source layer are built together.
+    std::vector<util::ptr<StyleBucket>> bucket_descs;
+    std::map<std::string, std::vector<util::ptr<StyleBucket>>> shared;
+    std::set<std::string> names;
     for (const util::ptr<StyleLayer> &layer_desc : group->layers) {
+        if (layer_desc->isBackground()) {
+            // background is a special, fake bucket
+            continue;
+        }
+
+        if (!layer_desc->bucket) {
+            Log::Warning(Event::ParseTile, "layer '%s' does not have buckets", layer_desc->id.c_str());
+            continue;
+        }
+
+        const std::string &name = layer_desc->bucket->name;
+        if (tile.pendingBuckets.count(name) || !names.insert(name).second) {
+            continue;
+        }
+
+        auto bucket_it = tile.buckets.find(name);
+        if (bucket_it != tile.buckets.end() && bucket_it->second.fingerprint == createFingerprint(layer_desc->bucket)) {
+            continue;
+        }
+
+        if (deferSymbols && layer_desc->bucket->render.is<StyleBucketSymbol>() && isBucketVisible(*layer_desc->bucket)) {
+            tile.symbolsDeferred = true;
+            continue;
+        }
+
+        // Tiles with the same data have the same fill and line buckets.
+        if (!layer_desc->bucket->render.is<StyleBucketSymbol>() && isBucketVisible(*layer_desc->bucket)) {
+            const SharedBuckets::Entry shared_bucket = SharedBuckets::find(*tile.data, tile.dataHash, tile.id.z, tile.depth, layer_desc->bucket);
+            if (shared_bucket.bucket) {
+                util::ptr<const FeatureIndex> index = shared_bucket.featureIndex;
+                if (!index) {
+                    indexFeatures(*layer_desc->bucket);
+                    index = mainBuilder.featureIndex;
+                }
+                tile.pendingBuckets[name] = { createFingerprint(layer_desc->bucket), shared_bucket.buffers, shared_bucket.bucket, index };
+                continue;
+            }
+            if (loadCachedBucket(layer_desc->bucket)) {
+                continue;
+            }
+        }
+
+        bucket_descs.push_back(layer_desc->bucket);
+        if (isSharedBucket(*layer_desc->bucket)) {
+            shared[layer_desc->bucket->source_layer].push_back(layer_desc->bucket);
+        }
+    }
+
+    // Fill, line and circle buckets don't depend on each other, so idle threads of the pool help
+    // building them. Symbol buckets share the collision state, and are built on this thread.
+    std::vector<BuildJob> jobs;
+    for (const auto &source_layer : shared) {
+        if (source_layer.second.size() > 1) {
+            jobs.emplace_back();
+            jobs.back().bucket_descs = source_layer.second;
+        }
+    }
+    for (const util::ptr<StyleBucket> &bucket_desc : bucket_descs) {
+        if (!bucket_desc->render.is<StyleBucketSymbol>() &&
+            !(isSharedBucket(*bucket_desc) && shared[bucket_desc->source_layer].size() > 1)) {
+            jobs.emplace_back();
+            jobs.back().bucket_descs.push_back(bucket_desc);
+        }
+    }
+
+    std::vector<std::function<void ()>> tasks;
+    for (BuildJob &job : jobs) {
+        tasks.emplace_back([this, &job] { runBuildJob(job); });
+    }
+    util::runParallel(pool, tasks);
+
+    // Bucket creation might fail because the data tile may not contain any data that falls
+    // into this bucket. We still record the fingerprint so that we don't try again on
+    // reparse.
+    for (BuildJob &job : jobs) {
         // Cancel early when parsing.
         if (obsolete()) {
             return;
         }
 
-        if (layer_desc->isBackground()) {
-            // background is a special, fake bucket
+        for (size_t i = 0; i < job.buckets.size(); i++) {
+            const util::ptr<StyleBucket> &bucket_desc = job.bucket_descs[i];
+            tile.pendingBuckets[bucket_desc->name] = { createFingerprint(bucket_desc), job.builder->buffers, std::move(job.buckets[i]), job.builder->featureIndex };
+        }
+    }
+
+    for (const util::ptr<StyleBucket> &bucket_desc : bucket_descs) {
+        if (obsolete()) {
+            return;
+        }
+
+        if (bucket_desc->render.is<StyleBucketSymbol>()) {
+            std::unique_ptr<Bucket> bucket = createBucket(mainBuilder, bucket_desc);
+            tile.pendingBuckets[bucket_desc->name] = { createFingerprint(bucket_desc), mainBuilder.buffers, std::move(bucket), mainBuilder.featureIndex };
+            symbolBuckets.push_back(bucket_desc->name);
+        }
+    }
+}
+
+void TileParser::runBuildJob(BuildJob &job) {
+    if (obsolete()) {
+        return;
+    }
+
+    AllocationTracker::Scope allocations(AllocationTracker::Subsystem::TileParser);
+    Builder &builder = acquireBuilder();
+    job.builder = &builder;
+
+    const util::ptr<StyleBucket> &first = job.bucket_descs.front();
+    const std::shared_ptr<const VectorTileLayer> layer = job.bucket_descs.size() > 1 ? vector_data.getLayer(first->source_layer) : nullptr;
+    if (layer) {
+        job.buckets = createSharedBuckets(builder, *layer, job.bucket_descs);
+    } else {
+        for (const util::ptr<StyleBucket> &bucket_desc : job.bucket_descs) {
+            job.buckets.push_back(createBucket(builder, bucket_desc));
+        }
+    }
+
+    releaseBuilder(builder);
+}
+
+TileParser::Builder &TileParser::acquireBuilder() {
+    std::lock_guard<std::mutex> lock(buildersMutex);
+    if (idleBuilders.empty()) {
+        helperBuilders.push_back(util::make_unique<Builder>(tile.retainBuffers));
+        return *helperBuilders.back();
+    }
+
+    Builder &builder = *idleBuilders.back();
+    idleBuilders.pop_back();
+    return builder;
+}
+
+void TileParser::releaseBuilder(Builder &builder) {
+    std::lock_guard<std::mutex> lock(buildersMutex);
+    idleBuilders.push_back(&builder);
+}
+
+bool TileParser::ownsBuffers(const util::ptr<TileBuffers> &buffers) const {
+    if (buffers == mainBuilder.buffers) {
+        return true;
+    }
+    for (const auto &builder : helperBuilders) {
+        if (builder->buffers == buffers) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TileParser::placeSymbols() {
+    // All symbol buckets share the collision state of the tile, so they are placed together, in
+    // layer order, once the glyphs of all of them are available. Until then, the tile keeps the
+    // symbol buckets it had, and is parsed again when more glyphs arrived.
+    if (missingGlyphs) {
+        for (const std::string &name : symbolBuckets) {
+            tile.pendingBuckets.erase(name);
+        }
+        tile.glyphGeneration = glyphGeneration;
+        return;
+    }
+
+    tile.glyphGeneration = 0;
+    for (const std::string &name : symbolBuckets) {
+        if (obsolete()) {
+            return;
+        }
+
+        Bucket *bucket = tile.pendingBuckets[name].bucket.get();
+        if (bucket) {
+            const timestamp start = util::now();
+            static_cast<SymbolBucket *>(bucket)->addFeatures(tile.id, spriteAtlas, *sprite, glyphAtlas, glyphStore);
+            mainBuilder.times.symbol += util::now() - start;
+        }
+    }
+}
+
+void TileParser::loadBucketCache() {
+    if (!tile.bucketCache) {
+        return;
+    }
+
+    cacheKey.dataHash = BucketCache::hashData(*tile.data);
+    cacheKey.dataSize = uint32_t(tile.data->size());
+    cacheKey.z = tile.id.z;
+    cacheKey.depth = tile.depth;
+    cacheKey.tileSize = tile.source.tile_size;
+    cacheKey.triangleElementSize = uint32_t(mainBuilder.buffers->triangleElementsBuffer.itemSize);
+    cacheKey.lineElementSize = uint32_t(mainBuilder.buffers->lineElementsBuffer.itemSize);
+    cachedBuckets = tile.bucketCache->load(cacheKey);
+}
+
+bool TileParser::loadCachedBucket(const util::ptr<StyleBucket> &bucket_desc) {
+    CachedBucket cached;
+    if (!cachedBuckets || !cachedBuckets->find(BucketCache::hashLayout(*bucket_desc), cached)) {
+        return false;
+    }
+
+    const timestamp start = util::now();
+    const util::ptr<TileBuffers> &buffers = mainBuilder.buffers;
+    std::unique_ptr<Bucket> bucket;
+    if (bucket_desc->render.is<StyleBucketFill>()) {
+        std::unique_ptr<FillBucket> fill = util::make_unique<FillBucket>(buffers->fillVertexBuffer, buffers->fillColorBuffer, buffers->fillFringeBuffer, buffers->triangleElementsBuffer, buffers->lineElementsBuffer, bucket_desc->render.get<StyleBucketFill>(), mainBuilder.arena, tile.fillFringes);
+        if (!fill->load(cached)) {
+            return false;
+        }
+        bucket = std::move(fill);
+        mainBuilder.times.fill += util::now() - start;
+    } else if (bucket_desc->render.is<StyleBucketLine>()) {
+        std::unique_ptr<LineBucket> line = util::make_unique<LineBucket>(buffers->lineVertexBuffer, buffers->triangleElementsBuffer, bucket_desc->render.get<StyleBucketLine>());
+        if (!line->load(cached)) {
+            return false;
+        }
+        bucket = std::move(line);
+        mainBuilder.times.line += util::now() - start;
+    } else {
+        return false;
+    }
+
+    indexFeatures(*bucket_desc);
+    tile.pendingBuckets[bucket_desc->name] = { createFingerprint(bucket_desc), buffers, std::move(bucket), mainBuilder.featureIndex };
+    loadedBuckets++;
+    return true;
+}
+
+void TileParser::storeBucketCache() {
+    if (!tile.bucketCache || obsolete()) {
+        return;
+    }
+
+    // Buckets that were kept from an earlier parse, or taken over from another tile, live in
+    // buffers that may be uploaded already; the file still has the ones it had.
+    std::vector<std::pair<uint64_t, CachedBucket>> cached;
+    for (const auto &pending : tile.pendingBuckets) {
+        const VectorTileData::ParsedBucket &parsed = pending.second;
+        if (!parsed.bucket || !ownsBuffers(parsed.buffers)) {
             continue;
         }
 
-        if (layer_desc->bucket) {
-            // This is a singular layer. Check if this bucket already exists. If not,
-            // parse this bucket.
-            auto bucket_it = tile.buckets.find(layer_desc->bucket->name);
-            if (bucket_it == tile.buckets.end()) {
-                // We need to create this bucket since it doesn't exist yet.
-                std::unique_ptr<Bucket> bucket = createBucket(layer_desc->bucket);
-                if (bucket) {
-                    // Bucket creation might fail because the data tile may not
-                    // contain any data that falls into this bucket.
-                    tile.buckets[layer_desc->bucket->name] = std::move(bucket);
-                }
-            }
-        } else {
-            fprintf(stderr, "[WARNING] layer '%s' does not have buckets\n", layer_desc->id.c_str());
+        const StyleBucket &bucket_desc = *parsed.fingerprint.bucket_desc;
+        if (bucket_desc.render.is<StyleBucketFill>()) {
+            cached.emplace_back(BucketCache::hashLayout(bucket_desc), CachedBucket());
+            static_cast<const FillBucket &>(*parsed.bucket).save(cached.back().second);
+        } else if (bucket_desc.render.is<StyleBucketLine>()) {
+            cached.emplace_back(BucketCache::hashLayout(bucket_desc), CachedBucket());
+            static_cast<const LineBucket &>(*parsed.bucket).save(cached.back().second);
         }
     }
+
+    if (cached.size() > loadedBuckets) {
+        tile.bucketCache->store(cacheKey, cached, cachedBuckets.get());
+    }
 }
 
-std::unique_ptr<Bucket> TileParser::createBucket(util::ptr<StyleBucket> bucket_desc) {
+BucketFingerprint TileParser::createFingerprint(const util::ptr<StyleBucket> &bucket_desc) const {
+    BucketFingerprint fingerprint;
+    fingerprint.bucket_desc = bucket_desc;
+    fingerprint.data = tile.data;
+
+    // All symbol buckets share the tile's collision state, so they all depend on
+    // the sprite and get rebuilt together.
+    if (bucket_desc->render.is<StyleBucketSymbol>()) {
+        fingerprint.sprite = sprite;
+    }
+
+    return fingerprint;
+}
+
+bool TileParser::isBucketVisible(const StyleBucket &bucket_desc) const {
+    if (tile.id.z < std::floor(bucket_desc.min_zoom) && std::floor(bucket_desc.min_zoom) < tile.source.max_zoom) return false;
+    if (tile.id.z >= std::ceil(bucket_desc.max_zoom)) return false;
+    if (bucket_desc.visibility == mbgl::VisibilityType::None) return false;
+    return true;
+}
+
+bool TileParser::isSharedBucket(const StyleBucket &bucket_desc) const {
+    if (!isBucketVisible(bucket_desc)) {
+        return false;
+    }
+
+    // Fill buckets with feature colors look at the tags of each feature while they add its
+    // geometry, so they walk the layer on their own.
+    return (bucket_desc.render.is<StyleBucketFill>() && bucket_desc.render.get<StyleBucketFill>().color_property.empty()) ||
+           bucket_desc.render.is<StyleBucketLine>();
+}
+
+std::unique_ptr<Bucket> TileParser::createBucket(Builder &builder, util::ptr<StyleBucket> bucket_desc) {
     if (!bucket_desc) {
-        fprintf(stderr, "missing bucket desc\n");
+        Log::Warning(Event::ParseTile, "missing bucket desc");
         return nullptr;
     }
 
     // Skip this bucket if we are to not render this
-    if (tile.id.z < std::floor(bucket_desc->min_zoom) && std::floor(bucket_desc->min_zoom) < tile.source.max_zoom) return nullptr;
-    if (tile.id.z >= std::ceil(bucket_desc->max_zoom)) return nullptr;
-    if (bucket_desc->visibility == mbgl::VisibilityType::None) return nullptr;
+    if (!isBucketVisible(*bucket_desc)) return nullptr;
 
-    auto layer_it = vector_data.layers.find(bucket_desc->source_layer);
-    if (layer_it != vector_data.layers.end()) {
-        const VectorTileLayer &layer = layer_it->second;
+    const std::shared_ptr<const VectorTileLayer> layer_ptr = vector_data.getLayer(bucket_desc->source_layer);
+    if (layer_ptr) {
+        const VectorTileLayer &layer = *layer_ptr;
+        const timestamp start = util::now();
         if (bucket_desc->render.is<StyleBucketFill>()) {
-            return createFillBucket(layer, bucket_desc->filter, bucket_desc->render.get<StyleBucketFill>());
+            std::unique_ptr<Bucket> bucket = createFillBucket(builder, layer, bucket_desc->compiled_filter, bucket_desc->render.get<StyleBucketFill>(), builder.featureIndex->addBucket(bucket_desc->name));
+            builder.times.fill += util::now() - start;
+            return bucket;
         } else if (bucket_desc->render.is<StyleBucketLine>()) {
-            return createLineBucket(layer, bucket_desc->filter, bucket_desc->render.get<StyleBucketLine>());
+            std::unique_ptr<Bucket> bucket = createLineBucket(builder, layer, bucket_desc->compiled_filter, bucket_desc->render.get<StyleBucketLine>(), builder.featureIndex->addBucket(bucket_desc->name));
+            builder.times.line += util::now() - start;
+            return bucket;
+        } else if (bucket_desc->render.is<StyleBucketCircle>()) {
+            std::unique_ptr<Bucket> bucket = createCircleBucket(builder, layer, bucket_desc->compiled_filter, bucket_desc->render.get<StyleBucketCircle>(), builder.featureIndex->addBucket(bucket_desc->name));
+            builder.times.circle += util::now() - start;
+            return bucket;
         } else if (bucket_desc->render.is<StyleBucketSymbol>()) {
-            return createSymbolBucket(layer, bucket_desc->filter, bucket_desc->render.get<StyleBucketSymbol>());
+            std::unique_ptr<Bucket> bucket = createSymbolBucket(layer, bucket_desc->compiled_filter, bucket_desc->render.get<StyleBucketSymbol>());
+            if (bucket) {
+                indexFeatures(*bucket_desc);
+            }
+            builder.times.symbol += util::now() - start;
+            return bucket;
         } else if (bucket_desc->render.is<StyleBucketRaster>()) {
             return nullptr;
         } else {
-            fprintf(stderr, "[WARNING] unknown bucket render type for layer '%s' (source layer '%s')\n", bucket_desc->name.c_str(), bucket_desc->source_layer.c_str());
+            Log::Warning(Event::ParseTile, "unknown bucket render type for layer '%s' (source layer '%s')", bucket_desc->name.c_str(), bucket_desc->source_layer.c_str());
         }
     } else {
         // The layer specified in the bucket does not exist. Do nothing.
         if (debug::tileParseWarnings) {
-            fprintf(stderr, "[WARNING] layer '%s' does not exist in tile %d/%d/%d\n",
+            Log::Warning(Event::ParseTile, "layer '%s' does not exist in tile %d/%d/%d",
                     bucket_desc->source_layer.c_str(), tile.id.z, tile.id.x, tile.id.y);
         }
     }
@@ -127,27 +434,183 @@ std::unique_ptr<Bucket> TileParser::createBucket(util::ptr<StyleBucket> bucket_d
     return nullptr;
 }
 
+// Lets buckets that style features individually look at the properties of a feature before its
+// geometry is added. Returns false if the feature isn't drawn.
+template <class Bucket>
+static inline bool setFeature(Bucket &, const VectorTileTagExtractor &) {
+    return true;
+}
+
+static inline bool setFeature(FillBucket &bucket, const VectorTileTagExtractor &tags) {
+    return bucket.setFeature(tags);
+}
+
 template <class Bucket>
-void TileParser::addBucketGeometries(Bucket& bucket, const VectorTileLayer& layer, const FilterExpression &filter) {
+void TileParser::addBucketGeometries(Builder &builder, Bucket& bucket, const VectorTileLayer& layer, const FilterProgram &filter, bool polygons, uint16_t indexBucket) {
     FilteredVectorTileLayer filtered_layer(layer, filter);
-    for (pbf feature : filtered_layer) {
+    const FilteredVectorTileLayer::iterator end = filtered_layer.end();
+    for (FilteredVectorTileLayer::iterator it = filtered_layer.begin(); it != end; ++it) {
         if (obsolete())
             return;
 
+        if (!setFeature(*bucket, it.tags())) {
+            continue;
+        }
+
+        pbf feature = *it;
+
         while (feature.next(4)) { // geometry
             pbf geometry_pbf = feature.message();
             if (geometry_pbf) {
-                bucket->addGeometry(geometry_pbf);
+                const GeometryCollection &geometry = builder.geometryDecoder.decode(geometry_pbf);
+                builder.featureIndex->insert(geometry, it.index(), indexBucket);
+                bucket->addGeometry(polygons ? builder.geometryClipper.clipPolygons(geometry)
+                                             : builder.geometryClipper.clipLines(geometry));
             } else if (debug::tileParseWarnings) {
-                fprintf(stderr, "[WARNING] geometry is empty\n");
+                Log::Warning(Event::ParseTile, "geometry is empty");
+            }
+        }
+    }
+}
+
+void TileParser::indexFeatures(const StyleBucket &bucket_desc) {
+    const std::shared_ptr<const VectorTileLayer> layer = vector_data.getLayer(bucket_desc.source_layer);
+    if (!layer) {
+        return;
+    }
+
+    FeatureIndex &featureIndex = *mainBuilder.featureIndex;
+    const uint16_t indexBucket = featureIndex.addBucket(bucket_desc.name);
+    FilteredVectorTileLayer filtered_layer(*layer, bucket_desc.compiled_filter);
+    const FilteredVectorTileLayer::iterator end = filtered_layer.end();
+    for (FilteredVectorTileLayer::iterator it = filtered_layer.begin(); it != end; ++it) {
+        if (obsolete()) {
+            return;
+        }
+
+        pbf feature = *it;
+        while (feature.next(4)) { // geometry
+            pbf geometry_pbf = feature.message();
+            if (geometry_pbf) {
+                featureIndex.insert(mainBuilder.geometryDecoder.decode(geometry_pbf), it.index(), indexBucket);
             }
         }
     }
 }
 
-std::unique_ptr<Bucket> TileParser::createFillBucket(const VectorTileLayer& layer, const FilterExpression &filter, const StyleBucketFill &fill) {
-    std::unique_ptr<FillBucket> bucket = util::make_unique<FillBucket>(tile.fillVertexBuffer, tile.triangleElementsBuffer, tile.lineElementsBuffer, fill);
-    addBucketGeometries(bucket, layer, filter);
+std::vector<std::unique_ptr<Bucket>> TileParser::createSharedBuckets(Builder &builder, const VectorTileLayer &layer,
+                                                                     const std::vector<util::ptr<StyleBucket>> &bucket_descs) {
+    std::vector<std::unique_ptr<Bucket>> buckets(bucket_descs.size());
+    timestamp start = util::now();
+
+    // The clipped geometries of the features, with the indices of the geometries that go into
+    // each bucket. Buckets write their vertices into the shared buffers in one contiguous run, so
+    // they can only take their geometries once the pass over the features is done.
+    struct SharedGeometry {
+        GeometryCollection polygons;
+        GeometryCollection lines;
+    };
+    std::vector<SharedGeometry> geometries;
+    std::vector<std::vector<uint32_t>> bucketGeometries(bucket_descs.size());
+    std::vector<size_t> matches;
+    std::vector<uint16_t> indexBuckets;
+    for (const util::ptr<StyleBucket> &bucket_desc : bucket_descs) {
+        indexBuckets.push_back(builder.featureIndex->addBucket(bucket_desc->name));
+    }
+
+    FilteredVectorTileLayer features(layer, FilterProgram());
+    const FilteredVectorTileLayer::iterator end = features.end();
+    for (FilteredVectorTileLayer::iterator it = features.begin(); it != end; ++it) {
+        if (obsolete()) {
+            return {};
+        }
+
+        matches.clear();
+        bool polygons = false;
+        bool lines = false;
+        for (size_t i = 0; i < bucket_descs.size(); i++) {
+            if (bucket_descs[i]->compiled_filter.evaluate(it.tags())) {
+                matches.push_back(i);
+                if (bucket_descs[i]->render.is<StyleBucketFill>()) {
+                    polygons = true;
+                } else {
+                    lines = true;
+                }
+            }
+        }
+        if (matches.empty()) {
+            continue;
+        }
+
+        pbf feature = *it;
+        while (feature.next(4)) { // geometry
+            pbf geometry_pbf = feature.message();
+            if (!geometry_pbf) {
+                if (debug::tileParseWarnings) {
+                    Log::Warning(Event::ParseTile, "geometry is empty");
+                }
+                continue;
+            }
+
+            const GeometryCollection &geometry = builder.geometryDecoder.decode(geometry_pbf);
+            geometries.emplace_back();
+            if (polygons) {
+                geometries.back().polygons = builder.geometryClipper.clipPolygons(geometry);
+            }
+            if (lines) {
+                geometries.back().lines = builder.geometryClipper.clipLines(geometry);
+            }
+            for (size_t i : matches) {
+                bucketGeometries[i].push_back(uint32_t(geometries.size() - 1));
+                builder.featureIndex->insert(geometry, it.index(), indexBuckets[i]);
+            }
+        }
+    }
+
+    // The pass over the features counts towards the bucket type that comes first.
+    const timestamp pass = util::now() - start;
+    if (bucket_descs.front()->render.is<StyleBucketFill>()) {
+        builder.times.fill += pass;
+    } else {
+        builder.times.line += pass;
+    }
+
+    // Detail below half a pixel is invisible, even at the largest scale the tile is drawn at.
+    const double tolerance = 0.5 * 4096 / tile.source.tile_size / std::pow(2, tile.depth);
+
+    TileBuffers &buffers = *builder.buffers;
+    for (size_t i = 0; i < bucket_descs.size(); i++) {
+        if (obsolete()) {
+            return {};
+        }
+
+        start = util::now();
+        if (bucket_descs[i]->render.is<StyleBucketFill>()) {
+            std::unique_ptr<FillBucket> bucket = util::make_unique<FillBucket>(buffers.fillVertexBuffer, buffers.fillColorBuffer, buffers.fillFringeBuffer, buffers.triangleElementsBuffer, buffers.lineElementsBuffer, bucket_descs[i]->render.get<StyleBucketFill>(), builder.arena, tile.fillFringes);
+            for (uint32_t index : bucketGeometries[i]) {
+                bucket->addGeometry(geometries[index].polygons);
+            }
+            bucket->flush();
+            buckets[i] = std::move(bucket);
+            builder.times.fill += util::now() - start;
+        } else {
+            std::unique_ptr<LineBucket> bucket = util::make_unique<LineBucket>(buffers.lineVertexBuffer, buffers.triangleElementsBuffer, bucket_descs[i]->render.get<StyleBucketLine>(), tolerance);
+            for (uint32_t index : bucketGeometries[i]) {
+                bucket->addGeometry(geometries[index].lines);
+            }
+            buckets[i] = std::move(bucket);
+            builder.times.line += util::now() - start;
+        }
+    }
+
+    return buckets;
+}
+
+std::unique_ptr<Bucket> TileParser::createFillBucket(Builder &builder, const VectorTileLayer& layer, const FilterProgram &filter, const StyleBucketFill &fill, uint16_t indexBucket) {
+    TileBuffers &buffers = *builder.buffers;
+    std::unique_ptr<FillBucket> bucket = util::make_unique<FillBucket>(buffers.fillVertexBuffer, buffers.fillColorBuffer, buffers.fillFringeBuffer, buffers.triangleElementsBuffer, buffers.lineElementsBuffer, fill, builder.arena, tile.fillFringes);
+    addBucketGeometries(builder, bucket, layer, filter, true, indexBucket);
+    bucket->flush();
     return obsolete() ? nullptr : std::move(bucket);
 }
 
@@ -156,15 +619,49 @@ std::unique_ptr<Bucket> TileParser::createRasterBucket(const StyleBucketRaster &
     return obsolete() ? nullptr : std::move(bucket);
 }
 
-std::unique_ptr<Bucket> TileParser::createLineBucket(const VectorTileLayer& layer, const FilterExpression &filter, const StyleBucketLine &line) {
-    std::unique_ptr<LineBucket> bucket = util::make_unique<LineBucket>(tile.lineVertexBuffer, tile.triangleElementsBuffer, tile.pointElementsBuffer, line);
-    addBucketGeometries(bucket, layer, filter);
+std::unique_ptr<Bucket> TileParser::createLineBucket(Builder &builder, const VectorTileLayer& layer, const FilterProgram &filter, const StyleBucketLine &line, uint16_t indexBucket) {
+    // Detail below half a pixel is invisible, even at the largest scale the tile is drawn at.
+    const double tolerance = 0.5 * 4096 / tile.source.tile_size / std::pow(2, tile.depth);
+    TileBuffers &buffers = *builder.buffers;
+    std::unique_ptr<LineBucket> bucket = util::make_unique<LineBucket>(buffers.lineVertexBuffer, buffers.triangleElementsBuffer, line, tolerance);
+    addBucketGeometries(builder, bucket, layer, filter, false, indexBucket);
+    return obsolete() ? nullptr : std::move(bucket);
+}
+
+std::unique_ptr<Bucket> TileParser::createCircleBucket(Builder &builder, const VectorTileLayer& layer, const FilterProgram &filter, const StyleBucketCircle &circle, uint16_t indexBucket) {
+    TileBuffers &buffers = *builder.buffers;
+    std::unique_ptr<CircleBucket> bucket = util::make_unique<CircleBucket>(buffers.circleVertexBuffer, buffers.triangleElementsBuffer, circle, buffers.instanced);
+
+    // The points aren't clipped; the bucket drops the ones that are far outside of the tile.
+    FilteredVectorTileLayer filtered_layer(layer, filter);
+    const FilteredVectorTileLayer::iterator end = filtered_layer.end();
+    for (FilteredVectorTileLayer::iterator it = filtered_layer.begin(); it != end; ++it) {
+        if (obsolete()) {
+            return nullptr;
+        }
+
+        pbf feature = *it;
+        while (feature.next(4)) { // geometry
+            pbf geometry_pbf = feature.message();
+            if (geometry_pbf) {
+                const GeometryCollection &geometry = builder.geometryDecoder.decode(geometry_pbf);
+                builder.featureIndex->insert(geometry, it.index(), indexBucket);
+                bucket->addGeometry(geometry);
+            } else if (debug::tileParseWarnings) {
+                Log::Warning(Event::ParseTile, "geometry is empty");
+            }
+        }
+    }
+
+    bucket->flush();
     return obsolete() ? nullptr : std::move(bucket);
 }
 
-std::unique_ptr<Bucket> TileParser::createSymbolBucket(const VectorTileLayer& layer, const FilterExpression &filter, const StyleBucketSymbol &symbol) {
-    std::unique_ptr<SymbolBucket> bucket = util::make_unique<SymbolBucket>(symbol, *collision);
-    bucket->addFeatures(layer, filter, tile.id, spriteAtlas, *sprite, glyphAtlas, glyphStore);
+std::unique_ptr<Bucket> TileParser::createSymbolBucket(const VectorTileLayer& layer, const FilterProgram &filter, const StyleBucketSymbol &symbol) {
+    std::unique_ptr<SymbolBucket> bucket = util::make_unique<SymbolBucket>(symbol, *collision, *mainBuilder.buffers);
+    if (!bucket->prepareFeatures(layer, filter, glyphStore)) {
+        missingGlyphs = true;
+    }
     return obsolete() ? nullptr : std::move(bucket);
 }
 
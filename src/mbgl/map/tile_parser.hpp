@@ -2,13 +2,24 @@
 #define MBGL_MAP_TILE_PARSER
 
 #include <mbgl/map/vector_tile.hpp>
-#include <mbgl/style/filter_expression.hpp>
+#include <mbgl/map/vector_tile_data.hpp>
+#include <mbgl/geometry/geometry.hpp>
+#include <mbgl/geometry/clip.hpp>
+#include <mbgl/renderer/bucket_cache.hpp>
+#include <mbgl/style/filter_program.hpp>
 #include <mbgl/text/glyph.hpp>
+#include <mbgl/util/arena.hpp>
 #include <mbgl/util/ptr.hpp>
 #include <mbgl/util/noncopyable.hpp>
 #include <cstdint>
 #include <iosfwd>
+#include <mutex>
 #include <string>
+#include <vector>
+
+namespace uv {
+class worker;
+}
 
 namespace mbgl {
 
@@ -24,41 +35,100 @@ class StyleBucket;
 class StyleBucketFill;
 class StyleBucketRaster;
 class StyleBucketLine;
+class StyleBucketCircle;
 class StyleBucketSymbol;
 class StyleLayerGroup;
-class VectorTileData;
 class Collision;
+class FeatureIndex;
 class TexturePool;
 
 class TileParser : private util::noncopyable
 {
 public:
-    TileParser(const std::string &data, VectorTileData &tile,
+    TileParser(VectorTile &vector_data, VectorTileData &tile,
                const util::ptr<const Style> &style,
                GlyphAtlas & glyphAtlas,
                GlyphStore & glyphStore,
                SpriteAtlas & spriteAtlas,
                const util::ptr<Sprite> &sprite,
-               TexturePool& texturePool);
+               TexturePool& texturePool,
+               uv::worker *pool = nullptr);
     ~TileParser();
 
 public:
     void parse();
 
 private:
+    // What building fill, line and circle buckets writes to. Buckets that are built at the same
+    // time on different threads use different builders, so that they don't share any buffers;
+    // every bucket draws from the buffers of the builder that built it.
+    struct Builder : private util::noncopyable {
+        explicit Builder(bool retainBuffers);
+
+        util::ptr<TileBuffers> buffers;
+        util::ptr<FeatureIndex> featureIndex;
+        GeometryDecoder geometryDecoder;
+        GeometryClipper geometryClipper;
+
+        // Parse-time scratch memory; released in one go when the parser goes away.
+        util::Arena arena;
+
+        BucketParseTimes times;
+    };
+
+    // Fill, line and circle buckets that are built in one go: either a single bucket, or those
+    // that share a pass over their source layer.
+    struct BuildJob {
+        std::vector<util::ptr<StyleBucket>> bucket_descs;
+        std::vector<std::unique_ptr<Bucket>> buckets;
+        Builder *builder = nullptr;
+    };
+
+    void runBuildJob(BuildJob &job);
+
+    // Hands out a builder that no other thread uses at the moment, creating one if there is none.
+    Builder &acquireBuilder();
+    void releaseBuilder(Builder &builder);
+
+    // Whether the buffers were created by this parser.
+    bool ownsBuffers(const util::ptr<TileBuffers> &buffers) const;
+
     bool obsolete() const;
     void parseStyleLayers(util::ptr<StyleLayerGroup> group);
-    std::unique_ptr<Bucket> createBucket(util::ptr<StyleBucket> bucket_desc);
+    void placeSymbols();
+    BucketFingerprint createFingerprint(const util::ptr<StyleBucket> &bucket_desc) const;
+    bool isBucketVisible(const StyleBucket &bucket_desc) const;
 
-    std::unique_ptr<Bucket> createFillBucket(const VectorTileLayer& layer, const FilterExpression &filter, const StyleBucketFill &fill);
+    // Reads the cached buckets of the tile, and writes the ones this parse built.
+    void loadBucketCache();
+    void storeBucketCache();
+    bool loadCachedBucket(const util::ptr<StyleBucket> &bucket_desc);
+    std::unique_ptr<Bucket> createBucket(Builder &builder, util::ptr<StyleBucket> bucket_desc);
+
+    // Whether the bucket can be built together with the other buckets of its source layer.
+    bool isSharedBucket(const StyleBucket &bucket_desc) const;
+
+    // Builds fill and line buckets of one source layer with a single pass over its features: the
+    // tags of a feature are read, and its geometry decoded and clipped, once for all of them.
+    std::vector<std::unique_ptr<Bucket>> createSharedBuckets(Builder &builder, const VectorTileLayer &layer,
+                                                             const std::vector<util::ptr<StyleBucket>> &bucket_descs);
+
+    // /indexBucket/ is the number of the bucket in the feature index.
+    std::unique_ptr<Bucket> createFillBucket(Builder &builder, const VectorTileLayer& layer, const FilterProgram &filter, const StyleBucketFill &fill, uint16_t indexBucket);
     std::unique_ptr<Bucket> createRasterBucket(const StyleBucketRaster &raster);
-    std::unique_ptr<Bucket> createLineBucket(const VectorTileLayer& layer, const FilterExpression &filter, const StyleBucketLine &line);
-    std::unique_ptr<Bucket> createSymbolBucket(const VectorTileLayer& layer, const FilterExpression &filter, const StyleBucketSymbol &symbol);
+    std::unique_ptr<Bucket> createLineBucket(Builder &builder, const VectorTileLayer& layer, const FilterProgram &filter, const StyleBucketLine &line, uint16_t indexBucket);
+    std::unique_ptr<Bucket> createCircleBucket(Builder &builder, const VectorTileLayer& layer, const FilterProgram &filter, const StyleBucketCircle &circle, uint16_t indexBucket);
+    std::unique_ptr<Bucket> createSymbolBucket(const VectorTileLayer& layer, const FilterProgram &filter, const StyleBucketSymbol &symbol);
 
-    template <class Bucket> void addBucketGeometries(Bucket& bucket, const VectorTileLayer& layer, const FilterExpression &filter);
+    // Polygons keep their rings closed when they are clipped to the tile; lines are split.
+    template <class Bucket> void addBucketGeometries(Builder &builder, Bucket& bucket, const VectorTileLayer& layer, const FilterProgram &filter, bool polygons, uint16_t indexBucket);
+
+    // Adds the features of a bucket that wasn't built from them to the feature index, e.g. one
+    // taken over from another tile or loaded from the bucket cache.
+    void indexFeatures(const StyleBucket &bucket_desc);
 
 private:
-    const VectorTile vector_data;
+    VectorTile& vector_data;
     VectorTileData& tile;
 
     // Cross-thread shared data.
@@ -69,7 +139,34 @@ private:
     util::ptr<Sprite> sprite;
     TexturePool& texturePool;
 
+    // Lets fill, line and circle buckets be built on idle threads of the pool; may be null.
+    uv::worker *const pool;
+
+    // The builder of the parsing thread. Symbol buckets, and buckets that weren't built from the
+    // features, go into it, too.
+    Builder mainBuilder;
+
+    // Builders for the buckets that are built at the same time as others.
+    std::mutex buildersMutex;
+    std::vector<std::unique_ptr<Builder>> helperBuilders;
+    std::vector<Builder *> idleBuilders;
+
     std::unique_ptr<Collision> collision;
+
+    // Symbol buckets are created when their layer is parsed, but placed at the end of the parse,
+    // and only if none of them misses glyphs.
+    const uint64_t glyphGeneration;
+    std::vector<std::string> symbolBuckets;
+    bool missingGlyphs = false;
+
+    // Fill and line buckets of an earlier run, and how many of them this parse used.
+    BucketCache::TileKey cacheKey;
+    std::unique_ptr<BucketCache::File> cachedBuckets;
+    size_t loadedBuckets = 0;
+
+    // The initial parse leaves out the symbol buckets, so that the tile can be drawn as soon as its
+    // other buckets are built. The symbols follow with a reparse.
+    const bool deferSymbols;
 };
 
 }
@@ -0,0 +1,37 @@
+#include <mbgl/map/tile_trace.hpp>
+
+using namespace mbgl;
+
+const char *TileTrace::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::Request: return "request";
+        case Phase::Cache: return "cache";
+        case Phase::Network: return "network";
+        case Phase::Queue: return "queue";
+        case Phase::Parse: return "parse";
+        case Phase::Upload: return "upload";
+    }
+    return "unknown";
+}
+
+void TileTrace::add(const std::string &source, Phase phase, timestamp duration) {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::unique_ptr<LatencyHistogram> &histogram = sources[source][size_t(phase)];
+    if (!histogram) {
+        histogram = util::make_unique<LatencyHistogram>();
+    }
+    histogram->add(duration);
+}
+
+TileLatencies TileTrace::latencies() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    TileLatencies result;
+    for (const auto &source : sources) {
+        for (size_t i = 0; i < phaseCount; i++) {
+            if (source.second[i]) {
+                result[source.first][phaseName(Phase(i))] = source.second[i]->snapshot();
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,38 @@
+#ifndef MBGL_MAP_TILE_TRACE
+#define MBGL_MAP_TILE_TRACE
+
+#include <mbgl/util/latency_histogram.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace mbgl {
+
+// Collects how long the tiles of each source spend in the phases of loading, to tell whether slow
+// tiles wait for the network, for a worker thread, or for parsing. May be used from any thread.
+class TileTrace : private util::noncopyable {
+public:
+    enum class Phase : uint8_t { Request, Cache, Network, Queue, Parse, Upload };
+    static const size_t phaseCount = size_t(Phase::Upload) + 1;
+    static const char *phaseName(Phase);
+
+    void add(const std::string &source, Phase phase, timestamp duration);
+
+    // Phases without any durations are left out.
+    TileLatencies latencies() const;
+
+private:
+    typedef std::array<std::unique_ptr<LatencyHistogram>, phaseCount> Histograms;
+
+    mutable std::mutex mtx;
+    std::map<std::string, Histograms> sources;
+};
+
+}
+
+#endif
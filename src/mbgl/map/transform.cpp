@@ -15,6 +15,19 @@ using namespace mbgl;
 const double D2R = M_PI / 180.0;
 const double M2PI = 2 * M_PI;
 
+class Transform::Change : private util::noncopyable {
+public:
+    inline Change(Transform &transform_) : transform(transform_), lock(transform_.mtx) {}
+    inline ~Change() {
+        transform.publishedCurrent.store(transform.current);
+        transform.publishedFinal.store(transform.final);
+    }
+
+private:
+    Transform &transform;
+    std::lock_guard<std::recursive_mutex> lock;
+};
+
 Transform::Transform(View &view_)
     : view(view_)
 {
@@ -24,7 +37,7 @@ Transform::Transform(View &view_)
 
 bool Transform::resize(const uint16_t w, const uint16_t h, const float ratio,
                        const uint16_t fb_w, const uint16_t fb_h) {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     if (final.width != w || final.height != h || final.pixelRatio != ratio ||
         final.framebuffer[0] != fb_w || final.framebuffer[1] != fb_h) {
@@ -49,7 +62,7 @@ bool Transform::resize(const uint16_t w, const uint16_t h, const float ratio,
 #pragma mark - Position
 
 void Transform::moveBy(const double dx, const double dy, const timestamp duration) {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     _moveBy(dx, dy, duration);
 }
@@ -67,6 +80,19 @@ void Transform::_moveBy(const double dx, const double dy, const timestamp durati
     constrain(final.scale, final.y);
 
     if (duration == 0) {
+        if (current.panning) {
+            const timestamp now = util::now();
+            if (pan_time && now > pan_time && now - pan_time < 100_milliseconds) {
+                // Smooth out the jitter of individual touch events.
+                const double dt = now - pan_time;
+                pan_velocity_x = 0.5 * pan_velocity_x + 0.5 * (final.x - current.x) / dt;
+                pan_velocity_y = 0.5 * pan_velocity_y + 0.5 * (final.y - current.y) / dt;
+            } else {
+                pan_velocity_x = pan_velocity_y = 0;
+            }
+            pan_time = now;
+        }
+
         current.x = final.x;
         current.y = final.y;
     } else {
@@ -85,7 +111,7 @@ void Transform::_moveBy(const double dx, const double dy, const timestamp durati
 }
 
 void Transform::setLonLat(const double lon, const double lat, const timestamp duration) {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     const double f = std::fmin(std::fmax(std::sin(D2R * lat), -0.9999), 0.9999);
     double xn = -lon * Bc;
@@ -96,7 +122,7 @@ void Transform::setLonLat(const double lon, const double lat, const timestamp du
 
 void Transform::setLonLatZoom(const double lon, const double lat, const double zoom,
                               const timestamp duration) {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     double new_scale = std::pow(2.0, zoom);
 
@@ -112,20 +138,17 @@ void Transform::setLonLatZoom(const double lon, const double lat, const double z
 }
 
 void Transform::getLonLat(double &lon, double &lat) const {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
-
-    final.getLonLat(lon, lat);
+    publishedFinal.load().getLonLat(lon, lat);
 }
 
 void Transform::getLonLatZoom(double &lon, double &lat, double &zoom) const {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
-
-    getLonLat(lon, lat);
-    zoom = getZoom();
+    const TransformState state = publishedFinal.load();
+    state.getLonLat(lon, lat);
+    zoom = std::log(state.scale) / M_LN2;
 }
 
 void Transform::startPanning() {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     _clearPanning();
 
@@ -137,7 +160,7 @@ void Transform::startPanning() {
 }
 
 void Transform::stopPanning() {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     _clearPanning();
 }
@@ -153,7 +176,7 @@ void Transform::_clearPanning() {
 #pragma mark - Zoom
 
 void Transform::scaleBy(const double ds, const double cx, const double cy, const timestamp duration) {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     // clamp scale to min/max values
     double new_scale = current.scale * ds;
@@ -168,31 +191,27 @@ void Transform::scaleBy(const double ds, const double cx, const double cy, const
 
 void Transform::setScale(const double scale, const double cx, const double cy,
                          const timestamp duration) {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     _setScale(scale, cx, cy, duration);
 }
 
 void Transform::setZoom(const double zoom, const timestamp duration) {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     _setScale(std::pow(2.0, zoom), -1, -1, duration);
 }
 
 double Transform::getZoom() const {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
-
-    return std::log(final.scale) / M_LN2;
+    return std::log(publishedFinal.load().scale) / M_LN2;
 }
 
 double Transform::getScale() const {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
-
-    return final.scale;
+    return publishedFinal.load().scale;
 }
 
 void Transform::startScaling() {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     _clearScaling();
 
@@ -204,14 +223,15 @@ void Transform::startScaling() {
 }
 
 void Transform::stopScaling() {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     _clearScaling();
 }
 
 double Transform::getMinZoom() const {
-    double test_scale = current.scale;
-    double test_y = current.y;
+    const TransformState state = publishedCurrent.load();
+    double test_scale = state.scale;
+    double test_y = state.y;
     constrain(test_scale, test_y);
 
     return std::log2(std::fmin(min_scale, test_scale));
@@ -320,7 +340,7 @@ void Transform::constrain(double& scale, double& y) const {
 
 void Transform::rotateBy(const double start_x, const double start_y, const double end_x,
                          const double end_y, const timestamp duration) {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     double center_x = current.width / 2, center_y = current.height / 2;
 
@@ -350,13 +370,13 @@ void Transform::rotateBy(const double start_x, const double start_y, const doubl
 }
 
 void Transform::setAngle(const double new_angle, const timestamp duration) {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     _setAngle(new_angle, duration);
 }
 
 void Transform::setAngle(const double new_angle, const double cx, const double cy) {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     double dx = 0, dy = 0;
 
@@ -402,13 +422,11 @@ void Transform::_setAngle(double new_angle, const timestamp duration) {
 }
 
 double Transform::getAngle() const {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
-
-    return final.angle;
+    return publishedFinal.load().angle;
 }
 
 void Transform::startRotating() {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     _clearRotating();
 
@@ -420,7 +438,7 @@ void Transform::startRotating() {
 }
 
 void Transform::stopRotating() {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     _clearRotating();
 }
@@ -444,7 +462,7 @@ bool Transform::needsTransition() const {
 }
 
 void Transform::updateTransitions(const timestamp now) {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     transitions.remove_if([now](const util::ptr<util::transition> &transition) {
         return transition->update(now) == util::transition::complete;
@@ -452,7 +470,7 @@ void Transform::updateTransitions(const timestamp now) {
 }
 
 void Transform::cancelTransitions() {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
+    const Change change(*this);
 
     transitions.clear();
 }
@@ -460,13 +478,21 @@ void Transform::cancelTransitions() {
 #pragma mark - Transform state
 
 const TransformState Transform::currentState() const {
-    std::lock_guard<std::recursive_mutex> lock(mtx);
-
-    return current;
+    return publishedCurrent.load();
 }
 
 const TransformState Transform::finalState() const {
+    return publishedFinal.load();
+}
+
+const TransformState Transform::predictedState(const timestamp ahead) const {
     std::lock_guard<std::recursive_mutex> lock(mtx);
 
-    return final;
+    TransformState state = final;
+    if (current.panning && util::now() - pan_time < 100_milliseconds) {
+        state.x += pan_velocity_x * ahead;
+        state.y += pan_velocity_y * ahead;
+        constrain(state.scale, state.y);
+    }
+    return state;
 }
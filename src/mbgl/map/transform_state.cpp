@@ -2,9 +2,13 @@
 #include <mbgl/util/constants.hpp>
 #include <mbgl/util/box.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 using namespace mbgl;
 
 const double R2D = 180.0 / M_PI;
+const double D2R = M_PI / 180.0;
 
 #pragma mark - Matrix
 
@@ -25,6 +29,28 @@ void TransformState::matrixFor(mat4& matrix, const Tile::ID& id) const {
     matrix::scale(matrix, matrix, factor, factor, 1);
 }
 
+void TransformState::matrixFor(mat4& matrix, const Tile::ID& id, const mat4& projMatrix) const {
+    const double tile_scale = std::pow(2, id.z);
+    const double tile_size = scale * util::tileSize / tile_scale;
+    const float factor = scale / tile_scale / (4096.0f / util::tileSize);
+
+    // The tile origin, rotated around the center of the viewport.
+    const float s = std::sin(angle);
+    const float c = std::cos(angle);
+    const float dx = pixel_x() + id.x * tile_size - 0.5f * (float)width;
+    const float dy = pixel_y() + id.y * tile_size - 0.5f * (float)height;
+    const float tx = 0.5f * (float)width + c * dx - s * dy;
+    const float ty = 0.5f * (float)height + s * dx + c * dy;
+
+    for (int i = 0; i < 4; i++) {
+        const float p0 = projMatrix[i], p1 = projMatrix[4 + i];
+        matrix[i] = factor * (c * p0 + s * p1);
+        matrix[4 + i] = factor * (c * p1 - s * p0);
+        matrix[8 + i] = projMatrix[8 + i];
+        matrix[12 + i] = tx * p0 + ty * p1 + projMatrix[12 + i];
+    }
+}
+
 box TransformState::cornersToBox(uint32_t z) const {
     const double ref_scale = std::pow(2, z);
 
@@ -59,6 +85,23 @@ box TransformState::cornersToBox(uint32_t z) const {
     return b;
 }
 
+std::array<double, 2> TransformState::pointCoordinate(double px, double py, uint32_t z) const {
+    const double angle_sin = std::sin(-angle);
+    const double angle_cos = std::cos(-angle);
+
+    // Like cornersToBox(), relative to the center of the view.
+    const double dx = px - width / 2.0;
+    const double dy = py - height / 2.0;
+    const double ss_0 = scale * util::tileSize;
+    const double ss_1 = std::pow(2, z) / ss_0;
+    const double ss_2 = ss_0 / 2.0;
+
+    return {{
+        (dx * angle_cos - dy * angle_sin + ss_2 - x) * ss_1,
+        (dx * angle_sin + dy * angle_cos + ss_2 - y) * ss_1
+    }};
+}
+
 
 #pragma mark - Dimensions
 
@@ -90,6 +133,42 @@ float TransformState::getPixelRatio() const {
     return pixelRatio;
 }
 
+TransformState TransformState::resized(uint16_t width_, uint16_t height_, float pixelRatio_) const {
+    TransformState result = *this;
+    if (pixelRatio_ > 0) {
+        result.pixelRatio = pixelRatio_;
+    }
+    result.width = width_;
+    result.height = height_;
+    result.framebuffer = {{ uint16_t(width_ * result.pixelRatio), uint16_t(height_ * result.pixelRatio) }};
+    return result;
+}
+
+TransformState TransformState::moved(double lon, double lat, double zoom, double angle_) const {
+    // The same as Transform::setLonLatZoom() and Transform::setAngle().
+    TransformState result = *this;
+    result.scale = std::pow(2.0, zoom);
+    const double s = result.scale * util::tileSize;
+    const double f = std::fmin(std::fmax(std::sin(D2R * lat), -0.9999), 0.9999);
+    result.x = -lon * s / 360;
+    result.y = 0.5 * s / (2 * M_PI) * std::log((1 + f) / (1 - f));
+
+    while (angle_ > M_PI) angle_ -= 2 * M_PI;
+    while (angle_ <= -M_PI) angle_ += 2 * M_PI;
+    result.angle = angle_;
+    result.rotating = result.scaling = result.panning = false;
+    return result;
+}
+
+TransformState TransformState::scaled(float resolution) const {
+    TransformState result = *this;
+    result.pixelRatio = pixelRatio * resolution;
+    for (size_t i = 0; i < 2; i++) {
+        result.framebuffer[i] = uint16_t(std::max(1.0f, std::round(framebuffer[i] * resolution)));
+    }
+    return result;
+}
+
 float TransformState::worldSize() const {
     return scale * util::tileSize;
 }
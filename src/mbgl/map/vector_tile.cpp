@@ -1,8 +1,10 @@
 #include <mbgl/map/vector_tile.hpp>
-#include <mbgl/style/filter_expression_private.hpp>
+#include <mbgl/style/filter_program_private.hpp>
+#include <mbgl/platform/log.hpp>
 
 #include <algorithm>
 #include <iostream>
+#include <unordered_map>
 
 using namespace mbgl;
 
@@ -17,31 +19,66 @@ std::ostream& mbgl::operator<<(std::ostream& os, const FeatureType& type) {
     }
 }
 
-VectorTileFeature::VectorTileFeature(pbf feature, const VectorTileLayer& layer) {
-    while (feature.next()) {
-        if (feature.tag == 1) { // id
-            id = feature.varint<uint64_t>();
-        } else if (feature.tag == 2) { // tags
-            // tags are packed varints. They should have an even length.
-            pbf tags = feature.message();
-            while (tags) {
-                uint32_t tag_key = tags.varint();
+namespace {
 
-                if (layer.keys.size() <= tag_key) {
-                    throw std::runtime_error("feature referenced out of range key");
-                }
+// Reads a varint from the bytes between pos and end without throwing. Returns 0 if the bytes end
+// before the varint does, -1 if it is too long, and 1 otherwise.
+int readVarint(const uint8_t *&pos, const uint8_t *end, uint64_t &value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (pos == end) {
+            return 0;
+        }
+        const uint8_t byte = *pos++;
+        value |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return 1;
+        }
+    }
+    return -1;
+}
 
-                if (tags) {
-                    uint32_t tag_val = tags.varint();
-                    if (layer.values.size() <= tag_val) {
-                        throw std::runtime_error("feature referenced out of range value");
-                    }
+// Tags are packed varints of key and value indices. They should have an even length.
+void decodeTags(pbf tags, const VectorTileLayer& layer, VectorTileTags& result) {
+    result.clear();
+    while (tags) {
+        uint32_t tag_key = tags.varint();
 
-                    properties.emplace(layer.keys[tag_key], layer.values[tag_val]);
-                } else {
-                    throw std::runtime_error("uneven number of feature tag ids");
-                }
+        if (layer.keys.size() <= tag_key) {
+            throw std::runtime_error("feature referenced out of range key");
+        }
+
+        if (tags) {
+            uint32_t tag_val = tags.varint();
+            if (layer.values.size() <= tag_val) {
+                throw std::runtime_error("feature referenced out of range value");
             }
+
+            result.emplace_back(tag_key, tag_val);
+        } else {
+            throw std::runtime_error("uneven number of feature tag ids");
+        }
+    }
+}
+
+const Value *findValue(const VectorTileTags& tags, const VectorTileLayer& layer, uint32_t key) {
+    for (const auto& tag : tags) {
+        if (tag.first == key) {
+            return &layer.values[tag.second];
+        }
+    }
+    return nullptr;
+}
+
+}
+
+VectorTileFeature::VectorTileFeature(pbf feature, const VectorTileLayer& layer_)
+    : layer(layer_) {
+    while (feature.next()) {
+        if (feature.tag == 1) { // id
+            id = feature.varint<uint64_t>();
+        } else if (feature.tag == 2) { // tags
+            decodeTags(feature.message(), layer, tags);
         } else if (feature.tag == 3) { // type
             type = (FeatureType)feature.varint();
         } else if (feature.tag == 4) { // geometry
@@ -52,11 +89,22 @@ VectorTileFeature::VectorTileFeature(pbf feature, const VectorTileLayer& layer)
     }
 }
 
+const Value *VectorTileFeature::getValue(const std::string &key) const {
+    auto field_it = layer.key_index.find(key);
+    if (field_it == layer.key_index.end()) {
+        return nullptr;
+    }
+    return findValue(tags, layer, field_it->second);
+}
+
+const Value *VectorTileFeature::getValue(uint32_t key) const {
+    return findValue(tags, layer, key);
+}
 
 std::ostream& mbgl::operator<<(std::ostream& os, const VectorTileFeature& feature) {
     os << "Feature(" << feature.id << "): " << feature.type << std::endl;
-    for (const auto& prop : feature.properties) {
-        os << "  - " << prop.first << ": " << prop.second << std::endl;
+    for (const auto& tag : feature.tags) {
+        os << "  - " << feature.layer.keys[tag.first] << ": " << feature.layer.values[tag.second] << std::endl;
     }
     return os;
 }
@@ -66,10 +114,23 @@ VectorTile::VectorTile() {}
 
 
 VectorTile::VectorTile(pbf tile) {
+    index(tile);
+}
+
+VectorTile::VectorTile(const std::shared_ptr<const std::string> &data_) : data(data_) {
+    index(pbf((const uint8_t *)data->data(), data->size()));
+}
+
+void VectorTile::index(pbf tile) {
     while (tile.next()) {
         if (tile.tag == 3) { // layer
-            VectorTileLayer layer(tile.message());
-            layers.emplace(layer.name, std::forward<VectorTileLayer>(layer));
+            const pbf layer = tile.message();
+
+            // Only read the name here; everything else is decoded on demand.
+            pbf fields = layer;
+            if (fields.next(1)) { // name
+                layerData.emplace(fields.string(), LayerData { layer, nullptr, 0 });
+            }
         } else {
             tile.skip();
         }
@@ -78,12 +139,181 @@ VectorTile::VectorTile(pbf tile) {
 
 VectorTile& VectorTile::operator=(VectorTile && other) {
     if (this != &other) {
+        std::lock(mtx, other.mtx);
+        std::lock_guard<std::mutex> lock(mtx, std::adopt_lock);
+        std::lock_guard<std::mutex> otherLock(other.mtx, std::adopt_lock);
+        layerData.swap(other.layerData);
         layers.swap(other.layers);
     }
     return *this;
 }
 
-VectorTileLayer::VectorTileLayer(pbf layer) : data(layer) {
+std::vector<std::string> VectorTile::append(const char *bytes, size_t length) {
+    std::vector<std::string> complete;
+    appended += length;
+    if (!appendable) {
+        return complete;
+    }
+    pending.append(bytes, length);
+
+    // Every complete field is consumed; the layers among them are copied out of the pending bytes,
+    // which move when more bytes arrive.
+    const uint8_t *const begin = (const uint8_t *)pending.data();
+    const uint8_t *const end = begin + pending.size();
+    const uint8_t *field = begin;
+    while (field < end) {
+        const uint8_t *pos = field;
+        uint64_t key = 0, value = 0, size = 0;
+        int read = readVarint(pos, end, key);
+        if (read > 0) {
+            switch (key & 0x7) {
+                case 0: read = readVarint(pos, end, value); break;
+                case 1: size = 8; break;
+                case 2: read = readVarint(pos, end, size); break;
+                case 5: size = 4; break;
+                default: read = -1; break;
+            }
+        }
+        if (read < 0) {
+            appendable = false;
+            break;
+        }
+        if (read == 0 || uint64_t(end - pos) < size) {
+            break;
+        }
+
+        if (key == ((3 << 3) | 2)) { // layer
+            const size_t offset = appended - pending.size() + (pos - begin);
+            const auto copy = std::make_shared<const std::string>((const char *)pos, size_t(size));
+            const pbf layer((const uint8_t *)copy->data(), copy->size());
+
+            // Only read the name here; everything else is decoded on demand.
+            pbf fields = layer;
+            try {
+                if (fields.next(1)) { // name
+                    std::string name = fields.string();
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (layerData.emplace(name, LayerData { layer, copy, offset }).second) {
+                        complete.push_back(std::move(name));
+                    }
+                }
+            } catch (const pbf::exception &) {
+                appendable = false;
+                break;
+            }
+        }
+        field = pos + size;
+    }
+
+    if (appendable) {
+        pending.erase(0, field - begin);
+    } else {
+        std::string().swap(pending);
+    }
+    return complete;
+}
+
+bool VectorTile::finish(const std::shared_ptr<const std::string> &data_) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!appendable || !pending.empty() || appended != data_->size()) {
+        return false;
+    }
+    for (const auto &layer : layerData) {
+        const std::string &copy = *layer.second.copy;
+        if (data_->compare(layer.second.offset, copy.size(), copy) != 0) {
+            return false;
+        }
+    }
+
+    // Decoded layers keep their copy until they are released.
+    for (auto &layer : layerData) {
+        layer.second.data = pbf((const uint8_t *)data_->data() + layer.second.offset, layer.second.copy->size());
+        layer.second.copy.reset();
+    }
+    data = data_;
+    return true;
+}
+
+util::ptr<VectorTile> VectorTile::get(const std::shared_ptr<const std::string> &data,
+                                      const util::ptr<VectorTile> &streamed) {
+    static std::mutex mtx;
+    // Keyed by the data; each tile holds on to its data, so the address isn't reused while the
+    // tile exists.
+    static std::unordered_map<const std::string *, std::weak_ptr<VectorTile>> tiles;
+    static size_t sweepSize = 64;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    std::weak_ptr<VectorTile> &entry = tiles[data.get()];
+    util::ptr<VectorTile> tile = entry.lock();
+    if (!tile) {
+        if (streamed && streamed->finish(data)) {
+            tile = streamed;
+        } else {
+            tile = std::make_shared<VectorTile>(data);
+        }
+        entry = tile;
+
+        // Forget the tiles that were destroyed once the table doubled in size.
+        if (tiles.size() >= sweepSize) {
+            for (auto it = tiles.begin(); it != tiles.end();) {
+                it = it->second.expired() ? tiles.erase(it) : std::next(it);
+            }
+            sweepSize = std::max(size_t(64), tiles.size() * 2);
+        }
+    }
+    return tile;
+}
+
+std::shared_ptr<const VectorTileLayer> VectorTile::getLayer(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto layer_it = layers.find(name);
+    if (layer_it != layers.end()) {
+        return layer_it->second;
+    }
+
+    auto data_it = layerData.find(name);
+    if (data_it == layerData.end()) {
+        return nullptr;
+    }
+
+    auto layer = std::make_shared<const VectorTileLayer>(data_it->second.data, data_it->second.copy);
+    layers.emplace(name, layer);
+    return layer;
+}
+
+size_t VectorTile::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return memoryUsageLocked();
+}
+
+size_t VectorTile::memoryUsageLocked() const {
+    size_t size = 0;
+    for (const auto &layer : layers) {
+        size += layer.second->memoryUsage();
+    }
+    return size;
+}
+
+void VectorTile::trim(size_t limit) {
+    std::lock_guard<std::mutex> lock(mtx);
+    size_t size = memoryUsageLocked();
+    while (size > limit && !layers.empty()) {
+        auto largest = layers.begin();
+        size_t largest_size = 0;
+        for (auto it = layers.begin(); it != layers.end(); ++it) {
+            const size_t layer_size = it->second->memoryUsage();
+            if (layer_size > largest_size) {
+                largest = it;
+                largest_size = layer_size;
+            }
+        }
+        size -= largest_size;
+        layers.erase(largest);
+    }
+}
+
+VectorTileLayer::VectorTileLayer(pbf layer, const std::shared_ptr<const std::string> &copy_)
+    : data(layer), copy(copy_) {
     std::vector<std::string> stacks;
 
     while (layer.next()) {
@@ -100,11 +330,33 @@ VectorTileLayer::VectorTileLayer(pbf layer) : data(layer) {
             layer.skip();
         }
     }
+
+    key_ids = KeyDictionary::Get().resolve(keys);
+}
+
+size_t VectorTileLayer::memoryUsage() const {
+    size_t size = sizeof(VectorTileLayer);
+    for (const std::string &key : keys) {
+        // Every key is stored twice: once in the list and once in the index.
+        size += 2 * (sizeof(std::string) + key.capacity()) + sizeof(uint32_t);
+    }
+    size += key_ids.capacity() * sizeof(int32_t);
+    size += values.capacity() * sizeof(Value);
+    for (const Value &value : values) {
+        if (value.is<std::string>()) {
+            size += value.get<std::string>().capacity();
+        }
+    }
+    if (copy) {
+        // Released along with the layer once the tile has its complete data.
+        size += copy->capacity();
+    }
+    return size;
 }
 
-FilteredVectorTileLayer::FilteredVectorTileLayer(const VectorTileLayer& layer_, const FilterExpression &filterExpression_)
+FilteredVectorTileLayer::FilteredVectorTileLayer(const VectorTileLayer& layer_, const FilterProgram &filter_)
     : layer(layer_),
-      filterExpression(filterExpression_) {
+      filter(filter_) {
 }
 
 FilteredVectorTileLayer::iterator FilteredVectorTileLayer::begin() const {
@@ -118,7 +370,8 @@ FilteredVectorTileLayer::iterator FilteredVectorTileLayer::end() const {
 FilteredVectorTileLayer::iterator::iterator(const FilteredVectorTileLayer& parent_, const pbf& data_)
     : parent(parent_),
       feature(pbf()),
-      data(data_) {
+      data(data_),
+      extractor(parent_.layer) {
     operator++();
 }
 
@@ -126,64 +379,73 @@ VectorTileTagExtractor::VectorTileTagExtractor(const VectorTileLayer &layer) : l
 
 
 void VectorTileTagExtractor::setTags(const pbf &pbf) {
-    tags_ = pbf;
-}
+    tags_.clear();
+
+    mbgl::pbf tags_pbf = pbf;
+    while (tags_pbf) {
+        const uint32_t tag_key = tags_pbf.varint();
+        if (!tags_pbf) {
+            // This should not happen; otherwise the vector tile is invalid.
+            Log::Warning(Event::ParseTile, "uneven number of feature tag ids");
+            return;
+        }
+        const uint32_t tag_val = tags_pbf.varint();
 
-mapbox::util::optional<Value> VectorTileTagExtractor::getValue(const std::string &key) const {
-    if (key == "$type") {
-        return Value(uint64_t(type_));
+        if (layer_.values.size() <= tag_val) {
+            Log::Warning(Event::ParseTile, "feature references out of range value");
+            continue;
+        }
+
+        tags_.emplace_back(tag_key, tag_val);
     }
+}
 
-    mapbox::util::optional<Value> value;
+const Value *VectorTileTagExtractor::getValue(const FilterKey &key) const {
+    if (key.id == TypeKeyID) {
+        return &type_value_;
+    }
 
-    auto field_it = layer_.key_index.find(key);
-    if (field_it != layer_.key_index.end()) {
-        const uint32_t filter_key = field_it->second;
-
-        // Now loop through all the key/value pair tags.
-        // tags are packed varints. They should have an even length.
-        pbf tags_pbf = tags_;
-        uint32_t tag_key, tag_val;
-        while (tags_pbf) {
-            tag_key = tags_pbf.varint();
-            if (!tags_pbf) {
-                // This should not happen; otherwise the vector tile is invalid.
-                fprintf(stderr, "[WARNING] uneven number of feature tag ids\n");
-                return value;
-            }
-            // Note: We need to run this command in all cases, even if the keys don't match.
-            tag_val = tags_pbf.varint();
-
-            if (tag_key == filter_key) {
-                if (layer_.values.size() > tag_val) {
-                    value = layer_.values[tag_val];
-                } else {
-                    fprintf(stderr, "[WARNING] feature references out of range value\n");
-                    break;
-                }
-            }
+    if (key.id < layer_.key_ids.size()) {
+        const int32_t index = layer_.key_ids[key.id];
+        if (index < 0) {
+            return nullptr;
         }
+        return findValue(tags_, layer_, index);
     }
 
-    return value;
+    // This key was interned after the layer was decoded.
+    return getValue(key.name);
+}
+
+const Value *VectorTileTagExtractor::getValue(const std::string &key) const {
+    if (key == "$type") {
+        return &type_value_;
+    }
+
+    auto field_it = layer_.key_index.find(key);
+    if (field_it == layer_.key_index.end()) {
+        return nullptr;
+    }
+    return findValue(tags_, layer_, field_it->second);
 }
 
 void VectorTileTagExtractor::setType(FeatureType type) {
     type_ = type;
+    type_value_ = uint64_t(type);
 }
 
-template bool mbgl::evaluate(const FilterExpression&, const VectorTileTagExtractor&);
-
 void FilteredVectorTileLayer::iterator::operator++() {
     valid = false;
 
-    const FilterExpression &expression = parent.filterExpression;
+    const FilterProgram &filter = parent.filter;
 
     while (data.next(2)) { // feature
         feature = data.message();
+        count++;
         pbf feature_pbf = feature;
 
-        VectorTileTagExtractor extractor(parent.layer);
+        extractor.setTags(pbf());
+        extractor.setType(FeatureType::Unknown);
 
         // Retrieve the basic information
         while (feature_pbf.next()) {
@@ -196,7 +458,7 @@ void FilteredVectorTileLayer::iterator::operator++() {
             }
         }
 
-        if (evaluate(expression, extractor)) {
+        if (filter.evaluate(extractor)) {
             valid = true;
             return; // data loop
         } else {
@@ -1,15 +1,18 @@
 #ifndef MBGL_MAP_VECTOR_TILE
 #define MBGL_MAP_VECTOR_TILE
 
-#include <mbgl/style/filter_expression.hpp>
+#include <mbgl/style/filter_program.hpp>
 #include <mbgl/style/value.hpp>
 #include <mbgl/text/glyph.hpp>
 #include <mbgl/util/pbf.hpp>
 #include <mbgl/util/optional.hpp>
+#include <mbgl/util/ptr.hpp>
 
 #include <cstdint>
 #include <iosfwd>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -27,13 +30,24 @@ enum class FeatureType {
 
 std::ostream& operator<<(std::ostream&, const FeatureType& type);
 
+// Decoded property tags of a feature, as (key index, value index) pairs into the layer's
+// keys and values.
+typedef std::vector<std::pair<uint32_t, uint32_t>> VectorTileTags;
+
 class VectorTileFeature {
 public:
     VectorTileFeature(pbf feature, const VectorTileLayer& layer);
 
+    // Points into the layer's values, or is null if the feature doesn't have the key.
+    const Value *getValue(const std::string &key) const;
+
+    // Looks up a key by its index into the layer's keys.
+    const Value *getValue(uint32_t key) const;
+
+    const VectorTileLayer& layer;
     uint64_t id = 0;
     FeatureType type = FeatureType::Unknown;
-    std::map<std::string, Value> properties;
+    VectorTileTags tags;
     pbf geometry;
 };
 
@@ -45,19 +59,24 @@ public:
     VectorTileTagExtractor(const VectorTileLayer &layer);
 
     void setTags(const pbf &pbf);
-    mapbox::util::optional<Value> getValue(const std::string &key) const;
+
+    // The returned values are owned by the layer (or the extractor, for $type) and aren't
+    // copied, so that filters don't allocate for every string property they compare.
+    const Value *getValue(const FilterKey &key) const;
+    const Value *getValue(const std::string &key) const;
     void setType(FeatureType type);
     FeatureType getType() const;
 
 private:
     const VectorTileLayer &layer_;
-    pbf tags_;
+    VectorTileTags tags_;
     FeatureType type_ = FeatureType::Unknown;
+    Value type_value_ = uint64_t(FeatureType::Unknown);
 };
 
 /*
  * Allows iterating over the features of a VectorTileLayer using a
- * BucketDescription as filter. Only features matching the descriptions will
+ * compiled bucket filter. Only features matching the descriptions will
  * be returned (as pbf).
  */
 class FilteredVectorTileLayer {
@@ -69,46 +88,129 @@ public:
         bool operator!=(const iterator& other) const;
         const pbf& operator*() const;
 
+        // The properties of the current feature.
+        inline const VectorTileTagExtractor& tags() const {
+            return extractor;
+        }
+
+        // The position of the current feature among all features of the layer.
+        inline uint32_t index() const {
+            return count - 1;
+        }
+
     private:
         const FilteredVectorTileLayer& parent;
         bool valid = false;
+        uint32_t count = 0;
         pbf feature;
         pbf data;
+
+        // Reused for every feature so that the tag storage is only allocated once.
+        VectorTileTagExtractor extractor;
     };
 
 public:
-    FilteredVectorTileLayer(const VectorTileLayer& layer, const FilterExpression &filterExpression);
+    FilteredVectorTileLayer(const VectorTileLayer& layer, const FilterProgram &filter);
 
     iterator begin() const;
     iterator end() const;
 
 private:
     const VectorTileLayer& layer;
-    const FilterExpression& filterExpression;
+    const FilterProgram& filter;
 };
 
 std::ostream& operator<<(std::ostream&, const PositionedGlyph& placement);
 
 class VectorTileLayer {
 public:
-    VectorTileLayer(pbf data);
+    VectorTileLayer(pbf data, const std::shared_ptr<const std::string> &copy = nullptr);
 
     const pbf data;
+    // Owns the bytes of data if they were copied out of a tile while it was downloading.
+    const std::shared_ptr<const std::string> copy;
     std::string name;
     uint32_t extent = 4096;
     std::vector<std::string> keys;
     std::unordered_map<std::string, uint32_t> key_index;
+    // Maps KeyIDs that were known when this layer was decoded to indices into keys.
+    std::vector<int32_t> key_ids;
     std::vector<Value> values;
-    std::map<std::string, std::map<Value, Shaping>> shaping;
+
+    // Approximate number of bytes held by the decoded keys and values.
+    size_t memoryUsage() const;
 };
 
+/*
+ * Indexes the layers of a vector tile by name without decoding them. A layer's
+ * keys and values are only decoded the first time it is requested. Any number
+ * of threads may use a tile at the same time.
+ */
 class VectorTile {
 public:
     VectorTile();
     VectorTile(pbf data);
+    // Keeps the data alive for as long as the tile exists.
+    VectorTile(const std::shared_ptr<const std::string> &data);
     VectorTile& operator=(VectorTile&& other);
 
-    std::map<std::string, const VectorTileLayer> layers;
+    // Returns the tile for this data. Tiles that are parsed by several maps at once, e.g. when
+    // they share a SharedFileSource, receive the same data object and decode it only once. If no
+    // other tile was created for the data yet, a /streamed/ tile whose appended bytes turn out to
+    // be the data becomes the tile for it, along with the layers it decoded.
+    static util::ptr<VectorTile> get(const std::shared_ptr<const std::string> &data,
+                                     const util::ptr<VectorTile> &streamed = nullptr);
+
+    // Indexes a tile that is still downloading. Appends the next bytes of its data and returns the
+    // names of the layers that are complete now; getLayer() finds them right away. Once the bytes
+    // turn out not to be a vector tile, e.g. because they are compressed, nothing is indexed
+    // anymore. Must only be called from one thread, before get() received the tile.
+    std::vector<std::string> append(const char *bytes, size_t length);
+
+    // The number of bytes that were appended so far.
+    inline size_t appendedSize() const {
+        return appended;
+    }
+
+    // Returns nullptr if the tile doesn't contain a layer with this name.
+    std::shared_ptr<const VectorTileLayer> getLayer(const std::string& name);
+
+    // Approximate number of bytes held by all decoded layers.
+    size_t memoryUsage() const;
+
+    // Releases decoded layers, largest first, until at most limit bytes are in
+    // use. The layer index is always kept. Layers that were returned by
+    // getLayer() stay valid until they are released by their users, too.
+    void trim(size_t limit);
+
+private:
+    struct LayerData {
+        pbf data;
+
+        // Of layers that were appended: the copy of their bytes, and where they start in the data.
+        std::shared_ptr<const std::string> copy;
+        size_t offset;
+    };
+
+    void index(pbf tile);
+    size_t memoryUsageLocked() const;
+
+    // Switches the appended layers over to the complete data. Returns false if the data isn't
+    // what was appended.
+    bool finish(const std::shared_ptr<const std::string> &data);
+
+    std::shared_ptr<const std::string> data;
+
+    // Undecoded layer messages, keyed by layer name.
+    std::map<std::string, LayerData> layerData;
+    std::map<std::string, std::shared_ptr<const VectorTileLayer>> layers;
+    mutable std::mutex mtx;
+
+    // Of a tile that is appended: the bytes of the incomplete field at the end, the total number
+    // of bytes, and whether they are still a valid vector tile.
+    std::string pending;
+    size_t appended = 0;
+    bool appendable = true;
 };
 
 
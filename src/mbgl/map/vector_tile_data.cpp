@@ -1,19 +1,49 @@
 #include <mbgl/map/vector_tile_data.hpp>
 #include <mbgl/map/tile_parser.hpp>
+#include <mbgl/map/vector_tile.hpp>
+#include <mbgl/map/shared_buckets.hpp>
+#include <mbgl/map/feature_index.hpp>
+#include <mbgl/map/sprite.hpp>
+#include <mbgl/renderer/bucket.hpp>
+#include <mbgl/text/collision.hpp>
+#include <mbgl/util/constants.hpp>
 #include <mbgl/util/std.hpp>
 #include <mbgl/map/map.hpp>
+#include <mbgl/style/style.hpp>
 #include <mbgl/style/style_layer.hpp>
+#include <mbgl/style/style_layer_group.hpp>
 #include <mbgl/style/style_bucket.hpp>
 #include <mbgl/geometry/glyph_atlas.hpp>
+#include <mbgl/text/glyph_store.hpp>
+#include <mbgl/platform/log.hpp>
+#include <mbgl/platform/gl_state.hpp>
+#include <mbgl/util/uv_detail.hpp>
+
+#include <cmath>
+#include <set>
 
 using namespace mbgl;
 
+namespace {
+
+struct DecodeJob {
+    DecodeJob(util::ptr<TileData> tile_, util::ptr<VectorTile> vector_data_, std::string layer_)
+        : tile(tile_), vector_data(vector_data_), layer(std::move(layer_)) {}
+
+    util::ptr<TileData> tile;
+    util::ptr<VectorTile> vector_data;
+    std::string layer;
+};
+
+}
+
 VectorTileData::VectorTileData(Tile::ID const& id_,
                                float mapMaxZoom, util::ptr<Style> style_,
                                GlyphAtlas& glyphAtlas_, GlyphStore& glyphStore_,
                                SpriteAtlas& spriteAtlas_, util::ptr<Sprite> sprite_,
                                TexturePool& texturePool_,
-                               const SourceInfo& source_)
+                               const SourceInfo& source_,
+                               util::ptr<CollisionIndex> collisionIndex_)
     : TileData(id_, source_),
       glyphAtlas(glyphAtlas_),
       glyphStore(glyphStore_),
@@ -21,16 +51,47 @@ VectorTileData::VectorTileData(Tile::ID const& id_,
       sprite(sprite_),
       texturePool(texturePool_),
       style(style_),
+      layoutGeneration(style_->getLayoutGeneration()),
+      contextGeneration(gl::State::getContextGeneration()),
+      collisionIndex(collisionIndex_),
       depth(id.z >= source.max_zoom ? mapMaxZoom - id.z : 1) {
 }
 
 VectorTileData::~VectorTileData() {
     glyphAtlas.removeGlyphs(id.to_uint64());
+    if (collisionIndex) {
+        collisionIndex->remove(id);
+    }
 }
 
 
+size_t TileBuffers::upload(size_t maxBytes) {
+    size_t bytes = 0;
+    const auto left = [&]() -> size_t { return maxBytes ? maxBytes - bytes : 0; };
+    const auto spent = [&]() { return maxBytes && bytes >= maxBytes; };
+
+    if (!spent()) bytes += fillVertexBuffer.upload(left());
+    if (!spent()) bytes += fillColorBuffer.upload(left());
+    if (!spent()) bytes += fillFringeBuffer.upload(left());
+    if (!spent()) bytes += lineVertexBuffer.upload(left());
+    if (!spent()) bytes += circleVertexBuffer.upload(left());
+    if (!spent()) bytes += textVertexBuffer.upload(left());
+    if (!spent()) bytes += iconVertexBuffer.upload(left());
+    if (!spent()) bytes += triangleElementsBuffer.upload(left());
+    if (!spent()) bytes += iconElementsBuffer.upload(left());
+    if (!spent()) bytes += lineElementsBuffer.upload(left());
+    if (!spent()) bytes += textInstanceBuffer.upload(left());
+    if (!spent()) bytes += iconInstanceBuffer.upload(left());
+    if (!spent()) bytes += textPlacementBuffer.upload(left());
+    if (!spent()) bytes += iconPlacementBuffer.upload(left());
+    return bytes;
+}
+
 void VectorTileData::parse() {
-    if (state != State::loaded) {
+    // A tile that was parsed before is only reparsed when its inputs changed; in
+    // that case, TileParser only rebuilds the buckets whose fingerprint differs.
+    const bool initial = state == State::loaded;
+    if (!initial && state != State::parsed) {
         return;
     }
 
@@ -38,41 +99,450 @@ void VectorTileData::parse() {
         // Parsing creates state that is encapsulated in TileParser. While parsing,
         // the TileParser object writes results into this objects. All other state
         // is going to be discarded afterwards.
-        TileParser parser(data, *this, style,
+        if (!vector_data) {
+            vector_data = VectorTile::get(data, streamedData);
+            dataHash = std::hash<std::string>()(*data);
+        }
+
+        TileParser parser(*vector_data, *this, style,
                           glyphAtlas, glyphStore,
                           spriteAtlas, sprite,
-                          texturePool);
+                          texturePool, parseWorker);
         parser.parse();
+
+        // The buffers of this parse are complete, so tiles with the same data can draw its fill
+        // and line buckets.
+        for (const auto &pending : pendingBuckets) {
+            const util::ptr<StyleBucket> &bucket_desc = pending.second.fingerprint.bucket_desc;
+            if (pending.second.bucket && bucket_desc && !bucket_desc->render.is<StyleBucketSymbol>()) {
+                SharedBuckets::add(data, dataHash, id.z, depth, bucket_desc,
+                                   { pending.second.buffers, pending.second.bucket, pending.second.featureIndex });
+            }
+        }
+
+        // Keep decoded layers around for the next reparse, as long as they fit
+        // into the cache budget.
+        vector_data->trim(util::decodedTileCacheSize);
+        decodedBytes = vector_data->memoryUsage();
     } catch (const std::exception& ex) {
 #if defined(DEBUG)
-        fprintf(stderr, "[%p] exception [%d/%d/%d]... failed: %s\n", this, id.z, id.x, id.y, ex.what());
+        Log::Warning(Event::ParseTile, "[%p] exception [%d/%d/%d]... failed: %s", this, id.z, id.x, id.y, ex.what());
 #endif
         cancel();
         return;
     }
 
-    if (state != State::obsolete) {
+    // Nothing is rendering this tile before its initial parse completed, so we
+    // can move the buckets into place right away. Buckets from a reparse are
+    // committed on the main thread in afterParse().
+    if (initial && state != State::obsolete) {
+        commitBuckets();
         state = State::parsed;
     }
 }
 
-void VectorTileData::render(Painter &painter, util::ptr<StyleLayer> layer_desc, const mat4 &matrix) {
+void VectorTileData::receiveData(uv::worker &worker, const std::string &bytes, size_t offset) {
+    // Parts that don't continue the data, e.g. because the download started before the tile
+    // listened, can't be indexed.
+    if (offset == 0) {
+        streamedData = std::make_shared<VectorTile>();
+    } else if (streamedData && streamedData->appendedSize() != offset) {
+        streamedData.reset();
+    }
+    if (!streamedData) {
+        return;
+    }
+
+    std::vector<std::string> complete = streamedData->append(bytes.data(), bytes.size());
+    const util::ptr<StyleLayerGroup> group = style->layers;
+    if (!group) {
+        return;
+    }
+
+    for (std::string &layer_name : complete) {
+        bool used = false;
+        for (const util::ptr<StyleLayer> &layer_desc : group->layers) {
+            if (layer_desc->bucket && layer_desc->bucket->source_layer == layer_name) {
+                used = true;
+                break;
+            }
+        }
+        if (!used) {
+            continue;
+        }
+
+        new uv::work<DecodeJob>(
+            worker,
+            [](DecodeJob& job) {
+                if (job.tile->state != State::obsolete) {
+                    job.vector_data->getLayer(job.layer);
+                }
+            },
+            [](DecodeJob&) {},
+            [](DecodeJob& job) {
+                return job.tile->state == State::obsolete ? HUGE_VALF : job.tile->priority.load();
+            },
+            shared_from_this(), streamedData, std::move(layer_name));
+    }
+}
+
+bool VectorTileData::afterParse() {
+    // The parse took over the layers, if they matched the data.
+    streamedData.reset();
+    reparsing = false;
+    if (state == State::obsolete) {
+        pendingBuckets.clear();
+        nextData.reset();
+        return false;
+    } else if (!uploaded) {
+        // The tile isn't drawn yet, so the buckets go up with the rest of it.
+        commitBuckets();
+    }
+
+    // Otherwise, the old buckets stay in place until upload() moved the new ones to the GPU, so
+    // that drawing the tile never has to upload anything.
+
+    // Data that arrived during the parse is parsed next.
+    if (nextData) {
+        std::shared_ptr<const std::string> next;
+        next.swap(nextData);
+        return replaceData(next);
+    }
+    return false;
+}
+
+void VectorTileData::commitBuckets() {
+    if (!pendingBuckets.empty()) {
+        generation++;
+    }
+    for (auto &pending : pendingBuckets) {
+        buckets[pending.first] = std::move(pending.second);
+    }
+    pendingBuckets.clear();
+}
+
+bool VectorTileData::isComplete() const {
+    if (state != State::parsed) {
+        return TileData::isComplete();
+    }
+    return !reparsing && pendingBuckets.empty() && !glyphGeneration && !symbolsDeferred;
+}
+
+bool VectorTileData::setSprite(util::ptr<Sprite> sprite_) {
+    // We can't swap out the sprite while a parse may be reading it. If the tile
+    // is still loading, we'll get another chance once it is parsed.
+    if (state != State::parsed || reparsing || sprite == sprite_) {
+        return false;
+    }
+
+    sprite = sprite_;
+
+    // The reparse compares against the buckets of the last one, uploaded or not.
+    commitBuckets();
+
+    for (const auto &parsed : buckets) {
+        if (parsed.second.fingerprint.sprite) {
+            reparsing = true;
+            break;
+        }
+    }
+
+    return reparsing;
+}
+
+bool VectorTileData::checkGlyphs() {
+    if (state != State::parsed || reparsing || !glyphGeneration ||
+        glyphGeneration == glyphStore.getGeneration()) {
+        return false;
+    }
+
+    commitBuckets();
+    reparsing = true;
+    return true;
+}
+
+bool VectorTileData::checkDeferredSymbols() {
+    if (state != State::parsed || reparsing || !symbolsDeferred || !sprite->isDone()) {
+        return false;
+    }
+
+    commitBuckets();
+    reparsing = true;
+    return true;
+}
+
+bool VectorTileData::checkLayout() {
+    if (state != State::parsed || reparsing || layoutGeneration == style->getLayoutGeneration()) {
+        return false;
+    }
+
+    // The parse compares the fingerprints of the buckets, so only the changed layers are built.
+    layoutGeneration = style->getLayoutGeneration();
+    commitBuckets();
+
+    // Buckets of layers that were removed from the style would never be drawn again.
+    std::set<std::string> names;
+    if (style->layers) {
+        for (const util::ptr<StyleLayer> &layer : style->layers->layers) {
+            if (layer && layer->bucket) {
+                names.insert(layer->bucket->name);
+            }
+        }
+    }
+    for (auto it = buckets.begin(); it != buckets.end();) {
+        if (names.count(it->first)) {
+            ++it;
+        } else {
+            it = buckets.erase(it);
+            generation++;
+        }
+    }
+
+    reparsing = true;
+    return true;
+}
+
+bool VectorTileData::checkContextLost() {
+    if (contextGeneration == gl::State::getContextGeneration()) {
+        return false;
+    }
+    if (state != State::parsed || reparsing) {
+        // The check waits until the buffers can be inspected.
+        return false;
+    }
+    contextGeneration = gl::State::getContextGeneration();
+
+    commitBuckets();
+    bool lost = false;
+    for (const auto &parsed : buckets) {
+        lost = lost || (parsed.second.buffers && parsed.second.buffers->isLost());
+    }
+
+    // The tile is drawn again once its buffers are in the new context.
+    uploaded = false;
+    if (!lost) {
+        return false;
+    }
+
+    // Without their elements, the buckets can't be drawn anymore, and the reparse must not keep
+    // any of them. The decoded layers and the bucket cache usually make this cheaper than the
+    // initial parse.
+    buckets.clear();
+    generation++;
+    reparsing = true;
+    return true;
+}
+
+bool VectorTileData::replaceData(const std::shared_ptr<const std::string> &data_) {
+    if (state == State::obsolete || !data_) {
+        return false;
+    }
+    if (data == data_ || (data && *data == *data_)) {
+        // Newer than anything that waits for the running parse.
+        nextData.reset();
+        return false;
+    }
+
+    // Like the sprite, we can't swap out the data while a parse may be reading it, so it waits
+    // for the parse to finish.
+    if (state != State::parsed || reparsing) {
+        nextData = data_;
+        return false;
+    }
+    nextData.reset();
+
+    // All buckets are rebuilt since their fingerprint refers to the old data.
+    commitBuckets();
+    data = data_;
+    vector_data.reset();
+    decodedBytes = 0;
+    reparsing = true;
+    return true;
+}
+
+void VectorTileData::render(Painter &painter, const util::ptr<StyleLayer> &layer_desc, const mat4 &matrix) {
     if (state == State::parsed && layer_desc->bucket) {
         auto databucket_it = buckets.find(layer_desc->bucket->name);
-        if (databucket_it != buckets.end()) {
-            assert(databucket_it->second);
-            databucket_it->second->render(painter, layer_desc, id, matrix);
+        if (databucket_it != buckets.end() && databucket_it->second.bucket) {
+            databucket_it->second.bucket->render(painter, layer_desc, id, matrix);
+        }
+    }
+}
+
+size_t VectorTileData::upload(size_t maxBytes) {
+    // The initial parse creates the buckets on a worker thread.
+    if (state != State::parsed) {
+        return 0;
+    }
+
+    size_t bytes = 0;
+    const auto left = [&]() -> size_t { return maxBytes ? maxBytes - bytes : 0; };
+    const auto spent = [&]() { return maxBytes && bytes >= maxBytes; };
+
+    if (hasPendingBuckets()) {
+        bool done = true;
+        for (const auto &pending : pendingBuckets) {
+            if (pending.second.buffers && !spent()) {
+                bytes += pending.second.buffers->upload(left());
+            }
+            if (pending.second.bucket && !spent()) {
+                bytes += pending.second.bucket->upload(left());
+            }
+            done = done && (!pending.second.buffers || pending.second.buffers->isUploaded()) &&
+                   (!pending.second.bucket || pending.second.bucket->isUploaded());
+        }
+        if (done) {
+            commitBuckets();
+        }
+        if (uploaded) {
+            return bytes;
+        }
+    }
+
+    for (const auto &parsed : buckets) {
+        if (parsed.second.buffers && !spent()) {
+            bytes += parsed.second.buffers->upload(left());
+        }
+        if (parsed.second.bucket && !spent()) {
+            bytes += parsed.second.bucket->upload(left());
         }
     }
+
+    for (const auto &parsed : buckets) {
+        if ((parsed.second.buffers && !parsed.second.buffers->isUploaded()) ||
+            (parsed.second.bucket && !parsed.second.bucket->isUploaded())) {
+            return bytes;
+        }
+    }
+
+    uploaded = true;
+    return bytes;
+}
+
+bool VectorTileData::needsUpload() const {
+    return TileData::needsUpload() || (ready() && hasPendingBuckets());
 }
 
 bool VectorTileData::hasData(StyleLayer const& layer_desc) const {
     if (state == State::parsed && layer_desc.bucket) {
         auto databucket_it = buckets.find(layer_desc.bucket->name);
-        if (databucket_it != buckets.end()) {
-            assert(databucket_it->second);
-            return databucket_it->second->hasData();
+        if (databucket_it != buckets.end() && databucket_it->second.bucket) {
+            return databucket_it->second.bucket->hasData();
         }
     }
     return false;
 }
+
+void VectorTileData::releaseMemory() {
+    // A parse that is in progress still uses the decoded layers.
+    if (state != State::parsed || reparsing || !vector_data) {
+        return;
+    }
+    vector_data->trim(0);
+    decodedBytes = vector_data->memoryUsage();
+}
+
+void VectorTileData::queryFeatures(const StyleLayer &layer_desc, double x, double y, double radius,
+                                   std::vector<RenderedFeature> &result) const {
+    if (state != State::parsed || !layer_desc.bucket) {
+        return;
+    }
+
+    const std::string &bucketName = layer_desc.bucket->name;
+    const auto it = buckets.find(bucketName);
+    if (it == buckets.end() || !it->second.bucket || !it->second.featureIndex) {
+        return;
+    }
+    const ParsedBucket &parsed = it->second;
+
+    std::vector<uint32_t> candidates;
+    parsed.featureIndex->query(bucketName, std::floor(x - radius), std::floor(y - radius),
+                               std::ceil(x + radius), std::ceil(y + radius), candidates);
+    if (candidates.empty()) {
+        return;
+    }
+
+    // The bucket was built from the data in its fingerprint, which a parse that is running may be
+    // replacing.
+    const util::ptr<VectorTile> tile = VectorTile::get(parsed.fingerprint.data);
+    const std::shared_ptr<const VectorTileLayer> layer = tile->getLayer(layer_desc.bucket->source_layer);
+    if (!layer) {
+        return;
+    }
+
+    GeometryDecoder decoder;
+    pbf features = layer->data;
+    uint32_t index = 0;
+    auto candidate = candidates.begin();
+    while (candidate != candidates.end() && features.next(2)) {
+        const pbf message = features.message();
+        if (index++ != *candidate) {
+            continue;
+        }
+        ++candidate;
+
+        const VectorTileFeature feature(message, *layer);
+        if (!FeatureIndex::intersects(decoder.decode(feature.geometry), feature.type, x, y, radius)) {
+            continue;
+        }
+
+        result.emplace_back();
+        RenderedFeature &rendered = result.back();
+        rendered.layer = layer_desc.id;
+        rendered.sourceLayer = layer_desc.bucket->source_layer;
+        rendered.id = feature.id;
+        for (const auto &tag : feature.tags) {
+            rendered.properties[layer->keys[tag.first]] = mbgl::toString(layer->values[tag.second]);
+        }
+    }
+}
+
+TileMemoryUsage VectorTileData::memoryUsage() const {
+    TileMemoryUsage usage = TileData::memoryUsage();
+    usage.data.cpu += decodedBytes;
+    usage.total.cpu += decodedBytes;
+    if (streamedData) {
+        usage.data.cpu += streamedData->appendedSize();
+        usage.total.cpu += streamedData->appendedSize();
+    }
+
+    // The initial parse creates the buckets on a worker thread.
+    if (state != State::parsed) {
+        return usage;
+    }
+
+    // Buckets of the same parsing pass share their buffers, so the buffers are added to the total
+    // once, while every bucket only reports the part it uses.
+    std::set<const TileBuffers *> counted;
+    std::set<const FeatureIndex *> indexed;
+    for (const auto &parsed : buckets) {
+        if (parsed.second.buffers && counted.insert(parsed.second.buffers.get()).second) {
+            usage.total += parsed.second.buffers->memoryUsage();
+        }
+
+        // The feature indices of the parses count towards the data of the tile.
+        const FeatureIndex *index = parsed.second.featureIndex.get();
+        if (index && indexed.insert(index).second) {
+            usage.data.cpu += index->memoryUsage();
+            usage.total.cpu += index->memoryUsage();
+        }
+
+        const Bucket *bucket = parsed.second.bucket.get();
+        if (!bucket || !parsed.second.fingerprint.bucket_desc) {
+            continue;
+        }
+
+        const MemoryUsage bucketUsage = bucket->memoryUsage();
+        const StyleBucketRender &render = parsed.second.fingerprint.bucket_desc->render;
+        if (render.is<StyleBucketSymbol>()) {
+            usage.buckets["symbol"] += bucketUsage;
+        } else if (render.is<StyleBucketLine>()) {
+            usage.buckets["line"] += bucketUsage;
+        } else if (render.is<StyleBucketCircle>()) {
+            usage.buckets["circle"] += bucketUsage;
+        } else {
+            usage.buckets["fill"] += bucketUsage;
+        }
+    }
+    return usage;
+}
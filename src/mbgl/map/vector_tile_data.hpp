@@ -5,9 +5,12 @@
 #include <mbgl/map/tile_data.hpp>
 #include <mbgl/geometry/elements_buffer.hpp>
 #include <mbgl/geometry/fill_buffer.hpp>
-#include <mbgl/geometry/icon_buffer.hpp>
 #include <mbgl/geometry/line_buffer.hpp>
+#include <mbgl/geometry/circle_buffer.hpp>
 #include <mbgl/geometry/text_buffer.hpp>
+#include <mbgl/geometry/icon_buffer.hpp>
+#include <mbgl/geometry/symbol_instance_buffer.hpp>
+#include <mbgl/geometry/symbol_placement_buffer.hpp>
 
 #include <iosfwd>
 #include <memory>
@@ -20,12 +23,144 @@ class Painter;
 class SourceInfo;
 class StyleLayer;
 class TileParser;
+class VectorTile;
 class GlyphAtlas;
 class GlyphStore;
 class SpriteAtlas;
 class Sprite;
 class TexturePool;
 class Style;
+class StyleBucket;
+class CollisionIndex;
+class BucketCache;
+class FeatureIndex;
+struct RenderedFeature;
+
+// Vertex and element buffers shared by the buckets created in one parsing pass.
+// Buffers can't grow after they were uploaded, so buckets that are rebuilt on a
+// reparse go into a new set of buffers, while kept buckets retain their old one.
+class TileBuffers : private util::noncopyable {
+public:
+    // Retained buffers keep their elements after the upload, to upload them again into a new GL
+    // context.
+    inline TileBuffers(bool retained = false)
+        : instanced(gl::isInstancingSupported()),
+          triangleElementsBuffer(gl::isElementIndexUintSupported),
+          iconElementsBuffer(gl::isElementIndexUintSupported),
+          lineElementsBuffer(gl::isElementIndexUintSupported) {
+        if (retained) {
+            fillVertexBuffer.retain();
+            fillColorBuffer.retain();
+            fillFringeBuffer.retain();
+            lineVertexBuffer.retain();
+            circleVertexBuffer.retain();
+            textVertexBuffer.retain();
+            iconVertexBuffer.retain();
+            triangleElementsBuffer.retain();
+            iconElementsBuffer.retain();
+            lineElementsBuffer.retain();
+            textInstanceBuffer.retain();
+            iconInstanceBuffer.retain();
+        }
+    }
+
+    // Whether symbols and circles go into instance buffers instead of vertices and elements.
+    const bool instanced;
+
+    FillVertexBuffer fillVertexBuffer;
+    FillColorBuffer fillColorBuffer;
+    FillFringeBuffer fillFringeBuffer;
+    LineVertexBuffer lineVertexBuffer;
+    CircleVertexBuffer circleVertexBuffer;
+    TextVertexBuffer textVertexBuffer;
+    IconVertexBuffer iconVertexBuffer;
+
+    // Used by fill, line, circle and text geometry.
+    TriangleElementsBuffer triangleElementsBuffer;
+    TriangleElementsBuffer iconElementsBuffer;
+    LineElementsBuffer lineElementsBuffer;
+
+    SymbolInstanceBuffer textInstanceBuffer;
+    SymbolInstanceBuffer iconInstanceBuffer;
+
+    // The placement of the text and icon vertices or instances, which changes without them.
+    SymbolPlacementBuffer textPlacementBuffer;
+    SymbolPlacementBuffer iconPlacementBuffer;
+
+    inline MemoryUsage memoryUsage() const {
+        return fillVertexBuffer.memoryUsage() + fillColorBuffer.memoryUsage() +
+               fillFringeBuffer.memoryUsage() +
+               lineVertexBuffer.memoryUsage() + textVertexBuffer.memoryUsage() +
+               iconVertexBuffer.memoryUsage() + triangleElementsBuffer.memoryUsage() +
+               iconElementsBuffer.memoryUsage() + lineElementsBuffer.memoryUsage() +
+               textInstanceBuffer.memoryUsage() + iconInstanceBuffer.memoryUsage() +
+               textPlacementBuffer.memoryUsage() + iconPlacementBuffer.memoryUsage() +
+               circleVertexBuffer.memoryUsage();
+    }
+
+    // Uploads at most /maxBytes/ (0 = all) of the buffers; returns the number of bytes uploaded.
+    size_t upload(size_t maxBytes);
+
+    // Whether any of the buffers went away with a lost GL context and can't be uploaded again.
+    inline bool isLost() const {
+        return fillVertexBuffer.isLost() || fillColorBuffer.isLost() ||
+               fillFringeBuffer.isLost() ||
+               lineVertexBuffer.isLost() || textVertexBuffer.isLost() ||
+               iconVertexBuffer.isLost() || triangleElementsBuffer.isLost() ||
+               iconElementsBuffer.isLost() || lineElementsBuffer.isLost() ||
+               textInstanceBuffer.isLost() || iconInstanceBuffer.isLost() ||
+               textPlacementBuffer.isLost() || iconPlacementBuffer.isLost() ||
+               circleVertexBuffer.isLost();
+    }
+
+    inline bool isUploaded() const {
+        return fillVertexBuffer.isUploaded() && fillColorBuffer.isUploaded() &&
+               fillFringeBuffer.isUploaded() &&
+               lineVertexBuffer.isUploaded() && textVertexBuffer.isUploaded() &&
+               iconVertexBuffer.isUploaded() && triangleElementsBuffer.isUploaded() &&
+               iconElementsBuffer.isUploaded() && lineElementsBuffer.isUploaded() &&
+               textInstanceBuffer.isUploaded() && iconInstanceBuffer.isUploaded() &&
+               textPlacementBuffer.isUploaded() && iconPlacementBuffer.isUploaded() &&
+               circleVertexBuffer.isUploaded();
+    }
+};
+
+// Records the inputs a bucket was created from. A reparse keeps all buckets whose
+// fingerprint is unchanged.
+struct BucketFingerprint {
+    util::ptr<StyleBucket> bucket_desc;
+
+    // Only set for buckets that place icons.
+    util::ptr<Sprite> sprite;
+
+    // The tile data the bucket was parsed from.
+    std::shared_ptr<const std::string> data;
+
+    inline bool operator==(const BucketFingerprint& rhs) const {
+        return bucket_desc == rhs.bucket_desc && sprite == rhs.sprite && data == rhs.data;
+    }
+
+    inline bool operator!=(const BucketFingerprint& rhs) const {
+        return !operator==(rhs);
+    }
+};
+
+// Nanoseconds that a parse spent building each type of bucket. Symbols include their placement.
+// The time of buckets that were built on other threads is added up, too.
+struct BucketParseTimes {
+    timestamp fill = 0;
+    timestamp line = 0;
+    timestamp circle = 0;
+    timestamp symbol = 0;
+
+    inline BucketParseTimes &operator+=(const BucketParseTimes &rhs) {
+        fill += rhs.fill;
+        line += rhs.line;
+        circle += rhs.circle;
+        symbol += rhs.symbol;
+        return *this;
+    }
+};
 
 class VectorTileData : public TileData {
     friend class TileParser;
@@ -36,27 +171,135 @@ public:
                    GlyphAtlas&, GlyphStore&,
                    SpriteAtlas&, util::ptr<Sprite>,
                    TexturePool&,
-                   const SourceInfo&);
+                   const SourceInfo&,
+                   util::ptr<CollisionIndex>);
     ~VectorTileData();
 
     virtual void parse();
-    virtual void render(Painter &painter, util::ptr<StyleLayer> layer_desc, const mat4 &matrix);
+    virtual bool afterParse();
+    virtual void render(Painter &painter, const util::ptr<StyleLayer> &layer_desc, const mat4 &matrix);
     virtual bool hasData(StyleLayer const& layer_desc) const;
+    virtual TileMemoryUsage memoryUsage() const;
+    virtual size_t upload(size_t maxBytes);
+    virtual bool needsUpload() const;
+    // Also waits for the reparses that bring in missing glyphs and deferred symbols.
+    virtual bool isComplete() const;
+
+    // Switches this tile over to a new sprite. Returns true if any of the buckets
+    // depends on the sprite and the tile needs to be reparsed. Must be called on
+    // the main thread.
+    bool setSprite(util::ptr<Sprite>);
+
+    // Returns true if the tile was parsed without its symbol buckets because some glyphs weren't
+    // loaded, and glyphs arrived since; the tile needs to be reparsed. Must be called on the main
+    // thread.
+    bool checkGlyphs();
+
+    // Keeps the fill and line buckets of this tile on disk. Must be called before the first parse.
+    inline void setBucketCache(const util::ptr<BucketCache> &cache) {
+        bucketCache = cache;
+    }
+
+    // Returns true if the initial parse left out the symbol buckets; the tile needs to be reparsed
+    // to add them. Must be called on the main thread.
+    bool checkDeferredSymbols();
+
+    // Keeps the geometry on the CPU side after the upload. Must be called before the first parse.
+    inline void setBufferRetention(bool retain) {
+        retainBuffers = retain;
+    }
+
+    // Surrounds the fills with an antialiasing fringe. Must be called before the first parse.
+    inline void setFillFringes(bool enabled) {
+        fillFringes = enabled;
+    }
+
+    // Lets idle threads of the worker help building the buckets of a parse. Must be called before
+    // the first parse, and the worker must outlive the parses.
+    inline void setParseWorker(uv::worker *worker) {
+        parseWorker = worker;
+    }
+
+    // Returns true if the layout of a layer changed since the last parse; the tile needs to be
+    // reparsed to rebuild its buckets. Must be called on the main thread.
+    bool checkLayout();
+
+    // Returns true if the GL context was lost and the buckets have to be built again; retained
+    // buckets are uploaded again instead. Must be called on the main thread.
+    bool checkContextLost();
+
+    // Indexes the layers of the data while it downloads, and decodes the ones that the style uses
+    // on the worker. Their buckets are still built once the data is complete.
+    virtual bool receivesData() const { return true; }
+    virtual void receiveData(uv::worker&, const std::string &data, size_t offset);
+
+    virtual bool replaceData(const std::shared_ptr<const std::string> &);
+    virtual void releaseMemory();
+
+    // Appends the features that the layer draws within /radius/ of a point, in tile coordinates.
+    // Lines and points are hit within the radius of their geometry, regardless of their width or
+    // icon. Must be called on the main thread.
+    void queryFeatures(const StyleLayer &layer_desc, double x, double y, double radius,
+                       std::vector<RenderedFeature> &result) const;
 
 protected:
-    // Holds the actual geometries in this tile.
-    FillVertexBuffer fillVertexBuffer;
-    LineVertexBuffer lineVertexBuffer;
-    IconVertexBuffer iconVertexBuffer;
-    TextVertexBuffer textVertexBuffer;
+    struct ParsedBucket {
+        BucketFingerprint fingerprint;
 
-    TriangleElementsBuffer triangleElementsBuffer;
-    LineElementsBuffer lineElementsBuffer;
-    PointElementsBuffer pointElementsBuffer;
+        // Holds the actual geometries of this bucket.
+        util::ptr<TileBuffers> buffers;
+
+        // Empty if the tile doesn't contain any data for this bucket. Shared with tiles that have
+        // the same data.
+        util::ptr<Bucket> bucket;
+
+        // The features of the parse that built the bucket. A later parse that rebuilds other
+        // buckets doesn't change it, so the bucket only finds its own features in it.
+        util::ptr<const FeatureIndex> featureIndex;
+    };
 
-    // Holds the buckets of this tile.
-    // They contain the location offsets in the buffers stored above
-    std::unordered_map<std::string, std::unique_ptr<Bucket>> buckets;
+    void commitBuckets();
+
+    // Whether a reparse finished and its buckets wait for their upload. Only valid on the main
+    // thread.
+    inline bool hasPendingBuckets() const {
+        return !reparsing && !pendingBuckets.empty();
+    }
+
+    // The decoded layer index of data. It is kept between reparses so that the
+    // tile doesn't have to be decoded again, and shared with the tiles of other
+    // maps that received the same data.
+    util::ptr<VectorTile> vector_data;
+
+    // The layers that arrived while the data is downloading. The initial parse takes it over as
+    // vector_data if it matches the data.
+    util::ptr<VectorTile> streamedData;
+
+    // Hash of data, to find the buckets of tiles with the same data. Set by the parse that decodes
+    // vector_data.
+    size_t dataHash = 0;
+
+    // Size of vector_data, which may still be used by a parse when the main thread asks.
+    std::atomic<size_t> decodedBytes { 0 };
+
+    // Holds the buckets of this tile, keyed by bucket name.
+    std::unordered_map<std::string, ParsedBucket> buckets;
+
+    // Buckets that were rebuilt by a reparse. They are swapped in on the main
+    // thread once they are uploaded, so that rendering never observes a
+    // half-updated tile.
+    std::unordered_map<std::string, ParsedBucket> pendingBuckets;
+    bool reparsing = false;
+
+    // Data that replaceData() received while a parse was running.
+    std::shared_ptr<const std::string> nextData;
+
+    // The glyph store generation when the last parse started, if that parse left out the symbol
+    // buckets because of missing glyphs; 0 otherwise.
+    uint64_t glyphGeneration = 0;
+
+    // Whether the last parse left out the symbol buckets so that the tile could be drawn sooner.
+    bool symbolsDeferred = false;
 
     GlyphAtlas& glyphAtlas;
     GlyphStore& glyphStore;
@@ -65,7 +308,28 @@ protected:
     TexturePool& texturePool;
     util::ptr<Style> style;
 
+    // The layout generation of the style when the last parse was started.
+    uint64_t layoutGeneration;
+
+    util::ptr<BucketCache> bucketCache;
+
+    bool retainBuffers = false;
+    bool fillFringes = false;
+    uv::worker *parseWorker = nullptr;
+
+    // The generation of the GL context that the buckets were last checked against.
+    uint32_t contextGeneration;
+
+    // Shared with the other tiles of the source, so that labels are placed across tile edges.
+    const util::ptr<CollisionIndex> collisionIndex;
+
 public:
+    // Of the last parse. Written by parse(); only read it once afterParse() ran.
+    BucketParseTimes parseTimes;
+
+    // The number of zoom levels this tile is used for. Tiles at the source's maximum zoom level are
+    // scaled up to the map's maximum zoom level, so their placement covers all of those levels and
+    // doesn't change while zooming.
     const float depth;
 };
 
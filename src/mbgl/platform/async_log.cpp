@@ -0,0 +1,162 @@
+#include <mbgl/platform/async_log.hpp>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace mbgl {
+
+const size_t AsyncLogBackend::maxLength;
+const size_t AsyncLogBackend::capacity;
+
+AsyncLogBackend::AsyncLogBackend(std::unique_ptr<LogBackend> backend_, uint32_t burst_)
+    : backend(std::move(backend_)),
+      burst(burst_),
+      entries(new Entry[capacity]) {
+    static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+    for (size_t i = 0; i < capacity; i++) {
+        entries[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    thread = std::thread([this] { run(); });
+}
+
+AsyncLogBackend::~AsyncLogBackend() {
+    running = false;
+    wakeup.notify_one();
+    thread.join();
+}
+
+void AsyncLogBackend::record(EventSeverity severity, Event event, const std::string &msg) {
+    if (admit(severity, event)) {
+        push(severity, event, false, 0, msg.c_str());
+    }
+}
+
+void AsyncLogBackend::record(EventSeverity severity, Event event, const char* format, ...) {
+    if (admit(severity, event)) {
+        char message[maxLength];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(message, maxLength, format, args);
+        va_end(args);
+        push(severity, event, false, 0, message);
+    }
+}
+
+void AsyncLogBackend::record(EventSeverity severity, Event event, int64_t code) {
+    if (admit(severity, event)) {
+        push(severity, event, true, code, "");
+    }
+}
+
+void AsyncLogBackend::record(EventSeverity severity, Event event, int64_t code, const std::string &msg) {
+    if (admit(severity, event)) {
+        push(severity, event, true, code, msg.c_str());
+    }
+}
+
+void AsyncLogBackend::flush() {
+    const size_t target = head.load(std::memory_order_acquire);
+    while (written.load(std::memory_order_acquire) < target) {
+        wakeup.notify_one();
+        std::this_thread::yield();
+    }
+}
+
+bool AsyncLogBackend::admit(EventSeverity severity, Event event) {
+    if (severity == EventSeverity::Error) {
+        return true;
+    }
+
+    RateLimit &limit = limits[static_cast<uint8_t>(event)];
+    const timestamp second = util::now() / 1_second;
+    timestamp window = limit.window.load(std::memory_order_relaxed);
+    if (window != second && limit.window.compare_exchange_strong(window, second)) {
+        // Threads that still count in the previous window may let a few more messages through.
+        limit.count = 0;
+        const uint64_t suppressed = limit.suppressed.exchange(0);
+        if (suppressed) {
+            char message[maxLength];
+            snprintf(message, maxLength, "%llu messages were suppressed",
+                     static_cast<unsigned long long>(suppressed));
+            push(EventSeverity::Warning, event, false, 0, message);
+        }
+    }
+
+    if (limit.count.fetch_add(1, std::memory_order_relaxed) < burst) {
+        return true;
+    }
+
+    limit.suppressed++;
+    droppedCount++;
+    return false;
+}
+
+void AsyncLogBackend::push(EventSeverity severity, Event event, bool hasCode, int64_t code, const char *message) {
+    size_t position = head.load(std::memory_order_relaxed);
+    Entry *entry;
+    while (true) {
+        entry = &entries[position & (capacity - 1)];
+        const size_t sequence = entry->sequence.load(std::memory_order_acquire);
+        if (sequence == position) {
+            if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (sequence < position) {
+            // The background thread hasn't written the message that used this entry yet.
+            droppedCount++;
+            return;
+        } else {
+            position = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    entry->severity = severity;
+    entry->event = event;
+    entry->hasCode = hasCode;
+    entry->code = code;
+    std::strncpy(entry->message, message, maxLength - 1);
+    entry->message[maxLength - 1] = '\0';
+    entry->sequence.store(position + 1, std::memory_order_release);
+
+    wakeup.notify_one();
+}
+
+bool AsyncLogBackend::pop() {
+    Entry &entry = entries[tail & (capacity - 1)];
+    if (entry.sequence.load(std::memory_order_acquire) != tail + 1) {
+        return false;
+    }
+
+    if (!entry.hasCode) {
+        backend->record(entry.severity, entry.event, std::string(entry.message));
+    } else if (entry.message[0]) {
+        backend->record(entry.severity, entry.event, entry.code, std::string(entry.message));
+    } else {
+        backend->record(entry.severity, entry.event, entry.code);
+    }
+
+    entry.sequence.store(tail + capacity, std::memory_order_release);
+    tail++;
+    written.store(tail, std::memory_order_release);
+    return true;
+}
+
+void AsyncLogBackend::run() {
+    while (true) {
+        while (pop());
+
+        if (!running) {
+            // Messages logged while we were stopping.
+            while (pop());
+            return;
+        }
+
+        // Loggers notify without holding the mutex, so a notification may get lost between the
+        // last pop() and the wait. The timeout bounds how late such a message is written.
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeup.wait_for(lock, std::chrono::milliseconds(50));
+    }
+}
+
+}
@@ -1,6 +1,7 @@
 #include <mbgl/platform/gl.hpp>
 #include <mbgl/platform/log.hpp>
 
+#include <cstring>
 #include <iostream>
 
 
@@ -70,10 +71,83 @@ PFNGLDELETEVERTEXARRAYSPROC DeleteVertexArrays = nullptr;
 PFNGLGENVERTEXARRAYSPROC GenVertexArrays = nullptr;
 PFNGLISVERTEXARRAYPROC IsVertexArray = nullptr;
 
+PFNGLVERTEXATTRIBDIVISORPROC VertexAttribDivisor = nullptr;
+PFNGLDRAWARRAYSINSTANCEDPROC DrawArraysInstanced = nullptr;
+
+bool isInstancingSupported() {
+    return VertexAttribDivisor && DrawArraysInstanced && BindVertexArray && GenVertexArrays;
+}
+
+PFNGLGETPROGRAMBINARYPROC GetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC ProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC ProgramParameteri = nullptr;
+
+PFNGLMAPBUFFERRANGEPROC MapBufferRange = nullptr;
+PFNGLUNMAPBUFFERPROC UnmapBuffer = nullptr;
+
+bool isPixelBufferObjectSupported() {
+    return MapBufferRange && UnmapBuffer;
+}
+
+PFNGLGENQUERIESPROC GenQueries = nullptr;
+PFNGLDELETEQUERIESPROC DeleteQueries = nullptr;
+PFNGLBEGINQUERYPROC BeginQuery = nullptr;
+PFNGLENDQUERYPROC EndQuery = nullptr;
+PFNGLGETQUERYOBJECTUIVPROC GetQueryObjectuiv = nullptr;
+PFNGLGETQUERYOBJECTUI64VPROC GetQueryObjectui64v = nullptr;
+bool isTimerQueryDisjointSupported = false;
+bool isSamplesQuerySupported = false;
+
+bool isTimerQuerySupported() {
+    return GenQueries && DeleteQueries && BeginQuery && EndQuery && GetQueryObjectuiv && GetQueryObjectui64v;
+}
+
+float maxTextureAnisotropy = 0;
+
 bool isPackedDepthStencilSupported = false;
 
 bool isDepth24Supported = false;
 
+bool isElementIndexUintSupported = false;
+
+bool isS3TCSupported = false;
+bool isETC1Supported = false;
+bool isETC2Supported = false;
+bool isASTCSupported = false;
+
+void detectCompressedTextureSupport(const std::string &extensions) {
+    const auto has = [&extensions](const char *name) {
+        return extensions.find(name) != std::string::npos;
+    };
+    isS3TCSupported = has("GL_EXT_texture_compression_s3tc");
+    isETC1Supported = has("GL_OES_compressed_ETC1_RGB8_texture");
+    // ETC2 is part of OpenGL ES 3 and has no extension of its own there.
+    const char *version = reinterpret_cast<const char *>(MBGL_CHECK_ERROR(glGetString(GL_VERSION)));
+    isETC2Supported = has("GL_ARB_ES3_compatibility") ||
+                      (version && std::strncmp(version, "OpenGL ES 3", 11) == 0);
+    isASTCSupported = has("GL_KHR_texture_compression_astc_ldr");
+}
+
+bool isCompressedFormatSupported(GLenum format) {
+    switch (format) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            return isS3TCSupported;
+        case GL_ETC1_RGB8_OES:
+            // ETC2 decoders read ETC1 data as well.
+            return isETC1Supported || isETC2Supported;
+        case GL_COMPRESSED_RGB8_ETC2:
+        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+            return isETC2Supported;
+        default:
+            return isASTCSupported && format >= GL_COMPRESSED_RGBA_ASTC_4x4_KHR &&
+                   format <= GL_COMPRESSED_RGBA_ASTC_12x12_KHR;
+    }
+}
+
 void checkError(const char *cmd, const char *file, int line) {
     const GLenum err = glGetError();
     if (err != GL_NO_ERROR) {
@@ -0,0 +1,277 @@
+#include <mbgl/platform/gl_state.hpp>
+
+#include <atomic>
+
+#include <pthread.h>
+
+namespace mbgl {
+namespace gl {
+
+State::State() {}
+
+State &State::Get() {
+    // Like the class dictionary, we're using the pthread functions directly since libuv 0.10
+    // doesn't have uv_key_* yet.
+    static pthread_once_t store_once = PTHREAD_ONCE_INIT;
+    static pthread_key_t store_key;
+
+    pthread_once(&store_once, []() {
+        pthread_key_create(&store_key, [](void *ptr) {
+            delete reinterpret_cast<State *>(ptr);
+        });
+    });
+
+    State *ptr = reinterpret_cast<State *>(pthread_getspecific(store_key));
+    if (ptr == nullptr) {
+        ptr = new State();
+        pthread_setspecific(store_key, ptr);
+    }
+
+    return *ptr;
+}
+
+void State::reset() {
+    blend.known = false;
+    depthTest.known = false;
+    stencilTest.known = false;
+    scissorTest.known = false;
+    blendFuncValue.known = false;
+    colorMaskValue.known = false;
+    stencilFuncValue.known = false;
+    stencilMaskValue.known = false;
+    stencilOpValue.known = false;
+    scissorValue.known = false;
+    depthMaskValue.known = false;
+    depthRangeValue.known = false;
+    lineWidthValue.known = false;
+    clearColorValue.known = false;
+    clearDepthValue.known = false;
+    clearStencilValue.known = false;
+    program.known = false;
+    activeTextureValue.known = false;
+    for (Value<GLuint> &texture : textures) {
+        texture.known = false;
+    }
+    arrayBuffer.known = false;
+    elementArrayBuffer.known = false;
+    vertexArray.known = false;
+}
+
+namespace {
+std::atomic<uint32_t> contextGeneration { 0 };
+}
+
+void State::contextLost() {
+    contextGeneration++;
+}
+
+uint32_t State::getContextGeneration() {
+    return contextGeneration;
+}
+
+State::Stats State::takeStats() {
+    const Stats result = stats;
+    stats = Stats();
+    return result;
+}
+
+template <typename T>
+bool State::change(Value<T> &current, const T &value) {
+    stats.calls++;
+    if (current.known && current.value == value) {
+        stats.redundant++;
+        return false;
+    }
+    current.value = value;
+    current.known = true;
+    return true;
+}
+
+void State::enable(GLenum capability, bool enabled) {
+    Value<bool> *current = capability == GL_BLEND ? &blend :
+                           capability == GL_DEPTH_TEST ? &depthTest :
+                           capability == GL_STENCIL_TEST ? &stencilTest :
+                           capability == GL_SCISSOR_TEST ? &scissorTest : nullptr;
+    if (!current) {
+        stats.calls++;
+    } else if (!change(*current, enabled)) {
+        return;
+    }
+
+    if (enabled) {
+        MBGL_CHECK_ERROR(glEnable(capability));
+    } else {
+        MBGL_CHECK_ERROR(glDisable(capability));
+    }
+}
+
+void State::blendFunc(GLenum sfactor, GLenum dfactor) {
+    if (change(blendFuncValue, std::make_tuple(sfactor, dfactor))) {
+        MBGL_CHECK_ERROR(glBlendFunc(sfactor, dfactor));
+    }
+}
+
+void State::colorMask(bool red, bool green, bool blue, bool alpha) {
+    if (change(colorMaskValue, std::array<bool, 4> {{ red, green, blue, alpha }})) {
+        MBGL_CHECK_ERROR(glColorMask(red, green, blue, alpha));
+    }
+}
+
+void State::stencilFunc(GLenum func, GLint ref, GLuint mask) {
+    if (change(stencilFuncValue, std::make_tuple(func, ref, mask))) {
+        MBGL_CHECK_ERROR(glStencilFunc(func, ref, mask));
+    }
+}
+
+void State::stencilMask(GLuint mask) {
+    if (change(stencilMaskValue, mask)) {
+        MBGL_CHECK_ERROR(glStencilMask(mask));
+    }
+}
+
+void State::stencilOp(GLenum sfail, GLenum dpfail, GLenum dppass) {
+    if (change(stencilOpValue, std::make_tuple(sfail, dpfail, dppass))) {
+        MBGL_CHECK_ERROR(glStencilOp(sfail, dpfail, dppass));
+    }
+}
+
+void State::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (change(scissorValue, std::array<GLint, 4> {{ x, y, width, height }})) {
+        MBGL_CHECK_ERROR(glScissor(x, y, width, height));
+    }
+}
+
+void State::depthMask(bool flag) {
+    if (change(depthMaskValue, flag)) {
+        MBGL_CHECK_ERROR(glDepthMask(flag ? GL_TRUE : GL_FALSE));
+    }
+}
+
+void State::depthRange(float near, float far) {
+    if (change(depthRangeValue, std::array<float, 2> {{ near, far }})) {
+        MBGL_CHECK_ERROR(glDepthRange(near, far));
+    }
+}
+
+void State::lineWidth(float width) {
+    if (change(lineWidthValue, width)) {
+        MBGL_CHECK_ERROR(glLineWidth(width));
+    }
+}
+
+void State::clearColor(float red, float green, float blue, float alpha) {
+    if (change(clearColorValue, std::array<float, 4> {{ red, green, blue, alpha }})) {
+        MBGL_CHECK_ERROR(glClearColor(red, green, blue, alpha));
+    }
+}
+
+void State::clearDepth(float depth) {
+    if (change(clearDepthValue, depth)) {
+        MBGL_CHECK_ERROR(glClearDepth(depth));
+    }
+}
+
+void State::clearStencil(GLint s) {
+    if (change(clearStencilValue, s)) {
+        MBGL_CHECK_ERROR(glClearStencil(s));
+    }
+}
+
+void State::useProgram(GLuint program_) {
+    if (change(program, program_)) {
+        MBGL_CHECK_ERROR(glUseProgram(program_));
+    }
+}
+
+void State::activeTexture(GLenum texture) {
+    if (change(activeTextureValue, texture)) {
+        MBGL_CHECK_ERROR(glActiveTexture(texture));
+    }
+}
+
+void State::bindTexture(GLuint texture) {
+    // Until a texture unit was activated through the tracker, we don't know which one binds go to.
+    const size_t unit = activeTextureValue.known ? activeTextureValue.value - GL_TEXTURE0 : textureUnits;
+    if (unit >= textureUnits) {
+        stats.calls++;
+    } else if (!change(textures[unit], texture)) {
+        return;
+    }
+    MBGL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
+}
+
+void State::bindBuffer(GLenum target, GLuint buffer) {
+    Value<GLuint> *current = target == GL_ARRAY_BUFFER ? &arrayBuffer :
+                             target == GL_ELEMENT_ARRAY_BUFFER ? &elementArrayBuffer : nullptr;
+    if (!current) {
+        stats.calls++;
+    } else if (!change(*current, buffer)) {
+        return;
+    }
+    MBGL_CHECK_ERROR(glBindBuffer(target, buffer));
+}
+
+void State::bindVertexArray(GLuint array) {
+    if (change(vertexArray, array)) {
+        MBGL_CHECK_ERROR(gl::BindVertexArray(array));
+        elementArrayBuffer.known = false;
+    }
+}
+
+void State::drawArrays(GLenum mode, GLint first, GLsizei count) {
+    stats.draws++;
+    gl::State::Get().drawArrays(mode, first, count);
+}
+
+void State::drawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices) {
+    stats.draws++;
+    gl::State::Get().drawElements(mode, count, type, indices);
+}
+
+void State::deleteTextures(GLsizei n, const GLuint *ids) {
+    // Deleting a bound texture binds 0 in its place.
+    for (GLsizei i = 0; i < n; i++) {
+        for (Value<GLuint> &texture : textures) {
+            if (texture.known && texture.value == ids[i]) {
+                texture.value = 0;
+            }
+        }
+    }
+    MBGL_CHECK_ERROR(glDeleteTextures(n, ids));
+}
+
+void State::deleteBuffers(GLsizei n, const GLuint *ids) {
+    for (GLsizei i = 0; i < n; i++) {
+        if (arrayBuffer.known && arrayBuffer.value == ids[i]) {
+            arrayBuffer.value = 0;
+        }
+        if (elementArrayBuffer.known && elementArrayBuffer.value == ids[i]) {
+            elementArrayBuffer.value = 0;
+        }
+    }
+    MBGL_CHECK_ERROR(glDeleteBuffers(n, ids));
+}
+
+void State::deleteVertexArrays(GLsizei n, const GLuint *ids) {
+    // Deleting the bound vertex array object binds the default one, which has its own element
+    // array binding.
+    for (GLsizei i = 0; i < n; i++) {
+        if (vertexArray.known && vertexArray.value == ids[i]) {
+            vertexArray.value = 0;
+            elementArrayBuffer.known = false;
+        }
+    }
+    MBGL_CHECK_ERROR(gl::DeleteVertexArrays(n, ids));
+}
+
+void State::deleteProgram(GLuint program_) {
+    // A program that is in use stays current until another one is used, but its name may be handed
+    // out again right away.
+    if (program.known && program.value == program_) {
+        program.known = false;
+    }
+    MBGL_CHECK_ERROR(glDeleteProgram(program_));
+}
+
+}
+}
@@ -0,0 +1,127 @@
+#ifndef MBGL_PLATFORM_GL_STATE
+#define MBGL_PLATFORM_GL_STATE
+
+#include <mbgl/platform/gl.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+
+namespace mbgl {
+namespace gl {
+
+// Remembers the GL state that the renderer sets, so that setting a value that is already current
+// doesn't reach the driver. There is one tracker per thread, since that's where a GL context is
+// current. Anything that changes the state without going through the tracker, like another
+// context or the platform drawing its own overlay, must be followed by reset().
+class State : private util::noncopyable {
+public:
+    struct Stats {
+        // Calls that went through the tracker, and those that it dropped because the value was
+        // already set.
+        size_t calls = 0;
+        size_t redundant = 0;
+        // Draw calls, which don't change any state.
+        size_t draws = 0;
+    };
+
+    static State &Get();
+
+    // Forgets all values, so that the next change of each of them goes to GL.
+    void reset();
+
+    // Records that a GL context was destroyed. Buffers and vertex arrays that were created before
+    // are created again when they are used next. The map may be restarted on another thread, so
+    // this counts for all threads; it may be called on any of them.
+    static void contextLost();
+
+    // Counts the lost contexts. GL objects remember it when they get their name, so that they can
+    // tell whether the name is still theirs.
+    static uint32_t getContextGeneration();
+
+    // Returns the counts since the last call, e.g. for the last frame.
+    Stats takeStats();
+
+    // GL_BLEND, GL_DEPTH_TEST, GL_STENCIL_TEST or GL_SCISSOR_TEST.
+    void enable(GLenum capability, bool enabled);
+    void blendFunc(GLenum sfactor, GLenum dfactor);
+    void colorMask(bool red, bool green, bool blue, bool alpha);
+    void stencilFunc(GLenum func, GLint ref, GLuint mask);
+    void stencilMask(GLuint mask);
+    void stencilOp(GLenum sfail, GLenum dpfail, GLenum dppass);
+    void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+    void depthMask(bool flag);
+    void depthRange(float near, float far);
+    void lineWidth(float width);
+    void clearColor(float red, float green, float blue, float alpha);
+    void clearDepth(float depth);
+    void clearStencil(GLint s);
+    void useProgram(GLuint program);
+
+    void activeTexture(GLenum texture);
+    // Binds a GL_TEXTURE_2D to the active texture unit.
+    void bindTexture(GLuint texture);
+
+    // GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER. The element array binding belongs to the vertex
+    // array object, so it is forgotten whenever another one is bound.
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindVertexArray(GLuint array);
+
+    // Pass straight through to GL; they only go through the tracker to be counted.
+    void drawArrays(GLenum mode, GLint first, GLsizei count);
+    void drawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices);
+
+    // GL reuses the names of deleted objects, so the tracker has to forget them.
+    void deleteTextures(GLsizei n, const GLuint *textures);
+    void deleteBuffers(GLsizei n, const GLuint *buffers);
+    void deleteVertexArrays(GLsizei n, const GLuint *arrays);
+    void deleteProgram(GLuint program);
+
+private:
+    State();
+
+    // A value that is known once it was set through the tracker.
+    template <typename T>
+    struct Value {
+        T value;
+        bool known = false;
+    };
+
+    // Returns whether the value has to be passed on to GL, and records it.
+    template <typename T>
+    bool change(Value<T> &current, const T &value);
+
+    // Texture units that bindTexture() keeps track of; binds to other units always go to GL.
+    static const size_t textureUnits = 8;
+
+    Value<bool> blend;
+    Value<bool> depthTest;
+    Value<bool> stencilTest;
+    Value<bool> scissorTest;
+    Value<std::tuple<GLenum, GLenum>> blendFuncValue;
+    Value<std::array<bool, 4>> colorMaskValue;
+    Value<std::tuple<GLenum, GLint, GLuint>> stencilFuncValue;
+    Value<GLuint> stencilMaskValue;
+    Value<std::tuple<GLenum, GLenum, GLenum>> stencilOpValue;
+    Value<std::array<GLint, 4>> scissorValue;
+    Value<bool> depthMaskValue;
+    Value<std::array<float, 2>> depthRangeValue;
+    Value<float> lineWidthValue;
+    Value<std::array<float, 4>> clearColorValue;
+    Value<float> clearDepthValue;
+    Value<GLint> clearStencilValue;
+    Value<GLuint> program;
+    Value<GLenum> activeTextureValue;
+    std::array<Value<GLuint>, textureUnits> textures;
+    Value<GLuint> arrayBuffer;
+    Value<GLuint> elementArrayBuffer;
+    Value<GLuint> vertexArray;
+
+    Stats stats;
+};
+
+}
+}
+
+#endif
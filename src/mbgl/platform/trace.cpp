@@ -0,0 +1,7 @@
+#include <mbgl/platform/trace.hpp>
+
+namespace mbgl {
+
+std::unique_ptr<TraceBackend> Trace::Backend;
+
+}
@@ -3,6 +3,7 @@
 
 #include <mbgl/map/tile.hpp>
 #include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/memory_usage.hpp>
 
 #include <string>
 
@@ -13,10 +14,18 @@ class StyleLayer;
 
 class Bucket : private util::noncopyable {
 public:
-    virtual void render(Painter& painter, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix) = 0;
+    virtual void render(Painter& painter, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix) = 0;
     virtual bool hasData() const = 0;
     virtual ~Bucket() {}
 
+    // Number of bytes this bucket's geometry takes up, including its part of the buffers that it
+    // shares with the other buckets of the tile.
+    virtual MemoryUsage memoryUsage() const = 0;
+
+    // Uploads at most /maxBytes/ (0 = all) of the buffers and textures that this bucket doesn't
+    // share with other buckets. Returns the number of bytes uploaded.
+    virtual size_t upload(size_t /* maxBytes */) { return 0; }
+    virtual bool isUploaded() const { return true; }
 };
 
 }
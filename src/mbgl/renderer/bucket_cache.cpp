@@ -0,0 +1,293 @@
+#include <mbgl/renderer/bucket_cache.hpp>
+#include <mbgl/style/style_bucket.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <set>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mbgl {
+
+namespace {
+
+const char magic[4] = { 'M', 'B', 'G', 'B' };
+
+// Bump when the way buckets build their geometry changes.
+const uint32_t version = 2;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+    BucketCache::TileKey key;
+};
+
+struct Record {
+    uint64_t layoutHash;
+    uint32_t triangleGroups;
+    uint32_t lineGroups;
+    uint32_t vertexBytes;
+    uint32_t colorBytes;
+    uint32_t triangleBytes;
+    uint32_t lineBytes;
+    // Where the groups start, counted from the start of the file. The buffer contents follow them.
+    uint32_t offset;
+    uint32_t fringeBytes;
+};
+
+static_assert(sizeof(BucketCache::TileKey) == 32, "bucket cache key must be packed");
+static_assert(sizeof(Header) == 48, "bucket cache header must be packed");
+static_assert(sizeof(Record) == 40, "bucket cache record must be packed");
+static_assert(sizeof(CachedBucket::Group) == 20, "bucket cache group must be packed");
+
+// FNV-1a, which unlike std::hash is the same across runs and builds.
+class Hash {
+public:
+    inline void add(const void *data, size_t size) {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; i++) {
+            value = (value ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    template <typename T>
+    inline void add(const T &data) {
+        add(&data, sizeof(T));
+    }
+
+    inline void add(const std::string &data) {
+        add(uint64_t(data.size()));
+        add(data.data(), data.size());
+    }
+
+    uint64_t value = 14695981039346656037ull;
+};
+
+inline bool operator==(const BucketCache::TileKey &a, const BucketCache::TileKey &b) {
+    return std::memcmp(&a, &b, sizeof(BucketCache::TileKey)) == 0;
+}
+
+}
+
+BucketCache::File::File(const char *data_, size_t size_, uint32_t count_)
+    : data(data_), size(size_), count(count_) {
+}
+
+BucketCache::File::~File() {
+    munmap(const_cast<char *>(data), size);
+}
+
+bool BucketCache::File::find(uint64_t layoutHash, CachedBucket &bucket) const {
+    for (uint32_t i = 0; i < count; i++) {
+        Record record;
+        std::memcpy(&record, data + sizeof(Header) + i * sizeof(Record), sizeof(Record));
+        if (record.layoutHash != layoutHash) {
+            continue;
+        }
+
+        const uint64_t length = uint64_t(record.triangleGroups + record.lineGroups) * sizeof(CachedBucket::Group) +
+                                record.vertexBytes + record.colorBytes + record.fringeBytes +
+                                record.triangleBytes + record.lineBytes;
+        if (record.offset > size || length > size - record.offset) {
+            return false;
+        }
+
+        const char *pos = data + record.offset;
+        bucket.triangleGroups.resize(record.triangleGroups);
+        std::memcpy(bucket.triangleGroups.data(), pos, record.triangleGroups * sizeof(CachedBucket::Group));
+        pos += record.triangleGroups * sizeof(CachedBucket::Group);
+        bucket.lineGroups.resize(record.lineGroups);
+        std::memcpy(bucket.lineGroups.data(), pos, record.lineGroups * sizeof(CachedBucket::Group));
+        pos += record.lineGroups * sizeof(CachedBucket::Group);
+
+        bucket.vertices = { pos, record.vertexBytes };
+        pos += record.vertexBytes;
+        bucket.colors = { pos, record.colorBytes };
+        pos += record.colorBytes;
+        bucket.fringes = { pos, record.fringeBytes };
+        pos += record.fringeBytes;
+        bucket.triangles = { pos, record.triangleBytes };
+        pos += record.triangleBytes;
+        bucket.lines = { pos, record.lineBytes };
+        return true;
+    }
+    return false;
+}
+
+BucketCache::BucketCache(const std::string &directory_) : directory(directory_) {
+}
+
+uint64_t BucketCache::hashData(const std::string &data) {
+    Hash hash;
+    hash.add(data.data(), data.size());
+    return hash.value;
+}
+
+uint64_t BucketCache::hashLayout(const StyleBucket &bucket_desc) {
+    Hash hash;
+    hash.add(bucket_desc.source_layer);
+
+    const FilterProgram &filter = bucket_desc.compiled_filter;
+    hash.add(uint64_t(filter.instructions.size()));
+    for (const FilterProgram::Instruction &instruction : filter.instructions) {
+        hash.add(instruction.op);
+        hash.add(instruction.key);
+        hash.add(instruction.operand);
+        hash.add(instruction.count);
+    }
+    hash.add(uint64_t(filter.keys.size()));
+    for (const FilterKey &key : filter.keys) {
+        hash.add(key.name);
+    }
+    hash.add(uint64_t(filter.constants.size()));
+    for (const FilterProgram::Constant &constant : filter.constants) {
+        hash.add(constant.kind);
+        hash.add(constant.boolean);
+        hash.add(constant.int_value);
+        hash.add(constant.uint_value);
+        hash.add(constant.number);
+        hash.add(constant.string);
+    }
+
+    if (bucket_desc.render.is<StyleBucketFill>()) {
+        const StyleBucketFill &fill = bucket_desc.render.get<StyleBucketFill>();
+        hash.add('F');
+        hash.add(fill.winding);
+        hash.add(fill.color_property);
+        hash.add(uint64_t(fill.color_stops.size()));
+        for (const auto &stop : fill.color_stops) {
+            hash.add(toString(stop.first));
+            hash.add(stop.second);
+        }
+        hash.add(bool(fill.color_default));
+        if (fill.color_default) {
+            hash.add(*fill.color_default);
+        }
+    } else if (bucket_desc.render.is<StyleBucketLine>()) {
+        const StyleBucketLine &line = bucket_desc.render.get<StyleBucketLine>();
+        hash.add('L');
+        hash.add(line.cap);
+        hash.add(line.join);
+        hash.add(line.miter_limit);
+        hash.add(line.round_limit);
+    }
+
+    return hash.value;
+}
+
+std::string BucketCache::getPath(const TileKey &key) const {
+    char name[48];
+    snprintf(name, sizeof(name), "/%d-%016llx.buckets", int(key.z), (unsigned long long)key.dataHash);
+    return directory + name;
+}
+
+std::unique_ptr<BucketCache::File> BucketCache::load(const TileKey &key) const {
+    const int fd = open(getPath(key).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+        close(fd);
+        return nullptr;
+    }
+
+    const size_t size = size_t(st.st_size);
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return nullptr;
+    }
+
+    const char *data = reinterpret_cast<const char *>(addr);
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+        !(header.key == key) || header.count > (size - sizeof(Header)) / sizeof(Record)) {
+        munmap(addr, size);
+        return nullptr;
+    }
+
+    return std::unique_ptr<File>(new File(data, size, header.count));
+}
+
+void BucketCache::store(const TileKey &key, const std::vector<std::pair<uint64_t, CachedBucket>> &buckets,
+                        const File *previous) const {
+    std::vector<const std::pair<uint64_t, CachedBucket> *> all;
+    std::set<uint64_t> hashes;
+    for (const auto &bucket : buckets) {
+        if (hashes.insert(bucket.first).second) {
+            all.push_back(&bucket);
+        }
+    }
+
+    // The buckets of the previous file that weren't rebuilt, e.g. because the tile kept them
+    // from an earlier parse.
+    std::vector<std::pair<uint64_t, CachedBucket>> kept;
+    if (previous) {
+        kept.reserve(previous->count);
+        for (uint32_t i = 0; i < previous->count; i++) {
+            Record record;
+            std::memcpy(&record, previous->data + sizeof(Header) + i * sizeof(Record), sizeof(Record));
+            CachedBucket bucket;
+            if (hashes.insert(record.layoutHash).second && previous->find(record.layoutHash, bucket)) {
+                kept.emplace_back(record.layoutHash, std::move(bucket));
+                all.push_back(&kept.back());
+            }
+        }
+    }
+
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.count = uint32_t(all.size());
+    header.reserved = 0;
+    header.key = key;
+
+    std::string data(sizeof(Header) + all.size() * sizeof(Record), '\0');
+    std::memcpy(&data[0], &header, sizeof(Header));
+    for (size_t i = 0; i < all.size(); i++) {
+        const CachedBucket &bucket = all[i]->second;
+        Record record;
+        record.layoutHash = all[i]->first;
+        record.triangleGroups = uint32_t(bucket.triangleGroups.size());
+        record.lineGroups = uint32_t(bucket.lineGroups.size());
+        record.vertexBytes = uint32_t(bucket.vertices.size);
+        record.colorBytes = uint32_t(bucket.colors.size);
+        record.triangleBytes = uint32_t(bucket.triangles.size);
+        record.lineBytes = uint32_t(bucket.lines.size);
+        record.offset = uint32_t(data.size());
+        record.fringeBytes = uint32_t(bucket.fringes.size);
+        std::memcpy(&data[sizeof(Header) + i * sizeof(Record)], &record, sizeof(Record));
+
+        data.append(reinterpret_cast<const char *>(bucket.triangleGroups.data()),
+                    bucket.triangleGroups.size() * sizeof(CachedBucket::Group));
+        data.append(reinterpret_cast<const char *>(bucket.lineGroups.data()),
+                    bucket.lineGroups.size() * sizeof(CachedBucket::Group));
+        for (const CachedBucket::Bytes &bytes : { bucket.vertices, bucket.colors, bucket.fringes, bucket.triangles, bucket.lines }) {
+            data.append(bytes.data, bytes.size);
+        }
+    }
+
+    // Write to a temporary file first so that a map starting at the same time never sees a
+    // partial file.
+    const std::string path = getPath(key);
+    const std::string temporary = path + ".tmp";
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (!file) {
+        return;
+    }
+    const bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+    if (fclose(file) != 0 || !written || rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+    }
+}
+
+}
@@ -0,0 +1,134 @@
+#ifndef MBGL_RENDERER_BUCKET_CACHE
+#define MBGL_RENDERER_BUCKET_CACHE
+
+#include <mbgl/geometry/element_bounds.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mbgl {
+
+class StyleBucket;
+
+// The geometry of a fill or line bucket as it is kept in the bucket cache: its element groups,
+// and the parts of the tile buffers they draw from.
+struct CachedBucket {
+    struct Group {
+        uint32_t vertex_length;
+        uint32_t elements_length;
+        ElementBounds bounds;
+    };
+
+    // Bytes of a buffer, which this object doesn't own.
+    struct Bytes {
+        inline Bytes() {}
+        inline Bytes(const char *data_, size_t size_) : data(data_), size(size_) {}
+
+        const char *data = nullptr;
+        size_t size = 0;
+    };
+
+    std::vector<Group> triangleGroups;
+    std::vector<Group> lineGroups;
+    Bytes vertices;
+    Bytes colors;
+    Bytes fringes;
+    Bytes triangles;
+    Bytes lines;
+};
+
+// Copies the element groups of a bucket.
+template <class Group>
+void saveGroups(const std::vector<Group> &groups, std::vector<CachedBucket::Group> &cached) {
+    cached.reserve(groups.size());
+    for (const Group &group : groups) {
+        cached.push_back({ group.vertex_length, group.elements_length, group.bounds });
+    }
+}
+
+template <class Group>
+void loadGroups(const std::vector<CachedBucket::Group> &cached, std::vector<Group> &groups) {
+    groups.reserve(cached.size());
+    for (const CachedBucket::Group &group : cached) {
+        groups.emplace_back(group.vertex_length, group.elements_length);
+        groups.back().bounds = group.bounds;
+    }
+}
+
+// Returns the number of vertices and elements of the groups.
+inline std::pair<uint64_t, uint64_t> countGroups(const std::vector<CachedBucket::Group> &groups) {
+    std::pair<uint64_t, uint64_t> count { 0, 0 };
+    for (const CachedBucket::Group &group : groups) {
+        count.first += group.vertex_length;
+        count.second += group.elements_length;
+    }
+    return count;
+}
+
+// Keeps the fill and line buckets of parsed tiles on disk, so that a tile that was parsed in an
+// earlier run skips decoding, clipping and tessellation, and goes straight to the upload. There is
+// one file per tile data and zoom level; it starts with a header and a table of fixed-size bucket
+// records, followed by the groups and buffer contents of the buckets, and is mapped into memory as
+// a whole when loaded. Buckets are found by a hash of the style properties that shape their
+// geometry, so restyling that only changes paint properties keeps them. The files use the byte
+// order of the machine that wrote them, and files that don't match the format are ignored.
+class BucketCache : private util::noncopyable {
+public:
+    // Everything besides the style that the geometry of a tile's buckets depends on.
+    struct TileKey {
+        uint64_t dataHash = 0;
+        uint32_t dataSize = 0;
+        int32_t z = 0;
+        float depth = 0;
+        uint32_t tileSize = 0;
+
+        // Element sizes of the triangle and line element buffers, which depend on the GL.
+        uint32_t triangleElementSize = 0;
+        uint32_t lineElementSize = 0;
+    };
+
+    // The buckets of one tile, mapped into memory.
+    class File : private util::noncopyable {
+    public:
+        ~File();
+
+        // Points /bucket/ into the file. Returns false if the file has no bucket with this layout.
+        bool find(uint64_t layoutHash, CachedBucket &bucket) const;
+
+    private:
+        friend class BucketCache;
+        File(const char *data, size_t size, uint32_t count);
+
+        const char *const data;
+        const size_t size;
+        const uint32_t count;
+    };
+
+    BucketCache(const std::string &directory);
+
+    // Hashes that are the same across runs and builds.
+    static uint64_t hashData(const std::string &data);
+    static uint64_t hashLayout(const StyleBucket &bucket_desc);
+
+    // Returns nullptr when the tile isn't cached.
+    std::unique_ptr<File> load(const TileKey &key) const;
+
+    // Writes the buckets of a tile, keyed by their layout hash, along with the buckets of the
+    // previous file that aren't replaced. Failures are ignored since the cache is only an
+    // optimization.
+    void store(const TileKey &key, const std::vector<std::pair<uint64_t, CachedBucket>> &buckets,
+               const File *previous) const;
+
+private:
+    std::string getPath(const TileKey &key) const;
+
+    const std::string directory;
+};
+
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include <mbgl/renderer/circle_bucket.hpp>
+#include <mbgl/renderer/painter.hpp>
+#include <mbgl/shader/circle_shader.hpp>
+#include <mbgl/platform/gl_state.hpp>
+
+#include <algorithm>
+#include <limits>
+
+#define BUFFER_OFFSET(i) ((char *)nullptr + (i))
+
+using namespace mbgl;
+
+CircleBucket::CircleBucket(CircleVertexBuffer &vertexBuffer_,
+                           TriangleElementsBuffer &triangleElementsBuffer_,
+                           const StyleBucketCircle &properties_,
+                           bool instanced_)
+    : properties(properties_),
+      instanced(instanced_),
+      vertexBuffer(vertexBuffer_),
+      triangleElementsBuffer(triangleElementsBuffer_),
+      vertex_start(vertexBuffer_.index()),
+      triangle_elements_start(triangleElementsBuffer_.index()) {
+}
+
+void CircleBucket::render(Painter& painter, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix) {
+    painter.renderCircle(*this, layer_desc, id, matrix);
+}
+
+bool CircleBucket::hasData() const {
+    return !groups.empty();
+}
+
+void CircleBucket::addGeometry(const GeometryCollection& geometry) {
+    // Vertices store twice the coordinates, so they must stay within half of the int16 range.
+    for (const std::vector<Coordinate> &line : geometry) {
+        for (const Coordinate &point : line) {
+            if (point.x >= -4096 && point.x < 8192 && point.y >= -4096 && point.y < 8192) {
+                points.push_back(point);
+            }
+        }
+    }
+}
+
+void CircleBucket::flush() {
+    // The points are grouped by the cell of a grid of a quarter tile that they fall into, so that
+    // the groups that are off screen are skipped when the tile is zoomed in. Points in the same
+    // cell keep their order.
+    const auto cell = [](const Coordinate &point) {
+        return ((point.y + 4096) >> 10) * 16 + ((point.x + 4096) >> 10);
+    };
+    std::stable_sort(points.begin(), points.end(), [&](const Coordinate &a, const Coordinate &b) {
+        return cell(a) < cell(b);
+    });
+
+    if (instanced) {
+        vertexBuffer.reserve(points.size());
+    } else {
+        vertexBuffer.reserve(points.size() * 4);
+        triangleElementsBuffer.reserve(points.size() * 2);
+    }
+
+    const uint32_t maxGroupVertices = instanced ? std::numeric_limits<uint32_t>::max()
+                                                : triangleElementsBuffer.maxGroupVertices();
+    int32_t current = -1;
+    for (const Coordinate &point : points) {
+        const int32_t next = cell(point);
+        if (next != current || groups.back().vertex_length + 4 > maxGroupVertices) {
+            groups.emplace_back();
+            groups.back().bounds.extent = 1;
+            current = next;
+        }
+
+        group_type &group = groups.back();
+        if (instanced) {
+            vertexBuffer.addInstance(point.x, point.y);
+            group.vertex_length++;
+        } else {
+            vertexBuffer.add(point.x, point.y);
+            const uint32_t index = group.vertex_length;
+            triangleElementsBuffer.add(index, index + 1, index + 2);
+            triangleElementsBuffer.add(index + 1, index + 3, index + 2);
+            group.vertex_length += 4;
+            group.elements_length += 2;
+        }
+        group.bounds.extend(point.x, point.y);
+    }
+
+    points.clear();
+    points.shrink_to_fit();
+}
+
+MemoryUsage CircleBucket::memoryUsage() const {
+    size_t vertices = 0, triangles = 0;
+    for (const group_type& group : groups) {
+        vertices += group.vertex_length;
+        triangles += group.elements_length;
+    }
+    return vertexBuffer.memoryUsage(vertices) +
+           triangleElementsBuffer.memoryUsage(triangles);
+}
+
+void CircleBucket::drawCircles(CircleShader& shader, const ElementCuller& culler) {
+    char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
+    char *elements_index = BUFFER_OFFSET(triangle_elements_start * triangleElementsBuffer.itemSize);
+    for (group_type& group : groups) {
+        if (culler.isVisible(group.bounds)) {
+            if (instanced) {
+                group.array[0].bind(shader, vertexBuffer, vertex_index);
+                MBGL_CHECK_ERROR(gl::DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, group.vertex_length));
+            } else {
+                group.array[0].bind(shader, vertexBuffer, triangleElementsBuffer, vertex_index);
+                gl::State::Get().drawElements(GL_TRIANGLES, group.elements_length * 3, triangleElementsBuffer.elementType, elements_index);
+            }
+        }
+        vertex_index += group.vertex_length * vertexBuffer.itemSize;
+        elements_index += group.elements_length * triangleElementsBuffer.itemSize;
+    }
+}
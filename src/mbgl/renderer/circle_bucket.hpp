@@ -0,0 +1,62 @@
+#ifndef MBGL_RENDERER_CIRCLEBUCKET
+#define MBGL_RENDERER_CIRCLEBUCKET
+
+#include <mbgl/renderer/bucket.hpp>
+#include <mbgl/geometry/vao.hpp>
+#include <mbgl/geometry/elements_buffer.hpp>
+#include <mbgl/geometry/circle_buffer.hpp>
+#include <mbgl/geometry/geometry.hpp>
+#include <mbgl/style/style_bucket.hpp>
+
+#include <vector>
+
+namespace mbgl {
+
+class CircleShader;
+
+// Draws every point of the features as a circle. Unlike symbols, circles aren't placed: all of
+// them are drawn, and they may overlap each other.
+class CircleBucket : public Bucket {
+    typedef ElementGroup<1> group_type;
+
+public:
+    // Instanced buckets store one instance per point, and need the instanced shader.
+    CircleBucket(CircleVertexBuffer &vertexBuffer,
+                 TriangleElementsBuffer &triangleElementsBuffer,
+                 const StyleBucketCircle &properties,
+                 bool instanced);
+
+    virtual void render(Painter& painter, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix);
+    virtual bool hasData() const;
+    virtual MemoryUsage memoryUsage() const;
+
+    // Collects the points of a feature; every vertex of the geometry is a point. Points that are
+    // more than a tile away from the tile are dropped.
+    void addGeometry(const GeometryCollection& geometry);
+
+    // Writes the collected points into the buffers.
+    void flush();
+
+    // Groups that the culler rejects are skipped.
+    void drawCircles(CircleShader& shader, const ElementCuller& culler);
+
+public:
+    const StyleBucketCircle &properties;
+    const bool instanced;
+
+private:
+    CircleVertexBuffer& vertexBuffer;
+    TriangleElementsBuffer& triangleElementsBuffer;
+
+    const size_t vertex_start;
+    const size_t triangle_elements_start;
+
+    std::vector<Coordinate> points;
+
+    // The vertex_length of instanced groups counts points.
+    std::vector<group_type> groups;
+};
+
+}
+
+#endif
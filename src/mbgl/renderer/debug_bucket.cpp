@@ -1,7 +1,7 @@
 #include <mbgl/renderer/debug_bucket.hpp>
 #include <mbgl/renderer/painter.hpp>
 
-#include <mbgl/platform/gl.hpp>
+#include <mbgl/platform/gl_state.hpp>
 
 #include <cassert>
 
@@ -13,7 +13,7 @@ DebugBucket::DebugBucket(DebugFontBuffer& fontBuffer_)
     : fontBuffer(fontBuffer_) {
 }
 
-void DebugBucket::render(Painter& painter, util::ptr<StyleLayer> /*layer_desc*/, const Tile::ID& /*id*/, const mat4 &matrix) {
+void DebugBucket::render(Painter& painter, const util::ptr<StyleLayer>& /*layer_desc*/, const Tile::ID& /*id*/, const mat4 &matrix) {
     painter.renderDebugText(*this, matrix);
 }
 
@@ -21,12 +21,16 @@ bool DebugBucket::hasData() const {
     return fontBuffer.index() > 0;
 }
 
+MemoryUsage DebugBucket::memoryUsage() const {
+    return fontBuffer.memoryUsage();
+}
+
 void DebugBucket::drawLines(PlainShader& shader) {
     array.bind(shader, fontBuffer, BUFFER_OFFSET(0));
-    MBGL_CHECK_ERROR(glDrawArrays(GL_LINES, 0, (GLsizei)(fontBuffer.index())));
+    gl::State::Get().drawArrays(GL_LINES, 0, (GLsizei)(fontBuffer.index()));
 }
 
 void DebugBucket::drawPoints(PlainShader& shader) {
     array.bind(shader, fontBuffer, BUFFER_OFFSET(0));
-    MBGL_CHECK_ERROR(glDrawArrays(GL_POINTS, 0, (GLsizei)(fontBuffer.index())));
+    gl::State::Get().drawArrays(GL_POINTS, 0, (GLsizei)(fontBuffer.index()));
 }
@@ -19,8 +19,9 @@ class DebugBucket : public Bucket {
 public:
     DebugBucket(DebugFontBuffer& fontBuffer);
 
-    virtual void render(Painter& painter, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix);
+    virtual void render(Painter& painter, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix);
     virtual bool hasData() const;
+    virtual MemoryUsage memoryUsage() const;
 
     void drawLines(PlainShader& shader);
     void drawPoints(PlainShader& shader);
@@ -2,15 +2,24 @@
 #include <mbgl/geometry/fill_buffer.hpp>
 #include <mbgl/geometry/elements_buffer.hpp>
 #include <mbgl/geometry/geometry.hpp>
+#include <mbgl/geometry/triangulate.hpp>
+#include <mbgl/geometry/vertex_cache.hpp>
 
 #include <mbgl/renderer/painter.hpp>
+#include <mbgl/renderer/bucket_cache.hpp>
 #include <mbgl/style/style.hpp>
 #include <mbgl/map/vector_tile.hpp>
+#include <mbgl/util/arena.hpp>
+#include <mbgl/util/math.hpp>
 
-#include <mbgl/platform/gl.hpp>
+#include <mbgl/platform/gl_state.hpp>
+#include <mbgl/platform/log.hpp>
 
 
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <thread>
 
 struct geometry_too_long_exception : std::exception {};
 
@@ -18,86 +27,244 @@ using namespace mbgl;
 
 
 
-void *FillBucket::alloc(void *, unsigned int size) {
-    return ::malloc(size);
+// libtess2 needs to know the size of a block when reallocating it, so we store
+// it in front of every allocation. The header occupies a full alignment unit so
+// that the returned pointer stays aligned.
+static_assert(sizeof(size_t) <= util::Arena::alignment, "allocation header doesn't fit");
+
+void *FillBucket::alloc(void *data, unsigned int size) {
+    util::Arena &arena = *reinterpret_cast<util::Arena *>(data);
+    uint8_t *block = reinterpret_cast<uint8_t *>(arena.allocate(util::Arena::alignment + size));
+    *reinterpret_cast<size_t *>(block) = size;
+    return block + util::Arena::alignment;
+}
+
+void *FillBucket::realloc(void *data, void *ptr, unsigned int size) {
+    if (!ptr) {
+        return alloc(data, size);
+    }
+    const size_t old_size = *reinterpret_cast<size_t *>(reinterpret_cast<uint8_t *>(ptr) - util::Arena::alignment);
+    if (size <= old_size) {
+        return ptr;
+    }
+    void *block = alloc(data, size);
+    std::memcpy(block, ptr, old_size);
+    return block;
 }
 
-void *FillBucket::realloc(void *, void *ptr, unsigned int size) {
-    return ::realloc(ptr, size);
+void FillBucket::free(void *, void *) {
+    // Memory is reclaimed all at once when the arena is reset.
+}
+
+namespace {
+
+// The direction in which the fringe extends the outline at /pt/, with a length of one fringe width
+// from the edges. Clipper orients holes opposite to the outer rings, so the fill is on the same side
+// of every edge. Very sharp corners are cut off at twice the fringe width.
+void fringeExtrusion(const ClipperLib::IntPoint &prev, const ClipperLib::IntPoint &pt,
+                     const ClipperLib::IntPoint &next, float &ex, float &ey) {
+    float ax = pt.Y - prev.Y, ay = prev.X - pt.X;
+    float bx = next.Y - pt.Y, by = pt.X - next.X;
+    const float a = std::sqrt(ax * ax + ay * ay), b = std::sqrt(bx * bx + by * by);
+    ax /= a; ay /= a;
+    bx /= b; by /= b;
+
+    // The miter has a length of 1 / cos(angle / 2), and the sum of the normals 2 * cos(angle / 2).
+    ex = ax + bx;
+    ey = ay + by;
+    const float length = std::sqrt(ex * ex + ey * ey);
+    if (length < 0.001f) {
+        // The outline turns back on itself.
+        ex = bx;
+        ey = by;
+        return;
+    }
+    const float scale = std::min(2.0f / (length * length), 2.0f / length);
+    ex *= scale;
+    ey *= scale;
 }
 
-void FillBucket::free(void *, void *ptr) {
-    ::free(ptr);
 }
 
 FillBucket::FillBucket(FillVertexBuffer &vertexBuffer_,
+                       FillColorBuffer &colorBuffer_,
+                       FillFringeBuffer &fringeBuffer_,
                        TriangleElementsBuffer &triangleElementsBuffer_,
                        LineElementsBuffer &lineElementsBuffer_,
-                       const StyleBucketFill &properties_)
+                       const StyleBucketFill &properties_,
+                       util::Arena &arena_,
+                       bool fringes_)
     : properties(properties_),
-      allocator(new TESSalloc{&alloc, &realloc, &free, nullptr, // userData
-                              64,                               // meshEdgeBucketSize
-                              64,                               // meshVertexBucketSize
-                              32,                               // meshFaceBucketSize
-                              64,                               // dictNodeBucketSize
-                              8,                                // regionBucketSize
-                              128, // extraVertices allocated for the priority queue.
-      }),
-      tesselator(tessNewTess(allocator)),
+      arena(arena_),
+      allocator(createAllocator(arena)),
       vertexBuffer(vertexBuffer_),
+      colorBuffer(colorBuffer_),
+      fringeBuffer(fringeBuffer_),
       triangleElementsBuffer(triangleElementsBuffer_),
       lineElementsBuffer(lineElementsBuffer_),
       vertex_start(vertexBuffer_.index()),
+      color_start(colorBuffer_.index()),
+      fringe_start(fringeBuffer_.index()),
       triangle_elements_start(triangleElementsBuffer_.index()),
-      line_elements_start(lineElementsBuffer.index()) {
-    assert(tesselator);
+      line_elements_start(lineElementsBuffer.index()),
+      fringes(fringes_ && !hasFeatureColors()) {
 }
 
-FillBucket::~FillBucket() {
-    if (tesselator) {
-        tessDeleteTess(tesselator);
+FillBucket::~FillBucket() = default;
+
+bool FillBucket::setFeature(const VectorTileTagExtractor &tags) {
+    if (!hasFeatureColors()) {
+        return true;
+    }
+
+    const Color *color = properties.getColor(tags.getValue(properties.color_property));
+    if (!color) {
+        return false;
     }
-    if (allocator) {
-        delete allocator;
+
+    for (size_t i = 0; i < featureColor.size(); i++) {
+        featureColor[i] = std::round(util::clamp((*color)[i], 0.0f, 1.0f) * 255);
     }
+    return true;
 }
 
-void FillBucket::addGeometry(pbf& geom) {
-    Geometry::command cmd;
+void FillBucket::addGeometry(const GeometryCollection& rings) {
+    size_t vertex_count = 0;
+    for (const std::vector<Coordinate>& ring : rings) {
+        vertex_count += ring.size();
+    }
 
-    Coordinate coord;
-    Geometry geometry(geom);
-    int32_t x, y;
-    while ((cmd = geometry.next(x, y)) != Geometry::end) {
-        if (cmd == Geometry::move_to) {
-            if (line.size()) {
-                clipper.AddPath(line, ClipperLib::ptSubject, true);
-                line.clear();
-                hasVertices = true;
-            }
+    if (vertex_count >= parallel_vertex_count) {
+        // Very large polygons (e.g. landcover or water at low zoom levels) dominate
+        // the parsing time of their tile. Tessellate them concurrently and merge the
+        // results in the order the features were added once they are done.
+        if (pending.size() >= util::max(1u, std::thread::hardware_concurrency())) {
+            Tessellation result = pending.front().get();
+            pending.pop_front();
+            merge(result);
         }
-        line.emplace_back(x, y);
+        const FillColorBuffer::color_type color = featureColor;
+        pending.emplace_back(std::async(std::launch::async, [rings, color]() {
+            util::Arena arena;
+            TESSalloc allocator = createAllocator(arena);
+            ClipperLib::Clipper clipper;
+            Tessellation result;
+            addRings(clipper, rings);
+            tessellate(clipper, allocator, result);
+            result.color = color;
+            return result;
+        }));
+        return;
     }
 
-    if (line.size()) {
-        clipper.AddPath(line, ClipperLib::ptSubject, true);
-        line.clear();
-        hasVertices = true;
+    addRings(clipper, rings);
+    tessellate(clipper, allocator, tessellation);
+    tessellation.color = featureColor;
+    arena.reset();
+    merge(tessellation);
+}
+
+void FillBucket::flush() {
+    while (!pending.empty()) {
+        Tessellation result = pending.front().get();
+        pending.pop_front();
+        merge(result);
     }
+}
 
-    tessellate();
+TESSalloc FillBucket::createAllocator(util::Arena &arena) {
+    return TESSalloc {
+        &alloc, &realloc, &free, &arena, // userData
+        64,                              // meshEdgeBucketSize
+        64,                              // meshVertexBucketSize
+        32,                              // meshFaceBucketSize
+        64,                              // dictNodeBucketSize
+        8,                               // regionBucketSize
+        128, // extraVertices allocated for the priority queue.
+    };
 }
 
-void FillBucket::tessellate() {
-    if (!hasVertices) {
-        return;
+void FillBucket::addRings(ClipperLib::Clipper &clipper, const GeometryCollection &rings) {
+    ClipperLib::Path line;
+    for (const std::vector<Coordinate>& ring : rings) {
+        line.clear();
+        for (const Coordinate& coord : ring) {
+            line.emplace_back(coord.x, coord.y);
+        }
+        clipper.AddPath(line, ClipperLib::ptSubject, true);
     }
-    hasVertices = false;
+}
 
-    std::vector<std::vector<ClipperLib::IntPoint>> polygons;
-    clipper.Execute(ClipperLib::ctUnion, polygons, ClipperLib::pftPositive);
+void FillBucket::tessellate(ClipperLib::Clipper &clipper, TESSalloc &allocator, Tessellation &result) {
+    result.polygons.clear();
+    result.vertices.clear();
+    result.vertex_indices.clear();
+    result.elements.clear();
+
+    clipper.Execute(ClipperLib::ctUnion, result.polygons, ClipperLib::pftPositive);
     clipper.Clear();
 
+    if (result.polygons.size() == 0) {
+        return;
+    }
+
+    // After the union, a single polygon can't have holes, so we can take a shortcut for the
+    // simple polygons that most features are made of.
+    const ClipperLib::Path &ring = result.polygons.front();
+    result.triangles.clear();
+    if (result.polygons.size() == 1 && ring.size() <= ear_clipping_vertex_count &&
+        triangulate(ring, result.triangles)) {
+        for (size_t i = 0; i < ring.size(); i++) {
+            result.vertices.push_back(ring[i].X);
+            result.vertices.push_back(ring[i].Y);
+            result.vertex_indices.push_back((TESSindex)i);
+        }
+        result.elements.assign(result.triangles.begin(), result.triangles.end());
+        return;
+    }
+
+    // The tesselator and everything it allocates live in the arena, so we don't
+    // delete it explicitly; the caller rewinds the arena to release it in one go.
+    TESStesselator *tesselator = tessNewTess(&allocator);
+    assert(tesselator);
+
+    for (const std::vector<ClipperLib::IntPoint>& polygon : result.polygons) {
+        assert(polygon.size() >= 3);
+
+        result.contour.clear();
+        for (const ClipperLib::IntPoint& pt : polygon) {
+            result.contour.push_back(pt.X);
+            result.contour.push_back(pt.Y);
+        }
+
+        tessAddContour(tesselator, vertexSize, result.contour.data(), stride, (int)result.contour.size() / vertexSize);
+    }
+
+    if (tessTesselate(tesselator, TESS_WINDING_POSITIVE, TESS_POLYGONS, vertices_per_group, vertexSize, 0)) {
+        const TESSreal *vertices = tessGetVertices(tesselator);
+        const size_t vertex_count = tessGetVertexCount(tesselator);
+        const TESSindex *vertex_indices = tessGetVertexIndices(tesselator);
+        const TESSindex *elements = tessGetElements(tesselator);
+        const size_t triangle_count = tessGetElementCount(tesselator);
+
+        result.vertices.assign(vertices, vertices + vertex_count * vertexSize);
+        result.vertex_indices.assign(vertex_indices, vertex_indices + vertex_count);
+        result.elements.assign(elements, elements + triangle_count * vertices_per_group);
+
+        // The sweep emits triangles in the order its regions close, which jumps across large
+        // polygons and makes the GPU transform most of their vertices several times.
+        if (triangle_count >= vertex_cache_triangle_count) {
+            optimizeVertexCache(result.elements, vertex_count);
+        }
+    } else {
+#if defined(DEBUG)
+        Log::Warning(Event::ParseTile, "tessellation failed");
+#endif
+    }
+}
+
+void FillBucket::merge(Tessellation &result) {
+    const ClipperLib::Paths &polygons = result.polygons;
     if (polygons.size() == 0) {
         return;
     }
@@ -107,11 +274,16 @@ void FillBucket::tessellate() {
         total_vertex_count += polygon.size();
     }
 
-    if (total_vertex_count > 65536) {
+    // The fringe adds an extruded copy of every vertex of the outline.
+    const size_t outline_vertex_count = total_vertex_count;
+    const bool fringe = fringes && !result.elements.empty();
+    const size_t fringe_vertex_count = fringe ? outline_vertex_count : 0;
+
+    if (total_vertex_count + fringe_vertex_count > lineElementsBuffer.maxGroupVertices()) {
         throw geometry_too_long_exception();
     }
 
-    if (!lineGroups.size() || (lineGroups.back().vertex_length + total_vertex_count > 65535)) {
+    if (!lineGroups.size() || (lineGroups.back().vertex_length + total_vertex_count + fringe_vertex_count > lineElementsBuffer.maxGroupVertices())) {
         // Move to a new group because the old one can't hold the geometry.
         lineGroups.emplace_back();
     }
@@ -119,15 +291,36 @@ void FillBucket::tessellate() {
     line_group_type& lineGroup = lineGroups.back();
     uint32_t lineIndex = lineGroup.vertex_length;
 
+    vertexBuffer.reserve(total_vertex_count);
+    lineElementsBuffer.reserve(total_vertex_count);
+    if (hasFeatureColors()) {
+        colorBuffer.reserve(total_vertex_count);
+    }
+    if (fringes) {
+        fringeBuffer.reserve(total_vertex_count + fringe_vertex_count);
+    }
+
+    // The triangles don't reach beyond the outline.
+    ElementBounds bounds;
+
     for (const std::vector<ClipperLib::IntPoint>& polygon : polygons) {
         const size_t group_count = polygon.size();
-        assert(group_count >= 3);
 
-        std::vector<TESSreal> clipped_line;
         for (const ClipperLib::IntPoint& pt : polygon) {
-            clipped_line.push_back(pt.X);
-            clipped_line.push_back(pt.Y);
             vertexBuffer.add(pt.X, pt.Y);
+            bounds.extend(pt.X, pt.Y);
+        }
+
+        if (hasFeatureColors()) {
+            for (size_t i = 0; i < group_count; i++) {
+                colorBuffer.add(result.color);
+            }
+        }
+
+        if (fringes) {
+            for (size_t i = 0; i < group_count; i++) {
+                fringeBuffer.add(0, 0);
+            }
         }
 
         for (size_t i = 0; i < group_count; i++) {
@@ -136,28 +329,55 @@ void FillBucket::tessellate() {
         }
 
         lineIndex += group_count;
-
-        tessAddContour(tesselator, vertexSize, clipped_line.data(), stride, (int)clipped_line.size() / vertexSize);
     }
 
     lineGroup.elements_length += total_vertex_count;
+    lineGroup.bounds.extend(bounds);
 
-    if (tessTesselate(tesselator, TESS_WINDING_POSITIVE, TESS_POLYGONS, vertices_per_group, vertexSize, 0)) {
-        const TESSreal *vertices = tessGetVertices(tesselator);
-        const size_t vertex_count = tessGetVertexCount(tesselator);
-        TESSindex *vertex_indices = const_cast<TESSindex *>(tessGetVertexIndices(tesselator));
-        const TESSindex *elements = tessGetElements(tesselator);
-        const int triangle_count = tessGetElementCount(tesselator);
+    if (!result.elements.empty()) {
+        const TESSreal *vertices = result.vertices.data();
+        const size_t vertex_count = result.vertex_indices.size();
+        TESSindex *vertex_indices = result.vertex_indices.data();
+        const TESSindex *elements = result.elements.data();
+        const int triangle_count = result.elements.size() / vertices_per_group;
+        const int fringe_triangle_count = fringe_vertex_count * 2;
+
+        vertexBuffer.reserve(vertex_count + fringe_vertex_count);
+        triangleElementsBuffer.reserve(triangle_count + fringe_triangle_count);
 
         for (size_t i = 0; i < vertex_count; ++i) {
             if (vertex_indices[i] == TESS_UNDEF) {
                 vertexBuffer.add(std::round(vertices[i * 2]), std::round(vertices[i * 2 + 1]));
+                if (hasFeatureColors()) {
+                    colorBuffer.add(result.color);
+                }
+                if (fringes) {
+                    fringeBuffer.add(0, 0);
+                }
                 vertex_indices[i] = (TESSindex)total_vertex_count;
                 total_vertex_count++;
             }
         }
 
-        if (!triangleGroups.size() || (triangleGroups.back().vertex_length + total_vertex_count > 65535)) {
+        // The outer vertices of the fringe follow all other vertices of the feature. Its inner
+        // vertices are those of the outline, and stay opaque.
+        const size_t fringe_vertex_start = total_vertex_count;
+        if (fringe) {
+            for (const std::vector<ClipperLib::IntPoint>& polygon : polygons) {
+                const size_t group_count = polygon.size();
+                for (size_t i = 0; i < group_count; i++) {
+                    const size_t prev_i = (i == 0 ? group_count : i) - 1;
+                    const size_t next_i = (i + 1 == group_count ? 0 : i + 1);
+                    float ex, ey;
+                    fringeExtrusion(polygon[prev_i], polygon[i], polygon[next_i], ex, ey);
+                    vertexBuffer.add(polygon[i].X, polygon[i].Y);
+                    fringeBuffer.add(ex, ey);
+                }
+            }
+            total_vertex_count += fringe_vertex_count;
+        }
+
+        if (!triangleGroups.size() || (triangleGroups.back().vertex_length + total_vertex_count > triangleElementsBuffer.maxGroupVertices())) {
             // Move to a new group because the old one can't hold the geometry.
             triangleGroups.emplace_back();
         }
@@ -180,22 +400,35 @@ void FillBucket::tessellate() {
                 } else {
 #if defined(DEBUG)
                     // TODO: We're missing a vertex that was not part of the line.
-                    fprintf(stderr, "undefined element buffer\n");
+                    Log::Warning(Event::ParseTile, "undefined element buffer");
 #endif
                 }
             } else {
 #if defined(DEBUG)
-                fprintf(stderr, "undefined element buffer\n");
+                Log::Warning(Event::ParseTile, "undefined element buffer");
 #endif
             }
         }
 
+        // Two triangles per edge of the outline connect it with the outer vertices of the fringe.
+        if (fringe) {
+            uint32_t outlineIndex = triangleIndex;
+            for (const std::vector<ClipperLib::IntPoint>& polygon : polygons) {
+                const size_t group_count = polygon.size();
+                for (size_t i = 0; i < group_count; i++) {
+                    const size_t prev_i = (i == 0 ? group_count : i) - 1;
+                    const uint32_t a = outlineIndex + prev_i, b = outlineIndex + i;
+                    const uint32_t c = a + fringe_vertex_start, d = b + fringe_vertex_start;
+                    triangleElementsBuffer.add(a, b, c);
+                    triangleElementsBuffer.add(b, d, c);
+                }
+                outlineIndex += group_count;
+            }
+        }
+
         triangleGroup.vertex_length += total_vertex_count;
-        triangleGroup.elements_length += triangle_count;
-    } else {
-#if defined(DEBUG)
-        fprintf(stderr, "tessellation failed\n");
-#endif
+        triangleGroup.elements_length += triangle_count + fringe_triangle_count;
+        triangleGroup.bounds.extend(bounds);
     }
 
     // We're adding the total vertex count *after* we added additional vertices
@@ -204,43 +437,151 @@ void FillBucket::tessellate() {
     lineGroup.vertex_length += total_vertex_count;
 }
 
-void FillBucket::render(Painter& painter, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix) {
+void FillBucket::render(Painter& painter, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix) {
     painter.renderFill(*this, layer_desc, id, matrix);
 }
 
+void FillBucket::save(CachedBucket &cached) const {
+    saveGroups(triangleGroups, cached.triangleGroups);
+    saveGroups(lineGroups, cached.lineGroups);
+
+    // The outline groups reference every vertex of the bucket.
+    const std::pair<uint64_t, uint64_t> triangles = countGroups(cached.triangleGroups);
+    const std::pair<uint64_t, uint64_t> lines = countGroups(cached.lineGroups);
+    cached.vertices = { vertexBuffer.data(vertex_start), lines.first * vertexBuffer.itemSize };
+    if (hasFeatureColors()) {
+        cached.colors = { colorBuffer.data(color_start), lines.first * colorBuffer.itemSize };
+    }
+    if (fringes) {
+        cached.fringes = { fringeBuffer.data(fringe_start), lines.first * fringeBuffer.itemSize };
+    }
+    cached.triangles = { triangleElementsBuffer.data(triangle_elements_start), triangles.second * triangleElementsBuffer.itemSize };
+    cached.lines = { lineElementsBuffer.data(line_elements_start), lines.second * lineElementsBuffer.itemSize };
+}
+
+bool FillBucket::load(const CachedBucket &cached) {
+    const std::pair<uint64_t, uint64_t> triangles = countGroups(cached.triangleGroups);
+    const std::pair<uint64_t, uint64_t> lines = countGroups(cached.lineGroups);
+    if (cached.vertices.size != lines.first * vertexBuffer.itemSize ||
+        triangles.first > lines.first ||
+        cached.colors.size != (hasFeatureColors() ? lines.first * colorBuffer.itemSize : 0) ||
+        cached.fringes.size != (fringes ? lines.first * fringeBuffer.itemSize : 0) ||
+        cached.triangles.size != triangles.second * triangleElementsBuffer.itemSize ||
+        cached.lines.size != lines.second * lineElementsBuffer.itemSize) {
+        return false;
+    }
+
+    vertexBuffer.append(cached.vertices.data, lines.first);
+    colorBuffer.append(cached.colors.data, cached.colors.size / colorBuffer.itemSize);
+    fringeBuffer.append(cached.fringes.data, cached.fringes.size / fringeBuffer.itemSize);
+    triangleElementsBuffer.append(cached.triangles.data, triangles.second);
+    lineElementsBuffer.append(cached.lines.data, lines.second);
+    loadGroups(cached.triangleGroups, triangleGroups);
+    loadGroups(cached.lineGroups, lineGroups);
+    return true;
+}
+
 bool FillBucket::hasData() const {
     return !triangleGroups.empty() || !lineGroups.empty();
 }
 
-void FillBucket::drawElements(PlainShader& shader) {
+MemoryUsage FillBucket::memoryUsage() const {
+    // The outline groups reference every vertex of the bucket.
+    size_t vertices = 0, triangles = 0, lines = 0;
+    for (const triangle_group_type& group : triangleGroups) {
+        triangles += group.elements_length;
+    }
+    for (const line_group_type& group : lineGroups) {
+        vertices += group.vertex_length;
+        lines += group.elements_length;
+    }
+    return vertexBuffer.memoryUsage(vertices) +
+           colorBuffer.memoryUsage(hasFeatureColors() ? vertices : 0) +
+           fringeBuffer.memoryUsage(fringes ? vertices : 0) +
+           triangleElementsBuffer.memoryUsage(triangles) +
+           lineElementsBuffer.memoryUsage(lines);
+}
+
+void FillBucket::drawElements(PlainShader& shader, const ElementCuller& culler) {
+    char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
+    char *elements_index = BUFFER_OFFSET(triangle_elements_start * triangleElementsBuffer.itemSize);
+    for (triangle_group_type& group : triangleGroups) {
+        if (culler.isVisible(group.bounds)) {
+            group.array[0].bind(shader, vertexBuffer, triangleElementsBuffer, vertex_index);
+            gl::State::Get().drawElements(GL_TRIANGLES, group.elements_length * 3, triangleElementsBuffer.elementType, elements_index);
+        }
+        vertex_index += group.vertex_length * vertexBuffer.itemSize;
+        elements_index += group.elements_length * triangleElementsBuffer.itemSize;
+    }
+}
+
+void FillBucket::drawElements(PatternShader& shader, const ElementCuller& culler) {
+    char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
+    char *elements_index = BUFFER_OFFSET(triangle_elements_start * triangleElementsBuffer.itemSize);
+    for (triangle_group_type& group : triangleGroups) {
+        if (culler.isVisible(group.bounds)) {
+            group.array[1].bind(shader, vertexBuffer, triangleElementsBuffer, vertex_index);
+            gl::State::Get().drawElements(GL_TRIANGLES, group.elements_length * 3, triangleElementsBuffer.elementType, elements_index);
+        }
+        vertex_index += group.vertex_length * vertexBuffer.itemSize;
+        elements_index += group.elements_length * triangleElementsBuffer.itemSize;
+    }
+}
+
+void FillBucket::drawElements(PlainColorShader& shader, const ElementCuller& culler) {
     char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
+    char *color_index = BUFFER_OFFSET(color_start * colorBuffer.itemSize);
     char *elements_index = BUFFER_OFFSET(triangle_elements_start * triangleElementsBuffer.itemSize);
     for (triangle_group_type& group : triangleGroups) {
-        group.array[0].bind(shader, vertexBuffer, triangleElementsBuffer, vertex_index);
-        MBGL_CHECK_ERROR(glDrawElements(GL_TRIANGLES, group.elements_length * 3, GL_UNSIGNED_SHORT, elements_index));
+        if (culler.isVisible(group.bounds)) {
+            group.array[2].bind(shader, vertexBuffer, colorBuffer, triangleElementsBuffer, vertex_index, color_index);
+            gl::State::Get().drawElements(GL_TRIANGLES, group.elements_length * 3, triangleElementsBuffer.elementType, elements_index);
+        }
         vertex_index += group.vertex_length * vertexBuffer.itemSize;
+        color_index += group.vertex_length * colorBuffer.itemSize;
         elements_index += group.elements_length * triangleElementsBuffer.itemSize;
     }
 }
 
-void FillBucket::drawElements(PatternShader& shader) {
+void FillBucket::drawElements(PlainFringeShader& shader, const ElementCuller& culler) {
     char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
+    char *fringe_index = BUFFER_OFFSET(fringe_start * fringeBuffer.itemSize);
     char *elements_index = BUFFER_OFFSET(triangle_elements_start * triangleElementsBuffer.itemSize);
     for (triangle_group_type& group : triangleGroups) {
-        group.array[1].bind(shader, vertexBuffer, triangleElementsBuffer, vertex_index);
-        MBGL_CHECK_ERROR(glDrawElements(GL_TRIANGLES, group.elements_length * 3, GL_UNSIGNED_SHORT, elements_index));
+        if (culler.isVisible(group.bounds)) {
+            group.array[3].bind(shader, vertexBuffer, fringeBuffer, triangleElementsBuffer, vertex_index, fringe_index);
+            gl::State::Get().drawElements(GL_TRIANGLES, group.elements_length * 3, triangleElementsBuffer.elementType, elements_index);
+        }
         vertex_index += group.vertex_length * vertexBuffer.itemSize;
+        fringe_index += group.vertex_length * fringeBuffer.itemSize;
         elements_index += group.elements_length * triangleElementsBuffer.itemSize;
     }
 }
 
-void FillBucket::drawVertices(OutlineShader& shader) {
+void FillBucket::drawVertices(OutlineShader& shader, const ElementCuller& culler) {
+    char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
+    char *elements_index = BUFFER_OFFSET(line_elements_start * lineElementsBuffer.itemSize);
+    for (line_group_type& group : lineGroups) {
+        if (culler.isVisible(group.bounds)) {
+            group.array[0].bind(shader, vertexBuffer, lineElementsBuffer, vertex_index);
+            gl::State::Get().drawElements(GL_LINES, group.elements_length * 2, lineElementsBuffer.elementType, elements_index);
+        }
+        vertex_index += group.vertex_length * vertexBuffer.itemSize;
+        elements_index += group.elements_length * lineElementsBuffer.itemSize;
+    }
+}
+
+void FillBucket::drawVertices(OutlineColorShader& shader, const ElementCuller& culler) {
     char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
+    char *color_index = BUFFER_OFFSET(color_start * colorBuffer.itemSize);
     char *elements_index = BUFFER_OFFSET(line_elements_start * lineElementsBuffer.itemSize);
     for (line_group_type& group : lineGroups) {
-        group.array[0].bind(shader, vertexBuffer, lineElementsBuffer, vertex_index);
-        MBGL_CHECK_ERROR(glDrawElements(GL_LINES, group.elements_length * 2, GL_UNSIGNED_SHORT, elements_index));
+        if (culler.isVisible(group.bounds)) {
+            group.array[1].bind(shader, vertexBuffer, colorBuffer, lineElementsBuffer, vertex_index, color_index);
+            gl::State::Get().drawElements(GL_LINES, group.elements_length * 2, lineElementsBuffer.elementType, elements_index);
+        }
         vertex_index += group.vertex_length * vertexBuffer.itemSize;
+        color_index += group.vertex_length * colorBuffer.itemSize;
         elements_index += group.elements_length * lineElementsBuffer.itemSize;
     }
 }
@@ -4,11 +4,14 @@
 #include <mbgl/renderer/bucket.hpp>
 #include <mbgl/geometry/elements_buffer.hpp>
 #include <mbgl/geometry/fill_buffer.hpp>
+#include <mbgl/geometry/geometry.hpp>
 #include <mbgl/style/style_bucket.hpp>
 
 #include <clipper/clipper.hpp>
 #include <libtess2/tesselator.h>
 
+#include <deque>
+#include <future>
 #include <vector>
 #include <memory>
 
@@ -20,67 +23,156 @@ namespace mbgl {
 
 class Style;
 class FillVertexBuffer;
+class FillColorBuffer;
+class FillFringeBuffer;
 class TriangleElementsBuffer;
 class LineElementsBuffer;
 class BucketDescription;
 class OutlineShader;
+class OutlineColorShader;
 class PlainShader;
+class PlainColorShader;
+class PlainFringeShader;
 class PatternShader;
+class VectorTileTagExtractor;
+struct CachedBucket;
 struct pbf;
 
+namespace util {
+class Arena;
+}
+
 class FillBucket : public Bucket {
 
     static void *alloc(void *data, unsigned int size);
     static void *realloc(void *data, void *ptr, unsigned int size);
     static void free(void *userData, void *ptr);
 
-    typedef ElementGroup<2> triangle_group_type;
-    typedef ElementGroup<1> line_group_type;
+    typedef ElementGroup<4> triangle_group_type;
+    typedef ElementGroup<2> line_group_type;
+
+    // The outline and triangulation of one feature, before they are added to the buffers.
+    struct Tessellation {
+        ClipperLib::Paths polygons;
+        std::vector<TESSreal> contour;
+        std::vector<TESSreal> vertices;
+        std::vector<TESSindex> vertex_indices;
+        std::vector<TESSindex> elements;
+        std::vector<uint32_t> triangles;
+
+        // Only used by buckets that color features individually.
+        FillColorBuffer::color_type color {{ 0, 0, 0, 0 }};
+    };
 
 public:
+    // Buckets with /fringes/ surround their triangles with an antialiasing fringe, unless they
+    // color their features individually.
     FillBucket(FillVertexBuffer& vertexBuffer,
+               FillColorBuffer& colorBuffer,
+               FillFringeBuffer& fringeBuffer,
                TriangleElementsBuffer& triangleElementsBuffer,
                LineElementsBuffer& lineElementsBuffer,
-               const StyleBucketFill& properties);
+               const StyleBucketFill& properties,
+               util::Arena& arena,
+               bool fringes = false);
     ~FillBucket();
 
-    virtual void render(Painter& painter, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix);
+    virtual void render(Painter& painter, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix);
     virtual bool hasData() const;
+    virtual MemoryUsage memoryUsage() const;
+
+    // Picks the color of the next feature, if features are colored individually. Returns false if
+    // the feature isn't drawn.
+    bool setFeature(const VectorTileTagExtractor& tags);
+
+    void addGeometry(const GeometryCollection& rings);
+
+    // Waits for all outstanding tessellations and adds them to the buffers. Must
+    // be called after the last geometry was added.
+    void flush();
+
+    // Copies out the geometry of the bucket, for the bucket cache. Must be called before the
+    // buffers are uploaded.
+    void save(CachedBucket &cached) const;
+
+    // Adds cached geometry to this empty bucket. Returns false, and leaves the bucket empty, if the
+    // geometry doesn't fit the buffers.
+    bool load(const CachedBucket &cached);
 
-    void addGeometry(pbf& data);
-    void tessellate();
+    // Groups that the culler rejects are skipped.
+    void drawElements(PlainShader& shader, const ElementCuller& culler);
+    void drawElements(PatternShader& shader, const ElementCuller& culler);
+    void drawElements(PlainColorShader& shader, const ElementCuller& culler);
+    void drawElements(PlainFringeShader& shader, const ElementCuller& culler);
+    void drawVertices(OutlineShader& shader, const ElementCuller& culler);
+    void drawVertices(OutlineColorShader& shader, const ElementCuller& culler);
 
-    void drawElements(PlainShader& shader);
-    void drawElements(PatternShader& shader);
-    void drawVertices(OutlineShader& shader);
+    // Whether every vertex has the color of its feature.
+    inline bool hasFeatureColors() const {
+        return !properties.color_property.empty();
+    }
+
+    // Whether the triangles include an antialiasing fringe around the outline. It is drawn with
+    // the plain fringe shader; other shaders don't extrude it, which leaves it without area.
+    inline bool hasFringes() const {
+        return fringes;
+    }
 
 public:
     const StyleBucketFill &properties;
 
 private:
-    TESSalloc *allocator;
-    TESStesselator *tesselator;
+    static TESSalloc createAllocator(util::Arena &arena);
+    static void addRings(ClipperLib::Clipper &clipper, const GeometryCollection &rings);
+    static void tessellate(ClipperLib::Clipper &clipper, TESSalloc &allocator, Tessellation &result);
+    void merge(Tessellation &result);
+
+    // Scratch memory for the tesselator. It is only used while geometry is being
+    // added, and is rewound after every tessellation.
+    util::Arena& arena;
+    TESSalloc allocator;
     ClipperLib::Clipper clipper;
+    Tessellation tessellation;
+
+    // The color of the feature whose geometry is added next.
+    FillColorBuffer::color_type featureColor {{ 0, 0, 0, 0 }};
+
+    // Tessellations of very large features that run concurrently.
+    std::deque<std::future<Tessellation>> pending;
 
     FillVertexBuffer& vertexBuffer;
+    FillColorBuffer& colorBuffer;
+    FillFringeBuffer& fringeBuffer;
     TriangleElementsBuffer& triangleElementsBuffer;
     LineElementsBuffer& lineElementsBuffer;
 
     // hold information on where the vertices are located in the FillBuffer
     const size_t vertex_start;
+    const size_t color_start;
+    const size_t fringe_start;
     const size_t triangle_elements_start;
     const size_t line_elements_start;
     VertexArrayObject array;
 
+    const bool fringes;
+
     std::vector<triangle_group_type> triangleGroups;
     std::vector<line_group_type> lineGroups;
 
-    std::vector<ClipperLib::IntPoint> line;
-    bool hasVertices = false;
-
     static const int vertexSize = 2;
     static const int stride = sizeof(TESSreal) * vertexSize;
     static const int vertices_per_group = 3;
+
+    // Features with at least this many vertices are tessellated concurrently.
+    static const size_t parallel_vertex_count = 4096;
+
+    // Features that are a single ring with at most this many vertices are triangulated by
+    // clipping ears instead of with libtess2.
+    static const size_t ear_clipping_vertex_count = 64;
+
+    // The triangles of tessellations with at least this many are reordered for the vertex cache.
+    // Smaller ones mostly fit into the cache anyway.
+    static const size_t vertex_cache_triangle_count = 128;
 };
 
 }
@@ -0,0 +1,137 @@
+#include <mbgl/renderer/gpu_timer.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+using namespace mbgl;
+
+namespace {
+
+// Frames that the averages cover.
+const size_t windowSize = 60;
+
+// Frames that may wait for their results. Drivers usually run two or three frames behind; beyond
+// this, the oldest frame is given up so that the queries don't pile up.
+const size_t maxPendingFrames = 6;
+
+}
+
+GLuint GPUTimer::takeQuery() {
+    if (unused.empty()) {
+        GLuint ids[16];
+        MBGL_CHECK_ERROR(gl::GenQueries(16, ids));
+        unused.insert(unused.end(), ids, ids + 16);
+    }
+    const GLuint id = unused.back();
+    unused.pop_back();
+    return id;
+}
+
+void GPUTimer::begin(const std::string &name) {
+    assert(!running);
+    if (!gl::isTimerQuerySupported()) {
+        return;
+    }
+    current.push_back({ takeQuery(), name });
+    MBGL_CHECK_ERROR(gl::BeginQuery(GL_TIME_ELAPSED, current.back().id));
+    running = true;
+}
+
+void GPUTimer::end() {
+    if (running) {
+        MBGL_CHECK_ERROR(gl::EndQuery(GL_TIME_ELAPSED));
+        running = false;
+    }
+}
+
+void GPUTimer::frame() {
+    assert(!running);
+    if (!current.empty()) {
+        pending.push_back(std::move(current));
+        current.clear();
+    }
+
+    // A disjoint operation invalidates every result that is in flight.
+    GLint disjoint = 0;
+    if (gl::isTimerQueryDisjointSupported) {
+        MBGL_CHECK_ERROR(glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint));
+    }
+
+    while (!pending.empty() && (pending.size() > maxPendingFrames || isAvailable(pending.front()))) {
+        collect(pending.front(), !disjoint && isAvailable(pending.front()));
+        recycle(pending.front());
+        pending.pop_front();
+    }
+}
+
+bool GPUTimer::isAvailable(const std::vector<Query> &frame) const {
+    // Queries finish in order, so the last one decides.
+    GLuint available = GL_FALSE;
+    MBGL_CHECK_ERROR(gl::GetQueryObjectuiv(frame.back().id, GL_QUERY_RESULT_AVAILABLE, &available));
+    return available == GL_TRUE;
+}
+
+void GPUTimer::collect(const std::vector<Query> &frame, bool valid) {
+    if (!valid) {
+        return;
+    }
+
+    std::map<std::string, uint64_t> durations;
+    for (const Query &query : frame) {
+        uint64_t elapsed = 0;
+        MBGL_CHECK_ERROR(gl::GetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsed));
+        durations[query.name] += elapsed;
+    }
+    window.push_back(std::move(durations));
+    if (window.size() > windowSize) {
+        window.pop_front();
+    }
+
+    std::map<std::string, uint64_t> sums;
+    for (const auto &entry : window) {
+        for (const auto &duration : entry) {
+            sums[duration.first] += duration.second;
+        }
+    }
+
+    GPUTimes result;
+    for (const auto &sum : sums) {
+        result.emplace_back(sum.first, sum.second / 1e6 / window.size());
+    }
+    std::sort(result.begin(), result.end(), [](const std::pair<std::string, double> &a,
+                                               const std::pair<std::string, double> &b) {
+        return a.second > b.second;
+    });
+
+    std::lock_guard<std::mutex> lock(mtx);
+    times.swap(result);
+}
+
+void GPUTimer::recycle(std::vector<Query> &frame) {
+    for (const Query &query : frame) {
+        unused.push_back(query.id);
+    }
+    frame.clear();
+}
+
+void GPUTimer::reset() {
+    end();
+    for (auto &frame : pending) {
+        recycle(frame);
+    }
+    pending.clear();
+    recycle(current);
+    if (!unused.empty()) {
+        MBGL_CHECK_ERROR(gl::DeleteQueries(GLsizei(unused.size()), unused.data()));
+        unused.clear();
+    }
+    window.clear();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    times.clear();
+}
+
+GPUTimes GPUTimer::getTimes() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return times;
+}
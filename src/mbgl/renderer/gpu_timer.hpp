@@ -0,0 +1,63 @@
+#ifndef MBGL_RENDERER_GPU_TIMER
+#define MBGL_RENDERER_GPU_TIMER
+
+#include <mbgl/platform/gl.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mbgl {
+
+// Milliseconds that the GPU spent on each part of a frame, most expensive first.
+typedef std::vector<std::pair<std::string, double>> GPUTimes;
+
+// Measures how long the GPU takes for named parts of a frame with timer queries. The results only
+// arrive a few frames later, so they are averaged over the last frames that finished. Everything
+// but getTimes() must be called on the thread that has the GL context current.
+class GPUTimer : private util::noncopyable {
+public:
+    // Measurements can't be nested. Parts with the same name add up within a frame.
+    void begin(const std::string &name);
+    void end();
+
+    // Ends the frame, and collects the results of the frames that finished on the GPU.
+    void frame();
+
+    // Deletes all queries and forgets the results.
+    void reset();
+
+    // Averages over the last frames. May be called on any thread.
+    GPUTimes getTimes() const;
+
+private:
+    struct Query {
+        GLuint id;
+        std::string name;
+    };
+
+    GLuint takeQuery();
+    // Whether all queries of the frame have their result.
+    bool isAvailable(const std::vector<Query> &frame) const;
+    void collect(const std::vector<Query> &frame, bool valid);
+    void recycle(std::vector<Query> &frame);
+
+    std::vector<GLuint> unused;
+    std::vector<Query> current;
+    std::deque<std::vector<Query>> pending;
+    bool running = false;
+
+    // Nanoseconds per name for each of the last frames that finished.
+    std::deque<std::map<std::string, uint64_t>> window;
+
+    mutable std::mutex mtx;
+    GPUTimes times;
+};
+
+}
+
+#endif
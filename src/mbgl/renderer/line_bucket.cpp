@@ -3,11 +3,13 @@
 #include <mbgl/geometry/geometry.hpp>
 
 #include <mbgl/renderer/painter.hpp>
+#include <mbgl/renderer/bucket_cache.hpp>
 #include <mbgl/style/style.hpp>
 #include <mbgl/map/vector_tile.hpp>
 
 #include <mbgl/util/math.hpp>
-#include <mbgl/platform/gl.hpp>
+#include <mbgl/util/simplify.hpp>
+#include <mbgl/platform/gl_state.hpp>
 
 #define BUFFER_OFFSET(i) ((char *)nullptr + (i))
 
@@ -19,36 +21,24 @@ using namespace mbgl;
 
 LineBucket::LineBucket(LineVertexBuffer& vertexBuffer_,
                        TriangleElementsBuffer& triangleElementsBuffer_,
-                       PointElementsBuffer& pointElementsBuffer_,
-                       const StyleBucketLine& properties_)
+                       const StyleBucketLine& properties_,
+                       double tolerance_)
     : properties(properties_),
       vertexBuffer(vertexBuffer_),
       triangleElementsBuffer(triangleElementsBuffer_),
-      pointElementsBuffer(pointElementsBuffer_),
+      tolerance(tolerance_),
       vertex_start(vertexBuffer_.index()),
-      triangle_elements_start(triangleElementsBuffer_.index()),
-      point_elements_start(pointElementsBuffer_.index())
+      triangle_elements_start(triangleElementsBuffer_.index())
 {
 }
 
-void LineBucket::addGeometry(pbf& geom) {
-    std::vector<Coordinate> line;
-    Geometry::command cmd;
-
-    Coordinate coord;
-    Geometry geometry(geom);
-    int32_t x, y;
-    while ((cmd = geometry.next(x, y)) != Geometry::end) {
-        if (cmd == Geometry::move_to) {
-            if (!line.empty()) {
-                addGeometry(line);
-                line.clear();
-            }
+void LineBucket::addGeometry(const GeometryCollection& lines) {
+    for (const std::vector<Coordinate>& line : lines) {
+        if (tolerance > 0) {
+            addGeometry(util::simplify(line, tolerance));
+        } else {
+            addGeometry(line);
         }
-        line.emplace_back(x, y);
-    }
-    if (line.size()) {
-        addGeometry(line);
     }
 }
 
@@ -57,7 +47,46 @@ struct TriangleElement {
     uint16_t a, b, c;
 };
 
-typedef uint16_t PointElement;
+namespace {
+
+// The extrusion of the vertices of a line, computed in passes over arrays of floats that compilers
+// can vectorize: the normals of all segments first, then the joins between them. Only adding the
+// vertices branches on the join type, and carries the flip state from one vertex to the next. The
+// arrays are kept for the next line that the thread adds.
+struct LineExtrusion {
+    // Of the vertices that aren't followed by a duplicate: their position in the line, and the
+    // length of the line up to them.
+    std::vector<uint32_t> index;
+    std::vector<double> distance;
+
+    // The normal of the segment towards the next vertex, and the reversed normal of the segment
+    // from the previous one.
+    std::vector<float> nextX, nextY;
+    std::vector<float> prevX, prevY;
+
+    // The extrusion of a miter join, whether the vertex gets one, and whether it flips the sides
+    // of the line because it became a bevel.
+    std::vector<float> joinX, joinY;
+    std::vector<uint8_t> miter, flip;
+
+    void clear() {
+        index.clear();
+        distance.clear();
+        nextX.clear();
+        nextY.clear();
+    }
+
+    void resize(size_t size) {
+        prevX.resize(size);
+        prevY.resize(size);
+        joinX.resize(size);
+        joinY.resize(size);
+        miter.resize(size);
+        flip.resize(size);
+    }
+};
+
+}
 
 void LineBucket::addGeometry(const std::vector<Coordinate>& vertices) {
     // TODO: use roundLimit
@@ -68,213 +97,182 @@ void LineBucket::addGeometry(const std::vector<Coordinate>& vertices) {
         return;
     }
 
-    Coordinate firstVertex = vertices.front();
-    Coordinate lastVertex = vertices.back();
-    bool closed = firstVertex.x == lastVertex.x && firstVertex.y == lastVertex.y;
+    const size_t size = vertices.size();
+    const Coordinate &firstVertex = vertices.front();
+    const Coordinate &lastVertex = vertices.back();
+    const bool closed = firstVertex.x == lastVertex.x && firstVertex.y == lastVertex.y;
 
-    if (vertices.size() == 2 && closed) {
+    if (size == 2 && closed) {
         // fprintf(stderr, "a line may not have coincident points\n");
         return;
     }
 
-    CapType beginCap = properties.cap;
-    CapType endCap = closed ? CapType::Butt : properties.cap;
+    const CapType beginCap = properties.cap;
+    const CapType endCap = closed ? CapType::Butt : properties.cap;
+    const float miterLimit = properties.miter_limit;
+
+    static thread_local LineExtrusion extrusion;
+    extrusion.clear();
+
+    // Collect the vertices with the direction towards the next one. Vertices that are followed by
+    // a duplicate are skipped. Closed lines treat the last vertex like the first, and start with
+    // the length of their last segment.
+    double distance = closed ? util::dist<double>(firstVertex, vertices[size - 2]) : 0;
+    for (size_t i = 0; i < size; ++i) {
+        const Coordinate &currentVertex = vertices[i];
+        if (i > 0) {
+            distance += util::dist<double>(currentVertex, vertices[i - 1]);
+        }
 
-    JoinType currentJoin = JoinType::Miter;
+        float dx = 0, dy = 0;
+        if (i + 1 < size || closed) {
+            const Coordinate &nextVertex = i + 1 < size ? vertices[i + 1] : vertices[1];
+            if (currentVertex.x == nextVertex.x && currentVertex.y == nextVertex.y) {
+                continue;
+            }
+            dx = nextVertex.x - currentVertex.x;
+            dy = nextVertex.y - currentVertex.y;
+        }
 
-    Coordinate currentVertex = Coordinate::null(),
-               prevVertex = Coordinate::null(),
-               nextVertex = Coordinate::null();
-    vec2<double> prevNormal = vec2<double>::null(),
-                 nextNormal = vec2<double>::null();
+        extrusion.index.push_back(uint32_t(i));
+        extrusion.distance.push_back(distance);
+        extrusion.nextX.push_back(dx);
+        extrusion.nextY.push_back(dy);
+    }
 
-    int32_t e1 = -1, e2 = -1, e3 = -1;
+    // A line needs at least one segment.
+    const size_t count = extrusion.index.size();
+    if (count < 2) {
+        return;
+    }
+    extrusion.resize(count);
+
+    float *nextX = extrusion.nextX.data(), *nextY = extrusion.nextY.data();
+    float *prevX = extrusion.prevX.data(), *prevY = extrusion.prevY.data();
+    float *joinX = extrusion.joinX.data(), *joinY = extrusion.joinY.data();
+    uint8_t *miter = extrusion.miter.data(), *flips = extrusion.flip.data();
+
+    // Normalize the directions of the segments. In case there is no next vertex, pretend that the
+    // line is continuing straight.
+    const size_t segments = closed ? count : count - 1;
+    for (size_t k = 0; k < segments; ++k) {
+        const float length = std::sqrt(nextX[k] * nextX[k] + nextY[k] * nextY[k]);
+        nextX[k] /= length;
+        nextY[k] /= length;
+    }
+    if (!closed) {
+        nextX[count - 1] = nextX[count - 2];
+        nextY[count - 1] = nextY[count - 2];
+    }
 
-    int8_t flip = 1;
-    double distance = 0;
+    // The previous normal of the first vertex is that of the segment that closes the line. The
+    // beginning of a non-closed line is a straight "join".
+    const Coordinate &closingVertex = vertices[size - 2];
+    if (closed && (closingVertex.x != lastVertex.x || closingVertex.y != lastVertex.y)) {
+        const vec2<float> closingNormal = util::normal<float>(closingVertex, lastVertex);
+        prevX[0] = -closingNormal.x;
+        prevY[0] = -closingNormal.y;
+    } else {
+        prevX[0] = -nextX[0];
+        prevY[0] = -nextY[0];
+    }
+    for (size_t k = 1; k < count; ++k) {
+        prevX[k] = -nextX[k - 1];
+        prevY[k] = -nextY[k - 1];
+    }
 
-    if (closed) {
-        currentVertex = vertices[vertices.size() - 2];
-        nextNormal = util::normal<double>(currentVertex, lastVertex);
+    const bool miterJoins = properties.join == JoinType::Miter;
+    for (size_t k = 0; k < count; ++k) {
+        // Determine the normal of the join extrusion. It is the angle bisector of the segments
+        // between the previous line and the next line. The cross product yields 0..1 depending on
+        // whether they are parallel or perpendicular.
+        float x = prevX[k] + nextX[k];
+        float y = prevY[k] + nextY[k];
+        const float joinAngularity = nextX[k] * y - nextY[k] * x;
+        x /= joinAngularity;
+        y /= joinAngularity;
+        const float roundness = std::fmax(std::fabs(x), std::fabs(y));
+
+        // Switch to miter joins if the angle is very low. If the miter grows too large, flip the
+        // direction to make a bevel join. If the two normals are almost parallel, extrude
+        // perpendicular to the line.
+        const bool bevel = roundness > miterLimit;
+        const bool parallel = std::fabs(joinAngularity) < 0.01f;
+        miter[k] = miterJoins || (std::fabs(joinAngularity) < 0.5f && roundness < miterLimit);
+        flips[k] = bevel;
+        joinX[k] = parallel ? -nextY[k] : bevel ? (prevX[k] - nextX[k]) / joinAngularity : x;
+        joinY[k] = parallel ? nextX[k] : bevel ? (prevY[k] - nextY[k]) / joinAngularity : y;
     }
 
     int32_t start_vertex = (int32_t)vertexBuffer.index();
 
-    std::vector<TriangleElement> triangle_store;
-    std::vector<PointElement> point_store;
-
-    for (size_t i = 0; i < vertices.size(); ++i) {
-        if (nextNormal) prevNormal = { -nextNormal.x, -nextNormal.y };
-        if (currentVertex) prevVertex = currentVertex;
-
-        currentVertex = vertices[i];
-        currentJoin = properties.join;
-
-        if (prevVertex) distance += util::dist<double>(currentVertex, prevVertex);
-
-        // Find the next vertex.
-        if (i + 1 < vertices.size()) {
-            nextVertex = vertices[i + 1];
-        } else {
-            nextVertex = Coordinate::null();
-        }
-
-        // If the line is closed, we treat the last vertex like the first vertex.
-        if (!nextVertex && closed) {
-            nextVertex = vertices[1];
-        }
-
-        if (nextVertex) {
-            // if two consecutive vertices exist, skip one
-            if (currentVertex.x == nextVertex.x && currentVertex.y == nextVertex.y) continue;
-        }
+    // Every vertex of the line is extruded to both sides, so there are at least two vertices and
+    // two triangles per vertex; joins may add more.
+    vertexBuffer.reserve(count * 2);
 
-        // Calculate the normal towards the next vertex in this line. In case
-        // there is no next vertex, pretend that the line is continuing straight,
-        // meaning that we are just reversing the previous normal
-        if (nextVertex) {
-            nextNormal = util::normal<double>(currentVertex, nextVertex);
-        } else {
-            nextNormal = { -prevNormal.x, -prevNormal.y };
-        }
+    std::vector<TriangleElement> triangle_store;
+    triangle_store.reserve(count * 2);
 
-        // If we still don't have a previous normal, this is the beginning of a
-        // non-closed line, so we're doing a straight "join".
-        if (!prevNormal) {
-            prevNormal = { -nextNormal.x, -nextNormal.y };
-        }
+    int32_t e1 = -1, e2 = -1, e3 = -1;
+    int8_t flip = 1;
 
-        // Determine the normal of the join extrusion. It is the angle bisector
-        // of the segments between the previous line and the next line.
-        vec2<double> joinNormal = {
-            prevNormal.x + nextNormal.x,
-            prevNormal.y + nextNormal.y
+    for (size_t k = 0; k < count; ++k) {
+        const size_t i = extrusion.index[k];
+        const Coordinate &currentVertex = vertices[i];
+        const int32_t linesofar = extrusion.distance[k];
+        const bool hasPrev = i > 0 || closed;
+        const bool hasNext = k + 1 < count || closed;
+        const float nx = nextX[k], ny = nextY[k];
+        const float px = prevX[k], py = prevY[k];
+
+        const auto addVertex = [&](float ex, float ey, int8_t tx, int8_t ty) {
+            e3 = (int32_t)vertexBuffer.add(currentVertex.x, currentVertex.y, ex, ey, tx, ty, linesofar) - start_vertex;
+            if (e1 >= 0 && e2 >= 0 && e3 >= 0) triangle_store.emplace_back(e1, e2, e3);
+            e1 = e2; e2 = e3;
         };
 
-        // Cross product yields 0..1 depending on whether they are parallel
-        // or perpendicular.
-        double joinAngularity = nextNormal.x * joinNormal.y - nextNormal.y * joinNormal.x;
-        joinNormal.x /= joinAngularity;
-        joinNormal.y /= joinAngularity;
-        double roundness = std::fmax(std::abs(joinNormal.x), std::abs(joinNormal.y));
-
+        // Round caps and joins are drawn as a square that extends the line by its width. Its
+        // vertices set the round bit of the texture normal, so that the fragment shader fades out
+        // everything that is farther than the line width away from the vertex.
 
-        // Switch to miter joins if the angle is very low.
-        if (currentJoin != JoinType::Miter) {
-            if (std::fabs(joinAngularity) < 0.5 && roundness < properties.miter_limit) {
-                currentJoin = JoinType::Miter;
-            }
+        // Add round begin cap. The line continues with the vertices of the join below.
+        if (!hasPrev && beginCap == CapType::Round) {
+            addVertex(flip * (px + py), flip * (-px + py), 1, 0);
+            addVertex(flip * (px - py), flip * (px + py), 1, 1);
         }
 
         // Add offset square begin cap.
-        if (!prevVertex && beginCap == CapType::Square) {
-            // Add first vertex
-            e3 = (int32_t)vertexBuffer.add(currentVertex.x, currentVertex.y, // vertex pos
-                                   flip * (prevNormal.x + prevNormal.y), flip * (-prevNormal.x + prevNormal.y), // extrude normal
-                                   0, 0, distance) - start_vertex; // texture normal
-
-            if (e1 >= 0 && e2 >= 0 && e3 >= 0) triangle_store.emplace_back(e1, e2, e3);
-            e1 = e2; e2 = e3;
-
-            // Add second vertex
-            e3 = (int32_t)vertexBuffer.add(currentVertex.x, currentVertex.y, // vertex pos
-                                   flip * (prevNormal.x - prevNormal.y), flip * (prevNormal.x + prevNormal.y), // extrude normal
-                                   0, 1, distance) - start_vertex; // texture normal
-
-            if (e1 >= 0 && e2 >= 0 && e3 >= 0) triangle_store.emplace_back(e1, e2, e3);
-            e1 = e2; e2 = e3;
+        if (!hasPrev && beginCap == CapType::Square) {
+            addVertex(flip * (px + py), flip * (-px + py), 0, 0);
+            addVertex(flip * (px - py), flip * (px + py), 0, 1);
         }
 
         // Add offset square end cap.
-        else if (!nextVertex && endCap == CapType::Square) {
-            // Add first vertex
-            e3 = (int32_t)vertexBuffer.add(currentVertex.x, currentVertex.y, // vertex pos
-                                   nextNormal.x - flip * nextNormal.y, flip * nextNormal.x + nextNormal.y, // extrude normal
-                                   0, 0, distance) - start_vertex; // texture normal
-
-            if (e1 >= 0 && e2 >= 0 && e3 >= 0) triangle_store.emplace_back(e1, e2, e3);
-            e1 = e2; e2 = e3;
-
-            // Add second vertex
-            e3 = (int32_t)vertexBuffer.add(currentVertex.x, currentVertex.y, // vertex pos
-                                   nextNormal.x + flip * nextNormal.y, -flip * nextNormal.x + nextNormal.y, // extrude normal
-                                   0, 1, distance) - start_vertex; // texture normal
-
-            if (e1 >= 0 && e2 >= 0 && e3 >= 0) triangle_store.emplace_back(e1, e2, e3);
-            e1 = e2; e2 = e3;
+        else if (!hasNext && endCap == CapType::Square) {
+            addVertex(nx - flip * ny, flip * nx + ny, 0, 0);
+            addVertex(nx + flip * ny, -flip * nx + ny, 0, 1);
         }
 
-        else if (currentJoin == JoinType::Miter) {
+        else if (miter[k]) {
             // MITER JOIN
-            if (std::fabs(joinAngularity) < 0.01) {
-                // The two normals are almost parallel.
-                joinNormal.x = -nextNormal.y;
-                joinNormal.y = nextNormal.x;
-            } else if (roundness > properties.miter_limit) {
-                // If the miter grows too large, flip the direction to make a
-                // bevel join.
-                joinNormal.x = (prevNormal.x - nextNormal.x) / joinAngularity;
-                joinNormal.y = (prevNormal.y - nextNormal.y) / joinAngularity;
-            }
-
-            if (roundness > properties.miter_limit) {
+            if (flips[k]) {
                 flip = -flip;
             }
-
-            // Add first vertex
-            e3 = (int32_t)vertexBuffer.add(currentVertex.x, currentVertex.y, // vertex pos
-                                   flip * joinNormal.x, flip * joinNormal.y, // extrude normal
-                                   0, 0, distance) - start_vertex; // texture normal
-
-            if (e1 >= 0 && e2 >= 0 && e3 >= 0) triangle_store.emplace_back(e1, e2, e3);
-            e1 = e2; e2 = e3;
-
-            // Add second vertex
-            e3 = (int32_t)vertexBuffer.add(currentVertex.x, currentVertex.y, // vertex pos
-                                   -flip * joinNormal.x, -flip * joinNormal.y, // extrude normal
-                                   0, 1, distance) - start_vertex; // texture normal
-
-            if (e1 >= 0 && e2 >= 0 && e3 >= 0) triangle_store.emplace_back(e1, e2, e3);
-            e1 = e2; e2 = e3;
-
-            if ((!prevVertex && beginCap == CapType::Round) ||
-                    (!nextVertex && endCap == CapType::Round)) {
-                point_store.emplace_back(e1);
-            }
+            addVertex(flip * joinX[k], flip * joinY[k], 0, 0);
+            addVertex(-flip * joinX[k], -flip * joinY[k], 0, 1);
         }
 
         else {
             // Close up the previous line
-            // Add first vertex
-            e3 = (int32_t)vertexBuffer.add(currentVertex.x, currentVertex.y, // vertex pos
-                                   flip * prevNormal.y, -flip * prevNormal.x, // extrude normal
-                                   0, 0, distance) - start_vertex; // texture normal
-
-            if (e1 >= 0 && e2 >= 0 && e3 >= 0) triangle_store.emplace_back(e1, e2, e3);
-            e1 = e2; e2 = e3;
-
-            // Add second vertex.
-            e3 = (int32_t)vertexBuffer.add(currentVertex.x, currentVertex.y, // vertex pos
-                                   -flip * prevNormal.y, flip * prevNormal.x, // extrude normal
-                                   0, 1, distance) - start_vertex; // texture normal
-
-            if (e1 >= 0 && e2 >= 0 && e3 >= 0) triangle_store.emplace_back(e1, e2, e3);
-            e1 = e2; e2 = e3;
-
-            prevNormal = { -nextNormal.x, -nextNormal.y };
-            flip = 1;
-
-
-            // begin/end caps
-            if ((!prevVertex && beginCap == CapType::Round) ||
-                    (!nextVertex && endCap == CapType::Round)) {
-                point_store.emplace_back(e1);
-            }
-
-
-            if (currentJoin == JoinType::Round) {
-                if (prevVertex && nextVertex && (!closed || i > 0)) {
-                    point_store.emplace_back(e1);
+            addVertex(flip * py, -flip * px, 0, 0);
+            addVertex(-flip * py, flip * px, 0, 1);
+
+            if (properties.join == JoinType::Round) {
+                if (hasPrev && hasNext && (!closed || i > 0)) {
+                    // End the previous line with a round cap, which covers the gap on the outer
+                    // side of the join.
+                    addVertex(flip * py - px, -flip * px - py, 1, 0);
+                    addVertex(-flip * py - px, flip * px - py, 1, 1);
                 }
 
                 // Reset the previous vertices so that we don't accidentally create
@@ -283,35 +281,37 @@ void LineBucket::addGeometry(const std::vector<Coordinate>& vertices) {
             }
 
             // Start the new quad.
-            // Add first vertex
-            e3 = (int32_t)vertexBuffer.add(currentVertex.x, currentVertex.y, // vertex pos
-                                   -flip * nextNormal.y, flip * nextNormal.x, // extrude normal
-                                   0, 0, distance) - start_vertex; // texture normal
-
-            if (e1 >= 0 && e2 >= 0 && e3 >= 0) triangle_store.emplace_back(e1, e2, e3);
-            e1 = e2; e2 = e3;
-
-            // Add second vertex
-            e3 = (int32_t)vertexBuffer.add(currentVertex.x, currentVertex.y, // vertex pos
-                                   flip * nextNormal.y, -flip * nextNormal.x, // extrude normal
-                                   0, 1, distance) - start_vertex; // texture normal
+            flip = 1;
+            addVertex(-ny, nx, 0, 0);
+            addVertex(ny, -nx, 0, 1);
+        }
 
-            if (e1 >= 0 && e2 >= 0 && e3 >= 0) triangle_store.emplace_back(e1, e2, e3);
-            e1 = e2; e2 = e3;
+        // Add round end cap after the vertices of the join.
+        if (!hasNext && endCap == CapType::Round) {
+            addVertex(nx - flip * ny, flip * nx + ny, 1, 0);
+            addVertex(nx + flip * ny, -flip * nx + ny, 1, 1);
         }
     }
 
     size_t end_vertex = vertexBuffer.index();
     size_t vertex_count = end_vertex - start_vertex;
 
+    // Joins may extrude the line by up to the miter limit times its width.
+    ElementBounds bounds;
+    for (const Coordinate& vertex : vertices) {
+        bounds.extend(vertex.x, vertex.y);
+    }
+    bounds.extent = std::max(properties.miter_limit, 1.0f);
+
     // Store the triangle/line groups.
     {
-        if (!triangleGroups.size() || (triangleGroups.back().vertex_length + vertex_count > 65535)) {
+        if (!triangleGroups.size() || (triangleGroups.back().vertex_length + vertex_count > triangleElementsBuffer.maxGroupVertices())) {
             // Move to a new group because the old one can't hold the geometry.
             triangleGroups.emplace_back();
         }
 
         triangle_group_type& group = triangleGroups.back();
+        triangleElementsBuffer.reserve(triangle_store.size());
         for (const TriangleElement& triangle : triangle_store) {
             triangleElementsBuffer.add(
                 group.vertex_length + triangle.a,
@@ -322,96 +322,84 @@ void LineBucket::addGeometry(const std::vector<Coordinate>& vertices) {
 
         group.vertex_length += vertex_count;
         group.elements_length += triangle_store.size();
+        group.bounds.extend(bounds);
     }
+}
 
-    // Store the line join/cap groups.
-    {
-        if (!pointGroups.size() || (pointGroups.back().vertex_length + vertex_count > 65535)) {
-            // Move to a new group because the old one can't hold the geometry.
-            pointGroups.emplace_back();
-        }
+void LineBucket::render(Painter& painter, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix) {
+    painter.renderLine(*this, layer_desc, id, matrix);
+}
 
-        point_group_type& group = pointGroups.back();
-        for (PointElement point : point_store) {
-            pointElementsBuffer.add(group.vertex_length + point);
-        }
+void LineBucket::save(CachedBucket &cached) const {
+    saveGroups(triangleGroups, cached.triangleGroups);
+    const std::pair<uint64_t, uint64_t> triangles = countGroups(cached.triangleGroups);
+    cached.vertices = { vertexBuffer.data(vertex_start), triangles.first * vertexBuffer.itemSize };
+    cached.triangles = { triangleElementsBuffer.data(triangle_elements_start), triangles.second * triangleElementsBuffer.itemSize };
+}
 
-        group.vertex_length += vertex_count;
-        group.elements_length += point_store.size();
+bool LineBucket::load(const CachedBucket &cached) {
+    const std::pair<uint64_t, uint64_t> triangles = countGroups(cached.triangleGroups);
+    if (cached.vertices.size != triangles.first * vertexBuffer.itemSize ||
+        cached.triangles.size != triangles.second * triangleElementsBuffer.itemSize ||
+        !cached.lineGroups.empty() || cached.colors.size || cached.lines.size) {
+        return false;
     }
-}
 
-void LineBucket::render(Painter& painter, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix) {
-    painter.renderLine(*this, layer_desc, id, matrix);
+    vertexBuffer.append(cached.vertices.data, triangles.first);
+    triangleElementsBuffer.append(cached.triangles.data, triangles.second);
+    loadGroups(cached.triangleGroups, triangleGroups);
+    return true;
 }
 
 bool LineBucket::hasData() const {
-    return !triangleGroups.empty() || !pointGroups.empty();
+    return !triangleGroups.empty();
 }
 
-bool LineBucket::hasPoints() const {
-    if (!pointGroups.empty()) {
-        for (const point_group_type& group : pointGroups) {
-            if (group.elements_length) {
-                return true;
-            }
-        }
+MemoryUsage LineBucket::memoryUsage() const {
+    size_t vertices = 0, triangles = 0;
+    for (const triangle_group_type& group : triangleGroups) {
+        vertices += group.vertex_length;
+        triangles += group.elements_length;
     }
-    return false;
+    return vertexBuffer.memoryUsage(vertices) +
+           triangleElementsBuffer.memoryUsage(triangles);
 }
 
-void LineBucket::drawLines(LineShader& shader) {
+void LineBucket::drawLines(LineShader& shader, const ElementCuller& culler) {
     char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
     char *elements_index = BUFFER_OFFSET(triangle_elements_start * triangleElementsBuffer.itemSize);
     for (triangle_group_type& group : triangleGroups) {
-        if (!group.elements_length) {
-            continue;
+        if (group.elements_length && culler.isVisible(group.bounds)) {
+            group.array[0].bind(shader, vertexBuffer, triangleElementsBuffer, vertex_index);
+            gl::State::Get().drawElements(GL_TRIANGLES, group.elements_length * 3, triangleElementsBuffer.elementType, elements_index);
         }
-        group.array[0].bind(shader, vertexBuffer, triangleElementsBuffer, vertex_index);
-        MBGL_CHECK_ERROR(glDrawElements(GL_TRIANGLES, group.elements_length * 3, GL_UNSIGNED_SHORT, elements_index));
         vertex_index += group.vertex_length * vertexBuffer.itemSize;
         elements_index += group.elements_length * triangleElementsBuffer.itemSize;
     }
 }
 
-void LineBucket::drawLineSDF(LineSDFShader& shader) {
+void LineBucket::drawLineSDF(LineSDFShader& shader, const ElementCuller& culler) {
     char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
     char *elements_index = BUFFER_OFFSET(triangle_elements_start * triangleElementsBuffer.itemSize);
     for (triangle_group_type& group : triangleGroups) {
-        if (!group.elements_length) {
-            continue;
+        if (group.elements_length && culler.isVisible(group.bounds)) {
+            group.array[2].bind(shader, vertexBuffer, triangleElementsBuffer, vertex_index);
+            gl::State::Get().drawElements(GL_TRIANGLES, group.elements_length * 3, triangleElementsBuffer.elementType, elements_index);
         }
-        group.array[2].bind(shader, vertexBuffer, triangleElementsBuffer, vertex_index);
-        MBGL_CHECK_ERROR(glDrawElements(GL_TRIANGLES, group.elements_length * 3, GL_UNSIGNED_SHORT, elements_index));
         vertex_index += group.vertex_length * vertexBuffer.itemSize;
         elements_index += group.elements_length * triangleElementsBuffer.itemSize;
     }
 }
 
-void LineBucket::drawLinePatterns(LinepatternShader& shader) {
+void LineBucket::drawLinePatterns(LinepatternShader& shader, const ElementCuller& culler) {
     char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
     char *elements_index = BUFFER_OFFSET(triangle_elements_start * triangleElementsBuffer.itemSize);
     for (triangle_group_type& group : triangleGroups) {
-        if (!group.elements_length) {
-            continue;
+        if (group.elements_length && culler.isVisible(group.bounds)) {
+            group.array[1].bind(shader, vertexBuffer, triangleElementsBuffer, vertex_index);
+            gl::State::Get().drawElements(GL_TRIANGLES, group.elements_length * 3, triangleElementsBuffer.elementType, elements_index);
         }
-        group.array[1].bind(shader, vertexBuffer, triangleElementsBuffer, vertex_index);
-        MBGL_CHECK_ERROR(glDrawElements(GL_TRIANGLES, group.elements_length * 3, GL_UNSIGNED_SHORT, elements_index));
         vertex_index += group.vertex_length * vertexBuffer.itemSize;
         elements_index += group.elements_length * triangleElementsBuffer.itemSize;
     }
 }
-
-void LineBucket::drawPoints(LinejoinShader& shader) {
-    char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
-    char *elements_index = BUFFER_OFFSET(point_elements_start * pointElementsBuffer.itemSize);
-    for (point_group_type& group : pointGroups) {
-        if (!group.elements_length) {
-            continue;
-        }
-        group.array[0].bind(shader, vertexBuffer, pointElementsBuffer, vertex_index);
-        MBGL_CHECK_ERROR(glDrawElements(GL_POINTS, group.elements_length, GL_UNSIGNED_SHORT, elements_index));
-        vertex_index += group.vertex_length * vertexBuffer.itemSize;
-        elements_index += group.elements_length * pointElementsBuffer.itemSize;
-    }
-}
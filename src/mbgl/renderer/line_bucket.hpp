@@ -5,6 +5,7 @@
 #include <mbgl/geometry/vao.hpp>
 #include <mbgl/geometry/elements_buffer.hpp>
 #include <mbgl/geometry/line_buffer.hpp>
+#include <mbgl/geometry/geometry.hpp>
 #include <mbgl/style/style_bucket.hpp>
 
 #include <vector>
@@ -15,33 +16,40 @@ class Style;
 class LineVertexBuffer;
 class TriangleElementsBuffer;
 class LineShader;
-class LinejoinShader;
 class LineSDFShader;
 class LinepatternShader;
+struct CachedBucket;
 struct pbf;
 
 class LineBucket : public Bucket {
     typedef ElementGroup<3> triangle_group_type;
-    typedef ElementGroup<1> point_group_type;
 
 public:
     LineBucket(LineVertexBuffer& vertexBuffer,
                TriangleElementsBuffer& triangleElementsBuffer,
-               PointElementsBuffer& pointElementsBuffer,
-               const StyleBucketLine& properties);
+               const StyleBucketLine& properties,
+               double tolerance = 0);
 
-    virtual void render(Painter& painter, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix);
+    virtual void render(Painter& painter, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix);
     virtual bool hasData() const;
+    virtual MemoryUsage memoryUsage() const;
 
-    void addGeometry(pbf& data);
+    // Simplifies the lines with the bucket's tolerance before adding them.
+    void addGeometry(const GeometryCollection& lines);
     void addGeometry(const std::vector<Coordinate>& line);
 
-    bool hasPoints() const;
+    // Copies out the geometry of the bucket, for the bucket cache. Must be called before the
+    // buffers are uploaded.
+    void save(CachedBucket &cached) const;
 
-    void drawLines(LineShader& shader);
-    void drawLineSDF(LineSDFShader& shader);
-    void drawLinePatterns(LinepatternShader& shader);
-    void drawPoints(LinejoinShader& shader);
+    // Adds cached geometry to this empty bucket. Returns false, and leaves the bucket empty, if the
+    // geometry doesn't fit the buffers.
+    bool load(const CachedBucket &cached);
+
+    // Groups that the culler rejects are skipped.
+    void drawLines(LineShader& shader, const ElementCuller& culler);
+    void drawLineSDF(LineSDFShader& shader, const ElementCuller& culler);
+    void drawLinePatterns(LinepatternShader& shader, const ElementCuller& culler);
 
 public:
     const StyleBucketLine &properties;
@@ -49,14 +57,14 @@ public:
 private:
     LineVertexBuffer& vertexBuffer;
     TriangleElementsBuffer& triangleElementsBuffer;
-    PointElementsBuffer& pointElementsBuffer;
+
+    // Vertices closer than this to the simplified line are dropped, in tile units.
+    const double tolerance;
 
     const size_t vertex_start;
     const size_t triangle_elements_start;
-    const size_t point_elements_start;
 
     std::vector<triangle_group_type> triangleGroups;
-    std::vector<point_group_type> pointGroups;
 };
 
 }
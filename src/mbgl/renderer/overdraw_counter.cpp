@@ -0,0 +1,131 @@
+#include <mbgl/renderer/overdraw_counter.hpp>
+
+#include <cassert>
+
+using namespace mbgl;
+
+namespace {
+
+// Frames that the averages cover.
+const size_t windowSize = 60;
+
+// Frames that may wait for their results before the oldest one is given up.
+const size_t maxPendingFrames = 6;
+
+}
+
+void OverdrawCounter::begin(RenderPass pass) {
+    assert(!running);
+    if (!gl::isSamplesQuerySupported || !gl::isTimerQuerySupported()) {
+        return;
+    }
+
+    GLuint &query = current.queries[size_t(pass)];
+    assert(!query);
+    if (unused.empty()) {
+        GLuint ids[8];
+        MBGL_CHECK_ERROR(gl::GenQueries(8, ids));
+        unused.insert(unused.end(), ids, ids + 8);
+    }
+    query = unused.back();
+    unused.pop_back();
+
+    MBGL_CHECK_ERROR(gl::BeginQuery(GL_SAMPLES_PASSED, query));
+    running = true;
+}
+
+void OverdrawCounter::end() {
+    if (running) {
+        MBGL_CHECK_ERROR(gl::EndQuery(GL_SAMPLES_PASSED));
+        running = false;
+    }
+}
+
+void OverdrawCounter::frame(uint64_t pixels) {
+    assert(!running);
+    if (current.queries[0] || current.queries[1]) {
+        current.pixels = pixels;
+        pending.push_back(current);
+        current = Frame();
+    }
+
+    while (!pending.empty() && (pending.size() > maxPendingFrames || isAvailable(pending.front()))) {
+        if (isAvailable(pending.front())) {
+            collect(pending.front());
+        }
+        recycle(pending.front());
+        pending.pop_front();
+    }
+}
+
+bool OverdrawCounter::isAvailable(const Frame &frame) const {
+    for (GLuint query : frame.queries) {
+        if (query) {
+            GLuint available = GL_FALSE;
+            MBGL_CHECK_ERROR(gl::GetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available));
+            if (available != GL_TRUE) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void OverdrawCounter::collect(const Frame &frame) {
+    if (!frame.pixels) {
+        return;
+    }
+
+    std::array<double, 2> ratios {{ 0, 0 }};
+    for (size_t i = 0; i < frame.queries.size(); i++) {
+        if (frame.queries[i]) {
+            GLuint samples = 0;
+            MBGL_CHECK_ERROR(gl::GetQueryObjectuiv(frame.queries[i], GL_QUERY_RESULT, &samples));
+            ratios[i] = double(samples) / frame.pixels;
+        }
+    }
+    window.push_back(ratios);
+    if (window.size() > windowSize) {
+        window.pop_front();
+    }
+
+    Overdraw result;
+    for (const std::array<double, 2> &entry : window) {
+        result.opaque += entry[size_t(RenderPass::Opaque)] / window.size();
+        result.translucent += entry[size_t(RenderPass::Translucent)] / window.size();
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    overdraw = result;
+}
+
+void OverdrawCounter::recycle(Frame &frame) {
+    for (GLuint &query : frame.queries) {
+        if (query) {
+            unused.push_back(query);
+            query = 0;
+        }
+    }
+}
+
+void OverdrawCounter::reset() {
+    end();
+    for (Frame &frame : pending) {
+        recycle(frame);
+    }
+    pending.clear();
+    recycle(current);
+    if (!unused.empty()) {
+        MBGL_CHECK_ERROR(gl::DeleteQueries(GLsizei(unused.size()), unused.data()));
+        unused.clear();
+    }
+    window.clear();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    overdraw = Overdraw();
+}
+
+Overdraw OverdrawCounter::getOverdraw() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return overdraw;
+}
@@ -0,0 +1,66 @@
+#ifndef MBGL_RENDERER_OVERDRAW_COUNTER
+#define MBGL_RENDERER_OVERDRAW_COUNTER
+
+#include <mbgl/platform/gl.hpp>
+#include <mbgl/renderer/render_item.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace mbgl {
+
+// Fragments that passed the depth and stencil tests in each pass of a frame, per pixel of the
+// framebuffer. 1 means that every pixel was written once.
+struct Overdraw {
+    double opaque = 0;
+    double translucent = 0;
+};
+
+// Counts the fragments that the passes of a frame write with occlusion queries. Like the GPU
+// times, the results arrive a few frames later and are averaged over the last frames that
+// finished. Everything but getOverdraw() must be called on the thread that has the GL context
+// current.
+class OverdrawCounter : private util::noncopyable {
+public:
+    // Each pass may be counted once per frame.
+    void begin(RenderPass pass);
+    void end();
+
+    // Ends a frame that covered /pixels/ pixels, and collects the frames that finished on the GPU.
+    void frame(uint64_t pixels);
+
+    // Deletes all queries and forgets the results.
+    void reset();
+
+    // May be called on any thread.
+    Overdraw getOverdraw() const;
+
+private:
+    struct Frame {
+        // Indexed by pass; 0 if the pass wasn't counted.
+        std::array<GLuint, 2> queries {{ 0, 0 }};
+        uint64_t pixels = 0;
+    };
+
+    bool isAvailable(const Frame &frame) const;
+    void collect(const Frame &frame);
+    void recycle(Frame &frame);
+
+    std::vector<GLuint> unused;
+    Frame current;
+    std::deque<Frame> pending;
+    bool running = false;
+
+    // Samples and pixels of the passes in the last frames that finished.
+    std::deque<std::array<double, 2>> window;
+
+    mutable std::mutex mtx;
+    Overdraw overdraw;
+};
+
+}
+
+#endif
@@ -7,27 +7,35 @@
 #include <mbgl/util/string.hpp>
 #include <mbgl/util/time.hpp>
 #include <mbgl/util/clip_ids.hpp>
+#include <mbgl/util/occlusion.hpp>
 #include <mbgl/util/constants.hpp>
 #include <mbgl/util/mat3.hpp>
+#include <mbgl/util/allocation_tracker.hpp>
 #include <mbgl/geometry/sprite_atlas.hpp>
 #include <mbgl/map/source.hpp>
+#include <mbgl/platform/log.hpp>
 
 #if defined(DEBUG)
 #include <mbgl/util/stopwatch.hpp>
 #endif
 
 #include <cassert>
+#include <cstdio>
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 using namespace mbgl;
 
 #define BUFFER_OFFSET(i) ((char *)nullptr + (i))
 
-Painter::Painter(SpriteAtlas& spriteAtlas_, GlyphAtlas& glyphAtlas_, LineAtlas& lineAtlas_)
+Painter::Painter(SpriteAtlas& spriteAtlas_, GlyphAtlas& glyphAtlas_, LineAtlas& lineAtlas_,
+                 FrameProfiler& profiler_)
     : spriteAtlas(spriteAtlas_)
     , glyphAtlas(glyphAtlas_)
     , lineAtlas(lineAtlas_)
+    , profiler(profiler_)
 {
 }
 
@@ -38,6 +46,19 @@ bool Painter::needsAnimation() const {
     return frameHistory.needsAnimation(300);
 }
 
+void Painter::setUploadBudget(size_t bytes) {
+    uploadBudget = bytes;
+}
+
+void Painter::setResolution(float resolution_) {
+    assert(resolution_ > 0 && resolution_ <= 1);
+    resolution = resolution_;
+}
+
+bool Painter::hasPendingUploads() const {
+    return pendingUploads;
+}
+
 void Painter::setup() {
 #if defined(DEBUG)
     util::stopwatch stopwatch("painter setup");
@@ -56,71 +77,51 @@ void Painter::setup() {
         MBGL_CHECK_ERROR(gl::DebugMessageCallback(gl::debug_callback, nullptr));
     }
 
-    setupShaders();
-
-    assert(iconShader);
-    assert(plainShader);
-    assert(outlineShader);
-    assert(lineShader);
-    assert(linejoinShader);
-    assert(linepatternShader);
-    assert(patternShader);
-    assert(rasterShader);
-    assert(sdfGlyphShader);
-    assert(sdfIconShader);
-    assert(dotShader);
-    assert(gaussianShader);
-
-
     // Blending
     // We are blending new pixels on top of old pixels. Since we have depth testing
     // and are drawing opaque fragments first front-to-back, then translucent
     // fragments back-to-front, this shades the fewest fragments possible.
-    MBGL_CHECK_ERROR(glEnable(GL_BLEND));
-    MBGL_CHECK_ERROR(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    gl::State &glState = gl::State::Get();
+    glState.reset();
+    glState.enable(GL_BLEND, true);
+    glState.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     // Set clear values
-    MBGL_CHECK_ERROR(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
-    MBGL_CHECK_ERROR(glClearDepth(1.0f));
-    MBGL_CHECK_ERROR(glClearStencil(0x0));
+    glState.clearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glState.clearDepth(1.0f);
+    glState.clearStencil(0x0);
 
     // Stencil test
-    MBGL_CHECK_ERROR(glEnable(GL_STENCIL_TEST));
-    MBGL_CHECK_ERROR(glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE));
-}
-
-void Painter::setupShaders() {
-    if (!plainShader) plainShader = util::make_unique<PlainShader>();
-    if (!outlineShader) outlineShader = util::make_unique<OutlineShader>();
-    if (!lineShader) lineShader = util::make_unique<LineShader>();
-    if (!linejoinShader) linejoinShader = util::make_unique<LinejoinShader>();
-    if (!linesdfShader) linesdfShader = util::make_unique<LineSDFShader>();
-    if (!linepatternShader) linepatternShader = util::make_unique<LinepatternShader>();
-    if (!patternShader) patternShader = util::make_unique<PatternShader>();
-    if (!iconShader) iconShader = util::make_unique<IconShader>();
-    if (!rasterShader) rasterShader = util::make_unique<RasterShader>();
-    if (!sdfGlyphShader) sdfGlyphShader = util::make_unique<SDFGlyphShader>();
-    if (!sdfIconShader) sdfIconShader = util::make_unique<SDFIconShader>();
-    if (!dotShader) dotShader = util::make_unique<DotShader>();
-    if (!gaussianShader) gaussianShader = util::make_unique<GaussianShader>();
+    glState.enable(GL_STENCIL_TEST, true);
+    glState.stencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 }
 
 void Painter::deleteShaders() {
-    plainShader = nullptr;
-    outlineShader = nullptr;
-    lineShader = nullptr;
-    linejoinShader = nullptr;
-    linepatternShader = nullptr;
-    patternShader = nullptr;
-    iconShader = nullptr;
-    rasterShader = nullptr;
-    sdfGlyphShader = nullptr;
-    sdfIconShader = nullptr;
-    dotShader = nullptr;
-    gaussianShader = nullptr;
+    plainShader.reset();
+    plainColorShader.reset();
+    plainFringeShader.reset();
+    outlineShader.reset();
+    outlineColorShader.reset();
+    lineShader.reset();
+    linesdfShader.reset();
+    linepatternShader.reset();
+    circleShader.reset();
+    patternShader.reset();
+    iconShader.reset();
+    rasterShader.reset();
+    sdfGlyphShader.reset();
+    sdfIconShader.reset();
+    dotShader.reset();
+    gaussianShader.reset();
+    iconInstancedShader.reset();
+    sdfInstancedShader.reset();
+    circleInstancedShader.reset();
 }
 
 void Painter::terminate() {
+    gpuTimer.reset();
+    overdrawCounter.reset();
+    clearTileTextures();
     deleteShaders();
 }
 
@@ -136,32 +137,32 @@ void Painter::setDebug(bool enabled) {
     debug = enabled;
 }
 
+void Painter::setGPUTiming(bool enabled) {
+    gpuTiming = enabled;
+}
+
+GPUTimes Painter::getGPUTimes() const {
+    return gpuTimer.getTimes();
+}
+
+Overdraw Painter::getOverdraw() const {
+    return overdrawCounter.getOverdraw();
+}
+
 void Painter::useProgram(uint32_t program) {
-    if (gl_program != program) {
-        MBGL_CHECK_ERROR(glUseProgram(program));
-        gl_program = program;
-    }
+    gl::State::Get().useProgram(program);
 }
 
 void Painter::lineWidth(float line_width) {
-    if (gl_lineWidth != line_width) {
-        MBGL_CHECK_ERROR(glLineWidth(line_width));
-        gl_lineWidth = line_width;
-    }
+    gl::State::Get().lineWidth(line_width);
 }
 
 void Painter::depthMask(bool value) {
-    if (gl_depthMask != value) {
-        MBGL_CHECK_ERROR(glDepthMask(value ? GL_TRUE : GL_FALSE));
-        gl_depthMask = value;
-    }
+    gl::State::Get().depthMask(value);
 }
 
 void Painter::depthRange(const float near, const float far) {
-    if (gl_depthRange[0] != near || gl_depthRange[1] != far) {
-        MBGL_CHECK_ERROR(glDepthRange(near, far));
-        gl_depthRange = {{ near, far }};
-    }
+    gl::State::Get().depthRange(near, far);
 }
 
 
@@ -181,18 +182,19 @@ void Painter::changeMatrix() {
 }
 
 void Painter::clear() {
-    gl::group group("clear");
-    MBGL_CHECK_ERROR(glStencilMask(0xFF));
+    MBGL_GL_GROUP("clear");
+    gl::State::Get().enable(GL_SCISSOR_TEST, false);
+    gl::State::Get().stencilMask(0xFF);
     depthMask(true);
 
-    MBGL_CHECK_ERROR(glClearColor(0, 0, 0, 0));
+    gl::State::Get().clearColor(0, 0, 0, 0);
     MBGL_CHECK_ERROR(glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 }
 
 void Painter::setOpaque() {
     if (pass != RenderPass::Opaque) {
         pass = RenderPass::Opaque;
-        MBGL_CHECK_ERROR(glDisable(GL_BLEND));
+        gl::State::Get().enable(GL_BLEND, false);
         depthMask(true);
     }
 }
@@ -200,7 +202,7 @@ void Painter::setOpaque() {
 void Painter::setTranslucent() {
     if (pass != RenderPass::Translucent) {
         pass = RenderPass::Translucent;
-        MBGL_CHECK_ERROR(glEnable(GL_BLEND));
+        gl::State::Get().enable(GL_BLEND, true);
         depthMask(false);
     }
 }
@@ -210,29 +212,96 @@ void Painter::setStrata(float value) {
 }
 
 void Painter::prepareTile(const Tile& tile) {
-    const GLint ref = (GLint)tile.clip.reference.to_ulong();
-    const GLuint mask = (GLuint)tile.clip.mask.to_ulong();
-    MBGL_CHECK_ERROR(glStencilFunc(GL_EQUAL, ref, mask));
+    if (!scissorClipping) {
+        const GLint ref = (GLint)tile.clip.reference.to_ulong();
+        const GLuint mask = (GLuint)tile.clip.mask.to_ulong();
+        gl::State::Get().stencilFunc(GL_EQUAL, ref, mask);
+        return;
+    }
+
+    // The corners of the tile in pixels. The rectangle holds the pixels whose centers are inside
+    // of the tile, which are the ones that the stencil quad would cover.
+    const mat4 &m = tile.matrix;
+    const float width = state.getFramebufferWidth();
+    const float height = state.getFramebufferHeight();
+    float x[2], y[2];
+    for (int i = 0; i < 2; i++) {
+        const float extent = i * 4096.0f;
+        const float w = m[3] * extent + m[7] * extent + m[15];
+        x[i] = ((m[0] * extent + m[4] * extent + m[12]) / w + 1) / 2 * width;
+        y[i] = ((m[1] * extent + m[5] * extent + m[13]) / w + 1) / 2 * height;
+    }
+    const GLint left = std::ceil(std::min(x[0], x[1]) - 0.5f);
+    const GLint right = std::ceil(std::max(x[0], x[1]) - 0.5f);
+    const GLint bottom = std::ceil(std::min(y[0], y[1]) - 0.5f);
+    const GLint top = std::ceil(std::max(y[0], y[1]) - 0.5f);
+    gl::State::Get().scissor(left, bottom, right - left, top - bottom);
+}
+
+void Painter::setClipping(bool enabled) {
+    gl::State::Get().enable(scissorClipping ? GL_SCISSOR_TEST : GL_STENCIL_TEST, enabled);
 }
 
 void Painter::render(const Style& style, const std::set<util::ptr<StyleSource>>& sources,
                      TransformState state_, timestamp time) {
+    AllocationTracker::Scope allocations(AllocationTracker::Subsystem::Painter);
     state = state_;
+    // The setting may change on another thread, but measurements must not stop halfway.
+    timing = gpuTiming && !snapshot;
+
+    // The platform may have changed the GL state since the last frame, e.g. to draw an overlay.
+    // All textures go to the first unit, so that the texture binds can be tracked from the start.
+    gl::State::Get().reset();
+    gl::State::Get().activeTexture(GL_TEXTURE0);
+
+    // At a lower resolution, the frame is drawn as if the screen had a lower pixel ratio.
+    const std::array<uint16_t, 2> framebuffer = state.getFramebufferDimensions();
+    const bool scaled = resolution < 1 && !snapshot &&
+                        scaledTarget.bindFramebuffer(state.scaled(resolution).getFramebufferDimensions());
+    if (scaled) {
+        state = state.scaled(resolution);
+    }
 
     clear();
     resize();
     changeMatrix();
 
+    {
+        FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::Upload);
+        uploadTiles(sources);
+    }
+
     // Update all clipping IDs.
-    ClipIDGenerator generator;
-    for (const util::ptr<StyleSource> &source : sources) {
-        generator.update(source->source->getLoadedTiles());
-        source->source->updateMatrices(projMatrix, state);
+    {
+        FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::ClipIDs);
+        std::vector<std::forward_list<Tile *>> sourceTiles;
+        tileMatrices.clear();
+        bool overlapping = false;
+        for (const util::ptr<StyleSource> &source : sources) {
+            sourceTiles.push_back(source->source->getLoadedTiles());
+            overlapping = updateOcclusion(sourceTiles.back()) || overlapping;
+            source->source->updateMatrices(projMatrix, state, tileMatrices);
+        }
+        clipIDs.update(sourceTiles);
+        scissorClipping = state.getAngle() == 0 && !overlapping;
     }
 
-    drawClippingMasks(sources);
+    gl::State::Get().enable(GL_STENCIL_TEST, !scissorClipping);
+    gl::State::Get().enable(GL_SCISSOR_TEST, scissorClipping);
+    if (!scissorClipping) {
+        if (timing) gpuTimer.begin("clipping masks");
+        drawClippingMasks(sources);
+        if (timing) gpuTimer.end();
+    }
 
-    recordZoom(time, state.getNormalizedZoom());
+    if (!snapshot) {
+        recordZoom(time, state.getNormalizedZoom());
+    }
+
+    {
+        FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::TileTextures);
+        updateTileTextures(style, time);
+    }
 
     // Actually render the layers
     if (debug::renderTree) { std::cout << "{" << std::endl; indent++; }
@@ -243,9 +312,153 @@ void Painter::render(const Style& style, const std::set<util::ptr<StyleSource>>&
     // This guarantees that we have at least one function per tile called.
     // When only rendering layers via the stylesheet, it's possible that we don't
     // ever visit a tile during rendering.
+    if (timing && debug) gpuTimer.begin("debug");
     for (const util::ptr<StyleSource> &source : sources) {
         source->source->finishRender(*this);
     }
+
+    if (debug) {
+        std::vector<std::string> lines {
+            "GL state changes: " + util::toString(frameStats.calls) +
+            ", redundant: " + util::toString(frameStats.redundant)
+        };
+        if (timing) {
+            const Overdraw overdraw = overdrawCounter.getOverdraw();
+            char written[64];
+            snprintf(written, sizeof(written), "overdraw: %.2f opaque, %.2f translucent",
+                     overdraw.opaque, overdraw.translucent);
+            lines.push_back(written);
+
+            const GPUTimes times = gpuTimer.getTimes();
+            for (size_t j = 0; j < times.size() && j < 8; j++) {
+                char duration[16];
+                snprintf(duration, sizeof(duration), "%.2f ms", times[j].second);
+                lines.push_back(times[j].first + ": " + duration);
+            }
+        }
+        renderDebugText(lines);
+    }
+    if (timing && debug) gpuTimer.end();
+
+    // Whatever draws after the map, like the platform's overlays, expects the whole framebuffer.
+    gl::State::Get().enable(GL_SCISSOR_TEST, false);
+    const uint64_t pixels = uint64_t(gl_viewport[0]) * gl_viewport[1];
+    if (scaled) {
+        drawScaledFrame(framebuffer);
+    } else if (scaledTarget.memoryUsage() && !snapshot) {
+        // Frames at full resolution usually mean that the map settled.
+        scaledTarget.release();
+    }
+    frameStats = gl::State::Get().takeStats();
+    if (timing) {
+        gpuTimer.frame();
+        overdrawCounter.frame(pixels);
+    }
+}
+
+void Painter::renderSnapshot(const Style& style, const std::set<util::ptr<StyleSource>>& sources,
+                             const TransformState& state_, timestamp time,
+                             PixelReader::Callback callback) {
+    if (!snapshotTarget.bindFramebuffer(state_.getFramebufferDimensions())) {
+        callback(nullptr);
+        return;
+    }
+
+    const size_t budget = uploadBudget;
+    const bool debugging = debug;
+    uploadBudget = 0;
+    debug = false;
+    snapshot = true;
+
+    render(style, sources, state_, time);
+    pixelReader.read(gl_viewport, callback);
+
+    uploadBudget = budget;
+    debug = debugging;
+    snapshot = false;
+
+    // Snapshots are rare enough that the storage isn't worth keeping.
+    snapshotTarget.unbindFramebuffer();
+    snapshotTarget.release();
+}
+
+void Painter::finishReads() {
+    pixelReader.finish();
+}
+
+bool Painter::hasPendingReads() const {
+    return pixelReader.hasPendingReads();
+}
+
+void Painter::drawScaledFrame(const std::array<uint16_t, 2> &framebuffer) {
+    MBGL_GL_GROUP("upscale");
+    scaledTarget.unbindFramebuffer();
+    gl_viewport = framebuffer;
+    MBGL_CHECK_ERROR(glViewport(0, 0, gl_viewport[0], gl_viewport[1]));
+
+    gl::State &glState = gl::State::Get();
+    glState.enable(GL_STENCIL_TEST, false);
+    glState.enable(GL_DEPTH_TEST, false);
+    setOpaque();
+
+    // The texture's first row is the bottom of the view, like the framebuffer's. It holds
+    // premultiplied colors and replaces whatever the framebuffer held.
+    mat4 matrix;
+    matrix::ortho(matrix, 0, 4096, 0, 4096, 0, 1);
+    useProgram(rasterShader->program);
+    rasterShader->u_matrix = matrix;
+    rasterShader->u_buffer = 0;
+    rasterShader->u_image = 0;
+    rasterShader->u_opacity = 1.0f;
+    rasterShader->u_brightness_low = 0.0f;
+    rasterShader->u_brightness_high = 1.0f;
+    rasterShader->u_saturation_factor = saturationFactor(0.0f);
+    rasterShader->u_contrast_factor = contrastFactor(0.0f);
+    rasterShader->u_spin_weights = spinWeights(0.0f);
+
+    scaledTarget.bind();
+    coveringRasterArray.bind(*rasterShader, tileStencilBuffer, BUFFER_OFFSET(0));
+    glState.drawArrays(GL_TRIANGLES, 0, (GLsizei)tileStencilBuffer.index());
+
+    glState.enable(GL_DEPTH_TEST, true);
+}
+
+void Painter::uploadTiles(const std::set<util::ptr<StyleSource>>& sources) {
+    std::vector<Tile *> pending;
+    for (const util::ptr<StyleSource> &source : sources) {
+        for (Tile *tile : source->source->getPendingUploads()) {
+            pending.push_back(tile);
+        }
+    }
+
+    pendingUploads = !pending.empty();
+    if (pending.empty()) {
+        return;
+    }
+
+    MBGL_GL_GROUP("upload");
+
+    // Element buffers are part of the VAO state, so make sure that we don't change the VAO that
+    // drew last.
+    VertexArrayObject::unbind();
+
+    // Tiles in the center of the viewport go first. The first tile always gets the full budget so
+    // that every frame makes progress.
+    std::sort(pending.begin(), pending.end(), [](const Tile *a, const Tile *b) {
+        return a->data->priority < b->data->priority;
+    });
+
+    size_t bytes = 0;
+    for (Tile *tile : pending) {
+        if (uploadBudget && bytes >= uploadBudget) {
+            break;
+        }
+        const bool initial = !tile->data->uploaded;
+        bytes += tile->data->upload(uploadBudget ? uploadBudget - bytes : 0);
+        if (initial && tile->data->uploaded) {
+            tile->data->uploadFinished();
+        }
+    }
 }
 
 void Painter::renderLayers(util::ptr<StyleLayerGroup> group) {
@@ -257,6 +470,9 @@ void Painter::renderLayers(util::ptr<StyleLayerGroup> group) {
     // TODO: Correctly compute the number of layers recursively beforehand.
     float strata_thickness = 1.0f / (group->layers.size() + 1);
 
+    renderItems.clear();
+    std::map<const Source *, std::forward_list<Tile *>> tiles;
+
     // - FIRST PASS ------------------------------------------------------------
     // Render everything top-to-bottom by using reverse iterators. Render opaque
     // objects first.
@@ -266,9 +482,12 @@ void Painter::renderLayers(util::ptr<StyleLayerGroup> group) {
     }
     int i = 0;
     for (auto it = group->layers.rbegin(), end = group->layers.rend(); it != end; ++it, ++i) {
-        setOpaque();
-        setStrata(i * strata_thickness);
-        renderLayer(*it);
+        addRenderItems(*it, RenderPass::Opaque, i, i * strata_thickness, tiles);
+        if (isOpaqueBackground(**it)) {
+            // Nothing below an opaque background shows.
+            ++i;
+            break;
+        }
     }
     if (debug::renderTree) {
         std::cout << std::string(--indent * 4, ' ') << "}" << std::endl;
@@ -281,18 +500,68 @@ void Painter::renderLayers(util::ptr<StyleLayerGroup> group) {
         std::cout << std::string(indent++ * 4, ' ') << "TRANSLUCENT {" << std::endl;
     }
     --i;
-    for (auto it = group->layers.begin(), end = group->layers.end(); it != end; ++it, --i) {
-        setTranslucent();
-        setStrata(i * strata_thickness);
-        renderLayer(*it);
+    uint32_t order = 0;
+    for (auto it = group->layers.end() - (i + 1), end = group->layers.end(); it != end; ++it, --i, ++order) {
+        if (!textureLayers.empty() && *it == textureLayers.front()) {
+            // The tile textures take the place of the first layer that they hold.
+            for (const Tile *tile : texturedTiles) {
+                renderItems.push_back({ RenderPass::Translucent, order, RenderItem::Shader::Raster,
+                                        RenderItem::Texture::Tile,
+                                        uint16_t(tile->clip.mask.to_ulong() << 8 | tile->clip.reference.to_ulong()),
+                                        i * strata_thickness, nullptr, tile });
+            }
+        }
+        addRenderItems(*it, RenderPass::Translucent, order, i * strata_thickness, tiles);
     }
     if (debug::renderTree) {
         std::cout << std::string(--indent * 4, ' ') << "}" << std::endl;
     }
+
+    sortRenderItems(renderItems);
+
+    const auto translucent = std::find_if(renderItems.begin(), renderItems.end(), [](const RenderItem &item) {
+        return item.pass == RenderPass::Translucent;
+    });
+    {
+        FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::OpaquePass);
+        if (timing) overdrawCounter.begin(RenderPass::Opaque);
+        std::for_each(renderItems.begin(), translucent, [this](const RenderItem &item) { renderItem(item); });
+        if (timing) overdrawCounter.end();
+    }
+    {
+        FrameProfiler::Scope scope(profiler, FrameProfiler::Phase::TranslucentPass);
+        if (timing) overdrawCounter.begin(RenderPass::Translucent);
+        std::for_each(translucent, renderItems.end(), [this](const RenderItem &item) { renderItem(item); });
+        if (timing) overdrawCounter.end();
+    }
 }
 
-void Painter::renderLayer(util::ptr<StyleLayer> layer_desc, const Tile::ID* id, const mat4* matrix) {
+void Painter::renderItem(const RenderItem &item) {
+    if (item.pass == RenderPass::Opaque) {
+        setOpaque();
+    } else {
+        setTranslucent();
+    }
+    setStrata(item.strata);
+
+    if (timing) gpuTimer.begin(item.layer ? item.layer->id : "tile textures");
+    if (item.tile && item.layer) {
+        renderTileLayer(*item.tile, item.layer, item.tile->matrix);
+    } else if (item.tile) {
+        renderTileTexture(*item.tile);
+    } else {
+        renderBackground(item.layer);
+    }
+    if (timing) gpuTimer.end();
+}
+
+void Painter::addRenderItems(const util::ptr<StyleLayer> &layer_desc, RenderPass itemPass, uint32_t order,
+                             float itemStrata, std::map<const Source *, std::forward_list<Tile *>> &tiles) {
     if (layer_desc->bucket->visibility == VisibilityType::None) return;
+
+    RenderItem item { itemPass, order, RenderItem::Shader::Plain, RenderItem::Texture::None, 0,
+                      itemStrata, layer_desc, nullptr };
+
     if (layer_desc->type == StyleLayerType::Background) {
         // This layer defines a background color/image.
 
@@ -301,16 +570,21 @@ void Painter::renderLayer(util::ptr<StyleLayer> layer_desc, const Tile::ID* id,
                       << layer_desc->type << ")" << std::endl;
         }
 
-        renderBackground(layer_desc);
+        if (layer_desc->getProperties<BackgroundProperties>().image.size()) {
+            item.shader = RenderItem::Shader::Pattern;
+            item.texture = RenderItem::Texture::SpriteAtlas;
+        }
+        item.clip = 0xFFFF;
+        renderItems.push_back(item);
     } else {
         // This is a singular layer.
         if (!layer_desc->bucket) {
-            fprintf(stderr, "[WARNING] layer '%s' is missing bucket\n", layer_desc->id.c_str());
+            Log::Warning(Event::Render, "layer '%s' is missing bucket", layer_desc->id.c_str());
             return;
         }
 
         if (!layer_desc->bucket->style_source) {
-            fprintf(stderr, "[WARNING] can't find source for layer '%s'\n", layer_desc->id.c_str());
+            Log::Warning(Event::Render, "can't find source for layer '%s'", layer_desc->id.c_str());
             return;
         }
 
@@ -333,20 +607,43 @@ void Painter::renderLayer(util::ptr<StyleLayer> layer_desc, const Tile::ID* id,
         // Abort early if we can already deduce from the bucket type that
         // we're not going to render anything anyway during this pass.
         switch (layer_desc->type) {
-            case StyleLayerType::Fill:
-                if (!layer_desc->getProperties<FillProperties>().isVisible()) return;
+            case StyleLayerType::Fill: {
+                const FillProperties &properties = layer_desc->getProperties<FillProperties>();
+                if (!properties.isVisible()) return;
+                if (properties.image.size()) {
+                    item.shader = RenderItem::Shader::Pattern;
+                    item.texture = RenderItem::Texture::SpriteAtlas;
+                }
                 break;
-            case StyleLayerType::Line:
-                if (pass == RenderPass::Opaque) return;
-                if (!layer_desc->getProperties<LineProperties>().isVisible()) return;
+            }
+            case StyleLayerType::Line: {
+                if (itemPass == RenderPass::Opaque) return;
+                const LineProperties &properties = layer_desc->getProperties<LineProperties>();
+                if (!properties.isVisible()) return;
+                item.shader = RenderItem::Shader::Line;
+                if (properties.image.size()) {
+                    item.texture = RenderItem::Texture::SpriteAtlas;
+                } else if (properties.dash_array.size()) {
+                    item.texture = RenderItem::Texture::LineAtlas;
+                }
+                break;
+            }
+            case StyleLayerType::Circle:
+                if (itemPass == RenderPass::Opaque) return;
+                if (!layer_desc->getProperties<CircleProperties>().isVisible()) return;
+                item.shader = RenderItem::Shader::Circle;
                 break;
             case StyleLayerType::Symbol:
-                if (pass == RenderPass::Opaque) return;
+                if (itemPass == RenderPass::Opaque) return;
                 if (!layer_desc->getProperties<SymbolProperties>().isVisible()) return;
+                item.shader = RenderItem::Shader::Symbol;
+                item.texture = RenderItem::Texture::GlyphAtlas;
                 break;
             case StyleLayerType::Raster:
-                if (pass == RenderPass::Opaque) return;
+                if (itemPass == RenderPass::Opaque) return;
                 if (!layer_desc->getProperties<RasterProperties>().isVisible()) return;
+                item.shader = RenderItem::Shader::Raster;
+                item.texture = RenderItem::Texture::Tile;
                 break;
             default:
                 break;
@@ -356,24 +653,50 @@ void Painter::renderLayer(util::ptr<StyleLayer> layer_desc, const Tile::ID* id,
             std::cout << std::string(indent * 4, ' ') << "- " << layer_desc->id << " ("
                       << layer_desc->type << ")" << std::endl;
         }
-        if (!id) {
-            style_source.source->render(*this, layer_desc);
-        } else {
-            style_source.source->render(*this, layer_desc, *id, *matrix);
+
+        const Source *source = style_source.source.get();
+        auto source_tiles = tiles.find(source);
+        if (source_tiles == tiles.end()) {
+            source_tiles = tiles.emplace(source, source->getLoadedTiles()).first;
+        }
+
+        for (Tile *tile : source_tiles->second) {
+            // Tiles that are covered by others don't pass the stencil test anywhere. Symbols are
+            // drawn without it, so they still show for covered tiles.
+            if (tile->occluded && layer_desc->type != StyleLayerType::Symbol) {
+                continue;
+            }
+            if (isInTileTexture(*tile, *layer_desc)) {
+                continue;
+            }
+            if (tile->data->hasData(*layer_desc) || layer_desc->type == StyleLayerType::Raster) {
+                item.tile = tile;
+                item.clip = uint16_t(tile->clip.mask.to_ulong() << 8 | tile->clip.reference.to_ulong());
+                renderItems.push_back(item);
+            }
         }
     }
 }
 
-void Painter::renderTileLayer(const Tile& tile, util::ptr<StyleLayer> layer_desc, const mat4 &matrix) {
-    assert(tile.data);
-    if (tile.data->hasData(*layer_desc) || layer_desc->type == StyleLayerType::Raster) {
-        gl::group group(std::string { "render " } + tile.data->name);
-        prepareTile(tile);
-        tile.data->render(*this, layer_desc, matrix);
+bool Painter::isOpaqueBackground(StyleLayer &layer_desc) const {
+    if (layer_desc.type != StyleLayerType::Background ||
+        (layer_desc.bucket && layer_desc.bucket->visibility == VisibilityType::None)) {
+        return false;
     }
+
+    // Patterns may have transparent pixels.
+    const BackgroundProperties &properties = layer_desc.getProperties<BackgroundProperties>();
+    return properties.image.empty() && properties.color[3] * properties.opacity >= 1.0f;
+}
+
+void Painter::renderTileLayer(const Tile& tile, const util::ptr<StyleLayer> &layer_desc, const mat4 &matrix) {
+    assert(tile.data);
+    MBGL_GL_GROUP(std::string { "render " } + layer_desc->id + " " + tile.data->name);
+    prepareTile(tile);
+    tile.data->render(*this, layer_desc, matrix);
 }
 
-void Painter::renderBackground(util::ptr<StyleLayer> layer_desc) {
+void Painter::renderBackground(const util::ptr<StyleLayer> &layer_desc) {
     const BackgroundProperties& properties = layer_desc->getProperties<BackgroundProperties>();
 
     if (properties.image.size()) {
@@ -383,12 +706,13 @@ void Painter::renderBackground(util::ptr<StyleLayer> layer_desc) {
         SpriteAtlasPosition imagePos = spriteAtlas.getPosition(properties.image, true);
         float zoomFraction = state.getZoomFraction();
 
-        useProgram(patternShader->program);
-        patternShader->u_matrix = identityMatrix;
-        patternShader->u_pattern_tl = imagePos.tl;
-        patternShader->u_pattern_br = imagePos.br;
-        patternShader->u_mix = zoomFraction;
-        patternShader->u_opacity = properties.opacity;
+        PatternShader &shader = patternShader[zoomFraction > 0.0f ? Shader::Crossfade : 0];
+        useProgram(shader.program);
+        shader.u_matrix = identityMatrix;
+        shader.u_pattern_tl = imagePos.tl;
+        shader.u_pattern_br = imagePos.br;
+        shader.u_mix = zoomFraction;
+        shader.u_opacity = properties.opacity;
 
         std::array<float, 2> size = imagePos.size;
         double lon, lat;
@@ -408,10 +732,10 @@ void Painter::renderBackground(util::ptr<StyleLayer> layer_desc) {
         matrix::scale(matrix, matrix,
                        scale * state.getWidth()  / 2,
                       -scale * state.getHeight() / 2);
-        patternShader->u_patternmatrix = matrix;
+        shader.u_patternmatrix = matrix;
 
         backgroundBuffer.bind();
-        patternShader->bind(0);
+        shader.bind(0);
         spriteAtlas.bind(true);
     } else {
         Color color = properties.color;
@@ -429,10 +753,14 @@ void Painter::renderBackground(util::ptr<StyleLayer> layer_desc) {
         backgroundArray.bind(*plainShader, backgroundBuffer, BUFFER_OFFSET(0));
     }
 
-    MBGL_CHECK_ERROR(glDisable(GL_STENCIL_TEST));
+    setClipping(false);
     depthRange(strata + strata_epsilon, 1.0f);
-    MBGL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
-    MBGL_CHECK_ERROR(glEnable(GL_STENCIL_TEST));
+    gl::State::Get().drawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    setClipping(true);
+}
+
+ElementCuller Painter::culler(const mat4 &matrix, float padding, float extentScale) const {
+    return ElementCuller(matrix, state.getWidth(), state.getHeight(), padding, extentScale);
 }
 
 mat4 Painter::translatedMatrix(const mat4& matrix, const std::array<float, 2> &translation, const Tile::ID &id, TranslateAnchorType anchor) {
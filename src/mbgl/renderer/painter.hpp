@@ -2,37 +2,51 @@
 #define MBGL_RENDERER_PAINTER
 
 #include <mbgl/map/tile_data.hpp>
+#include <mbgl/geometry/element_bounds.hpp>
 #include <mbgl/geometry/vao.hpp>
+#include <mbgl/platform/gl_state.hpp>
 #include <mbgl/geometry/static_vertex_buffer.hpp>
+#include <mbgl/util/clip_ids.hpp>
+#include <mbgl/util/frame_profiler.hpp>
 #include <mbgl/util/mat4.hpp>
 #include <mbgl/util/noncopyable.hpp>
 #include <mbgl/renderer/frame_history.hpp>
+#include <mbgl/renderer/gpu_timer.hpp>
+#include <mbgl/renderer/overdraw_counter.hpp>
+#include <mbgl/renderer/pixel_reader.hpp>
+#include <mbgl/renderer/render_item.hpp>
+#include <mbgl/renderer/render_target.hpp>
+#include <mbgl/renderer/tile_texture.hpp>
 #include <mbgl/style/types.hpp>
 
 #include <mbgl/shader/plain_shader.hpp>
+#include <mbgl/shader/plaincolor_shader.hpp>
+#include <mbgl/shader/plainfringe_shader.hpp>
 #include <mbgl/shader/outline_shader.hpp>
+#include <mbgl/shader/outlinecolor_shader.hpp>
 #include <mbgl/shader/pattern_shader.hpp>
 #include <mbgl/shader/line_shader.hpp>
-#include <mbgl/shader/linejoin_shader.hpp>
 #include <mbgl/shader/linesdf_shader.hpp>
 #include <mbgl/shader/linepattern_shader.hpp>
+#include <mbgl/shader/circle_shader.hpp>
 #include <mbgl/shader/icon_shader.hpp>
 #include <mbgl/shader/raster_shader.hpp>
 #include <mbgl/shader/sdf_shader.hpp>
 #include <mbgl/shader/dot_shader.hpp>
 #include <mbgl/shader/gaussian_shader.hpp>
+#include <mbgl/shader/lazy_shader.hpp>
 
 #include <mbgl/map/transform_state.hpp>
 #include <mbgl/util/ptr.hpp>
 
+#include <atomic>
+#include <forward_list>
 #include <map>
 #include <unordered_map>
 #include <set>
 
 namespace mbgl {
 
-enum class RenderPass : bool { Opaque, Translucent };
-
 class Transform;
 class Style;
 class Tile;
@@ -46,9 +60,9 @@ class StyleLayerGroup;
 
 class FillBucket;
 class LineBucket;
+class CircleBucket;
 class SymbolBucket;
 class RasterBucket;
-class PrerenderedTexture;
 
 struct FillProperties;
 struct RasterProperties;
@@ -58,7 +72,7 @@ class RasterTileData;
 
 class Painter : private util::noncopyable {
 public:
-    Painter(SpriteAtlas&, GlyphAtlas&, LineAtlas&);
+    Painter(SpriteAtlas&, GlyphAtlas&, LineAtlas&, FrameProfiler&);
     ~Painter();
 
     void setup();
@@ -80,11 +94,30 @@ public:
                 TransformState state,
                 timestamp time);
 
+    // Draws a frame of the view in /state/ into an offscreen target and reads it back; the
+    // callback gets the pixels once the GPU is done, at the latest in finishReads(). Tiles are
+    // uploaded in full and drawn at full resolution, without debug information, and the frame
+    // isn't part of the frame history.
+    void renderSnapshot(const Style& style,
+                        const std::set<util::ptr<StyleSource>>& sources,
+                        const TransformState& state,
+                        timestamp time,
+                        PixelReader::Callback callback);
+    void finishReads();
+    bool hasPendingReads() const;
+
     void renderLayers(util::ptr<StyleLayerGroup> group);
-    void renderLayer(util::ptr<StyleLayer> layer_desc, const Tile::ID* id = nullptr, const mat4* matrix = nullptr);
+
+    // Adds the items that draw a layer in a pass to the render list of the frame. The loaded tiles
+    // of each source are looked up once per frame and kept in /tiles/.
+    void addRenderItems(const util::ptr<StyleLayer> &layer_desc, RenderPass pass, uint32_t order, float strata,
+                        std::map<const Source *, std::forward_list<Tile *>> &tiles);
+
+    // Whether a layer hides everything below it.
+    bool isOpaqueBackground(StyleLayer &layer_desc) const;
 
     // Renders a particular layer from a tile.
-    void renderTileLayer(const Tile& tile, util::ptr<StyleLayer> layer_desc, const mat4 &matrix);
+    void renderTileLayer(const Tile& tile, const util::ptr<StyleLayer> &layer_desc, const mat4 &matrix);
 
     // Renders debug information for a tile.
     void renderTileDebug(const Tile& tile);
@@ -94,27 +127,39 @@ public:
 
     void renderDebugText(DebugBucket& bucket, const mat4 &matrix);
     void renderDebugText(const std::vector<std::string> &strings);
-    void renderFill(FillBucket& bucket, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix);
-    void renderLine(LineBucket& bucket, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix);
-    void renderSymbol(SymbolBucket& bucket, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix);
-    void renderRaster(RasterBucket& bucket, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix);
-    void renderBackground(util::ptr<StyleLayer> layer_desc);
+    void renderFill(FillBucket& bucket, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix);
+    void renderLine(LineBucket& bucket, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix);
+    void renderCircle(CircleBucket& bucket, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix);
+    void renderSymbol(SymbolBucket& bucket, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix);
+    void renderRaster(RasterBucket& bucket, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix);
+    void renderBackground(const util::ptr<StyleLayer> &layer_desc);
 
     float saturationFactor(float saturation);
     float contrastFactor(float contrast);
     std::array<float, 3> spinWeights(float spin_value);
 
-    void preparePrerender(RasterBucket &bucket);
-
-    void renderPrerenderedTexture(RasterBucket &bucket, const mat4 &matrix, const RasterProperties& properties);
-
-    void createPrerendered(RasterBucket& bucket, util::ptr<StyleLayer> layer_desc, const Tile::ID& id);
-
     void resize();
 
     // Changes whether debug information is drawn onto the map
     void setDebug(bool enabled);
 
+    // Changes whether the GPU time of each layer and of the clipping and debug passes is measured.
+    // With debug enabled, the most expensive ones are shown on the map.
+    void setGPUTiming(bool enabled);
+    GPUTimes getGPUTimes() const;
+    // Measured along with the GPU times.
+    Overdraw getOverdraw() const;
+
+    // Calls that went through the GL state tracker during the last frame.
+    inline const gl::State::Stats &getFrameStats() const { return frameStats; }
+
+    // Changes whether the bottom fill and line layers of each tile are kept in a texture while the
+    // camera sits at an integer zoom level without rotation, so that panning only composites them.
+    void setTileTextureCaching(bool enabled);
+    // Deletes the tile textures; they are drawn again when they are needed. Returns what they took
+    // up.
+    MemoryUsage releaseTileTextures();
+
     // Opaque/Translucent pass setting
     void setOpaque();
     void setTranslucent();
@@ -133,14 +178,49 @@ public:
 
     bool needsAnimation() const;
 
+    // Sets the number of bytes of tile geometry uploaded per frame; 0 uploads everything in the
+    // next frame.
+    void setUploadBudget(size_t bytes);
+
+    // Draws the following frames at this fraction of the framebuffer's resolution, into a texture
+    // that is stretched over the framebuffer at the end of the frame.
+    void setResolution(float resolution);
+
+    // Whether the last frame left uploads for the next one, or finished tiles that may replace the
+    // ones standing in for them.
+    bool hasPendingUploads() const;
+
 private:
-    void setupShaders();
     void deleteShaders();
+    // Stretches the frame that was drawn into scaledTarget over the framebuffer.
+    void drawScaledFrame(const std::array<uint16_t, 2> &framebuffer);
     mat4 translatedMatrix(const mat4& matrix, const std::array<float, 2> &translation, const Tile::ID &id, TranslateAnchorType anchor);
 
+    // Skips the element groups that are off screen when drawn with /matrix/. Bounds are grown by
+    // /padding/ pixels plus their extent times /extentScale/ pixels.
+    ElementCuller culler(const mat4 &matrix, float padding = 0, float extentScale = 0) const;
+
     void prepareTile(const Tile& tile);
+
+    // Turns the clipping of tiles to their area on or off, in the way it is done in this frame.
+    void setClipping(bool enabled);
+
+    void renderItem(const RenderItem &item);
+    void uploadTiles(const std::set<util::ptr<StyleSource>>& sources);
     void recordZoom(const timestamp time, const float zoom);
 
+    // Picks the layers and tiles that draw from tile textures in this frame, and redraws the
+    // textures that are out of date. Must run after the clipping IDs were updated.
+    void updateTileTextures(const Style& style, timestamp time);
+    // Whether the layer draws from the texture of the tile instead of its buckets.
+    bool isInTileTexture(const Tile& tile, const StyleLayer& layer_desc) const;
+    void renderTileTexture(const Tile& tile);
+    void clearTileTextures();
+
+    // Draws a fill bucket whose features carry their own colors.
+    void renderFeatureColorFill(FillBucket& bucket, const FillProperties &properties,
+                                const mat4 &vtxMatrix, const ElementCuller &groups);
+
     template <typename BucketProperties, typename StyleProperties>
     void renderSDF(SymbolBucket &bucket,
                    const Tile::ID &id,
@@ -150,7 +230,7 @@ private:
                    float scaleDivisor,
                    std::array<float, 2> texsize,
                    SDFShader& sdfShader,
-                   void (SymbolBucket::*drawSDF)(SDFShader&));
+                   void (SymbolBucket::*drawSDF)(SDFShader&, const ElementCuller&));
 
 public:
     void useProgram(uint32_t program);
@@ -183,11 +263,16 @@ private:
     bool debug = false;
     int indent = 0;
 
-    uint32_t gl_program = 0;
-    float gl_lineWidth = 0;
-    bool gl_depthMask = true;
+    std::atomic<bool> gpuTiming { false };
+    // Whether the current frame is measured.
+    bool timing = false;
+    GPUTimer gpuTimer;
+    OverdrawCounter overdrawCounter;
+
     std::array<uint16_t, 2> gl_viewport = {{ 0, 0 }};
-    std::array<float, 2> gl_depthRange = {{ 0, 1 }};
+
+    // Calls that went through the GL state tracker during the last frame.
+    gl::State::Stats frameStats;
     float strata = 0;
     RenderPass pass = RenderPass::Opaque;
     const float strata_epsilon = 1.0f / (1 << 16);
@@ -196,26 +281,72 @@ private:
     timestamp lastIntegerZoomTime = 0;
     float lastZoom = -1;
 
+    size_t uploadBudget = 0;
+    bool pendingUploads = false;
+
+    float resolution = 1;
+    RenderTarget scaledTarget;
+
+    // Whether the current frame is a snapshot.
+    bool snapshot = false;
+    RenderTarget snapshotTarget;
+    PixelReader pixelReader;
+
+    // Kept across frames so that its storage is reused.
+    std::vector<RenderItem> renderItems;
+
+    ClipIDCache clipIDs;
+
+    // Whether tiles are clipped with the scissor rectangle instead of the stencil mask in this
+    // frame. Without rotation, a tile covers an axis-aligned rectangle of the screen; as long as no
+    // tile shows only partly, that rectangle is all the clipping it needs.
+    bool scissorClipping = false;
+
+    // The matrices of the tiles drawn in this frame. Sources that show the same tiles share them.
+    std::unordered_map<Tile::ID, mat4, Tile::ID::Hash> tileMatrices;
+
+    bool tileTextureCaching = false;
+    // The consecutive layers from the bottom that go into the tile textures, and the style
+    // generation they were drawn with.
+    std::vector<util::ptr<StyleLayer>> textureLayers;
+    uint64_t textureStyleGeneration = 0;
+    std::map<Tile::ID, std::unique_ptr<TileTexture>> tileTextures;
+    // Textures of tiles that left the view, with their framebuffers. Tiles that come into view
+    // draw into these instead of allocating new ones.
+    std::vector<std::unique_ptr<TileTexture>> spareTileTextures;
+    // The tiles whose texture is current in this frame.
+    std::vector<const Tile *> texturedTiles;
+
 public:
     FrameHistory frameHistory;
 
     SpriteAtlas& spriteAtlas;
     GlyphAtlas& glyphAtlas;
     LineAtlas& lineAtlas;
-
-    std::unique_ptr<PlainShader> plainShader;
-    std::unique_ptr<OutlineShader> outlineShader;
-    std::unique_ptr<LineShader> lineShader;
-    std::unique_ptr<LinejoinShader> linejoinShader;
-    std::unique_ptr<LineSDFShader> linesdfShader;
-    std::unique_ptr<LinepatternShader> linepatternShader;
-    std::unique_ptr<PatternShader> patternShader;
-    std::unique_ptr<IconShader> iconShader;
-    std::unique_ptr<RasterShader> rasterShader;
-    std::unique_ptr<SDFGlyphShader> sdfGlyphShader;
-    std::unique_ptr<SDFIconShader> sdfIconShader;
-    std::unique_ptr<DotShader> dotShader;
-    std::unique_ptr<GaussianShader> gaussianShader;
+    FrameProfiler& profiler;
+
+    // Each program is compiled the first time something draws with it.
+    LazyShader<PlainShader> plainShader;
+    LazyShader<PlainColorShader> plainColorShader;
+    LazyShader<PlainFringeShader> plainFringeShader;
+    LazyShader<OutlineShader> outlineShader;
+    LazyShader<OutlineColorShader> outlineColorShader;
+    LazyShader<LineShader> lineShader;
+    LazyShaderVariants<LineSDFShader, 2> linesdfShader;
+    LazyShaderVariants<LinepatternShader, 2> linepatternShader;
+    LazyShader<CircleShader> circleShader;
+    LazyShaderVariants<PatternShader, 2> patternShader;
+    LazyShader<IconShader> iconShader;
+    LazyShader<RasterShader> rasterShader;
+    LazyShader<SDFGlyphShader> sdfGlyphShader;
+    LazyShader<SDFIconShader> sdfIconShader;
+    LazyShader<DotShader> dotShader;
+    LazyShader<GaussianShader> gaussianShader;
+
+    // Only usable with instanced arrays; used for instanced symbol and circle buckets.
+    LazyShader<IconInstancedShader> iconInstancedShader;
+    LazyShader<SDFInstancedShader> sdfInstancedShader;
+    LazyShader<CircleInstancedShader> circleInstancedShader;
 
     StaticVertexBuffer backgroundBuffer = {
         { -1, -1 }, { 1, -1 },
@@ -0,0 +1,39 @@
+#include <mbgl/renderer/painter.hpp>
+#include <mbgl/renderer/circle_bucket.hpp>
+#include <mbgl/style/style_layer.hpp>
+
+#include <algorithm>
+
+using namespace mbgl;
+
+void Painter::renderCircle(CircleBucket& bucket, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix) {
+    // Abort early.
+    if (pass == RenderPass::Opaque) return;
+    if (!bucket.hasData()) return;
+
+    const CircleProperties &properties = layer_desc->getProperties<CircleProperties>();
+
+    Color color = properties.color;
+    color[0] *= properties.opacity;
+    color[1] *= properties.opacity;
+    color[2] *= properties.opacity;
+    color[3] *= properties.opacity;
+
+    // The edge fades out over at least one device pixel, as a fraction of the radius.
+    const float blur = std::max(properties.blur, 1.0f / (properties.radius * state.getPixelRatio()));
+
+    mat4 vtxMatrix = translatedMatrix(matrix, properties.translate, id, properties.translateAnchor);
+    const ElementCuller groups = culler(vtxMatrix, 1, properties.radius);
+
+    depthRange(strata, 1.0f);
+
+    CircleShader &shader = bucket.instanced ? *circleInstancedShader : *circleShader;
+    useProgram(shader.program);
+    shader.u_matrix = vtxMatrix;
+    shader.u_exmatrix = projMatrix;
+    shader.u_color = color;
+    shader.u_size = properties.radius;
+    shader.u_blur = blur;
+
+    bucket.drawCircles(shader, groups);
+}
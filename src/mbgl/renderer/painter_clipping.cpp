@@ -7,12 +7,12 @@
 using namespace mbgl;
 
 void Painter::drawClippingMasks(const std::set<util::ptr<StyleSource>> &sources) {
-    gl::group group("clipping masks");
+    MBGL_GL_GROUP("clipping masks");
 
     useProgram(plainShader->program);
-    MBGL_CHECK_ERROR(glDisable(GL_DEPTH_TEST));
+    gl::State::Get().enable(GL_DEPTH_TEST, false);
     depthMask(false);
-    MBGL_CHECK_ERROR(glColorMask(false, false, false, false));
+    gl::State::Get().colorMask(false, false, false, false);
     depthRange(1.0f, 1.0f);
 
     coveringPlainArray.bind(*plainShader, tileStencilBuffer, BUFFER_OFFSET(0));
@@ -21,10 +21,10 @@ void Painter::drawClippingMasks(const std::set<util::ptr<StyleSource>> &sources)
         source->source->drawClippingMasks(*this);
     }
 
-    MBGL_CHECK_ERROR(glEnable(GL_DEPTH_TEST));
-    MBGL_CHECK_ERROR(glColorMask(true, true, true, true));
+    gl::State::Get().enable(GL_DEPTH_TEST, true);
+    gl::State::Get().colorMask(true, true, true, true);
     depthMask(true);
-    MBGL_CHECK_ERROR(glStencilMask(0x0));
+    gl::State::Get().stencilMask(0x0);
 }
 
 void Painter::drawClippingMask(const mat4& matrix, const ClipID &clip) {
@@ -32,8 +32,8 @@ void Painter::drawClippingMask(const mat4& matrix, const ClipID &clip) {
 
     const GLint ref = (GLint)(clip.reference.to_ulong());
     const GLuint mask = (GLuint)(clip.mask.to_ulong());
-    MBGL_CHECK_ERROR(glStencilFunc(GL_ALWAYS, ref, mask));
-    MBGL_CHECK_ERROR(glStencilMask(mask));
+    gl::State::Get().stencilFunc(GL_ALWAYS, ref, mask);
+    gl::State::Get().stencilMask(mask);
 
-    MBGL_CHECK_ERROR(glDrawArrays(GL_TRIANGLES, 0, (GLsizei)tileStencilBuffer.index()));
+    gl::State::Get().drawArrays(GL_TRIANGLES, 0, (GLsizei)tileStencilBuffer.index());
 }
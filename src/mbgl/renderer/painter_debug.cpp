@@ -6,7 +6,7 @@
 using namespace mbgl;
 
 void Painter::renderTileDebug(const Tile& tile) {
-    gl::group group(std::string { "debug " } + std::string(tile.id));
+    MBGL_GL_GROUP(std::string { "debug " } + std::string(tile.id));
     assert(tile.data);
     if (debug) {
         prepareTile(tile);
@@ -16,9 +16,9 @@ void Painter::renderTileDebug(const Tile& tile) {
 }
 
 void Painter::renderDebugText(DebugBucket& bucket, const mat4 &matrix) {
-    gl::group group("debug text");
+    MBGL_GL_GROUP("debug text");
 
-    MBGL_CHECK_ERROR(glDisable(GL_DEPTH_TEST));
+    gl::State::Get().enable(GL_DEPTH_TEST, false);
 
     useProgram(plainShader->program);
     plainShader->u_matrix = matrix;
@@ -39,16 +39,16 @@ void Painter::renderDebugText(DebugBucket& bucket, const mat4 &matrix) {
     lineWidth(2.0f * state.getPixelRatio());
     bucket.drawLines(*plainShader);
 
-    MBGL_CHECK_ERROR(glEnable(GL_DEPTH_TEST));
+    gl::State::Get().enable(GL_DEPTH_TEST, true);
 }
 
 void Painter::renderDebugFrame(const mat4 &matrix) {
-    gl::group group("debug frame");
+    MBGL_GL_GROUP("debug frame");
 
     // Disable depth test and don't count this towards the depth buffer,
     // but *don't* disable stencil test, as we want to clip the red tile border
     // to the tile viewport.
-    MBGL_CHECK_ERROR(glDisable(GL_DEPTH_TEST));
+    gl::State::Get().enable(GL_DEPTH_TEST, false);
 
     useProgram(plainShader->program);
     plainShader->u_matrix = matrix;
@@ -57,9 +57,9 @@ void Painter::renderDebugFrame(const mat4 &matrix) {
     tileBorderArray.bind(*plainShader, tileBorderBuffer, BUFFER_OFFSET(0));
     plainShader->u_color = {{ 1.0f, 0.0f, 0.0f, 1.0f }};
     lineWidth(4.0f * state.getPixelRatio());
-    MBGL_CHECK_ERROR(glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)tileBorderBuffer.index()));
+    gl::State::Get().drawArrays(GL_LINE_STRIP, 0, (GLsizei)tileBorderBuffer.index());
 
-    MBGL_CHECK_ERROR(glEnable(GL_DEPTH_TEST));
+    gl::State::Get().enable(GL_DEPTH_TEST, true);
 }
 
 void Painter::renderDebugText(const std::vector<std::string> &strings) {
@@ -67,10 +67,10 @@ void Painter::renderDebugText(const std::vector<std::string> &strings) {
         return;
     }
 
-    gl::group group("debug text");
+    MBGL_GL_GROUP("debug text");
 
-    MBGL_CHECK_ERROR(glDisable(GL_DEPTH_TEST));
-    MBGL_CHECK_ERROR(glStencilFunc(GL_ALWAYS, 0xFF, 0xFF));
+    gl::State::Get().enable(GL_DEPTH_TEST, false);
+    setClipping(false);
 
     useProgram(plainShader->program);
     plainShader->u_matrix = nativeMatrix;
@@ -88,15 +88,16 @@ void Painter::renderDebugText(const std::vector<std::string> &strings) {
         debugFontArray.bind(*plainShader, debugFontBuffer, BUFFER_OFFSET(0));
         plainShader->u_color = {{ 1.0f, 1.0f, 1.0f, 1.0f }};
         lineWidth(4.0f * state.getPixelRatio());
-        MBGL_CHECK_ERROR(glDrawArrays(GL_LINES, 0, (GLsizei)debugFontBuffer.index()));
+        gl::State::Get().drawArrays(GL_LINES, 0, (GLsizei)debugFontBuffer.index());
     #ifndef GL_ES_VERSION_2_0
         MBGL_CHECK_ERROR(glPointSize(2));
-        MBGL_CHECK_ERROR(glDrawArrays(GL_POINTS, 0, (GLsizei)debugFontBuffer.index()));
+        gl::State::Get().drawArrays(GL_POINTS, 0, (GLsizei)debugFontBuffer.index());
     #endif
         plainShader->u_color = {{ 0.0f, 0.0f, 0.0f, 1.0f }};
         lineWidth(2.0f * state.getPixelRatio());
-        MBGL_CHECK_ERROR(glDrawArrays(GL_LINES, 0, (GLsizei)debugFontBuffer.index()));
+        gl::State::Get().drawArrays(GL_LINES, 0, (GLsizei)debugFontBuffer.index());
     }
 
-    MBGL_CHECK_ERROR(glEnable(GL_DEPTH_TEST));
+    setClipping(true);
+    gl::State::Get().enable(GL_DEPTH_TEST, true);
 }
@@ -10,12 +10,14 @@
 
 using namespace mbgl;
 
-void Painter::renderFill(FillBucket& bucket, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix) {
+void Painter::renderFill(FillBucket& bucket, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix) {
     // Abort early.
     if (!bucket.hasData()) return;
 
     const FillProperties &properties = layer_desc->getProperties<FillProperties>();
     mat4 vtxMatrix = translatedMatrix(matrix, properties.translate, id, properties.translateAnchor);
+    // The outlines are antialiased beyond the polygons.
+    const ElementCuller groups = culler(vtxMatrix, 2);
 
     Color fill_color = properties.fill_color;
     fill_color[0] *= properties.opacity;
@@ -35,9 +37,20 @@ void Painter::renderFill(FillBucket& bucket, util::ptr<StyleLayer> layer_desc, c
 
     const bool pattern = properties.image.size();
 
+    if (bucket.hasFeatureColors() && !pattern) {
+        renderFeatureColorFill(bucket, properties, vtxMatrix, groups);
+        return;
+    }
+
     bool outline = properties.antialias && !pattern && properties.stroke_color != properties.fill_color;
     bool fringeline = properties.antialias && !pattern && properties.stroke_color == properties.fill_color;
 
+    // Buckets with a fringe antialias their edges while drawing the fill, instead of with lines.
+    const bool fringe = fringeline && bucket.hasFringes();
+    if (fringe) {
+        fringeline = false;
+    }
+
     // Because we're drawing top-to-bottom, and we update the stencil mask
     // below, we have to draw the outline first (!)
     if (outline && pass == RenderPass::Translucent) {
@@ -53,7 +66,7 @@ void Painter::renderFill(FillBucket& bucket, util::ptr<StyleLayer> layer_desc, c
             static_cast<float>(state.getFramebufferHeight())
         }};
         depthRange(strata, 1.0f);
-        bucket.drawVertices(*outlineShader);
+        bucket.drawVertices(*outlineShader, groups);
     }
 
     if (pattern) {
@@ -75,30 +88,49 @@ void Painter::renderFill(FillBucket& bucket, util::ptr<StyleLayer> layer_desc, c
                 mix = fraction - fraction * t;
             }
 
+            // Outside of a fade, only one of the two samples is visible. The second one is the
+            // pattern at half the size.
+            const bool crossfade = mix > 0.0f && mix < 1.0f;
+            if (mix >= 1.0f) {
+                factor /= 2.0;
+            }
+
             mat3 patternMatrix;
             matrix::identity(patternMatrix);
             matrix::scale(patternMatrix, patternMatrix, 1.0f / (pos.size[0] * factor), 1.0f / (pos.size[1] * factor));
 
-            useProgram(patternShader->program);
-            patternShader->u_matrix = vtxMatrix;
-            patternShader->u_pattern_tl = pos.tl;
-            patternShader->u_pattern_br = pos.br;
-            patternShader->u_opacity = properties.opacity;
-            patternShader->u_image = 0;
-            patternShader->u_mix = mix;
-            patternShader->u_patternmatrix = patternMatrix;
-
-            MBGL_CHECK_ERROR(glActiveTexture(GL_TEXTURE0));
+            PatternShader &shader = patternShader[crossfade ? Shader::Crossfade : 0];
+            useProgram(shader.program);
+            shader.u_matrix = vtxMatrix;
+            shader.u_pattern_tl = pos.tl;
+            shader.u_pattern_br = pos.br;
+            shader.u_opacity = properties.opacity;
+            shader.u_image = 0;
+            shader.u_mix = mix;
+            shader.u_patternmatrix = patternMatrix;
+
+            gl::State::Get().activeTexture(GL_TEXTURE0);
             spriteAtlas.bind(true);
 
             // Draw the actual triangles into the color & stencil buffer.
             depthRange(strata, 1.0f);
-            bucket.drawElements(*patternShader);
+            bucket.drawElements(shader, groups);
         }
     }
     else {
         // No image fill.
-        if ((fill_color[3] >= 1.0f) == (pass == RenderPass::Opaque)) {
+        if (fringe && pass == RenderPass::Translucent) {
+            // Translucent fills are drawn along with their fringe. Opaque fills were drawn in the
+            // opaque pass; the depth test skips their triangles, so only the fringe is shaded.
+            useProgram(plainFringeShader->program);
+            plainFringeShader->u_matrix = vtxMatrix;
+            plainFringeShader->u_exmatrix = extrudeMatrix;
+            plainFringeShader->u_color = fill_color;
+            plainFringeShader->u_fringe = 1.0f / state.getPixelRatio();
+
+            depthRange(strata + strata_epsilon, 1.0f);
+            bucket.drawElements(*plainFringeShader, groups);
+        } else if ((fill_color[3] >= 1.0f) == (pass == RenderPass::Opaque)) {
             // Only draw the fill when it's either opaque and we're drawing opaque
             // fragments or when it's translucent and we're drawing translucent
             // fragments
@@ -109,7 +141,7 @@ void Painter::renderFill(FillBucket& bucket, util::ptr<StyleLayer> layer_desc, c
 
             // Draw the actual triangles into the color & stencil buffer.
             depthRange(strata + strata_epsilon, 1.0f);
-            bucket.drawElements(*plainShader);
+            bucket.drawElements(*plainShader, groups);
         }
     }
 
@@ -129,6 +161,53 @@ void Painter::renderFill(FillBucket& bucket, util::ptr<StyleLayer> layer_desc, c
         }};
 
         depthRange(strata + strata_epsilon, 1.0f);
-        bucket.drawVertices(*outlineShader);
+        bucket.drawVertices(*outlineShader, groups);
+    }
+}
+
+// The vertices carry the color of their feature, so the fill color of the layer doesn't apply.
+void Painter::renderFeatureColorFill(FillBucket& bucket, const FillProperties &properties,
+                                     const mat4 &vtxMatrix, const ElementCuller &groups) {
+    const std::array<float, 2> world = {{
+        static_cast<float>(state.getFramebufferWidth()),
+        static_cast<float>(state.getFramebufferHeight())
+    }};
+
+    // An outline color applies to all features, and is drawn below the fill.
+    const bool outline = properties.antialias && properties.stroke_color[3] >= 0;
+    if (outline && pass == RenderPass::Translucent) {
+        Color stroke_color = properties.stroke_color;
+        stroke_color[0] *= properties.opacity;
+        stroke_color[1] *= properties.opacity;
+        stroke_color[2] *= properties.opacity;
+        stroke_color[3] *= properties.opacity;
+
+        useProgram(outlineShader->program);
+        outlineShader->u_matrix = vtxMatrix;
+        lineWidth(2.0f); // This is always fixed and does not depend on the pixelRatio!
+        outlineShader->u_color = stroke_color;
+        outlineShader->u_world = world;
+        depthRange(strata, 1.0f);
+        bucket.drawVertices(*outlineShader, groups);
+    }
+
+    const bool opaque = properties.opacity >= 1.0f && bucket.properties.isOpaque();
+    if (opaque == (pass == RenderPass::Opaque)) {
+        useProgram(plainColorShader->program);
+        plainColorShader->u_matrix = vtxMatrix;
+        plainColorShader->u_opacity = properties.opacity;
+        depthRange(strata + strata_epsilon, 1.0f);
+        bucket.drawElements(*plainColorShader, groups);
+    }
+
+    // Without an outline color, the edges are antialiased in the color of their feature.
+    if (properties.antialias && !outline && pass == RenderPass::Translucent) {
+        useProgram(outlineColorShader->program);
+        outlineColorShader->u_matrix = vtxMatrix;
+        lineWidth(2.0f); // This is always fixed and does not depend on the pixelRatio!
+        outlineColorShader->u_opacity = properties.opacity;
+        outlineColorShader->u_world = world;
+        depthRange(strata + strata_epsilon, 1.0f);
+        bucket.drawVertices(*outlineColorShader, groups);
     }
 }
@@ -9,7 +9,7 @@
 
 using namespace mbgl;
 
-void Painter::renderLine(LineBucket& bucket, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix) {
+void Painter::renderLine(LineBucket& bucket, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix) {
     // Abort early.
     if (pass == RenderPass::Opaque) return;
     if (!bucket.hasData()) return;
@@ -44,47 +44,15 @@ void Painter::renderLine(LineBucket& bucket, util::ptr<StyleLayer> layer_desc, c
 
     float ratio = state.getPixelRatio();
     mat4 vtxMatrix = translatedMatrix(matrix, properties.translate, id, properties.translateAnchor);
+    const ElementCuller groups = culler(vtxMatrix, blur + 1, outset);
 
     depthRange(strata, 1.0f);
 
-    // We're only drawing end caps + round line joins if the line is > 2px. Otherwise, they aren't visible anyway.
-    if (bucket.hasPoints() && outset > 1.0f) {
-        useProgram(linejoinShader->program);
-        linejoinShader->u_matrix = vtxMatrix;
-        linejoinShader->u_color = color;
-        linejoinShader->u_world = {{
-            state.getFramebufferWidth() * 0.5f,
-            state.getFramebufferHeight() * 0.5f
-        }};
-        linejoinShader->u_linewidth = {{
-            ((outset - 0.25f) * state.getPixelRatio()),
-            ((inset - 0.25f) * state.getPixelRatio())
-        }};
-
-        float pointSize = std::ceil(state.getPixelRatio() * outset * 2.0);
-#if defined(GL_ES_VERSION_2_0)
-        linejoinShader->u_size = pointSize;
-#else
-        MBGL_CHECK_ERROR(glPointSize(pointSize));
-#endif
-        bucket.drawPoints(*linejoinShader);
-    }
-
     float duration = 300 * 1_millisecond;
     const float fraction = std::fmod(float(state.getZoom()), 1.0f);
     float t = std::min((util::now() - lastIntegerZoomTime) / duration, 1.0f);
 
     if (properties.dash_array.size()) {
-
-        useProgram(linesdfShader->program);
-
-        linesdfShader->u_matrix = vtxMatrix;
-        linesdfShader->u_exmatrix = extrudeMatrix;
-        linesdfShader->u_linewidth = {{ outset, inset }};
-        linesdfShader->u_ratio = ratio;
-        linesdfShader->u_blur = blur;
-        linesdfShader->u_color = color;
-
         LinePatternPos pos = lineAtlas.getDashPosition(properties.dash_array, bucket.properties.cap == CapType::Round);
         lineAtlas.bind();
 
@@ -102,15 +70,31 @@ void Painter::renderLine(LineBucket& bucket, util::ptr<StyleLayer> layer_desc, c
             mix = fraction - fraction * t;
         }
 
-        linesdfShader->u_patternscale_a = {{ scaleX, scaleY }};
-        linesdfShader->u_tex_y_a = pos.y;
-        linesdfShader->u_patternscale_b = {{ scaleX * 2.0f, scaleY }};
-        linesdfShader->u_tex_y_b = pos.y;
-        linesdfShader->u_image = 0;
-        linesdfShader->u_sdfgamma = lineAtlas.width / (properties.dash_line_width * pos.width * 256.0 * state.getPixelRatio()) / 2;
-        linesdfShader->u_mix = mix;
+        // Outside of a fade, only one of the two dash patterns is visible.
+        const bool crossfade = mix > 0.0f && mix < 1.0f;
+        if (mix >= 1.0f) {
+            scaleX *= 2.0;
+        }
 
-        bucket.drawLineSDF(*linesdfShader);
+        LineSDFShader &shader = linesdfShader[crossfade ? Shader::Crossfade : 0];
+        useProgram(shader.program);
+
+        shader.u_matrix = vtxMatrix;
+        shader.u_exmatrix = extrudeMatrix;
+        shader.u_linewidth = {{ outset, inset }};
+        shader.u_ratio = ratio;
+        shader.u_blur = blur;
+        shader.u_color = color;
+
+        shader.u_patternscale_a = {{ scaleX, scaleY }};
+        shader.u_tex_y_a = pos.y;
+        shader.u_patternscale_b = {{ scaleX * 2.0f, scaleY }};
+        shader.u_tex_y_b = pos.y;
+        shader.u_image = 0;
+        shader.u_sdfgamma = lineAtlas.width / (properties.dash_line_width * pos.width * 256.0 * state.getPixelRatio()) / 2;
+        shader.u_mix = mix;
+
+        bucket.drawLineSDF(shader, groups);
 
     } else if (properties.image.size()) {
         SpriteAtlasPosition imagePos = spriteAtlas.getPosition(properties.image, true);
@@ -126,25 +110,33 @@ void Painter::renderLine(LineBucket& bucket, util::ptr<StyleLayer> layer_desc, c
             fade = fraction - fraction * t;
         }
 
-        useProgram(linepatternShader->program);
+        // Outside of a fade, only one of the two samples is visible. The second one is the
+        // pattern at half the length.
+        const bool crossfade = fade > 0.0f && fade < 1.0f;
+        if (fade >= 1.0f) {
+            factor /= 2.0;
+        }
+
+        LinepatternShader &shader = linepatternShader[crossfade ? Shader::Crossfade : 0];
+        useProgram(shader.program);
 
-        linepatternShader->u_matrix = vtxMatrix;
-        linepatternShader->u_exmatrix = extrudeMatrix;
-        linepatternShader->u_linewidth = {{ outset, inset }};
-        linepatternShader->u_ratio = ratio;
-        linepatternShader->u_blur = blur;
+        shader.u_matrix = vtxMatrix;
+        shader.u_exmatrix = extrudeMatrix;
+        shader.u_linewidth = {{ outset, inset }};
+        shader.u_ratio = ratio;
+        shader.u_blur = blur;
 
-        linepatternShader->u_pattern_size = {{imagePos.size[0] * factor, imagePos.size[1]}};
-        linepatternShader->u_pattern_tl = imagePos.tl;
-        linepatternShader->u_pattern_br = imagePos.br;
-        linepatternShader->u_fade = fade;
-        linepatternShader->u_opacity = properties.opacity;
+        shader.u_pattern_size = {{imagePos.size[0] * factor, imagePos.size[1]}};
+        shader.u_pattern_tl = imagePos.tl;
+        shader.u_pattern_br = imagePos.br;
+        shader.u_fade = fade;
+        shader.u_opacity = properties.opacity;
 
-        MBGL_CHECK_ERROR(glActiveTexture(GL_TEXTURE0));
+        gl::State::Get().activeTexture(GL_TEXTURE0);
         spriteAtlas.bind(true);
-        MBGL_CHECK_ERROR(glDepthRange(strata + strata_epsilon, 1.0f));  // may or may not matter
+        depthRange(strata + strata_epsilon, 1.0f);  // may or may not matter
 
-        bucket.drawLinePatterns(*linepatternShader);
+        bucket.drawLinePatterns(shader, groups);
 
     } else {
         useProgram(lineShader->program);
@@ -157,6 +149,6 @@ void Painter::renderLine(LineBucket& bucket, util::ptr<StyleLayer> layer_desc, c
 
         lineShader->u_color = color;
 
-        bucket.drawLines(*lineShader);
+        bucket.drawLines(*lineShader, groups);
     }
 }
@@ -18,7 +18,7 @@ void Painter::renderSDF(SymbolBucket &bucket,
                         float sdfFontSize,
                         std::array<float, 2> texsize,
                         SDFShader& sdfShader,
-                        void (SymbolBucket::*drawSDF)(SDFShader&))
+                        void (SymbolBucket::*drawSDF)(SDFShader&, const ElementCuller&))
 {
     mat4 vtxMatrix = translatedMatrix(matrix, styleProperties.translate, id, styleProperties.translate_anchor);
 
@@ -37,6 +37,8 @@ void Painter::renderSDF(SymbolBucket &bucket,
     float fontScale = fontSize / sdfFontSize;
     matrix::scale(exMatrix, exMatrix, fontScale, fontScale, 1.0f);
 
+    const ElementCuller groups = culler(vtxMatrix, styleProperties.halo_width + styleProperties.halo_blur + 1, fontScale);
+
     useProgram(sdfShader.program);
     sdfShader.u_matrix = vtxMatrix;
     sdfShader.u_exmatrix = exMatrix;
@@ -85,7 +87,7 @@ void Painter::renderSDF(SymbolBucket &bucket,
         sdfShader.u_buffer = (haloOffset - styleProperties.halo_width / fontScale) / sdfPx;
 
         depthRange(strata, 1.0f);
-        (bucket.*drawSDF)(sdfShader);
+        (bucket.*drawSDF)(sdfShader, groups);
     }
 
     // Then, we draw the text/icon over the halo
@@ -106,11 +108,11 @@ void Painter::renderSDF(SymbolBucket &bucket,
         sdfShader.u_buffer = (256.0f - 64.0f) / 256.0f;
 
         depthRange(strata + strata_epsilon, 1.0f);
-        (bucket.*drawSDF)(sdfShader);
+        (bucket.*drawSDF)(sdfShader, groups);
     }
 }
 
-void Painter::renderSymbol(SymbolBucket &bucket, util::ptr<StyleLayer> layer_desc, const Tile::ID &id, const mat4 &matrix) {
+void Painter::renderSymbol(SymbolBucket &bucket, const util::ptr<StyleLayer> &layer_desc, const Tile::ID &id, const mat4 &matrix) {
     // Abort early.
     if (pass == RenderPass::Opaque) {
         return;
@@ -118,7 +120,7 @@ void Painter::renderSymbol(SymbolBucket &bucket, util::ptr<StyleLayer> layer_des
 
     const SymbolProperties &properties = layer_desc->getProperties<SymbolProperties>();
 
-    MBGL_CHECK_ERROR(glDisable(GL_STENCIL_TEST));
+    setClipping(false);
 
     if (bucket.hasIconData()) {
         bool sdf = bucket.sdfIcons;
@@ -142,7 +144,7 @@ void Painter::renderSymbol(SymbolBucket &bucket, util::ptr<StyleLayer> layer_des
                       properties.icon,
                       1.0f,
                       {{ float(spriteAtlas.getWidth()) / 4.0f, float(spriteAtlas.getHeight()) / 4.0f }},
-                      *sdfIconShader,
+                      bucket.instanced ? static_cast<SDFShader &>(*sdfInstancedShader) : *sdfIconShader,
                       &SymbolBucket::drawIcons);
         } else {
             mat4 vtxMatrix = translatedMatrix(matrix, properties.icon.translate, id, properties.icon.translate_anchor);
@@ -156,10 +158,12 @@ void Painter::renderSymbol(SymbolBucket &bucket, util::ptr<StyleLayer> layer_des
 
             matrix::scale(exMatrix, exMatrix, fontScale, fontScale, 1.0f);
 
-            useProgram(iconShader->program);
-            iconShader->u_matrix = vtxMatrix;
-            iconShader->u_exmatrix = exMatrix;
-            iconShader->u_texsize = {{ float(spriteAtlas.getWidth()) / 4.0f, float(spriteAtlas.getHeight()) / 4.0f }};
+            IconShader &shader = bucket.instanced ? *iconInstancedShader : *iconShader;
+
+            useProgram(shader.program);
+            shader.u_matrix = vtxMatrix;
+            shader.u_exmatrix = exMatrix;
+            shader.u_texsize = {{ float(spriteAtlas.getWidth()) / 4.0f, float(spriteAtlas.getHeight()) / 4.0f }};
 
             // Convert the -pi..pi to an int8 range.
             const float angle = std::round(state.getAngle() / M_PI * 128);
@@ -167,21 +171,21 @@ void Painter::renderSymbol(SymbolBucket &bucket, util::ptr<StyleLayer> layer_des
             // adjust min/max zooms for variable font sies
             float zoomAdjust = std::log(fontSize / bucket.properties.icon.max_size) / std::log(2);
 
-            iconShader->u_angle = (int32_t)(angle + 256) % 256;
+            shader.u_angle = (int32_t)(angle + 256) % 256;
 
             bool flip = (bucket.properties.icon.rotation_alignment == RotationAlignmentType::Map)
                 && bucket.properties.icon.keep_upright;
-            iconShader->u_flip = flip ? 1 : 0;
-            iconShader->u_zoom = (state.getNormalizedZoom() - zoomAdjust) * 10; // current zoom level
+            shader.u_flip = flip ? 1 : 0;
+            shader.u_zoom = (state.getNormalizedZoom() - zoomAdjust) * 10; // current zoom level
 
-            iconShader->u_fadedist = 0 * 10;
-            iconShader->u_minfadezoom = state.getNormalizedZoom() * 10;
-            iconShader->u_maxfadezoom = state.getNormalizedZoom() * 10;
-            iconShader->u_fadezoom = state.getNormalizedZoom() * 10;
-            iconShader->u_opacity = properties.icon.opacity;
+            shader.u_fadedist = 0 * 10;
+            shader.u_minfadezoom = state.getNormalizedZoom() * 10;
+            shader.u_maxfadezoom = state.getNormalizedZoom() * 10;
+            shader.u_fadezoom = state.getNormalizedZoom() * 10;
+            shader.u_opacity = properties.icon.opacity;
 
             depthRange(strata, 1.0f);
-            bucket.drawIcons(*iconShader);
+            bucket.drawIcons(shader, culler(vtxMatrix, 1, fontScale));
         }
     }
 
@@ -195,9 +199,9 @@ void Painter::renderSymbol(SymbolBucket &bucket, util::ptr<StyleLayer> layer_des
                   properties.text,
                   24.0f,
                   {{ float(glyphAtlas.width) / 4, float(glyphAtlas.height) / 4 }},
-                  *sdfGlyphShader,
+                  bucket.instanced ? static_cast<SDFShader &>(*sdfInstancedShader) : *sdfGlyphShader,
                   &SymbolBucket::drawGlyphs);
     }
 
-    MBGL_CHECK_ERROR(glEnable(GL_STENCIL_TEST));
+    setClipping(true);
 }
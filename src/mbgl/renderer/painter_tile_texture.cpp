@@ -0,0 +1,281 @@
+#include <mbgl/renderer/painter.hpp>
+#include <mbgl/style/style.hpp>
+#include <mbgl/style/style_layer.hpp>
+#include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/style/style_bucket.hpp>
+#include <mbgl/map/source.hpp>
+#include <mbgl/util/constants.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace mbgl;
+
+namespace {
+
+// Textures take four bytes per pixel, so at a pixel ratio of 2 this covers 16 tiles. Tiles beyond
+// it draw their layers as usual.
+const size_t maxTileTextureBytes = 64 * 1024 * 1024;
+
+// Only layers that draw nothing but their own tile, and that look the same while panning, go into
+// the textures. We stop at the first other layer, since everything above it has to blend with it.
+bool isTexturableLayer(const StyleLayer &layer_desc) {
+    return (layer_desc.type == StyleLayerType::Fill || layer_desc.type == StyleLayerType::Line) &&
+           layer_desc.bucket && layer_desc.bucket->style_source &&
+           layer_desc.bucket->style_source->source;
+}
+
+}
+
+void Painter::setTileTextureCaching(bool enabled) {
+    tileTextureCaching = enabled;
+}
+
+MemoryUsage Painter::releaseTileTextures() {
+    MemoryUsage usage;
+    for (const auto &texture : tileTextures) {
+        usage.gpu += size_t(texture.second->size) * texture.second->size * 4;
+    }
+    for (const auto &texture : spareTileTextures) {
+        usage.gpu += size_t(texture->size) * texture->size * 4;
+    }
+    clearTileTextures();
+    return usage;
+}
+
+void Painter::clearTileTextures() {
+    tileTextures.clear();
+    spareTileTextures.clear();
+    texturedTiles.clear();
+    textureLayers.clear();
+}
+
+bool Painter::isInTileTexture(const Tile& tile, const StyleLayer& layer_desc) const {
+    const bool cached = std::find_if(textureLayers.begin(), textureLayers.end(), [&](const util::ptr<StyleLayer> &layer) {
+        return layer.get() == &layer_desc;
+    }) != textureLayers.end();
+    if (!cached) {
+        return false;
+    }
+
+    const auto it = tileTextures.find(tile.id);
+    return it != tileTextures.end() && it->second->current;
+}
+
+void Painter::updateTileTextures(const Style& style, timestamp time) {
+    texturedTiles.clear();
+    for (auto &texture : tileTextures) {
+        texture.second->current = false;
+    }
+
+    // The textures are drawn at the scale of tiles at an integer zoom level, and can't be rotated
+    // since lines are antialiased in screen space. Patterns still blend between zoom levels for a
+    // while after an integer zoom level was passed. Frames at a lower resolution would need
+    // textures of another size, and snapshots would draw over textures of the view.
+    const double fraction = state.getZoomFraction();
+    if (!tileTextureCaching || snapshot || !style.layers || state.getAngle() != 0 || resolution < 1 ||
+        (fraction > 0.001 && fraction < 0.999) || time - lastIntegerZoomTime < 300_milliseconds ||
+        style.hasTransitions()) {
+        return;
+    }
+
+    std::vector<util::ptr<StyleLayer>> layers;
+    const Source *source = nullptr;
+    for (const util::ptr<StyleLayer> &layer : style.layers->layers) {
+        if (layers.empty() && layer->type == StyleLayerType::Background) {
+            // Backgrounds don't belong to a tile.
+            continue;
+        }
+        if (!isTexturableLayer(*layer) ||
+            (source && layer->bucket->style_source->source.get() != source)) {
+            break;
+        }
+        source = layer->bucket->style_source->source.get();
+        layers.push_back(layer);
+    }
+    if (layers.size() < 2) {
+        // Compositing a single layer doesn't save anything.
+        layers.clear();
+    }
+
+    const uint16_t size = util::tileSize * state.getPixelRatio();
+    const bool resized = (!tileTextures.empty() && tileTextures.begin()->second->size != size) ||
+                         (!spareTileTextures.empty() && spareTileTextures.front()->size != size);
+    if (resized) {
+        clearTileTextures();
+    }
+    if (layers != textureLayers || style.getGeneration() != textureStyleGeneration) {
+        // The contents are outdated, but the textures can be drawn into again.
+        for (auto &texture : tileTextures) {
+            spareTileTextures.push_back(std::move(texture.second));
+        }
+        tileTextures.clear();
+        textureLayers = layers;
+        textureStyleGeneration = style.getGeneration();
+    }
+    if (textureLayers.empty()) {
+        clearTileTextures();
+        return;
+    }
+
+    // Tiles near the center of the viewport get textures first.
+    const int32_t zoom = std::round(state.getZoom());
+    std::vector<const Tile *> tiles;
+    for (const Tile *tile : source->getLoadedTiles()) {
+        if (tile->id.z == zoom && !tile->occluded && tile->data) {
+            tiles.push_back(tile);
+        }
+    }
+    std::sort(tiles.begin(), tiles.end(), [](const Tile *a, const Tile *b) {
+        return a->data->priority < b->data->priority;
+    });
+
+    const size_t textureBytes = size_t(size) * size * 4;
+    const size_t maxTextures = maxTileTextureBytes / textureBytes;
+    if (tiles.size() > maxTextures) {
+        tiles.resize(maxTextures);
+    }
+    texturedTiles.assign(tiles.begin(), tiles.end());
+
+    // Set aside the textures of tiles that went off screen, so that the tiles that came into view
+    // can take them over. Allocating a texture and attaching it to a framebuffer is much slower
+    // than clearing one.
+    for (auto it = tileTextures.begin(); it != tileTextures.end();) {
+        if (std::find_if(texturedTiles.begin(), texturedTiles.end(), [&](const Tile *tile) {
+                return tile->id == it->first;
+            }) == texturedTiles.end()) {
+            spareTileTextures.push_back(std::move(it->second));
+            it = tileTextures.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::vector<const Tile *> stale;
+    for (const Tile *tile : texturedTiles) {
+        std::unique_ptr<TileTexture> &texture = tileTextures[tile->id];
+        if (!texture) {
+            if (spareTileTextures.empty()) {
+                texture = util::make_unique<TileTexture>(size);
+            } else {
+                texture = std::move(spareTileTextures.back());
+                spareTileTextures.pop_back();
+                texture->data = nullptr;
+                texture->generation = 0;
+            }
+        }
+        if (texture->data != tile->data.get() || texture->generation != tile->data->generation) {
+            stale.push_back(tile);
+        }
+    }
+
+    // Spares count towards the limit as well.
+    const size_t maxSpares = maxTextures - tileTextures.size();
+    if (spareTileTextures.size() > maxSpares) {
+        spareTileTextures.resize(maxSpares);
+    }
+
+    if (!stale.empty()) {
+        MBGL_GL_GROUP("tile textures");
+
+        // The layers are collected before any texture is marked current, so that none of them
+        // are skipped. Each layer draws its opaque and then its translucent parts; without a depth
+        // buffer, the layers above have to be drawn after it.
+        renderItems.clear();
+        std::map<const Source *, std::forward_list<Tile *>> sourceTiles;
+        uint32_t order = 0;
+        for (const util::ptr<StyleLayer> &layer : textureLayers) {
+            addRenderItems(layer, RenderPass::Opaque, order, 0, sourceTiles);
+            addRenderItems(layer, RenderPass::Translucent, order, 0, sourceTiles);
+            order++;
+        }
+
+        // Draw with a camera whose viewport is exactly one tile. The projection is flipped so that
+        // the top of the tile ends up in the first row of the texture.
+        const TransformState screenState = state;
+        const mat4 screenProjMatrix = projMatrix;
+        const mat4 screenExtrudeMatrix = extrudeMatrix;
+        const mat4 screenNativeMatrix = nativeMatrix;
+
+        state = state.resized(util::tileSize, util::tileSize);
+        matrix::ortho(projMatrix, 0, util::tileSize, 0, util::tileSize, 0, 1);
+        extrudeMatrix = projMatrix;
+        nativeMatrix = projMatrix;
+
+        mat4 tileMatrix;
+        matrix::scale(tileMatrix, projMatrix, util::tileSize / 4096.0f, util::tileSize / 4096.0f, 1);
+
+        gl::State &glState = gl::State::Get();
+        glState.enable(GL_DEPTH_TEST, false);
+        setClipping(false);
+
+        for (const Tile *tile : stale) {
+            TileTexture &texture = *tileTextures[tile->id];
+            if (!texture.bindFramebuffer()) {
+                // The driver can't draw into textures; keep drawing the layers directly.
+                tileTextureCaching = false;
+                break;
+            }
+            for (const RenderItem &item : renderItems) {
+                if (item.tile == tile) {
+                    if (item.pass == RenderPass::Opaque) {
+                        setOpaque();
+                    } else {
+                        setTranslucent();
+                    }
+                    renderTileLayer(*tile, item.layer, tileMatrix);
+                }
+            }
+            texture.unbindFramebuffer();
+            texture.data = tile->data.get();
+            texture.generation = tile->data->generation;
+        }
+
+        glState.enable(GL_DEPTH_TEST, true);
+        setClipping(true);
+        MBGL_CHECK_ERROR(glViewport(0, 0, gl_viewport[0], gl_viewport[1]));
+
+        state = screenState;
+        projMatrix = screenProjMatrix;
+        extrudeMatrix = screenExtrudeMatrix;
+        nativeMatrix = screenNativeMatrix;
+        renderItems.clear();
+
+        if (!tileTextureCaching) {
+            clearTileTextures();
+            return;
+        }
+    }
+
+    for (const Tile *tile : texturedTiles) {
+        tileTextures[tile->id]->current = true;
+    }
+}
+
+void Painter::renderTileTexture(const Tile& tile) {
+    const auto it = tileTextures.find(tile.id);
+    assert(it != tileTextures.end());
+
+    MBGL_GL_GROUP(std::string { "composite " } + tile.data->name);
+    prepareTile(tile);
+
+    // The texture holds premultiplied colors already, so it is drawn as it is.
+    useProgram(rasterShader->program);
+    rasterShader->u_matrix = tile.matrix;
+    rasterShader->u_buffer = 0;
+    rasterShader->u_image = 0;
+    rasterShader->u_opacity = 1.0f;
+    rasterShader->u_brightness_low = 0.0f;
+    rasterShader->u_brightness_high = 1.0f;
+    rasterShader->u_saturation_factor = saturationFactor(0.0f);
+    rasterShader->u_contrast_factor = contrastFactor(0.0f);
+    rasterShader->u_spin_weights = spinWeights(0.0f);
+
+    depthRange(strata + strata_epsilon, 1.0f);
+
+    it->second->bind();
+    coveringRasterArray.bind(*rasterShader, tileStencilBuffer, BUFFER_OFFSET(0));
+    gl::State::Get().drawArrays(GL_TRIANGLES, 0, (GLsizei)tileStencilBuffer.index());
+}
@@ -0,0 +1,61 @@
+#include <mbgl/renderer/pixel_reader.hpp>
+#include <mbgl/util/std.hpp>
+#include <mbgl/util/image_kernels.hpp>
+
+#include <cstring>
+
+using namespace mbgl;
+
+PixelReader::~PixelReader() {
+    // The reads that are left can't be delivered anymore, e.g. because the context is going away.
+    for (const Read &read : reads) {
+        MBGL_CHECK_ERROR(glDeleteBuffers(1, &read.buffer));
+    }
+}
+
+void PixelReader::read(const std::array<uint16_t, 2> &size, Callback callback) {
+    const size_t bytes = size_t(size[0]) * size[1] * 4;
+
+    if (!gl::isPixelBufferObjectSupported()) {
+        auto pixels = util::make_unique<uint32_t[]>(size_t(size[0]) * size[1]);
+        MBGL_CHECK_ERROR(glReadPixels(0, 0, size[0], size[1], GL_RGBA, GL_UNSIGNED_BYTE, pixels.get()));
+        // GL reads the bottom row first.
+        util::flipRows(pixels.get(), size[0], size[1]);
+        callback(std::move(pixels));
+        return;
+    }
+
+    GLuint buffer = 0;
+    MBGL_CHECK_ERROR(glGenBuffers(1, &buffer));
+    MBGL_CHECK_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer));
+    MBGL_CHECK_ERROR(glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ));
+    MBGL_CHECK_ERROR(glReadPixels(0, 0, size[0], size[1], GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+    MBGL_CHECK_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+    reads.push_back({ buffer, size, callback });
+}
+
+void PixelReader::finish() {
+    // Callbacks may start new reads.
+    std::vector<Read> finished;
+    finished.swap(reads);
+
+    for (const Read &read : finished) {
+        const size_t bytes = size_t(read.size[0]) * read.size[1] * 4;
+        std::unique_ptr<uint32_t[]> pixels;
+
+        MBGL_CHECK_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER, read.buffer));
+        const void *data = MBGL_CHECK_ERROR(gl::MapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT));
+        if (data) {
+            pixels = util::make_unique<uint32_t[]>(size_t(read.size[0]) * read.size[1]);
+            std::memcpy(pixels.get(), data, bytes);
+            MBGL_CHECK_ERROR(gl::UnmapBuffer(GL_PIXEL_PACK_BUFFER));
+        }
+        MBGL_CHECK_ERROR(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+        MBGL_CHECK_ERROR(glDeleteBuffers(1, &read.buffer));
+
+        if (pixels) {
+            util::flipRows(pixels.get(), read.size[0], read.size[1]);
+        }
+        read.callback(std::move(pixels));
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef MBGL_RENDERER_PIXEL_READER
+#define MBGL_RENDERER_PIXEL_READER
+
+#include <mbgl/platform/gl.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mbgl {
+
+// Reads the pixels of the bound framebuffer without waiting for the GPU to finish drawing them:
+// with pixel buffer objects, read() only starts the transfer, and finish() copies the pixels out
+// later, e.g. during the next frame. Without them, read() waits and calls back right away.
+//
+// The pixels are RGBA with premultiplied alpha, top row first. Must be used on the thread with
+// the GL context.
+class PixelReader : private util::noncopyable {
+public:
+    // Called with nullptr if the pixels couldn't be read.
+    typedef std::function<void (std::unique_ptr<uint32_t[]>)> Callback;
+
+    ~PixelReader();
+
+    void read(const std::array<uint16_t, 2> &size, Callback callback);
+
+    // Calls back for all reads that were started.
+    void finish();
+
+    inline bool hasPendingReads() const { return !reads.empty(); }
+
+private:
+    struct Read {
+        GLuint buffer;
+        std::array<uint16_t, 2> size;
+        Callback callback;
+    };
+
+    std::vector<Read> reads;
+};
+
+}
+
+#endif
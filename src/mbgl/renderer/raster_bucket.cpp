@@ -8,7 +8,7 @@ RasterBucket::RasterBucket(TexturePool& texturePool, const StyleBucketRaster& pr
   raster(texturePool) {
 }
 
-void RasterBucket::render(Painter &painter, util::ptr<StyleLayer> layer_desc, const Tile::ID &id, const mat4 &matrix) {
+void RasterBucket::render(Painter &painter, const util::ptr<StyleLayer> &layer_desc, const Tile::ID &id, const mat4 &matrix) {
     painter.renderRaster(*this, layer_desc, id, matrix);
 }
 
@@ -20,16 +20,28 @@ void RasterBucket::drawRaster(RasterShader& shader, StaticVertexBuffer &vertices
     raster.bind(true);
     shader.u_image = 0;
     array.bind(shader, vertices, BUFFER_OFFSET(0));
-    MBGL_CHECK_ERROR(glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.index()));
+    gl::State::Get().drawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.index());
 }
 
 void RasterBucket::drawRaster(RasterShader& shader, StaticVertexBuffer &vertices, VertexArrayObject &array, GLuint texture_) {
     raster.bind(texture_);
     shader.u_image = 0;
     array.bind(shader, vertices, BUFFER_OFFSET(0));
-    MBGL_CHECK_ERROR(glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.index()));
+    gl::State::Get().drawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.index());
 }
 
 bool RasterBucket::hasData() const {
     return raster.isLoaded();
 }
+
+MemoryUsage RasterBucket::memoryUsage() const {
+    return raster.memoryUsage();
+}
+
+size_t RasterBucket::upload(size_t) {
+    return raster.upload();
+}
+
+bool RasterBucket::isUploaded() const {
+    return !raster.isLoaded() || raster.textured;
+}
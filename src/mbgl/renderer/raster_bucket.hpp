@@ -17,8 +17,11 @@ class RasterBucket : public Bucket {
 public:
     RasterBucket(TexturePool&, const StyleBucketRaster&);
 
-    virtual void render(Painter& painter, util::ptr<StyleLayer> layer_desc, const Tile::ID& id, const mat4 &matrix);
+    virtual void render(Painter& painter, const util::ptr<StyleLayer> &layer_desc, const Tile::ID& id, const mat4 &matrix);
     virtual bool hasData() const;
+    virtual MemoryUsage memoryUsage() const;
+    virtual size_t upload(size_t maxBytes);
+    virtual bool isUploaded() const;
 
     bool setImage(const std::string &data);
 
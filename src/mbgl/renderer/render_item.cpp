@@ -0,0 +1,21 @@
+#include <mbgl/renderer/render_item.hpp>
+
+#include <algorithm>
+#include <tuple>
+
+namespace mbgl {
+
+void sortRenderItems(std::vector<RenderItem> &items) {
+    const auto translucent = std::stable_partition(items.begin(), items.end(), [](const RenderItem &item) {
+        return item.pass == RenderPass::Opaque;
+    });
+
+    // Layers go top to bottom, so that early depth testing rejects the fragments of lower layers
+    // that upper ones cover; the tiles of a layer are grouped by their shader and texture.
+    std::stable_sort(items.begin(), translucent, [](const RenderItem &a, const RenderItem &b) {
+        return std::tie(a.order, a.shader, a.texture, a.clip) <
+               std::tie(b.order, b.shader, b.texture, b.clip);
+    });
+}
+
+}
@@ -0,0 +1,47 @@
+#ifndef MBGL_RENDERER_RENDER_ITEM
+#define MBGL_RENDERER_RENDER_ITEM
+
+#include <mbgl/util/ptr.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace mbgl {
+
+class Tile;
+class StyleLayer;
+
+enum class RenderPass : bool { Opaque, Translucent };
+
+// A single draw of the painter: one layer of one tile, the texture of a tile, or a background
+// layer. The painter collects the items of a frame before it issues any GL calls, so that they can
+// be sorted to change as little GL state as possible.
+struct RenderItem {
+    // The shader and texture that the item draws with, as far as they are known up front.
+    enum class Shader : uint8_t { Plain, Pattern, Line, Circle, Symbol, Raster };
+    enum class Texture : uint8_t { None, SpriteAtlas, LineAtlas, GlyphAtlas, Tile };
+
+    RenderPass pass;
+    // Position in the order of the pass in which the layers were traversed.
+    uint32_t order;
+    Shader shader;
+    Texture texture;
+    // Stencil mask and reference of the tile. Background layers use 0xFFFF so that they draw after
+    // the tiles above them.
+    uint16_t clip;
+
+    float strata;
+    // nullptr for an item that composites the tile texture of the tile.
+    util::ptr<StyleLayer> layer;
+    // nullptr for background layers.
+    const Tile *tile;
+};
+
+// Moves the opaque items first and sorts them front to back, so that the depth buffer holds the
+// upper layers before the lower ones draw. Translucent items keep their order, which blending
+// depends on.
+void sortRenderItems(std::vector<RenderItem> &items);
+
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include <mbgl/renderer/render_target.hpp>
+#include <mbgl/platform/gl_state.hpp>
+#include <mbgl/platform/log.hpp>
+
+using namespace mbgl;
+
+RenderTarget::~RenderTarget() {
+    release();
+}
+
+void RenderTarget::release() {
+    if (fbo) {
+        MBGL_CHECK_ERROR(glDeleteFramebuffers(1, &fbo));
+        fbo = 0;
+    }
+    if (stencil && stencil != depth) {
+        MBGL_CHECK_ERROR(glDeleteRenderbuffers(1, &stencil));
+    }
+    if (depth) {
+        MBGL_CHECK_ERROR(glDeleteRenderbuffers(1, &depth));
+    }
+    depth = stencil = 0;
+    if (texture) {
+        gl::State::Get().deleteTextures(1, &texture);
+        texture = 0;
+    }
+    size = {{ 0, 0 }};
+}
+
+bool RenderTarget::bindFramebuffer(const std::array<uint16_t, 2> &size_) {
+    MBGL_CHECK_ERROR(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo));
+
+    if (fbo && size == size_) {
+        MBGL_CHECK_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, fbo));
+        return true;
+    }
+
+    release();
+    size = size_;
+
+    MBGL_CHECK_ERROR(glGenTextures(1, &texture));
+    gl::State::Get().bindTexture(texture);
+    MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    MBGL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size[0], size[1], 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+
+    // The painter uses the depth buffer for its strata and the stencil buffer for clipping.
+    MBGL_CHECK_ERROR(glGenRenderbuffers(1, &depth));
+    MBGL_CHECK_ERROR(glBindRenderbuffer(GL_RENDERBUFFER, depth));
+    if (gl::isPackedDepthStencilSupported) {
+        MBGL_CHECK_ERROR(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size[0], size[1]));
+        stencil = depth;
+    } else {
+        MBGL_CHECK_ERROR(glRenderbufferStorage(GL_RENDERBUFFER, gl::isDepth24Supported ? GL_DEPTH_COMPONENT24 : GL_DEPTH_COMPONENT16, size[0], size[1]));
+        MBGL_CHECK_ERROR(glGenRenderbuffers(1, &stencil));
+        MBGL_CHECK_ERROR(glBindRenderbuffer(GL_RENDERBUFFER, stencil));
+        MBGL_CHECK_ERROR(glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, size[0], size[1]));
+    }
+    MBGL_CHECK_ERROR(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+    MBGL_CHECK_ERROR(glGenFramebuffers(1, &fbo));
+    MBGL_CHECK_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, fbo));
+    MBGL_CHECK_ERROR(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0));
+    MBGL_CHECK_ERROR(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth));
+    MBGL_CHECK_ERROR(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, stencil));
+
+    const GLenum status = MBGL_CHECK_ERROR(glCheckFramebufferStatus(GL_FRAMEBUFFER));
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        Log::Warning(Event::OpenGL, "Render target framebuffer is incomplete: 0x%x", status);
+        unbindFramebuffer();
+        release();
+        return false;
+    }
+    return true;
+}
+
+void RenderTarget::unbindFramebuffer() {
+    MBGL_CHECK_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, previousFbo));
+}
+
+void RenderTarget::bind() {
+    gl::State::Get().bindTexture(texture);
+}
+
+size_t RenderTarget::memoryUsage() const {
+    // Four bytes of color and four of depth and stencil per pixel.
+    return size_t(size[0]) * size[1] * 8;
+}
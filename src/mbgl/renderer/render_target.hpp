@@ -0,0 +1,47 @@
+#ifndef MBGL_RENDERER_RENDER_TARGET
+#define MBGL_RENDERER_RENDER_TARGET
+
+#include <mbgl/platform/gl.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <array>
+#include <cstdint>
+
+namespace mbgl {
+
+// A color texture with depth and stencil buffers that a whole frame can be drawn into, e.g. at a
+// lower resolution than the screen's, before the texture is stretched over the screen. Must be
+// used on the thread with the GL context.
+class RenderTarget : private util::noncopyable {
+public:
+    ~RenderTarget();
+
+    // Makes the target the draw target, with storage of the given size; the storage is only
+    // allocated again when the size changes. Returns false if the driver can't draw into it.
+    bool bindFramebuffer(const std::array<uint16_t, 2> &size);
+
+    // Returns to the framebuffer that was bound before bindFramebuffer().
+    void unbindFramebuffer();
+
+    // Binds the color texture to the active texture unit.
+    void bind();
+
+    // Bytes of GPU memory held.
+    size_t memoryUsage() const;
+
+    // Deletes the storage; the next bindFramebuffer() allocates it again.
+    void release();
+
+private:
+    std::array<uint16_t, 2> size = {{ 0, 0 }};
+    GLuint texture = 0;
+    GLuint fbo = 0;
+    // With packed depth and stencil, both are the same renderbuffer.
+    GLuint depth = 0;
+    GLuint stencil = 0;
+    GLint previousFbo = 0;
+};
+
+}
+
+#endif
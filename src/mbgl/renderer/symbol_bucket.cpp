@@ -1,4 +1,5 @@
 #include <mbgl/renderer/symbol_bucket.hpp>
+#include <mbgl/map/vector_tile_data.hpp>
 #include <mbgl/geometry/text_buffer.hpp>
 #include <mbgl/geometry/icon_buffer.hpp>
 #include <mbgl/geometry/glyph_atlas.hpp>
@@ -17,13 +18,68 @@
 #include <mbgl/util/token.hpp>
 #include <mbgl/util/math.hpp>
 #include <mbgl/util/merge_lines.hpp>
+#include <mbgl/util/allocation_tracker.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
 
 namespace mbgl {
 
-SymbolBucket::SymbolBucket(const StyleBucketSymbol &properties_, Collision &collision_)
-    : properties(properties_), collision(collision_) {}
+namespace {
+
+// Adds the time and the allocations of the calling thread until the end of the scope to a stage
+// of the profile, if the bucket has one.
+class StageScope : private util::noncopyable {
+public:
+    typedef SymbolBucket::Profile Profile;
+
+    inline StageScope(Profile *profile, Profile::Stage Profile::*stage_)
+        : stage(profile ? &(profile->*stage_) : nullptr) {
+        if (stage) {
+            allocated = AllocationTracker::thread().sum();
+            start = util::now();
+        }
+    }
+
+    inline ~StageScope() {
+        end();
+    }
+
+    // Ends the stage before the end of the scope.
+    inline void end() {
+        if (stage) {
+            stage->time += util::now() - start;
+            stage->allocations += AllocationTracker::thread().sum() - allocated;
+            stage = nullptr;
+        }
+    }
+
+private:
+    Profile::Stage *stage;
+    AllocationUsage allocated;
+    timestamp start = 0;
+};
+
+}
 
-void SymbolBucket::render(Painter &painter, util::ptr<StyleLayer> layer_desc,
+SymbolBucket::SymbolBucket(const StyleBucketSymbol &properties_, Collision &collision_,
+                           TileBuffers &buffers)
+    : properties(properties_),
+      textField(properties.text.field),
+      iconImage(properties.icon.image),
+      instanced(buffers.instanced),
+      collision(collision_),
+      text { buffers.textVertexBuffer, buffers.triangleElementsBuffer, buffers.textInstanceBuffer,
+             buffers.textPlacementBuffer, buffers.textVertexBuffer.index(),
+             buffers.triangleElementsBuffer.index(), buffers.textInstanceBuffer.index(),
+             buffers.textPlacementBuffer.index(), {}, {} },
+      icon { buffers.iconVertexBuffer, buffers.iconElementsBuffer, buffers.iconInstanceBuffer,
+             buffers.iconPlacementBuffer, buffers.iconVertexBuffer.index(),
+             buffers.iconElementsBuffer.index(), buffers.iconInstanceBuffer.index(),
+             buffers.iconPlacementBuffer.index(), {}, {} } {}
+
+void SymbolBucket::render(Painter &painter, const util::ptr<StyleLayer> &layer_desc,
                           const Tile::ID &id, const mat4 &matrix) {
     painter.renderSymbol(*this, layer_desc, id, matrix);
 }
@@ -34,16 +90,59 @@ bool SymbolBucket::hasTextData() const { return !text.groups.empty(); }
 
 bool SymbolBucket::hasIconData() const { return !icon.groups.empty(); }
 
+MemoryUsage SymbolBucket::memoryUsage() const {
+    size_t textVertices = 0, textTriangles = 0, iconVertices = 0, iconTriangles = 0;
+    for (const TextElementGroup &group : text.groups) {
+        textVertices += group.vertex_length;
+        textTriangles += group.elements_length;
+    }
+    for (const IconElementGroup &group : icon.groups) {
+        iconVertices += group.vertex_length;
+        iconTriangles += group.elements_length;
+    }
+    const MemoryUsage placements = text.placements.memoryUsage(textVertices) +
+                                   icon.placements.memoryUsage(iconVertices);
+    if (instanced) {
+        return text.instances.memoryUsage(textVertices) + icon.instances.memoryUsage(iconVertices) +
+               placements;
+    }
+    return text.vertices.memoryUsage(textVertices) + text.triangles.memoryUsage(textTriangles) +
+           icon.vertices.memoryUsage(iconVertices) + icon.triangles.memoryUsage(iconTriangles) +
+           placements;
+}
+
 void SymbolBucket::addGlyphsToAtlas(uint64_t tileid, const std::string stackname,
                                     const std::u32string &text, const FontStack &fontStack,
                                     GlyphAtlas &glyphAtlas, GlyphPositions &face) {
     glyphAtlas.addGlyphs(tileid, text, stackname, fontStack,face);
 }
 
+namespace {
+
+// Maps each token to the index of that key in the layer, or -1 if no feature has it.
+std::vector<int32_t> resolveTokens(const util::TokenTemplate &tokens, const VectorTileLayer &layer) {
+    std::vector<int32_t> keys;
+    for (const std::string &token : tokens.tokens()) {
+        const auto it = layer.key_index.find(token);
+        keys.push_back(it != layer.key_index.end() ? int32_t(it->second) : -1);
+    }
+    return keys;
+}
+
+void appendValue(std::string &result, const Value *value) {
+    if (!value) {
+        return;
+    } else if (value->is<std::string>()) {
+        result.append(value->get<std::string>());
+    } else {
+        result.append(toString(*value));
+    }
+}
+
+}
+
 std::vector<SymbolFeature> SymbolBucket::processFeatures(const VectorTileLayer &layer,
-                                                         const FilterExpression &filter,
-                                                         GlyphStore &glyphStore,
-                                                         const Sprite &sprite) {
+                                                         const FilterProgram &filter) {
     const bool has_text = properties.text.field.size();
     const bool has_icon = properties.icon.image.size();
 
@@ -53,17 +152,35 @@ std::vector<SymbolFeature> SymbolBucket::processFeatures(const VectorTileLayer &
         return features;
     }
 
-    // Determine and load glyph ranges
-    std::set<GlyphRange> ranges;
+    GeometryDecoder geometryDecoder;
+
+    const std::vector<int32_t> textKeys = resolveTokens(textField, layer);
+    const std::vector<int32_t> iconKeys = resolveTokens(iconImage, layer);
+
+    const auto sortKey = layer.key_index.find(properties.sort_key);
+    const bool sorted = !properties.sort_key.empty();
+
+    // Reused for all features, so that only the final label is allocated.
+    std::string u8string;
+    std::u32string u32string;
 
     FilteredVectorTileLayer filtered_layer(layer, filter);
     for (const pbf &feature_pbf : filtered_layer) {
         const VectorTileFeature feature{feature_pbf, layer};
 
+        auto appendToken = [&feature](const std::vector<int32_t> &keys) {
+            return [&feature, &keys](size_t token, std::string &result) {
+                if (keys[token] >= 0) {
+                    appendValue(result, feature.getValue(uint32_t(keys[token])));
+                }
+            };
+        };
+
         SymbolFeature ft;
 
         if (has_text) {
-            std::string u8string = util::replaceTokens(properties.text.field, feature.properties);
+            u8string.clear();
+            textField.render(u8string, appendToken(textKeys));
 
             if (properties.text.transform == TextTransformType::Uppercase) {
                 u8string = platform::uppercase(u8string);
@@ -71,36 +188,21 @@ std::vector<SymbolFeature> SymbolBucket::processFeatures(const VectorTileLayer &
                 u8string = platform::lowercase(u8string);
             }
 
-            ft.label = util::utf8_to_utf32::convert(u8string);
-
-            if (ft.label.size()) {
-                // Loop through all characters of this text and collect unique codepoints.
-                for (char32_t chr : ft.label) {
-                    ranges.insert(getGlyphRange(chr));
-                }
-            }
+            util::utf8_to_utf32::convert(u8string, u32string);
+            ft.label = u32string;
         }
 
         if (has_icon) {
-            ft.sprite = util::replaceTokens(properties.icon.image, feature.properties);
+            iconImage.render(ft.sprite, appendToken(iconKeys));
         }
 
         if (ft.label.length() || ft.sprite.length()) {
 
-            auto &multiline = ft.geometry;
-
-            // Decode line
-            Geometry::command cmd;
-            pbf geom(feature.geometry);
-            Geometry geometry(geom);
-            bool first = true;
-            int32_t x, y;
-            while ((cmd = geometry.next(x, y)) != Geometry::end) {
-                if (first || cmd == Geometry::move_to) {
-                    multiline.emplace_back();
-                    first = false;
-                }
-                multiline.back().emplace_back(x, y);
+            ft.geometry = geometryDecoder.decode(feature.geometry);
+
+            if (sorted) {
+                const Value *value = sortKey != layer.key_index.end() ? feature.getValue(sortKey->second) : nullptr;
+                ft.sortKey = value ? toNumber<double>(*value) : std::numeric_limits<double>::infinity();
             }
 
             features.push_back(std::move(ft));
@@ -111,17 +213,82 @@ std::vector<SymbolFeature> SymbolBucket::processFeatures(const VectorTileLayer &
         util::mergeLines(features);
     }
 
-    glyphStore.waitForGlyphRanges(properties.text.font, ranges);
-    sprite.waitUntilLoaded();
+    // Features are placed in this order, so earlier ones win collisions.
+    if (sorted) {
+        std::stable_sort(features.begin(), features.end(), [](const SymbolFeature &a, const SymbolFeature &b) {
+            return a.sortKey < b.sortKey;
+        });
+    }
 
     return features;
 }
 
-void SymbolBucket::addFeatures(const VectorTileLayer &layer, const FilterExpression &filter,
-                               const Tile::ID &id, SpriteAtlas &spriteAtlas, Sprite &sprite,
-                               GlyphAtlas & glyphAtlas, GlyphStore &glyphStore) {
+void SymbolBucket::thinFeatures() {
+    if (properties.placement != PlacementType::Point || properties.text.allow_overlap ||
+        properties.text.ignore_placement || properties.text.optional) {
+        return;
+    }
+
+    // Labels are at least a quarter of the font size wide and high, and are kept /padding/
+    // apart. Two anchors in the same cell are closer than that on both axes, even when the
+    // tile is shown at maxPlacementScale.
+    const float cellSize = (properties.text.max_size / 4 + properties.text.padding) *
+                           collision.tilePixelRatio / collision.maxPlacementScale;
+    std::unordered_set<uint64_t> occupied;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < features.size(); i++) {
+        SymbolFeature &feature = features[i];
+
+        // Without text, the symbol is placed like an icon, whose size we don't know yet.
+        if (feature.label.size()) {
+            auto &points = feature.geometry;
+            points.erase(std::remove_if(points.begin(), points.end(), [&](const std::vector<Coordinate> &line) {
+                if (line.empty()) {
+                    return true;
+                }
+                const Coordinate &anchor = line[0];
+                if (anchor.x < 0 || anchor.x > 4096 || anchor.y < 0 || anchor.y > 4096) {
+                    return true;
+                }
+                const uint64_t cell = uint64_t(uint32_t(anchor.x / cellSize)) << 32 | uint32_t(anchor.y / cellSize);
+                return !occupied.insert(cell).second;
+            }), points.end());
+
+            if (points.empty()) {
+                continue;
+            }
+        }
 
-    const std::vector<SymbolFeature> features = processFeatures(layer, filter, glyphStore, sprite);
+        if (kept != i) {
+            features[kept] = std::move(feature);
+        }
+        kept++;
+    }
+    features.resize(kept);
+}
+
+bool SymbolBucket::prepareFeatures(const VectorTileLayer &layer, const FilterProgram &filter,
+                                   GlyphStore &glyphStore) {
+    {
+        const StageScope stage(profile, &Profile::features);
+        features = processFeatures(layer, filter);
+        thinFeatures();
+    }
+
+    // Determine and load the glyph ranges of the labels that are left.
+    std::set<GlyphRange> ranges;
+    for (const SymbolFeature &feature : features) {
+        for (char32_t chr : feature.label) {
+            ranges.insert(getGlyphRange(chr));
+        }
+    }
+    return glyphStore.requestGlyphRanges(properties.text.font, ranges);
+}
+
+void SymbolBucket::addFeatures(const Tile::ID &id, SpriteAtlas &spriteAtlas, Sprite &sprite,
+                               GlyphAtlas & glyphAtlas, GlyphStore &glyphStore) {
+    AllocationTracker::Scope allocations(AllocationTracker::Subsystem::SymbolBucket);
 
     float horizontalAlign = 0.5;
     float verticalAlign = 0.5;
@@ -165,17 +332,20 @@ void SymbolBucket::addFeatures(const VectorTileLayer &layer, const FilterExpress
     else if (properties.text.justify == TextJustifyType::Left) justify = 0;
 
     const FontStack &fontStack = glyphStore.getFontStack(properties.text.font);
+    const util::ptr<const Shaping> empty = std::make_shared<const Shaping>();
 
     for (const SymbolFeature &feature : features) {
         if (!feature.geometry.size()) continue;
 
-        Shaping shaping;
+        util::ptr<const Shaping> shaping = empty;
         Rect<uint16_t> image;
         GlyphPositions face;
+        StageScope shapingStage(profile, &Profile::shaping);
 
         // if feature has text, shape the text
         if (feature.label.length()) {
-            shaping = fontStack.getShaping(
+            shaping = glyphStore.getShaping(
+                /* font stack */ properties.text.font,
                 /* string */ feature.label,
                 /* maxWidth */ properties.text.max_width,
                 /* lineHeight */ properties.text.line_height,
@@ -186,7 +356,7 @@ void SymbolBucket::addFeatures(const VectorTileLayer &layer, const FilterExpress
                 /* translate */ properties.text.offset);
 
             // Add the glyphs we need for this label to the glyph atlas.
-            if (shaping.size()) {
+            if (shaping->size()) {
                 SymbolBucket::addGlyphsToAtlas(id.to_uint64(), properties.text.font, feature.label, fontStack,
                                                glyphAtlas, face);
             }
@@ -201,19 +371,22 @@ void SymbolBucket::addFeatures(const VectorTileLayer &layer, const FilterExpress
                 sdfIcons = true;
             }
         }
+        shapingStage.end();
 
         // if either shaping or icon position is present, add the feature
-        if (shaping.size() || image) {
+        if (shaping->size() || image) {
             for (const std::vector<Coordinate> &line : feature.geometry) {
                 if (line.size()) {
-                    addFeature(line, shaping, face, image);
+                    addFeature(line, *shaping, face, image);
                 }
             }
         }
     }
-}
 
-bool byScale(const Anchor &a, const Anchor &b) { return a.scale < b.scale; }
+    features.clear();
+
+    place(collision);
+}
 
 const PlacementRange fullRange{{2 * M_PI, 0}};
 
@@ -226,8 +399,6 @@ void SymbolBucket::addFeature(const std::vector<Coordinate> &line, const Shaping
 
     const bool horizontalText =
         properties.text.rotation_alignment == RotationAlignmentType::Viewport;
-    const bool horizontalIcon =
-        properties.icon.rotation_alignment == RotationAlignmentType::Viewport;
     const float fontScale = properties.text.max_size / glyphSize;
     const float textBoxScale = collision.tilePixelRatio * fontScale;
     const float iconBoxScale = collision.tilePixelRatio * properties.icon.max_size;
@@ -236,61 +407,112 @@ void SymbolBucket::addFeature(const std::vector<Coordinate> &line, const Shaping
     const bool avoidEdges = properties.avoid_edges && properties.placement != PlacementType::Line;
 
     Anchors anchors;
+    StageScope anchorStage(profile, &Profile::anchors);
 
     if (properties.placement == PlacementType::Line) {
-        // Line labels
+        // Line labels. The anchors come ordered by scale, so that placement starts with the
+        // anchors that can be shown at the lowest zoom levels.
         anchors = resample(line, properties.min_distance, minScale, collision.maxPlacementScale,
                            collision.tilePixelRatio);
 
-        // Sort anchors by segment so that we can start placement with the
-        // anchors that can be shown at the lowest zoom levels.
-        std::sort(anchors.begin(), anchors.end(), byScale);
-
     } else {
         // Point labels
         anchors = {Anchor{float(line[0].x), float(line[0].y), 0, minScale}};
     }
+    anchorStage.end();
 
     // TODO: figure out correct ascender height.
     const vec2<float> origin = {0, -17};
 
     for (Anchor &anchor : anchors) {
-
-        // Calculate the scales at which the text and icons can be first shown without overlap
-        Placement glyphPlacement;
-        Placement iconPlacement;
-        float glyphScale = 0;
-        float iconScale = 0;
         const bool inside = !(anchor.x < 0 || anchor.x > 4096 || anchor.y < 0 || anchor.y > 4096);
 
         if (avoidEdges && !inside) continue;
 
+        Label label(anchor);
+        label.iconWithoutText = iconWithoutText;
+        label.textWithoutIcon = textWithoutIcon;
+
+        // Only the quads of anchors inside of the tile are drawn; placement decides which of
+        // them are shown at which zoom levels.
         if (shaping.size()) {
-            glyphPlacement = Placement::getGlyphs(anchor, origin, shaping, face, textBoxScale,
-                                                  horizontalText, line, properties);
+            StageScope quadStage(profile, &Profile::quads);
+            Placement glyphPlacement = Placement::getGlyphs(anchor, origin, shaping, face, textBoxScale,
+                                                            horizontalText, line, properties);
+            quadStage.end();
+            label.hasText = true;
+            label.glyphMinScale = glyphPlacement.minScale;
+            label.glyphBoxes = std::move(glyphPlacement.boxes);
+            if (inside) {
+                const StageScope bufferStage(profile, &Profile::buffers);
+                label.glyphStart = addQuads(text, glyphPlacement.shapes);
+                label.glyphCount = uint32_t(glyphPlacement.shapes.size());
+            }
+        }
+
+        if (image) {
+            StageScope quadStage(profile, &Profile::quads);
+            Placement iconPlacement = Placement::getIcon(anchor, image, iconBoxScale, line, properties);
+            quadStage.end();
+            label.hasIcon = true;
+            label.iconMinScale = iconPlacement.minScale;
+            label.iconBoxes = std::move(iconPlacement.boxes);
+            if (inside) {
+                const StageScope bufferStage(profile, &Profile::buffers);
+                label.iconStart = addQuads(icon, iconPlacement.shapes);
+                label.iconCount = uint32_t(iconPlacement.shapes.size());
+            }
+        }
+
+        labels.push_back(std::move(label));
+    }
+}
+
+void SymbolBucket::place(Collision &target) {
+    AllocationTracker::Scope allocations(AllocationTracker::Subsystem::SymbolBucket);
+    const StageScope stage(profile, &Profile::placement);
+    const bool horizontalText =
+        properties.text.rotation_alignment == RotationAlignmentType::Viewport;
+    const bool horizontalIcon =
+        properties.icon.rotation_alignment == RotationAlignmentType::Viewport;
+    const bool avoidEdges = properties.avoid_edges && properties.placement != PlacementType::Line;
+
+    for (const Label &label : labels) {
+
+        // Calculate the scales at which the text and icons can be first shown without overlap
+        float glyphScale = 0;
+        float iconScale = 0;
+        bool placed = true;
+
+        if (label.hasText) {
             glyphScale =
                 properties.text.allow_overlap
-                    ? glyphPlacement.minScale
-                    : collision.getPlacementScale(glyphPlacement.boxes, glyphPlacement.minScale, avoidEdges);
-            if (!glyphScale && !iconWithoutText)
-                continue;
+                    ? label.glyphMinScale
+                    : target.getPlacementScale(label.glyphBoxes, label.glyphMinScale, avoidEdges);
+            if (!glyphScale && !label.iconWithoutText)
+                placed = false;
         }
 
-        if (image) {
-            iconPlacement = Placement::getIcon(anchor, image, iconBoxScale, line, properties);
+        if (placed && label.hasIcon) {
             iconScale =
                 properties.icon.allow_overlap
-                    ? iconPlacement.minScale
-                    : collision.getPlacementScale(iconPlacement.boxes, iconPlacement.minScale, avoidEdges);
-            if (!iconScale && !textWithoutIcon)
-                continue;
+                    ? label.iconMinScale
+                    : target.getPlacementScale(label.iconBoxes, label.iconMinScale, avoidEdges);
+            if (!iconScale && !label.textWithoutIcon)
+                placed = false;
         }
 
-        if (!iconWithoutText && !textWithoutIcon) {
+        if (!placed) {
+            placeQuads(text, label.glyphStart, label.glyphCount, target.zoom, 0, fullRange);
+            placeQuads(icon, label.iconStart, label.iconCount, target.zoom, 0, fullRange);
+            continue;
+        }
+
+        if (!label.iconWithoutText && !label.textWithoutIcon) {
             iconScale = glyphScale = util::max(iconScale, glyphScale);
-        } else if (!textWithoutIcon && glyphScale) {
+        } else if (!label.textWithoutIcon && glyphScale) {
             glyphScale = util::max(iconScale, glyphScale);
-        } else if (!iconWithoutText && iconScale) {
+        } else if (!label.iconWithoutText && iconScale) {
             iconScale = util::max(iconScale, glyphScale);
         }
 
@@ -298,48 +520,61 @@ void SymbolBucket::addFeature(const std::vector<Coordinate> &line, const Shaping
         PlacementRange glyphRange =
             (!glyphScale || properties.text.allow_overlap)
                 ? fullRange
-                : collision.getPlacementRange(glyphPlacement.boxes, glyphScale, horizontalText);
+                : target.getPlacementRange(label.glyphBoxes, glyphScale, horizontalText);
         PlacementRange iconRange =
             (!iconScale || properties.icon.allow_overlap)
                 ? fullRange
-                : collision.getPlacementRange(iconPlacement.boxes, iconScale, horizontalIcon);
+                : target.getPlacementRange(label.iconBoxes, iconScale, horizontalIcon);
 
         const PlacementRange maxRange = {{
             util::min(iconRange[0], glyphRange[0]), util::max(iconRange[1], glyphRange[1]),
         }};
 
-        if (!iconWithoutText && !textWithoutIcon) {
+        if (!label.iconWithoutText && !label.textWithoutIcon) {
             iconRange = glyphRange = maxRange;
-        } else if (!textWithoutIcon) {
+        } else if (!label.textWithoutIcon) {
             glyphRange = maxRange;
-        } else if (!iconWithoutText) {
+        } else if (!label.iconWithoutText) {
             iconRange = maxRange;
         }
 
-        // Insert final placement into collision tree and add glyphs/icons to buffers
+        // Insert final placement into collision tree and show the glyphs/icons
         if (glyphScale && std::isfinite(glyphScale)) {
             if (!properties.text.ignore_placement) {
-                collision.insert(glyphPlacement.boxes, anchor, glyphScale, glyphRange,
+                target.insert(label.glyphBoxes, label.anchor, glyphScale, glyphRange,
                                  horizontalText);
             }
-            if (inside) addSymbols(text, glyphPlacement.shapes, glyphScale, glyphRange);
+        } else {
+            glyphScale = 0;
         }
+        placeQuads(text, label.glyphStart, label.glyphCount, target.zoom, glyphScale, glyphRange);
 
         if (iconScale && std::isfinite(iconScale)) {
             if (!properties.icon.ignore_placement) {
-                collision.insert(iconPlacement.boxes, anchor, iconScale, iconRange, horizontalIcon);
+                target.insert(label.iconBoxes, label.anchor, iconScale, iconRange, horizontalIcon);
             }
-            if (inside) addSymbols(icon, iconPlacement.shapes, iconScale, iconRange);
+        } else {
+            iconScale = 0;
         }
+        placeQuads(icon, label.iconStart, label.iconCount, target.zoom, iconScale, iconRange);
     }
 }
 
 template <typename Buffer>
-void SymbolBucket::addSymbols(Buffer &buffer, const PlacedGlyphs &symbols, float scale,
-                              PlacementRange placementRange) {
+uint32_t SymbolBucket::addQuads(Buffer &buffer, const PlacedGlyphs &symbols) {
     const float zoom = collision.zoom;
+    const uint32_t first = uint32_t(buffer.scales.size());
 
-    const float placementZoom = std::log(scale) / std::log(2) + zoom;
+    // Every glyph is a quad of four vertices and two triangles, or a single instance.
+    buffer.scales.reserve(first + symbols.size());
+    if (instanced) {
+        buffer.instances.reserve(symbols.size());
+        buffer.placements.reserve(symbols.size());
+    } else {
+        buffer.vertices.reserve(symbols.size() * 4);
+        buffer.triangles.reserve(symbols.size() * 2);
+        buffer.placements.reserve(symbols.size() * 4);
+    }
 
     for (const PlacedGlyph &symbol : symbols) {
         const auto &tl = symbol.tl;
@@ -349,24 +584,33 @@ void SymbolBucket::addSymbols(Buffer &buffer, const PlacedGlyphs &symbols, float
         const auto &tex = symbol.tex;
         const auto &angle = symbol.angle;
 
-        float minZoom =
-            util::max(static_cast<float>(zoom + log(symbol.minScale) / log(2)), placementZoom);
-        float maxZoom = util::min(static_cast<float>(zoom + log(symbol.maxScale) / log(2)), 25.0f);
+        const float maxZoom = util::min(static_cast<float>(zoom + log(symbol.maxScale) / log(2)), 25.0f);
         const auto &glyphAnchor = symbol.anchor;
 
-        if (maxZoom <= minZoom)
-            continue;
+        buffer.scales.push_back({{ symbol.minScale, symbol.maxScale }});
 
-        // Lower min zoom so that while fading out the label
-        // it can be shown outside of collision-free zoom levels
-        if (minZoom == placementZoom) {
-            minZoom = 0;
+        // The quad is extruded from the anchor on screen, and it may be rotated.
+        ElementBounds bounds;
+        bounds.extend(std::floor(glyphAnchor.x), std::floor(glyphAnchor.y));
+        bounds.extend(std::ceil(glyphAnchor.x), std::ceil(glyphAnchor.y));
+        bounds.extent = std::sqrt(std::max(std::max(tl.x * tl.x + tl.y * tl.y, tr.x * tr.x + tr.y * tr.y),
+                                           std::max(bl.x * bl.x + bl.y * bl.y, br.x * br.x + br.y * br.y)));
+
+        if (instanced) {
+            if (buffer.groups.empty()) {
+                buffer.groups.emplace_back();
+            }
+            buffer.instances.add(glyphAnchor.x, glyphAnchor.y, tl, tr, bl, br, tex, angle, maxZoom);
+            buffer.placements.add(1);
+            buffer.groups.back().vertex_length++;
+            buffer.groups.back().bounds.extend(bounds);
+            continue;
         }
 
         const int glyph_vertex_length = 4;
 
         if (!buffer.groups.size() ||
-            (buffer.groups.back().vertex_length + glyph_vertex_length > 65535)) {
+            (buffer.groups.back().vertex_length + glyph_vertex_length > buffer.triangles.maxGroupVertices())) {
             // Move to a new group because the old one can't hold the geometry.
             buffer.groups.emplace_back();
         }
@@ -377,14 +621,14 @@ void SymbolBucket::addSymbols(Buffer &buffer, const PlacedGlyphs &symbols, float
         uint32_t triangleIndex = triangleGroup.vertex_length;
 
         // coordinates (2 triangles)
-        buffer.vertices.add(glyphAnchor.x, glyphAnchor.y, tl.x, tl.y, tex.x, tex.y, angle, minZoom,
-                            placementRange, maxZoom, placementZoom);
+        buffer.vertices.add(glyphAnchor.x, glyphAnchor.y, tl.x, tl.y, tex.x, tex.y, angle, maxZoom);
         buffer.vertices.add(glyphAnchor.x, glyphAnchor.y, tr.x, tr.y, tex.x + tex.w, tex.y, angle,
-                            minZoom, placementRange, maxZoom, placementZoom);
+                            maxZoom);
         buffer.vertices.add(glyphAnchor.x, glyphAnchor.y, bl.x, bl.y, tex.x, tex.y + tex.h, angle,
-                            minZoom, placementRange, maxZoom, placementZoom);
+                            maxZoom);
         buffer.vertices.add(glyphAnchor.x, glyphAnchor.y, br.x, br.y, tex.x + tex.w, tex.y + tex.h,
-                            angle, minZoom, placementRange, maxZoom, placementZoom);
+                            angle, maxZoom);
+        buffer.placements.add(glyph_vertex_length);
 
         // add the two triangles, referencing the four coordinates we just inserted.
         buffer.triangles.add(triangleIndex + 0, triangleIndex + 1, triangleIndex + 2);
@@ -392,39 +636,135 @@ void SymbolBucket::addSymbols(Buffer &buffer, const PlacedGlyphs &symbols, float
 
         triangleGroup.vertex_length += glyph_vertex_length;
         triangleGroup.elements_length += 2;
+        triangleGroup.bounds.extend(bounds);
     }
+
+    return first;
 }
 
-void SymbolBucket::drawGlyphs(SDFShader &shader) {
-    char *vertex_index = BUFFER_OFFSET(0);
-    char *elements_index = BUFFER_OFFSET(0);
+template <typename Buffer>
+void SymbolBucket::placeQuads(Buffer &buffer, uint32_t first, uint32_t count, float zoom,
+                              float scale, PlacementRange placementRange) {
+    const size_t entries = instanced ? 1 : 4;
+    if (!scale) {
+        buffer.placements.hide(buffer.placement_start + first * entries, count * entries);
+        return;
+    }
+
+    const float placementZoom = std::log(scale) / std::log(2) + zoom;
+
+    for (uint32_t i = first; i < first + count; i++) {
+        const size_t start = buffer.placement_start + i * entries;
+
+        float minZoom =
+            util::max(static_cast<float>(zoom + log(buffer.scales[i][0]) / log(2)), placementZoom);
+        float maxZoom = util::min(static_cast<float>(zoom + log(buffer.scales[i][1]) / log(2)), 25.0f);
+
+        if (maxZoom <= minZoom) {
+            buffer.placements.hide(start, entries);
+            continue;
+        }
+
+        // Lower min zoom so that while fading out the label
+        // it can be shown outside of collision-free zoom levels
+        if (minZoom == placementZoom) {
+            minZoom = 0;
+        }
+
+        buffer.placements.set(start, entries, minZoom, placementRange, placementZoom);
+    }
+}
+
+void SymbolBucket::drawGlyphs(SDFShader &shader, const ElementCuller &culler) {
+    // Placement may have changed after the upload.
+    if (!text.placements.isUploaded()) {
+        text.placements.bind();
+    }
+
+    if (instanced) {
+        drawInstances(shader, text.instances, text.instance_start, text.placements,
+                      text.placement_start, text.groups, 0, culler);
+        return;
+    }
+
+    char *vertex_index = BUFFER_OFFSET(text.vertex_start * text.vertices.itemSize);
+    char *placement_index = BUFFER_OFFSET(text.placement_start * text.placements.itemSize);
+    char *elements_index = BUFFER_OFFSET(text.triangle_elements_start * text.triangles.itemSize);
     for (TextElementGroup &group : text.groups) {
-        group.array[0].bind(shader, text.vertices, text.triangles, vertex_index);
-        MBGL_CHECK_ERROR(glDrawElements(GL_TRIANGLES, group.elements_length * 3, GL_UNSIGNED_SHORT, elements_index));
+        if (culler.isVisible(group.bounds)) {
+            group.array[0].bind(shader, text.vertices, text.placements, text.triangles, vertex_index, placement_index);
+            gl::State::Get().drawElements(GL_TRIANGLES, group.elements_length * 3, text.triangles.elementType, elements_index);
+        }
         vertex_index += group.vertex_length * text.vertices.itemSize;
+        placement_index += group.vertex_length * text.placements.itemSize;
         elements_index += group.elements_length * text.triangles.itemSize;
     }
 }
 
-void SymbolBucket::drawIcons(SDFShader &shader) {
-    char *vertex_index = BUFFER_OFFSET(0);
-    char *elements_index = BUFFER_OFFSET(0);
+void SymbolBucket::drawIcons(SDFShader &shader, const ElementCuller &culler) {
+    if (!icon.placements.isUploaded()) {
+        icon.placements.bind();
+    }
+
+    if (instanced) {
+        drawInstances(shader, icon.instances, icon.instance_start, icon.placements,
+                      icon.placement_start, icon.groups, 0, culler);
+        return;
+    }
+
+    char *vertex_index = BUFFER_OFFSET(icon.vertex_start * icon.vertices.itemSize);
+    char *placement_index = BUFFER_OFFSET(icon.placement_start * icon.placements.itemSize);
+    char *elements_index = BUFFER_OFFSET(icon.triangle_elements_start * icon.triangles.itemSize);
     for (IconElementGroup &group : icon.groups) {
-        group.array[0].bind(shader, icon.vertices, icon.triangles, vertex_index);
-        MBGL_CHECK_ERROR(glDrawElements(GL_TRIANGLES, group.elements_length * 3, GL_UNSIGNED_SHORT, elements_index));
+        if (culler.isVisible(group.bounds)) {
+            group.array[0].bind(shader, icon.vertices, icon.placements, icon.triangles, vertex_index, placement_index);
+            gl::State::Get().drawElements(GL_TRIANGLES, group.elements_length * 3, icon.triangles.elementType, elements_index);
+        }
         vertex_index += group.vertex_length * icon.vertices.itemSize;
+        placement_index += group.vertex_length * icon.placements.itemSize;
         elements_index += group.elements_length * icon.triangles.itemSize;
     }
 }
 
-void SymbolBucket::drawIcons(IconShader &shader) {
-    char *vertex_index = BUFFER_OFFSET(0);
-    char *elements_index = BUFFER_OFFSET(0);
+void SymbolBucket::drawIcons(IconShader &shader, const ElementCuller &culler) {
+    if (!icon.placements.isUploaded()) {
+        icon.placements.bind();
+    }
+
+    if (instanced) {
+        drawInstances(shader, icon.instances, icon.instance_start, icon.placements,
+                      icon.placement_start, icon.groups, 1, culler);
+        return;
+    }
+
+    char *vertex_index = BUFFER_OFFSET(icon.vertex_start * icon.vertices.itemSize);
+    char *placement_index = BUFFER_OFFSET(icon.placement_start * icon.placements.itemSize);
+    char *elements_index = BUFFER_OFFSET(icon.triangle_elements_start * icon.triangles.itemSize);
     for (IconElementGroup &group : icon.groups) {
-        group.array[1].bind(shader, icon.vertices, icon.triangles, vertex_index);
-        MBGL_CHECK_ERROR(glDrawElements(GL_TRIANGLES, group.elements_length * 3, GL_UNSIGNED_SHORT, elements_index));
+        if (culler.isVisible(group.bounds)) {
+            group.array[1].bind(shader, icon.vertices, icon.placements, icon.triangles, vertex_index, placement_index);
+            gl::State::Get().drawElements(GL_TRIANGLES, group.elements_length * 3, icon.triangles.elementType, elements_index);
+        }
         vertex_index += group.vertex_length * icon.vertices.itemSize;
+        placement_index += group.vertex_length * icon.placements.itemSize;
         elements_index += group.elements_length * icon.triangles.itemSize;
     }
 }
+
+template <typename Shader, typename Groups>
+void SymbolBucket::drawInstances(Shader &shader, SymbolInstanceBuffer &instances, size_t start,
+                                 SymbolPlacementBuffer &placements, size_t placement_start,
+                                 Groups &groups, size_t array, const ElementCuller &culler) {
+    char *instance_index = BUFFER_OFFSET(start * instances.itemSize);
+    char *placement_index = BUFFER_OFFSET(placement_start * placements.itemSize);
+    for (auto &group : groups) {
+        if (culler.isVisible(group.bounds)) {
+            group.array[array].bind(shader, instances, placements, instance_index, placement_index);
+            MBGL_CHECK_ERROR(gl::DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, group.vertex_length));
+        }
+        instance_index += group.vertex_length * instances.itemSize;
+        placement_index += group.vertex_length * placements.itemSize;
+    }
+}
+
 }
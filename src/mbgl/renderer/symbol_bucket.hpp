@@ -6,13 +6,19 @@
 #include <mbgl/geometry/elements_buffer.hpp>
 #include <mbgl/geometry/text_buffer.hpp>
 #include <mbgl/geometry/icon_buffer.hpp>
+#include <mbgl/geometry/symbol_instance_buffer.hpp>
+#include <mbgl/geometry/symbol_placement_buffer.hpp>
+#include <mbgl/geometry/anchor.hpp>
 #include <mbgl/map/vector_tile.hpp>
 #include <mbgl/text/types.hpp>
 #include <mbgl/text/glyph.hpp>
 #include <mbgl/style/style_bucket.hpp>
+#include <mbgl/util/token.hpp>
+#include <mbgl/util/time.hpp>
 
 #include <memory>
 #include <map>
+#include <set>
 #include <vector>
 
 namespace mbgl {
@@ -27,12 +33,15 @@ class Sprite;
 class GlyphAtlas;
 class GlyphStore;
 class FontStack;
+class TileBuffers;
 
 class SymbolFeature {
 public:
     std::vector<std::vector<Coordinate>> geometry;
     std::u32string label;
     std::string sprite;
+    // The value of the symbol-sort-key property; features without one are placed last.
+    double sortKey = 0;
 };
 
 
@@ -54,35 +63,92 @@ class SymbolBucket : public Bucket {
     typedef ElementGroup<2> IconElementGroup;
 
 public:
-    SymbolBucket(const StyleBucketSymbol &properties, Collision &collision);
+    SymbolBucket(const StyleBucketSymbol &properties, Collision &collision, TileBuffers &buffers);
 
-    virtual void render(Painter &painter, util::ptr<StyleLayer> layer_desc, const Tile::ID &id, const mat4 &matrix);
+    virtual void render(Painter &painter, const util::ptr<StyleLayer> &layer_desc, const Tile::ID &id, const mat4 &matrix);
     virtual bool hasData() const;
     virtual bool hasTextData() const;
     virtual bool hasIconData() const;
+    virtual MemoryUsage memoryUsage() const;
 
-    void addFeatures(const VectorTileLayer &layer, const FilterExpression &filter,
-                     const Tile::ID &id, SpriteAtlas &spriteAtlas, Sprite &sprite,
+    // Decodes the labels and icons of the layer and starts loading the glyphs they need. Returns
+    // whether all of those glyphs are available; addFeatures() must only be called once they are.
+    bool prepareFeatures(const VectorTileLayer &layer, const FilterProgram &filter,
+                         GlyphStore &glyphStore);
+
+    // Builds the quads of the prepared labels and icons, and places them.
+    void addFeatures(const Tile::ID &id, SpriteAtlas &spriteAtlas, Sprite &sprite,
                      GlyphAtlas &glyphAtlas, GlyphStore &glyphStore);
 
+    // Places the labels and icons against /target/, in the order of their features, and
+    // writes the results to the placement buffers. The quads stay as they are; placement buffers
+    // that were uploaded already transfer their changed part again before the next draw. Must not
+    // run while the bucket is drawn.
+    void place(Collision &target);
+
     void addGlyphs(const PlacedGlyphs &glyphs, float placementZoom, PlacementRange placementRange,
                    float zoom);
 
-    void drawGlyphs(SDFShader& shader);
-    void drawIcons(SDFShader& shader);
-    void drawIcons(IconShader& shader);
+    // Where building the bucket spends its time, stage by stage. Only buckets that were given a
+    // profile measure anything, since that takes a few clock readings per label. Allocations are
+    // only counted by builds that track them, see AllocationTracker.
+    struct Profile {
+        struct Stage {
+            timestamp time = 0;
+            AllocationUsage allocations;
+        };
+
+        // prepareFeatures(): decoding, filtering and thinning the features.
+        Stage features;
+        // Shaping the labels, adding their glyphs to the atlas and looking up the icons.
+        Stage shaping;
+        // Resampling the lines of line labels into anchors.
+        Stage anchors;
+        // Placement::getGlyphs() and getIcon(): the quads and collision boxes at every anchor.
+        Stage quads;
+        // Writing the quads to the vertex or instance buffers.
+        Stage buffers;
+        // place(): placing the labels against the collision boxes of the tile.
+        Stage placement;
+    };
+
+    // Adds the measurements of the following calls to /profile/, which must outlive the bucket.
+    inline void setProfile(Profile *profile_) { profile = profile_; }
+
+    // Groups that the culler rejects are skipped. The extent of the group bounds is in the units
+    // of the quad offsets.
+    void drawGlyphs(SDFShader& shader, const ElementCuller& culler);
+    void drawIcons(SDFShader& shader, const ElementCuller& culler);
+    void drawIcons(IconShader& shader, const ElementCuller& culler);
 
 private:
 
-    std::vector<SymbolFeature> processFeatures(const VectorTileLayer &layer, const FilterExpression &filter, GlyphStore &glyphStore, const Sprite &sprite);
+    std::vector<SymbolFeature> processFeatures(const VectorTileLayer &layer, const FilterProgram &filter);
+
+    // Drops the point labels that placement would reject anyway, before they are shaped: labels
+    // whose anchor is outside of the tile, and labels whose anchor is so close to the anchor of
+    // an earlier one that their boxes overlap even at the collision's maximum placement scale.
+    // Only applies where the text has to be placed for the symbol to be shown.
+    void thinFeatures();
 
 
     void addFeature(const std::vector<Coordinate> &line, const Shaping &shaping, const GlyphPositions &face, const Rect<uint16_t> &image);
 
 
-    // Adds placed items to the buffer.
+    // Adds the quads to the buffer, as four vertices or as one instance per quad, and returns the
+    // index of the first one. They are hidden until placement shows them.
+    template <typename Buffer>
+    uint32_t addQuads(Buffer &buffer, const PlacedGlyphs &symbols);
+
+    // Shows the quads from /first/ on at /scale/ and above, or hides them if the scale is 0.
     template <typename Buffer>
-    void addSymbols(Buffer &buffer, const PlacedGlyphs &symbols, float scale, PlacementRange placementRange);
+    void placeQuads(Buffer &buffer, uint32_t first, uint32_t count, float zoom, float scale,
+                    PlacementRange placementRange);
+
+    template <typename Shader, typename Groups>
+    void drawInstances(Shader &shader, SymbolInstanceBuffer &instances, size_t start,
+                       SymbolPlacementBuffer &placements, size_t placement_start, Groups &groups,
+                       size_t array, const ElementCuller &culler);
 
     // Adds glyphs to the glyph atlas so that they have a left/top/width/height coordinates associated to them that we can use for writing to a buffer.
     static void addGlyphsToAtlas(uint64_t tileid, const std::string stackname, const std::u32string &string,
@@ -92,19 +158,74 @@ public:
     const StyleBucketSymbol &properties;
     bool sdfIcons = false;
 
+    // The text field and icon image of the properties, split into their tokens.
+    const util::TokenTemplate textField;
+    const util::TokenTemplate iconImage;
+
+    // Whether the quads are drawn as instances; they need the instanced shaders.
+    const bool instanced;
+
 private:
     Collision &collision;
-
+    Profile *profile = nullptr;
+
+    // Decoded by prepareFeatures(), until addFeatures() places them.
+    std::vector<SymbolFeature> features;
+
+    // What placement needs to know about the text and icon at one anchor. Kept with the bucket
+    // so that placement can run again without shaping the labels and building their quads.
+    struct Label {
+        explicit Label(const Anchor &anchor_) : anchor(anchor_) {}
+
+        Anchor anchor;
+        GlyphBoxes glyphBoxes;
+        GlyphBoxes iconBoxes;
+        float glyphMinScale = 0;
+        float iconMinScale = 0;
+        bool hasText = false;
+        bool hasIcon = false;
+        bool iconWithoutText = false;
+        bool textWithoutIcon = false;
+
+        // The quads of the text and icon, counted from the first quad of the bucket. Anchors
+        // outside of the tile take part in placement, but don't have quads.
+        uint32_t glyphStart = 0;
+        uint32_t glyphCount = 0;
+        uint32_t iconStart = 0;
+        uint32_t iconCount = 0;
+    };
+
+    std::vector<Label> labels;
+
+    // Text and icons are added in turns, so they need separate element buffers to keep the
+    // elements of each group contiguous. The buffers are shared with the other buckets of the tile.
+    // Instanced buckets have a single group; its vertex_length counts instances. The placements
+    // run parallel to the vertices or instances.
     struct {
-        TextVertexBuffer vertices;
-        TriangleElementsBuffer triangles;
+        TextVertexBuffer &vertices;
+        TriangleElementsBuffer &triangles;
+        SymbolInstanceBuffer &instances;
+        SymbolPlacementBuffer &placements;
+        const size_t vertex_start;
+        const size_t triangle_elements_start;
+        const size_t instance_start;
+        const size_t placement_start;
         std::vector<TextElementGroup> groups;
+        // The minimum and maximum scale of every quad.
+        std::vector<std::array<float, 2>> scales;
     } text;
 
     struct {
-        IconVertexBuffer vertices;
-        TriangleElementsBuffer triangles;
+        IconVertexBuffer &vertices;
+        TriangleElementsBuffer &triangles;
+        SymbolInstanceBuffer &instances;
+        SymbolPlacementBuffer &placements;
+        const size_t vertex_start;
+        const size_t triangle_elements_start;
+        const size_t instance_start;
+        const size_t placement_start;
         std::vector<IconElementGroup> groups;
+        std::vector<std::array<float, 2>> scales;
     } icon;
 
 };
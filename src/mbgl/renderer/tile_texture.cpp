@@ -0,0 +1,58 @@
+#include <mbgl/renderer/tile_texture.hpp>
+#include <mbgl/platform/gl_state.hpp>
+#include <mbgl/platform/log.hpp>
+
+using namespace mbgl;
+
+TileTexture::TileTexture(uint16_t size_) : size(size_) {}
+
+TileTexture::~TileTexture() {
+    if (fbo) {
+        MBGL_CHECK_ERROR(glDeleteFramebuffers(1, &fbo));
+    }
+    if (texture) {
+        gl::State::Get().deleteTextures(1, &texture);
+    }
+}
+
+bool TileTexture::bindFramebuffer() {
+    MBGL_CHECK_ERROR(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo));
+
+    if (!texture) {
+        MBGL_CHECK_ERROR(glGenTextures(1, &texture));
+        gl::State::Get().bindTexture(texture);
+        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+        MBGL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+    }
+
+    if (!fbo) {
+        MBGL_CHECK_ERROR(glGenFramebuffers(1, &fbo));
+        MBGL_CHECK_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, fbo));
+        MBGL_CHECK_ERROR(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0));
+
+        const GLenum status = MBGL_CHECK_ERROR(glCheckFramebufferStatus(GL_FRAMEBUFFER));
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            Log::Warning(Event::OpenGL, "Tile texture framebuffer is incomplete: 0x%x", status);
+            unbindFramebuffer();
+            return false;
+        }
+    } else {
+        MBGL_CHECK_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, fbo));
+    }
+
+    MBGL_CHECK_ERROR(glViewport(0, 0, size, size));
+    gl::State::Get().clearColor(0, 0, 0, 0);
+    MBGL_CHECK_ERROR(glClear(GL_COLOR_BUFFER_BIT));
+    return true;
+}
+
+void TileTexture::unbindFramebuffer() {
+    MBGL_CHECK_ERROR(glBindFramebuffer(GL_FRAMEBUFFER, previousFbo));
+}
+
+void TileTexture::bind() {
+    gl::State::Get().bindTexture(texture);
+}
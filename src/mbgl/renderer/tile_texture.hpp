@@ -0,0 +1,48 @@
+#ifndef MBGL_RENDERER_TILE_TEXTURE
+#define MBGL_RENDERER_TILE_TEXTURE
+
+#include <mbgl/platform/gl.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstdint>
+
+namespace mbgl {
+
+class TileData;
+
+// A square color texture that the bottom layers of a tile are drawn into once, so that later
+// frames only have to composite it. Must be used on the thread with the GL context.
+class TileTexture : private util::noncopyable {
+public:
+    explicit TileTexture(uint16_t size);
+    ~TileTexture();
+
+    // Makes the texture the draw target, covering the whole viewport, and clears it to
+    // transparent. Returns false if the driver can't draw into it.
+    bool bindFramebuffer();
+
+    // Returns to the framebuffer that was bound before bindFramebuffer().
+    void unbindFramebuffer();
+
+    // Binds the texture to the active texture unit.
+    void bind();
+
+public:
+    const uint16_t size;
+
+    // The tile data and generation of its buckets that the texture was drawn from.
+    const TileData *data = nullptr;
+    uint64_t generation = 0;
+
+    // Whether the texture shows the tile in the current frame.
+    bool current = false;
+
+private:
+    GLuint texture = 0;
+    GLuint fbo = 0;
+    GLint previousFbo = 0;
+};
+
+}
+
+#endif
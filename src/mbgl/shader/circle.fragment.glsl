@@ -0,0 +1,10 @@
+uniform vec4 u_color;
+uniform float u_blur;
+
+varying vec2 v_extrude;
+
+void main() {
+    // v_extrude is 1 at the radius of the circle.
+    float t = smoothstep(1.0 - u_blur, 1.0, length(v_extrude));
+    gl_FragColor = u_color * (1.0 - t);
+}
@@ -0,0 +1,15 @@
+// Every point is a quad of four vertices with the same position. The position is stored times
+// two, with the corner of the quad in the lowest bit of each coordinate.
+attribute vec2 a_pos;
+
+// matrix is for the vertex position, exmatrix is for projecting the extrusion vector.
+uniform mat4 u_matrix;
+uniform mat4 u_exmatrix;
+uniform float u_size;
+
+varying vec2 v_extrude;
+
+void main(void) {
+    v_extrude = mod(a_pos, 2.0) * 2.0 - 1.0;
+    gl_Position = u_matrix * vec4(floor(a_pos * 0.5), 0, 1) + u_exmatrix * vec4(v_extrude * u_size, 0, 0);
+}
@@ -0,0 +1,54 @@
+#include <mbgl/shader/circle_shader.hpp>
+#include <mbgl/shader/shaders.hpp>
+#include <mbgl/platform/gl.hpp>
+
+#include <cstdio>
+
+using namespace mbgl;
+
+CircleShader::CircleShader()
+    : CircleShader(
+         "circle",
+         shaders[CIRCLE_SHADER].vertex,
+         shaders[CIRCLE_SHADER].fragment
+         ) {
+}
+
+CircleShader::CircleShader(const char *name_, const char *vertex, const char *fragment)
+    : Shader(name_, vertex, fragment) {
+    if (!valid) {
+        fprintf(stderr, "invalid %s shader\n", name);
+        return;
+    }
+
+    a_pos = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_pos"));
+}
+
+void CircleShader::bind(char *offset) {
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_pos));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_pos, 2, GL_SHORT, false, 4, offset));
+}
+
+CircleInstancedShader::CircleInstancedShader()
+    : CircleShader(
+         "circleinst",
+         shaders[CIRCLEINST_SHADER].vertex,
+         shaders[CIRCLEINST_SHADER].fragment
+         ) {
+    if (!valid) {
+        return;
+    }
+
+    a_corner = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_corner"));
+}
+
+void CircleInstancedShader::bind(char *offset) {
+    // Called with the instance buffer bound.
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_pos));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_pos, 2, GL_SHORT, false, 4, offset));
+    MBGL_CHECK_ERROR(gl::VertexAttribDivisor(a_pos, 1));
+
+    quad.bind();
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_corner));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_corner, 2, GL_SHORT, false, 0, nullptr));
+}
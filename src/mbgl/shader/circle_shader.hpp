@@ -0,0 +1,43 @@
+#ifndef MBGL_SHADER_SHADER_CIRCLE
+#define MBGL_SHADER_SHADER_CIRCLE
+
+#include <mbgl/shader/shader.hpp>
+#include <mbgl/shader/uniform.hpp>
+#include <mbgl/geometry/static_vertex_buffer.hpp>
+
+namespace mbgl {
+
+class CircleShader : public Shader {
+public:
+    CircleShader();
+
+    virtual void bind(char *offset);
+
+    UniformMatrix<4>              u_matrix   = {"u_matrix",   *this};
+    UniformMatrix<4>              u_exmatrix = {"u_exmatrix", *this};
+    Uniform<std::array<float, 4>> u_color    = {"u_color",    *this};
+    Uniform<float>                u_size     = {"u_size",     *this};
+    Uniform<float>                u_blur     = {"u_blur",     *this};
+
+protected:
+    CircleShader(const char *name, const char *vertex, const char *fragment);
+
+    int32_t a_pos = -1;
+};
+
+// Draws the points of a CircleVertexBuffer as instances of a unit quad.
+class CircleInstancedShader : public CircleShader {
+public:
+    CircleInstancedShader();
+
+    void bind(char *offset);
+
+private:
+    StaticVertexBuffer quad = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+
+    int32_t a_corner = -1;
+};
+
+}
+
+#endif
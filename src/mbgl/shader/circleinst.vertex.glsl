@@ -0,0 +1,15 @@
+// a_corner selects the corner of the unit quad, a_pos is the point of the instance.
+attribute vec2 a_corner;
+attribute vec2 a_pos;
+
+// matrix is for the vertex position, exmatrix is for projecting the extrusion vector.
+uniform mat4 u_matrix;
+uniform mat4 u_exmatrix;
+uniform float u_size;
+
+varying vec2 v_extrude;
+
+void main(void) {
+    v_extrude = a_corner * 2.0 - 1.0;
+    gl_Position = u_matrix * vec4(a_pos, 0, 1) + u_exmatrix * vec4(v_extrude * u_size, 0, 0);
+}
@@ -3,6 +3,7 @@
 
 #include <mbgl/shader/shader.hpp>
 #include <mbgl/shader/uniform.hpp>
+#include <mbgl/geometry/static_vertex_buffer.hpp>
 
 namespace mbgl {
 
@@ -10,7 +11,8 @@ class IconShader : public Shader {
 public:
     IconShader();
 
-    void bind(char *offset);
+    virtual void bind(char *offset);
+    virtual void bindAttributes(char *offset);
 
     UniformMatrix<4>              u_matrix      = {"u_matrix",      *this};
     UniformMatrix<4>              u_exmatrix    = {"u_exmatrix",    *this};
@@ -24,13 +26,32 @@ public:
     Uniform<float>                u_opacity     = {"u_opacity",     *this};
     Uniform<std::array<float, 2>> u_texsize     = {"u_texsize",     *this};
 
-private:
+protected:
+    IconShader(const char *name, const char *vertex, const char *fragment);
+
     int32_t a_pos = -1;
     int32_t a_offset = -1;
     int32_t a_data1 = -1;
     int32_t a_data2 = -1;
 };
 
+// Draws the quads of a SymbolInstanceBuffer as instances of a unit quad.
+class IconInstancedShader : public IconShader {
+public:
+    IconInstancedShader();
+
+    void bind(char *offset);
+    void bindAttributes(char *offset);
+
+private:
+    StaticVertexBuffer quad = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+
+    int32_t a_corner = -1;
+    int32_t a_offset1 = -1;
+    int32_t a_offset2 = -1;
+    int32_t a_data3 = -1;
+};
+
 }
 
 #endif
@@ -0,0 +1,70 @@
+#ifndef MBGL_SHADER_LAZY_SHADER
+#define MBGL_SHADER_LAZY_SHADER
+
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <array>
+#include <cassert>
+#include <memory>
+
+namespace mbgl {
+
+// Holds a shader that is only compiled when it is first used, so that programs a style never
+// draws with don't cost anything. It must only be dereferenced on the thread that has the GL
+// context current.
+template <typename T>
+class LazyShader : private util::noncopyable {
+public:
+    T &operator*() {
+        if (!shader) {
+            shader = util::make_unique<T>();
+        }
+        return *shader;
+    }
+
+    T *operator->() {
+        return &**this;
+    }
+
+    // Whether the shader was compiled.
+    explicit operator bool() const {
+        return bool(shader);
+    }
+
+    // Deletes the program; the next use compiles it again.
+    void reset() {
+        shader.reset();
+    }
+
+private:
+    std::unique_ptr<T> shader;
+};
+
+// Like LazyShader, for a shader that is compiled into a separate program for each combination of
+// the Shader::Variant flags below /Count/. Only the variants that are used are compiled.
+template <typename T, uint32_t Count>
+class LazyShaderVariants : private util::noncopyable {
+public:
+    T &operator[](uint32_t variant) {
+        assert(variant < Count);
+        if (!shaders[variant]) {
+            shaders[variant] = util::make_unique<T>(variant);
+        }
+        return *shaders[variant];
+    }
+
+    // Deletes all programs; the next use compiles them again.
+    void reset() {
+        for (std::unique_ptr<T> &shader : shaders) {
+            shader.reset();
+        }
+    }
+
+private:
+    std::array<std::unique_ptr<T>, Count> shaders;
+};
+
+}
+
+#endif
@@ -6,11 +6,12 @@
 
 using namespace mbgl;
 
-LinepatternShader::LinepatternShader()
+LinepatternShader::LinepatternShader(uint32_t variant_)
     : Shader(
         "linepattern",
          shaders[LINEPATTERN_SHADER].vertex,
-         shaders[LINEPATTERN_SHADER].fragment
+         shaders[LINEPATTERN_SHADER].fragment,
+         variant_
     ) {
     if (!valid) {
         fprintf(stderr, "invalid line pattern shader\n");
@@ -8,7 +8,7 @@ namespace mbgl {
 
 class LinepatternShader : public Shader {
 public:
-    LinepatternShader();
+    explicit LinepatternShader(uint32_t variant = 0);
 
     void bind(char *offset);
 
@@ -19,7 +19,6 @@ public:
     Uniform<std::array<float, 2>> u_pattern_tl   = {"u_pattern_tl",   *this};
     Uniform<std::array<float, 2>> u_pattern_br   = {"u_pattern_br",   *this};
     Uniform<float>                u_ratio        = {"u_ratio",        *this};
-    Uniform<float>                u_point        = {"u_point",        *this};
     Uniform<float>                u_blur         = {"u_blur",         *this};
     Uniform<float>                u_fade         = {"u_fade",         *this};
     Uniform<float>                u_opacity      = {"u_opacity",      *this};
@@ -3,11 +3,15 @@ uniform vec4 u_color;
 uniform float u_blur;
 uniform sampler2D u_image;
 uniform float u_sdfgamma;
+#ifdef CROSSFADE
 uniform float u_mix;
+#endif
 
 varying vec2 v_normal;
 varying vec2 v_tex_a;
+#ifdef CROSSFADE
 varying vec2 v_tex_b;
+#endif
 
 void main() {
     // Calculate the distance of the pixel from the line in pixels.
@@ -18,9 +22,10 @@ void main() {
     // (v_linewidth.s)
     float alpha = clamp(min(dist - (u_linewidth.t - u_blur), u_linewidth.s - dist) / u_blur, 0.0, 1.0);
 
-    float sdfdist_a = texture2D(u_image, v_tex_a).a;
-    float sdfdist_b = texture2D(u_image, v_tex_b).a;
-    float sdfdist = mix(sdfdist_a, sdfdist_b, u_mix);
+    float sdfdist = texture2D(u_image, v_tex_a).a;
+#ifdef CROSSFADE
+    sdfdist = mix(sdfdist, texture2D(u_image, v_tex_b).a, u_mix);
+#endif
     alpha *= smoothstep(0.5 - u_sdfgamma, 0.5 + u_sdfgamma, sdfdist);
 
     gl_FragColor = u_color * alpha;
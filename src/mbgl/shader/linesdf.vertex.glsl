@@ -19,12 +19,16 @@ uniform float u_ratio;
 uniform vec2 u_linewidth;
 uniform vec2 u_patternscale_a;
 uniform float u_tex_y_a;
+#ifdef CROSSFADE
 uniform vec2 u_patternscale_b;
 uniform float u_tex_y_b;
+#endif
 
 varying vec2 v_normal;
 varying vec2 v_tex_a;
+#ifdef CROSSFADE
 varying vec2 v_tex_b;
+#endif
 
 void main() {
     vec2 a_extrude = a_data.xy;
@@ -49,5 +53,7 @@ void main() {
     gl_Position = u_matrix * vec4(floor(a_pos * 0.5), 0.0, 1.0) + u_exmatrix * dist;
 
     v_tex_a = vec2(a_linesofar * u_patternscale_a.x, normal.y * u_patternscale_a.y + u_tex_y_a);
+#ifdef CROSSFADE
     v_tex_b = vec2(a_linesofar * u_patternscale_b.x, normal.y * u_patternscale_b.y + u_tex_y_b);
+#endif
 }
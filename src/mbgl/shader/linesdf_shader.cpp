@@ -6,14 +6,15 @@
 
 using namespace mbgl;
 
-LineSDFShader::LineSDFShader()
+LineSDFShader::LineSDFShader(uint32_t variant_)
     : Shader(
-        "line",
+        "linesdf",
         shaders[LINESDF_SHADER].vertex,
-        shaders[LINESDF_SHADER].fragment
+        shaders[LINESDF_SHADER].fragment,
+        variant_
     ) {
     if (!valid) {
-        fprintf(stderr, "invalid line shader\n");
+        fprintf(stderr, "invalid line sdf shader\n");
         return;
     }
 
@@ -8,7 +8,7 @@ namespace mbgl {
 
 class LineSDFShader : public Shader {
 public:
-    LineSDFShader();
+    explicit LineSDFShader(uint32_t variant = 0);
 
     void bind(char *offset);
 
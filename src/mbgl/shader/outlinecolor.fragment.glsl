@@ -0,0 +1,8 @@
+varying vec2 v_pos;
+varying vec4 v_color;
+
+void main() {
+    float dist = length(v_pos - gl_FragCoord.xy);
+    float alpha = smoothstep(1.0, 0.0, dist);
+    gl_FragColor = v_color * alpha;
+}
@@ -0,0 +1,32 @@
+#include <mbgl/shader/outlinecolor_shader.hpp>
+#include <mbgl/shader/shaders.hpp>
+#include <mbgl/platform/gl.hpp>
+
+#include <cstdio>
+
+using namespace mbgl;
+
+OutlineColorShader::OutlineColorShader()
+    : Shader(
+        "outlinecolor",
+        shaders[OUTLINECOLOR_SHADER].vertex,
+        shaders[OUTLINECOLOR_SHADER].fragment
+    ) {
+    if (!valid) {
+        fprintf(stderr, "invalid outline color shader\n");
+        return;
+    }
+
+    a_pos = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_pos"));
+    a_color = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_color"));
+}
+
+void OutlineColorShader::bind(char *offset) {
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_pos));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_pos, 2, GL_SHORT, false, 0, offset));
+}
+
+void OutlineColorShader::bindAttributes(char *offset) {
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_color));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_color, 4, GL_UNSIGNED_BYTE, true, 0, offset));
+}
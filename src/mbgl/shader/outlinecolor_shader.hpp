@@ -0,0 +1,28 @@
+#ifndef MBGL_SHADER_SHADER_OUTLINECOLOR
+#define MBGL_SHADER_SHADER_OUTLINECOLOR
+
+#include <mbgl/shader/shader.hpp>
+#include <mbgl/shader/uniform.hpp>
+
+namespace mbgl {
+
+// Draws antialiased outlines with a color per vertex.
+class OutlineColorShader : public Shader {
+public:
+    OutlineColorShader();
+
+    void bind(char *offset);
+    void bindAttributes(char *offset);
+
+    UniformMatrix<4>              u_matrix  = {"u_matrix",  *this};
+    Uniform<std::array<float, 2>> u_world   = {"u_world",   *this};
+    Uniform<float>                u_opacity = {"u_opacity", *this};
+
+private:
+    int32_t a_pos = -1;
+    int32_t a_color = -1;
+};
+
+}
+
+#endif
@@ -1,7 +1,9 @@
 uniform float u_opacity;
 uniform vec2 u_pattern_tl;
 uniform vec2 u_pattern_br;
+#ifdef CROSSFADE
 uniform float u_mix;
+#endif
 
 uniform sampler2D u_image;
 
@@ -11,11 +13,13 @@ void main() {
 
     vec2 imagecoord = mod(v_pos, 1.0);
     vec2 pos = mix(u_pattern_tl, u_pattern_br, imagecoord);
-    vec4 color1 = texture2D(u_image, pos);
+    vec4 color = texture2D(u_image, pos);
 
+#ifdef CROSSFADE
     vec2 imagecoord2 = mod(imagecoord * 2.0, 1.0);
     vec2 pos2 = mix(u_pattern_tl, u_pattern_br, imagecoord2);
-    vec4 color2 = texture2D(u_image, pos2);
+    color = mix(color, texture2D(u_image, pos2), u_mix);
+#endif
 
-    gl_FragColor = mix(color1, color2, u_mix) * u_opacity;
+    gl_FragColor = color * u_opacity;
 }
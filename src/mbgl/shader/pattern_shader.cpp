@@ -6,11 +6,12 @@
 
 using namespace mbgl;
 
-PatternShader::PatternShader()
+PatternShader::PatternShader(uint32_t variant_)
     : Shader(
         "pattern",
         shaders[PATTERN_SHADER].vertex,
-        shaders[PATTERN_SHADER].fragment
+        shaders[PATTERN_SHADER].fragment,
+        variant_
     ) {
     if (!valid) {
         fprintf(stderr, "invalid pattern shader\n");
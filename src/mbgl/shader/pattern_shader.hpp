@@ -8,7 +8,7 @@ namespace mbgl {
 
 class PatternShader : public Shader {
 public:
-    PatternShader();
+    explicit PatternShader(uint32_t variant = 0);
 
     void bind(char *offset);
 
@@ -0,0 +1,27 @@
+#ifndef MBGL_SHADER_SHADER_PLAINCOLOR
+#define MBGL_SHADER_SHADER_PLAINCOLOR
+
+#include <mbgl/shader/shader.hpp>
+#include <mbgl/shader/uniform.hpp>
+
+namespace mbgl {
+
+// Fills with a color per vertex.
+class PlainColorShader : public Shader {
+public:
+    PlainColorShader();
+
+    void bind(char *offset);
+    void bindAttributes(char *offset);
+
+    UniformMatrix<4> u_matrix  = {"u_matrix",  *this};
+    Uniform<float>   u_opacity = {"u_opacity", *this};
+
+private:
+    int32_t a_pos = -1;
+    int32_t a_color = -1;
+};
+
+}
+
+#endif
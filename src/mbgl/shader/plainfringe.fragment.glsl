@@ -0,0 +1,7 @@
+uniform vec4 u_color;
+
+varying float v_alpha;
+
+void main() {
+    gl_FragColor = u_color * v_alpha;
+}
@@ -0,0 +1,22 @@
+// floor(127 / 2) == 63.0
+// #define scale 63.0
+#define scale 0.015873016
+
+attribute vec2 a_pos;
+attribute vec2 a_extrude;
+
+// matrix is for the vertex position, exmatrix is for rotating and projecting
+// the extrusion vector.
+uniform mat4 u_matrix;
+uniform mat4 u_exmatrix;
+uniform float u_fringe;
+
+varying float v_alpha;
+
+void main() {
+    // Only the outer vertices of the fringe are extruded. They are pushed out by
+    // the width of the fringe in pixel space, and fade out the fill towards them.
+    vec4 dist = vec4(u_fringe * a_extrude * scale, 0.0, 0.0);
+    gl_Position = u_matrix * vec4(a_pos, 0, 1) + u_exmatrix * dist;
+    v_alpha = 1.0 - step(0.5, length(a_extrude));
+}
@@ -0,0 +1,32 @@
+#include <mbgl/shader/plainfringe_shader.hpp>
+#include <mbgl/shader/shaders.hpp>
+#include <mbgl/platform/gl.hpp>
+
+#include <cstdio>
+
+using namespace mbgl;
+
+PlainFringeShader::PlainFringeShader()
+    : Shader(
+        "plainfringe",
+        shaders[PLAINFRINGE_SHADER].vertex,
+        shaders[PLAINFRINGE_SHADER].fragment
+    ) {
+    if (!valid) {
+        fprintf(stderr, "invalid plain fringe shader\n");
+        return;
+    }
+
+    a_pos = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_pos"));
+    a_extrude = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_extrude"));
+}
+
+void PlainFringeShader::bind(char *offset) {
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_pos));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_pos, 2, GL_SHORT, false, 0, offset));
+}
+
+void PlainFringeShader::bindAttributes(char *offset) {
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_extrude));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_extrude, 2, GL_BYTE, false, 4, offset));
+}
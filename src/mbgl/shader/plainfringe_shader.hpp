@@ -0,0 +1,29 @@
+#ifndef MBGL_SHADER_SHADER_PLAINFRINGE
+#define MBGL_SHADER_SHADER_PLAINFRINGE
+
+#include <mbgl/shader/shader.hpp>
+#include <mbgl/shader/uniform.hpp>
+
+namespace mbgl {
+
+// Fills with a color, and extrudes the antialiasing fringe of the fill buckets that have one.
+class PlainFringeShader : public Shader {
+public:
+    PlainFringeShader();
+
+    void bind(char *offset);
+    void bindAttributes(char *offset);
+
+    UniformMatrix<4>              u_matrix   = {"u_matrix",   *this};
+    UniformMatrix<4>              u_exmatrix = {"u_exmatrix", *this};
+    Uniform<std::array<float, 4>> u_color    = {"u_color",    *this};
+    Uniform<float>                u_fringe   = {"u_fringe",   *this};
+
+private:
+    int32_t a_pos = -1;
+    int32_t a_extrude = -1;
+};
+
+}
+
+#endif
@@ -23,14 +23,13 @@ varying float v_alpha;
 
 void main() {
     vec2 a_tex = a_data1.xy;
-    float a_labelminzoom = a_data1[2];
-    float a_angle = a_data1[3];
-    vec2 a_zoom = a_data2.st;
-    float a_minzoom = a_zoom[0];
-    float a_maxzoom = a_zoom[1];
-    vec2 a_range = a_data2.pq;
-    float a_rangeend = a_range[0];
-    float a_rangestart = a_range[1];
+    float a_angle = a_data1[2];
+    float a_maxzoom = a_data1[3];
+    // The placement comes from a buffer of its own.
+    float a_labelminzoom = a_data2[0];
+    float a_minzoom = a_data2[1];
+    float a_rangeend = a_data2[2];
+    float a_rangestart = a_data2[3];
 
     float rev = 0.0;
 
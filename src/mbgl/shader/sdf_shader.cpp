@@ -7,13 +7,17 @@
 using namespace mbgl;
 
 SDFShader::SDFShader()
-    : Shader(
+    : SDFShader(
         "sdf",
         shaders[SDF_SHADER].vertex,
         shaders[SDF_SHADER].fragment
     ) {
+}
+
+SDFShader::SDFShader(const char *name_, const char *vertex, const char *fragment)
+    : Shader(name_, vertex, fragment) {
     if (!valid) {
-        fprintf(stderr, "invalid sdf shader\n");
+        fprintf(stderr, "invalid %s shader\n", name);
         return;
     }
 
@@ -24,7 +28,7 @@ SDFShader::SDFShader()
 }
 
 void SDFGlyphShader::bind(char *offset) {
-    const int stride = 16;
+    const int stride = 12;
 
     MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_pos));
     MBGL_CHECK_ERROR(glVertexAttribPointer(a_pos, 2, GL_SHORT, false, stride, offset + 0));
@@ -34,13 +38,10 @@ void SDFGlyphShader::bind(char *offset) {
 
     MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_data1));
     MBGL_CHECK_ERROR(glVertexAttribPointer(a_data1, 4, GL_UNSIGNED_BYTE, false, stride, offset + 8));
-
-    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_data2));
-    MBGL_CHECK_ERROR(glVertexAttribPointer(a_data2, 4, GL_UNSIGNED_BYTE, false, stride, offset + 12));
 }
 
 void SDFIconShader::bind(char *offset) {
-    const int stride = 16;
+    const int stride = 12;
 
     MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_pos));
     MBGL_CHECK_ERROR(glVertexAttribPointer(a_pos, 2, GL_SHORT, false, stride, offset + 0));
@@ -50,7 +51,61 @@ void SDFIconShader::bind(char *offset) {
 
     MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_data1));
     MBGL_CHECK_ERROR(glVertexAttribPointer(a_data1, 4, GL_UNSIGNED_BYTE, false, stride, offset + 8));
+}
+
+// The placement of the vertices, from a SymbolPlacementBuffer.
+void SDFShader::bindAttributes(char *offset) {
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_data2));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_data2, 4, GL_UNSIGNED_BYTE, false, 0, offset));
+}
+
+SDFInstancedShader::SDFInstancedShader()
+    : SDFShader(
+        "sdfinst",
+        shaders[SDFINST_SHADER].vertex,
+        shaders[SDFINST_SHADER].fragment
+    ) {
+    if (!valid) {
+        return;
+    }
+
+    a_corner = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_corner"));
+    a_offset1 = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_offset1"));
+    a_offset2 = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_offset2"));
+    a_data3 = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_data3"));
+}
+
+void SDFInstancedShader::bind(char *offset) {
+    // Called with the instance buffer bound.
+    const int stride = 28;
+
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_pos));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_pos, 2, GL_SHORT, false, stride, offset + 0));
+    MBGL_CHECK_ERROR(gl::VertexAttribDivisor(a_pos, 1));
+
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_offset1));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_offset1, 4, GL_SHORT, false, stride, offset + 4));
+    MBGL_CHECK_ERROR(gl::VertexAttribDivisor(a_offset1, 1));
+
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_offset2));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_offset2, 4, GL_SHORT, false, stride, offset + 12));
+    MBGL_CHECK_ERROR(gl::VertexAttribDivisor(a_offset2, 1));
+
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_data1));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_data1, 4, GL_UNSIGNED_BYTE, false, stride, offset + 20));
+    MBGL_CHECK_ERROR(gl::VertexAttribDivisor(a_data1, 1));
 
     MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_data2));
-    MBGL_CHECK_ERROR(glVertexAttribPointer(a_data2, 4, GL_UNSIGNED_BYTE, false, stride, offset + 12));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_data2, 2, GL_UNSIGNED_BYTE, false, stride, offset + 24));
+    MBGL_CHECK_ERROR(gl::VertexAttribDivisor(a_data2, 1));
+
+    quad.bind();
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_corner));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_corner, 2, GL_SHORT, false, 0, nullptr));
+}
+
+void SDFInstancedShader::bindAttributes(char *offset) {
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_data3));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_data3, 4, GL_UNSIGNED_BYTE, false, 0, offset));
+    MBGL_CHECK_ERROR(gl::VertexAttribDivisor(a_data3, 1));
 }
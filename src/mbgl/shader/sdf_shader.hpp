@@ -3,6 +3,7 @@
 
 #include <mbgl/shader/shader.hpp>
 #include <mbgl/shader/uniform.hpp>
+#include <mbgl/geometry/static_vertex_buffer.hpp>
 
 namespace mbgl {
 
@@ -11,6 +12,7 @@ public:
     SDFShader();
 
     virtual void bind(char *offset) = 0;
+    virtual void bindAttributes(char *offset);
 
     UniformMatrix<4>              u_matrix      = {"u_matrix",      *this};
     UniformMatrix<4>              u_exmatrix    = {"u_exmatrix",    *this};
@@ -27,6 +29,8 @@ public:
     Uniform<float>                u_fadezoom    = {"u_fadezoom",    *this};
 
 protected:
+    SDFShader(const char *name, const char *vertex, const char *fragment);
+
     int32_t a_pos = -1;
     int32_t a_offset = -1;
     int32_t a_data1 = -1;
@@ -43,6 +47,23 @@ public:
     void bind(char *offset);
 };
 
+// Draws the glyph and icon quads of a SymbolInstanceBuffer as instances of a unit quad.
+class SDFInstancedShader : public SDFShader {
+public:
+    SDFInstancedShader();
+
+    void bind(char *offset);
+    void bindAttributes(char *offset);
+
+private:
+    StaticVertexBuffer quad = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+
+    int32_t a_corner = -1;
+    int32_t a_offset1 = -1;
+    int32_t a_offset2 = -1;
+    int32_t a_data3 = -1;
+};
+
 }
 
 #endif
@@ -1,30 +1,190 @@
 #include <mbgl/shader/shader.hpp>
 #include <mbgl/platform/gl.hpp>
+#include <mbgl/platform/gl_state.hpp>
 #include <mbgl/util/stopwatch.hpp>
 #include <mbgl/platform/log.hpp>
 #include <mbgl/platform/platform.hpp>
 
+#include <atomic>
 #include <cstring>
 #include <cassert>
 #include <iostream>
 #include <fstream>
 #include <cstdio>
+#include <memory>
+#include <string>
 
 using namespace mbgl;
 
-Shader::Shader(const char *name_, const GLchar *vertSource, const GLchar *fragSource)
+namespace {
+
+const char programBinaryMagic[] = "MBGLPROG";
+
+// FNV-1a, which unlike std::hash is the same across runs and builds.
+uint64_t sourceHash(const GLchar *vertSource, const GLchar *fragSource) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const GLchar *source : { vertSource, fragSource }) {
+        for (const GLchar *c = source; *c; c++) {
+            hash = (hash ^ uint8_t(*c)) * 1099511628211ull;
+        }
+        hash = (hash ^ 0xFF) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string glString(GLenum name) {
+    const GLubyte *str = MBGL_CHECK_ERROR(glGetString(name));
+    return str ? reinterpret_cast<const char *>(str) : "";
+}
+
+// A binary is only good for the driver that produced it, and for the sources it was linked from.
+std::string programBinaryKey(const GLchar *vertSource, const GLchar *fragSource) {
+    return glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION) + "\n" +
+           std::to_string(sourceHash(vertSource, fragSource));
+}
+
+// Binaries go next to the cache database. Each shader variant has one file, which is overwritten
+// when the key changes.
+std::string programBinaryPath(const char *name, uint32_t variant) {
+    const std::string database = platform::defaultCacheDatabase();
+    const size_t slash = database.rfind('/');
+    const std::string directory = slash == std::string::npos ? "." : database.substr(0, slash);
+    const std::string suffix = variant ? "-" + std::to_string(variant) : "";
+    return directory + "/mbgl-shader-" + name + suffix + ".bin";
+}
+
+// Inserts the defines of the variant after the first line of the source, which is the preamble that
+// selects the GLSL version or precision.
+std::string specializeSource(const GLchar *source, uint32_t variant) {
+    std::string defines;
+    if (variant & Shader::Crossfade) {
+        defines += "#define CROSSFADE\n";
+    }
+
+    std::string result = source;
+    const size_t preamble = result.find('\n');
+    result.insert(preamble == std::string::npos ? result.size() : preamble + 1, defines);
+    return result;
+}
+
+bool isProgramBinarySupported() {
+    return gl::GetProgramBinary && gl::ProgramBinary;
+}
+
+// Loads a program binary that was saved with the same key. Returns false, leaving the program
+// unusable, if there is none or the driver rejects it.
+bool loadProgramBinary(GLuint program, const std::string &path, const std::string &key) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.good()) {
+        return false;
+    }
+
+    char magic[sizeof(programBinaryMagic)] = {};
+    uint32_t keyLength = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(&keyLength), sizeof(keyLength));
+    if (!file.good() || std::memcmp(magic, programBinaryMagic, sizeof(magic)) != 0 || keyLength != key.size()) {
+        return false;
+    }
+
+    std::string fileKey(keyLength, '\0');
+    file.read(&fileKey[0], keyLength);
+    if (!file.good() || fileKey != key) {
+        return false;
+    }
+
+    GLenum format = 0;
+    uint32_t length = 0;
+    file.read(reinterpret_cast<char *>(&format), sizeof(format));
+    file.read(reinterpret_cast<char *>(&length), sizeof(length));
+    if (!file.good() || length == 0) {
+        return false;
+    }
+
+    std::unique_ptr<char[]> binary = mbgl::util::make_unique<char[]>(length);
+    file.read(binary.get(), length);
+    if (!file.good()) {
+        return false;
+    }
+
+    MBGL_CHECK_ERROR(gl::ProgramBinary(program, format, binary.get(), GLsizei(length)));
+
+    // Drivers reject binaries after an update even when the version string stays the same.
+    GLint status;
+    MBGL_CHECK_ERROR(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    return status != 0;
+}
+
+void saveProgramBinary(GLuint program, const std::string &path, const std::string &key) {
+    GLint length = 0;
+    MBGL_CHECK_ERROR(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0) {
+        return;
+    }
+
+    std::unique_ptr<char[]> binary = mbgl::util::make_unique<char[]>(length);
+    GLenum format = 0;
+    MBGL_CHECK_ERROR(gl::GetProgramBinary(program, length, &length, &format, binary.get()));
+
+    // Contexts on other threads may save the same program at the same time, so every writer
+    // goes through its own file, which replaces the binary at once.
+    static std::atomic<uint32_t> writers { 0 };
+    const std::string tmpPath = path + "." + std::to_string(writers++) + ".tmp";
+
+    std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+    const uint32_t keyLength = uint32_t(key.size());
+    const uint32_t binaryLength = uint32_t(length);
+    file.write(programBinaryMagic, sizeof(programBinaryMagic));
+    file.write(reinterpret_cast<const char *>(&keyLength), sizeof(keyLength));
+    file.write(key.data(), keyLength);
+    file.write(reinterpret_cast<const char *>(&format), sizeof(format));
+    file.write(reinterpret_cast<const char *>(&binaryLength), sizeof(binaryLength));
+    file.write(binary.get(), binaryLength);
+    file.close();
+    if (!file.good() || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        Log::Warning(Event::Shader, "Couldn't write program binary to %s", path.c_str());
+        std::remove(tmpPath.c_str());
+    }
+}
+
+}
+
+Shader::Shader(const char *name_, const GLchar *vertex, const GLchar *fragment, uint32_t variant_)
     : name(name_),
+      variant(variant_),
       valid(false),
       program(0) {
     util::stopwatch stopwatch("shader compilation", Event::Shader);
 
+    const std::string vertString = specializeSource(vertex, variant);
+    const std::string fragString = specializeSource(fragment, variant);
+    const GLchar *vertSource = vertString.c_str();
+    const GLchar *fragSource = fragString.c_str();
+
     program = MBGL_CHECK_ERROR(glCreateProgram());
 
+    const bool binarySupported = isProgramBinarySupported();
+    const std::string binaryPath = binarySupported ? programBinaryPath(name, variant) : "";
+    const std::string binaryKey = binarySupported ? programBinaryKey(vertSource, fragSource) : "";
+    if (binarySupported) {
+        if (loadProgramBinary(program, binaryPath, binaryKey)) {
+            valid = true;
+            return;
+        }
+
+        // Start over with a fresh program rather than relinking one that failed to load.
+        gl::State::Get().deleteProgram(program);
+        program = MBGL_CHECK_ERROR(glCreateProgram());
+        if (gl::ProgramParameteri) {
+            MBGL_CHECK_ERROR(gl::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+        }
+    }
+
     GLuint vertShader = 0;
     GLuint fragShader = 0;
     if (!compileShader(&vertShader, GL_VERTEX_SHADER, vertSource)) {
         Log::Error(Event::Shader, "Vertex shader %s failed to compile: %s", name, vertSource);
-        MBGL_CHECK_ERROR(glDeleteProgram(program));
+        gl::State::Get().deleteProgram(program);
         program = 0;
         return;
     }
@@ -33,7 +193,7 @@ Shader::Shader(const char *name_, const GLchar *vertSource, const GLchar *fragSo
         Log::Error(Event::Shader, "Fragment shader %s failed to compile: %s", name, fragSource);
         MBGL_CHECK_ERROR(glDeleteShader(vertShader));
         vertShader = 0;
-        MBGL_CHECK_ERROR(glDeleteProgram(program));
+        gl::State::Get().deleteProgram(program);
         program = 0;
         return;
     }
@@ -61,7 +221,7 @@ Shader::Shader(const char *name_, const GLchar *vertSource, const GLchar *fragSo
             vertShader = 0;
             MBGL_CHECK_ERROR(glDeleteShader(fragShader));
             fragShader = 0;
-            MBGL_CHECK_ERROR(glDeleteProgram(program));
+            gl::State::Get().deleteProgram(program);
             program = 0;
             return;
         }
@@ -86,7 +246,7 @@ Shader::Shader(const char *name_, const GLchar *vertSource, const GLchar *fragSo
             vertShader = 0;
             MBGL_CHECK_ERROR(glDeleteShader(fragShader));
             fragShader = 0;
-            MBGL_CHECK_ERROR(glDeleteProgram(program));
+            gl::State::Get().deleteProgram(program);
             program = 0;
         }
     }
@@ -97,6 +257,10 @@ Shader::Shader(const char *name_, const GLchar *vertSource, const GLchar *fragSo
     MBGL_CHECK_ERROR(glDetachShader(program, fragShader));
     MBGL_CHECK_ERROR(glDeleteShader(fragShader));
 
+    if (binarySupported && program) {
+        saveProgramBinary(program, binaryPath, binaryKey);
+    }
+
     valid = true;
 }
 
@@ -139,7 +303,7 @@ bool Shader::compileShader(GLuint *shader, GLenum type, const GLchar *source) {
 
 Shader::~Shader() {
     if (program) {
-        MBGL_CHECK_ERROR(glDeleteProgram(program));
+        gl::State::Get().deleteProgram(program);
         program = 0;
         valid = false;
     }
@@ -10,9 +10,17 @@ namespace mbgl {
 
 class Shader : private util::noncopyable {
 public:
-    Shader(const char *name, const char *vertex, const char *fragment);
+    // Features that are compiled into a program through preprocessor defines, instead of being
+    // switched off with uniforms at runtime. Each combination is a separate program.
+    enum Variant : uint32_t {
+        // Blends two samples of a pattern, while it fades between zoom levels. Defines CROSSFADE.
+        Crossfade = 1 << 0,
+    };
+
+    Shader(const char *name, const char *vertex, const char *fragment, uint32_t variant = 0);
     ~Shader();
     const char *name;
+    const uint32_t variant;
     bool valid;
     uint32_t program;
 
@@ -0,0 +1,41 @@
+#include <mbgl/storage/bandwidth_estimator.hpp>
+
+#include <cassert>
+
+namespace mbgl {
+
+BandwidthEstimator::BandwidthEstimator(timestamp window_, timestamp minimum_)
+    : window(window_), minimum(minimum_) {
+    assert(minimum <= window);
+}
+
+void BandwidthEstimator::advance(timestamp now) {
+    if (active) {
+        busy += now - last;
+    }
+    last = now;
+}
+
+void BandwidthEstimator::start(timestamp now) {
+    advance(now);
+    active++;
+}
+
+void BandwidthEstimator::finish(timestamp now, size_t bytes_) {
+    assert(active > 0);
+    advance(now);
+    active--;
+    bytes += bytes_;
+
+    // Scales down the older transfers instead of keeping each of them around.
+    if (busy > window) {
+        bytes *= window / busy;
+        busy = window;
+    }
+
+    if (busy >= minimum) {
+        bandwidth = uint64_t(bytes / busy * 1e9);
+    }
+}
+
+}
@@ -0,0 +1,48 @@
+#ifndef MBGL_STORAGE_BANDWIDTH_ESTIMATOR
+#define MBGL_STORAGE_BANDWIDTH_ESTIMATOR
+
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/time.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mbgl {
+
+// Estimates the throughput of the network as the bytes that HTTP responses brought, divided by the
+// time in which any request was in flight. Unlike the throughput of single requests, this isn't
+// lowered by requests that share a connection or wait for a free one.
+//
+// Only the last /window/ of busy time counts, so the estimate follows a changing network within a
+// few seconds. Requests that are canceled or fail count their time, but no bytes.
+//
+// Transfers are reported on the loop of the file source; the estimate may be read from any thread.
+class BandwidthEstimator : private util::noncopyable {
+public:
+    BandwidthEstimator(timestamp window = 10_seconds, timestamp minimum = 1_second);
+
+    void start(timestamp now);
+    void finish(timestamp now, size_t bytes);
+
+    // In bytes per second; 0 until the network was busy for /minimum/.
+    inline uint64_t estimate() const { return bandwidth; }
+
+private:
+    // Adds the busy time since the last transfer started or finished.
+    void advance(timestamp now);
+
+    const timestamp window;
+    const timestamp minimum;
+
+    size_t active = 0;
+    timestamp last = 0;
+    double bytes = 0;
+    double busy = 0;
+
+    std::atomic<uint64_t> bandwidth { 0 };
+};
+
+}
+
+#endif
@@ -2,10 +2,13 @@
 #include <mbgl/storage/response.hpp>
 #include <mbgl/storage/request.hpp>
 #include <mbgl/util/std.hpp>
+#include <mbgl/util/mapbox.hpp>
 
 #include <uv.h>
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 namespace mbgl {
 
@@ -19,7 +22,8 @@ void invoke(const std::forward_list<std::unique_ptr<Callback>> &list, Args&& ...
     }
 }
 
-BaseRequest::BaseRequest(const std::string &path_) : threadId(std::this_thread::get_id()), path(path_) {
+BaseRequest::BaseRequest(const std::string &path_)
+    : threadId(std::this_thread::get_id()), path(path_), cacheKey(util::mapbox::canonicalURL(path_)) {
 }
 
 // A base request can only be "canceled" by destroying the object. In that case, we'll have to
@@ -33,6 +37,14 @@ void BaseRequest::retryImmediately() {
     // no-op. override in child class.
 }
 
+void BaseRequest::setPriority(float) {
+    // no-op. override in child class.
+}
+
+void BaseRequest::startProgress() {
+    // no-op. override in child class.
+}
+
 void BaseRequest::notify() {
     assert(std::this_thread::get_id() == threadId);
 
@@ -46,14 +58,66 @@ void BaseRequest::notify() {
     callbacks.clear();
 
     if (response) {
+        response->cacheTime = cacheTime;
+        response->networkTime = networkTime;
         invoke<CompletedCallback>(list, *response);
     } else {
         invoke<AbortedCallback>(list);
     }
 
+    stale.reset();
     self.reset();
 }
 
+void BaseRequest::notifyStale() {
+    assert(std::this_thread::get_id() == threadId);
+    assert(stale);
+    stale->cacheTime = cacheTime;
+    stale->networkTime = networkTime;
+
+    // Callbacks may cancel the request, which would modify the list and could deallocate us.
+    util::ptr<BaseRequest> retain = self;
+    std::vector<Callback *> list;
+    for (const std::unique_ptr<Callback> &callback : callbacks) {
+        list.push_back(callback.get());
+    }
+
+    for (Callback *callback : list) {
+        // Skip callbacks that were removed by a previous callback.
+        const bool registered = std::find_if(callbacks.begin(), callbacks.end(),
+            [callback](const std::unique_ptr<Callback> &it) { return it.get() == callback; }) != callbacks.end();
+        if (registered && callback->is<CompletedCallback>()) {
+            // Copy it, since the callback may remove itself while it runs.
+            const CompletedCallback completed = callback->get<CompletedCallback>();
+            completed(*stale);
+        }
+    }
+}
+
+void BaseRequest::notifyProgress(const std::string &data, size_t offset) {
+    assert(std::this_thread::get_id() == threadId);
+
+    // Callbacks may cancel the request, which would modify the list and could deallocate us.
+    util::ptr<BaseRequest> retain = self;
+    std::vector<Callback *> list;
+    for (const std::unique_ptr<Callback> &callback : callbacks) {
+        if (callback->is<ProgressCallback>()) {
+            list.push_back(callback.get());
+        }
+    }
+
+    for (Callback *callback : list) {
+        // Skip callbacks that were removed by a previous callback.
+        const bool registered = std::find_if(callbacks.begin(), callbacks.end(),
+            [callback](const std::unique_ptr<Callback> &it) { return it.get() == callback; }) != callbacks.end();
+        if (registered) {
+            // Copy it, since the callback may remove itself while it runs.
+            const ProgressCallback progress = callback->get<ProgressCallback>();
+            progress(data, offset);
+        }
+    }
+}
+
 Callback *BaseRequest::add(Callback &&callback, const util::ptr<BaseRequest> &request) {
     assert(std::this_thread::get_id() == threadId);
     assert(this == request.get());
@@ -63,14 +127,25 @@ Callback *BaseRequest::add(Callback &&callback, const util::ptr<BaseRequest> &re
         if (callback.is<CompletedCallback>()) {
             callback.get<CompletedCallback>()(*response);
         } else {
-            // We already know that this request was successful. The AbortedCallback will be discarded
-            // here since it would never be called.
+            // We already know that this request was successful. The AbortedCallback and
+            // ProgressCallback will be discarded here since they would never be called.
         }
         return nullptr;
     } else {
+        if (stale && callback.is<CompletedCallback>()) {
+            // Hand out what we have while the final response is underway.
+            callback.get<CompletedCallback>()(*stale);
+        }
+        const bool progress = callback.is<ProgressCallback>() &&
+            std::none_of(callbacks.begin(), callbacks.end(),
+                [](const std::unique_ptr<Callback> &it) { return it->is<ProgressCallback>(); });
         self = request;
         callbacks.push_front(util::make_unique<Callback>(std::move(callback)));
-        return callbacks.front().get();
+        Callback *added = callbacks.front().get();
+        if (progress) {
+            startProgress();
+        }
+        return added;
     }
 }
 
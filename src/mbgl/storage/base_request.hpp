@@ -3,6 +3,7 @@
 
 #include <mbgl/storage/request_callback.hpp>
 #include <mbgl/util/ptr.hpp>
+#include <mbgl/util/time.hpp>
 
 #include <string>
 #include <forward_list>
@@ -36,6 +37,14 @@ public:
     // all listeners.
     void notify();
 
+    // May be called by subclasses with a preliminary response in `stale` before the actual
+    // response is available. Listeners stay registered and are notified again by notify(), which
+    // may well hand out the same data.
+    void notifyStale();
+
+    // May be called by subclasses with the next part of the response body while it downloads.
+    void notifyProgress(const std::string &data, size_t offset);
+
     // This function is called when the request ought to be stopped. Any subclass must make sure this
     // is also called in its destructor. Calling this function repeatedly must be safe.
     // This function must call notify().
@@ -45,12 +54,32 @@ public:
     // reaction to a network status change.
     virtual void retryImmediately();
 
+    // Changes the order in which this request is scheduled relative to other pending requests.
+    // Lower values are fetched first; see Request::setPriority().
+    virtual void setPriority(float priority);
+
+    // This function is called when the first progress listener is added. Subclasses that can
+    // deliver the response body in parts start calling notifyProgress().
+    virtual void startProgress();
+
 public:
     const std::thread::id threadId;
     const std::string path;
+
+    // The key of the response in the cache, computed once so that cache lookups and writes don't
+    // have to canonicalize the URL again.
+    const std::string cacheKey;
+
     std::unique_ptr<Response> response;
 
 protected:
+    std::unique_ptr<Response> stale;
+
+    // Subclasses add up the time spent in each phase here; the responses handed to listeners carry
+    // the totals.
+    timestamp cacheTime = 0;
+    timestamp networkTime = 0;
+
     // This object may hold a shared_ptr to itself. It does this to prevent destruction of this object
     // while a request is in progress.
     util::ptr<BaseRequest> self;
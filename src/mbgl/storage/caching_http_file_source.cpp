@@ -2,7 +2,10 @@
 #include <mbgl/storage/asset_request.hpp>
 #include <mbgl/storage/http_request.hpp>
 #include <mbgl/storage/sqlite_store.hpp>
-#include <mbgl/storage/asset_request.hpp>
+#include <mbgl/storage/mbtiles_source.hpp>
+#include <mbgl/storage/request_counters.hpp>
+#include <mbgl/storage/circuit_breaker.hpp>
+#include <mbgl/storage/timer_wheel.hpp>
 #include <mbgl/util/uv-messenger.h>
 #include <mbgl/util/mapbox.hpp>
 #include <mbgl/util/std.hpp>
@@ -12,7 +15,7 @@
 namespace mbgl {
 
 CachingHTTPFileSource::CachingHTTPFileSource(const std::string &path_)
-    : path(path_) {}
+    : path(path_), counters(std::make_shared<RequestCounters>()) {}
 
 CachingHTTPFileSource::~CachingHTTPFileSource() {
 }
@@ -23,6 +26,7 @@ void CachingHTTPFileSource::setLoop(uv_loop_t* loop_) {
     threadId = std::this_thread::get_id();
     store = !path.empty() ? util::ptr<SQLiteStore>(new SQLiteStore(loop_, path)) : nullptr;
     loop = loop_;
+    timers = std::make_shared<TimerWheel>(loop);
     queue = new uv_messenger_t;
 
     uv_messenger_init(loop, queue, [](void *ptr) {
@@ -54,6 +58,8 @@ void CachingHTTPFileSource::clearLoop() {
     }
 
     store.reset();
+    mbtiles.reset();
+    timers.reset();
 
     loop = nullptr;
 }
@@ -72,26 +78,30 @@ std::string CachingHTTPFileSource::getAccessToken() const {
     return accessToken;
 }
 
-std::unique_ptr<Request> CachingHTTPFileSource::request(ResourceType type, const std::string& url_) {
-    assert(std::this_thread::get_id() == threadId);
-
-    std::string url = url_;
-
+std::string CachingHTTPFileSource::normalizeURL(ResourceType type, const std::string &url) const {
     // Make URL absolute.
-    const size_t separator = url.find("://");
-    if (separator == std::string::npos) {
-        url = base + url;
+    if (url.find("://") == std::string::npos) {
+        const std::string absolute = base + url;
+        return absolute.find("://") != std::string::npos ? normalizeURL(type, absolute) : absolute;
     }
 
-    // Normalize mapbox:// URLs.
-    switch (type) {
-    case ResourceType::Glyphs:
-        url = util::mapbox::normalizeGlyphsURL(url, accessToken);
-    default:
-        url = util::mapbox::normalizeSourceURL(url, accessToken);
+    // Normalize mapbox:// URLs. Other URLs are returned as they are without rebuilding them.
+    if (url.compare(0, 9, "mapbox://") != 0) {
+        return url;
+    }
+    if (type == ResourceType::Glyphs) {
+        return util::mapbox::normalizeGlyphsURL(url, accessToken);
     }
+    return util::mapbox::normalizeSourceURL(url, accessToken);
+}
+
+std::unique_ptr<Request> CachingHTTPFileSource::request(ResourceType type, const std::string& url_) {
+    assert(std::this_thread::get_id() == threadId);
+
+    const std::string url = normalizeURL(type, url_);
 
     util::ptr<BaseRequest> req;
+    counters->requests++;
 
     // First, try to find an existing Request object.
     auto it = pending.find(url);
@@ -99,14 +109,22 @@ std::unique_ptr<Request> CachingHTTPFileSource::request(ResourceType type, const
         req = it->second.lock();
     }
 
-    if (!req) {
+    if (req) {
+        counters->coalesced++;
+    } else {
         if (url.substr(0, 8) == "asset://") {
             req = std::make_shared<AssetRequest>(url.substr(8), loop);
+        } else if (url.substr(0, 10) == "mbtiles://") {
+            if (!mbtiles) {
+                mbtiles = util::make_unique<MBTilesSource>(loop);
+            }
+            req = mbtiles->request(url.substr(10));
         } else {
-            req = std::make_shared<HTTPRequest>(type, url, loop, store);
+            req = std::make_shared<HTTPRequest>(type, url, loop, timers, store, counters, networkEnabled);
         }
 
-        pending.emplace(url, req);
+        // Replaces an expired entry for the same URL.
+        pending[url] = req;
     }
 
     return util::make_unique<Request>(req);
@@ -120,8 +138,23 @@ void CachingHTTPFileSource::prepare(std::function<void()> fn) {
     }
 }
 
+size_t CachingHTTPFileSource::releaseMemory() {
+    assert(std::this_thread::get_id() == threadId);
+    return store ? store->releaseMemory() : 0;
+}
+
+void CachingHTTPFileSource::pin(ResourceType type, const std::string &url) {
+    assert(std::this_thread::get_id() == threadId);
+    if (store) {
+        store->pin(util::mapbox::canonicalURL(normalizeURL(type, url)));
+    }
+}
+
 void CachingHTTPFileSource::setReachability(bool reachable) {
     if (reachable && loop) {
+        // Failures while we were offline don't say anything about the servers.
+        CircuitBreaker::shared().reset();
+
         prepare([this]() {
             util::ptr<BaseRequest> req;
             for (const std::pair<std::string, std::weak_ptr<BaseRequest>> &pair : pending) {
@@ -133,4 +166,24 @@ void CachingHTTPFileSource::setReachability(bool reachable) {
     }
 }
 
+void CachingHTTPFileSource::setNetworkEnabled(bool enabled) {
+    networkEnabled = enabled;
+}
+
+FileSourceStatistics CachingHTTPFileSource::getStatistics() const {
+    FileSourceStatistics statistics;
+    statistics.requests = counters->requests;
+    statistics.coalesced = counters->coalesced;
+    statistics.cacheHits = counters->cacheHits;
+    statistics.cacheMisses = counters->cacheMisses;
+    statistics.cacheLatency = counters->cacheLatency.snapshot();
+    statistics.networkLatency = counters->networkLatency.snapshot();
+    statistics.bandwidth = counters->bandwidth.estimate();
+    return statistics;
+}
+
+uint64_t CachingHTTPFileSource::getBandwidth() {
+    return counters->bandwidth.estimate();
+}
+
 }
@@ -0,0 +1,98 @@
+#include <mbgl/storage/circuit_breaker.hpp>
+#include <mbgl/platform/log.hpp>
+
+#include <algorithm>
+
+namespace mbgl {
+
+// Consecutive failures after which we stop sending requests to a host.
+const uint32_t CircuitBreakerThreshold = 5;
+
+// The first cool-down period; it doubles with every failed probe up to the maximum.
+const timestamp CircuitBreakerCooldown = 5_seconds;
+const timestamp CircuitBreakerMaxCooldown = 60_seconds;
+
+// A probe that didn't report back in time (e.g. because it was canceled) doesn't block others.
+const timestamp CircuitBreakerProbeTimeout = 30_seconds;
+
+CircuitBreaker &CircuitBreaker::shared() {
+    // Never destructed, so that requests on other threads can't outlive it during shutdown.
+    static CircuitBreaker *breaker = new CircuitBreaker;
+    return *breaker;
+}
+
+uint64_t CircuitBreaker::check(const std::string &url) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = hosts.find(url);
+    if (it == hosts.end() || it->second.failures < CircuitBreakerThreshold) {
+        return 0;
+    }
+
+    Host &entry = it->second;
+    const timestamp now = util::now();
+    if (now < entry.reopen) {
+        return (entry.reopen - now) / 1_millisecond + 1;
+    } else if (!entry.probing || now - entry.probe >= CircuitBreakerProbeTimeout) {
+        // This request is the probe.
+        entry.probing = true;
+        entry.probe = now;
+        return 0;
+    } else {
+        // Wait for the result of the probe.
+        const timestamp wait = std::min(entry.probe + CircuitBreakerProbeTimeout - now, CircuitBreakerCooldown);
+        return wait / 1_millisecond + 1;
+    }
+}
+
+void CircuitBreaker::reportSuccess(const std::string &url) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = hosts.find(url);
+    if (it != hosts.end()) {
+        if (it->second.failures >= CircuitBreakerThreshold) {
+            Log::Info(Event::HttpRequest, "%s is reachable again", url.c_str());
+        }
+        hosts.erase(it);
+    }
+}
+
+void CircuitBreaker::reportFailure(const std::string &url) {
+    if (url.empty()) {
+        // Not a URL we know how to attribute to a host.
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    Host &entry = hosts[url];
+    entry.failures++;
+
+    const timestamp now = util::now();
+    if (entry.failures == CircuitBreakerThreshold) {
+        entry.cooldown = CircuitBreakerCooldown;
+        Log::Warning(Event::HttpRequest, "%s is failing; pausing requests for %llu seconds",
+                     url.c_str(), (unsigned long long)(entry.cooldown / 1_second));
+    } else if (entry.probing) {
+        // The probe failed.
+        entry.cooldown = std::min(entry.cooldown * 2, CircuitBreakerMaxCooldown);
+    } else if (entry.failures < CircuitBreakerThreshold || now < entry.reopen) {
+        // Requests that were sent before we stopped don't extend the cool-down period.
+        return;
+    }
+
+    entry.reopen = now + entry.cooldown;
+    entry.probing = false;
+}
+
+void CircuitBreaker::reset() {
+    std::lock_guard<std::mutex> lock(mtx);
+    hosts.clear();
+}
+
+std::string CircuitBreaker::host(const std::string &url) {
+    const size_t separator = url.find("://");
+    if (separator == std::string::npos) {
+        return "";
+    }
+    return url.substr(0, url.find('/', separator + 3));
+}
+
+}
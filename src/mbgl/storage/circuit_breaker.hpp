@@ -0,0 +1,51 @@
+#ifndef MBGL_STORAGE_CIRCUIT_BREAKER
+#define MBGL_STORAGE_CIRCUIT_BREAKER
+
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/time.hpp>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace mbgl {
+
+// Tracks the health of the hosts we send requests to. After a number of consecutive failures, a
+// host is considered unhealthy, and requests to it fail right away instead of adding to its load.
+// Once the cool-down period is over, a single probe request is let through: if it succeeds, the
+// host is healthy again, otherwise the cool-down period doubles.
+//
+// Shared by all requests in the process; may be used from any thread.
+class CircuitBreaker : private util::noncopyable {
+public:
+    static CircuitBreaker &shared();
+
+    // Returns 0 when a request to the host may be sent. Otherwise returns the number of
+    // milliseconds until the host will be probed again.
+    uint64_t check(const std::string &host);
+
+    void reportSuccess(const std::string &host);
+    void reportFailure(const std::string &host);
+
+    // Forgets about all failures, e.g. because they were caused by our own network connection.
+    void reset();
+
+    // Returns "scheme://host:port" of a URL.
+    static std::string host(const std::string &url);
+
+private:
+    struct Host {
+        uint32_t failures = 0;
+        timestamp cooldown = 0;
+        timestamp reopen = 0;
+        bool probing = false;
+        timestamp probe = 0;
+    };
+
+    std::mutex mtx;
+    std::unordered_map<std::string, Host> hosts;
+};
+
+}
+
+#endif
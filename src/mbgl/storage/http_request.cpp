@@ -1,12 +1,20 @@
 #include <mbgl/storage/http_request.hpp>
 #include <mbgl/storage/sqlite_store.hpp>
 #include <mbgl/storage/http_request_baton.hpp>
+#include <mbgl/storage/request_counters.hpp>
+#include <mbgl/storage/circuit_breaker.hpp>
 #include <mbgl/platform/log.hpp>
+#include <mbgl/util/std.hpp>
+#include <mbgl/util/constants.hpp>
+#include <mbgl/util/time.hpp>
 
 #include <uv.h>
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <mutex>
+#include <random>
 
 namespace mbgl {
 
@@ -15,14 +23,41 @@ namespace mbgl {
 #pragma clang diagnostic ignored "-Wexit-time-destructors"
 #pragma clang diagnostic ignored "-Wglobal-constructors"
 
+// Requests that are woken up by a reachability change are spread out over this many milliseconds.
+const uint64_t ReachabilityRetryWindow = 1000;
+
+// Responses that say there is no data are cached for a while even if the server doesn't say how
+// long they stay valid.
+void expireNegativeResponse(Response &res) {
+    if (res.expires <= 0) {
+        const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count();
+        res.expires = now + util::negativeCacheTTL;
+    }
+}
+
+// Returns a uniformly distributed random number in [0, max].
+uint64_t randomDelay(uint64_t max) {
+    static std::mutex mtx;
+    static std::minstd_rand engine(std::random_device{}());
+    std::lock_guard<std::mutex> lock(mtx);
+    return std::uniform_int_distribution<uint64_t>(0, max)(engine);
+}
+
 struct CacheRequestBaton {
     HTTPRequest *request = nullptr;
-    std::string path;
     util::ptr<SQLiteStore> store;
+
+    // When loading the data of an entry, the response that it belongs to.
+    std::unique_ptr<Response> response;
+    bool revalidate = false;
 };
 
-HTTPRequest::HTTPRequest(ResourceType type_, const std::string &path_, uv_loop_t *loop_, util::ptr<SQLiteStore> store_)
-    : BaseRequest(path_), threadId(std::this_thread::get_id()), loop(loop_), store(store_), type(type_) {
+HTTPRequest::HTTPRequest(ResourceType type_, const std::string &path_, uv_loop_t *loop_, util::ptr<TimerWheel> timers_,
+                         util::ptr<SQLiteStore> store_, util::ptr<RequestCounters> counters_, bool networkEnabled_)
+    : BaseRequest(path_), threadId(std::this_thread::get_id()), loop(loop_), timers(timers_), store(store_),
+      counters(counters_), type(type_), networkEnabled(networkEnabled_), host(CircuitBreaker::host(path_)) {
+    assert(timers);
     if (store) {
         startCacheRequest();
     } else {
@@ -35,18 +70,67 @@ void HTTPRequest::startCacheRequest() {
 
     cacheBaton = new CacheRequestBaton;
     cacheBaton->request = this;
-    cacheBaton->path = path;
     cacheBaton->store = store;
-    store->get(path, [](std::unique_ptr<Response> &&response_, void *ptr) {
+    phaseStart = util::now();
+
+    // Only read the metadata for now; if the entry turns out to be expired, we'll only need the
+    // data when the server confirms that it didn't change.
+    store->head(cacheKey, [](std::unique_ptr<Response> &&response_, void *ptr) {
         // Wrap in a unique_ptr, so it'll always get auto-destructed.
         std::unique_ptr<CacheRequestBaton> baton((CacheRequestBaton *)ptr);
         if (baton->request) {
             baton->request->cacheBaton = nullptr;
+            baton->request->finishCachePhase();
             baton->request->handleCacheResponse(std::move(response_));
         }
     }, cacheBaton);
 }
 
+void HTTPRequest::startCacheDataRequest(std::unique_ptr<Response> &&res, bool revalidate) {
+    assert(std::this_thread::get_id() == threadId);
+    assert(!cacheBaton);
+
+    cacheBaton = new CacheRequestBaton;
+    cacheBaton->request = this;
+    cacheBaton->store = store;
+    cacheBaton->response = std::move(res);
+    cacheBaton->revalidate = revalidate;
+    phaseStart = util::now();
+    store->get(cacheKey, [](std::unique_ptr<Response> &&response_, void *ptr) {
+        // Wrap in a unique_ptr, so it'll always get auto-destructed.
+        std::unique_ptr<CacheRequestBaton> baton((CacheRequestBaton *)ptr);
+        if (baton->request) {
+            baton->request->cacheBaton = nullptr;
+            baton->request->finishCachePhase();
+            baton->request->handleCacheDataResponse(std::move(baton->response), std::move(response_),
+                                                    baton->revalidate);
+        }
+    }, cacheBaton);
+}
+
+void HTTPRequest::handleCacheDataResponse(std::unique_ptr<Response> &&res, std::unique_ptr<Response> &&cached,
+                                          bool revalidate) {
+    assert(std::this_thread::get_id() == threadId);
+
+    if (cached && cached->data) {
+        res->data = cached->data;
+        if (revalidate) {
+            revalidateStale(std::move(res));
+            return;
+        }
+        if (counters) {
+            counters->cacheHits++;
+        }
+        response = std::move(res);
+        notify();
+        // Note: after calling notify(), the request object may cease to exist.
+    } else {
+        // The entry was evicted in the meantime; get the data from the server without
+        // revalidating.
+        startHTTPRequest(nullptr);
+    }
+}
+
 void HTTPRequest::handleCacheResponse(std::unique_ptr<Response> &&res) {
     assert(std::this_thread::get_id() == threadId);
 
@@ -54,30 +138,110 @@ void HTTPRequest::handleCacheResponse(std::unique_ptr<Response> &&res) {
         // This entry was stored in the cache. Now determine if we need to revalidate.
         const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
                                 std::chrono::system_clock::now().time_since_epoch()).count();
-        if (res->expires > now) {
+        if (res->expires > now || (!networkEnabled && res->code == 200)) {
+            if (!res->data) {
+                startCacheDataRequest(std::move(res), false);
+                return;
+            }
+            if (counters) {
+                counters->cacheHits++;
+            }
             response = std::move(res);
             notify();
             // Note: after calling notify(), the request object may cease to exist.
             // This HTTPRequest is completed.
             return;
-        } else {
-            // TODO: notify with preliminary results.
+        } else if (type == ResourceType::Tile && res->code == 200) {
+            // Tiles rarely change, so rather than waiting for the network, we render the expired
+            // tile right away and replace it if the server sends a different one.
+            if (!res->data) {
+                startCacheDataRequest(std::move(res), true);
+            } else {
+                revalidateStale(std::move(res));
+            }
+            return;
         }
     }
 
     startHTTPRequest(std::move(res));
 }
 
+void HTTPRequest::revalidateStale(std::unique_ptr<Response> &&res) {
+    assert(std::this_thread::get_id() == threadId);
+    assert(res && res->data);
+
+    stale = util::make_unique<Response>(*res);
+    stale->stale = true;
+
+    // Start revalidating first, since listeners may cancel this request.
+    startHTTPRequest(std::move(res));
+    notifyStale();
+    // Note: after calling notifyStale(), the request object may cease to exist.
+}
+
+// The cached entry that we revalidated may not have its data loaded, but listeners of failed
+// requests still expect a data object.
+std::unique_ptr<Response> withData(std::unique_ptr<Response> &&res) {
+    if (res && !res->data) {
+        res->data = std::make_shared<const std::string>();
+    }
+    return std::move(res);
+}
+
 void HTTPRequest::startHTTPRequest(std::unique_ptr<Response> &&res) {
     assert(std::this_thread::get_id() == threadId);
     assert(!httpBaton);
 
+    if (!networkEnabled) {
+        response = withData(res ? std::move(res) : util::make_unique<Response>());
+        response->code = -1;
+        response->message = "The network is disabled";
+        notify();
+        // Note: after calling notify(), the request object may cease to exist.
+        return;
+    }
+
+    if (counters && attempts == 0) {
+        // Retries of the same request don't count again.
+        counters->cacheMisses++;
+    }
+
+    const uint64_t wait = CircuitBreaker::shared().check(host);
+    if (wait) {
+        failFast(std::move(res), wait);
+        return;
+    }
+
     httpBaton = std::make_shared<HTTPRequestBaton>(path);
     httpBaton->request = this;
     httpBaton->async = new uv_async_t;
     httpBaton->response = std::move(res);
+    httpBaton->priority = priority;
+    httpBaton->progress = progress;
     httpBaton->async->data = new util::ptr<HTTPRequestBaton>(httpBaton);
 
+    // The baton outlives this handle: it is closed before the request lets go of the baton.
+    httpBaton->progressAsync = new uv_async_t;
+    httpBaton->progressAsync->data = httpBaton.get();
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
+    uv_async_init(loop, httpBaton->progressAsync, [](uv_async_t *async, int) {
+#else
+    uv_async_init(loop, httpBaton->progressAsync, [](uv_async_t *async) {
+#endif
+        HTTPRequestBaton &baton = *(HTTPRequestBaton *)async->data;
+        std::string data;
+        size_t offset = 0;
+        {
+            std::lock_guard<std::mutex> lock(baton.progressMutex);
+            data.swap(baton.progressData);
+            offset = baton.progressOffset;
+        }
+        if (baton.request && !data.empty()) {
+            baton.request->notifyProgress(data, offset);
+            // Note: after calling notifyProgress(), the request object may cease to exist.
+        }
+    });
+
 #if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
     uv_async_init(loop, httpBaton->async, [](uv_async_t *async, int) {
 #else
@@ -87,8 +251,12 @@ void HTTPRequest::startHTTPRequest(std::unique_ptr<Response> &&res) {
 
         if (baton->request) {
             HTTPRequest *request = baton->request;
+            request->removeProgressAsync();
             request->httpBaton.reset();
             baton->request = nullptr;
+            const std::unique_ptr<Response> &res = baton->response;
+            request->finishNetworkPhase(baton->type == HTTPResponseType::Successful && res && res->data
+                                            ? res->data->size() : 0);
             request->handleHTTPResponse(baton->type, std::move(baton->response));
         }
 
@@ -99,16 +267,69 @@ void HTTPRequest::startHTTPRequest(std::unique_ptr<Response> &&res) {
         });
     });
     attempts++;
+    phaseStart = util::now();
+    if (counters) {
+        counters->bandwidth.start(phaseStart);
+    }
     HTTPRequestBaton::start(httpBaton);
 }
 
+void HTTPRequest::finishCachePhase() {
+    const timestamp duration = util::now() - phaseStart;
+    cacheTime += duration;
+    if (counters) {
+        counters->cacheLatency.add(duration);
+    }
+}
+
+void HTTPRequest::finishNetworkPhase(size_t bytes) {
+    const timestamp now = util::now();
+    const timestamp duration = now - phaseStart;
+    networkTime += duration;
+    if (counters) {
+        counters->networkLatency.add(duration);
+        counters->bandwidth.finish(now, bytes);
+    }
+}
+
+
+void HTTPRequest::failFast(std::unique_ptr<Response> &&res, uint64_t wait) {
+    assert(std::this_thread::get_id() == threadId);
 
+    // The server is unhealthy; don't add to its load. This counts as a failed attempt, so that
+    // listeners get the error quickly if the server doesn't recover.
+    attempts++;
+    if (attempts >= 4) {
+        response = withData(res ? std::move(res) : util::make_unique<Response>());
+        response->code = -1;
+        response->message = "Requests to " + host + " are paused after repeated failures";
+        notify();
+        // Note: after calling notify(), the request object may cease to exist.
+    } else {
+        retryHTTPRequest(std::move(res), std::max<uint64_t>((1 << attempts) * 1000, wait));
+    }
+}
 
 void HTTPRequest::handleHTTPResponse(HTTPResponseType responseType, std::unique_ptr<Response> &&res) {
     assert(std::this_thread::get_id() == threadId);
     assert(!httpBaton);
     assert(!response);
 
+    switch (responseType) {
+        case HTTPResponseType::TemporaryError:
+        case HTTPResponseType::ConnectionError:
+            CircuitBreaker::shared().reportFailure(host);
+            break;
+        case HTTPResponseType::Successful:
+        case HTTPResponseType::NotModified:
+        case HTTPResponseType::PermanentError:
+            // The server answered, even if it doesn't have what we're looking for.
+            CircuitBreaker::shared().reportSuccess(host);
+            break;
+        default:
+            break;
+    }
+
     switch (responseType) {
         // This error was caused by a temporary error and it is likely that it will be resolved
         // immediately. We are going to try again right away. This is like the TemporaryError,
@@ -116,7 +337,7 @@ void HTTPRequest::handleHTTPResponse(HTTPResponseType responseType, std::unique_
         case HTTPResponseType::SingularError:
             if (attempts >= 4) {
                 // Report as error after 4 attempts.
-                response = std::move(res);
+                response = withData(std::move(res));
                 notify();
             } else if (attempts >= 2) {
                 // Switch to the back-off algorithm after the second failure.
@@ -132,7 +353,7 @@ void HTTPRequest::handleHTTPResponse(HTTPResponseType responseType, std::unique_
         case HTTPResponseType::TemporaryError:
             if (attempts >= 4) {
                 // Report error back after it failed completely.
-                response = std::move(res);
+                response = withData(std::move(res));
                 notify();
             } else {
                 retryHTTPRequest(std::move(res), (1 << attempts) * 1000);
@@ -146,7 +367,7 @@ void HTTPRequest::handleHTTPResponse(HTTPResponseType responseType, std::unique_
 
             if (attempts >= 4) {
                 // Report error back after it failed completely.
-                response = std::move(res);
+                response = withData(std::move(res));
                 notify();
             } else {
                 // By default, we will retry every 60 seconds.
@@ -162,14 +383,24 @@ void HTTPRequest::handleHTTPResponse(HTTPResponseType responseType, std::unique_
 
         // This error probably won't be resolved by retrying anytime soon. We are giving up.
         case HTTPResponseType::PermanentError:
-            response = std::move(res);
+            if (store && res->code == 404) {
+                // Tiles outside of the data of a source are usually missing; caching the miss
+                // saves the request the next time the tile is needed.
+                res->data = std::make_shared<const std::string>();
+                expireNegativeResponse(*res);
+                store->put(cacheKey, type, *res);
+            }
+            response = withData(std::move(res));
             notify();
             break;
 
         // The request returned data successfully. We retrieved and decoded the data successfully.
         case HTTPResponseType::Successful:
             if (store) {
-                store->put(path, type, *res);
+                if (res->code == 204) {
+                    expireNegativeResponse(*res);
+                }
+                store->put(cacheKey, type, *res);
             }
             response = std::move(res);
             notify();
@@ -178,7 +409,12 @@ void HTTPRequest::handleHTTPResponse(HTTPResponseType responseType, std::unique_
         // The request confirmed that the data wasn't changed. We already have the data.
         case HTTPResponseType::NotModified:
             if (store) {
-                store->updateExpiration(path, res->expires);
+                store->updateExpiration(cacheKey, res->expires);
+            }
+            if (!res->data) {
+                // Now we know that we need the cached data.
+                startCacheDataRequest(std::move(res), false);
+                break;
             }
             response = std::move(res);
             notify();
@@ -190,37 +426,53 @@ void HTTPRequest::handleHTTPResponse(HTTPResponseType responseType, std::unique_
     }
 }
 
-using RetryBaton = std::pair<HTTPRequest *, std::unique_ptr<Response>>;
-
 void HTTPRequest::retryHTTPRequest(std::unique_ptr<Response> &&res, uint64_t timeout) {
     assert(std::this_thread::get_id() == threadId);
-    assert(!backoffTimer);
-    backoffTimer = new uv_timer_t();
-    uv_timer_init(loop, backoffTimer);
-    backoffTimer->data = new RetryBaton(this, std::move(res));
+    assert(!retryTimer);
+    retryResponse = std::move(res);
 
-#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
-    uv_timer_start(backoffTimer, [](uv_timer_t *timer, int) {
-#else
-    uv_timer_start(backoffTimer, [](uv_timer_t *timer) {
-#endif
-        std::unique_ptr<RetryBaton> pair { static_cast<RetryBaton *>(timer->data) };
-        pair->first->startHTTPRequest(std::move(pair->second));
-        pair->first->backoffTimer = nullptr;
-        uv_timer_stop(timer);
-        uv_close((uv_handle_t *)timer, [](uv_handle_t *handle) { delete (uv_timer_t *)handle; });
-    }, timeout, 0);
+    // Spread out the retries of requests that failed at the same time, e.g. because the server
+    // was overloaded, so that they don't hit it again all at once.
+    scheduleRetry(timeout / 2 + randomDelay(timeout / 2));
+}
+
+void HTTPRequest::scheduleRetry(uint64_t timeout) {
+    retryTimer = timers->schedule(timeout, [this] {
+        // The request may schedule another retry right away.
+        retryTimer = 0;
+        startHTTPRequest(std::move(retryResponse));
+    });
 }
 
 void HTTPRequest::removeHTTPBaton() {
     assert(std::this_thread::get_id() == threadId);
     if (httpBaton) {
+        if (counters) {
+            counters->bandwidth.finish(util::now(), 0);
+        }
+        removeProgressAsync();
         httpBaton->request = nullptr;
         HTTPRequestBaton::stop(httpBaton);
         httpBaton.reset();
     }
 }
 
+void HTTPRequest::removeProgressAsync() {
+    assert(std::this_thread::get_id() == threadId);
+    assert(httpBaton);
+
+    // The implementation may still be writing to the baton. Once the handle is gone, it drops the
+    // parts; they are in the complete response anyway.
+    std::lock_guard<std::mutex> lock(httpBaton->progressMutex);
+    if (httpBaton->progressAsync) {
+        uv_close((uv_handle_t *)httpBaton->progressAsync, [](uv_handle_t *handle) {
+            delete (uv_async_t *)handle;
+        });
+        httpBaton->progressAsync = nullptr;
+        httpBaton->progressData.clear();
+    }
+}
+
 void HTTPRequest::removeCacheBaton() {
     assert(std::this_thread::get_id() == threadId);
     if (cacheBaton) {
@@ -236,27 +488,41 @@ void HTTPRequest::removeCacheBaton() {
 
 void HTTPRequest::removeBackoffTimer() {
     assert(std::this_thread::get_id() == threadId);
-    if (backoffTimer) {
-        delete static_cast<RetryBaton *>(backoffTimer->data);
-        uv_timer_stop(backoffTimer);
-        uv_close((uv_handle_t *)backoffTimer, [](uv_handle_t *handle) { delete (uv_timer_t *)handle; });
-        backoffTimer = nullptr;
+    if (retryTimer) {
+        timers->cancel(retryTimer);
+        retryTimer = 0;
+        retryResponse.reset();
+    }
+}
+
+void HTTPRequest::setPriority(float priority_) {
+    assert(std::this_thread::get_id() == threadId);
+    priority = priority_;
+    if (httpBaton) {
+        // Only takes effect if the request is still waiting for a free connection.
+        httpBaton->priority = priority;
+    }
+}
+
+void HTTPRequest::startProgress() {
+    assert(std::this_thread::get_id() == threadId);
+    progress = true;
+    if (httpBaton) {
+        // Takes effect with the next part of the body that arrives.
+        httpBaton->progress = true;
     }
 }
 
 void HTTPRequest::retryImmediately() {
     assert(std::this_thread::get_id() == threadId);
     if (!cacheBaton && !httpBaton) {
-        if (backoffTimer) {
-            // Retry immediately.
-            uv_timer_stop(backoffTimer);
-            std::unique_ptr<RetryBaton> pair { static_cast<RetryBaton *>(backoffTimer->data) };
-            assert(pair->first == this);
-            startHTTPRequest(std::move(pair->second));
-            uv_close((uv_handle_t *)backoffTimer, [](uv_handle_t *handle) { delete (uv_timer_t *)handle; });
-            backoffTimer = nullptr;
+        if (retryTimer) {
+            // Retry soon. All waiting requests are woken up at the same time, so we don't start
+            // them all at once.
+            timers->cancel(retryTimer);
+            scheduleRetry(1 + randomDelay(ReachabilityRetryWindow));
         } else {
-            assert(!"We should always have a backoffTimer when there are no batons");
+            assert(!"We should always have a retry timer when there are no batons");
         }
     }
 }
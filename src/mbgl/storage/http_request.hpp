@@ -4,6 +4,7 @@
 #include <mbgl/storage/resource_type.hpp>
 #include <mbgl/storage/base_request.hpp>
 #include <mbgl/storage/http_request_baton.hpp>
+#include <mbgl/storage/timer_wheel.hpp>
 
 #include <string>
 #include <memory>
@@ -11,7 +12,6 @@
 #include <thread>
 
 typedef struct uv_loop_s uv_loop_t;
-typedef struct uv_timer_s uv_timer_t;
 
 namespace mbgl {
 
@@ -19,36 +19,65 @@ struct CacheRequestBaton;
 struct HTTPRequestBaton;
 struct CacheEntry;
 class SQLiteStore;
+struct RequestCounters;
 
 class HTTPRequest : public BaseRequest {
 public:
-    HTTPRequest(ResourceType type, const std::string &path, uv_loop_t *loop, util::ptr<SQLiteStore> store);
+    HTTPRequest(ResourceType type, const std::string &path, uv_loop_t *loop, util::ptr<TimerWheel> timers,
+                util::ptr<SQLiteStore> store, util::ptr<RequestCounters> counters = nullptr,
+                bool networkEnabled = true);
     ~HTTPRequest();
 
     void cancel();
     void retryImmediately();
+    void setPriority(float priority);
+    void startProgress();
 
 private:
     void startCacheRequest();
     void handleCacheResponse(std::unique_ptr<Response> &&response);
+    void startCacheDataRequest(std::unique_ptr<Response> &&res, bool revalidate);
+    void handleCacheDataResponse(std::unique_ptr<Response> &&res, std::unique_ptr<Response> &&cached,
+                                 bool revalidate);
+    void revalidateStale(std::unique_ptr<Response> &&res);
     void startHTTPRequest(std::unique_ptr<Response> &&res);
     void handleHTTPResponse(HTTPResponseType responseType, std::unique_ptr<Response> &&response);
 
     void retryHTTPRequest(std::unique_ptr<Response> &&res, uint64_t timeout);
+    // Starts the request in retryResponse again after the timeout.
+    void scheduleRetry(uint64_t timeout);
+    void failFast(std::unique_ptr<Response> &&res, uint64_t wait);
 
     void removeCacheBaton();
     void removeHTTPBaton();
+    void removeProgressAsync();
     void removeBackoffTimer();
 
+    // Adds the time since phaseStart to the total of the phase.
+    void finishCachePhase();
+    // /bytes/ is the size of the data that arrived, if any.
+    void finishNetworkPhase(size_t bytes);
+
 private:
     const std::thread::id threadId;
     uv_loop_t *const loop;
     CacheRequestBaton *cacheBaton = nullptr;
     util::ptr<HTTPRequestBaton> httpBaton;
-    uv_timer_t *backoffTimer = nullptr;
+    // Retries wait on the wheel that all requests of the file source share.
+    util::ptr<TimerWheel> timers;
+    TimerWheel::ID retryTimer = 0;
+    std::unique_ptr<Response> retryResponse;
     util::ptr<SQLiteStore> store;
+    util::ptr<RequestCounters> counters;
     const ResourceType type;
+    const bool networkEnabled;
+    // Used to look up the health of the server in the CircuitBreaker.
+    const std::string host;
     uint8_t attempts = 0;
+    float priority = 0;
+    bool progress = false;
+    // When the pending cache read or HTTP request started.
+    timestamp phaseStart = 0;
 
     friend struct HTTPRequestBaton;
 };
@@ -3,7 +3,7 @@
 
 namespace mbgl {
 
-HTTPRequestBaton::HTTPRequestBaton(const std::string &path_) : threadId(std::this_thread::get_id()), path(path_) {
+HTTPRequestBaton::HTTPRequestBaton(const std::string &path_) : threadId(std::this_thread::get_id()), path(path_), priority(0) {
 }
 
 HTTPRequestBaton::~HTTPRequestBaton() {
@@ -0,0 +1,295 @@
+#include <mbgl/storage/mbtiles_source.hpp>
+#include <mbgl/storage/base_request.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/compression.hpp>
+#include <mbgl/util/sqlite3.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <mbgl/util/uv-worker.h>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <unordered_map>
+
+using namespace mapbox::sqlite;
+
+namespace mbgl {
+
+struct MBTilesSource::Connections {
+    // Only used on the worker thread. Files that failed to open are stored as nullptr so that we
+    // don't retry them over and over again.
+    std::unordered_map<std::string, std::unique_ptr<Database>> databases;
+
+    Database *get(const std::string &file) {
+        auto it = databases.find(file);
+        if (it == databases.end()) {
+            std::unique_ptr<Database> db;
+            try {
+                db = util::make_unique<Database>(file, ReadOnly);
+                // Let SQLite read pages through a memory map instead of copying them into its
+                // page cache.
+                db->exec("PRAGMA mmap_size = 268435456");
+            } catch (const std::exception &) {
+                db.reset();
+            }
+            it = databases.emplace(file, std::move(db)).first;
+        }
+        return it->second.get();
+    }
+};
+
+class MBTilesRequest;
+
+struct MBTilesRequestBaton {
+    MBTilesRequest *request = nullptr;
+    util::ptr<MBTilesSource::Connections> connections;
+    std::string file;
+    bool tile = false;
+    int32_t z = 0, x = 0, y = 0;
+    std::unique_ptr<Response> response;
+};
+
+class MBTilesRequest : public BaseRequest {
+public:
+    MBTilesRequest(const std::string &path, uv_worker_t *worker,
+                   const util::ptr<MBTilesSource::Connections> &connections);
+    ~MBTilesRequest();
+
+    void cancel();
+
+private:
+    static void run(void *data);
+    static void after(void *data);
+
+    static void loadTile(Database &db, MBTilesRequestBaton &baton);
+    static void loadTileJSON(Database &db, MBTilesRequestBaton &baton);
+
+    MBTilesRequestBaton *ptr = nullptr;
+};
+
+// Splits "/path/file.mbtiles/z/x/y.ext" into the file and the tile coordinate. Returns false when
+// the path doesn't end in a tile coordinate.
+bool parseTilePath(const std::string &path, std::string &file, int32_t &z, int32_t &x, int32_t &y) {
+    int32_t coords[3];
+    size_t end = path.size();
+
+    // Strip the file extension of the y coordinate.
+    const size_t slash = path.rfind('/');
+    const size_t dot = path.rfind('.');
+    if (slash != std::string::npos && dot != std::string::npos && dot > slash) {
+        end = dot;
+    }
+
+    for (int i = 2; i >= 0; i--) {
+        if (end == 0) {
+            return false;
+        }
+        const size_t separator = path.rfind('/', end - 1);
+        if (separator == std::string::npos || separator + 1 >= end) {
+            return false;
+        }
+        const std::string component = path.substr(separator + 1, end - separator - 1);
+        char *component_end = nullptr;
+        const long value = std::strtol(component.c_str(), &component_end, 10);
+        if (*component_end != '\0' || value < 0) {
+            return false;
+        }
+        coords[i] = int32_t(value);
+        end = separator;
+    }
+
+    file = path.substr(0, end);
+    z = coords[0];
+    x = coords[1];
+    y = coords[2];
+    return !file.empty();
+}
+
+MBTilesRequest::MBTilesRequest(const std::string &path_, uv_worker_t *worker,
+                               const util::ptr<MBTilesSource::Connections> &connections)
+    : BaseRequest(path_) {
+    ptr = new MBTilesRequestBaton;
+    ptr->request = this;
+    ptr->connections = connections;
+    ptr->tile = parseTilePath(path, ptr->file, ptr->z, ptr->x, ptr->y);
+    if (!ptr->tile) {
+        ptr->file = path;
+    }
+
+    // Note: The MBTilesRequestBaton object is deleted in MBTilesRequest::after().
+    uv_worker_send(worker, ptr, run, after);
+}
+
+MBTilesRequest::~MBTilesRequest() {
+    assert(std::this_thread::get_id() == threadId);
+    cancel();
+}
+
+void MBTilesRequest::cancel() {
+    assert(std::this_thread::get_id() == threadId);
+
+    if (ptr) {
+        // The lookup may already be running; make sure that its result doesn't reference this
+        // object anymore.
+        ptr->request = nullptr;
+        ptr = nullptr;
+    }
+
+    notify();
+}
+
+void MBTilesRequest::run(void *data) {
+    MBTilesRequestBaton &baton = *reinterpret_cast<MBTilesRequestBaton *>(data);
+    baton.response = util::make_unique<Response>();
+
+    Database *db = baton.connections->get(baton.file);
+    if (!db) {
+        baton.response->code = 404;
+        baton.response->message = "Could not open MBTiles file " + baton.file;
+        return;
+    }
+
+    try {
+        if (baton.tile) {
+            loadTile(*db, baton);
+        } else {
+            loadTileJSON(*db, baton);
+        }
+    } catch (const std::exception &ex) {
+        baton.response->code = 500;
+        baton.response->message = ex.what();
+        baton.response->data = std::make_shared<const std::string>();
+    }
+}
+
+void MBTilesRequest::loadTile(Database &db, MBTilesRequestBaton &baton) {
+    if (baton.z > 30 || baton.x >= (1 << baton.z) || baton.y >= (1 << baton.z)) {
+        baton.response->code = 404;
+        return;
+    }
+
+    Statement &stmt = db.prepareCached("SELECT `tile_data` FROM `tiles` "
+        "WHERE `zoom_level` = ? AND `tile_column` = ? AND `tile_row` = ?");
+    stmt.bind(1, int(baton.z));
+    stmt.bind(2, int(baton.x));
+    // MBTiles uses the TMS scheme, which counts rows from the south.
+    stmt.bind(3, int((1 << baton.z) - 1 - baton.y));
+
+    std::string data;
+    if (stmt.run()) {
+        baton.response->code = 200;
+
+        // Vector tiles in MBTiles files are gzipped; HTTP responses arrive already inflated. We
+        // inflate straight out of SQLite's copy of the row.
+        size_t size = 0;
+        const char *blob = stmt.getBlob(0, size);
+        if (size >= 2 && uint8_t(blob[0]) == 0x1F && uint8_t(blob[1]) == 0x8B) {
+            try {
+                data = util::decompress(blob, size);
+            } catch (...) {
+                stmt.reset();
+                throw;
+            }
+        } else {
+            data.assign(blob, size);
+        }
+    } else {
+        baton.response->code = 404;
+    }
+    stmt.reset();
+
+    baton.response->data = std::make_shared<const std::string>(std::move(data));
+}
+
+void MBTilesRequest::loadTileJSON(Database &db, MBTilesRequestBaton &baton) {
+    std::unordered_map<std::string, std::string> metadata;
+    Statement &stmt = db.prepareCached("SELECT `name`, `value` FROM `metadata`");
+    while (stmt.run()) {
+        metadata.emplace(stmt.get<std::string>(0), stmt.get<std::string>(1));
+    }
+    stmt.reset();
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+
+    writer.String("tiles");
+    writer.StartArray();
+    const std::string tiles = "mbtiles://" + baton.file + "/{z}/{x}/{y}";
+    writer.String(tiles.c_str(), rapidjson::SizeType(tiles.size()));
+    writer.EndArray();
+
+    for (const char *key : { "minzoom", "maxzoom" }) {
+        auto it = metadata.find(key);
+        if (it != metadata.end()) {
+            writer.String(key);
+            writer.Uint(unsigned(std::atoi(it->second.c_str())));
+        }
+    }
+
+    // bounds and center are comma-separated lists of numbers.
+    for (const char *key : { "bounds", "center" }) {
+        auto it = metadata.find(key);
+        if (it != metadata.end()) {
+            writer.String(key);
+            writer.StartArray();
+            const char *value = it->second.c_str();
+            char *end = nullptr;
+            while (*value) {
+                writer.Double(std::strtod(value, &end));
+                if (end == value) {
+                    break;
+                }
+                value = *end == ',' ? end + 1 : end;
+            }
+            writer.EndArray();
+        }
+    }
+
+    auto attribution = metadata.find("attribution");
+    if (attribution != metadata.end()) {
+        writer.String("attribution");
+        writer.String(attribution->second.c_str(), rapidjson::SizeType(attribution->second.size()));
+    }
+
+    writer.EndObject();
+
+    baton.response->code = 200;
+    baton.response->data = std::make_shared<const std::string>(buffer.GetString(), buffer.Size());
+}
+
+void MBTilesRequest::after(void *data) {
+    std::unique_ptr<MBTilesRequestBaton> baton { reinterpret_cast<MBTilesRequestBaton *>(data) };
+    MBTilesRequest *request = baton->request;
+    if (request) {
+        assert(std::this_thread::get_id() == request->threadId);
+        request->ptr = nullptr;
+        request->response = std::move(baton->response);
+        request->notify();
+    }
+}
+
+MBTilesSource::MBTilesSource(uv_loop_t *loop_)
+    : threadId(std::this_thread::get_id()),
+      loop(loop_),
+      connections(std::make_shared<Connections>()) {
+    worker = new uv_worker_t;
+    uv_worker_init(worker, loop, 1, "MBTiles");
+}
+
+MBTilesSource::~MBTilesSource() {
+    assert(std::this_thread::get_id() == threadId);
+    uv_worker_close(worker, [](uv_worker_t *worker_handle) {
+        delete worker_handle;
+    });
+}
+
+util::ptr<BaseRequest> MBTilesSource::request(const std::string &path) {
+    assert(std::this_thread::get_id() == threadId);
+    return std::make_shared<MBTilesRequest>(path, worker, connections);
+}
+
+}
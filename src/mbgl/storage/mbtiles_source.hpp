@@ -0,0 +1,43 @@
+#ifndef MBGL_STORAGE_MBTILES_SOURCE
+#define MBGL_STORAGE_MBTILES_SOURCE
+
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/ptr.hpp>
+
+#include <string>
+#include <thread>
+
+typedef struct uv_loop_s uv_loop_t;
+typedef struct uv_worker_s uv_worker_t;
+
+namespace mbgl {
+
+class BaseRequest;
+
+// Serves mbtiles:// URLs straight out of MBTiles files, without going through the HTTP cache.
+//
+//   mbtiles:///path/to/file.mbtiles             TileJSON generated from the metadata table
+//   mbtiles:///path/to/file.mbtiles/{z}/{x}/{y} A single tile by its XYZ coordinate
+//
+// A file extension on the last tile coordinate (e.g. ".pbf") is ignored. Files are opened on
+// first use and stay memory-mapped for the lifetime of this object.
+class MBTilesSource : private util::noncopyable {
+public:
+    MBTilesSource(uv_loop_t *loop);
+    ~MBTilesSource();
+
+    // Takes the URL without the mbtiles:// prefix.
+    util::ptr<BaseRequest> request(const std::string &path);
+
+    struct Connections;
+
+private:
+    const std::thread::id threadId;
+    uv_loop_t *loop = nullptr;
+    uv_worker_t *worker = nullptr;
+    util::ptr<Connections> connections;
+};
+
+}
+
+#endif
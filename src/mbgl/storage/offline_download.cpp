@@ -0,0 +1,262 @@
+#include <mbgl/storage/offline_download.hpp>
+#include <mbgl/storage/caching_http_file_source.hpp>
+#include <mbgl/storage/request.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/style/style.hpp>
+#include <mbgl/style/style_bucket.hpp>
+#include <mbgl/style/style_layer.hpp>
+#include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/style/style_source.hpp>
+#include <mbgl/text/glyph.hpp>
+#include <mbgl/platform/log.hpp>
+#include <mbgl/util/box.hpp>
+#include <mbgl/util/constants.hpp>
+#include <mbgl/util/math.hpp>
+#include <mbgl/util/string.hpp>
+#include <mbgl/util/token.hpp>
+#include <mbgl/util/url.hpp>
+
+#include <rapidjson/document.h>
+
+#include <cassert>
+#include <cmath>
+#include <set>
+
+namespace mbgl {
+
+// Projects a coordinate to fractional tile coordinates at zoom level z.
+vec2<double> projectToTile(double lon, double lat, int32_t z) {
+    const double scale = std::pow(2, z);
+    const double sine = std::sin(util::clamp(lat, -85.0511, 85.0511) * M_PI / 180);
+    return {
+        (lon + 180) / 360 * scale,
+        (0.5 - 0.25 * std::log((1 + sine) / (1 - sine)) / M_PI) * scale
+    };
+}
+
+OfflineDownload::OfflineDownload(CachingHTTPFileSource &fileSource_, const OfflineRegion &region_,
+                                 ProgressCallback callback_, size_t maxConcurrentRequests_)
+    : threadId(std::this_thread::get_id()),
+      fileSource(fileSource_),
+      region(region_),
+      callback(callback_),
+      maxConcurrentRequests(maxConcurrentRequests_ > 0 ? maxConcurrentRequests_ : 1) {
+    const size_t pos = region.styleURL.rfind('/');
+    if (pos != std::string::npos) {
+        base = region.styleURL.substr(0, pos + 1);
+    }
+}
+
+OfflineDownload::~OfflineDownload() {
+    cancel();
+}
+
+void OfflineDownload::start() {
+    assert(std::this_thread::get_id() == threadId);
+    if (started) {
+        return;
+    }
+
+    started = true;
+    add(Kind::Style, ResourceType::JSON, region.styleURL);
+    pump();
+}
+
+void OfflineDownload::cancel() {
+    assert(std::this_thread::get_id() == threadId);
+    queue.clear();
+    for (const std::unique_ptr<Request> &req : active) {
+        req->cancel();
+    }
+    active.clear();
+}
+
+const OfflineDownload::Progress &OfflineDownload::getProgress() const {
+    return progress;
+}
+
+void OfflineDownload::add(Kind kind, ResourceType type, const std::string &url,
+                          const util::ptr<StyleSource> &source) {
+    // Resolve URLs relative to the style, like the map does.
+    const std::string absolute = url.find("://") == std::string::npos ? base + url : url;
+    queue.emplace_back(kind, type, absolute, source, Tile::ID(0, 0, 0));
+    progress.requiredResources++;
+}
+
+void OfflineDownload::addTiles(const util::ptr<StyleSource> &source) {
+    const SourceInfo &info = source->info;
+    if (info.type != SourceType::Vector && info.type != SourceType::Raster) {
+        return;
+    }
+
+    // Same as Source::getZoom(): the map loads tiles at a higher zoom level when they're smaller
+    // than our tile size, or when it has to scale up raster tiles on a high resolution screen.
+    const double offset = info.getZoomOffset(region.pixelRatio);
+    const int32_t minZoom = std::max<int32_t>(info.min_zoom, std::floor(region.minZoom + offset));
+    const int32_t maxZoom = std::min<int32_t>(info.max_zoom, std::floor(region.maxZoom + offset));
+
+    // Don't request tiles outside of the bounds that the source advertises.
+    const double west = std::max<double>(region.west, info.bounds[0]);
+    const double south = std::max<double>(region.south, info.bounds[1]);
+    const double east = std::min<double>(region.east, info.bounds[2]);
+    const double north = std::min<double>(region.north, info.bounds[3]);
+    if (west >= east || south >= north) {
+        return;
+    }
+
+    for (int32_t z = minZoom; z <= maxZoom; z++) {
+        box bounds;
+        bounds.tl = projectToTile(west, north, z);
+        bounds.tr = projectToTile(east, north, z);
+        bounds.br = projectToTile(east, south, z);
+        bounds.bl = projectToTile(west, south, z);
+        bounds.center = projectToTile((west + east) / 2, (south + north) / 2, z);
+
+        // The cover may contain the same tile more than once.
+        std::set<Tile::ID> ids;
+        const int32_t dim = 1 << z;
+        for (const Tile::ID &id : Tile::cover(z, bounds)) {
+            if (id.x >= 0 && id.x < dim && id.y >= 0 && id.y < dim && ids.insert(id).second) {
+                queue.emplace_back(Kind::Tile, ResourceType::Tile, "", source, id);
+                progress.requiredResources++;
+            }
+        }
+    }
+}
+
+void OfflineDownload::pump() {
+    // Requests may complete synchronously, e.g. when the response is cached in memory, in which
+    // case we're called again from within the loop below.
+    if (pumping) {
+        return;
+    }
+
+    pumping = true;
+    while (active.size() < maxConcurrentRequests && !queue.empty()) {
+        const Resource resource = queue.front();
+        queue.pop_front();
+
+        const std::string url = resource.kind == Kind::Tile
+            ? resource.source->info.tileURL(resource.id, region.pixelRatio)
+            : resource.url;
+
+        active.emplace_front(fileSource.request(resource.type, url));
+        auto it = active.begin();
+        (*it)->setPriority(OfflineRequestPriority);
+        (*it)->onload([this, it, resource, url](const Response &res) {
+            if (res.stale) {
+                // We're only done once the expired resource was revalidated.
+                return;
+            }
+            active.erase(it);
+            finish(resource, url, res);
+        });
+    }
+    pumping = false;
+}
+
+void OfflineDownload::finish(const Resource &resource, const std::string &url, const Response &res) {
+    assert(std::this_thread::get_id() == threadId);
+
+    bool success = res.code == 200;
+    if (success) {
+        fileSource.pin(resource.type, url);
+        progress.completedBytes += res.data->size();
+
+        if (resource.kind == Kind::Style) {
+            success = parseStyle(*res.data);
+        } else if (resource.kind == Kind::TileJSON) {
+            success = parseTileJSON(resource.source, *res.data);
+        }
+    } else {
+        Log::Warning(Event::HttpRequest, "offline download of %s failed: %ld %s",
+                     url.c_str(), res.code, res.message.c_str());
+    }
+
+    if (success) {
+        progress.completedResources++;
+    } else {
+        progress.failedResources++;
+    }
+
+    progress.complete = queue.empty() && active.empty();
+    if (callback) {
+        callback(progress);
+    }
+
+    pump();
+}
+
+bool OfflineDownload::parseStyle(const std::string &data) {
+    Style style;
+    try {
+        style.loadJSON((const uint8_t *)data.c_str());
+    } catch (const std::exception &ex) {
+        Log::Warning(Event::ParseStyle, "offline download failed to parse style: %s", ex.what());
+        return false;
+    }
+
+    // Collect everything that the layers reference, the same way Map::updateSources() does.
+    std::set<util::ptr<StyleSource>> sources;
+    std::set<std::string> fontStacks;
+    if (style.layers) {
+        for (const util::ptr<StyleLayer> &layer : style.layers->layers) {
+            if (!layer || !layer->bucket) continue;
+            if (layer->bucket->style_source) {
+                sources.insert(layer->bucket->style_source);
+            }
+            if (layer->bucket->render.is<StyleBucketSymbol>()) {
+                const StyleBucketSymbol &symbol = layer->bucket->render.get<StyleBucketSymbol>();
+                if (!symbol.text.field.empty() && !symbol.text.font.empty()) {
+                    fontStacks.insert(symbol.text.font);
+                }
+            }
+        }
+    }
+
+    const std::string &spriteURL = style.getSpriteURL();
+    if (!spriteURL.empty()) {
+        const std::string ratio = region.pixelRatio > 1 ? "@2x" : "";
+        add(Kind::Other, ResourceType::JSON, spriteURL + ratio + ".json");
+        add(Kind::Other, ResourceType::Image, spriteURL + ratio + ".png");
+    }
+
+    // We can't know which glyphs the labels in the region will use, so we get all of the BMP.
+    if (!style.glyph_url.empty()) {
+        for (const std::string &fontStack : fontStacks) {
+            for (uint32_t start = 0; start <= 65280; start += 256) {
+                const GlyphRange range = getGlyphRange(start);
+                add(Kind::Other, ResourceType::Glyphs, util::replaceTokens(style.glyph_url, [&](const std::string &name) -> std::string {
+                    if (name == "fontstack") return util::percentEncode(fontStack);
+                    if (name == "range") return util::toString(range.first) + "-" + util::toString(range.second);
+                    return "";
+                }));
+            }
+        }
+    }
+
+    for (const util::ptr<StyleSource> &source : sources) {
+        if (!source->info.url.empty()) {
+            add(Kind::TileJSON, ResourceType::JSON, source->info.url, source);
+        } else {
+            addTiles(source);
+        }
+    }
+
+    return true;
+}
+
+bool OfflineDownload::parseTileJSON(const util::ptr<StyleSource> &source, const std::string &data) {
+    rapidjson::Document d;
+    d.Parse<0>(data.c_str());
+    if (d.HasParseError()) {
+        Log::Warning(Event::General, "offline download got invalid source TileJSON");
+        return false;
+    }
+
+    source->info.parseTileJSONProperties(d);
+    addTiles(source);
+    return true;
+}
+
+}
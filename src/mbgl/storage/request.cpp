@@ -35,6 +35,16 @@ void Request::oncancel(AbortedCallback cb) {
     }
 }
 
+void Request::onprogress(ProgressCallback cb) {
+    assert(thread_id == std::this_thread::get_id());
+    if (base) {
+        Callback *callback = base->add(std::move(cb), base);
+        if (callback) {
+            callbacks.push_front(callback);
+        }
+    }
+}
+
 void Request::cancel() {
     assert(thread_id == std::this_thread::get_id());
     if (base) {
@@ -46,4 +56,11 @@ void Request::cancel() {
     callbacks.clear();
 }
 
+void Request::setPriority(float priority) {
+    assert(thread_id == std::this_thread::get_id());
+    if (base) {
+        base->setPriority(priority);
+    }
+}
+
 }
@@ -0,0 +1,27 @@
+#ifndef MBGL_STORAGE_REQUEST_COUNTERS
+#define MBGL_STORAGE_REQUEST_COUNTERS
+
+#include <mbgl/storage/bandwidth_estimator.hpp>
+#include <mbgl/util/latency_histogram.hpp>
+
+#include <atomic>
+#include <cstdint>
+
+namespace mbgl {
+
+// Updated on the file source's loop, but may be read from any thread.
+struct RequestCounters {
+    std::atomic<uint64_t> requests { 0 };
+    std::atomic<uint64_t> coalesced { 0 };
+    std::atomic<uint64_t> cacheHits { 0 };
+    std::atomic<uint64_t> cacheMisses { 0 };
+
+    LatencyHistogram cacheLatency;
+    LatencyHistogram networkLatency;
+
+    BandwidthEstimator bandwidth;
+};
+
+}
+
+#endif
@@ -0,0 +1,352 @@
+#include <mbgl/storage/shared_file_source.hpp>
+#include <mbgl/storage/base_request.hpp>
+#include <mbgl/storage/request.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/uv-messenger.h>
+#include <mbgl/util/uv_detail.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <uv.h>
+
+#include <cassert>
+#include <future>
+#include <mutex>
+
+namespace mbgl {
+
+class SharedRequest;
+
+// Delivers functions to the loop of a Client. Requests on the shared thread may still try to
+// deliver their response after the Client cleared its loop.
+struct SharedMailbox {
+    std::mutex mtx;
+    uv_messenger_t *queue = nullptr;
+
+    // Only used on the Client's thread. The loop is kept alive while requests are in flight, since
+    // nothing else on it is waiting for them.
+    size_t active = 0;
+
+    void send(std::function<void()> fn) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (queue) {
+            uv_messenger_send(queue, new std::function<void()>(std::move(fn)));
+        }
+    }
+
+    void ref() {
+        if (active++ == 0 && queue) {
+            uv_messenger_ref(queue);
+        }
+    }
+
+    void unref() {
+        assert(active > 0);
+        if (--active == 0 && queue) {
+            uv_messenger_unref(queue);
+        }
+    }
+};
+
+struct SharedRequestBaton {
+    inline SharedRequestBaton(SharedRequest *request_, const util::ptr<SharedMailbox> &mailbox_)
+        : request(request_), mailbox(mailbox_) {}
+
+    // Only used on the Client's thread.
+    SharedRequest *request = nullptr;
+
+    // Only used on the shared thread.
+    std::unique_ptr<Request> upstream;
+    bool done = false;
+
+    const util::ptr<SharedMailbox> mailbox;
+};
+
+class SharedRequest : public BaseRequest {
+public:
+    SharedRequest(ResourceType type, const std::string &path, SharedFileSource &shared,
+                  const util::ptr<SharedMailbox> &mailbox);
+    ~SharedRequest();
+
+    void cancel();
+    void setPriority(float priority);
+
+    // Called on the Client's thread with every response of the upstream request.
+    static void receive(const util::ptr<SharedRequestBaton> &baton, const Response &res);
+
+private:
+    SharedFileSource &shared;
+    util::ptr<SharedRequestBaton> baton;
+};
+
+SharedRequest::SharedRequest(ResourceType type, const std::string &path_, SharedFileSource &shared_,
+                             const util::ptr<SharedMailbox> &mailbox)
+    : BaseRequest(path_), shared(shared_), baton(std::make_shared<SharedRequestBaton>(this, mailbox)) {
+    mailbox->ref();
+
+    SharedFileSource &source = shared;
+    const util::ptr<SharedRequestBaton> ptr = baton;
+    const std::string url = path;
+    shared.invoke([&source, ptr, type, url]() {
+        source.start(ptr, type, url);
+    });
+}
+
+SharedRequest::~SharedRequest() {
+    assert(std::this_thread::get_id() == threadId);
+    cancel();
+}
+
+void SharedRequest::cancel() {
+    assert(std::this_thread::get_id() == threadId);
+
+    if (baton) {
+        // The response may already be on its way; make sure that it doesn't reference this object.
+        baton->request = nullptr;
+        baton->mailbox->unref();
+
+        SharedFileSource &source = shared;
+        const util::ptr<SharedRequestBaton> ptr = baton;
+        shared.invoke([&source, ptr]() {
+            source.stop(ptr);
+        });
+        baton.reset();
+    }
+
+    notify();
+}
+
+void SharedRequest::setPriority(float priority) {
+    assert(std::this_thread::get_id() == threadId);
+
+    if (baton) {
+        const util::ptr<SharedRequestBaton> ptr = baton;
+        shared.invoke([ptr, priority]() {
+            if (ptr->upstream) {
+                ptr->upstream->setPriority(priority);
+            }
+        });
+    }
+}
+
+void SharedRequest::receive(const util::ptr<SharedRequestBaton> &baton, const Response &res) {
+    SharedRequest *request = baton->request;
+    if (!request) {
+        // The request was canceled in the meantime.
+        return;
+    }
+
+    assert(std::this_thread::get_id() == request->threadId);
+
+    if (res.stale) {
+        request->stale = util::make_unique<Response>(res);
+        request->notifyStale();
+        // Note: after calling notifyStale(), the request object may cease to exist.
+    } else {
+        baton->request = nullptr;
+        baton->mailbox->unref();
+        request->baton.reset();
+        request->response = util::make_unique<Response>(res);
+        request->notify();
+        // Note: after calling notify(), the request object may cease to exist.
+    }
+}
+
+SharedFileSource::SharedFileSource(const std::string &path_) : path(path_) {
+    std::promise<void> ready;
+    thread = std::thread([this, &ready]() {
+        uv::loop loop;
+
+        fileSource = util::make_unique<CachingHTTPFileSource>(path);
+        fileSource->setLoop(*loop);
+
+        // Keeps the loop running until we're destroyed.
+        asyncTerminate = util::make_unique<uv::async>(*loop, [this]() {
+            while (!active.empty()) {
+                const util::ptr<SharedRequestBaton> baton = *active.begin();
+                stop(baton);
+            }
+            fileSource->clearLoop();
+            asyncTerminate.reset();
+        });
+
+        ready.set_value();
+        uv_run(*loop, UV_RUN_DEFAULT);
+
+        fileSource.reset();
+    });
+
+    // Requests can only be forwarded once the file source has its loop.
+    ready.get_future().wait();
+}
+
+SharedFileSource::~SharedFileSource() {
+    asyncTerminate->send();
+    thread.join();
+}
+
+void SharedFileSource::invoke(std::function<void()> fn) {
+    fileSource->prepare(std::move(fn));
+}
+
+void SharedFileSource::setAccessToken(std::string value) {
+    invoke([this, value]() {
+        fileSource->setAccessToken(value);
+    });
+}
+
+void SharedFileSource::releaseMemory() {
+    invoke([this]() {
+        fileSource->releaseMemory();
+    });
+}
+
+void SharedFileSource::setReachability(bool reachable) {
+    fileSource->setReachability(reachable);
+}
+
+FileSourceStatistics SharedFileSource::getStatistics() const {
+    FileSourceStatistics statistics = fileSource->getStatistics();
+    statistics.requests += requests;
+    statistics.coalesced += coalesced;
+    return statistics;
+}
+
+void SharedFileSource::start(const util::ptr<SharedRequestBaton> &baton, ResourceType type,
+                             const std::string &url) {
+    if (baton->done) {
+        // The request was canceled before it got here.
+        return;
+    }
+
+    std::unique_ptr<Request> req = fileSource->request(type, url);
+    active.insert(baton);
+
+    // The callback may be called right away if the response is already there.
+    req->onload([this, baton](const Response &res) {
+        if (!res.stale) {
+            baton->done = true;
+            active.erase(baton);
+            baton->upstream.reset();
+        }
+
+        const util::ptr<SharedRequestBaton> ptr = baton;
+        const Response copy = res;
+        baton->mailbox->send([ptr, copy]() {
+            SharedRequest::receive(ptr, copy);
+        });
+    });
+
+    if (!baton->done) {
+        baton->upstream = std::move(req);
+    }
+}
+
+void SharedFileSource::stop(const util::ptr<SharedRequestBaton> &baton) {
+    baton->done = true;
+    if (baton->upstream) {
+        baton->upstream->cancel();
+        baton->upstream.reset();
+    }
+    active.erase(baton);
+}
+
+SharedFileSource::Client::Client(SharedFileSource &shared_)
+    : shared(shared_), mailbox(std::make_shared<SharedMailbox>()) {
+}
+
+SharedFileSource::Client::~Client() {
+    if (loop) {
+        clearLoop();
+    }
+}
+
+void SharedFileSource::Client::setLoop(uv_loop_t *loop_) {
+    assert(!loop);
+
+    threadId = std::this_thread::get_id();
+    loop = loop_;
+
+    std::lock_guard<std::mutex> lock(mailbox->mtx);
+    mailbox->queue = new uv_messenger_t;
+    uv_messenger_init(loop, mailbox->queue, [](void *ptr) {
+        std::unique_ptr<std::function<void()>> fn { reinterpret_cast<std::function<void()> *>(ptr) };
+        (*fn)();
+    });
+    if (mailbox->active == 0) {
+        uv_messenger_unref(mailbox->queue);
+    }
+}
+
+bool SharedFileSource::Client::hasLoop() {
+    return loop;
+}
+
+void SharedFileSource::Client::clearLoop() {
+    assert(std::this_thread::get_id() == threadId);
+    assert(loop);
+
+    // Send a cancel() message to all requests that we are still holding.
+    util::ptr<BaseRequest> req;
+    for (const std::pair<std::string, std::weak_ptr<BaseRequest>> &pair : pending) {
+        if ((req = pair.second.lock())) {
+            req->cancel();
+        }
+    }
+    pending.clear();
+
+    std::lock_guard<std::mutex> lock(mailbox->mtx);
+    uv_messenger_stop(mailbox->queue, [](uv_messenger_t *msgr) {
+        delete msgr;
+    });
+    mailbox->queue = nullptr;
+
+    loop = nullptr;
+}
+
+void SharedFileSource::Client::setBase(std::string value) {
+    // TODO: Make threadsafe.
+    base.swap(value);
+}
+
+std::unique_ptr<Request> SharedFileSource::Client::request(ResourceType type, const std::string &url_) {
+    assert(std::this_thread::get_id() == threadId);
+
+    // Make URL absolute; the shared file source doesn't know our base.
+    const std::string url = url_.find("://") == std::string::npos ? base + url_ : url_;
+
+    util::ptr<BaseRequest> req;
+    auto it = pending.find(url);
+    if (it != pending.end()) {
+        req = it->second.lock();
+    }
+
+    if (req) {
+        shared.requests++;
+        shared.coalesced++;
+    } else {
+        req = std::make_shared<SharedRequest>(type, url, shared, mailbox);
+        pending[url] = req;
+    }
+
+    return util::make_unique<Request>(req);
+}
+
+size_t SharedFileSource::Client::releaseMemory() {
+    shared.releaseMemory();
+    return 0;
+}
+
+uint64_t SharedFileSource::Client::getBandwidth() {
+    // The estimate of the shared file source may be read from any thread.
+    return shared.fileSource->getBandwidth();
+}
+
+void SharedFileSource::Client::prepare(std::function<void()> fn) {
+    if (std::this_thread::get_id() == threadId) {
+        fn();
+    } else {
+        mailbox->send(std::move(fn));
+    }
+}
+
+}
@@ -2,77 +2,461 @@
 #include <mbgl/util/compression.hpp>
 #include <mbgl/util/sqlite3.hpp>
 #include <mbgl/util/std.hpp>
+#include <mbgl/util/allocation_tracker.hpp>
+#include <mbgl/platform/log.hpp>
 
 #include <mbgl/util/uv-worker.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 using namespace mapbox::sqlite;
 
-std::string removeAccessTokenFromURL(const std::string &url) {
-    const size_t token_start = url.find("access_token=");
-    // Ensure that token exists, isn't at the front and is preceded by either & or ?.
-    if (token_start == std::string::npos || token_start == 0 || !(url[token_start - 1] == '&' || url[token_start - 1] == '?')) {
-        return url;
-    }
+namespace mbgl {
 
-    const size_t token_end = url.find_first_of('&', token_start);
-    if (token_end == std::string::npos) {
-        // The token is the last query argument. We slice away the "&access_token=..." part
-        return url.substr(0, token_start - 1);
-    } else {
-        // We slice away the "access_token=...&" part.
-        return url.substr(0, token_start) + url.substr(token_end + 1);
+// Entries are evicted in ascending order of this priority, and least recently used first within
+// the same priority. Glyphs and JSON documents (styles, TileJSON, sprite metadata) are small and
+// expensive to lose, so they outlive tiles and images.
+int evictionPriority(ResourceType type) {
+    switch (type) {
+        case ResourceType::Glyphs:
+        case ResourceType::JSON:
+            return 1;
+        default:
+            return 0;
     }
 }
 
-std::string convertMapboxDomainsToProtocol(const std::string &url) {
-    const size_t protocol_separator = url.find("://");
-    if (protocol_separator == std::string::npos) {
-        return url;
-    }
+int64_t currentTime() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+// Number of entries we look at and evict in one job, so that the worker doesn't stall for long.
+const int evictionBatchSize = 64;
+
+// Number of recorded accesses after which we write them back even if nothing else is written.
+const size_t accessBatchSize = 256;
 
-    const std::string protocol = url.substr(0, protocol_separator);
-    if (!(protocol == "http" || protocol == "https")) {
-        return url;
+// Upper bound for the number of read-only connections, each of which gets its own thread.
+const unsigned maxReaderCount = 4;
+
+// Tiles are stored in their own table, keyed by the id of their source's URL template and their
+// coordinates. That key is far smaller than the URL, compares as integers, and keeps the tiles of
+// a source and zoom level together.
+struct TileURL {
+    std::string pattern;
+    int32_t z = 0, x = 0, y = 0;
+};
+
+struct TileKey {
+    int64_t source = 0;
+    int32_t z = 0, x = 0, y = 0;
+};
+
+// Splits URLs like .../{z}/{x}/{y}.vector.pbf or .../{z}/{x}/{y}@2x.png?style=... into the URL
+// with the placeholders and the coordinates. Returns false for URLs that don't end in three
+// numeric path segments.
+bool parseTileURL(const std::string &url, TileURL &tile) {
+    const size_t end = std::min(url.find('?'), url.size());
+    size_t slashes[3];
+    size_t pos = end;
+    for (size_t &slash : slashes) {
+        if (pos == 0 || (slash = url.rfind('/', pos - 1)) == std::string::npos) {
+            return false;
+        }
+        pos = slash;
     }
 
-    const size_t domain_begin = protocol_separator + 3;
-    const size_t path_separator = url.find("/", domain_begin);
-    if (path_separator == std::string::npos) {
-        return url;
+    int32_t *const values[3] = { &tile.y, &tile.x, &tile.z };
+    size_t yEnd = 0;
+    for (size_t i = 0; i < 3; i++) {
+        const size_t begin = slashes[i] + 1;
+        size_t digits = begin;
+        while (digits < url.size() && digits - begin < 9 && url[digits] >= '0' && url[digits] <= '9') {
+            digits++;
+        }
+        // The y segment may have a suffix; the others have to be numbers all the way.
+        if (digits == begin || (i > 0 && digits != slashes[i - 1])) {
+            return false;
+        }
+        *values[i] = std::stoi(url.substr(begin, digits - begin));
+        if (i == 0) {
+            yEnd = digits;
+        }
     }
 
-    const std::string domain = url.substr(domain_begin, path_separator - domain_begin);
-    if (domain.find(".tiles.mapbox.com") != std::string::npos) {
-        return "mapbox://" + url.substr(path_separator + 1);
-    } else {
-        return url;
+    tile.pattern = url.substr(0, slashes[2] + 1) + "{z}/{x}/{y}" + url.substr(yEnd);
+    return true;
+}
+
+// Returns the id of the URL template, or 0 if it doesn't have one. With /create/, it gets one.
+int64_t findTileSource(Database &db, const std::string &pattern, bool create) {
+    if (create) {
+        Statement &insert = db.prepareCached("INSERT OR IGNORE INTO `tile_sources` (`url_template`) VALUES (?)");
+        insert.bind(1, pattern.c_str());
+        insert.run();
+        insert.reset();
     }
+
+    Statement &select = db.prepareCached("SELECT `id` FROM `tile_sources` WHERE `url_template` = ?");
+    select.bind(1, pattern.c_str());
+    const int64_t id = select.run() ? select.get<int64_t>(0) : 0;
+    select.reset();
+    return id;
 }
 
-std::string unifyMapboxURLs(const std::string &url) {
-    return removeAccessTokenFromURL(convertMapboxDomainsToProtocol(url));
+// Binds the tile's key to the parameters /first/ to /first/ + 3.
+void bindTile(Statement &stmt, int first, const TileKey &key) {
+    stmt.bind<int64_t>(first, key.source);
+    stmt.bind(first + 1, int(key.z));
+    stmt.bind(first + 2, int(key.x));
+    stmt.bind(first + 3, int(key.y));
 }
 
-namespace mbgl {
+// Read-only connections for the reader threads. There are as many connections as there are
+// threads, so acquire() always finds an idle one.
+class SQLiteStore::ReaderPool {
+public:
+    ReaderPool(const std::string &path, unsigned count) {
+        for (unsigned i = 0; i < count; i++) {
+            idle.emplace_back(util::make_unique<Database>(path.c_str(), ReadOnly));
+        }
+    }
+
+    std::unique_ptr<Database> acquire() {
+        std::lock_guard<std::mutex> lock(mtx);
+        assert(!idle.empty());
+        std::unique_ptr<Database> db = std::move(idle.back());
+        idle.pop_back();
+        return db;
+    }
+
+    void release(std::unique_ptr<Database> db) {
+        std::lock_guard<std::mutex> lock(mtx);
+        idle.emplace_back(std::move(db));
+    }
+
+    // Only reaches the connections that aren't in use right now.
+    size_t releaseMemory() {
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t freed = 0;
+        for (const auto &db : idle) {
+            freed += db->releaseMemory();
+        }
+        return freed;
+    }
+
+private:
+    std::mutex mtx;
+    std::vector<std::unique_ptr<Database>> idle;
+};
+
+// A byte-bounded LRU of recent responses, keyed on the unified URL. Only used on the thread that
+// owns the SQLiteStore.
+class SQLiteStore::MemoryCache {
+public:
+    MemoryCache(size_t maxSize_) : maxSize(maxSize_) {}
+
+    const Response *get(const std::string &url) {
+        auto it = index.find(url);
+        if (it == index.end()) {
+            return nullptr;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        return &it->second->second;
+    }
+
+    void put(const std::string &url, const Response &response) {
+        remove(url);
+
+        const size_t entrySize = sizeOf(url, response);
+        // Don't let a single large response flush everything else.
+        if (entrySize > maxSize / 4) {
+            return;
+        }
+
+        entries.emplace_front(url, response);
+        index.emplace(url, entries.begin());
+        size += entrySize;
+
+        while (size > maxSize) {
+            const std::pair<std::string, Response> &last = entries.back();
+            size -= sizeOf(last.first, last.second);
+            index.erase(last.first);
+            entries.pop_back();
+        }
+    }
+
+    void updateExpiration(const std::string &url, int64_t expires) {
+        auto it = index.find(url);
+        if (it != index.end()) {
+            it->second->second.expires = expires;
+        }
+    }
+
+    // Returns the number of bytes freed.
+    size_t clear() {
+        const size_t freed = size;
+        index.clear();
+        entries.clear();
+        size = 0;
+        return freed;
+    }
+
+private:
+    static size_t sizeOf(const std::string &url, const Response &response) {
+        return url.size() + response.data->size() + response.etag.size() + sizeof(Response);
+    }
+
+    void remove(const std::string &url) {
+        auto it = index.find(url);
+        if (it != index.end()) {
+            size -= sizeOf(url, it->second->second);
+            entries.erase(it->second);
+            index.erase(it);
+        }
+    }
+
+    const size_t maxSize;
+    size_t size = 0;
+    std::list<std::pair<std::string, Response>> entries;
+    std::unordered_map<std::string, std::list<std::pair<std::string, Response>>::iterator> index;
+};
 
-SQLiteStore::SQLiteStore(uv_loop_t *loop, const std::string &path)
+struct SQLiteStore::CacheState {
+    CacheState(uv_worker_t *worker_, uint64_t maxSize_) : worker(worker_), maxSize(maxSize_) {}
+
+    // Only used on the thread that owns the SQLiteStore. The worker is reset when the store
+    // goes away so that outstanding jobs no longer schedule new ones.
+    uv_worker_t *worker;
+    bool maintaining = false;
+
+    // Number of queued or in-flight puts per path. Reads of these paths go to the writer so that
+    // they are ordered after the write. Only used on the thread that owns the SQLiteStore.
+    std::unordered_map<std::string, size_t> unwritten;
+
+    // Finds the key of a tile URL. Returns false if the URL isn't one, or if no tile of its source
+    // was stored yet and /create/ isn't set. Only the writer may create sources; a rolled back
+    // transaction must be followed by forgetTileSources().
+    bool tileKey(Database &db, const std::string &url, bool create, TileKey &key) {
+        TileURL tile;
+        if (!parseTileURL(url, tile)) {
+            return false;
+        }
+        key.z = tile.z;
+        key.x = tile.x;
+        key.y = tile.y;
+
+        {
+            std::lock_guard<std::mutex> lock(sourcesMutex);
+            auto it = sources.find(tile.pattern);
+            if (it != sources.end()) {
+                key.source = it->second;
+                return true;
+            }
+        }
+
+        key.source = findTileSource(db, tile.pattern, create);
+        if (!key.source) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(sourcesMutex);
+        sources.emplace(tile.pattern, key.source);
+        return true;
+    }
+
+    void forgetTileSources() {
+        std::lock_guard<std::mutex> lock(sourcesMutex);
+        sources.clear();
+    }
+
+    // Only used on the writer thread.
+    const int64_t maxSize;
+    int64_t size = -1; // -1 means we haven't summed up the table yet.
+
+    // Records the accesses of cache hits from all threads; we only write them back alongside
+    // other writes to avoid turning every read into a write transaction.
+    size_t recordAccess(const std::string &url) {
+        std::lock_guard<std::mutex> lock(accessedMutex);
+        accessed.emplace_back(url, currentTime());
+        return accessed.size();
+    }
+
+    void writeAccessed(Database &db) {
+        std::vector<std::pair<std::string, int64_t>> list;
+        {
+            std::lock_guard<std::mutex> lock(accessedMutex);
+            list.swap(accessed);
+        }
+
+        Statement &stmt = db.prepareCached("UPDATE `http_cache` SET `accessed` = ? WHERE `url` = ?");
+        Statement &tileStmt = db.prepareCached("UPDATE `tiles` SET `accessed` = ? "
+            "WHERE `source` = ? AND `z` = ? AND `x` = ? AND `y` = ?");
+        for (const std::pair<std::string, int64_t> &access : list) {
+            TileKey key;
+            if (tileKey(db, access.first, false, key)) {
+                tileStmt.bind<int64_t>(1, access.second);
+                bindTile(tileStmt, 2, key);
+                tileStmt.run();
+                tileStmt.reset();
+                if (db.changes()) {
+                    continue;
+                }
+            }
+
+            stmt.bind<int64_t>(1, access.second);
+            stmt.bind(2, access.first.c_str());
+            stmt.run();
+            stmt.reset();
+        }
+    }
+
+    int64_t totalSize(Database &db) {
+        if (size < 0) {
+            Statement &stmt = db.prepareCached("SELECT "
+                "IFNULL((SELECT SUM(`size`) FROM `http_cache` WHERE `pinned` = 0), 0) + "
+                "IFNULL((SELECT SUM(`size`) FROM `tiles` WHERE `pinned` = 0), 0)");
+            stmt.run();
+            size = stmt.get<int64_t>(0);
+            stmt.reset();
+        }
+        return size;
+    }
+
+    bool overBudget(Database &db) {
+        return maxSize > 0 && totalSize(db) > maxSize;
+    }
+
+    // Writes back recorded accesses and evicts up to evictionBatchSize entries in one
+    // transaction. Returns true when we're still over budget afterwards.
+    bool evict(Database &db) {
+        db.exec("BEGIN TRANSACTION");
+        writeAccessed(db);
+
+        // Merges the least recently used entries of both tables. Tiles all have the priority of
+        // ResourceType::Tile.
+        std::vector<std::string> urls;
+        std::vector<TileKey> tiles;
+        Statement &select = db.prepareCached("SELECT `url`, `size`, `priority`, `accessed` "
+            "FROM `http_cache` WHERE `pinned` = 0 ORDER BY `priority`, `accessed` LIMIT ?");
+        Statement &selectTiles = db.prepareCached("SELECT `source`, `z`, `x`, `y`, `size`, `accessed` "
+            "FROM `tiles` WHERE `pinned` = 0 ORDER BY `accessed` LIMIT ?");
+        select.bind(1, evictionBatchSize);
+        selectTiles.bind(1, evictionBatchSize);
+        const int tilePriority = evictionPriority(ResourceType::Tile);
+        int64_t remaining = totalSize(db);
+        bool entry = select.run();
+        bool tile = selectTiles.run();
+        while (maxSize > 0 && remaining > maxSize && (entry || tile)) {
+            if (tile && (!entry ||
+                    std::make_pair(tilePriority, selectTiles.get<int64_t>(5)) <
+                    std::make_pair(select.get<int>(2), select.get<int64_t>(3)))) {
+                TileKey key;
+                key.source = selectTiles.get<int64_t>(0);
+                key.z = selectTiles.get<int>(1);
+                key.x = selectTiles.get<int>(2);
+                key.y = selectTiles.get<int>(3);
+                tiles.push_back(key);
+                remaining -= selectTiles.get<int64_t>(4);
+                tile = selectTiles.run();
+            } else {
+                urls.emplace_back(select.get<std::string>(0));
+                remaining -= select.get<int64_t>(1);
+                entry = select.run();
+            }
+        }
+        select.reset();
+        selectTiles.reset();
+
+        Statement &remove = db.prepareCached("DELETE FROM `http_cache` WHERE `url` = ?");
+        for (const std::string &url : urls) {
+            remove.bind(1, url.c_str());
+            remove.run();
+            remove.reset();
+        }
+
+        Statement &removeTile = db.prepareCached("DELETE FROM `tiles` "
+            "WHERE `source` = ? AND `z` = ? AND `x` = ? AND `y` = ?");
+        for (const TileKey &key : tiles) {
+            bindTile(removeTile, 1, key);
+            removeTile.run();
+            removeTile.reset();
+        }
+
+        db.exec("COMMIT TRANSACTION");
+        if (!urls.empty() || !tiles.empty()) {
+            size = remaining;
+            return overBudget(db);
+        } else if (overBudget(db)) {
+            // The table is empty, so our running total is off. Sum it up again next time.
+            size = -1;
+        }
+        return false;
+    }
+
+private:
+    std::mutex accessedMutex;
+    std::vector<std::pair<std::string, int64_t>> accessed;
+
+    // The ids of the URL templates of tile sources. Used from all threads.
+    std::mutex sourcesMutex;
+    std::unordered_map<std::string, int64_t> sources;
+};
+
+SQLiteStore::SQLiteStore(uv_loop_t *loop, const std::string &path, size_t batchSize_,
+                         uint64_t batchDelay_, uint64_t maxSize, size_t memorySize)
     : thread_id(std::this_thread::get_id()),
-      db(std::make_shared<Database>(path.c_str(), ReadWrite | Create)) {
+      db(std::make_shared<Database>(path.c_str(), ReadWrite | Create)),
+      batchSize(batchSize_),
+      batchDelay(batchDelay_),
+      codecs({
+          { ResourceType::Tile, Codec::Raw },
+          { ResourceType::Image, Codec::Raw },
+      }) {
     createSchema();
     worker = new uv_worker_t;
     uv_worker_init(worker, loop, 1, "SQLite");
+    state = std::make_shared<CacheState>(worker, maxSize);
+    memory = std::make_shared<MemoryCache>(memorySize);
+
+    // In WAL mode, readers don't block the writer or each other, so cache lookups get their own
+    // connections and threads. All writes stay on the single writer connection above.
+    if (*db) {
+        const unsigned readerCount =
+            std::max(1u, std::min(maxReaderCount, std::thread::hardware_concurrency()));
+        readers = std::make_shared<ReaderPool>(path, readerCount);
+        readWorker = new uv_worker_t;
+        uv_worker_init(readWorker, loop, readerCount, "SQLite Reader");
+    }
+    batchTimer = new uv_timer_t();
+    uv_timer_init(loop, batchTimer);
+    batchTimer->data = this;
 }
 
 SQLiteStore::~SQLiteStore() {
-    // Nothing to do. This function needs to be here because we're forward-declaring
-    // Database, so we need the actual definition here to be able to properly destruct it.
+    // This function needs to be here because we're forward-declaring Database, so we need the
+    // actual definition here to be able to properly destruct it.
+    flush();
+    state->worker = nullptr;
+    if (batchTimer) {
+        uv_timer_stop(batchTimer);
+        uv_close((uv_handle_t *)batchTimer, [](uv_handle_t *handle) { delete (uv_timer_t *)handle; });
+    }
     if (worker) {
         uv_worker_close(worker, [](uv_worker_t *worker_handle) {
             delete worker_handle;
         });
     }
+    if (readWorker) {
+        uv_worker_close(readWorker, [](uv_worker_t *worker_handle) {
+            delete worker_handle;
+        });
+    }
 }
 
 void SQLiteStore::createSchema() {
@@ -80,6 +464,14 @@ void SQLiteStore::createSchema() {
         return;
     }
 
+    // With a write-ahead log, a commit only appends to the log instead of rewriting the pages
+    // in place, and readers don't block the writer. NORMAL synchronisation only syncs at
+    // checkpoints, which is still safe from corruption in WAL mode; worst case, a power loss
+    // drops the last few cache writes. The page cache size is in KiB when negative.
+    db->exec("PRAGMA journal_mode = WAL;"
+             "PRAGMA synchronous = NORMAL;"
+             "PRAGMA cache_size = -4096;");
+
     db->exec("CREATE TABLE IF NOT EXISTS `http_cache` ("
              "    `url` TEXT PRIMARY KEY NOT NULL,"
              "    `code` INTEGER NOT NULL,"
@@ -91,19 +483,173 @@ void SQLiteStore::createSchema() {
              "    `compressed` INTEGER NOT NULL DEFAULT 0"
              ");"
              "CREATE INDEX IF NOT EXISTS `http_cache_type_idx` ON `http_cache` (`type`);");
+
+    int version = 0;
+    {
+        Statement stmt = db->prepare("PRAGMA user_version");
+        if (stmt.run()) {
+            version = stmt.get<int>(0);
+        }
+    }
+
+    if (version < 1) {
+        // Version 1 adds the columns we need for size-bounded LRU eviction. Existing entries
+        // haven't been accessed as far as we know, and are sized by their stored data.
+        db->exec("BEGIN TRANSACTION;"
+                 "ALTER TABLE `http_cache` ADD COLUMN `accessed` INTEGER NOT NULL DEFAULT 0;"
+                 "ALTER TABLE `http_cache` ADD COLUMN `size` INTEGER NOT NULL DEFAULT 0;"
+                 "ALTER TABLE `http_cache` ADD COLUMN `priority` INTEGER NOT NULL DEFAULT 0;"
+                 "UPDATE `http_cache` SET `size` = IFNULL(LENGTH(`data`), 0), `priority` = "
+                 "    CASE `type` WHEN 2 THEN 1 WHEN 4 THEN 1 ELSE 0 END;"
+                 "CREATE INDEX IF NOT EXISTS `http_cache_eviction_idx` "
+                 "    ON `http_cache` (`priority`, `accessed`);"
+                 "PRAGMA user_version = 1;"
+                 "COMMIT TRANSACTION;");
+    }
+
+    if (version < 2) {
+        // Version 2 adds pinned entries, which are never evicted and don't count towards the
+        // size budget.
+        db->exec("BEGIN TRANSACTION;"
+                 "ALTER TABLE `http_cache` ADD COLUMN `pinned` INTEGER NOT NULL DEFAULT 0;"
+                 "DROP INDEX IF EXISTS `http_cache_eviction_idx`;"
+                 "CREATE INDEX IF NOT EXISTS `http_cache_eviction_idx` "
+                 "    ON `http_cache` (`pinned`, `priority`, `accessed`);"
+                 "PRAGMA user_version = 2;"
+                 "COMMIT TRANSACTION;");
+    }
+
+    if (version < 3) {
+        // Version 3 moves the tiles out of `http_cache`, into a table that is keyed by the id of
+        // the tile URL template and the tile coordinates. Tiles whose URL doesn't look like one
+        // stay where they are.
+        db->exec("BEGIN TRANSACTION;"
+                 "CREATE TABLE IF NOT EXISTS `tile_sources` ("
+                 "    `id` INTEGER PRIMARY KEY,"
+                 "    `url_template` TEXT NOT NULL UNIQUE"
+                 ");"
+                 "CREATE TABLE IF NOT EXISTS `tiles` ("
+                 "    `source` INTEGER NOT NULL,"
+                 "    `z` INTEGER NOT NULL,"
+                 "    `x` INTEGER NOT NULL,"
+                 "    `y` INTEGER NOT NULL,"
+                 "    `code` INTEGER NOT NULL,"
+                 "    `modified` INTEGER,"
+                 "    `etag` TEXT,"
+                 "    `expires` INTEGER,"
+                 "    `data` BLOB,"
+                 "    `compressed` INTEGER NOT NULL DEFAULT 0,"
+                 "    `accessed` INTEGER NOT NULL DEFAULT 0,"
+                 "    `size` INTEGER NOT NULL DEFAULT 0,"
+                 "    `pinned` INTEGER NOT NULL DEFAULT 0,"
+                 "    PRIMARY KEY (`source`, `z`, `x`, `y`)"
+                 ") WITHOUT ROWID;"
+                 "CREATE INDEX IF NOT EXISTS `tiles_eviction_idx` ON `tiles` (`pinned`, `accessed`);");
+
+        std::vector<std::string> urls;
+        {
+            Statement select = db->prepare("SELECT `url` FROM `http_cache` WHERE `type` = 1");
+            while (select.run()) {
+                urls.emplace_back(select.get<std::string>(0));
+            }
+        }
+
+        {
+            Statement move = db->prepare("REPLACE INTO `tiles` (`source`, `z`, `x`, `y`, `code`, "
+                "`modified`, `etag`, `expires`, `data`, `compressed`, `accessed`, `size`, `pinned`) "
+                "SELECT ?, ?, ?, ?, `code`, `modified`, `etag`, `expires`, `data`, `compressed`, "
+                "`accessed`, `size`, `pinned` FROM `http_cache` WHERE `url` = ?");
+            Statement remove = db->prepare("DELETE FROM `http_cache` WHERE `url` = ?");
+            for (const std::string &url : urls) {
+                TileURL tile;
+                if (!parseTileURL(url, tile)) {
+                    continue;
+                }
+                TileKey key;
+                key.source = findTileSource(*db, tile.pattern, true);
+                key.z = tile.z;
+                key.x = tile.x;
+                key.y = tile.y;
+                bindTile(move, 1, key);
+                move.bind(5, url.c_str());
+                move.run();
+                move.reset();
+
+                remove.bind(1, url.c_str());
+                remove.run();
+                remove.reset();
+            }
+        }
+
+        db->exec("PRAGMA user_version = 3;"
+                 "COMMIT TRANSACTION;");
+    }
+}
+
+void SQLiteStore::scheduleMaintenance(util::ptr<Database> db, util::ptr<CacheState> state) {
+    if (!state->worker || state->maintaining) {
+        return;
+    }
+
+    struct EvictionBaton {
+        util::ptr<Database> db;
+        util::ptr<CacheState> state;
+        bool overBudget = false;
+    };
+
+    EvictionBaton *eviction_baton = new EvictionBaton;
+    eviction_baton->db = db;
+    eviction_baton->state = state;
+    state->maintaining = true;
+
+    uv_worker_send(state->worker, eviction_baton, [](void *data) {
+        EvictionBaton *baton = (EvictionBaton *)data;
+        try {
+            baton->overBudget = baton->state->evict(*baton->db);
+        } catch (const std::exception &ex) {
+            Log::Warning(Event::Database, "failed to evict cache entries: %s", ex.what());
+            try {
+                baton->db->exec("ROLLBACK TRANSACTION");
+            } catch (const std::exception &) {
+                // The transaction was never started, or already rolled back by SQLite.
+            }
+            baton->state->size = -1;
+        }
+    }, [](void *data) {
+        std::unique_ptr<EvictionBaton> baton { (EvictionBaton *)data };
+        baton->state->maintaining = false;
+        if (baton->overBudget) {
+            // Continue in a separate job so that pending reads get a chance to run in between.
+            scheduleMaintenance(baton->db, baton->state);
+        }
+    });
 }
 
 struct GetBaton {
     util::ptr<Database> db;
+    util::ptr<SQLiteStore::ReaderPool> readers;
+    util::ptr<SQLiteStore::CacheState> state;
+    util::ptr<SQLiteStore::MemoryCache> memory;
     std::string path;
     ResourceType type;
     void *ptr = nullptr;
     SQLiteStore::GetCallback callback = nullptr;
     std::unique_ptr<Response> response;
+    bool withData = true;
+    bool writeAccessed = false;
 };
 
 void SQLiteStore::get(const std::string &path, GetCallback callback, void *ptr) {
+    lookup(path, callback, ptr, true);
+}
+
+void SQLiteStore::head(const std::string &path, GetCallback callback, void *ptr) {
+    lookup(path, callback, ptr, false);
+}
+
+void SQLiteStore::lookup(const std::string &path, GetCallback callback, void *ptr, bool withData) {
     assert(std::this_thread::get_id() == thread_id);
+    AllocationTracker::Scope allocations(AllocationTracker::Subsystem::SQLiteStore);
     if (!db || !*db) {
         if (callback) {
             callback(nullptr, ptr);
@@ -111,40 +657,130 @@ void SQLiteStore::get(const std::string &path, GetCallback callback, void *ptr)
         return;
     }
 
+    if (const Response *cached = memory->get(path)) {
+        state->recordAccess(path);
+        if (callback) {
+            callback(util::make_unique<Response>(*cached), ptr);
+        }
+        return;
+    }
+
     GetBaton *get_baton = new GetBaton;
     get_baton->db = db;
+    get_baton->state = state;
+    get_baton->memory = memory;
     get_baton->path = path;
     get_baton->ptr = ptr;
     get_baton->callback = callback;
+    get_baton->withData = withData;
+
+    uv_worker_t *target = readWorker;
+    if (state->unwritten.count(path)) {
+        // Make sure that we read our own writes by queueing the read behind them on the writer.
+        flush();
+        target = worker;
+    } else {
+        get_baton->readers = readers;
+    }
 
-    uv_worker_send(worker, get_baton, [](void *data) {
+    uv_worker_send(target, get_baton, [](void *data) {
+        AllocationTracker::Scope scope(AllocationTracker::Subsystem::SQLiteStore);
         GetBaton *baton = (GetBaton *)data;
-        const std::string url = unifyMapboxURLs(baton->path);
-        //                                                    0       1         2
-        Statement stmt = baton->db->prepare("SELECT `code`, `type`, `modified`, "
-        //     3         4        5           6
-            "`etag`, `expires`, `data`, `compressed` FROM `http_cache` WHERE `url` = ?");
+        std::unique_ptr<Database> reader;
+        if (baton->readers) {
+            reader = baton->readers->acquire();
+        }
+        Database &database = reader ? *reader : *baton->db;
 
-        stmt.bind(1, url.c_str());
-        if (stmt.run()) {
-            // There is data.
-            baton->response = util::make_unique<Response>();
-
-            baton->response->code = stmt.get<int>(0);
-            baton->type = ResourceType(stmt.get<int>(1));
-            baton->response->modified = stmt.get<int64_t>(2);
-            baton->response->etag = stmt.get<std::string>(3);
-            baton->response->expires = stmt.get<int64_t>(4);
-            baton->response->data = stmt.get<std::string>(5);
-            if (stmt.get<int>(6)) { // == compressed
-                baton->response->data = util::decompress(baton->response->data);
+        const std::string &url = baton->path;
+        // Reads the row of the statement, whose columns are the same for both tables. Returns
+        // whether there was one.
+        const auto read = [&](Statement &stmt) {
+            const bool found = stmt.run();
+            if (found) {
+                // There is data.
+                baton->response = util::make_unique<Response>();
+
+                baton->response->code = stmt.get<int>(0);
+                baton->type = ResourceType(stmt.get<int>(1));
+                baton->response->modified = stmt.get<int64_t>(2);
+                baton->response->etag = stmt.get<std::string>(3);
+                baton->response->expires = stmt.get<int64_t>(4);
+                if (!baton->withData) {
+                    // The caller loads the data separately once it knows that it needs it, which
+                    // also records the access.
+                    baton->response->data = nullptr;
+                } else {
+                    switch (SQLiteStore::Codec(stmt.get<int>(6))) {
+                        case SQLiteStore::Codec::Raw:
+                            baton->response->data = std::make_shared<const std::string>(stmt.get<std::string>(5));
+                            break;
+                        case SQLiteStore::Codec::Zlib: {
+                            // Inflate straight out of SQLite's copy of the row.
+                            size_t size = 0;
+                            const char *compressed = stmt.getBlob(5, size);
+                            baton->response->data = std::make_shared<const std::string>(util::decompress(compressed, size));
+                            break;
+                        }
+                        default:
+                            // Written by a newer version that uses a codec we don't know about.
+                            baton->response.reset();
+                            break;
+                    }
+
+                    baton->writeAccessed = baton->state->recordAccess(url) >= accessBatchSize;
+                }
             }
-        } else {
-            // There is no data.
-            // This is a noop.
+            stmt.reset();
+            return found;
+        };
+
+        // The `compressed` column stores the SQLiteStore::Codec that was used for `data`. A head
+        // lookup doesn't select the BLOB at all, so SQLite doesn't read its overflow pages. The
+        // type of a tile is ResourceType::Tile. A tile URL is still looked up in `http_cache`
+        // if it isn't in `tiles`, as other resources may have URLs that look like tiles.
+        TileKey key;
+        bool found = false;
+        if (baton->state->tileKey(database, url, false, key)) {
+            Statement &stmt = baton->withData
+            //                                                  0    1       2
+                ? database.prepareCached("SELECT `code`, 1, `modified`, "
+            //     3         4        5           6
+                "`etag`, `expires`, `data`, `compressed` FROM `tiles` "
+                "WHERE `source` = ? AND `z` = ? AND `x` = ? AND `y` = ?")
+                : database.prepareCached("SELECT `code`, 1, `modified`, `etag`, `expires` "
+                "FROM `tiles` WHERE `source` = ? AND `z` = ? AND `x` = ? AND `y` = ?");
+            bindTile(stmt, 1, key);
+            found = read(stmt);
+        }
+
+        if (!found) {
+            Statement &stmt = baton->withData
+            //                                                  0       1         2
+                ? database.prepareCached("SELECT `code`, `type`, `modified`, "
+            //     3         4        5           6
+                "`etag`, `expires`, `data`, `compressed` FROM `http_cache` WHERE `url` = ?")
+                : database.prepareCached("SELECT `code`, `type`, `modified`, "
+                "`etag`, `expires` FROM `http_cache` WHERE `url` = ?");
+            stmt.bind(1, url.c_str());
+            read(stmt);
+        }
+
+        if (reader) {
+            baton->readers->release(std::move(reader));
         }
     }, [](void *data) {
         std::unique_ptr<GetBaton> baton { (GetBaton *)data };
+        if (baton->response && baton->withData) {
+            // A put may have come in for this URL while we were reading; don't clobber it.
+            const std::string &url = baton->path;
+            if (!baton->memory->get(url)) {
+                baton->memory->put(url, *baton->response);
+            }
+        }
+        if (baton->writeAccessed) {
+            scheduleMaintenance(baton->db, baton->state);
+        }
         if (baton->callback) {
             baton->callback(std::move(baton->response), baton->ptr);
         }
@@ -154,51 +790,253 @@ void SQLiteStore::get(const std::string &path, GetCallback callback, void *ptr)
 
 struct PutBaton {
     util::ptr<Database> db;
-    std::string path;
-    ResourceType type;
-    Response response;
+    util::ptr<SQLiteStore::CacheState> state;
+    std::vector<SQLiteStore::PutEntry> entries;
+    std::vector<std::string> pins;
+    bool overBudget = false;
 };
 
 void SQLiteStore::put(const std::string &path, ResourceType type, const Response &response) {
     assert(std::this_thread::get_id() == thread_id);
+    AllocationTracker::Scope allocations(AllocationTracker::Subsystem::SQLiteStore);
     if (!db) return;
 
+    memory->put(path, response);
+
+    auto codec = codecs.find(type);
+    pendingPuts.push_back({ path, type, codec != codecs.end() ? codec->second : Codec::Zlib, response });
+    state->unwritten[path]++;
+
+    scheduleFlush();
+}
+
+void SQLiteStore::pin(const std::string &path) {
+    assert(std::this_thread::get_id() == thread_id);
+    if (!db) return;
+
+    pendingPins.push_back(path);
+
+    scheduleFlush();
+}
+
+void SQLiteStore::scheduleFlush() {
+    const size_t pending = pendingPuts.size() + pendingPins.size();
+    if (pending >= batchSize) {
+        flush();
+    } else if (pending == 1) {
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
+        uv_timer_start(batchTimer, [](uv_timer_t *timer, int) {
+#else
+        uv_timer_start(batchTimer, [](uv_timer_t *timer) {
+#endif
+            reinterpret_cast<SQLiteStore *>(timer->data)->flush();
+        }, batchDelay, 0);
+    }
+}
+
+void SQLiteStore::setCodec(ResourceType type, Codec codec) {
+    assert(std::this_thread::get_id() == thread_id);
+    codecs[type] = codec;
+}
+
+size_t SQLiteStore::releaseMemory() {
+    assert(std::this_thread::get_id() == thread_id);
+    size_t freed = memory->clear();
+    if (db) {
+        freed += db->releaseMemory();
+    }
+    if (readers) {
+        freed += readers->releaseMemory();
+    }
+    return freed;
+}
+
+void SQLiteStore::flush() {
+    assert(std::this_thread::get_id() == thread_id);
+    AllocationTracker::Scope allocations(AllocationTracker::Subsystem::SQLiteStore);
+    if (batchTimer) {
+        uv_timer_stop(batchTimer);
+    }
+
+    if (pendingPuts.empty() && pendingPins.empty()) {
+        return;
+    }
+
     PutBaton *put_baton = new PutBaton;
     put_baton->db = db;
-    put_baton->path = path;
-    put_baton->type = type;
-    put_baton->response = response;
+    put_baton->state = state;
+    put_baton->entries = std::move(pendingPuts);
+    pendingPuts.clear();
+    put_baton->pins = std::move(pendingPins);
+    pendingPins.clear();
 
     uv_worker_send(worker, put_baton, [](void *data) {
+        AllocationTracker::Scope scope(AllocationTracker::Subsystem::SQLiteStore);
         PutBaton *baton = (PutBaton *)data;
-        const std::string url = unifyMapboxURLs(baton->path);
-        Statement stmt = baton->db->prepare("REPLACE INTO `http_cache` ("
-        //     1      2       3         4         5         6        7          8
-            "`url`, `code`, `type`, `modified`, `etag`, `expires`, `data`, `compressed`"
-            ") VALUES(?, ?, ?, ?, ?, ?, ?, ?)");
-        stmt.bind(1, url.c_str());
-        stmt.bind(2, int(baton->response.code));
-        stmt.bind(3, int(baton->type));
-        stmt.bind(4, baton->response.modified);
-        stmt.bind(5, baton->response.etag.c_str());
-        stmt.bind(6, baton->response.expires);
-
-        if (baton->type == ResourceType::Image) {
-            stmt.bind(7, baton->response.data, false); // do not retain the string internally.
-            stmt.bind(8, false);
-        } else {
-            stmt.bind(7, util::compress(baton->response.data), true); // retain the string internally.
-            stmt.bind(8, true);
+        Database &database = *baton->db;
+        SQLiteStore::CacheState &cache = *baton->state;
+        const int64_t now = currentTime();
+
+        // Write the entire batch in one transaction so that we only sync once.
+        try {
+            database.exec("BEGIN TRANSACTION");
+            int64_t size = cache.totalSize(database);
+
+            Statement &existing = database.prepareCached("SELECT `size`, `pinned` FROM `http_cache` WHERE `url` = ?");
+            Statement &existingTile = database.prepareCached("SELECT `size`, `pinned` FROM `tiles` "
+                "WHERE `source` = ? AND `z` = ? AND `x` = ? AND `y` = ?");
+            Statement &replace = database.prepareCached("REPLACE INTO `http_cache` ("
+            //     1      2          3
+                "`url`, `type`, `priority`, "
+            //      4         5         6         7        8          9
+                "`code`, `modified`, `etag`, `expires`, `data`, `compressed`, "
+            //      10         11        12
+                "`accessed`, `size`, `pinned`"
+                ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+            Statement &replaceTile = database.prepareCached("REPLACE INTO `tiles` ("
+            //      1        2      3      4
+                "`source`, `z`, `x`, `y`, "
+            //      5         6         7         8         9         10
+                "`code`, `modified`, `etag`, `expires`, `data`, `compressed`, "
+            //      11         12        13
+                "`accessed`, `size`, `pinned`"
+                ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+            // Looks up the size of an existing entry and whether it is pinned.
+            const auto lookupExisting = [](Statement &stmt, int64_t &stored, bool &pinned) {
+                const bool found = stmt.run();
+                if (found) {
+                    stored = stmt.get<int64_t>(0);
+                    pinned = stmt.get<int>(1);
+                }
+                stmt.reset();
+                return found;
+            };
+
+            for (const SQLiteStore::PutEntry &entry : baton->entries) {
+                const std::string &url = entry.path;
+
+                TileKey key;
+                const bool tile = entry.type == ResourceType::Tile && cache.tileKey(database, url, true, key);
+                Statement &stmt = tile ? replaceTile : replace;
+                int param;
+                if (tile) {
+                    bindTile(existingTile, 1, key);
+                    bindTile(replaceTile, 1, key);
+                    param = 5;
+                } else {
+                    existing.bind(1, url.c_str());
+                    replace.bind(1, url.c_str());
+                    replace.bind(2, int(entry.type));
+                    replace.bind(3, evictionPriority(entry.type));
+                    param = 4;
+                }
+
+                // Replacing an entry keeps it pinned. Pinned entries aren't part of the budget.
+                int64_t previous = 0;
+                bool pinned = false;
+                if (lookupExisting(tile ? existingTile : existing, previous, pinned) && !pinned) {
+                    size -= previous;
+                }
+
+                stmt.bind(param, int(entry.response.code));
+                stmt.bind(param + 1, entry.response.modified);
+                stmt.bind(param + 2, entry.response.etag.c_str());
+                stmt.bind(param + 3, entry.response.expires);
+
+                int64_t stored = 0;
+                if (entry.codec == SQLiteStore::Codec::Zlib) {
+                    const std::string compressed = util::compress(*entry.response.data);
+                    stmt.bind(param + 4, compressed, true); // retain the string internally.
+                    stored = compressed.size();
+                } else {
+                    stmt.bind(param + 4, *entry.response.data, false); // do not retain the string internally.
+                    stored = entry.response.data->size();
+                }
+                stmt.bind(param + 5, int(entry.codec));
+
+                stmt.bind<int64_t>(param + 6, now);
+                stmt.bind<int64_t>(param + 7, stored);
+                stmt.bind(param + 8, int(pinned));
+
+                stmt.run();
+                stmt.reset();
+                if (!pinned) {
+                    size += stored;
+                }
+            }
+
+            // Pins are applied after the puts so that they cover entries from the same batch.
+            Statement &pin = database.prepareCached("UPDATE `http_cache` SET `pinned` = 1 WHERE `url` = ?");
+            Statement &pinTile = database.prepareCached("UPDATE `tiles` SET `pinned` = 1 "
+                "WHERE `source` = ? AND `z` = ? AND `x` = ? AND `y` = ?");
+            for (const std::string &path : baton->pins) {
+                const std::string &url = path;
+
+                int64_t stored = 0;
+                bool pinned = false;
+                TileKey key;
+                if (cache.tileKey(database, url, false, key)) {
+                    bindTile(existingTile, 1, key);
+                    if (lookupExisting(existingTile, stored, pinned)) {
+                        if (!pinned) {
+                            size -= stored;
+                        }
+                        bindTile(pinTile, 1, key);
+                        pinTile.run();
+                        pinTile.reset();
+                        continue;
+                    }
+                }
+
+                existing.bind(1, url.c_str());
+                if (lookupExisting(existing, stored, pinned) && !pinned) {
+                    size -= stored;
+                }
+
+                pin.bind(1, url.c_str());
+                pin.run();
+                pin.reset();
+            }
+
+            cache.writeAccessed(database);
+            database.exec("COMMIT TRANSACTION");
+            cache.size = size;
+        } catch (const std::exception &ex) {
+            Log::Warning(Event::Database, "failed to write %d cache entries: %s",
+                         int(baton->entries.size()), ex.what());
+            try {
+                database.exec("ROLLBACK TRANSACTION");
+            } catch (const std::exception &) {
+                // The transaction was never started, or already rolled back by SQLite.
+            }
+            cache.forgetTileSources();
         }
 
-        stmt.run();
+        try {
+            baton->overBudget = cache.overBudget(database);
+        } catch (const std::exception &) {
+            baton->overBudget = false;
+        }
     }, [](void *data) {
-        delete (PutBaton *)data;
+        std::unique_ptr<PutBaton> baton { (PutBaton *)data };
+        std::unordered_map<std::string, size_t> &unwritten = baton->state->unwritten;
+        for (const SQLiteStore::PutEntry &entry : baton->entries) {
+            auto it = unwritten.find(entry.path);
+            if (it != unwritten.end() && --it->second == 0) {
+                unwritten.erase(it);
+            }
+        }
+
+        if (baton->overBudget) {
+            scheduleMaintenance(baton->db, baton->state);
+        }
     });
 }
 
 struct ExpirationBaton {
     util::ptr<Database> db;
+    util::ptr<SQLiteStore::CacheState> state;
     std::string path;
     int64_t expires;
 };
@@ -207,19 +1045,43 @@ void SQLiteStore::updateExpiration(const std::string &path, int64_t expires) {
     assert(std::this_thread::get_id() == thread_id);
     if (!db || !*db) return;
 
+    memory->updateExpiration(path, expires);
+
+    if (state->unwritten.count(path)) {
+        flush();
+    }
+
     ExpirationBaton *expiration_baton = new ExpirationBaton;
     expiration_baton->db = db;
+    expiration_baton->state = state;
     expiration_baton->path = path;
     expiration_baton->expires = expires;
 
     uv_worker_send(worker, expiration_baton, [](void *data) {
         ExpirationBaton *baton = (ExpirationBaton *)data;
-        const std::string url = unifyMapboxURLs(baton->path);
-        Statement stmt = //                                 1               2
-            baton->db->prepare("UPDATE `http_cache` SET `expires` = ? WHERE `url` = ?");
+        const std::string &url = baton->path;
+
+        TileKey key;
+        if (baton->state->tileKey(*baton->db, url, false, key)) {
+            Statement &stmt = //                                   1
+                baton->db->prepareCached("UPDATE `tiles` SET `expires` = ? "
+            //                 2             3           4           5
+                "WHERE `source` = ? AND `z` = ? AND `x` = ? AND `y` = ?");
+            stmt.bind<int64_t>(1, baton->expires);
+            bindTile(stmt, 2, key);
+            stmt.run();
+            stmt.reset();
+            if (baton->db->changes()) {
+                return;
+            }
+        }
+
+        Statement &stmt = //                                      1               2
+            baton->db->prepareCached("UPDATE `http_cache` SET `expires` = ? WHERE `url` = ?");
         stmt.bind<int64_t>(1, baton->expires);
         stmt.bind(2, url.c_str());
         stmt.run();
+        stmt.reset();
     }, [](void *data) {
         delete (ExpirationBaton *)data;
     });
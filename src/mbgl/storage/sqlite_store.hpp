@@ -7,8 +7,10 @@
 
 #include <uv.h>
 
+#include <map>
 #include <string>
 #include <thread>
+#include <vector>
 
 typedef struct uv_worker_s uv_worker_t;
 
@@ -22,17 +24,72 @@ namespace mbgl {
 
 class SQLiteStore {
 public:
-    SQLiteStore(uv_loop_t *loop, const std::string &path);
+    // Puts are queued and written in a single transaction once either batchSize entries have
+    // accumulated, or batchDelay milliseconds have passed since the first queued entry.
+    // Once the stored data exceeds maxSize bytes, the least recently used entries are evicted,
+    // starting with tiles and images. A maxSize of 0 disables eviction.
+    // Recently used responses are additionally kept in memory, up to memorySize bytes.
+    SQLiteStore(uv_loop_t *loop, const std::string &path, size_t batchSize = 64,
+                uint64_t batchDelay = 250, uint64_t maxSize = 50 * 1024 * 1024,
+                size_t memorySize = 4 * 1024 * 1024);
     ~SQLiteStore();
 
     typedef void (*GetCallback)(std::unique_ptr<Response> &&entry, void *ptr);
 
+    // All paths are cache keys as returned by util::mapbox::canonicalURL(); the store uses them
+    // as they are. Tiles with .../{z}/{x}/{y} URLs are kept apart from the other resources, in a
+    // table keyed by their URL template and coordinates.
+
+    // Calls the callback synchronously when the response is found in memory.
     void get(const std::string &path, GetCallback cb, void *ptr);
+
+    // Like get(), but only reads the metadata (code, modified, etag, expires) of the entry. The
+    // response data is null, unless the response happened to be in memory anyway.
+    void head(const std::string &path, GetCallback cb, void *ptr);
     void put(const std::string &path, ResourceType type, const Response &entry);
     void updateExpiration(const std::string &path, int64_t expires);
 
+    // Exempts the entry from eviction, e.g. because it is part of an offline region. Pinned
+    // entries don't count towards maxSize. Applied with the next batch of puts, after any puts
+    // that are already queued.
+    void pin(const std::string &path);
+
+    // Writes all queued puts and pins immediately.
+    void flush();
+
+    // Drops the responses that are kept in memory and the page caches of the database
+    // connections. Returns the number of bytes freed.
+    size_t releaseMemory();
+
+    // How cached data is encoded in the database. The numeric value is stored in the row, so
+    // existing values must never change.
+    enum class Codec : uint8_t {
+        Raw = 0,
+        Zlib = 1,
+    };
+
+    // Sets the codec for entries of this type that are put from now on. Existing entries keep
+    // their codec. By default, tiles and images are stored raw so that cache hits can be handed
+    // out without decoding, and everything else is compressed.
+    void setCodec(ResourceType type, Codec codec);
+
+    struct CacheState;
+    class ReaderPool;
+    class MemoryCache;
+
+    struct PutEntry {
+        std::string path;
+        ResourceType type;
+        Codec codec;
+        Response response;
+    };
+
 private:
     void createSchema();
+    void lookup(const std::string &path, GetCallback cb, void *ptr, bool withData);
+    void scheduleFlush();
+    static void scheduleMaintenance(util::ptr<mapbox::sqlite::Database> db,
+                                 util::ptr<CacheState> state);
     void closeDatabase();
     static void runGet(uv_work_t *req);
     static void runPut(uv_work_t *req);
@@ -42,6 +99,17 @@ private:
     const std::thread::id thread_id;
     util::ptr<mapbox::sqlite::Database> db;
     uv_worker_t *worker = nullptr;
+    util::ptr<CacheState> state;
+    util::ptr<MemoryCache> memory;
+    util::ptr<ReaderPool> readers;
+    uv_worker_t *readWorker = nullptr;
+
+    const size_t batchSize;
+    const uint64_t batchDelay;
+    std::vector<PutEntry> pendingPuts;
+    std::vector<std::string> pendingPins;
+    std::map<ResourceType, Codec> codecs;
+    uv_timer_t *batchTimer = nullptr;
 };
 
 }
@@ -0,0 +1,95 @@
+#include <mbgl/storage/timer_wheel.hpp>
+
+#include <uv.h>
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace mbgl {
+
+TimerWheel::TimerWheel(uv_loop_t *loop_, uint64_t tick_, size_t slots)
+    : loop(loop_), timer(new uv_timer_t), tick(tick_), wheel(slots) {
+    assert(tick > 0 && slots > 0);
+    uv_timer_init(loop, timer);
+    timer->data = this;
+}
+
+TimerWheel::~TimerWheel() {
+    uv_timer_stop(timer);
+    uv_close((uv_handle_t *)timer, [](uv_handle_t *handle) { delete (uv_timer_t *)handle; });
+}
+
+TimerWheel::ID TimerWheel::schedule(uint64_t delay, Callback callback) {
+    const uint64_t now = uv_now(loop);
+    if (index.empty()) {
+        // The wheel stands still while it's empty; it starts turning from now on.
+        lastTick = now;
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
+        uv_timer_start(timer, [](uv_timer_t *handle, int) {
+#else
+        uv_timer_start(timer, [](uv_timer_t *handle) {
+#endif
+            reinterpret_cast<TimerWheel *>(handle->data)->advance();
+        }, tick, tick);
+    }
+
+    // Counted from the last tick, since the next one comes sooner than /tick/.
+    const uint64_t ticks = std::max<uint64_t>(1, (now - lastTick + delay + tick - 1) / tick);
+    const size_t slot = (current + ticks) % wheel.size();
+
+    const ID id = nextID++;
+    Slot &list = wheel[slot];
+    list.push_back({ id, (ticks - 1) / wheel.size(), std::move(callback) });
+    index.emplace(id, std::make_pair(slot, std::prev(list.end())));
+    return id;
+}
+
+bool TimerWheel::cancel(ID id) {
+    auto it = index.find(id);
+    if (it == index.end()) {
+        return false;
+    }
+    wheel[it->second.first].erase(it->second.second);
+    index.erase(it);
+    if (index.empty()) {
+        uv_timer_stop(timer);
+    }
+    return true;
+}
+
+void TimerWheel::advance() {
+    // The timer may fire late when the loop was busy; catch up with all ticks that passed.
+    const uint64_t now = uv_now(loop);
+    std::vector<ID> due;
+    while (lastTick + tick <= now) {
+        lastTick += tick;
+        current = (current + 1) % wheel.size();
+
+        for (Timer &entry : wheel[current]) {
+            if (entry.rounds) {
+                entry.rounds--;
+            } else {
+                due.push_back(entry.id);
+            }
+        }
+    }
+
+    // Callbacks may schedule and cancel others, including the ones that are due now, or destroy
+    // the object that scheduled them.
+    for (const ID id : due) {
+        auto it = index.find(id);
+        if (it == index.end()) {
+            continue;
+        }
+        const Callback callback = std::move(it->second.second->callback);
+        wheel[it->second.first].erase(it->second.second);
+        index.erase(it);
+        if (index.empty()) {
+            uv_timer_stop(timer);
+        }
+        callback();
+    }
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef MBGL_STORAGE_TIMER_WHEEL
+#define MBGL_STORAGE_TIMER_WHEEL
+
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+typedef struct uv_loop_s uv_loop_t;
+typedef struct uv_timer_s uv_timer_t;
+
+namespace mbgl {
+
+// Runs callbacks after a delay on a loop, like one uv_timer_t per callback would, but with a
+// single timer that ticks every /tick/ milliseconds while any callback is scheduled. Deadlines are
+// rounded up to the next tick, so callbacks that are due in the same tick run in one wakeup.
+//
+// The callbacks are kept in a hashed wheel of /slots/ lists, one for each tick; callbacks that
+// are due more than one turn of the wheel ahead wait for the wheel to come around.
+//
+// Only used on the thread of the loop.
+class TimerWheel : private util::noncopyable {
+public:
+    typedef std::function<void()> Callback;
+    // 0 never identifies a scheduled callback.
+    typedef uint64_t ID;
+
+    TimerWheel(uv_loop_t *loop, uint64_t tick = 100, size_t slots = 256);
+    ~TimerWheel();
+
+    ID schedule(uint64_t delay, Callback callback);
+
+    // Returns whether the callback was still scheduled.
+    bool cancel(ID id);
+
+    inline size_t size() const { return index.size(); }
+
+private:
+    struct Timer {
+        ID id;
+        // Turns of the wheel until the callback is due.
+        uint64_t rounds;
+        Callback callback;
+    };
+    typedef std::list<Timer> Slot;
+
+    void advance();
+
+    uv_loop_t *const loop;
+    uv_timer_t *timer;
+    const uint64_t tick;
+
+    std::vector<Slot> wheel;
+    std::unordered_map<ID, std::pair<size_t, Slot::iterator>> index;
+
+    // The slot of the last tick, and when it was due.
+    size_t current = 0;
+    uint64_t lastTick = 0;
+    ID nextID = 1;
+};
+
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include <mbgl/style/applied_class_properties.hpp>
 
+#include <algorithm>
+
 namespace mbgl {
 
 AppliedClassProperty::AppliedClassProperty(ClassID class_id, timestamp begin_, timestamp end_, const PropertyValue &value_)
@@ -21,6 +23,21 @@ bool AppliedClassProperties::hasTransitions() const {
     return properties.size() > 1;
 }
 
+timestamp AppliedClassProperties::nextTransition(timestamp now) const {
+    // Like in hasTransitions(), the first property is the value that is being transitioned from.
+    if (!hasTransitions()) {
+        return noTransition;
+    }
+
+    timestamp next = noTransition;
+    for (auto it = std::next(properties.begin()); it != properties.end(); it++) {
+        if (it->end > now) {
+            next = std::min(next, std::max(it->begin, now));
+        }
+    }
+    return next;
+}
+
 // Erase all items in the property list that are before a completed transition.
 // Then, if the only remaining property is a Fallback value, remove it too.
 void AppliedClassProperties::cleanup(timestamp now) {
@@ -3,6 +3,7 @@
 
 #include <mbgl/style/property_value.hpp>
 #include <mbgl/style/class_dictionary.hpp>
+#include <mbgl/style/property_transition.hpp>
 #include <mbgl/util/time.hpp>
 
 #include <list>
@@ -30,6 +31,9 @@ public:
     ClassID mostRecent() const;
     void add(ClassID class_id, timestamp begin, timestamp end, const PropertyValue &value);
     bool hasTransitions() const;
+    // Returns the earliest time from now on at which a transition changes the value, which is
+    // later than now only for transitions that are delayed, or noTransition.
+    timestamp nextTransition(timestamp now) const;
     void cleanup(timestamp now);
     bool empty() const;
 };
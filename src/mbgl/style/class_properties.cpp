@@ -3,12 +3,8 @@
 namespace mbgl {
 
 const PropertyTransition &ClassProperties::getTransition(PropertyKey key, const PropertyTransition &defaultTransition) const {
-    auto it = transitions.find(key);
-    if (it == transitions.end()) {
-        return defaultTransition;
-    } else {
-        return it->second;
-    }
+    const PropertyTransition *transition = transitions.find(key);
+    return transition ? *transition : defaultTransition;
 }
 
 }
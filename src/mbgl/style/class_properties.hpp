@@ -4,8 +4,7 @@
 #include <mbgl/style/property_key.hpp>
 #include <mbgl/style/property_value.hpp>
 #include <mbgl/style/property_transition.hpp>
-
-#include <map>
+#include <mbgl/style/property_key_map.hpp>
 
 namespace mbgl {
 
@@ -13,7 +12,8 @@ class ClassProperties {
 public:
     inline ClassProperties() {}
     inline ClassProperties(ClassProperties &&properties_)
-        : properties(std::move(properties_.properties)) {}
+        : properties(std::move(properties_.properties)),
+          transitions(std::move(properties_.transitions)) {}
 
     inline void set(PropertyKey key, const PropertyValue &value) {
         properties.emplace(key, value);
@@ -26,16 +26,16 @@ public:
     const PropertyTransition &getTransition(PropertyKey key, const PropertyTransition &defaultTransition) const;
 
     // Route-through iterable interface so that you can iterate on the object as is.
-    inline std::map<PropertyKey, PropertyValue>::const_iterator begin() const {
+    inline PropertyKeyMap<PropertyValue>::const_iterator begin() const {
         return properties.begin();
     }
-    inline std::map<PropertyKey, PropertyValue>::const_iterator end() const {
+    inline PropertyKeyMap<PropertyValue>::const_iterator end() const {
         return properties.end();
     }
 
 public:
-    std::map<PropertyKey, PropertyValue> properties;
-    std::map<PropertyKey, PropertyTransition> transitions;
+    PropertyKeyMap<PropertyValue> properties;
+    PropertyKeyMap<PropertyTransition> transitions;
 };
 
 }
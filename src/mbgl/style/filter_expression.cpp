@@ -16,6 +16,13 @@ Value parseFeatureType(const Value& value) {
     }
 }
 
+FilterKey parseFilterKey(const rapidjson::Value& value) {
+    FilterKey key;
+    key.name = { value.GetString(), value.GetStringLength() };
+    key.id = KeyDictionary::Get().lookup(key.name);
+    return key;
+}
+
 template <class Expression>
 FilterExpression parseBinaryFilter(const rapidjson::Value& value) {
     FilterExpression empty;
@@ -31,10 +38,10 @@ FilterExpression parseBinaryFilter(const rapidjson::Value& value) {
     }
 
     Expression expression;
-    expression.key = { value[1u].GetString(), value[1u].GetStringLength() };
+    expression.key = parseFilterKey(value[1u]);
     expression.value = parseValue(value[2u]);
 
-    if (expression.key == "$type") {
+    if (expression.key.id == TypeKeyID) {
         expression.value = parseFeatureType(expression.value);
     }
 
@@ -56,7 +63,7 @@ FilterExpression parseSetFilter(const rapidjson::Value& value) {
     }
 
     Expression expression;
-    expression.key = { value[1u].GetString(), value[1u].GetStringLength() };
+    expression.key = parseFilterKey(value[1u]);
     for (rapidjson::SizeType i = 2; i < value.Size(); ++i) {
         expression.values.push_back(parseValue(value[i]));
     }
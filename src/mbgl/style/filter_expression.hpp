@@ -2,6 +2,7 @@
 #define MBGL_STYLE_FILTER_EXPRESSION
 
 #include <mbgl/style/value.hpp>
+#include <mbgl/style/key_dictionary.hpp>
 
 #include <rapidjson/document.h>
 
@@ -27,6 +28,15 @@ typedef mapbox::util::variant<
 
 FilterExpression parseFilterExpression(const rapidjson::Value&);
 
+// The feature property a comparison refers to. Extractors that only understand strings can
+// keep using the name; the vector tile extractor uses the interned id.
+struct FilterKey {
+    std::string name;
+    KeyID id = UnknownKeyID;
+
+    inline operator const std::string&() const { return name; }
+};
+
 template <class Extractor>
 bool evaluate(const FilterExpression&, const Extractor&);
 
@@ -36,7 +46,7 @@ struct NullExpression {
 };
 
 struct EqualsExpression {
-    std::string key;
+    FilterKey key;
     Value value;
 
     template <class Extractor>
@@ -44,7 +54,7 @@ struct EqualsExpression {
 };
 
 struct NotEqualsExpression {
-    std::string key;
+    FilterKey key;
     Value value;
 
     template <class Extractor>
@@ -52,7 +62,7 @@ struct NotEqualsExpression {
 };
 
 struct LessThanExpression {
-    std::string key;
+    FilterKey key;
     Value value;
 
     template <class Extractor>
@@ -60,7 +70,7 @@ struct LessThanExpression {
 };
 
 struct LessThanEqualsExpression {
-    std::string key;
+    FilterKey key;
     Value value;
 
     template <class Extractor>
@@ -68,7 +78,7 @@ struct LessThanEqualsExpression {
 };
 
 struct GreaterThanExpression {
-    std::string key;
+    FilterKey key;
     Value value;
 
     template <class Extractor>
@@ -76,7 +86,7 @@ struct GreaterThanExpression {
 };
 
 struct GreaterThanEqualsExpression {
-    std::string key;
+    FilterKey key;
     Value value;
 
     template <class Extractor>
@@ -84,7 +94,7 @@ struct GreaterThanEqualsExpression {
 };
 
 struct InExpression {
-    std::string key;
+    FilterKey key;
     std::vector<Value> values;
 
     template <class Extractor>
@@ -92,7 +102,7 @@ struct InExpression {
 };
 
 struct NotInExpression {
-    std::string key;
+    FilterKey key;
     std::vector<Value> values;
 
     template <class Extractor>
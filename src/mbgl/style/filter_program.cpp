@@ -0,0 +1,129 @@
+#include <mbgl/style/filter_program.hpp>
+
+namespace mbgl {
+
+FilterProgram::Constant::Constant(const Value& value) {
+    if (value.is<std::string>()) {
+        kind = Kind::String;
+        string = value.get<std::string>();
+    } else if (value.is<bool>()) {
+        kind = Kind::Bool;
+        boolean = value.get<bool>();
+    } else if (value.is<int64_t>()) {
+        kind = Kind::Int;
+        int_value = value.get<int64_t>();
+        number = double(int_value);
+    } else if (value.is<uint64_t>()) {
+        kind = Kind::Uint;
+        uint_value = value.get<uint64_t>();
+        number = double(uint_value);
+    } else {
+        kind = Kind::Double;
+        number = value.get<double>();
+    }
+}
+
+namespace {
+
+typedef FilterProgram::Op Op;
+
+struct FilterCompiler : public mapbox::util::static_visitor<void> {
+    FilterProgram& program;
+
+    FilterCompiler(FilterProgram& program_) : program(program_) {}
+
+    void operator()(const NullExpression&) const {
+        emit(Op::Constant, 0, true);
+    }
+
+    void operator()(const EqualsExpression& e) const { comparison(Op::Equals, e); }
+    void operator()(const NotEqualsExpression& e) const { comparison(Op::NotEquals, e); }
+    void operator()(const LessThanExpression& e) const { comparison(Op::LessThan, e); }
+    void operator()(const LessThanEqualsExpression& e) const { comparison(Op::LessThanEquals, e); }
+    void operator()(const GreaterThanExpression& e) const { comparison(Op::GreaterThan, e); }
+    void operator()(const GreaterThanEqualsExpression& e) const { comparison(Op::GreaterThanEquals, e); }
+
+    void operator()(const InExpression& e) const { set(Op::In, e); }
+    void operator()(const NotInExpression& e) const { set(Op::NotIn, e); }
+
+    void operator()(const AnyExpression& e) const {
+        compound(e.expressions, Op::JumpIfTrue, false);
+    }
+
+    void operator()(const AllExpression& e) const {
+        compound(e.expressions, Op::JumpIfFalse, true);
+    }
+
+    void operator()(const NoneExpression& e) const {
+        compound(e.expressions, Op::JumpIfTrue, false);
+        emit(Op::Not);
+    }
+
+private:
+    void emit(Op op, uint32_t key = 0, uint32_t operand = 0, uint32_t count = 0) const {
+        FilterProgram::Instruction instruction;
+        instruction.op = op;
+        instruction.key = key;
+        instruction.operand = operand;
+        instruction.count = count;
+        program.instructions.push_back(instruction);
+    }
+
+    uint32_t key(const FilterKey& key) const {
+        for (size_t i = 0; i < program.keys.size(); ++i) {
+            if (program.keys[i].name == key.name) {
+                return uint32_t(i);
+            }
+        }
+        program.keys.push_back(key);
+        return uint32_t(program.keys.size() - 1);
+    }
+
+    template <class Expression>
+    void comparison(Op op, const Expression& e) const {
+        program.constants.emplace_back(e.value);
+        emit(op, key(e.key), uint32_t(program.constants.size() - 1));
+    }
+
+    template <class Expression>
+    void set(Op op, const Expression& e) const {
+        const uint32_t first = uint32_t(program.constants.size());
+        for (const Value& value : e.values) {
+            program.constants.emplace_back(value);
+        }
+        emit(op, key(e.key), first, uint32_t(e.values.size()));
+    }
+
+    // Evaluates the expressions in order and jumps to the end as soon as one of them
+    // produces a result that decides the whole expression.
+    void compound(const std::vector<FilterExpression>& expressions, Op jump, bool empty) const {
+        if (expressions.empty()) {
+            emit(Op::Constant, 0, empty);
+            return;
+        }
+
+        std::vector<size_t> jumps;
+        for (size_t i = 0; i < expressions.size(); ++i) {
+            mapbox::util::apply_visitor(*this, expressions[i]);
+            if (i + 1 < expressions.size()) {
+                jumps.push_back(program.instructions.size());
+                emit(jump);
+            }
+        }
+
+        const uint32_t end = uint32_t(program.instructions.size());
+        for (size_t index : jumps) {
+            program.instructions[index].operand = end;
+        }
+    }
+};
+
+}
+
+FilterProgram::FilterProgram(const FilterExpression& expression) {
+    if (!expression.is<NullExpression>()) {
+        mapbox::util::apply_visitor(FilterCompiler(*this), expression);
+    }
+}
+
+}
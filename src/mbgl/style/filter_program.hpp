@@ -0,0 +1,73 @@
+#ifndef MBGL_STYLE_FILTER_PROGRAM
+#define MBGL_STYLE_FILTER_PROGRAM
+
+#include <mbgl/style/filter_expression.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace mbgl {
+
+/*
+ * A FilterExpression lowered into a flat list of instructions. Compound
+ * expressions become short-circuit jumps and comparison constants are
+ * classified up front, so evaluating a feature is a single loop instead of a
+ * recursive walk over the expression variant.
+ */
+class FilterProgram {
+public:
+    // The empty program matches every feature.
+    FilterProgram() = default;
+    explicit FilterProgram(const FilterExpression&);
+
+    template <class Extractor>
+    bool evaluate(const Extractor&) const;
+
+    inline bool empty() const { return instructions.empty(); }
+
+public:
+    enum class Op : uint8_t {
+        Constant,       // result = operand
+        Equals,         // result = key == constants[operand]
+        NotEquals,
+        LessThan,
+        LessThanEquals,
+        GreaterThan,
+        GreaterThanEquals,
+        In,             // result = key in constants[operand, operand + count)
+        NotIn,
+        Not,            // result = !result
+        JumpIfTrue,     // if (result) jump to operand
+        JumpIfFalse,    // if (!result) jump to operand
+    };
+
+    struct Instruction {
+        Op op;
+        uint32_t key = 0;
+        uint32_t operand = 0;
+        uint32_t count = 0;
+    };
+
+    struct Constant {
+        enum class Kind : uint8_t { Bool, Int, Uint, Double, String };
+
+        Constant(const Value&);
+
+        Kind kind;
+        bool boolean = false;
+        int64_t int_value = 0;
+        uint64_t uint_value = 0;
+        // Numeric constants are also stored as double for comparisons with
+        // values of a different numeric type.
+        double number = 0;
+        std::string string;
+    };
+
+    std::vector<Instruction> instructions;
+    std::vector<FilterKey> keys;
+    std::vector<Constant> constants;
+};
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+#include <mbgl/style/filter_program.hpp>
+#include <mbgl/util/optional.hpp>
+
+#include <functional>
+
+namespace mbgl {
+
+namespace detail {
+
+template <template <typename> class Operator>
+bool compareConstant(const Value& actual, const FilterProgram::Constant& constant) {
+    typedef FilterProgram::Constant::Kind Kind;
+
+    switch (constant.kind) {
+    case Kind::String:
+        return actual.is<std::string>() && Operator<std::string>()(actual.get<std::string>(), constant.string);
+    case Kind::Bool:
+        return actual.is<bool>() && Operator<bool>()(actual.get<bool>(), constant.boolean);
+    default:
+        break;
+    }
+
+    // Numbers of the same type compare exactly; mixed numeric types compare as double.
+    if (actual.is<int64_t>()) {
+        return constant.kind == Kind::Int
+            ? Operator<int64_t>()(actual.get<int64_t>(), constant.int_value)
+            : Operator<double>()(double(actual.get<int64_t>()), constant.number);
+    } else if (actual.is<uint64_t>()) {
+        return constant.kind == Kind::Uint
+            ? Operator<uint64_t>()(actual.get<uint64_t>(), constant.uint_value)
+            : Operator<double>()(double(actual.get<uint64_t>()), constant.number);
+    } else if (actual.is<double>()) {
+        return Operator<double>()(actual.get<double>(), constant.number);
+    }
+
+    return false;
+}
+
+}
+
+template <class Extractor>
+bool FilterProgram::evaluate(const Extractor& extractor) const {
+    bool result = true;
+
+    const size_t size = instructions.size();
+    for (size_t pc = 0; pc < size; ++pc) {
+        const Instruction& instruction = instructions[pc];
+
+        switch (instruction.op) {
+        case Op::Constant:
+            result = instruction.operand;
+            continue;
+        case Op::Not:
+            result = !result;
+            continue;
+        case Op::JumpIfTrue:
+            if (result) pc = instruction.operand - 1;
+            continue;
+        case Op::JumpIfFalse:
+            if (!result) pc = instruction.operand - 1;
+            continue;
+        default:
+            break;
+        }
+
+        // Either a pointer or an optional, depending on the extractor.
+        const auto actual = extractor.getValue(keys[instruction.key]);
+
+        switch (instruction.op) {
+        case Op::Equals:
+            result = actual && detail::compareConstant<std::equal_to>(*actual, constants[instruction.operand]);
+            break;
+        case Op::NotEquals:
+            result = !actual || detail::compareConstant<std::not_equal_to>(*actual, constants[instruction.operand]);
+            break;
+        case Op::LessThan:
+            result = actual && detail::compareConstant<std::less>(*actual, constants[instruction.operand]);
+            break;
+        case Op::LessThanEquals:
+            result = actual && detail::compareConstant<std::less_equal>(*actual, constants[instruction.operand]);
+            break;
+        case Op::GreaterThan:
+            result = actual && detail::compareConstant<std::greater>(*actual, constants[instruction.operand]);
+            break;
+        case Op::GreaterThanEquals:
+            result = actual && detail::compareConstant<std::greater_equal>(*actual, constants[instruction.operand]);
+            break;
+        case Op::In:
+        case Op::NotIn: {
+            bool found = false;
+            if (actual) {
+                for (uint32_t i = 0; i < instruction.count && !found; ++i) {
+                    found = detail::compareConstant<std::equal_to>(*actual, constants[instruction.operand + i]);
+                }
+            }
+            result = (instruction.op == Op::In) == found;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    return result;
+}
+
+}
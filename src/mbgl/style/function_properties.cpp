@@ -2,7 +2,9 @@
 #include <mbgl/style/types.hpp>
 #include <mbgl/util/interpolate.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <iterator>
 
 namespace mbgl {
 
@@ -16,55 +18,84 @@ template <> inline std::vector<float> defaultStopsValue() { return {{ 1, 0 }}; }
 
 
 template <typename T>
-T StopsFunction<T>::evaluate(float z) const {
-    bool smaller = false;
-    float smaller_z = 0.0f;
-    T smaller_val = T();
-    bool larger = false;
-    float larger_z = 0.0f;
-    T larger_val = T();
-
-    for (uint32_t i = 0; i < values.size(); i++) {
-        float stop_z = values[i].first;
-        T stop_val = values[i].second;
-        if (stop_z <= z && (!smaller || smaller_z < stop_z)) {
-            smaller = true;
-            smaller_z = stop_z;
-            smaller_val = stop_val;
-        }
-        if (stop_z >= z && (!larger || larger_z > stop_z)) {
-            larger = true;
-            larger_z = stop_z;
-            larger_val = stop_val;
-        }
+StopsFunction<T>::StopsFunction(const std::vector<std::pair<float, T>> &values_, float base_)
+    : values(values_), base(base_) {
+    std::stable_sort(values.begin(), values.end(), [](const std::pair<float, T> &a, const std::pair<float, T> &b) {
+        return a.first < b.first;
+    });
+    values.erase(std::unique(values.begin(), values.end(), [](const std::pair<float, T> &a, const std::pair<float, T> &b) {
+        return a.first == b.first;
+    }), values.end());
+
+    for (size_t i = 1; i < values.size(); i++) {
+        const float zoomDiff = values[i].first - values[i - 1].first;
+        spans.push_back(base == 1.0f ? zoomDiff : std::pow(base, zoomDiff) - 1);
     }
+}
 
-    if (smaller && larger) {
-        if (larger_z == smaller_z || larger_val == smaller_val) {
-            return smaller_val;
-        }
-        const float zoomDiff = larger_z - smaller_z;
-        const float zoomProgress = z - smaller_z;
-        if (base == 1.0f) {
-            const float t = zoomProgress / zoomDiff;
-            return util::interpolate(smaller_val, larger_val, t);
-        } else {
-            const float t = (std::pow(base, zoomProgress) - 1) / (std::pow(base, zoomDiff) - 1);
-            return util::interpolate(smaller_val, larger_val, t);
-        }
-    } else if (larger) {
-        return larger_val;
-    } else if (smaller) {
-        return smaller_val;
-    } else {
+template <typename T>
+T StopsFunction<T>::evaluate(float z) const {
+    if (values.empty()) {
         // No stop defined.
         return defaultStopsValue<T>();
     }
+
+    // The first stop above z.
+    const auto larger = std::upper_bound(values.begin(), values.end(), z, [](float z_, const std::pair<float, T> &stop) {
+        return z_ < stop.first;
+    });
+    if (larger == values.begin()) {
+        return larger->second;
+    }
+
+    const auto smaller = std::prev(larger);
+    if (larger == values.end() || smaller->first == z || smaller->second == larger->second) {
+        return smaller->second;
+    }
+
+    const float zoomProgress = z - smaller->first;
+    const float span = spans[smaller - values.begin()];
+    const float t = (base == 1.0f ? zoomProgress : std::pow(base, zoomProgress) - 1) / span;
+    return util::interpolate(smaller->second, larger->second, t);
+}
+
+template <typename T>
+std::pair<float, float> StopsFunction<T>::constantRange(float z) const {
+    std::pair<float, float> range = allZoomLevels();
+    if (values.empty()) {
+        return range;
+    }
+
+    // Finds the same stops as evaluate().
+    const auto larger = std::upper_bound(values.begin(), values.end(), z, [](float z_, const std::pair<float, T> &stop) {
+        return z_ < stop.first;
+    });
+    if (larger == values.begin()) {
+        range.second = larger->first;
+    } else if (larger == values.end()) {
+        range.first = std::prev(larger)->first;
+    } else if (std::prev(larger)->first == z || std::prev(larger)->second != larger->second) {
+        // On a stop, or interpolating between two stops.
+        range = { z, z };
+    } else {
+        range = { std::prev(larger)->first, larger->first };
+    }
+    return range;
 }
 
+template StopsFunction<bool>::StopsFunction(const std::vector<std::pair<float, bool>> &, float);
+template StopsFunction<float>::StopsFunction(const std::vector<std::pair<float, float>> &, float);
+template StopsFunction<Color>::StopsFunction(const std::vector<std::pair<float, Color>> &, float);
+template StopsFunction<std::vector<float>>::StopsFunction(const std::vector<std::pair<float, std::vector<float>>> &, float);
+
 template bool StopsFunction<bool>::evaluate(float z) const;
 template float StopsFunction<float>::evaluate(float z) const;
 template Color StopsFunction<Color>::evaluate(float z) const;
 template std::vector<float> StopsFunction<std::vector<float>>::evaluate(float z) const;
 
+template std::pair<float, float> StopsFunction<bool>::constantRange(float z) const;
+template std::pair<float, float> StopsFunction<float>::constantRange(float z) const;
+template std::pair<float, float> StopsFunction<Color>::constantRange(float z) const;
+template std::pair<float, float> StopsFunction<std::vector<float>>::constantRange(float z) const;
+
 }
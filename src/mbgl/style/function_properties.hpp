@@ -3,10 +3,17 @@
 
 #include <mbgl/util/variant.hpp>
 
+#include <limits>
+#include <utility>
 #include <vector>
 
 namespace mbgl {
 
+// A zoom range that no function narrows.
+inline std::pair<float, float> allZoomLevels() {
+    return { -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() };
+}
+
 template <typename T>
 struct ConstantFunction {
     inline ConstantFunction(const T &value_) : value(value_) {}
@@ -18,12 +25,21 @@ private:
 
 template <typename T>
 struct StopsFunction {
-    inline StopsFunction(const std::vector<std::pair<float, T>> &values_, float base_) : values(values_), base(base_) {}
+    // Sorts the stops by zoom level, so that they can be searched, and precomputes the
+    // interpolation scale of every span. Of stops with the same zoom level, the first one wins.
+    StopsFunction(const std::vector<std::pair<float, T>> &values, float base);
     T evaluate(float z) const;
 
+    // Returns the zoom levels around z at which evaluate() returns the same value as at z.
+    std::pair<float, float> constantRange(float z) const;
+
 private:
-    const std::vector<std::pair<float, T>> values;
+    std::vector<std::pair<float, T>> values;
     const float base;
+
+    // The interpolation denominator of the span that starts at every stop: base ^ span - 1, or
+    // span if base is 1.
+    std::vector<float> spans;
 };
 
 template <typename T>
@@ -0,0 +1,37 @@
+#include <mbgl/style/key_dictionary.hpp>
+
+namespace mbgl {
+
+KeyDictionary::KeyDictionary() {}
+
+KeyDictionary &KeyDictionary::Get() {
+    static KeyDictionary dictionary;
+    return dictionary;
+}
+
+KeyID KeyDictionary::lookup(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = store.find(key);
+    if (it == store.end()) {
+        // Insert the key into the store.
+        const KeyID id = KeyID(store.size());
+        store.emplace(key, id);
+        return id;
+    } else {
+        return it->second;
+    }
+}
+
+std::vector<int32_t> KeyDictionary::resolve(const std::vector<std::string> &keys) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<int32_t> indices(store.size(), -1);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        auto it = store.find(keys[i]);
+        if (it != store.end()) {
+            indices[it->second] = int32_t(i);
+        }
+    }
+    return indices;
+}
+
+}
@@ -0,0 +1,44 @@
+#ifndef MBGL_STYLE_KEY_DICTIONARY
+#define MBGL_STYLE_KEY_DICTIONARY
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mbgl {
+
+// Integer IDs for the feature property keys referenced by filters, so that matching a filter
+// against a feature compares integers instead of strings.
+typedef uint32_t KeyID;
+
+const KeyID TypeKeyID = 0; // The "$type" pseudo-key
+const KeyID UnknownKeyID = std::numeric_limits<KeyID>::max();
+
+class KeyDictionary {
+private:
+    KeyDictionary();
+
+public:
+    // Keys are shared between the style parser and the tile workers, so unlike the
+    // ClassDictionary, this store is process-wide and synchronized.
+    static KeyDictionary &Get();
+
+    // Returns an ID for a key. If the key does not yet have an ID, one is auto-generated and
+    // stored for future reference. IDs remain valid for the lifetime of the process.
+    KeyID lookup(const std::string &key);
+
+    // Maps every known KeyID to the index of that key in the given list of keys, or -1 if the
+    // list doesn't contain this key. Keys that don't have an ID yet are ignored.
+    std::vector<int32_t> resolve(const std::vector<std::string> &keys) const;
+
+private:
+    mutable std::mutex mtx;
+    std::unordered_map<std::string, KeyID> store = { { "$type", TypeKeyID } };
+};
+
+}
+
+#endif
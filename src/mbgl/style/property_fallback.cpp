@@ -21,6 +21,14 @@ const std::map<PropertyKey, PropertyValue> PropertyFallbackValue::properties = {
     { PropertyKey::LineGapWidth, defaultStyleProperties<LineProperties>().gap_width },
     { PropertyKey::LineBlur, defaultStyleProperties<LineProperties>().blur },
 
+    { PropertyKey::CircleOpacity, defaultStyleProperties<CircleProperties>().opacity },
+    { PropertyKey::CircleColor, defaultStyleProperties<CircleProperties>().color },
+    { PropertyKey::CircleTranslateX, defaultStyleProperties<CircleProperties>().translate[0] },
+    { PropertyKey::CircleTranslateY, defaultStyleProperties<CircleProperties>().translate[1] },
+    { PropertyKey::CircleTranslateAnchor, defaultStyleProperties<CircleProperties>().translateAnchor },
+    { PropertyKey::CircleRadius, defaultStyleProperties<CircleProperties>().radius },
+    { PropertyKey::CircleBlur, defaultStyleProperties<CircleProperties>().blur },
+
     { PropertyKey::IconOpacity, defaultStyleProperties<SymbolProperties>().icon.opacity },
     { PropertyKey::IconRotate, defaultStyleProperties<SymbolProperties>().icon.rotate },
     { PropertyKey::IconSize, defaultStyleProperties<SymbolProperties>().icon.size },
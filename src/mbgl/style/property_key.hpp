@@ -1,6 +1,8 @@
 #ifndef MBGL_STYLE_PROPERTY_KEY
 #define MBGL_STYLE_PROPERTY_KEY
 
+#include <cstddef>
+
 namespace mbgl {
 
 enum class PropertyKey {
@@ -26,6 +28,15 @@ enum class PropertyKey {
     LineDashArray, // for transitions only
     LineImage,
 
+    CircleOpacity,
+    CircleColor,
+    CircleTranslate, // for transitions only
+    CircleTranslateX,
+    CircleTranslateY,
+    CircleTranslateAnchor,
+    CircleRadius,
+    CircleBlur,
+
     IconOpacity,
     IconRotate,
     IconSize,
@@ -63,6 +74,9 @@ enum class PropertyKey {
     BackgroundImage
 };
 
+// The number of property keys, for tables that are indexed by key.
+const size_t PropertyKeyCount = size_t(PropertyKey::BackgroundImage) + 1;
+
 }
 
 #endif
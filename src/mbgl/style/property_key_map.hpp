@@ -0,0 +1,131 @@
+#ifndef MBGL_STYLE_PROPERTY_KEY_MAP
+#define MBGL_STYLE_PROPERTY_KEY_MAP
+
+#include <mbgl/style/property_key.hpp>
+
+#include <array>
+#include <bitset>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mbgl {
+
+// Maps property keys to values in a table with a slot for every key, so that lookups don't have
+// to search. Iterates in key order, like a std::map would. Values are only constructed in the
+// slots that are used, and never assigned to, which variants don't support for all types.
+template <typename T>
+class PropertyKeyMap {
+public:
+    inline PropertyKeyMap() {}
+    inline PropertyKeyMap(const PropertyKeyMap &other) : present(other.present) {
+        for (size_t i = 0; i < PropertyKeyCount; i++) {
+            if (present[i]) {
+                new (&values[i]) T(other.at(i));
+            }
+        }
+    }
+    inline PropertyKeyMap(PropertyKeyMap &&other) : present(other.present) {
+        for (size_t i = 0; i < PropertyKeyCount; i++) {
+            if (present[i]) {
+                new (&values[i]) T(std::move(other.at(i)));
+            }
+        }
+    }
+    PropertyKeyMap &operator=(const PropertyKeyMap &) = delete;
+    PropertyKeyMap &operator=(PropertyKeyMap &&) = delete;
+
+    inline ~PropertyKeyMap() {
+        for (size_t i = 0; i < PropertyKeyCount; i++) {
+            if (present[i]) {
+                at(i).~T();
+            }
+        }
+    }
+
+    template <typename Map, typename Value>
+    class basic_iterator {
+    public:
+        inline basic_iterator(Map &map_, size_t index_) : map(map_), index(index_) { skip(); }
+
+        inline std::pair<PropertyKey, Value &> operator*() const {
+            return { PropertyKey(index), map.at(index) };
+        }
+        inline basic_iterator &operator++() {
+            index++;
+            skip();
+            return *this;
+        }
+        inline bool operator==(const basic_iterator &other) const { return index == other.index; }
+        inline bool operator!=(const basic_iterator &other) const { return index != other.index; }
+
+    private:
+        inline void skip() {
+            while (index < PropertyKeyCount && !map.present[index]) {
+                index++;
+            }
+        }
+
+        Map &map;
+        size_t index;
+    };
+
+    typedef basic_iterator<PropertyKeyMap, T> iterator;
+    typedef basic_iterator<const PropertyKeyMap, const T> const_iterator;
+
+    inline bool has(PropertyKey key) const {
+        return present[size_t(key)];
+    }
+
+    // Returns nullptr if there is no value for the key.
+    inline T *find(PropertyKey key) {
+        return has(key) ? &at(size_t(key)) : nullptr;
+    }
+    inline const T *find(PropertyKey key) const {
+        return has(key) ? &at(size_t(key)) : nullptr;
+    }
+
+    // Adds a default constructed value if there is none for the key.
+    inline T &operator[](PropertyKey key) {
+        if (!has(key)) {
+            new (&values[size_t(key)]) T();
+            present.set(size_t(key));
+        }
+        return at(size_t(key));
+    }
+
+    // Doesn't replace an existing value.
+    inline void emplace(PropertyKey key, const T &value) {
+        if (!has(key)) {
+            new (&values[size_t(key)]) T(value);
+            present.set(size_t(key));
+        }
+    }
+
+    inline void erase(PropertyKey key) {
+        if (has(key)) {
+            at(size_t(key)).~T();
+            present.reset(size_t(key));
+        }
+    }
+
+    inline bool empty() const {
+        return present.none();
+    }
+
+    inline iterator begin() { return iterator(*this, 0); }
+    inline iterator end() { return iterator(*this, PropertyKeyCount); }
+    inline const_iterator begin() const { return const_iterator(*this, 0); }
+    inline const_iterator end() const { return const_iterator(*this, PropertyKeyCount); }
+
+private:
+    inline T &at(size_t index) { return *reinterpret_cast<T *>(&values[index]); }
+    inline const T &at(size_t index) const { return *reinterpret_cast<const T *>(&values[index]); }
+
+    std::array<typename std::aligned_storage<sizeof(T), alignof(T)>::type, PropertyKeyCount> values;
+    std::bitset<PropertyKeyCount> present;
+};
+
+}
+
+#endif
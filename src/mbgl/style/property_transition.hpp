@@ -1,7 +1,10 @@
 #ifndef MBGL_STYLE_PROPERTY_TRANSITION
 #define MBGL_STYLE_PROPERTY_TRANSITION
 
+#include <mbgl/util/time.hpp>
+
 #include <cstdint>
+#include <limits>
 
 namespace mbgl {
 
@@ -10,6 +13,9 @@ struct PropertyTransition {
     uint16_t delay = 0;
 };
 
+// Returned by nextTransition() when no transition is pending.
+constexpr timestamp noTransition = std::numeric_limits<timestamp>::max();
+
 }
 
 #endif
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include <mbgl/style/style.hpp>
 #include <mbgl/map/sprite.hpp>
 #include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/style/style_layer.hpp>
 #include <mbgl/style/style_parser.hpp>
+#include <mbgl/style/style_binary.hpp>
 #include <mbgl/style/style_bucket.hpp>
 #include <mbgl/util/constants.hpp>
 #include <mbgl/util/time.hpp>
@@ -15,6 +17,11 @@
 
 #include <algorithm>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace mbgl {
 
 Style::Style()
@@ -49,9 +56,144 @@ void Style::setDefaultTransitionDuration(uint16_t duration_milliseconds) {
 }
 
 void Style::cascadeClasses(const std::vector<std::string>& classes) {
-    if (layers) {
-        layers->setClasses(classes, util::now(), defaultTransition);
+    // From here on, we're only dealing with IDs to avoid comparing strings in every layer.
+    std::vector<ClassID> class_ids;
+    class_ids.reserve(classes.size());
+    for (const std::string &class_name : classes) {
+        class_ids.push_back(ClassDictionary::Get().lookup(class_name));
+    }
+
+    // Classes only change paint properties; the tiles' buckets stay as they are.
+    if (layers && layers->setClasses(class_ids, util::now(), defaultTransition)) {
+        generation++;
+    }
+}
+
+namespace {
+
+// Swaps the sources and buckets of /next/ that are defined exactly like in /previous/ for the ones
+// of /previous/. Kept sources keep their tiles, and the tiles keep the buckets that were kept.
+void keepUnchanged(const StyleLayerGroup &previous, StyleLayerGroup &next) {
+    std::unordered_map<std::string, util::ptr<StyleSource>> sources;
+    std::unordered_map<std::string, util::ptr<StyleBucket>> buckets;
+    for (const util::ptr<StyleLayer> &layer : previous.layers) {
+        if (!layer || !layer->bucket) continue;
+        if (layer->bucket->style_source) {
+            sources.emplace(layer->bucket->style_source->info.id, layer->bucket->style_source);
+        }
+        if (!layer->bucket->key.empty()) {
+            buckets.emplace(layer->bucket->key, layer->bucket);
+        }
+    }
+
+    // Tiles key their buckets by name, so a kept bucket must not take the name of another one.
+    std::set<std::string> names;
+    for (const util::ptr<StyleLayer> &layer : next.layers) {
+        if (layer && layer->bucket) {
+            names.insert(layer->bucket->name);
+        }
+    }
+
+    std::map<util::ptr<StyleBucket>, util::ptr<StyleBucket>> replaced;
+    for (const util::ptr<StyleLayer> &layer : next.layers) {
+        if (!layer || !layer->bucket) continue;
+        auto replaced_it = replaced.find(layer->bucket);
+        if (replaced_it != replaced.end()) {
+            layer->bucket = replaced_it->second;
+            continue;
+        }
+
+        const util::ptr<StyleBucket> bucket = layer->bucket;
+        if (bucket->style_source) {
+            auto source_it = sources.find(bucket->style_source->info.id);
+            if (source_it != sources.end() && source_it->second->definition == bucket->style_source->definition) {
+                bucket->style_source = source_it->second;
+            }
+        }
+
+        auto bucket_it = bucket->key.empty() ? buckets.end() : buckets.find(bucket->key);
+        if (bucket_it != buckets.end() && bucket_it->second->style_source == bucket->style_source &&
+            (bucket_it->second->name == bucket->name || !names.count(bucket_it->second->name))) {
+            layer->bucket = bucket_it->second;
+        }
+        replaced.emplace(bucket, layer->bucket);
+    }
+}
+
+// Parses a property into an object like the paint or layout object of a layer in a style. The
+// object is allocated by /doc/.
+bool parseProperty(rapidjson::Document &doc, rapidjson::Value &object,
+                   const std::string &name, const std::string &value) {
+    // The root of a document must be an object or an array, so the value goes into an array.
+    const std::string array = "[" + value + "]";
+    doc.Parse<0>(array.c_str());
+    if (doc.HasParseError() || doc.Size() != 1) {
+        Log::Warning(Event::ParseStyle, "value of '%s' isn't valid JSON", name.c_str());
+        return false;
+    }
+
+    // Moves the parsed value into the object.
+    object.SetObject();
+    object.AddMember(name.c_str(), doc.GetAllocator(), doc[rapidjson::SizeType(0)], doc.GetAllocator());
+    return true;
+}
+
+}
+
+bool Style::setPaintProperty(const std::string &layer_id, const std::string &name,
+                             const std::string &value, const std::string &klass) {
+    util::ptr<StyleLayer> layer = layers ? layers->getLayer(layer_id) : nullptr;
+    rapidjson::Document doc;
+    rapidjson::Value object;
+    if (!layer || !parseProperty(doc, object, name, value)) {
+        return false;
+    }
+
+    ClassProperties changes;
+    StyleParser().parsePaint(object, changes);
+    if (changes.properties.empty() && changes.transitions.empty()) {
+        return false;
     }
+
+    const ClassID class_id = klass.empty() ? ClassID::Default : ClassDictionary::Get().lookup(klass);
+
+    uv::writelock lock(mtx);
+    if (layers->setClassProperties(layer, class_id, changes, util::now(), defaultTransition)) {
+        generation++;
+    }
+    return true;
+}
+
+bool Style::setLayoutProperty(const std::string &layer_id, const std::string &name,
+                              const std::string &value) {
+    util::ptr<StyleLayer> layer = layers ? layers->getLayer(layer_id) : nullptr;
+    rapidjson::Document doc;
+    rapidjson::Value object;
+    if (!layer || !layer->bucket || !parseProperty(doc, object, name, value)) {
+        return false;
+    }
+
+    // Workers may be parsing tiles with the current bucket, so the changes go into a copy. It no
+    // longer matches its definition in the style.
+    auto bucket = std::make_shared<StyleBucket>(*layer->bucket);
+    StyleParser().parseLayout(object, *layer, *bucket);
+    bucket->key.clear();
+
+    // Tiles key their buckets by name. Layers that share the bucket keep the old one, so the copy
+    // needs a name of its own.
+    const bool shared = std::any_of(layers->layers.begin(), layers->layers.end(),
+                                    [&](const util::ptr<StyleLayer> &other) {
+        return other && other != layer && other->bucket == layer->bucket;
+    });
+    if (shared) {
+        bucket->name += "/" + layer->id;
+    }
+
+    uv::writelock lock(mtx);
+    layer->bucket = bucket;
+    generation++;
+    layoutGeneration++;
+    return true;
 }
 
 bool Style::hasTransitions() const {
@@ -63,21 +205,76 @@ bool Style::hasTransitions() const {
     return false;
 }
 
+timestamp Style::nextTransition(timestamp now) const {
+    return layers ? layers->nextTransition(now) : noTransition;
+}
+
 
 void Style::loadJSON(const uint8_t *const data) {
-    uv::writelock lock(mtx);
+    // Parsing in place lets the document point into this buffer instead of copying every string.
+    std::string buffer { (const char *)data };
 
     rapidjson::Document doc;
-    doc.Parse<0>((const char *const)data);
+    doc.ParseInsitu<0>(&buffer[0]);
     if (doc.HasParseError()) {
         Log::Error(Event::ParseStyle, "Error parsing style JSON at %i: %s", doc.GetErrorOffset(), doc.GetParseError());
         throw error::style_parse(doc.GetErrorOffset(), doc.GetParseError());
     }
 
+    load(doc);
+}
+
+void Style::loadBinary(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        Log::Error(Event::ParseStyle, "Cannot read style binary %s", path.c_str());
+        throw exception("cannot read style binary");
+    }
+
+    const size_t size = size_t(st.st_size);
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        Log::Error(Event::ParseStyle, "Cannot map style binary %s", path.c_str());
+        throw exception("cannot map style binary");
+    }
+
+    // The document points into the mapping, which only has to live while the parser runs.
+    rapidjson::Document doc;
+    if (!StyleBinary::decode(reinterpret_cast<const char *>(addr), size, doc)) {
+        munmap(addr, size);
+        Log::Error(Event::ParseStyle, "Invalid style binary %s", path.c_str());
+        throw exception("invalid style binary");
+    }
+
+    try {
+        load(doc);
+    } catch (...) {
+        munmap(addr, size);
+        throw;
+    }
+    munmap(addr, size);
+}
+
+void Style::load(const rapidjson::Value &doc) {
     StyleParser parser;
     parser.parse(doc);
 
-    layers = parser.getLayers();
+    util::ptr<StyleLayerGroup> next = parser.getLayers();
+    if (layers && next) {
+        keepUnchanged(*layers, *next);
+    }
+
+    // Only swapping in the result excludes the render thread, which keeps drawing the old style
+    // while the new one is parsed. Tiles of the sources that were kept rebuild the buckets that
+    // changed.
+    uv::writelock lock(mtx);
+    layers = next;
+    layoutGeneration++;
     sprite_url = parser.getSprite();
     glyph_url = parser.getGlyphURL();
 }
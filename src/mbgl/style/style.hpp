@@ -8,6 +8,9 @@
 #include <mbgl/util/uv.hpp>
 #include <mbgl/util/ptr.hpp>
 
+#include <rapidjson/document.h>
+
+#include <atomic>
 #include <cstdint>
 #include <map>
 #include <string>
@@ -29,6 +32,8 @@ public:
     ~Style();
 
     void loadJSON(const uint8_t *const data);
+    // Loads a style that StyleBinary compiled, by mapping the file into memory.
+    void loadBinary(const std::string &path);
 
     size_t layerCount() const;
     void updateProperties(float z, timestamp t);
@@ -36,7 +41,28 @@ public:
     void setDefaultTransitionDuration(uint16_t duration_milliseconds = 0);
     void cascadeClasses(const std::vector<std::string>&);
 
+    // Sets a paint property of a layer in a class, or in the default class if /klass/ is empty.
+    // /value/ is JSON, like the value of the property in a style. Only the properties change; the
+    // tiles' buckets stay as they are. Returns false if the layer or the property doesn't exist.
+    bool setPaintProperty(const std::string &layer_id, const std::string &name,
+                          const std::string &value, const std::string &klass);
+
+    // Sets a layout property of a layer. Tiles rebuild the buckets of that layer, and keep all
+    // others. Returns false if the layer doesn't exist or has no buckets.
+    bool setLayoutProperty(const std::string &layer_id, const std::string &name,
+                           const std::string &value);
+
     bool hasTransitions() const;
+    // Returns the time at which the next frame has to be rendered to show the transitions, or
+    // noTransition.
+    timestamp nextTransition(timestamp now) const;
+
+    // Changes whenever the classes are cascaded again, and thus whenever the layer properties may
+    // change without the zoom level changing.
+    inline uint64_t getGeneration() const { return generation; }
+
+    // Changes whenever the layout of a layer changed, and tiles have to rebuild its buckets.
+    inline uint64_t getLayoutGeneration() const { return layoutGeneration; }
 
     const std::string &getSpriteURL() const;
 
@@ -45,9 +71,13 @@ public:
     std::string glyph_url;
 
 private:
+    void load(const rapidjson::Value &document);
+
     std::string sprite_url;
     PropertyTransition defaultTransition;
     bool initial_render_complete = false;
+    uint64_t generation = 0;
+    std::atomic<uint64_t> layoutGeneration { 0 };
     std::unique_ptr<uv::rwlock> mtx;
 };
 
@@ -0,0 +1,310 @@
+#include <mbgl/style/style_binary.hpp>
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace mbgl {
+
+namespace {
+
+const char magic[4] = { 'M', 'B', 'G', 'S' };
+const uint32_t version = 1;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    // The string table follows the header; every string is stored as its length, the
+    // characters and a terminating zero.
+    uint32_t strings;
+    uint32_t stringBytes;
+};
+
+static_assert(sizeof(Header) == 16, "style binary header must be packed");
+
+enum class Tag : uint8_t {
+    Null,
+    False,
+    True,
+    Int,
+    Uint,
+    Int64,
+    Uint64,
+    Double,
+    // Followed by the index of the string in the table.
+    String,
+    // Followed by the number of elements and the elements.
+    Array,
+    // Followed by the number of members, and the index of the name and the value of each.
+    Object,
+};
+
+// Corrupt data must not exhaust the stack.
+const uint32_t maxDepth = 256;
+
+uint32_t memberCount(const rapidjson::Value &value) {
+    return uint32_t(value.MemberEnd() - value.MemberBegin());
+}
+
+class Compiler {
+public:
+    Compiler(const rapidjson::Value &document) {
+        if (document.IsObject() && document.HasMember("constants")) {
+            const rapidjson::Value &value = document["constants"];
+            if (value.IsObject()) {
+                for (auto itr = value.MemberBegin(); itr != value.MemberEnd(); ++itr) {
+                    std::string name { itr->name.GetString(), itr->name.GetStringLength() };
+                    if (name.length() && name[0] == '@') {
+                        constants.emplace(std::move(name), &itr->value);
+                    }
+                }
+            }
+        }
+    }
+
+    std::string compile(const rapidjson::Value &document) {
+        if (document.IsObject()) {
+            // The constants are only needed to resolve the values that refer to them.
+            writeCount(Tag::Object, memberCount(document) - (document.HasMember("constants") ? 1 : 0));
+            for (auto itr = document.MemberBegin(); itr != document.MemberEnd(); ++itr) {
+                const std::string name { itr->name.GetString(), itr->name.GetStringLength() };
+                if (name != "constants") {
+                    writeScalar(intern(itr->name));
+                    write(itr->value, name == "layers");
+                }
+            }
+        } else {
+            write(document, false);
+        }
+
+        const Header header { { magic[0], magic[1], magic[2], magic[3] }, version, uint32_t(order.size()), uint32_t(table.size()) };
+        std::string result { reinterpret_cast<const char *>(&header), sizeof(Header) };
+        result.reserve(sizeof(Header) + table.size() + values.size());
+        result += table;
+        result += values;
+        return result;
+    }
+
+private:
+    // StyleParser resolves constants in the layers only, and doesn't resolve the values of
+    // constants again. Filter expressions resolve as a whole, and layer ids not at all.
+    void write(const rapidjson::Value &value, bool resolve) {
+        if (resolve && value.IsString()) {
+            const auto it = constants.find({ value.GetString(), value.GetStringLength() });
+            if (it != constants.end()) {
+                write(*it->second, false);
+                return;
+            }
+        }
+
+        if (value.IsNull()) {
+            writeScalar(Tag::Null);
+        } else if (value.IsFalse()) {
+            writeScalar(Tag::False);
+        } else if (value.IsTrue()) {
+            writeScalar(Tag::True);
+        } else if (value.IsInt()) {
+            writeScalar(Tag::Int);
+            writeScalar<int32_t>(value.GetInt());
+        } else if (value.IsUint()) {
+            writeScalar(Tag::Uint);
+            writeScalar<uint32_t>(value.GetUint());
+        } else if (value.IsInt64()) {
+            writeScalar(Tag::Int64);
+            writeScalar<int64_t>(value.GetInt64());
+        } else if (value.IsUint64()) {
+            writeScalar(Tag::Uint64);
+            writeScalar<uint64_t>(value.GetUint64());
+        } else if (value.IsNumber()) {
+            writeScalar(Tag::Double);
+            writeScalar<double>(value.GetDouble());
+        } else if (value.IsString()) {
+            writeScalar(Tag::String);
+            writeScalar(intern(value));
+        } else if (value.IsArray()) {
+            writeCount(Tag::Array, value.Size());
+            for (rapidjson::SizeType i = 0; i < value.Size(); i++) {
+                write(value[i], resolve);
+            }
+        } else if (value.IsObject()) {
+            writeCount(Tag::Object, memberCount(value));
+            for (auto itr = value.MemberBegin(); itr != value.MemberEnd(); ++itr) {
+                writeScalar(intern(itr->name));
+                const std::string name { itr->name.GetString(), itr->name.GetStringLength() };
+                if (resolve && name == "filter") {
+                    const auto it = itr->value.IsString()
+                        ? constants.find({ itr->value.GetString(), itr->value.GetStringLength() })
+                        : constants.end();
+                    write(it != constants.end() ? *it->second : itr->value, false);
+                } else {
+                    write(itr->value, resolve && name != "id");
+                }
+            }
+        }
+    }
+
+    template <typename T>
+    void writeScalar(T value) {
+        values.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void writeCount(Tag tag, uint32_t count) {
+        writeScalar(tag);
+        writeScalar(count);
+    }
+
+    uint32_t intern(const rapidjson::Value &value) {
+        std::string string { value.GetString(), value.GetStringLength() };
+        const auto it = strings.find(string);
+        if (it != strings.end()) {
+            return it->second;
+        }
+
+        const uint32_t index = uint32_t(order.size());
+        const uint32_t length = uint32_t(string.size());
+        table.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        table.append(string);
+        table.push_back('\0');
+        order.push_back(string);
+        strings.emplace(std::move(string), index);
+        return index;
+    }
+
+    std::unordered_map<std::string, const rapidjson::Value *> constants;
+    std::unordered_map<std::string, uint32_t> strings;
+    std::vector<std::string> order;
+    std::string table;
+    std::string values;
+};
+
+class Decoder {
+public:
+    Decoder(const char *data, size_t length, rapidjson::Document::AllocatorType &allocator_)
+        : pos(data), end(data + length), allocator(allocator_) {}
+
+    bool decode(rapidjson::Value &document) {
+        Header header;
+        if (!readScalar(header) || std::memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+            header.version != version || header.stringBytes > size_t(end - pos) ||
+            header.strings > header.stringBytes / (sizeof(uint32_t) + 1)) {
+            return false;
+        }
+
+        strings.reserve(header.strings);
+        const char *const tableEnd = pos + header.stringBytes;
+        for (uint32_t i = 0; i < header.strings; i++) {
+            uint32_t length;
+            if (size_t(tableEnd - pos) < sizeof(length) || !readScalar(length) ||
+                length >= size_t(tableEnd - pos) || pos[length] != '\0') {
+                return false;
+            }
+            strings.emplace_back(pos, length);
+            pos += length + 1;
+        }
+
+        return pos == tableEnd && decode(document, 0) && pos == end;
+    }
+
+private:
+    bool decode(rapidjson::Value &value, uint32_t depth) {
+        Tag tag;
+        if (depth > maxDepth || !readScalar(tag)) {
+            return false;
+        }
+
+        switch (tag) {
+        case Tag::Null: value.SetNull(); return true;
+        case Tag::False: value.SetBool(false); return true;
+        case Tag::True: value.SetBool(true); return true;
+        case Tag::Int: return decodeNumber<int32_t, int>(value);
+        case Tag::Uint: return decodeNumber<uint32_t, unsigned>(value);
+        case Tag::Int64: return decodeNumber<int64_t, int64_t>(value);
+        case Tag::Uint64: return decodeNumber<uint64_t, uint64_t>(value);
+        case Tag::Double: return decodeNumber<double, double>(value);
+        case Tag::String: return decodeString(value);
+        case Tag::Array: {
+            uint32_t count;
+            // Every element takes at least one byte.
+            if (!readScalar(count) || count > size_t(end - pos)) {
+                return false;
+            }
+            value.SetArray();
+            value.Reserve(count, allocator);
+            for (uint32_t i = 0; i < count; i++) {
+                rapidjson::Value element;
+                if (!decode(element, depth + 1)) {
+                    return false;
+                }
+                value.PushBack(element, allocator);
+            }
+            return true;
+        }
+        case Tag::Object: {
+            uint32_t count;
+            if (!readScalar(count) || count > size_t(end - pos)) {
+                return false;
+            }
+            value.SetObject();
+            for (uint32_t i = 0; i < count; i++) {
+                rapidjson::Value name;
+                rapidjson::Value member;
+                if (!decodeString(name) || !decode(member, depth + 1)) {
+                    return false;
+                }
+                value.AddMember(name, member, allocator);
+            }
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    template <typename Stored, typename Type>
+    bool decodeNumber(rapidjson::Value &value) {
+        Stored number;
+        if (!readScalar(number)) {
+            return false;
+        }
+        // Constructing the value from the same type as the JSON reader gives it the same flags.
+        value = Type(number);
+        return true;
+    }
+
+    bool decodeString(rapidjson::Value &value) {
+        uint32_t index;
+        if (!readScalar(index) || index >= strings.size()) {
+            return false;
+        }
+        rapidjson::Value string(strings[index].first, strings[index].second);
+        value = string;
+        return true;
+    }
+
+    template <typename T>
+    bool readScalar(T &value) {
+        if (size_t(end - pos) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    const char *pos;
+    const char *const end;
+    rapidjson::Document::AllocatorType &allocator;
+    std::vector<std::pair<const char *, rapidjson::SizeType>> strings;
+};
+
+}
+
+std::string StyleBinary::compile(const rapidjson::Value &document) {
+    return Compiler(document).compile(document);
+}
+
+bool StyleBinary::decode(const char *data, size_t length, rapidjson::Document &document) {
+    return Decoder(data, length, document.GetAllocator()).decode(document);
+}
+
+}
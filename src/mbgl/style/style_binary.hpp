@@ -0,0 +1,29 @@
+#ifndef MBGL_STYLE_STYLE_BINARY
+#define MBGL_STYLE_STYLE_BINARY
+
+#include <rapidjson/document.h>
+
+#include <string>
+
+namespace mbgl {
+
+// A style document precompiled into a compact binary form, so that an app that ships a fixed
+// style doesn't tokenize JSON at startup. The compiler resolves the constants and drops them, and
+// interns every string, including the property and class names, into one table. Numbers are
+// stored in binary, with the same integer or floating point type the JSON parser gives them.
+//
+// Decoding rebuilds the document without copying any string, and StyleParser reads it like a
+// parsed JSON document, so both forms produce the same layers. The files use the byte order of
+// the machine that wrote them, and data that doesn't match the format is rejected.
+class StyleBinary {
+public:
+    static std::string compile(const rapidjson::Value &document);
+
+    // The strings of the document point into /data/, which has to outlive it. Returns false if
+    // the data isn't a compiled style.
+    static bool decode(const char *data, size_t length, rapidjson::Document &document);
+};
+
+}
+
+#endif
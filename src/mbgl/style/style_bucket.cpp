@@ -1,15 +1,41 @@
 #include <mbgl/style/style_bucket.hpp>
+#include <mbgl/style/value_comparison.hpp>
 
 namespace mbgl {
 
-StyleBucket::StyleBucket(StyleLayerType type) {
+// The render properties are constructed in place: assigning a variant swaps its raw storage,
+// which breaks members that point into themselves, like short strings.
+static StyleBucketRender createRender(StyleLayerType type) {
     switch (type) {
-        case StyleLayerType::Fill: render = StyleBucketFill{}; break;
-        case StyleLayerType::Line: render = StyleBucketLine{}; break;
-        case StyleLayerType::Symbol: render = StyleBucketSymbol{}; break;
-        case StyleLayerType::Raster: render = StyleBucketRaster{}; break;
-        default: break;
+        case StyleLayerType::Fill: return StyleBucketFill{};
+        case StyleLayerType::Line: return StyleBucketLine{};
+        case StyleLayerType::Circle: return StyleBucketCircle{};
+        case StyleLayerType::Symbol: return StyleBucketSymbol{};
+        case StyleLayerType::Raster: return StyleBucketRaster{};
+        default: return std::false_type();
     }
 }
 
-}
\ No newline at end of file
+StyleBucket::StyleBucket(StyleLayerType type) : render(createRender(type)) {}
+
+const Color *StyleBucketFill::getColor(const Value *value) const {
+    if (value) {
+        for (const std::pair<Value, Color> &stop : color_stops) {
+            if (util::relaxed_equal(*value, stop.first)) {
+                return &stop.second;
+            }
+        }
+    }
+    return color_default ? &*color_default : nullptr;
+}
+
+bool StyleBucketFill::isOpaque() const {
+    for (const std::pair<Value, Color> &stop : color_stops) {
+        if (stop.second[3] < 1.0f) {
+            return false;
+        }
+    }
+    return !color_default || (*color_default)[3] >= 1.0f;
+}
+
+}
@@ -3,12 +3,15 @@
 
 #include <mbgl/style/types.hpp>
 #include <mbgl/style/filter_expression.hpp>
+#include <mbgl/style/filter_program.hpp>
 #include <mbgl/style/style_source.hpp>
+#include <mbgl/style/value.hpp>
 
 #include <mbgl/util/vec.hpp>
 #include <mbgl/util/variant.hpp>
 #include <mbgl/util/noncopyable.hpp>
 #include <mbgl/util/ptr.hpp>
+#include <mbgl/util/optional.hpp>
 
 #include <forward_list>
 
@@ -19,6 +22,22 @@ class Source;
 class StyleBucketFill {
 public:
     WindingType winding = WindingType::NonZero;
+
+    // When set, features are colored by the value of this property instead of with the layer's
+    // fill color. The colors go into the vertices, so that features of all values are drawn at
+    // once.
+    std::string color_property;
+    std::vector<std::pair<Value, Color>> color_stops;
+
+    // The color of features whose value has no stop. They are left out if it isn't set.
+    mapbox::util::optional<Color> color_default;
+
+    // Returns the color of a feature with this value of color_property, or nullptr if the feature
+    // isn't drawn.
+    const Color *getColor(const Value *value) const;
+
+    // Whether all features are colored opaquely.
+    bool isOpaque() const;
 };
 
 class StyleBucketLine {
@@ -29,18 +48,24 @@ public:
     float round_limit = 1.0f;
 };
 
+class StyleBucketCircle {
+public:
+};
+
 class StyleBucketSymbol {
 public:
-    // Make movable only.
+    // Make movable only; buckets are only copied explicitly, to change the layout of a layer.
     inline StyleBucketSymbol() = default;
     inline StyleBucketSymbol(StyleBucketSymbol &&) = default;
     inline StyleBucketSymbol& operator=(StyleBucketSymbol &&) = default;
-    inline StyleBucketSymbol(const StyleBucketSymbol &) = delete;
+    inline explicit StyleBucketSymbol(const StyleBucketSymbol &) = default;
     inline StyleBucketSymbol& operator=(const StyleBucketSymbol &) = delete;
 
     PlacementType placement = PlacementType::Point;
     float min_distance = 250.0f;
     bool avoid_edges = false;
+    // A numeric feature property; features with lower values are placed first.
+    std::string sort_key;
 
     struct {
         bool allow_overlap = false;
@@ -82,7 +107,7 @@ class StyleBucketRaster {
 public:
 };
 
-typedef mapbox::util::variant<StyleBucketFill, StyleBucketLine, StyleBucketSymbol,
+typedef mapbox::util::variant<StyleBucketFill, StyleBucketLine, StyleBucketCircle, StyleBucketSymbol,
                               StyleBucketRaster, std::false_type> StyleBucketRender;
 
 
@@ -93,9 +118,15 @@ public:
     StyleBucket(StyleLayerType type);
 
     std::string name;
+
+    // The serialized definition of buckets that layers can share, to find the same bucket in the
+    // next revision of a style. Empty if the bucket can't be kept.
+    std::string key;
+
     util::ptr<StyleSource> style_source;
     std::string source_layer;
     FilterExpression filter;
+    FilterProgram compiled_filter;
     StyleBucketRender render = std::false_type();
     float min_zoom = -std::numeric_limits<float>::infinity();
     float max_zoom = std::numeric_limits<float>::infinity();
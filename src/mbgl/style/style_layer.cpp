@@ -5,6 +5,9 @@
 
 #include <mbgl/util/interpolate.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace mbgl {
 
 StyleLayer::StyleLayer(const std::string &id_, std::map<ClassID, ClassProperties> &&styles_)
@@ -14,29 +17,64 @@ bool StyleLayer::isBackground() const {
     return type == StyleLayerType::Background;
 }
 
-void StyleLayer::setClasses(const std::vector<std::string> &class_names, const timestamp now,
-                            const PropertyTransition &defaultTransition) {
-    // Stores all keys that we have already added transitions for.
-    std::set<PropertyKey> already_applied;
-
-    // Reverse iterate through all class names and apply them last to first.
-    for (auto it = class_names.rbegin(); it != class_names.rend(); ++it) {
-        const std::string &class_name = *it;
-        // From here on, we're only dealing with IDs to avoid comparing strings all the time.
-        const ClassID class_id = ClassDictionary::Get().lookup(class_name);
-        applyClassProperties(class_id, already_applied, now, defaultTransition);
+const PropertyKeyMap<StyleLayer::CascadedValue> &StyleLayer::cascade(const std::vector<ClassID> &class_ids) {
+    // Classes that this layer doesn't have styles for don't change anything, so they aren't part
+    // of the combination.
+    std::vector<ClassID> layer_class_ids;
+    for (const ClassID class_id : class_ids) {
+        if (styles.find(class_id) != styles.end()) {
+            layer_class_ids.push_back(class_id);
+        }
+    }
+
+    auto cascade_it = cascades.find(layer_class_ids);
+    if (cascade_it == cascades.end()) {
+        PropertyKeyMap<CascadedValue> cascaded;
+
+        // Reverse iterate through all classes and apply them last to first.
+        for (auto it = layer_class_ids.rbegin(); it != layer_class_ids.rend(); ++it) {
+            cascadeClassProperties(*it, cascaded);
+        }
+
+        // As the last class, apply the default class.
+        cascadeClassProperties(ClassID::Default, cascaded);
+
+        cascade_it = cascades.emplace(layer_class_ids, std::move(cascaded)).first;
     }
+    return cascade_it->second;
+}
 
-    // As the last class, apply the default class.
-    applyClassProperties(ClassID::Default, already_applied, now, defaultTransition);
+bool StyleLayer::setClasses(const std::vector<ClassID> &class_ids, const timestamp now,
+                            const PropertyTransition &defaultTransition) {
+    classes = class_ids;
+    const PropertyKeyMap<CascadedValue> &cascaded = cascade(class_ids);
+
+    bool changed = false;
+
+    for (std::pair<PropertyKey, const CascadedValue &> property_pair : cascaded) {
+        const PropertyKey key = property_pair.first;
+        const CascadedValue &cascaded_value = property_pair.second;
+
+        // If the most recent transition is not the one with the highest priority, create
+        // a transition.
+        AppliedClassProperties &appliedProperties = appliedStyle[key];
+        if (appliedProperties.mostRecent() != cascaded_value.class_id) {
+            const PropertyTransition &transition =
+                cascaded_value.class_properties->getTransition(key, defaultTransition);
+            const timestamp begin = now + transition.delay * 1_millisecond;
+            const timestamp end = begin + transition.duration * 1_millisecond;
+            appliedProperties.add(cascaded_value.class_id, begin, end, *cascaded_value.value);
+            changed = true;
+        }
+    }
 
     // Make sure that we also transition to the fallback value for keys that aren't changed by
     // any applied classes.
-    for (std::pair<const PropertyKey, AppliedClassProperties> &property_pair : appliedStyle) {
+    for (std::pair<PropertyKey, AppliedClassProperties &> property_pair : appliedStyle) {
         const PropertyKey key = property_pair.first;
-        if (already_applied.find(key) != already_applied.end()) {
-            // This property has already been set by a previous class, so we don't need to
-            // transition to the fallback.
+        if (cascaded.has(key)) {
+            // This property has already been set by a class, so we don't need to transition to
+            // the fallback.
             continue;
         }
 
@@ -49,46 +87,74 @@ void StyleLayer::setClasses(const std::vector<std::string> &class_names, const t
             const timestamp end = begin + defaultTransition.duration * 1_millisecond;
             const PropertyValue &value = PropertyFallbackValue::Get(key);
             appliedProperties.add(ClassID::Fallback, begin, end, value);
+            changed = true;
         }
     }
-}
 
-// Helper function for applying all properties of a a single class that haven't been applied yet.
-void StyleLayer::applyClassProperties(const ClassID class_id,
-                                      std::set<PropertyKey> &already_applied, timestamp now,
-                                      const PropertyTransition &defaultTransition) {
-    auto style_it = styles.find(class_id);
-    if (style_it == styles.end()) {
-        // There is no class in this layer with this class_name.
-        return;
+    if (changed) {
+        // The new values may evaluate differently at any zoom level.
+        evaluatedRange = { 1, 0 };
     }
 
-    // Loop through all the properties in this style, and add transitions to them, if they're
-    // not already the most recent transition.
-    const ClassProperties &class_properties = style_it->second;
-    for (const std::pair<PropertyKey, PropertyValue> &property_pair : class_properties)  {
-        PropertyKey key = property_pair.first;
-        if (already_applied.find(key) != already_applied.end()) {
-            // This property has already been set by a previous class.
-            continue;
-        }
+    return changed;
+}
 
-        // Mark this property as written by a previous class, so that subsequent
-        // classes won't override this.
-        already_applied.insert(key);
+bool StyleLayer::setClassProperties(const ClassID class_id, const ClassProperties &changes,
+                                    const timestamp now, const PropertyTransition &defaultTransition) {
+    ClassProperties &class_properties = styles[class_id];
+    for (std::pair<PropertyKey, const PropertyValue &> property_pair : changes.properties) {
+        class_properties.properties.erase(property_pair.first);
+        class_properties.properties.emplace(property_pair.first, property_pair.second);
+    }
+    for (std::pair<PropertyKey, const PropertyTransition &> transition_pair : changes.transitions) {
+        class_properties.transitions.erase(transition_pair.first);
+        class_properties.transitions.emplace(transition_pair.first, transition_pair.second);
+    }
 
-        // If the most recent transition is not the one with the highest priority, create
-        // a transition.
-        AppliedClassProperties &appliedProperties = appliedStyle[key];
-        if (appliedProperties.mostRecent() != class_id) {
+    // The cascades point into the values that were just replaced.
+    cascades.clear();
+    const PropertyKeyMap<CascadedValue> &cascaded = cascade(classes);
+
+    // setClasses() only transitions properties whose cascaded value comes from another class now,
+    // so the values that this class still provides need their transitions here.
+    bool changed = false;
+    for (std::pair<PropertyKey, const PropertyValue &> property_pair : changes.properties) {
+        const PropertyKey key = property_pair.first;
+        const CascadedValue *cascaded_value = cascaded.find(key);
+        if (cascaded_value && cascaded_value->class_id == class_id) {
             const PropertyTransition &transition =
-                class_properties.getTransition(key, defaultTransition);
+                cascaded_value->class_properties->getTransition(key, defaultTransition);
             const timestamp begin = now + transition.delay * 1_millisecond;
             const timestamp end = begin + transition.duration * 1_millisecond;
-            const PropertyValue &value = property_pair.second;
-            appliedProperties.add(class_id, begin, end, value);
+            appliedStyle[key].add(class_id, begin, end, *cascaded_value->value);
+            changed = true;
         }
     }
+
+    if (setClasses(classes, now, defaultTransition)) {
+        changed = true;
+    } else if (changed) {
+        evaluatedRange = { 1, 0 };
+    }
+
+    return changed;
+}
+
+// Helper function for cascading all properties of a single class that haven't been set yet.
+void StyleLayer::cascadeClassProperties(const ClassID class_id,
+                                        PropertyKeyMap<CascadedValue> &cascaded) const {
+    auto style_it = styles.find(class_id);
+    if (style_it == styles.end()) {
+        // There is no class in this layer with this ID.
+        return;
+    }
+
+    // Properties that were set by a previous class take precedence, so emplace() keeps them.
+    const ClassProperties &class_properties = style_it->second;
+    for (std::pair<PropertyKey, const PropertyValue &> property_pair : class_properties)  {
+        cascaded.emplace(property_pair.first,
+                         CascadedValue { class_id, &class_properties, &property_pair.second });
+    }
 }
 
 template <typename T>
@@ -114,17 +180,46 @@ private:
     const float z;
 };
 
+// Returns the zoom levels around z at which a property value evaluates to the same result.
+struct ConstantZoomRange {
+    typedef std::pair<float, float> result_type;
+    ConstantZoomRange(float z_) : z(z_) {}
+
+    template <typename T>
+    result_type operator()(const Function<T> &value) const {
+        return mapbox::util::apply_visitor(*this, value);
+    }
+
+    template <typename T>
+    result_type operator()(const StopsFunction<T> &value) const {
+        return value.constantRange(z);
+    }
+
+    template <typename P>
+    result_type operator()(const P &) const {
+        return allZoomLevels();
+    }
+
+private:
+    const float z;
+};
+
+inline void narrowRange(std::pair<float, float> &range, const std::pair<float, float> &other) {
+    range.first = std::max(range.first, other.first);
+    range.second = std::min(range.second, other.second);
+}
+
 template <typename T>
 void StyleLayer::applyStyleProperty(PropertyKey key, T &target, const float z, const timestamp now) {
-    auto it = appliedStyle.find(key);
-    if (it != appliedStyle.end()) {
-        AppliedClassProperties &applied = it->second;
+    AppliedClassProperties *applied = appliedStyle.find(key);
+    if (applied) {
         // Iterate through all properties that we need to apply in order.
         const PropertyEvaluator<T> evaluator(z);
-        for (AppliedClassProperty &property : applied.properties) {
+        for (AppliedClassProperty &property : applied->properties) {
             if (now >= property.begin) {
                 // We overwrite the current property with the new value.
                 target = mapbox::util::apply_visitor(evaluator, property.value);
+                narrowRange(evaluatedRange, mapbox::util::apply_visitor(ConstantZoomRange(z), property.value));
             } else {
                 // Do not apply this property because its transition hasn't begun yet.
             }
@@ -134,15 +229,15 @@ void StyleLayer::applyStyleProperty(PropertyKey key, T &target, const float z, c
 
 template <typename T>
 void StyleLayer::applyTransitionedStyleProperty(PropertyKey key, T &target, const float z, const timestamp now) {
-    auto it = appliedStyle.find(key);
-    if (it != appliedStyle.end()) {
-        AppliedClassProperties &applied = it->second;
+    AppliedClassProperties *applied = appliedStyle.find(key);
+    if (applied) {
         // Iterate through all properties that we need to apply in order.
         const PropertyEvaluator<T> evaluator(z);
-        for (AppliedClassProperty &property : applied.properties) {
+        for (AppliedClassProperty &property : applied->properties) {
             if (now >= property.end) {
                 // We overwrite the current property with the new value.
                 target = mapbox::util::apply_visitor(evaluator, property.value);
+                narrowRange(evaluatedRange, mapbox::util::apply_visitor(ConstantZoomRange(z), property.value));
             } else if (now >= property.begin) {
                 // We overwrite the current property partially with the new value.
                 float progress = float(now - property.begin) / float(property.end - property.begin);
@@ -183,8 +278,24 @@ void StyleLayer::applyStyleProperties<LineProperties>(const float z, const times
     applyStyleProperty(PropertyKey::LineDashArray, line.dash_array, z, now);
     applyStyleProperty(PropertyKey::LineImage, line.image, z, now);
 
-    // for scaling dasharrays
+    // for scaling dasharrays. This value only changes at integer zoom levels.
+    const std::pair<float, float> range = evaluatedRange;
     applyStyleProperty(PropertyKey::LineWidth, line.dash_line_width, std::floor(z), now + 10000);
+    evaluatedRange = range;
+    narrowRange(evaluatedRange, { std::floor(z), std::nextafter(std::floor(z) + 1, -1.0f) });
+}
+
+template <>
+void StyleLayer::applyStyleProperties<CircleProperties>(const float z, const timestamp now) {
+    properties.set<CircleProperties>();
+    CircleProperties &circle = properties.get<CircleProperties>();
+    applyTransitionedStyleProperty(PropertyKey::CircleOpacity, circle.opacity, z, now);
+    applyTransitionedStyleProperty(PropertyKey::CircleColor, circle.color, z, now);
+    applyTransitionedStyleProperty(PropertyKey::CircleTranslateX, circle.translate[0], z, now);
+    applyTransitionedStyleProperty(PropertyKey::CircleTranslateY, circle.translate[1], z, now);
+    applyStyleProperty(PropertyKey::CircleTranslateAnchor, circle.translateAnchor, z, now);
+    applyTransitionedStyleProperty(PropertyKey::CircleRadius, circle.radius, z, now);
+    applyTransitionedStyleProperty(PropertyKey::CircleBlur, circle.blur, z, now);
 }
 
 template <>
@@ -236,40 +347,67 @@ void StyleLayer::applyStyleProperties<BackgroundProperties>(const float z, const
 }
 
 void StyleLayer::updateProperties(float z, const timestamp now) {
+    if (z >= evaluatedRange.first && z <= evaluatedRange.second) {
+        return;
+    }
+
     cleanupAppliedStyleProperties(now);
 
+    evaluatedRange = allZoomLevels();
     switch (type) {
         case StyleLayerType::Fill: applyStyleProperties<FillProperties>(z, now); break;
         case StyleLayerType::Line: applyStyleProperties<LineProperties>(z, now); break;
+        case StyleLayerType::Circle: applyStyleProperties<CircleProperties>(z, now); break;
         case StyleLayerType::Symbol: applyStyleProperties<SymbolProperties>(z, now); break;
         case StyleLayerType::Raster: applyStyleProperties<RasterProperties>(z, now); break;
         case StyleLayerType::Background: applyStyleProperties<BackgroundProperties>(z, now); break;
         default: properties.set<std::false_type>(); break;
     }
+
+    // Running transitions change the properties over time, so they need to be evaluated again in
+    // the next frame.
+    if (!isSettled(now)) {
+        evaluatedRange = { 1, 0 };
+    }
 }
 
-bool StyleLayer::hasTransitions() const {
-    for (const std::pair<PropertyKey, AppliedClassProperties> &pair : appliedStyle) {
-        if (pair.second.hasTransitions()) {
-            return true;
+bool StyleLayer::isSettled(const timestamp now) const {
+    for (std::pair<PropertyKey, const AppliedClassProperties &> pair : appliedStyle) {
+        const std::list<AppliedClassProperty> &applied = pair.second.properties;
+        if (applied.size() > 1 || (applied.size() == 1 && applied.front().end > now)) {
+            return false;
         }
     }
-    return false;
+    return true;
+}
+
+timestamp StyleLayer::transitionsEnd() const {
+    timestamp end = 0;
+    for (std::pair<PropertyKey, const AppliedClassProperties &> pair : appliedStyle) {
+        for (const AppliedClassProperty &property : pair.second.properties) {
+            end = std::max(end, property.end);
+        }
+    }
+    return end;
+}
+
+timestamp StyleLayer::nextTransition(timestamp now) const {
+    timestamp next = noTransition;
+    for (std::pair<PropertyKey, const AppliedClassProperties &> pair : appliedStyle) {
+        next = std::min(next, pair.second.nextTransition(now));
+    }
+    return next;
 }
 
 
 void StyleLayer::cleanupAppliedStyleProperties(timestamp now) {
-    auto it = appliedStyle.begin();
-    const auto end = appliedStyle.end();
-    while (it != end) {
-        AppliedClassProperties &applied_properties = it->second;
+    for (std::pair<PropertyKey, AppliedClassProperties &> pair : appliedStyle) {
+        AppliedClassProperties &applied_properties = pair.second;
         applied_properties.cleanup(now);
 
         // If the current properties object is empty, remove it from the map entirely.
         if (applied_properties.empty()) {
-            appliedStyle.erase(it++);
-        } else {
-            ++it;
+            appliedStyle.erase(pair.first);
         }
     }
 }
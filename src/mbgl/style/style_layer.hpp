@@ -5,13 +5,13 @@
 #include <mbgl/style/class_properties.hpp>
 #include <mbgl/style/style_properties.hpp>
 #include <mbgl/style/applied_class_properties.hpp>
+#include <mbgl/style/property_key_map.hpp>
 
 #include <mbgl/util/ptr.hpp>
 
 #include <vector>
 #include <string>
 #include <map>
-#include <set>
 
 namespace mbgl {
 
@@ -34,19 +34,39 @@ public:
     bool isBackground() const;
 
     // Updates the StyleProperties information in this layer by evaluating all
-    // pending transitions and applied classes in order.
+    // pending transitions and applied classes in order. Does nothing if no transition is running
+    // and the properties evaluate the same at z as they did last time.
     void updateProperties(float z, timestamp now);
 
-    // Sets the list of classes and creates transitions to the currently applied values.
-    void setClasses(const std::vector<std::string> &class_names, timestamp now,
+    // Sets the list of classes and creates transitions to the currently applied values. Returns
+    // true if any property of this layer changes. Classes only affect paint properties, so this
+    // never invalidates the buckets that were parsed for this layer.
+    bool setClasses(const std::vector<ClassID> &class_ids, timestamp now,
                     const PropertyTransition &defaultTransition);
 
-    bool hasTransitions() const;
+    // Replaces the values and transitions that a class sets for the properties in /changes/.
+    // Properties whose cascaded value changed transition to it as if the classes had changed.
+    // Returns true if any property of this layer changes.
+    bool setClassProperties(ClassID class_id, const ClassProperties &changes, timestamp now,
+                            const PropertyTransition &defaultTransition);
+
+    // Returns the time at which the last of the applied values is fully transitioned to.
+    timestamp transitionsEnd() const;
+    timestamp nextTransition(timestamp now) const;
 
 private:
-    // Applies all properties from a class, if they haven't been applied already.
-    void applyClassProperties(ClassID class_id, std::set<PropertyKey> &already_applied,
-                              timestamp now, const PropertyTransition &defaultTransition);
+    // The value that a combination of classes cascades to for one property.
+    struct CascadedValue {
+        ClassID class_id;
+        const ClassProperties *class_properties;
+        const PropertyValue *value;
+    };
+
+    // Adds all properties from a class, if no previous class set them already.
+    void cascadeClassProperties(ClassID class_id, PropertyKeyMap<CascadedValue> &cascaded) const;
+
+    // Returns the values that a list of classes cascades to.
+    const PropertyKeyMap<CascadedValue> &cascade(const std::vector<ClassID> &class_ids);
 
     // Sets the properties of this object by evaluating all pending transitions and
     // aplied classes in order.
@@ -57,6 +77,9 @@ private:
     // Removes all expired style transitions.
     void cleanupAppliedStyleProperties(timestamp now);
 
+    // Whether every property has reached its final value.
+    bool isSettled(timestamp now) const;
+
 public:
     // The name of this layer.
     const std::string id;
@@ -67,13 +90,26 @@ public:
     // for this layer (feature property filters, tessellation instructions, ...).
     util::ptr<StyleBucket> bucket;
 
-    // Contains all style classes that can be applied to this layer.
-    const std::map<ClassID, ClassProperties> styles;
+    // Contains all style classes that can be applied to this layer. Only changed through
+    // setClassProperties().
+    std::map<ClassID, ClassProperties> styles;
 
 private:
     // For every property, stores a list of applied property values, with
     // optional transition times.
-    std::map<PropertyKey, AppliedClassProperties> appliedStyle;
+    PropertyKeyMap<AppliedClassProperties> appliedStyle;
+
+    // The cascaded values of every combination of classes that was set so far, keyed by the
+    // classes that this layer has styles for. Toggling back and forth between combinations
+    // doesn't cascade them again.
+    std::map<std::vector<ClassID>, PropertyKeyMap<CascadedValue>> cascades;
+
+    // The classes of the last call to setClasses().
+    std::vector<ClassID> classes;
+
+    // The zoom levels at which the properties evaluate to what they currently hold. Narrowed by
+    // every value that is applied, and emptied while transitions run or the classes changed.
+    std::pair<float, float> evaluatedRange { 1, 0 };
 
 public:
     // Stores the evaluated, and cascaded styling information, specific to this
@@ -1,14 +1,46 @@
 #include <mbgl/style/style_layer_group.hpp>
 
+#include <algorithm>
+
 namespace mbgl {
 
-void StyleLayerGroup::setClasses(const std::vector<std::string> &class_names, timestamp now,
+bool StyleLayerGroup::setClasses(const std::vector<ClassID> &class_ids, timestamp now,
                                  const PropertyTransition &defaultTransition) {
+    bool changed = false;
     for (const util::ptr<StyleLayer> &layer : layers) {
-        if (layer) {
-            layer->setClasses(class_names, now, defaultTransition);
+        if (layer && layer->setClasses(class_ids, now, defaultTransition)) {
+            changed = true;
+            addTransition(layer);
         }
     }
+    return changed;
+}
+
+bool StyleLayerGroup::setClassProperties(const util::ptr<StyleLayer> &layer, ClassID class_id,
+                                         const ClassProperties &changes, timestamp now,
+                                         const PropertyTransition &defaultTransition) {
+    if (!layer->setClassProperties(class_id, changes, now, defaultTransition)) {
+        return false;
+    }
+    addTransition(layer);
+    return true;
+}
+
+void StyleLayerGroup::addTransition(const util::ptr<StyleLayer> &layer) {
+    const timestamp end = layer->transitionsEnd();
+    auto it = std::find_if(transitions.begin(), transitions.end(),
+                           [&](const Transition &transition) { return transition.layer == layer; });
+    if (it == transitions.end()) {
+        transitions.push_back({ layer, end });
+    } else {
+        it->end = std::max(it->end, end);
+    }
+}
+
+util::ptr<StyleLayer> StyleLayerGroup::getLayer(const std::string &id) const {
+    auto it = std::find_if(layers.begin(), layers.end(),
+                           [&](const util::ptr<StyleLayer> &layer) { return layer && layer->id == id; });
+    return it != layers.end() ? *it : nullptr;
 }
 
 void StyleLayerGroup::updateProperties(float z, timestamp t) {
@@ -17,17 +49,23 @@ void StyleLayerGroup::updateProperties(float z, timestamp t) {
             layer->updateProperties(z, t);
         }
     }
+
+    // Layers that were evaluated after their last transition ended hold their final values.
+    transitions.erase(std::remove_if(transitions.begin(), transitions.end(),
+                                     [t](const Transition &transition) { return transition.end <= t; }),
+                      transitions.end());
 }
 
 bool StyleLayerGroup::hasTransitions() const {
-    for (const util::ptr<const StyleLayer> &layer: layers) {
-        if (layer) {
-            if (layer->hasTransitions()) {
-                return true;
-            }
-        }
+    return !transitions.empty();
+}
+
+timestamp StyleLayerGroup::nextTransition(timestamp now) const {
+    timestamp next = noTransition;
+    for (const Transition &transition : transitions) {
+        next = std::min(next, transition.layer->nextTransition(now));
     }
-    return false;
+    return next;
 }
 
 
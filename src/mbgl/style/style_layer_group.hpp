@@ -9,13 +9,37 @@ namespace mbgl {
 
 class StyleLayerGroup {
 public:
-    void setClasses(const std::vector<std::string> &class_names, timestamp now,
+    // Returns true if any property of any layer changes.
+    bool setClasses(const std::vector<ClassID> &class_ids, timestamp now,
                     const PropertyTransition &defaultTransition);
+    // Returns true if any property of the layer changes.
+    bool setClassProperties(const util::ptr<StyleLayer> &layer, ClassID class_id,
+                            const ClassProperties &changes, timestamp now,
+                            const PropertyTransition &defaultTransition);
+
+    // Returns nullptr if there is no layer with the id.
+    util::ptr<StyleLayer> getLayer(const std::string &id) const;
+
     void updateProperties(float z, timestamp t);
 
+    // Whether a transition started since the properties were last updated, or is still running.
     bool hasTransitions() const;
+    timestamp nextTransition(timestamp now) const;
 public:
     std::vector<util::ptr<StyleLayer>> layers;
+
+private:
+    void addTransition(const util::ptr<StyleLayer> &layer);
+
+    struct Transition {
+        util::ptr<StyleLayer> layer;
+        // When the last transition of the layer ends.
+        timestamp end;
+    };
+
+    // The layers whose properties are transitioning, so that checking for transitions doesn't
+    // have to look at every property of every layer.
+    std::vector<Transition> transitions;
 };
 
 }
@@ -3,9 +3,13 @@
 #include <mbgl/style/style_layer_group.hpp>
 #include <mbgl/util/constants.hpp>
 #include <mbgl/util/std.hpp>
+#include <mbgl/util/allocation_tracker.hpp>
 #include <mbgl/platform/log.hpp>
 #include <csscolorparser/csscolorparser.hpp>
 
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
 #include <algorithm>
 
 namespace mbgl {
@@ -16,6 +20,8 @@ StyleParser::StyleParser() {
 }
 
 void StyleParser::parse(JSVal document) {
+    AllocationTracker::Scope allocations(AllocationTracker::Subsystem::StyleParser);
+
     if (document.HasMember("constants")) {
         parseConstants(document["constants"]);
     }
@@ -178,12 +184,46 @@ void StyleParser::parseSources(JSVal value) {
         rapidjson::Value::ConstMemberIterator itr = value.MemberBegin();
         for (; itr != value.MemberEnd(); ++itr) {
             std::string name { itr->name.GetString(), itr->name.GetStringLength() };
-            SourceInfo& info = sources.emplace(name, std::make_shared<StyleSource>()).first->second->info;
+            StyleSource &source = *sources.emplace(name, std::make_shared<StyleSource>()).first->second;
+            SourceInfo& info = source.info;
+            info.id = name;
+
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            itr->value.Accept(writer);
+            source.definition = { buffer.GetString(), buffer.Size() };
 
             parseRenderProperty<SourceTypeClass>(itr->value, info.type, "type");
             parseRenderProperty(itr->value, info.url, "url");
             parseRenderProperty(itr->value, info.tile_size, "tileSize");
             info.parseTileJSONProperties(itr->value);
+
+            if (info.type == SourceType::GeoJSON) {
+                // The data is either a URL or the GeoJSON itself.
+                if (itr->value.HasMember("data")) {
+                    JSVal data = itr->value["data"];
+                    if (data.IsString()) {
+                        info.url = { data.GetString(), data.GetStringLength() };
+                    } else if (data.IsObject()) {
+                        rapidjson::StringBuffer geojson;
+                        rapidjson::Writer<rapidjson::StringBuffer> geojsonWriter(geojson);
+                        data.Accept(geojsonWriter);
+                        info.geojson = { geojson.GetString(), geojson.Size() };
+                    } else {
+                        Log::Warning(Event::ParseStyle, "data of source '%s' must be a URL or GeoJSON", name.c_str());
+                    }
+                }
+
+                // Deeper tiles are scaled up from this level instead of being cut from the data.
+                if (!itr->value.HasMember("maxzoom")) {
+                    info.max_zoom = 18;
+                }
+
+                parseRenderProperty(itr->value, info.cluster, "cluster");
+                parseRenderProperty(itr->value, info.cluster_radius, "clusterRadius");
+                info.cluster_max_zoom = info.max_zoom - 1;
+                parseRenderProperty(itr->value, info.cluster_max_zoom, "clusterMaxZoom");
+            }
         }
     } else {
         Log::Warning(Event::ParseStyle, "sources must be an object");
@@ -327,15 +367,6 @@ bool StyleParser::setProperty(JSVal value, const char *property_name, PropertyKe
     return parsed;
 }
 
-template<typename T>
-bool StyleParser::parseOptionalProperty(const char *property_name, PropertyKey key, ClassProperties &klass, JSVal value) {
-    if (!value.HasMember(property_name)) {
-        return false;
-    } else {
-        return setProperty<T>(replaceConstant(value[property_name]), property_name, key, klass);
-    }
-}
-
 template<> std::tuple<bool, std::string> StyleParser::parseProperty(JSVal value, const char *property_name) {
     if (!value.IsString()) {
         Log::Warning(Event::ParseStyle, "value of '%s' must be a string", property_name);
@@ -430,25 +461,6 @@ template<> std::tuple<bool, Function<std::vector<float>>> StyleParser::parseProp
     }
 }
 
-template <typename T>
-bool StyleParser::parseOptionalProperty(const char *property_name, const std::vector<PropertyKey> &keys, ClassProperties &klass, JSVal value) {
-    if (value.HasMember(property_name)) {
-        JSVal rvalue = replaceConstant(value[property_name]);
-        if (!rvalue.IsArray()) {
-            Log::Warning(Event::ParseStyle, "array value must be an array");
-        }
-
-        if (rvalue.Size() != keys.size()) {
-            Log::Warning(Event::ParseStyle, "array value has unexpected number of elements");
-        }
-
-        for (uint16_t i = 0; i < keys.size(); i++) {
-            setProperty<T>(rvalue[(rapidjson::SizeType)i], property_name, keys[i], klass);
-        }
-    }
-    return true;
-}
-
 #pragma mark - Parse Layers
 
 std::unique_ptr<StyleLayerGroup> StyleParser::createLayers(JSVal value) {
@@ -560,86 +572,156 @@ void StyleParser::parsePaints(JSVal value, std::map<ClassID, ClassProperties> &p
     }
 }
 
-void StyleParser::parsePaint(JSVal value, ClassProperties &klass) {
+template <typename T>
+StyleParser::PaintProperty StyleParser::paintProperty(PropertyKey key) {
+    return [key](StyleParser &parser, JSVal value, const char *property_name, ClassProperties &klass) {
+        parser.setProperty<T>(parser.replaceConstant(value), property_name, key, klass);
+    };
+}
+
+template <typename T>
+StyleParser::PaintProperty StyleParser::paintProperty(std::vector<PropertyKey> keys) {
+    return [keys](StyleParser &parser, JSVal value, const char *property_name, ClassProperties &klass) {
+        JSVal rvalue = parser.replaceConstant(value);
+        if (!rvalue.IsArray()) {
+            Log::Warning(Event::ParseStyle, "array value must be an array");
+            return;
+        }
+
+        if (rvalue.Size() != keys.size()) {
+            Log::Warning(Event::ParseStyle, "array value has unexpected number of elements");
+        }
+
+        for (uint16_t i = 0; i < keys.size() && i < rvalue.Size(); i++) {
+            parser.setProperty<T>(rvalue[(rapidjson::SizeType)i], property_name, keys[i], klass);
+        }
+    };
+}
+
+const std::unordered_map<std::string, StyleParser::PaintProperty> &StyleParser::paintProperties() {
     using Key = PropertyKey;
 
-    parseOptionalProperty<Function<bool>>("fill-antialias", Key::FillAntialias, klass, value);
-    parseOptionalProperty<Function<float>>("fill-opacity", Key::FillOpacity, klass, value);
-    parseOptionalProperty<PropertyTransition>("fill-opacity-transition", Key::FillOpacity, klass, value);
-    parseOptionalProperty<Function<Color>>("fill-color", Key::FillColor, klass, value);
-    parseOptionalProperty<PropertyTransition>("fill-color-transition", Key::FillColor, klass, value);
-    parseOptionalProperty<Function<Color>>("fill-outline-color", Key::FillOutlineColor, klass, value);
-    parseOptionalProperty<PropertyTransition>("fill-outline-color-transition", Key::FillOutlineColor, klass, value);
-    parseOptionalProperty<Function<float>>("fill-translate", { Key::FillTranslateX, Key::FillTranslateY }, klass, value);
-    parseOptionalProperty<PropertyTransition>("fill-translate-transition", Key::FillTranslate, klass, value);
-    parseOptionalProperty<TranslateAnchorType>("fill-translate-anchor", Key::FillTranslateAnchor, klass, value);
-    parseOptionalProperty<std::string>("fill-image", Key::FillImage, klass, value);
-
-    parseOptionalProperty<Function<float>>("line-opacity", Key::LineOpacity, klass, value);
-    parseOptionalProperty<PropertyTransition>("line-opacity-transition", Key::LineOpacity, klass, value);
-    parseOptionalProperty<Function<Color>>("line-color", Key::LineColor, klass, value);
-    parseOptionalProperty<PropertyTransition>("line-color-transition", Key::LineColor, klass, value);
-    parseOptionalProperty<Function<float>>("line-translate", { Key::LineTranslateX, Key::LineTranslateY }, klass, value);
-    parseOptionalProperty<PropertyTransition>("line-translate-transition", Key::LineTranslate, klass, value);
-    parseOptionalProperty<TranslateAnchorType>("line-translate-anchor", Key::LineTranslateAnchor, klass, value);
-    parseOptionalProperty<Function<float>>("line-width", Key::LineWidth, klass, value);
-    parseOptionalProperty<PropertyTransition>("line-width-transition", Key::LineWidth, klass, value);
-    parseOptionalProperty<Function<float>>("line-gap-width", Key::LineGapWidth, klass, value);
-    parseOptionalProperty<PropertyTransition>("line-gap-width-transition", Key::LineGapWidth, klass, value);
-    parseOptionalProperty<Function<float>>("line-blur", Key::LineBlur, klass, value);
-    parseOptionalProperty<PropertyTransition>("line-blur-transition", Key::LineBlur, klass, value);
-    parseOptionalProperty<Function<std::vector<float>>>("line-dasharray", Key::LineDashArray, klass, value);
-    parseOptionalProperty<std::string>("line-image", Key::LineImage, klass, value);
-
-    parseOptionalProperty<Function<float>>("icon-opacity", Key::IconOpacity, klass, value);
-    parseOptionalProperty<PropertyTransition>("icon-opacity-transition", Key::IconOpacity, klass, value);
-    parseOptionalProperty<Function<float>>("icon-rotate", Key::IconRotate, klass, value);
-    parseOptionalProperty<Function<float>>("icon-size", Key::IconSize, klass, value);
-    parseOptionalProperty<PropertyTransition>("icon-size-transition", Key::IconSize, klass, value);
-    parseOptionalProperty<Function<Color>>("icon-color", Key::IconColor, klass, value);
-    parseOptionalProperty<PropertyTransition>("icon-color-transition", Key::IconColor, klass, value);
-    parseOptionalProperty<Function<Color>>("icon-halo-color", Key::IconHaloColor, klass, value);
-    parseOptionalProperty<PropertyTransition>("icon-halo-color-transition", Key::IconHaloColor, klass, value);
-    parseOptionalProperty<Function<float>>("icon-halo-width", Key::IconHaloWidth, klass, value);
-    parseOptionalProperty<PropertyTransition>("icon-halo-width-transition", Key::IconHaloWidth, klass, value);
-    parseOptionalProperty<Function<float>>("icon-halo-blur", Key::IconHaloBlur, klass, value);
-    parseOptionalProperty<PropertyTransition>("icon-halo-blur-transition", Key::IconHaloBlur, klass, value);
-    parseOptionalProperty<Function<float>>("icon-translate", { Key::IconTranslateX, Key::IconTranslateY }, klass, value);
-    parseOptionalProperty<PropertyTransition>("icon-translate-transition", Key::IconTranslate, klass, value);
-    parseOptionalProperty<TranslateAnchorType>("icon-translate-anchor", Key::IconTranslateAnchor, klass, value);
-
-    parseOptionalProperty<Function<float>>("text-opacity", Key::TextOpacity, klass, value);
-    parseOptionalProperty<PropertyTransition>("text-opacity-transition", Key::TextOpacity, klass, value);
-    parseOptionalProperty<Function<float>>("text-size", Key::TextSize, klass, value);
-    parseOptionalProperty<PropertyTransition>("text-size-transition", Key::TextSize, klass, value);
-    parseOptionalProperty<Function<Color>>("text-color", Key::TextColor, klass, value);
-    parseOptionalProperty<PropertyTransition>("text-color-transition", Key::TextColor, klass, value);
-    parseOptionalProperty<Function<Color>>("text-halo-color", Key::TextHaloColor, klass, value);
-    parseOptionalProperty<PropertyTransition>("text-halo-color-transition", Key::TextHaloColor, klass, value);
-    parseOptionalProperty<Function<float>>("text-halo-width", Key::TextHaloWidth, klass, value);
-    parseOptionalProperty<PropertyTransition>("text-halo-width-transition", Key::TextHaloWidth, klass, value);
-    parseOptionalProperty<Function<float>>("text-halo-blur", Key::TextHaloBlur, klass, value);
-    parseOptionalProperty<PropertyTransition>("text-halo-blur-transition", Key::TextHaloBlur, klass, value);
-    parseOptionalProperty<Function<float>>("text-translate", { Key::TextTranslateX, Key::TextTranslateY }, klass, value);
-    parseOptionalProperty<PropertyTransition>("text-translate-transition", Key::TextTranslate, klass, value);
-    parseOptionalProperty<TranslateAnchorType>("text-translate-anchor", Key::TextTranslateAnchor, klass, value);
-
-    parseOptionalProperty<Function<float>>("raster-opacity", Key::RasterOpacity, klass, value);
-    parseOptionalProperty<PropertyTransition>("raster-opacity-transition", Key::RasterOpacity, klass, value);
-    parseOptionalProperty<Function<float>>("raster-hue-rotate", Key::RasterHueRotate, klass, value);
-    parseOptionalProperty<PropertyTransition>("raster-hue-rotate-transition", Key::RasterHueRotate, klass, value);
-    parseOptionalProperty<Function<float>>("raster-brightness", { Key::RasterBrightnessLow, Key::RasterBrightnessHigh }, klass, value);
-    parseOptionalProperty<PropertyTransition>("raster-brightness-transition", Key::RasterBrightness, klass, value);
-    parseOptionalProperty<Function<float>>("raster-saturation", Key::RasterSaturation, klass, value);
-    parseOptionalProperty<PropertyTransition>("raster-saturation-transition", Key::RasterSaturation, klass, value);
-    parseOptionalProperty<Function<float>>("raster-contrast", Key::RasterContrast, klass, value);
-    parseOptionalProperty<PropertyTransition>("raster-contrast-transition", Key::RasterContrast, klass, value);
-    parseOptionalProperty<Function<float>>("raster-fade-duration", Key::RasterFade, klass, value);
-    parseOptionalProperty<PropertyTransition>("raster-fade-duration-transition", Key::RasterFade, klass, value);
-
-    parseOptionalProperty<Function<float>>("background-opacity", Key::BackgroundOpacity, klass, value);
-    parseOptionalProperty<Function<Color>>("background-color", Key::BackgroundColor, klass, value);
-    parseOptionalProperty<std::string>("background-image", Key::BackgroundImage, klass, value);
+    static const std::unordered_map<std::string, PaintProperty> properties {
+        { "fill-antialias", paintProperty<Function<bool>>(Key::FillAntialias) },
+        { "fill-opacity", paintProperty<Function<float>>(Key::FillOpacity) },
+        { "fill-opacity-transition", paintProperty<PropertyTransition>(Key::FillOpacity) },
+        { "fill-color", paintProperty<Function<Color>>(Key::FillColor) },
+        { "fill-color-transition", paintProperty<PropertyTransition>(Key::FillColor) },
+        { "fill-outline-color", paintProperty<Function<Color>>(Key::FillOutlineColor) },
+        { "fill-outline-color-transition", paintProperty<PropertyTransition>(Key::FillOutlineColor) },
+        { "fill-translate", paintProperty<Function<float>>({ Key::FillTranslateX, Key::FillTranslateY }) },
+        { "fill-translate-transition", paintProperty<PropertyTransition>(Key::FillTranslate) },
+        { "fill-translate-anchor", paintProperty<TranslateAnchorType>(Key::FillTranslateAnchor) },
+        { "fill-image", paintProperty<std::string>(Key::FillImage) },
+
+        { "line-opacity", paintProperty<Function<float>>(Key::LineOpacity) },
+        { "line-opacity-transition", paintProperty<PropertyTransition>(Key::LineOpacity) },
+        { "line-color", paintProperty<Function<Color>>(Key::LineColor) },
+        { "line-color-transition", paintProperty<PropertyTransition>(Key::LineColor) },
+        { "line-translate", paintProperty<Function<float>>({ Key::LineTranslateX, Key::LineTranslateY }) },
+        { "line-translate-transition", paintProperty<PropertyTransition>(Key::LineTranslate) },
+        { "line-translate-anchor", paintProperty<TranslateAnchorType>(Key::LineTranslateAnchor) },
+        { "line-width", paintProperty<Function<float>>(Key::LineWidth) },
+        { "line-width-transition", paintProperty<PropertyTransition>(Key::LineWidth) },
+        { "line-gap-width", paintProperty<Function<float>>(Key::LineGapWidth) },
+        { "line-gap-width-transition", paintProperty<PropertyTransition>(Key::LineGapWidth) },
+        { "line-blur", paintProperty<Function<float>>(Key::LineBlur) },
+        { "line-blur-transition", paintProperty<PropertyTransition>(Key::LineBlur) },
+        { "line-dasharray", paintProperty<Function<std::vector<float>>>(Key::LineDashArray) },
+        { "line-image", paintProperty<std::string>(Key::LineImage) },
+
+        { "circle-opacity", paintProperty<Function<float>>(Key::CircleOpacity) },
+        { "circle-opacity-transition", paintProperty<PropertyTransition>(Key::CircleOpacity) },
+        { "circle-color", paintProperty<Function<Color>>(Key::CircleColor) },
+        { "circle-color-transition", paintProperty<PropertyTransition>(Key::CircleColor) },
+        { "circle-translate", paintProperty<Function<float>>({ Key::CircleTranslateX, Key::CircleTranslateY }) },
+        { "circle-translate-transition", paintProperty<PropertyTransition>(Key::CircleTranslate) },
+        { "circle-translate-anchor", paintProperty<TranslateAnchorType>(Key::CircleTranslateAnchor) },
+        { "circle-radius", paintProperty<Function<float>>(Key::CircleRadius) },
+        { "circle-radius-transition", paintProperty<PropertyTransition>(Key::CircleRadius) },
+        { "circle-blur", paintProperty<Function<float>>(Key::CircleBlur) },
+        { "circle-blur-transition", paintProperty<PropertyTransition>(Key::CircleBlur) },
+
+        { "icon-opacity", paintProperty<Function<float>>(Key::IconOpacity) },
+        { "icon-opacity-transition", paintProperty<PropertyTransition>(Key::IconOpacity) },
+        { "icon-rotate", paintProperty<Function<float>>(Key::IconRotate) },
+        { "icon-size", paintProperty<Function<float>>(Key::IconSize) },
+        { "icon-size-transition", paintProperty<PropertyTransition>(Key::IconSize) },
+        { "icon-color", paintProperty<Function<Color>>(Key::IconColor) },
+        { "icon-color-transition", paintProperty<PropertyTransition>(Key::IconColor) },
+        { "icon-halo-color", paintProperty<Function<Color>>(Key::IconHaloColor) },
+        { "icon-halo-color-transition", paintProperty<PropertyTransition>(Key::IconHaloColor) },
+        { "icon-halo-width", paintProperty<Function<float>>(Key::IconHaloWidth) },
+        { "icon-halo-width-transition", paintProperty<PropertyTransition>(Key::IconHaloWidth) },
+        { "icon-halo-blur", paintProperty<Function<float>>(Key::IconHaloBlur) },
+        { "icon-halo-blur-transition", paintProperty<PropertyTransition>(Key::IconHaloBlur) },
+        { "icon-translate", paintProperty<Function<float>>({ Key::IconTranslateX, Key::IconTranslateY }) },
+        { "icon-translate-transition", paintProperty<PropertyTransition>(Key::IconTranslate) },
+        { "icon-translate-anchor", paintProperty<TranslateAnchorType>(Key::IconTranslateAnchor) },
+
+        { "text-opacity", paintProperty<Function<float>>(Key::TextOpacity) },
+        { "text-opacity-transition", paintProperty<PropertyTransition>(Key::TextOpacity) },
+        { "text-size", paintProperty<Function<float>>(Key::TextSize) },
+        { "text-size-transition", paintProperty<PropertyTransition>(Key::TextSize) },
+        { "text-color", paintProperty<Function<Color>>(Key::TextColor) },
+        { "text-color-transition", paintProperty<PropertyTransition>(Key::TextColor) },
+        { "text-halo-color", paintProperty<Function<Color>>(Key::TextHaloColor) },
+        { "text-halo-color-transition", paintProperty<PropertyTransition>(Key::TextHaloColor) },
+        { "text-halo-width", paintProperty<Function<float>>(Key::TextHaloWidth) },
+        { "text-halo-width-transition", paintProperty<PropertyTransition>(Key::TextHaloWidth) },
+        { "text-halo-blur", paintProperty<Function<float>>(Key::TextHaloBlur) },
+        { "text-halo-blur-transition", paintProperty<PropertyTransition>(Key::TextHaloBlur) },
+        { "text-translate", paintProperty<Function<float>>({ Key::TextTranslateX, Key::TextTranslateY }) },
+        { "text-translate-transition", paintProperty<PropertyTransition>(Key::TextTranslate) },
+        { "text-translate-anchor", paintProperty<TranslateAnchorType>(Key::TextTranslateAnchor) },
+
+        { "raster-opacity", paintProperty<Function<float>>(Key::RasterOpacity) },
+        { "raster-opacity-transition", paintProperty<PropertyTransition>(Key::RasterOpacity) },
+        { "raster-hue-rotate", paintProperty<Function<float>>(Key::RasterHueRotate) },
+        { "raster-hue-rotate-transition", paintProperty<PropertyTransition>(Key::RasterHueRotate) },
+        { "raster-brightness", paintProperty<Function<float>>({ Key::RasterBrightnessLow, Key::RasterBrightnessHigh }) },
+        { "raster-brightness-transition", paintProperty<PropertyTransition>(Key::RasterBrightness) },
+        { "raster-saturation", paintProperty<Function<float>>(Key::RasterSaturation) },
+        { "raster-saturation-transition", paintProperty<PropertyTransition>(Key::RasterSaturation) },
+        { "raster-contrast", paintProperty<Function<float>>(Key::RasterContrast) },
+        { "raster-contrast-transition", paintProperty<PropertyTransition>(Key::RasterContrast) },
+        { "raster-fade-duration", paintProperty<Function<float>>(Key::RasterFade) },
+        { "raster-fade-duration-transition", paintProperty<PropertyTransition>(Key::RasterFade) },
+
+        { "background-opacity", paintProperty<Function<float>>(Key::BackgroundOpacity) },
+        { "background-color", paintProperty<Function<Color>>(Key::BackgroundColor) },
+        { "background-image", paintProperty<std::string>(Key::BackgroundImage) },
+    };
+    return properties;
+}
+
+void StyleParser::parsePaint(JSVal value, ClassProperties &klass) {
+    if (!value.IsObject()) {
+        Log::Warning(Event::ParseStyle, "paint must be an object");
+        return;
+    }
+
+    // Looks up every key of the paint object once, instead of searching the object for every
+    // property that could be in it.
+    const std::unordered_map<std::string, PaintProperty> &properties = paintProperties();
+    for (rapidjson::Value::ConstMemberIterator itr = value.MemberBegin(); itr != value.MemberEnd(); ++itr) {
+        const auto it = properties.find({ itr->name.GetString(), itr->name.GetStringLength() });
+        if (it == properties.end()) {
+            continue;
+        }
+
+        JSVal rvalue = replaceConstant(itr->value);
+        if (rvalue.IsObject() && rvalue.HasMember("property")) {
+            // Property functions vary per feature, so they are evaluated when the bucket is
+            // parsed; see parseFeatureColors().
+            if (it->first != "fill-color") {
+                Log::Warning(Event::ParseStyle, "'%s' can't be a property function", it->first.c_str());
+            }
+            continue;
+        }
+
+        it->second(*this, itr->value, it->first.c_str(), klass);
+    }
 }
 
 void StyleParser::parseReference(JSVal value, util::ptr<StyleLayer> &layer) {
@@ -667,8 +749,58 @@ void StyleParser::parseReference(JSVal value, util::ptr<StyleLayer> &layer) {
 
 #pragma mark - Parse Bucket
 
+// Serializes everything that goes into the bucket of a layer. Layers that only differ in their
+// paint properties (e.g. road casings and fills) have the same key.
+std::string StyleParser::bucketKey(JSVal value, StyleLayerType type) {
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartArray();
+    writer.Uint(static_cast<uint32_t>(type));
+    for (const char *name : { "source", "source-layer", "filter", "layout", "minzoom", "maxzoom" }) {
+        if (value.HasMember(name)) {
+            replaceConstant(value[name]).Accept(writer);
+        } else {
+            writer.Null();
+        }
+    }
+
+    // Property functions are evaluated into the bucket; see parseFeatureColors().
+    if (type == StyleLayerType::Fill && value.HasMember("paint")) {
+        JSVal value_paint = replaceConstant(value["paint"]);
+        if (value_paint.IsObject() && value_paint.HasMember("fill-color")) {
+            JSVal value_color = replaceConstant(value_paint["fill-color"]);
+            if (value_color.IsObject() && value_color.HasMember("property")) {
+                value_color.Accept(writer);
+            }
+        }
+    }
+
+    writer.EndArray();
+    return { buffer.GetString(), buffer.Size() };
+}
+
 void StyleParser::parseBucket(JSVal value, util::ptr<StyleLayer> &layer) {
+    // Layers whose buckets would be identical share one, so that its geometry is only built once
+    // per tile and drawn once for every layer.
+    const bool shareable = layer->type == StyleLayerType::Fill ||
+                           layer->type == StyleLayerType::Line ||
+                           layer->type == StyleLayerType::Circle ||
+                           layer->type == StyleLayerType::Symbol;
+    std::string key;
+    if (shareable) {
+        key = bucketKey(value, layer->type);
+        auto bucket_it = buckets.find(key);
+        if (bucket_it != buckets.end()) {
+            layer->bucket = bucket_it->second;
+            return;
+        }
+    }
+
     layer->bucket = std::make_shared<StyleBucket>(layer->type);
+    if (shareable) {
+        buckets.emplace(key, layer->bucket);
+        layer->bucket->key = key;
+    }
 
     // We name the buckets according to the layer that defined it.
     layer->bucket->name = layer->id;
@@ -697,14 +829,27 @@ void StyleParser::parseBucket(JSVal value, util::ptr<StyleLayer> &layer) {
         }
     }
 
+    // The tiles of a GeoJSON source have a single layer.
+    if (layer->bucket->style_source && layer->bucket->style_source->info.type == SourceType::GeoJSON) {
+        layer->bucket->source_layer = util::geojsonLayerName;
+    }
+
     if (value.HasMember("filter")) {
         JSVal value_filter = replaceConstant(value["filter"]);
         layer->bucket->filter = parseFilterExpression(value_filter);
+        layer->bucket->compiled_filter = FilterProgram(layer->bucket->filter);
     }
 
     if (value.HasMember("layout")) {
         JSVal value_render = replaceConstant(value["layout"]);
-        parseLayout(value_render, layer);
+        parseLayout(value_render, *layer, *layer->bucket);
+    }
+
+    if (layer->type == StyleLayerType::Fill && value.HasMember("paint")) {
+        JSVal value_paint = replaceConstant(value["paint"]);
+        if (value_paint.IsObject() && value_paint.HasMember("fill-color")) {
+            parseFeatureColors(replaceConstant(value_paint["fill-color"]), layer);
+        }
     }
 
     if (value.HasMember("minzoom")) {
@@ -726,16 +871,54 @@ void StyleParser::parseBucket(JSVal value, util::ptr<StyleLayer> &layer) {
     }
 }
 
-void StyleParser::parseLayout(JSVal value, util::ptr<StyleLayer> &layer) {
+// Parses a property function of the form
+// { "property": "class", "stops": [["motorway", "#f00"], ...], "default": "#000" }
+// into the bucket, which writes the color of every feature into its vertices.
+void StyleParser::parseFeatureColors(JSVal value, util::ptr<StyleLayer> &layer) {
+    if (!value.IsObject() || !value.HasMember("property")) {
+        // Constants and zoom functions apply to the entire layer and are parsed with the paint.
+        return;
+    }
+
+    JSVal value_property = value["property"];
+    if (!value_property.IsString()) {
+        Log::Warning(Event::ParseStyle, "property of the fill-color of layer '%s' must be a string", layer->id.c_str());
+        return;
+    }
+
+    if (!value.HasMember("stops") || !value["stops"].IsArray()) {
+        Log::Warning(Event::ParseStyle, "property function of layer '%s' must have a stops array", layer->id.c_str());
+        return;
+    }
+
+    StyleBucketFill &render = layer->bucket->render.get<StyleBucketFill>();
+    render.color_property = { value_property.GetString(), value_property.GetStringLength() };
+
+    JSVal value_stops = value["stops"];
+    for (rapidjson::SizeType i = 0; i < value_stops.Size(); ++i) {
+        JSVal stop = value_stops[i];
+        if (!stop.IsArray() || stop.Size() != 2) {
+            Log::Warning(Event::ParseStyle, "property function stop must be an array with two elements");
+            continue;
+        }
+        render.color_stops.emplace_back(parseValue(stop[rapidjson::SizeType(0)]),
+                                        parseFunctionArgument<Color>(stop[rapidjson::SizeType(1)]));
+    }
+
+    if (value.HasMember("default")) {
+        render.color_default = parseFunctionArgument<Color>(value["default"]);
+    }
+}
+
+void StyleParser::parseLayout(JSVal value, const StyleLayer &layer, StyleBucket &bucket) {
     if (!value.IsObject()) {
-        Log::Warning(Event::ParseStyle, "layout property of layer '%s' must be an object", layer->id.c_str());
+        Log::Warning(Event::ParseStyle, "layout property of layer '%s' must be an object", layer.id.c_str());
         return;
     }
 
-    StyleBucket &bucket = *layer->bucket;
     parseRenderProperty<VisibilityTypeClass>(value, bucket.visibility, "visibility");
 
-    switch (layer->type) {
+    switch (layer.type) {
     case StyleLayerType::Fill: {
         StyleBucketFill &render = bucket.render.get<StyleBucketFill>();
 
@@ -763,6 +946,7 @@ void StyleParser::parseLayout(JSVal value, util::ptr<StyleLayer> &layer) {
 
         parseRenderProperty(value, render.min_distance, "symbol-min-distance");
         parseRenderProperty(value, render.avoid_edges, "symbol-avoid-edges");
+        parseRenderProperty(value, render.sort_key, "symbol-sort-key");
 
         parseRenderProperty(value, render.icon.allow_overlap, "icon-allow-overlap");
         parseRenderProperty(value, render.icon.ignore_placement, "icon-ignore-placement");
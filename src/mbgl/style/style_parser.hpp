@@ -10,6 +10,7 @@
 
 #include <unordered_map>
 #include <forward_list>
+#include <functional>
 #include <tuple>
 
 namespace mbgl {
@@ -39,6 +40,11 @@ public:
         return glyph_url;
     }
 
+    // Parse the paint and layout objects of a single layer, also outside of a style document to
+    // change a loaded style. Constants only resolve while parsing a document.
+    void parsePaint(JSVal, ClassProperties &properties);
+    void parseLayout(JSVal value, const StyleLayer &layer, StyleBucket &bucket);
+
 private:
     void parseConstants(JSVal value);
     JSVal replaceConstant(JSVal value);
@@ -50,10 +56,10 @@ private:
     void parseLayers();
     void parseLayer(std::pair<JSVal, util::ptr<StyleLayer>> &pair);
     void parsePaints(JSVal value, std::map<ClassID, ClassProperties> &paints);
-    void parsePaint(JSVal, ClassProperties &properties);
     void parseReference(JSVal value, util::ptr<StyleLayer> &layer);
+    std::string bucketKey(JSVal value, StyleLayerType type);
     void parseBucket(JSVal value, util::ptr<StyleLayer> &layer);
-    void parseLayout(JSVal value, util::ptr<StyleLayer> &layer);
+    void parseFeatureColors(JSVal value, util::ptr<StyleLayer> &layer);
     void parseSprite(JSVal value);
     void parseGlyphURL(JSVal value);
 
@@ -63,11 +69,16 @@ private:
     template <typename Parser, typename T>
     bool parseRenderProperty(JSVal value, T &target, const char *name);
 
-    // Parses optional properties into style class properties.
+    // Parses the value of a paint key into style class properties.
+    typedef std::function<void(StyleParser &, JSVal value, const char *property_name, ClassProperties &)> PaintProperty;
     template <typename T>
-    bool parseOptionalProperty(const char *property_name, PropertyKey key, ClassProperties &klass, JSVal value);
+    static PaintProperty paintProperty(PropertyKey key);
+    // For array values whose elements go into one key each.
     template <typename T>
-    bool parseOptionalProperty(const char *property_name, const std::vector<PropertyKey> &keys, ClassProperties &klass, JSVal value);
+    static PaintProperty paintProperty(std::vector<PropertyKey> keys);
+    // Maps the names of all paint keys to their parsers.
+    static const std::unordered_map<std::string, PaintProperty> &paintProperties();
+
     template <typename T>
     bool setProperty(JSVal value, const char *property_name, PropertyKey key, ClassProperties &klass);
 
@@ -92,6 +103,9 @@ private:
     // This maps ids to Layer objects, with all items being at the root level.
     std::unordered_map<std::string, std::pair<JSVal, util::ptr<StyleLayer>>> layers;
 
+    // Maps the serialized bucket definitions of the layers parsed so far to their buckets.
+    std::unordered_map<std::string, util::ptr<StyleBucket>> buckets;
+
     // Store a stack of layers we're parsing right now. This is to prevent reference cycles.
     std::forward_list<StyleLayer *> stack;
 
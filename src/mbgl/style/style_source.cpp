@@ -1,7 +1,12 @@
 #include <mbgl/style/style_source.hpp>
 #include <mbgl/platform/platform.hpp>
 #include <mbgl/platform/log.hpp>
+#include <mbgl/util/token.hpp>
+#include <mbgl/util/constants.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <limits>
 
 namespace mbgl {
@@ -67,6 +72,11 @@ void parse(const rapidjson::Value& value, std::array<float, N>& target, const ch
 
 void SourceInfo::parseTileJSONProperties(const rapidjson::Value& value) {
     parse(value, tiles, "tiles");
+    tileTemplates.clear();
+    for (const std::string &tile : tiles) {
+        tileTemplates.emplace_back(tile);
+    }
+
     parse(value, min_zoom, "minzoom");
     parse(value, max_zoom, "maxzoom");
     parse(value, attribution, "attribution");
@@ -74,4 +84,75 @@ void SourceInfo::parseTileJSONProperties(const rapidjson::Value& value) {
     parse(value, bounds, "bounds");
 }
 
+SourceInfo::TileURLTemplate::TileURLTemplate(const std::string &url)
+    : segments(url), length(url.length()) {
+    for (const std::string &token : segments.tokens()) {
+        if (token == "z") tokens.push_back(Token::Z);
+        else if (token == "x") tokens.push_back(Token::X);
+        else if (token == "y") tokens.push_back(Token::Y);
+        else if (token == "prefix") tokens.push_back(Token::Prefix);
+        else if (token == "ratio") tokens.push_back(Token::Ratio);
+        else tokens.push_back(Token::Unknown);
+    }
+}
+
+static void appendNumber(std::string &result, int32_t value) {
+    char buffer[12];
+    result.append(buffer, snprintf(buffer, sizeof(buffer), "%d", value));
+}
+
+std::string SourceInfo::tileURL(const Tile::ID& id, float pixelRatio) const {
+    if (tileTemplates.empty()) {
+        return "";
+    }
+
+    const TileURLTemplate &tileTemplate = tileTemplates[(id.x + id.y) % tileTemplates.size()];
+    std::string url;
+    url.reserve(tileTemplate.length + 16);
+    tileTemplate.segments.render(url, [&](size_t token, std::string &result) {
+        switch (tileTemplate.tokens[token]) {
+            case TileURLTemplate::Token::Z: appendNumber(result, id.z); break;
+            case TileURLTemplate::Token::X: appendNumber(result, id.x); break;
+            case TileURLTemplate::Token::Y: appendNumber(result, id.y); break;
+            case TileURLTemplate::Token::Prefix:
+                result += "0123456789abcdef"[id.x % 16];
+                result += "0123456789abcdef"[id.y % 16];
+                break;
+            case TileURLTemplate::Token::Ratio:
+                if (pixelRatio > 1.0) result += "@2x";
+                break;
+            case TileURLTemplate::Token::Unknown: break;
+        }
+    });
+    return url;
+}
+
+bool SourceInfo::containsTile(const Tile::ID& id) const {
+    // Tiles of the world copies show the same data.
+    const double scale = 1 << id.z;
+    const double x = id.x - double(id.w) * scale;
+    const auto latitude = [scale](double y) {
+        return std::atan(std::sinh(M_PI * (1 - 2 * y / scale))) * 180 / M_PI;
+    };
+
+    const double west = x / scale * 360 - 180;
+    const double east = (x + 1) / scale * 360 - 180;
+    const double north = latitude(id.y);
+    const double south = latitude(id.y + 1);
+    return west < bounds[2] && east > bounds[0] && south < bounds[3] && north > bounds[1];
+}
+
+double SourceInfo::getZoomOffset(float pixelRatio) const {
+    double offset = std::log2(util::tileSize / tile_size);
+    if (type == SourceType::Raster && pixelRatio > 1.0) {
+        const bool retina = std::any_of(tiles.begin(), tiles.end(), [](const std::string &url) {
+            return url.find("{ratio}") != std::string::npos;
+        });
+        if (!retina) {
+            offset += 1;
+        }
+    }
+    return offset;
+}
+
 }
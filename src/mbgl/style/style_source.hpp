@@ -2,8 +2,10 @@
 #define MBGL_STYLE_STYLE_SOURCE
 
 #include <mbgl/style/types.hpp>
+#include <mbgl/map/tile.hpp>
 #include <mbgl/util/ptr.hpp>
 #include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/token.hpp>
 #include <rapidjson/document.h>
 
 #include <vector>
@@ -15,8 +17,21 @@ class Source;
 
 class SourceInfo : private util::noncopyable {
 public:
+    // The name of the source in the style.
+    std::string id;
     SourceType type = SourceType::Vector;
     std::string url;
+
+    // The serialized data of a GeoJSON source, unless it is loaded from the URL.
+    std::string geojson;
+
+    // Whether a GeoJSON source merges points that are close to each other, and up to which zoom
+    // level.
+    bool cluster = false;
+    uint16_t cluster_radius = 50;
+    uint16_t cluster_max_zoom = 17;
+
+    // Set by parseTileJSONProperties(), which also prepares them for tileURL().
     std::vector<std::string> tiles;
     uint16_t tile_size = 512;
     uint16_t min_zoom = 0;
@@ -26,6 +41,33 @@ public:
     std::array<float, 4> bounds = {{-180, -90, 180, 90}};
 
     void parseTileJSONProperties(const rapidjson::Value&);
+
+    // Fills in the tile URL template for this tile. Returns an empty string when the source
+    // doesn't have any tile URLs yet.
+    std::string tileURL(const Tile::ID& id, float pixelRatio) const;
+
+    // How many zoom levels deeper than the map the tiles of this source are loaded, so that they
+    // are shown at their size. Raster tiles without a high resolution variant are loaded one more
+    // level deeper on high resolution screens; vector tiles are sharp at any pixel ratio.
+    double getZoomOffset(float pixelRatio) const;
+
+    // Whether the tile overlaps the bounds of the source. Tiles outside of them don't exist.
+    bool containsTile(const Tile::ID& id) const;
+
+private:
+    // A tile URL that is split into literal text and tokens once, so that filling it in for a
+    // tile doesn't scan the URL or compare token names again.
+    struct TileURLTemplate {
+        enum class Token : uint8_t { Z, X, Y, Prefix, Ratio, Unknown };
+
+        explicit TileURLTemplate(const std::string &url);
+
+        util::TokenTemplate segments;
+        std::vector<Token> tokens;
+        size_t length;
+    };
+
+    std::vector<TileURLTemplate> tileTemplates;
 };
 
 
@@ -33,6 +75,13 @@ class StyleSource : private util::noncopyable {
 public:
     SourceInfo info;
     bool enabled = false;
+
+    // The serialized definition of the source in the style, to find the same source in the next
+    // revision of a style.
+    std::string definition;
+
+    // Minimum and maximum zoom levels of the visible layers that use this source.
+    std::vector<std::pair<float, float>> zoom_ranges;
     util::ptr<Source> source;
 };
 
@@ -16,10 +16,11 @@ struct relaxed_operator_visitor {
     typedef bool result_type;
 
     template <typename T0, typename T1>
-    inline bool operator()(T0, T1) const { return false; }
+    inline bool operator()(const T0&, const T1&) const { return false; }
 
+    // Strings are compared in place instead of being copied for every comparison.
     template <typename T>
-    inline bool operator()(T lhs, T rhs) const { return Operator()(lhs, rhs); }
+    inline bool operator()(const T& lhs, const T& rhs) const { return Operator()(lhs, rhs); }
 
     inline bool operator()(int64_t lhs, uint64_t rhs) const {
         return Operator()(double(lhs), double(rhs));
@@ -48,32 +49,32 @@ struct relaxed_operator_visitor {
 
 struct relaxed_equal_operator {
     template <typename T0, typename T1>
-    inline bool operator()(T0 lhs, T1 rhs) const { return lhs == rhs; }
+    inline bool operator()(const T0& lhs, const T1& rhs) const { return lhs == rhs; }
 };
 
 struct relaxed_not_equal_operator {
     template <typename T0, typename T1>
-    inline bool operator()(T0 lhs, T1 rhs) const { return lhs != rhs; }
+    inline bool operator()(const T0& lhs, const T1& rhs) const { return lhs != rhs; }
 };
 
 struct relaxed_greater_operator {
     template <typename T0, typename T1>
-    inline bool operator()(T0 lhs, T1 rhs) const { return lhs > rhs; }
+    inline bool operator()(const T0& lhs, const T1& rhs) const { return lhs > rhs; }
 };
 
 struct relaxed_greater_equal_operator {
     template <typename T0, typename T1>
-    inline bool operator()(T0 lhs, T1 rhs) const { return lhs >= rhs; }
+    inline bool operator()(const T0& lhs, const T1& rhs) const { return lhs >= rhs; }
 };
 
 struct relaxed_less_operator {
     template <typename T0, typename T1>
-    inline bool operator()(T0 lhs, T1 rhs) const { return lhs < rhs; }
+    inline bool operator()(const T0& lhs, const T1& rhs) const { return lhs < rhs; }
 };
 
 struct relaxed_less_equal_operator {
     template <typename T0, typename T1>
-    inline bool operator()(T0 lhs, T1 rhs) const { return lhs <= rhs; }
+    inline bool operator()(const T0& lhs, const T1& rhs) const { return lhs <= rhs; }
 };
 
 } // end namespace detail
@@ -1,6 +1,7 @@
 #include <mbgl/text/collision.hpp>
 #include <mbgl/text/rotation_range.hpp>
 #include <mbgl/util/math.hpp>
+#include <mbgl/util/constants.hpp>
 
 
 using namespace mbgl;
@@ -19,11 +20,25 @@ Box getBox(const CollisionAnchor &anchor, const CollisionRect &bbox, float minSc
     };
 };
 
+void CollisionIndex::remove(const Tile::ID &id) {
+    std::lock_guard<std::mutex> lock(mtx);
+    tiles.erase(id);
+}
+
 Collision::Collision(float zoom_, float tileExtent, float tileSize, float placementDepth)
+    : Collision(Tile::ID(zoom_, 0, 0), nullptr, tileExtent, tileSize, placementDepth) {
+}
+
+Collision::Collision(const Tile::ID &id_, const util::ptr<CollisionIndex> &index_,
+                     float tileExtent, float tileSize, float placementDepth)
       // tile pixels per screen pixels at the tile's zoom level
-    : tilePixelRatio(tileExtent / tileSize),
+    : id(id_),
+      index(index_),
+      tilePixelRatio(tileExtent / tileSize),
 
-      zoom(zoom_),
+      // The map zoom level at which the tile is drawn at its size, so that placement zoom levels
+      // can be compared to the zoom level of the map.
+      zoom(id.z + std::log2(tileSize / util::tileSize)),
 
       // Calculate the maximum scale we can go down in our fake-3d rtree so that
       // placement still makes sense. This is calculated so that the minimum
@@ -33,7 +48,7 @@ Collision::Collision(float zoom_, float tileExtent, float tileSize, float placem
       // We don't want to place labels all the way to 25.5. This lets too many
       // glyphs be placed, slowing down collision checking. Only place labels if
       // they will show up within the intended zoom range of the tile.
-      maxPlacementScale(std::exp(std::log(2) * util::min(3.0f, placementDepth, 25.5f - zoom_))) {
+      maxPlacementScale(std::exp(std::log(2) * util::min(3.0f, placementDepth, 25.5f - zoom))) {
     const float m = 4096;
     const float edge = m * tilePixelRatio * 2;
 
@@ -84,6 +99,77 @@ Collision::Collision(float zoom_, float tileExtent, float tileSize, float placem
 
 }
 
+void Collision::query(const Box &box, bool curved, std::vector<PlacementValue> &result) {
+    if (!index) {
+        hTree.query(box, result);
+        if (curved) {
+            cTree.query(box, result);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(index->mtx);
+    if (!cleared) {
+        index->tiles.erase(id);
+        cleared = true;
+    }
+
+    const int32_t dim = 1 << id.z;
+    const float extent = 4096;
+    for (int32_t dy = -1; dy <= 1; dy++) {
+        if (id.y + dy < 0 || id.y + dy >= dim) {
+            continue;
+        }
+        for (int32_t dx = -1; dx <= 1; dx++) {
+            // Tiles wrap around the antimeridian.
+            const Tile::ID neighbor(id.z, (id.x + dx + dim) % dim, id.y + dy);
+            auto it = index->tiles.find(neighbor);
+            if (it == index->tiles.end()) {
+                continue;
+            }
+
+            const float ox = dx * extent;
+            const float oy = dy * extent;
+            const Box translated {
+                Point { box.min_corner().get<0>() - ox, box.min_corner().get<1>() - oy },
+                Point { box.max_corner().get<0>() - ox, box.max_corner().get<1>() - oy }
+            };
+
+            const size_t first = result.size();
+            it->second.hTree.query(translated, result);
+            if (curved) {
+                it->second.cTree.query(translated, result);
+            }
+
+            if (dx == 0 && dy == 0) {
+                continue;
+            }
+            for (size_t i = first; i < result.size(); i++) {
+                Box &b = std::get<0>(result[i]);
+                b = Box {
+                    Point { b.min_corner().get<0>() + ox, b.min_corner().get<1>() + oy },
+                    Point { b.max_corner().get<0>() + ox, b.max_corner().get<1>() + oy }
+                };
+                CollisionAnchor &anchor = std::get<1>(result[i]).anchor;
+                anchor = CollisionAnchor { anchor.x + ox, anchor.y + oy };
+            }
+        }
+    }
+}
+
+Tree &Collision::getTree(bool horizontal) {
+    if (!index) {
+        return horizontal ? hTree : cTree;
+    }
+
+    if (!cleared) {
+        index->tiles.erase(id);
+        cleared = true;
+    }
+    CollisionIndex::Trees &trees = index->tiles[id];
+    return horizontal ? trees.hTree : trees.cTree;
+}
+
 GlyphBox getMergedGlyphs(const GlyphBoxes &boxes, const CollisionAnchor &anchor) {
     GlyphBox mergedGlyphs;
     const float inf = std::numeric_limits<float>::infinity();
@@ -127,8 +213,7 @@ float Collision::getPlacementScale(const GlyphBoxes &glyphs, float minPlacementS
         const Box searchBox = getBox(anchor, bbox, minScale, maxScale);
 
         std::vector<PlacementValue> blocking;
-        hTree.query(bgi::intersects(searchBox), std::back_inserter(blocking));
-        cTree.query(bgi::intersects(searchBox), std::back_inserter(blocking));
+        query(searchBox, true, blocking);
 
         if (avoidEdges) {
             if (searchBox.min_corner().get<0>() < 0) blocking.emplace_back(leftEdge);
@@ -153,8 +238,7 @@ float Collision::getPlacementScale(const GlyphBoxes &glyphs, float minPlacementS
                     return 0;
                 }
 
-                // todo: unhardcode the 8 = tileExtent/tileSize
-                float padding = std::fmax(pad, placement.padding) * 8.0f;
+                float padding = std::fmax(pad, placement.padding) * tilePixelRatio;
 
                 // Original algorithm:
                 float s1 = (ob.tl.x - nb.br.x - padding) /
@@ -210,11 +294,7 @@ PlacementRange Collision::getPlacementRange(const GlyphBoxes &glyphs, float plac
         Box query_box{Point{minPlacedX, minPlacedY}, Point{maxPlacedX, maxPlacedY}};
 
         std::vector<PlacementValue> blocking;
-        hTree.query(bgi::intersects(query_box), std::back_inserter(blocking));
-
-        if (horizontal) {
-            cTree.query(bgi::intersects(query_box), std::back_inserter(blocking));
-        }
+        query(query_box, horizontal, blocking);
 
         for (const PlacementValue &value : blocking) {
             const Box &s = std::get<0>(value);
@@ -289,9 +369,10 @@ void Collision::insert(const GlyphBoxes &glyphs, const CollisionAnchor &anchor,
     }
 
     // Bulk-insert all glyph boxes
-    if (horizontal) {
-        hTree.insert(allBounds.begin(), allBounds.end());
+    if (index) {
+        std::lock_guard<std::mutex> lock(index->mtx);
+        getTree(horizontal).insert(allBounds.begin(), allBounds.end());
     } else {
-        cTree.insert(allBounds.begin(), allBounds.end());
+        getTree(horizontal).insert(allBounds.begin(), allBounds.end());
     }
 }
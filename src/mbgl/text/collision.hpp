@@ -2,38 +2,50 @@
 #define MBGL_TEXT_COLLISION
 
 #include <mbgl/text/types.hpp>
+#include <mbgl/text/collision_grid.hpp>
+#include <mbgl/map/tile.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/ptr.hpp>
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-parameter"
-#pragma GCC diagnostic ignored "-Wunused-variable"
-#pragma GCC diagnostic ignored "-Wshadow"
-#ifdef __clang__
-#pragma GCC diagnostic ignored "-Wdeprecated-register"
-#else
-#pragma GCC diagnostic ignored "-Wunused-local-typedefs"
-#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
-#endif
-#include <boost/geometry.hpp>
-#include <boost/geometry/geometries/point.hpp>
-#include <boost/geometry/geometries/box.hpp>
-#include <boost/geometry/index/rtree.hpp>
-#pragma GCC diagnostic pop
+#include <map>
+#include <unordered_map>
+#include <mutex>
 
 namespace mbgl {
 
-namespace bg = boost::geometry;
-namespace bgm = bg::model;
-namespace bgi = bg::index;
-typedef bgm::point<float, 2, bg::cs::cartesian> Point;
-typedef bgm::box<Point> Box;
-typedef std::pair<Box, PlacementBox> PlacementValue;
-typedef bgi::rtree<PlacementValue, bgi::linear<16,4>> Tree;
+typedef CollisionGrid Tree;
+
+// The glyph boxes placed in all parsed tiles of a source, so that tiles place their labels
+// against those of their neighbors and labels near tile edges are neither duplicated nor
+// overlapping. Every tile keeps its boxes in its own coordinates; queries translate them to the
+// coordinates of the tile that places labels. Tiles may be parsed on several threads at once.
+class CollisionIndex : private util::noncopyable {
+public:
+    // Drops the boxes of a tile, e.g. when it goes away.
+    void remove(const Tile::ID &id);
+
+private:
+    friend class Collision;
+
+    struct Trees {
+        Tree hTree;
+        Tree cTree;
+    };
+
+    std::mutex mtx;
+    std::unordered_map<Tile::ID, Trees, Tile::ID::Hash> tiles;
+};
 
 class Collision {
 
 public:
     Collision(float zoom, float tileExtent, float tileSize, float placementDepth = 1);
 
+    // Places labels against the labels of the neighbors of /id/ in /index/. The boxes that the
+    // tile placed in an earlier parse are dropped on the first query.
+    Collision(const Tile::ID &id, const util::ptr<CollisionIndex> &index, float tileExtent,
+              float tileSize, float placementDepth = 1);
+
     float getPlacementScale(const GlyphBoxes &glyphs, float minPlacementScale, bool avoidEdges);
     PlacementRange getPlacementRange(const GlyphBoxes &glyphs, float placementScale,
                                      bool horizontal);
@@ -41,8 +53,20 @@ public:
                 const PlacementRange &placementRange, bool horizontal);
 
 private:
+    // Finds the boxes that intersect /box/, including those of neighboring tiles, in our
+    // coordinates. Curved labels are only found with /curved/.
+    void query(const Box &box, bool curved, std::vector<PlacementValue> &result);
+
+    // Returns the trees of this tile. Must be called with the index locked.
+    Tree &getTree(bool horizontal);
+
     Tree hTree;
     Tree cTree;
+
+    const Tile::ID id;
+    const util::ptr<CollisionIndex> index;
+    bool cleared = false;
+
     PlacementValue leftEdge;
     PlacementValue topEdge;
     PlacementValue rightEdge;
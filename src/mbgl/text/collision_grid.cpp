@@ -0,0 +1,106 @@
+#include <mbgl/text/collision_grid.hpp>
+#include <mbgl/util/math.hpp>
+
+#include <cassert>
+#include <cmath>
+
+namespace mbgl {
+
+namespace {
+
+inline bool intersects(const Box &a, const Box &b) {
+    return a.min_corner().get<0>() <= b.max_corner().get<0>() &&
+           a.max_corner().get<0>() >= b.min_corner().get<0>() &&
+           a.min_corner().get<1>() <= b.max_corner().get<1>() &&
+           a.max_corner().get<1>() >= b.min_corner().get<1>();
+}
+
+}
+
+CollisionGrid::CollisionGrid(float extent, uint32_t cellsPerSide_, size_t cellCapacity_,
+                             size_t maxCells_)
+    : cellsPerSide(cellsPerSide_),
+      cellSize(extent / cellsPerSide_),
+      cellCapacity(cellCapacity_),
+      maxCells(maxCells_),
+      cells(cellsPerSide_ * cellsPerSide_) {
+    assert(cellsPerSide > 0);
+}
+
+CollisionGrid::Range CollisionGrid::getRange(const Box &box) const {
+    // Clamping keeps boxes outside of the extent in the border cells; since it is monotonic, a
+    // query still visits every cell that a box intersecting it was stored in.
+    const float max = cellsPerSide - 1;
+    return Range {
+        uint32_t(util::clamp(std::floor(box.min_corner().get<0>() / cellSize), 0.0f, max)),
+        uint32_t(util::clamp(std::floor(box.min_corner().get<1>() / cellSize), 0.0f, max)),
+        uint32_t(util::clamp(std::floor(box.max_corner().get<0>() / cellSize), 0.0f, max)),
+        uint32_t(util::clamp(std::floor(box.max_corner().get<1>() / cellSize), 0.0f, max)),
+    };
+}
+
+void CollisionGrid::insert(const PlacementValue &value) {
+    const uint32_t index = values.size();
+    values.push_back(value);
+
+    const Range range = getRange(value.first);
+    ranges.push_back(range);
+    bool fits = (range.x1 - range.x0 + 1) * (range.y1 - range.y0 + 1) <= maxCells;
+    for (uint32_t y = range.y0; fits && y <= range.y1; y++) {
+        for (uint32_t x = range.x0; fits && x <= range.x1; x++) {
+            fits = cells[y * cellsPerSide + x].size() < cellCapacity;
+        }
+    }
+
+    if (!fits) {
+        overflow.push_back(index);
+        return;
+    }
+
+    for (uint32_t y = range.y0; y <= range.y1; y++) {
+        for (uint32_t x = range.x0; x <= range.x1; x++) {
+            cells[y * cellsPerSide + x].push_back(index);
+        }
+    }
+}
+
+void CollisionGrid::query(const Box &box, std::vector<PlacementValue> &result) const {
+    if (values.empty()) {
+        return;
+    }
+
+    const Range range = getRange(box);
+    for (uint32_t y = range.y0; y <= range.y1; y++) {
+        for (uint32_t x = range.x0; x <= range.x1; x++) {
+            for (const uint32_t index : cells[y * cellsPerSide + x]) {
+                // A box that spans several cells is only reported in the first cell that both
+                // it and the query cover.
+                const Range &stored = ranges[index];
+                if (x != util::max(stored.x0, range.x0) || y != util::max(stored.y0, range.y0)) {
+                    continue;
+                }
+
+                const PlacementValue &value = values[index];
+                if (intersects(value.first, box)) {
+                    result.push_back(value);
+                }
+            }
+        }
+    }
+
+    for (const uint32_t index : overflow) {
+        if (intersects(values[index].first, box)) {
+            result.push_back(values[index]);
+        }
+    }
+}
+
+size_t CollisionGrid::size() const {
+    return values.size();
+}
+
+bool CollisionGrid::empty() const {
+    return values.empty();
+}
+
+}
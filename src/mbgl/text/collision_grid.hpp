@@ -0,0 +1,82 @@
+#ifndef MBGL_TEXT_COLLISION_GRID
+#define MBGL_TEXT_COLLISION_GRID
+
+#include <mbgl/text/types.hpp>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wshadow"
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wdeprecated-register"
+#else
+#pragma GCC diagnostic ignored "-Wunused-local-typedefs"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#pragma GCC diagnostic pop
+
+#include <cstdint>
+#include <vector>
+
+namespace mbgl {
+
+namespace bg = boost::geometry;
+namespace bgm = bg::model;
+typedef bgm::point<float, 2, bg::cs::cartesian> Point;
+typedef bgm::box<Point> Box;
+typedef std::pair<Box, PlacementBox> PlacementValue;
+
+// Spatial index for the glyph boxes of a tile. Labels are small boxes of similar size that are
+// spread over a bounded area, so a uniform grid answers queries faster than an R-tree and inserts
+// in constant time. Boxes outside of the extent are kept in the cells along the border.
+//
+// Every cell holds at most /cellCapacity/ boxes. Boxes that would overflow a cell, or that cover
+// more than /maxCells/ cells, go to a separate list that every query scans, so that a cluster of
+// labels at one spot doesn't degrade the whole grid.
+class CollisionGrid {
+public:
+    CollisionGrid(float extent = 4096, uint32_t cellsPerSide = 32, size_t cellCapacity = 128,
+                  size_t maxCells = 16);
+
+    void insert(const PlacementValue &value);
+
+    template <typename Iterator>
+    void insert(Iterator first, Iterator last) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    // Appends all boxes that intersect /box/, including those that only touch it, like
+    // bgi::intersects does.
+    void query(const Box &box, std::vector<PlacementValue> &result) const;
+
+    size_t size() const;
+    bool empty() const;
+
+private:
+    struct Range {
+        uint32_t x0, y0, x1, y1;
+    };
+
+    Range getRange(const Box &box) const;
+
+    const uint32_t cellsPerSide;
+    const float cellSize;
+    const size_t cellCapacity;
+    const size_t maxCells;
+
+    std::vector<PlacementValue> values;
+    std::vector<Range> ranges;
+
+    // Indices into /values/.
+    std::vector<std::vector<uint32_t>> cells;
+    std::vector<uint32_t> overflow;
+};
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include <mbgl/text/glyph_cache.hpp>
+#include <mbgl/text/glyph_store.hpp>
+#include <mbgl/util/string.hpp>
+#include <mbgl/util/url.hpp>
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mbgl {
+
+namespace {
+
+const char magic[4] = { 'M', 'B', 'G', 'C' };
+const uint32_t version = 1;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct Record {
+    uint32_t id;
+    uint32_t width;
+    uint32_t height;
+    int32_t left;
+    int32_t top;
+    uint32_t advance;
+    // Where the bitmap starts, counted from the start of the file.
+    uint32_t offset;
+    uint32_t length;
+};
+
+static_assert(sizeof(Header) == 16, "glyph cache header must be packed");
+static_assert(sizeof(Record) == 32, "glyph cache record must be packed");
+
+}
+
+GlyphCache::GlyphCache(const std::string &directory_) : directory(directory_) {
+}
+
+std::string GlyphCache::getPath(const std::string &fontStack, GlyphRange range) const {
+    return directory + "/" + util::percentEncode(fontStack) + "-" + util::toString(range.first) +
+           "-" + util::toString(range.second) + ".glyphs";
+}
+
+bool GlyphCache::load(const std::string &fontStack, GlyphRange range, FontStack &stack) const {
+    const int fd = open(getPath(fontStack, range).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+
+    const size_t size = size_t(st.st_size);
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    const char *data = reinterpret_cast<const char *>(addr);
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+
+    bool valid = std::memcmp(header.magic, magic, sizeof(magic)) == 0 &&
+                 header.version == version &&
+                 header.count <= (size - sizeof(Header)) / sizeof(Record);
+
+    // Check the whole file before adding anything to the stack.
+    std::vector<Record> records(valid ? header.count : 0);
+    for (uint32_t i = 0; valid && i < header.count; i++) {
+        Record &record = records[i];
+        std::memcpy(&record, data + sizeof(Header) + i * sizeof(Record), sizeof(Record));
+        valid = record.offset <= size && record.length <= size - record.offset;
+    }
+
+    if (valid) {
+        // The file is copied once, and the glyphs point into the copy.
+        const auto buffer = std::make_shared<const std::string>(data, size);
+        std::vector<SDFGlyphRef> glyphs(records.size());
+        for (size_t i = 0; i < records.size(); i++) {
+            const Record &record = records[i];
+            SDFGlyphRef &glyph = glyphs[i];
+            glyph.id = record.id;
+            glyph.bitmap = buffer->data() + record.offset;
+            glyph.bitmapSize = record.length;
+            glyph.metrics.width = record.width;
+            glyph.metrics.height = record.height;
+            glyph.metrics.left = record.left;
+            glyph.metrics.top = record.top;
+            glyph.metrics.advance = record.advance;
+        }
+        stack.insert(buffer, glyphs);
+    }
+
+    munmap(addr, size);
+    return valid;
+}
+
+void GlyphCache::store(const std::string &fontStack, GlyphRange range,
+                       const std::vector<SDFGlyphRef> &glyphs) const {
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.count = uint32_t(glyphs.size());
+    header.reserved = 0;
+
+    std::string data(sizeof(Header) + glyphs.size() * sizeof(Record), '\0');
+    std::memcpy(&data[0], &header, sizeof(Header));
+    for (size_t i = 0; i < glyphs.size(); i++) {
+        const SDFGlyphRef &glyph = glyphs[i];
+        Record record;
+        record.id = glyph.id;
+        record.width = glyph.metrics.width;
+        record.height = glyph.metrics.height;
+        record.left = glyph.metrics.left;
+        record.top = glyph.metrics.top;
+        record.advance = glyph.metrics.advance;
+        record.offset = uint32_t(data.size());
+        record.length = glyph.bitmapSize;
+        std::memcpy(&data[sizeof(Header) + i * sizeof(Record)], &record, sizeof(Record));
+        data.append(glyph.bitmap, glyph.bitmapSize);
+    }
+
+    // Write to a temporary file first so that a map starting at the same time never sees a
+    // partial file.
+    const std::string path = getPath(fontStack, range);
+    const std::string temporary = path + ".tmp";
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (!file) {
+        return;
+    }
+    const bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+    if (fclose(file) != 0 || !written || rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+    }
+}
+
+}
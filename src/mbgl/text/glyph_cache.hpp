@@ -0,0 +1,39 @@
+#ifndef MBGL_TEXT_GLYPH_CACHE
+#define MBGL_TEXT_GLYPH_CACHE
+
+#include <mbgl/text/glyph.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <string>
+#include <vector>
+
+namespace mbgl {
+
+class FontStack;
+struct SDFGlyphRef;
+
+// Keeps decoded glyph ranges on disk, one file per font stack and range, so that a cold start
+// doesn't need to fetch and decode the PBFs again. A file starts with a header and a table of
+// fixed-size glyph records, followed by the bitmaps; it is mapped into memory as a whole when
+// loaded. The files use the byte order of the machine that wrote them, and files that don't
+// match the format are ignored.
+class GlyphCache : private util::noncopyable {
+public:
+    GlyphCache(const std::string &directory);
+
+    // Adds the glyphs of the range to the stack. Returns false when the range isn't cached.
+    bool load(const std::string &fontStack, GlyphRange range, FontStack &stack) const;
+
+    // Writes the glyphs of a range. Failures are ignored since the cache is only an optimization.
+    void store(const std::string &fontStack, GlyphRange range,
+               const std::vector<SDFGlyphRef> &glyphs) const;
+
+private:
+    std::string getPath(const std::string &fontStack, GlyphRange range) const;
+
+    const std::string directory;
+};
+
+}
+
+#endif
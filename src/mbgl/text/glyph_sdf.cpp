@@ -0,0 +1,114 @@
+#include <mbgl/text/glyph_sdf.hpp>
+#include <mbgl/platform/glyph_rasterizer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace mbgl {
+
+namespace {
+
+const uint32_t border = 3;
+const double radius = 8;
+const double cutoff = 0.25;
+const double inf = 1e20;
+
+// 1D squared distance transform of Felzenszwalb and Huttenlocher, applied in place to /n/ values
+// that are /stride/ apart.
+void edt1d(double *grid, uint32_t offset, uint32_t stride, uint32_t n,
+           std::vector<double> &f, std::vector<double> &z, std::vector<uint32_t> &v) {
+    for (uint32_t q = 0; q < n; q++) {
+        f[q] = grid[offset + q * stride];
+    }
+
+    v[0] = 0;
+    z[0] = -inf;
+    z[1] = inf;
+    for (uint32_t q = 1, k = 0; q < n; q++) {
+        double s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = inf;
+    }
+
+    for (uint32_t q = 0, k = 0; q < n; q++) {
+        while (z[k + 1] < q) {
+            k++;
+        }
+        const double d = double(q) - v[k];
+        grid[offset + q * stride] = d * d + f[v[k]];
+    }
+}
+
+void edt(std::vector<double> &grid, uint32_t width, uint32_t height) {
+    const uint32_t n = std::max(width, height);
+    std::vector<double> f(n), z(n + 1);
+    std::vector<uint32_t> v(n);
+    for (uint32_t x = 0; x < width; x++) {
+        edt1d(grid.data(), x, width, height, f, z, v);
+    }
+    for (uint32_t y = 0; y < height; y++) {
+        edt1d(grid.data(), y * width, 1, width, f, z, v);
+    }
+}
+
+}
+
+SDFGlyph makeSDFGlyph(uint32_t id, const GlyphBitmap &bitmap) {
+    SDFGlyph glyph;
+    glyph.id = id;
+    glyph.metrics.width = bitmap.width;
+    glyph.metrics.height = bitmap.height;
+    glyph.metrics.left = bitmap.left;
+    glyph.metrics.top = bitmap.top;
+    glyph.metrics.advance = bitmap.advance;
+
+    if (!bitmap.width || !bitmap.height || bitmap.coverage.size() < bitmap.width * bitmap.height) {
+        // Like spaces in glyph PBFs, which have metrics but no bitmap.
+        glyph.metrics.width = 0;
+        glyph.metrics.height = 0;
+        return glyph;
+    }
+
+    const uint32_t width = bitmap.width + 2 * border;
+    const uint32_t height = bitmap.height + 2 * border;
+
+    // Squared distances to the nearest pixel outside and inside of the glyph. Partially covered
+    // pixels start out at their distance from the outline, assuming it crosses them straight.
+    std::vector<double> outer(width * height, inf);
+    std::vector<double> inner(width * height, 0);
+    for (uint32_t y = 0; y < bitmap.height; y++) {
+        for (uint32_t x = 0; x < bitmap.width; x++) {
+            const double a = uint8_t(bitmap.coverage[y * bitmap.width + x]) / 255.0;
+            const uint32_t i = (y + border) * width + x + border;
+            if (a >= 1) {
+                outer[i] = 0;
+                inner[i] = inf;
+            } else if (a > 0) {
+                outer[i] = std::pow(std::max(0.0, 0.5 - a), 2);
+                inner[i] = std::pow(std::max(0.0, a - 0.5), 2);
+            }
+        }
+    }
+
+    edt(outer, width, height);
+    edt(inner, width, height);
+
+    glyph.bitmap.resize(width * height);
+    for (uint32_t i = 0; i < width * height; i++) {
+        const double d = std::sqrt(outer[i]) - std::sqrt(inner[i]);
+        const double value = std::round(255 - 255 * (d / radius + cutoff));
+        glyph.bitmap[i] = char(uint8_t(std::max(0.0, std::min(255.0, value))));
+    }
+
+    return glyph;
+}
+
+}
@@ -0,0 +1,16 @@
+#ifndef MBGL_TEXT_GLYPH_SDF
+#define MBGL_TEXT_GLYPH_SDF
+
+#include <mbgl/text/glyph_store.hpp>
+
+namespace mbgl {
+
+struct GlyphBitmap;
+
+// Turns the coverage bitmap of a glyph into a signed distance field in the format of glyph PBFs: a
+// border of 3 pixels, distances of up to 8 pixels, and 192 on the outline of the glyph.
+SDFGlyph makeSDFGlyph(uint32_t id, const GlyphBitmap &bitmap);
+
+}
+
+#endif
@@ -1,4 +1,6 @@
 #include <mbgl/text/glyph_store.hpp>
+#include <mbgl/text/glyph_cache.hpp>
+#include <mbgl/text/glyph_sdf.hpp>
 
 #include <mbgl/util/std.hpp>
 #include <mbgl/util/string.hpp>
@@ -10,35 +12,114 @@
 #include <mbgl/util/math.hpp>
 #include <mbgl/storage/file_source.hpp>
 #include <mbgl/platform/platform.hpp>
+#include <mbgl/platform/glyph_rasterizer.hpp>
+#include <mbgl/platform/log.hpp>
 #include <mbgl/util/uv_detail.hpp>
 #include <algorithm>
 
 namespace mbgl {
 
 
-void FontStack::insert(uint32_t id, const SDFGlyph &glyph) {
-    std::lock_guard<std::mutex> lock(mtx);
-    metrics.emplace(id, glyph.metrics);
-    bitmaps.emplace(id, glyph.bitmap);
-    sdfs.emplace(id, glyph);
+FontStack::FontStack() {
+    for (std::atomic<const Block *> &block : blocks) {
+        block.store(nullptr, std::memory_order_relaxed);
+    }
 }
 
-const std::map<uint32_t, GlyphMetrics> &FontStack::getMetrics() const {
+void FontStack::insert(const std::shared_ptr<const std::string> &buffer, const std::vector<SDFGlyphRef> &glyphs) {
     std::lock_guard<std::mutex> lock(mtx);
-    return metrics;
+
+    // Ranges usually map to a single block, but we don't rely on the PBF to contain only the
+    // glyphs of the range that it was requested for.
+    std::map<uint32_t, std::unique_ptr<Block>> changed;
+    for (const SDFGlyphRef &glyph : glyphs) {
+        const uint32_t index = glyph.id >> 8;
+        if (index >= blocks.size()) {
+            continue;
+        }
+
+        std::unique_ptr<Block> &block = changed[index];
+        if (!block) {
+            const Block *current = blocks[index].load(std::memory_order_relaxed);
+            block = current ? util::make_unique<Block>(*current) : util::make_unique<Block>();
+            block->buffers.push_back(buffer);
+        }
+
+        const auto it = std::lower_bound(block->glyphs.begin(), block->glyphs.end(), glyph.id,
+                                         [](const SDFGlyphRef &a, uint32_t id) { return a.id < id; });
+        if (it != block->glyphs.end() && it->id == glyph.id) {
+            *it = glyph;
+        } else {
+            block->glyphs.insert(it, glyph);
+        }
+    }
+
+    for (auto &pair : changed) {
+        // Buffers that no glyph of the block points into anymore are dropped along with the
+        // block that was replaced.
+        Block &block = *pair.second;
+        block.buffers.erase(std::remove_if(block.buffers.begin(), block.buffers.end(), [&](const std::shared_ptr<const std::string> &candidate) {
+            const char *begin = candidate->data();
+            const char *end = begin + candidate->size();
+            return candidate != buffer && std::none_of(block.glyphs.begin(), block.glyphs.end(), [&](const SDFGlyphRef &glyph) {
+                return glyph.bitmap >= begin && glyph.bitmap < end;
+            });
+        }), block.buffers.end());
+
+        blocks[pair.first].store(pair.second.get(), std::memory_order_release);
+        owned.emplace_back(std::move(pair.second));
+    }
 }
 
-const std::map<uint32_t, SDFGlyph> &FontStack::getSDFs() const {
-    std::lock_guard<std::mutex> lock(mtx);
-    return sdfs;
+void FontStack::insert(const std::vector<SDFGlyph> &glyphs) {
+    size_t size = 0;
+    for (const SDFGlyph &glyph : glyphs) {
+        size += glyph.bitmap.size();
+    }
+    auto buffer = std::make_shared<std::string>();
+    buffer->reserve(size);
+
+    std::vector<SDFGlyphRef> refs(glyphs.size());
+    for (size_t i = 0; i < glyphs.size(); i++) {
+        refs[i].id = glyphs[i].id;
+        refs[i].bitmapSize = uint32_t(glyphs[i].bitmap.size());
+        refs[i].metrics = glyphs[i].metrics;
+        buffer->append(glyphs[i].bitmap);
+    }
+
+    // The buffer doesn't change anymore, so the pointers stay valid.
+    size_t offset = 0;
+    for (SDFGlyphRef &ref : refs) {
+        ref.bitmap = buffer->data() + offset;
+        offset += ref.bitmapSize;
+    }
+
+    insert(buffer, refs);
+}
+
+const SDFGlyphRef *FontStack::getSDF(uint32_t id) const {
+    const uint32_t index = id >> 8;
+    if (index >= blocks.size()) {
+        return nullptr;
+    }
+    const Block *block = blocks[index].load(std::memory_order_acquire);
+    if (!block) {
+        return nullptr;
+    }
+    const auto it = std::lower_bound(block->glyphs.begin(), block->glyphs.end(), id,
+                                     [](const SDFGlyphRef &a, uint32_t value) { return a.id < value; });
+    return it != block->glyphs.end() && it->id == id ? &*it : nullptr;
+}
+
+const GlyphMetrics *FontStack::getMetrics(uint32_t id) const {
+    const SDFGlyphRef *glyph = getSDF(id);
+    return glyph ? &glyph->metrics : nullptr;
 }
 
 const Shaping FontStack::getShaping(const std::u32string &string, const float maxWidth,
                                     const float lineHeight, const float horizontalAlign,
                                     const float verticalAlign, const float justify,
                                     const float spacing, const vec2<float> &translate) const {
-    std::lock_guard<std::mutex> lock(mtx);
-
     Shaping shaping;
 
     int32_t x = std::round(translate.x * 24); // one em
@@ -47,9 +128,9 @@ const Shaping FontStack::getShaping(const std::u32string &string, const float ma
     // Loop through all characters of this label and shape.
     for (uint32_t chr : string) {
         shaping.emplace_back(chr, x, y);
-        auto metric = metrics.find(chr);
-        if (metric != metrics.end()) {
-            x += metric->second.advance + spacing;
+        const GlyphMetrics *metric = getMetrics(chr);
+        if (metric) {
+            x += metric->advance + spacing;
         }
     }
 
@@ -73,12 +154,11 @@ void align(Shaping &shaping, const float justify, const float horizontalAlign,
     }
 }
 
-void justifyLine(Shaping &shaping, const std::map<uint32_t, GlyphMetrics> &metrics, uint32_t start,
-                 uint32_t end, float justify) {
+void FontStack::justifyLine(Shaping &shaping, uint32_t start, uint32_t end, float justify) const {
     PositionedGlyph &glyph = shaping[end];
-    auto metric = metrics.find(glyph.glyph);
-    if (metric != metrics.end()) {
-        const uint32_t lastAdvance = metric->second.advance;
+    const GlyphMetrics *metric = getMetrics(glyph.glyph);
+    if (metric) {
+        const uint32_t lastAdvance = metric->advance;
         const float lineIndent = float(glyph.x + lastAdvance) * justify;
 
         for (uint32_t j = start; j <= end; j++) {
@@ -116,7 +196,7 @@ void FontStack::lineWrap(Shaping &shaping, const float lineHeight, const float m
                 }
 
                 if (justify) {
-                    justifyLine(shaping, metrics, lineStartIndex, lastSafeBreak - 1, justify);
+                    justifyLine(shaping, lineStartIndex, lastSafeBreak - 1, justify);
                 }
 
                 lineStartIndex = lastSafeBreak + 1;
@@ -133,12 +213,41 @@ void FontStack::lineWrap(Shaping &shaping, const float lineHeight, const float m
 
     if (!maxLineLength) maxLineLength = shaping.back().x;
 
-    justifyLine(shaping, metrics, lineStartIndex, uint32_t(shaping.size()) - 1, justify);
+    justifyLine(shaping, lineStartIndex, uint32_t(shaping.size()) - 1, justify);
     align(shaping, justify, horizontalAlign, verticalAlign, maxLineLength, lineHeight, line);
 }
 
-GlyphPBF::GlyphPBF(const std::string &glyphURL, const std::string &fontStack, GlyphRange glyphRange, FileSource& fileSource)
-    : future(promise.get_future().share())
+LocalGlyphRasterizer::LocalGlyphRasterizer(std::unique_ptr<GlyphRasterizer> rasterizer_,
+                                           const std::vector<std::pair<char32_t, char32_t>> &codePoints_)
+    : rasterizer(std::move(rasterizer_)),
+      codePoints(codePoints_) {}
+
+LocalGlyphRasterizer::~LocalGlyphRasterizer() {}
+
+bool LocalGlyphRasterizer::covers(GlyphRange range) const {
+    return std::find_if(codePoints.begin(), codePoints.end(), [&](const std::pair<char32_t, char32_t> &codes) {
+        return codes.first <= range.first && range.second <= codes.second;
+    }) != codePoints.end();
+}
+
+std::vector<SDFGlyph> LocalGlyphRasterizer::rasterize(const std::string &fontStack, GlyphRange range) {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    std::vector<SDFGlyph> glyphs;
+    GlyphBitmap bitmap;
+    for (uint32_t id = range.first; id <= range.second; id++) {
+        if (rasterizer->rasterize(fontStack, id, bitmap)) {
+            glyphs.push_back(makeSDFGlyph(id, bitmap));
+        }
+    }
+    return glyphs;
+}
+
+GlyphPBF::GlyphPBF(const std::string &glyphURL, const std::string &fontStack_, GlyphRange glyphRange_, FileSource& fileSource,
+                   const util::ptr<GlyphCache> &cache_, std::function<void()> onload)
+    : fontStack(fontStack_),
+      glyphRange(glyphRange_),
+      cache(cache_)
 {
     // Load the glyph set URL
     std::string url = util::replaceTokens(glyphURL, [&](const std::string &name) -> std::string {
@@ -148,43 +257,69 @@ GlyphPBF::GlyphPBF(const std::string &glyphURL, const std::string &fontStack, Gl
     });
 
     // The prepare call jumps back to the main thread.
-    fileSource.prepare([&, url] {
+    fileSource.prepare([&, url, onload] {
         auto request = fileSource.request(ResourceType::Glyphs, url);
-        request->onload([&, url](const Response &res) {
+        request->onload([&, url, onload](const Response &res) {
             if (res.code != 200) {
-                // Something went wrong with loading the glyph pbf. Pass on the error to the future listeners.
-                const std::string msg = std::string { "[ERROR] failed to load glyphs (" } + util::toString(res.code) + "): " + res.message;
-                promise.set_exception(std::make_exception_ptr(std::runtime_error(msg)));
+                // Something went wrong with loading the glyph pbf. Labels are placed without the
+                // glyphs of this range.
+                Log::Warning(Event::HttpRequest, "failed to load glyphs (%ld): %s", res.code, res.message.c_str());
             } else {
                 // Transfer the data to the GlyphSet and signal its availability.
                 // Once it is available, the caller will need to call parse() to actually
                 // parse the data we received. We are not doing this here since this callback is being
                 // called from another (unknown) thread.
+                std::lock_guard<std::mutex> lock(mtx);
                 data = res.data;
-                promise.set_value(*this);
             }
+            done = true;
+            onload();
         });
-        request->oncancel([&]() {
-            promise.set_exception(std::make_exception_ptr(std::runtime_error("Loading glyphs was canceled")));
+        request->oncancel([&, onload]() {
+            done = true;
+            onload();
         });
     });
 }
 
-std::shared_future<GlyphPBF &> GlyphPBF::getFuture() {
-    return future;
+GlyphPBF::GlyphPBF(const std::string &fontStack_, GlyphRange glyphRange_,
+                   const util::ptr<LocalGlyphRasterizer> &rasterizer_)
+    : fontStack(fontStack_),
+      glyphRange(glyphRange_),
+      rasterizer(rasterizer_),
+      done(true) {}
+
+GlyphPBF::GlyphPBF(const std::string &fontStack_, GlyphRange glyphRange_,
+                   const std::shared_ptr<const std::string> &data_)
+    : fontStack(fontStack_),
+      glyphRange(glyphRange_),
+      data(data_),
+      done(true) {}
+
+bool GlyphPBF::isDone() const {
+    return done;
 }
 
 void GlyphPBF::parse(FontStack &stack) {
     std::lock_guard<std::mutex> lock(mtx);
 
-    if (!data.size()) {
+    if (rasterizer) {
+        // Locally drawn glyphs aren't cached, so that they never stand in for the glyphs of the
+        // glyph URL when the rasterizer is removed.
+        stack.insert(rasterizer->rasterize(fontStack, glyphRange));
+        rasterizer.reset();
+        return;
+    }
+
+    if (!data || data->empty()) {
         // If there is no data, this means we either haven't received any data, or
         // we have already parsed the data.
         return;
     }
 
-    // Parse the glyph PBF
-    pbf glyphs_pbf(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+    // Parse the glyph PBF. The bitmaps stay in the response, which the font stack keeps.
+    pbf glyphs_pbf(reinterpret_cast<const uint8_t *>(data->data()), data->size());
+    std::vector<SDFGlyphRef> glyphs;
 
     while (glyphs_pbf.next()) {
         if (glyphs_pbf.tag == 1) { // stacks
@@ -193,13 +328,15 @@ void GlyphPBF::parse(FontStack &stack) {
                 if (fontstack_pbf.tag == 3) { // glyphs
                     pbf glyph_pbf = fontstack_pbf.message();
 
-                    SDFGlyph glyph;
+                    SDFGlyphRef glyph;
 
                     while (glyph_pbf.next()) {
                         if (glyph_pbf.tag == 1) { // id
                             glyph.id = glyph_pbf.varint();
                         } else if (glyph_pbf.tag == 2) { // bitmap
-                            glyph.bitmap = glyph_pbf.string();
+                            const pbf bitmap = glyph_pbf.message();
+                            glyph.bitmap = reinterpret_cast<const char *>(bitmap.data);
+                            glyph.bitmapSize = uint32_t(bitmap.end - bitmap.data);
                         } else if (glyph_pbf.tag == 3) { // width
                             glyph.metrics.width = glyph_pbf.varint();
                         } else if (glyph_pbf.tag == 4) { // height
@@ -215,7 +352,7 @@ void GlyphPBF::parse(FontStack &stack) {
                         }
                     }
 
-                    stack.insert(glyph.id, glyph);
+                    glyphs.push_back(glyph);
                 } else {
                     fontstack_pbf.skip();
                 }
@@ -225,7 +362,12 @@ void GlyphPBF::parse(FontStack &stack) {
         }
     }
 
-    data.clear();
+    stack.insert(data, glyphs);
+    if (cache) {
+        cache->store(fontStack, glyphRange, glyphs);
+    }
+
+    data.reset();
 }
 
 GlyphStore::GlyphStore(FileSource& fileSource_) : fileSource(fileSource_) {}
@@ -234,18 +376,45 @@ void GlyphStore::setURL(const std::string &url) {
     glyphURL = url;
 }
 
+void GlyphStore::addGlyphRange(const std::string &fontStack, GlyphRange range,
+                               const std::shared_ptr<const std::string> &data) {
+    std::lock_guard<std::mutex> lock(mtx);
+    ranges[fontStack].emplace(range, util::make_unique<GlyphPBF>(fontStack, range, data));
+}
+
+void GlyphStore::setCacheDirectory(const std::string &directory) {
+    std::lock_guard<std::mutex> lock(mtx);
+    cache = std::make_shared<GlyphCache>(directory);
+}
 
-void GlyphStore::waitForGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges) {
-    // We are implementing a blocking wait with futures: Every GlyphSet has a future that we are
-    // waiting for until it is loaded.
+
+void GlyphStore::setLocalGlyphRasterizer(std::unique_ptr<GlyphRasterizer> rasterizer,
+                                         const std::vector<std::pair<char32_t, char32_t>> &codePoints) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (rasterizer) {
+        localRasterizer = std::make_shared<LocalGlyphRasterizer>(std::move(rasterizer), codePoints);
+    } else {
+        localRasterizer.reset();
+    }
+}
+
+void GlyphStore::setObserver(std::function<void()> observer_) {
+    observer = observer_;
+}
+
+uint64_t GlyphStore::getGeneration() const {
+    return generation;
+}
+
+bool GlyphStore::requestGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges) {
     if (glyphRanges.empty()) {
-        return;
+        return true;
     }
 
     FontStack *stack = nullptr;
 
-    std::vector<std::shared_future<GlyphPBF &>> futures;
-    futures.reserve(glyphRanges.size());
+    std::vector<GlyphPBF *> pbfs;
+    pbfs.reserve(glyphRanges.size());
     {
         std::lock_guard<std::mutex> lock(mtx);
         auto &rangeSets = ranges[fontStack];
@@ -253,28 +422,47 @@ void GlyphStore::waitForGlyphRanges(const std::string &fontStack, const std::set
         stack = &createFontStack(fontStack);
 
         // Attempt to load the glyph range. If the GlyphSet already exists, we are getting back
-        // the same shared_future.
+        // the same GlyphPBF.
         for (GlyphRange range : glyphRanges) {
-            futures.emplace_back(loadGlyphRange(fontStack, rangeSets, range));
+            GlyphPBF *pbf = loadGlyphRange(fontStack, rangeSets, range, *stack);
+            if (pbf) {
+                pbfs.push_back(pbf);
+            }
         }
     }
 
-    // Now that we potentially created all GlyphSets, we are waiting for the results, one by one.
-    // When we get a result (or the GlyphSet is aready loaded), we are attempting to parse the
-    // GlyphSet.
-    for (std::shared_future<GlyphPBF &> &future : futures) {
-        future.get().parse(*stack);
+    // Parse the GlyphSets that arrived; parsing one that was parsed before doesn't do anything.
+    // GlyphPBFs are never removed, so we don't need the lock for this.
+    bool complete = true;
+    for (GlyphPBF *pbf : pbfs) {
+        if (pbf->isDone()) {
+            pbf->parse(*stack);
+        } else {
+            complete = false;
+        }
     }
+    return complete;
 }
 
-std::shared_future<GlyphPBF &> GlyphStore::loadGlyphRange(const std::string &fontStack, std::map<GlyphRange, std::unique_ptr<GlyphPBF>> &rangeSets, const GlyphRange range) {
+GlyphPBF *GlyphStore::loadGlyphRange(const std::string &fontStack, std::map<GlyphRange, std::unique_ptr<GlyphPBF>> &rangeSets, const GlyphRange range, FontStack &stack) {
     auto range_it = rangeSets.find(range);
     if (range_it == rangeSets.end()) {
         // We don't have this glyph set yet for this font stack.
-        range_it = rangeSets.emplace(range, util::make_unique<GlyphPBF>(glyphURL, fontStack, range, fileSource)).first;
+        if (localRasterizer && localRasterizer->covers(range)) {
+            range_it = rangeSets.emplace(range, util::make_unique<GlyphPBF>(fontStack, range, localRasterizer)).first;
+        } else if (cache && cache->load(fontStack, range, stack)) {
+            range_it = rangeSets.emplace(range, nullptr).first;
+        } else {
+            range_it = rangeSets.emplace(range, util::make_unique<GlyphPBF>(glyphURL, fontStack, range, fileSource, cache, [this] {
+                generation++;
+                if (observer) {
+                    observer();
+                }
+            })).first;
+        }
     }
 
-    return range_it->second->getFuture();
+    return range_it->second.get();
 }
 
 FontStack &GlyphStore::createFontStack(const std::string &fontStack) {
@@ -290,5 +478,22 @@ FontStack &GlyphStore::getFontStack(const std::string &fontStack) {
     return createFontStack(fontStack);
 }
 
+util::ptr<const Shaping> GlyphStore::getShaping(const std::string &fontStack,
+                                                const std::u32string &string, float maxWidth,
+                                                float lineHeight, float horizontalAlign,
+                                                float verticalAlign, float justify, float spacing,
+                                                const vec2<float> &translate) {
+    const ShapingCache::Key key { string, fontStack, maxWidth, lineHeight, horizontalAlign,
+                                  verticalAlign, justify, spacing, translate };
+    util::ptr<const Shaping> shaping = shapingCache.get(key);
+    if (!shaping) {
+        shaping = std::make_shared<const Shaping>(getFontStack(fontStack).getShaping(
+            string, maxWidth, lineHeight, horizontalAlign, verticalAlign, justify, spacing,
+            translate));
+        shapingCache.add(key, shaping);
+    }
+    return shaping;
+}
+
 
 }
@@ -2,20 +2,28 @@
 #define MBGL_TEXT_GLYPH_STORE
 
 #include <mbgl/text/glyph.hpp>
+#include <mbgl/text/shaping_cache.hpp>
 #include <mbgl/util/pbf.hpp>
 #include <mbgl/util/vec.hpp>
 #include <mbgl/util/ptr.hpp>
+#include <mbgl/util/noncopyable.hpp>
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <vector>
-#include <future>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <unordered_map>
 
 namespace mbgl {
 
 class FileSource;
+class GlyphCache;
+class GlyphRasterizer;
 
 class SDFGlyph {
 public:
@@ -28,11 +36,36 @@ public:
     GlyphMetrics metrics;
 };
 
-class FontStack {
+// A glyph as FontStack keeps it. The bitmap isn't owned by the glyph: it points into the buffer
+// of the range that the glyph came with, e.g. the response of the glyph PBF.
+struct SDFGlyphRef {
+    uint32_t id = 0;
+
+    // A signed distance field of the glyph with a border of 3 pixels.
+    const char *bitmap = nullptr;
+    uint32_t bitmapSize = 0;
+
+    GlyphMetrics metrics;
+};
+
+// The glyphs of a font stack. Glyphs are added one glyph range at a time, and a range is never
+// changed once it was published, so lookups don't need a lock and may run on any number of
+// threads while another thread adds ranges.
+class FontStack : private util::noncopyable {
 public:
-    void insert(uint32_t id, const SDFGlyph &glyph);
-    const std::map<uint32_t, GlyphMetrics> &getMetrics() const;
-    const std::map<uint32_t, SDFGlyph> &getSDFs() const;
+    FontStack();
+
+    // Publishes the glyphs of a range, whose bitmaps must lie within /buffer/. The font stack
+    // keeps the buffer instead of copying the bitmaps. Glyphs outside of the BMP are ignored.
+    void insert(const std::shared_ptr<const std::string> &buffer, const std::vector<SDFGlyphRef> &glyphs);
+    // Copies the bitmaps of all glyphs into a single buffer.
+    void insert(const std::vector<SDFGlyph> &glyphs);
+
+    // Returns nullptr when the glyph isn't loaded (yet). The glyph stays valid as long as the
+    // font stack exists.
+    const SDFGlyphRef *getSDF(uint32_t id) const;
+    const GlyphMetrics *getMetrics(uint32_t id) const;
+
     const Shaping getShaping(const std::u32string &string, float maxWidth, float lineHeight,
                              float horizontalAlign, float verticalAlign, float justify,
                              float spacing, const vec2<float> &translate) const;
@@ -40,15 +73,56 @@ public:
                   float verticalAlign, float justify) const;
 
 private:
-    std::map<uint32_t, std::string> bitmaps;
-    std::map<uint32_t, GlyphMetrics> metrics;
-    std::map<uint32_t, SDFGlyph> sdfs;
-    mutable std::mutex mtx;
+    void justifyLine(Shaping &shaping, uint32_t start, uint32_t end, float justify) const;
+
+    // The glyphs of one range of 256 code points, sorted by code point, and the buffers that
+    // their bitmaps lie in; usually one.
+    struct Block {
+        std::vector<SDFGlyphRef> glyphs;
+        std::vector<std::shared_ptr<const std::string>> buffers;
+    };
+
+    std::array<std::atomic<const Block *>, 256> blocks;
+
+    // Owns all blocks, including those that were replaced when a range was inserted twice;
+    // readers may still look at those.
+    std::vector<std::unique_ptr<const Block>> owned;
+    std::mutex mtx;
+};
+
+// Draws glyphs locally, one thread at a time.
+class LocalGlyphRasterizer : private util::noncopyable {
+public:
+    LocalGlyphRasterizer(std::unique_ptr<GlyphRasterizer> rasterizer,
+                         const std::vector<std::pair<char32_t, char32_t>> &codePoints);
+    ~LocalGlyphRasterizer();
+
+    // Whether all code points of the range are drawn locally.
+    bool covers(GlyphRange range) const;
+
+    // Returns the glyphs of the range that a font of the device has.
+    std::vector<SDFGlyph> rasterize(const std::string &fontStack, GlyphRange range);
+
+private:
+    const std::unique_ptr<GlyphRasterizer> rasterizer;
+    const std::vector<std::pair<char32_t, char32_t>> codePoints;
+    std::mutex mtx;
 };
 
 class GlyphPBF {
 public:
-    GlyphPBF(const std::string &glyphURL, const std::string &fontStack, GlyphRange glyphRange, FileSource& fileSource);
+    // Calls /onload/ on the map thread once the request finished, successfully or not.
+    GlyphPBF(const std::string &glyphURL, const std::string &fontStack, GlyphRange glyphRange, FileSource& fileSource,
+             const util::ptr<GlyphCache> &cache, std::function<void()> onload);
+
+    // A range that is drawn locally. It doesn't request anything, and draws its glyphs on the
+    // first parse.
+    GlyphPBF(const std::string &fontStack, GlyphRange glyphRange,
+             const util::ptr<LocalGlyphRasterizer> &rasterizer);
+
+    // A range whose glyph PBF is at hand already. It is parsed on the first parse.
+    GlyphPBF(const std::string &fontStack, GlyphRange glyphRange,
+             const std::shared_ptr<const std::string> &data);
 
 private:
     GlyphPBF(const GlyphPBF &) = delete;
@@ -57,14 +131,19 @@ private:
     GlyphPBF &operator=(GlyphPBF &&) = delete;
 
 public:
-    void parse(FontStack &stack);
+    // Whether the request finished. Ranges that failed to load are done, but never add glyphs.
+    bool isDone() const;
 
-    std::shared_future<GlyphPBF &> getFuture();
+    void parse(FontStack &stack);
 
 private:
-    std::string data;
-    std::promise<GlyphPBF &> promise;
-    std::shared_future<GlyphPBF &> future;
+    const std::string fontStack;
+    const GlyphRange glyphRange;
+    const util::ptr<GlyphCache> cache;
+    util::ptr<LocalGlyphRasterizer> rasterizer;
+
+    std::shared_ptr<const std::string> data;
+    std::atomic<bool> done { false };
     std::mutex mtx;
 };
 
@@ -73,21 +152,56 @@ class GlyphStore {
 public:
     GlyphStore(FileSource& fileSource);
 
-    // Block until all specified GlyphRanges of the specified font stack are loaded.
-    void waitForGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges);
+    // Starts loading the specified GlyphRanges of the font stack that aren't loaded yet. Returns
+    // whether all of them are available; never waits for the ones that aren't.
+    bool requestGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges);
+
+    // Changes whenever a requested glyph range arrived or failed to load, so that callers that
+    // found ranges missing know when to ask again.
+    uint64_t getGeneration() const;
+
+    // Called on the map thread whenever the generation changes.
+    void setObserver(std::function<void()> observer);
 
     FontStack &getFontStack(const std::string &fontStack);
 
+    // Shapes a label with the font stack, or returns the shaping of an earlier call with the same
+    // arguments. The glyph ranges of the label must have been loaded.
+    util::ptr<const Shaping> getShaping(const std::string &fontStack, const std::u32string &string,
+                                        float maxWidth, float lineHeight, float horizontalAlign,
+                                        float verticalAlign, float justify, float spacing,
+                                        const vec2<float> &translate);
+
     void setURL(const std::string &url);
 
+    // Adds a glyph range from glyph PBF data that the caller loaded, instead of loading it from
+    // the glyph URL. Ranges that were requested before are left as they are.
+    void addGlyphRange(const std::string &fontStack, GlyphRange range,
+                       const std::shared_ptr<const std::string> &data);
+
+    // Keeps decoded glyph ranges in this directory, which must exist. Ranges that are loaded
+    // afterwards are read from there if they were decoded before.
+    void setCacheDirectory(const std::string &directory);
+
+    // Draws the glyphs of glyph ranges that lie within /codePoints/ with the rasterizer, instead of
+    // loading them from the glyph URL. Only affects glyph ranges that weren't loaded yet.
+    void setLocalGlyphRasterizer(std::unique_ptr<GlyphRasterizer> rasterizer,
+                                 const std::vector<std::pair<char32_t, char32_t>> &codePoints);
+
 private:
-    // Loads an individual glyph range from the font stack and adds it to rangeSets
-    std::shared_future<GlyphPBF &> loadGlyphRange(const std::string &fontStack, std::map<GlyphRange, std::unique_ptr<GlyphPBF>> &rangeSets, GlyphRange range);
+    // Loads an individual glyph range from the font stack and adds it to rangeSets. Ranges that
+    // were read from the cache are stored without a GlyphPBF.
+    GlyphPBF *loadGlyphRange(const std::string &fontStack, std::map<GlyphRange, std::unique_ptr<GlyphPBF>> &rangeSets, GlyphRange range, FontStack &stack);
 
     FontStack &createFontStack(const std::string &fontStack);
 
     std::string glyphURL;
     FileSource& fileSource;
+    util::ptr<GlyphCache> cache;
+    util::ptr<LocalGlyphRasterizer> localRasterizer;
+    ShapingCache shapingCache;
+    std::atomic<uint64_t> generation { 1 };
+    std::function<void()> observer;
     std::unordered_map<std::string, std::map<GlyphRange, std::unique_ptr<GlyphPBF>>> ranges;
     std::unordered_map<std::string, std::unique_ptr<FontStack>> stacks;
     std::mutex mtx;
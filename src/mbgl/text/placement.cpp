@@ -6,6 +6,7 @@
 #include <mbgl/style/style_bucket.hpp>
 
 #include <mbgl/util/math.hpp>
+#include <mbgl/util/std.hpp>
 
 namespace mbgl {
 
@@ -26,73 +27,154 @@ struct GlyphInstance {
 
 typedef std::vector<GlyphInstance> GlyphInstances;
 
-void getSegmentGlyphs(std::back_insert_iterator<GlyphInstances> glyphs, Anchor &anchor,
-                      float offset, const std::vector<Coordinate> &line, int segment,
-                      int8_t direction, float maxAngle) {
+// The walk from an anchor along a line in one direction. Segments are unrolled onto a straight
+// line, so that a glyph at offset x sits on the step whose distance from the anchor reaches x.
+// None of this depends on the glyph, so all glyphs of a label share the steps, which are computed
+// lazily as far as the glyphs reach, and only need a division per step.
+class SegmentPath {
+public:
+    SegmentPath(const Anchor &anchor, const std::vector<Coordinate> &line_, int8_t direction_,
+                bool upsideDown_, float maxAngle_)
+        : line(line_),
+          direction(direction_),
+          upsideDown(upsideDown_),
+          maxAngle(maxAngle_),
+          segment(anchor.segment + (direction_ > 0 ? 1 : 0)) {
+        if ((int)line.size() <= segment) {
+            complete = true;
+            empty = true;
+            return;
+        }
+        end = line[segment];
+        push(anchor);
+    }
+
+    // Makes sure that step i exists. Returns false when the line ends before it.
+    bool reach(size_t i) {
+        while (i >= dists.size() && !complete) {
+            extend();
+        }
+        return i < dists.size();
+    }
+
+    bool isEmpty() const { return empty; }
+
+    std::vector<vec2<float>> anchors;
+    std::vector<float> dists;
+    std::vector<float> angles;
+    // Whether the angle to the previous step is too sharp to place glyphs around the corner.
+    std::vector<bool> sharp;
+
+private:
+    void push(const vec2<float> &from) {
+        const float dist = util::dist<float>(from, end);
+        float angle = -std::atan2(end.x - from.x, end.y - from.y) + direction * M_PI / 2.0f;
+        if (upsideDown)
+            angle += M_PI;
+
+        const bool first = angles.empty();
+        const float prevAngle = first ? 0.0f : rawAngles.back();
+        const float angleDiff = std::fmod((angle - prevAngle), (2.0f * M_PI));
+
+        anchors.push_back(from);
+        dists.push_back(dist);
+        rawAngles.push_back(angle);
+        angles.push_back(static_cast<float>(std::fmod((angle + 2.0 * M_PI), (2.0 * M_PI))));
+        sharp.push_back(!first && prevAngle && std::fabs(angleDiff) > maxAngle);
+    }
+
+    void extend() {
+        vec2<float> from = end;
+
+        // skip duplicate nodes
+        while (from == end) {
+            segment += direction;
+            if ((int)line.size() <= segment || segment < 0) {
+                complete = true;
+                return;
+            }
+            end = line[segment];
+        }
+
+        vec2<float> normal = util::normal<float>(from, end) * dists.back();
+        push(from - normal);
+    }
+
+    const std::vector<Coordinate> &line;
+    const int8_t direction;
+    const bool upsideDown;
+    const float maxAngle;
+    int segment;
+    vec2<float> end;
+    std::vector<float> rawAngles;
+    bool complete = false;
+    bool empty = false;
+};
+
+// Lazily creates the paths of an anchor for both walking directions, upright and upside down.
+class SegmentPaths {
+public:
+    SegmentPaths(const Anchor &anchor_, const std::vector<Coordinate> &line_, float maxAngle_)
+        : anchor(anchor_), line(line_), maxAngle(maxAngle_) {}
+
+    SegmentPath &get(int8_t direction, bool upsideDown) {
+        std::unique_ptr<SegmentPath> &path = paths[direction > 0][upsideDown];
+        if (!path) {
+            path = util::make_unique<SegmentPath>(anchor, line, direction, upsideDown, maxAngle);
+        }
+        return *path;
+    }
+
+private:
+    const Anchor anchor;
+    const std::vector<Coordinate> &line;
+    const float maxAngle;
+    std::unique_ptr<SegmentPath> paths[2][2];
+};
+
+void getSegmentGlyphs(GlyphInstances &glyphs, Anchor &anchor, float offset, SegmentPaths &paths,
+                      int8_t direction) {
     const bool upsideDown = direction < 0;
 
     if (offset < 0)
         direction *= -1;
 
-    if (direction > 0)
-        segment++;
-
-    vec2<float> newAnchor = anchor;
-
-    if ((int)line.size() <= segment) {
+    SegmentPath &path = paths.get(direction, upsideDown);
+    if (path.isEmpty()) {
         return;
     }
-    vec2<float> end = line[segment];
+
     float prevscale = std::numeric_limits<float>::infinity();
-    float prevAngle = 0.0f;
 
     offset = std::fabs(offset);
 
     const float placementScale = anchor.scale;
+    const float flip = static_cast<float>(upsideDown ? M_PI : 0.0);
 
-    while (true) {
-        const float dist = util::dist<float>(newAnchor, end);
-        const float scale = offset / dist;
-        float angle =
-            -std::atan2(end.x - newAnchor.x, end.y - newAnchor.y) + direction * M_PI / 2.0f;
-        if (upsideDown)
-            angle += M_PI;
+    for (size_t i = 0; path.reach(i); i++) {
+        const float scale = offset / path.dists[i];
 
         // Don't place around sharp corners
-        float angleDiff = std::fmod((angle - prevAngle), (2.0f * M_PI));
-        if (prevAngle && std::fabs(angleDiff) > maxAngle) {
+        if (path.sharp[i]) {
             anchor.scale = prevscale;
-            break;
+            return;
         }
 
-        glyphs = GlyphInstance{
-            /* anchor */ newAnchor,
-            /* offset */ static_cast<float>(upsideDown ? M_PI : 0.0),
+        glyphs.emplace_back(
+            /* anchor */ path.anchors[i],
+            /* offset */ flip,
             /* minScale */ scale,
             /* maxScale */ prevscale,
-            /* angle */ static_cast<float>(std::fmod((angle + 2.0 * M_PI), (2.0 * M_PI)))};
+            /* angle */ path.angles[i]);
 
         if (scale <= placementScale)
-            break;
-
-        newAnchor = end;
-
-        // skip duplicate nodes
-        while (newAnchor == end) {
-            segment += direction;
-            if ((int)line.size() <= segment || segment < 0) {
-                anchor.scale = scale;
-                return;
-            }
-            end = line[segment];
-        }
-
-        vec2<float> normal = util::normal<float>(newAnchor, end) * dist;
-        newAnchor = newAnchor - normal;
+            return;
 
         prevscale = scale;
-        prevAngle = angle;
     }
+
+    // The line ended before the glyph reached the anchor's scale.
+    anchor.scale = prevscale;
 }
 
 GlyphBox getMergedBoxes(const GlyphBoxes &glyphs, const Anchor &anchor) {
@@ -210,6 +292,16 @@ Placement Placement::getGlyphs(Anchor &anchor, const vec2<float> &origin, const
 
     const uint32_t buffer = 3;
 
+    SegmentPaths paths(anchor, line, maxAngle);
+    GlyphInstances glyphInstances;
+
+    // Glyphs on the same segment share their angle.
+    float prevAngle = 0;
+    float angleSin = 0, angleCos = 1;
+
+    placement.shapes.reserve(shaping.size());
+    placement.boxes.reserve(shaping.size());
+
     for (const PositionedGlyph &shape : shaping) {
         auto face_it = face.find(shape.glyph);
         if (face_it == face.end())
@@ -225,13 +317,11 @@ Placement Placement::getGlyphs(Anchor &anchor, const vec2<float> &origin, const
 
         const float x = (origin.x + shape.x + glyph.metrics.left - buffer + rect.w / 2) * boxScale;
 
-        GlyphInstances glyphInstances;
+        glyphInstances.clear();
         if (anchor.segment >= 0 && alongLine) {
-            getSegmentGlyphs(std::back_inserter(glyphInstances), anchor, x, line, anchor.segment, 1,
-                             maxAngle);
+            getSegmentGlyphs(glyphInstances, anchor, x, paths, 1);
             if (keepUpright)
-                getSegmentGlyphs(std::back_inserter(glyphInstances), anchor, x, line,
-                                 anchor.segment, -1, maxAngle);
+                getSegmentGlyphs(glyphInstances, anchor, x, paths, -1);
 
         } else {
             glyphInstances.emplace_back(GlyphInstance{anchor});
@@ -261,10 +351,14 @@ Placement Placement::getGlyphs(Anchor &anchor, const vec2<float> &origin, const
             const float angle = instance.angle + rotate;
 
             if (angle) {
+                if (angle != prevAngle) {
+                    angleSin = std::sin(angle);
+                    angleCos = std::cos(angle);
+                    prevAngle = angle;
+                }
+
                 // Compute the transformation matrix.
-                float angle_sin = std::sin(angle);
-                float angle_cos = std::cos(angle);
-                std::array<float, 4> matrix = {{angle_cos, -angle_sin, angle_sin, angle_cos}};
+                std::array<float, 4> matrix = {{angleCos, -angleSin, angleSin, angleCos}};
 
                 tl = tl.matMul(matrix);
                 tr = tr.matMul(matrix);
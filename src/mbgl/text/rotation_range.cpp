@@ -7,17 +7,20 @@
 
 namespace mbgl {
 
+namespace {
+
+const float pi = M_PI;
+const float twoPi = 2 * M_PI;
+
 /*
- * Combine an array of collision ranges to form a continuous
- * range that includes 0. Collisions within the ignoreRange are ignored
+ * Accumulates collision ranges into the continuous range that includes 0, so
+ * that the ranges don't have to be collected in a list first.
  */
-CollisionRange mergeCollisions(const CollisionList &collisions,
-                               PlacementRange ignoreRange) {
-    // find continuous interval including 0 that doesn't have any collisions
-    float min = 2.0f * M_PI;
-    float max = 0.0f;
+class CollisionMerger {
+public:
+    explicit CollisionMerger(const PlacementRange &ignoreRange_) : ignoreRange(ignoreRange_) {}
 
-    for (CollisionRange collision : collisions) {
+    void operator()(const CollisionRange &collision) {
         bool entryOutside =
             ignoreRange[0] <= collision[0] && collision[0] <= ignoreRange[1];
         bool exitOutside =
@@ -37,15 +40,56 @@ CollisionRange mergeCollisions(const CollisionList &collisions,
         }
     }
 
-    return {{min, max}};
+    CollisionRange result() const {
+        return {{min, max}};
+    }
+
+private:
+    const PlacementRange ignoreRange;
+    float min = twoPi;
+    float max = 0.0f;
+};
+
+/*
+ * Collects collision ranges in a list.
+ */
+class CollisionAppender {
+public:
+    explicit CollisionAppender(CollisionList &collisions_) : collisions(collisions_) {}
+
+    void operator()(const CollisionRange &collision) {
+        collisions.push_back(collision);
+    }
+
+private:
+    CollisionList &collisions;
+};
+
+}
+
+/*
+ * Combine an array of collision ranges to form a continuous
+ * range that includes 0. Collisions within the ignoreRange are ignored
+ */
+CollisionRange mergeCollisions(const CollisionList &collisions,
+                               PlacementRange ignoreRange) {
+    // find continuous interval including 0 that doesn't have any collisions
+    CollisionMerger merger(ignoreRange);
+    for (const CollisionRange &collision : collisions) {
+        merger(collision);
+    }
+    return merger.result();
 }
 
+namespace {
+
 /*
  *  Calculate collision ranges for two rotating boxes.
  */
-CollisionList
-rotatingRotatingCollisions(const CollisionRect &a, const CollisionRect &b,
-                           const CollisionAnchor &anchorToAnchor) {
+template <typename Output>
+void rotatingRotatingCollisions(Output &collisions, const CollisionRect &a,
+                                const CollisionRect &b,
+                                const CollisionAnchor &anchorToAnchor) {
     const float d = util::mag<float>(anchorToAnchor);
     const float d_sq = d * d;
 
@@ -53,27 +97,29 @@ rotatingRotatingCollisions(const CollisionRect &a, const CollisionRect &b,
     const float angleBetweenAnchors =
         util::angle_between<float>(anchorToAnchor, horizontal);
 
+    const float rl = a.br.x - b.tl.x;
+    const float lr = -a.tl.x + b.br.x;
+    const float tb = a.br.y - b.tl.y;
+    const float bt = -a.tl.y + b.br.y;
+
+    const float asinTB = std::asin(tb / d);
+    const float asinBT = std::asin(bt / d);
+    const float acosRL = std::acos(rl / d);
+    const float acosLR = std::acos(lr / d);
+
     // Calculate angles at which collisions may occur
     const std::array<float, 8> c = {{
         // top/bottom
-        /*[0]*/ static_cast<float>(std::asin((float)(a.br.y - b.tl.y) / d)),
-        /*[1]*/ static_cast<float>(std::asin((float)(a.br.y - b.tl.y) / d) + M_PI),
-        /*[2]*/ static_cast<float>(2 * M_PI -
-                                   std::asin((float)(-a.tl.y + b.br.y) / d)),
-        /*[3]*/ static_cast<float>(M_PI - std::asin((float)(-a.tl.y + b.br.y) / d)),
+        /*[0]*/ asinTB,
+        /*[1]*/ asinTB + pi,
+        /*[2]*/ twoPi - asinBT,
+        /*[3]*/ pi - asinBT,
 
         // left/right
-        /*[4]*/ static_cast<float>(2 * M_PI -
-                                   std::acos((float)(a.br.x - b.tl.x) / d)),
-        /*[5]*/ static_cast<float>(std::acos((float)(a.br.x - b.tl.x) / d)),
-        /*[6]*/ static_cast<float>(M_PI - std::acos((float)(-a.tl.x + b.br.x) / d)),
-        /*[7]*/ static_cast<float>(M_PI +
-                                   std::acos((float)(-a.tl.x + b.br.x) / d))}};
-
-    const float rl = a.br.x - b.tl.x;
-    const float lr = -a.tl.x + b.br.x;
-    const float tb = a.br.y - b.tl.y;
-    const float bt = -a.tl.y + b.br.y;
+        /*[4]*/ twoPi - acosRL,
+        /*[5]*/ acosRL,
+        /*[6]*/ pi - acosLR,
+        /*[7]*/ pi + acosLR}};
 
     // Calculate the distance squared of the diagonal which will be used
     // to check if the boxes are close enough for collisions to occur at each
@@ -81,40 +127,37 @@ rotatingRotatingCollisions(const CollisionRect &a, const CollisionRect &b,
     // todo, triple check these
     const std::array<float, 8> e = {{
         // top/bottom
-        /*[0]*/ static_cast<float>(rl * rl + tb * tb),
-        /*[1]*/ static_cast<float>(lr * lr + tb * tb),
-        /*[2]*/ static_cast<float>(rl * rl + bt * bt),
-        /*[3]*/ static_cast<float>(lr * lr + bt * bt),
+        /*[0]*/ rl * rl + tb * tb,
+        /*[1]*/ lr * lr + tb * tb,
+        /*[2]*/ rl * rl + bt * bt,
+        /*[3]*/ lr * lr + bt * bt,
 
         // left/right
-        /*[4]*/ static_cast<float>(rl * rl + tb * tb),
-        /*[5]*/ static_cast<float>(rl * rl + bt * bt),
-        /*[6]*/ static_cast<float>(lr * lr + bt * bt),
-        /*[7]*/ static_cast<float>(lr * lr + tb * tb)}};
+        /*[4]*/ rl * rl + tb * tb,
+        /*[5]*/ rl * rl + bt * bt,
+        /*[6]*/ lr * lr + bt * bt,
+        /*[7]*/ lr * lr + tb * tb}};
 
-    std::vector<float> f;
+    std::array<float, 8> f;
+    size_t count = 0;
     for (size_t i = 0; i < c.size(); i++) {
         // Check if they are close enough to collide
         if (!std::isnan(c[i]) && d_sq <= e[i]) {
             // So far, angles have been calulated as relative to the vector
             // between anchors.
             // Convert the angles to angles from north.
-            f.push_back(
-                std::fmod((c[i] + angleBetweenAnchors + 2 * M_PI), (2 * M_PI)));
+            f[count++] = std::fmod(c[i] + angleBetweenAnchors + twoPi, twoPi);
         }
     }
 
-    assert(f.size() % 2 == 0);
+    assert(count % 2 == 0);
 
     // Group the collision angles by two
     // each group represents a range where the two boxes collide
-    CollisionList collisions;
-    std::sort(f.begin(), f.end());
-    for (size_t k = 0; k < f.size(); k += 2) {
-        collisions.push_back({{f[k], f[k + 1]}});
+    std::sort(f.begin(), f.begin() + count);
+    for (size_t k = 0; k + 1 < count; k += 2) {
+        collisions({{f[k], f[k + 1]}});
     }
-
-    return collisions;
 }
 
 double getAngle(const CollisionPoint &p1, const CollisionPoint &p2,
@@ -129,8 +172,8 @@ double getAngle(const CollisionPoint &p1, const CollisionPoint &p2,
 /*
  * Return the intersection points of a circle and a line segment;
  */
-void circleEdgeCollisions(std::back_insert_iterator<CollisionAngles> angles,
-                          const CollisionPoint &corner, float radius,
+template <typename Output>
+void circleEdgeCollisions(Output &angles, const CollisionPoint &corner, float radius,
                           const CollisionPoint &p1, const CollisionPoint &p2) {
     const CollisionPoint::Type edgeX = p2.x - p1.x;
     const CollisionPoint::Type edgeY = p2.y - p1.y;
@@ -149,33 +192,43 @@ void circleEdgeCollisions(std::back_insert_iterator<CollisionAngles> angles,
         // only add points if within line segment
         // hack to handle floating point representations of 0 and 1
         if (0 < x1 && x1 < 1) {
-            angles = getAngle(p1, p2, x1, corner);
+            angles(getAngle(p1, p2, x1, corner));
         }
 
         if (0 < x2 && x2 < 1) {
-            angles = getAngle(p1, p2, x2, corner);
+            angles(getAngle(p1, p2, x2, corner));
         }
     }
 }
 
+// A circle crosses the four edges of a box at most eight times.
+class CornerAngles {
+public:
+    void operator()(CollisionAngle angle) {
+        angles[count++] = angle;
+    }
+
+    std::array<CollisionAngle, 8> angles;
+    size_t count = 0;
+};
+
 /*
  *  Calculate the ranges for which the corner,
  *  rotatated around the anchor, is within the box;
  */
-void cornerBoxCollisions(std::back_insert_iterator<CollisionList> collisions,
-                         const CollisionPoint &corner,
+template <typename Output>
+void cornerBoxCollisions(Output &collisions, const CollisionPoint &corner,
                          const CollisionCorners &boxCorners, bool flip) {
     float radius = util::mag<float>(corner);
 
-    CollisionAngles angles;
+    CornerAngles angles;
 
     // Calculate the points at which the corners intersect with the edges
     for (size_t i = 0, j = 3; i < 4; j = i++) {
-        circleEdgeCollisions(std::back_inserter(angles), corner, radius,
-                             boxCorners[j], boxCorners[i]);
+        circleEdgeCollisions(angles, corner, radius, boxCorners[j], boxCorners[i]);
     }
 
-    if (angles.size() % 2 != 0) {
+    if (angles.count % 2 != 0) {
         // TODO fix
         // This could get hit when a point intersects very close to a corner
         // and floating point issues cause only one of the entry or exit to be
@@ -183,15 +236,15 @@ void cornerBoxCollisions(std::back_insert_iterator<CollisionList> collisions,
         throw std::runtime_error("expecting an even number of intersections");
     }
 
-    std::sort(angles.begin(), angles.end());
+    std::sort(angles.angles.begin(), angles.angles.begin() + angles.count);
 
     // Group by pairs, where each represents a range where a collision occurs
-    for (size_t k = 0; k < angles.size(); k += 2) {
-        CollisionRange range = {{angles[k], angles[k + 1]}};
+    for (size_t k = 0; k < angles.count; k += 2) {
+        CollisionRange range = {{angles.angles[k], angles.angles[k + 1]}};
         if (flip) {
             range = util::flip(range);
         }
-        collisions = range;
+        collisions(range);
     }
 }
 
@@ -205,23 +258,58 @@ CollisionCorners getCorners(const CollisionRect &a) {
 /*
  *  Calculate collision ranges for a rotating box and a fixed box;
  */
-CollisionList rotatingFixedCollisions(const CollisionRect &rotating,
-                                      const CollisionRect &fixed) {
+template <typename Output>
+void rotatingFixedCollisions(Output &collisions, const CollisionRect &rotating,
+                             const CollisionRect &fixed) {
     const auto cornersR = getCorners(rotating);
     const auto cornersF = getCorners(fixed);
 
     // A collision occurs when, and only at least one corner from one of the
     // boxes is within the other box. Calculate these ranges for each corner.
+    for (size_t i = 0; i < 4; i++) {
+        cornerBoxCollisions(collisions, cornersR[i], cornersF, false);
+        cornerBoxCollisions(collisions, cornersF[i], cornersR, true);
+    }
+}
+
+// The distance of the box corner that is farthest from the anchor, i.e. the
+// radius of the circle that the box sweeps when it rotates.
+float sweepRadius(const CollisionRect &box) {
+    const float x = util::max(std::abs(box.tl.x), std::abs(box.br.x));
+    const float y = util::max(std::abs(box.tl.y), std::abs(box.br.y));
+    return std::sqrt(x * x + y * y);
+}
+
+}
 
+CollisionList rotatingRotatingCollisions(const CollisionRect &a,
+                                         const CollisionRect &b,
+                                         const CollisionAnchor &anchorToAnchor) {
     CollisionList collisions;
+    CollisionAppender appender(collisions);
+    rotatingRotatingCollisions(appender, a, b, anchorToAnchor);
+    return collisions;
+}
 
-    for (size_t i = 0; i < 4; i++) {
-        cornerBoxCollisions(std::back_inserter(collisions), cornersR[i],
-                            cornersF);
-        cornerBoxCollisions(std::back_inserter(collisions), cornersF[i],
-                            cornersR, true);
-    }
+void circleEdgeCollisions(std::back_insert_iterator<CollisionAngles> angles,
+                          const CollisionPoint &corner, float radius,
+                          const CollisionPoint &p1, const CollisionPoint &p2) {
+    auto append = [&](CollisionAngle angle) { angles = angle; };
+    circleEdgeCollisions(append, corner, radius, p1, p2);
+}
+
+void cornerBoxCollisions(std::back_insert_iterator<CollisionList> collisions,
+                         const CollisionPoint &corner,
+                         const CollisionCorners &boxCorners, bool flip) {
+    auto append = [&](const CollisionRange &range) { collisions = range; };
+    cornerBoxCollisions(append, corner, boxCorners, flip);
+}
 
+CollisionList rotatingFixedCollisions(const CollisionRect &rotating,
+                                      const CollisionRect &fixed) {
+    CollisionList collisions;
+    CollisionAppender appender(collisions);
+    rotatingFixedCollisions(appender, rotating, fixed);
     return collisions;
 }
 
@@ -230,34 +318,46 @@ CollisionList rotatingFixedCollisions(const CollisionRect &rotating,
  */
 CollisionRange rotationRange(const GlyphBox &inserting,
                              const PlacementBox &blocker, float scale) {
-    CollisionList collisions;
-
     const GlyphBox &a = inserting;
     const PlacementBox &b = blocker;
 
+    // Find the continous range around 0 where there are no collisions
+    CollisionMerger collisions(blocker.placementRange);
+
+    // Two fixed boxes never generate collision ranges.
+    if (!a.hBox && !b.hBox) {
+        return collisions.result();
+    }
+
     // Instead of scaling the boxes, we move the anchors
     CollisionAnchor relativeAnchor{
-        static_cast<float>((b.anchor.x - a.anchor.x) * scale),
-        static_cast<float>((b.anchor.y - a.anchor.y) * scale)};
+        (b.anchor.x - a.anchor.x) * scale,
+        (b.anchor.y - a.anchor.y) * scale};
+
+    // Boxes whose anchors are farther apart than the radii of the circles they
+    // sweep can't collide at any rotation. Leave a little slack so that pairs
+    // that just touch still get the exact calculation.
+    const float reach = (sweepRadius(a.box) + sweepRadius(b.box)) * 1.001f;
+    if (relativeAnchor.x * relativeAnchor.x + relativeAnchor.y * relativeAnchor.y >
+        reach * reach) {
+        return collisions.result();
+    }
 
-    // Generate a list of collision interval
+    // Generate the collision intervals
     if (a.hBox && b.hBox) {
-        collisions = rotatingRotatingCollisions(a.box, b.box, relativeAnchor);
+        rotatingRotatingCollisions(collisions, a.box, b.box, relativeAnchor);
     } else if (a.hBox) {
         const CollisionRect box {
             b.box.tl.x + relativeAnchor.x, b.box.tl.y + relativeAnchor.y,
             b.box.br.x + relativeAnchor.x, b.box.br.y + relativeAnchor.y};
-        collisions = rotatingFixedCollisions(a.box, box);
-    } else if (b.hBox) {
+        rotatingFixedCollisions(collisions, a.box, box);
+    } else {
         const CollisionRect box {
             a.box.tl.x - relativeAnchor.x, a.box.tl.y - relativeAnchor.y,
             a.box.br.x - relativeAnchor.x, a.box.br.y - relativeAnchor.y};
-        collisions = rotatingFixedCollisions(b.box, box);
-    } else {
-        // collisions remains empty
+        rotatingFixedCollisions(collisions, b.box, box);
     }
 
-    // Find and return the continous are around 0 where there are no collisions
-    return mergeCollisions(collisions, blocker.placementRange);
+    return collisions.result();
 }
 }
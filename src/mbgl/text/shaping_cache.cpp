@@ -0,0 +1,51 @@
+#include <mbgl/text/shaping_cache.hpp>
+
+#include <tuple>
+
+namespace mbgl {
+
+bool ShapingCache::Key::operator<(const Key &rhs) const {
+    return std::tie(text, fontStack, maxWidth, lineHeight, horizontalAlign, verticalAlign, justify,
+                    spacing, translate.x, translate.y) <
+           std::tie(rhs.text, rhs.fontStack, rhs.maxWidth, rhs.lineHeight, rhs.horizontalAlign,
+                    rhs.verticalAlign, rhs.justify, rhs.spacing, rhs.translate.x, rhs.translate.y);
+}
+
+ShapingCache::ShapingCache(size_t maxEntries_) : maxEntries(maxEntries_) {
+}
+
+util::ptr<const Shaping> ShapingCache::get(const Key &key) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return nullptr;
+    }
+
+    // Move the shaping to the front of the list.
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+void ShapingCache::add(const Key &key, const util::ptr<const Shaping> &shaping) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    entries.emplace_front(key, shaping);
+    index.emplace(key, entries.begin());
+
+    while (entries.size() > maxEntries) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+size_t ShapingCache::size() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return entries.size();
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef MBGL_TEXT_SHAPING_CACHE
+#define MBGL_TEXT_SHAPING_CACHE
+
+#include <mbgl/text/glyph.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/ptr.hpp>
+#include <mbgl/util/vec.hpp>
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace mbgl {
+
+// Keeps the shapings of recently used labels, so that the same street and place names don't get
+// shaped again in every tile and at every zoom level. Once the cache holds more than the maximum
+// number of shapings, the least recently used ones are dropped. May be used from any thread.
+class ShapingCache : private util::noncopyable {
+public:
+    struct Key {
+        std::u32string text;
+        std::string fontStack;
+        float maxWidth;
+        float lineHeight;
+        float horizontalAlign;
+        float verticalAlign;
+        float justify;
+        float spacing;
+        vec2<float> translate;
+
+        bool operator<(const Key &rhs) const;
+    };
+
+    ShapingCache(size_t maxEntries = 4096);
+
+    // Returns nullptr if the shaping isn't cached.
+    util::ptr<const Shaping> get(const Key &key);
+
+    // Adds a shaping. Replaces an existing shaping with the same key.
+    void add(const Key &key, const util::ptr<const Shaping> &shaping);
+
+    size_t size() const;
+
+private:
+    typedef std::pair<Key, util::ptr<const Shaping>> Entry;
+
+    const size_t maxEntries;
+    mutable std::mutex mtx;
+
+    // Most recently used shapings first.
+    std::list<Entry> entries;
+    std::map<Key, std::list<Entry>::iterator> index;
+};
+
+}
+
+#endif
@@ -0,0 +1,178 @@
+#include <mbgl/util/allocation_tracker.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace mbgl {
+
+const char *AllocationTracker::subsystemName(Subsystem subsystem) {
+    switch (subsystem) {
+        case Subsystem::Other: return "Other";
+        case Subsystem::TileParser: return "TileParser";
+        case Subsystem::SymbolBucket: return "SymbolBucket";
+        case Subsystem::StyleParser: return "StyleParser";
+        case Subsystem::SQLiteStore: return "SQLiteStore";
+        case Subsystem::Painter: return "Painter";
+    }
+    return "Unknown";
+}
+
+AllocationTracker::Counts &AllocationTracker::Counts::operator+=(const Counts &rhs) {
+    for (size_t i = 0; i < subsystemCount; i++) {
+        subsystems[i] += rhs.subsystems[i];
+    }
+    return *this;
+}
+
+AllocationTracker::Counts AllocationTracker::Counts::operator-(const Counts &rhs) const {
+    Counts result;
+    for (size_t i = 0; i < subsystemCount; i++) {
+        result.subsystems[i] = subsystems[i] - rhs.subsystems[i];
+    }
+    return result;
+}
+
+AllocationUsage AllocationTracker::Counts::sum() const {
+    AllocationUsage result;
+    for (const AllocationUsage &usage : subsystems) {
+        result += usage;
+    }
+    return result;
+}
+
+std::map<std::string, AllocationUsage> AllocationTracker::Counts::toMap() const {
+    std::map<std::string, AllocationUsage> result;
+    for (size_t i = 0; i < subsystemCount; i++) {
+        if (subsystems[i].count) {
+            result[subsystemName(Subsystem(i))] = subsystems[i];
+        }
+    }
+    return result;
+}
+
+#if defined(MBGL_TRACK_ALLOCATIONS)
+
+namespace {
+
+// All of the state is plain data that is zero initialized, so that counting the allocations that
+// happen before main() or on a new thread doesn't depend on constructors having run.
+thread_local AllocationTracker::Subsystem currentSubsystem;
+thread_local uint64_t threadCounts[AllocationTracker::subsystemCount];
+thread_local uint64_t threadBytes[AllocationTracker::subsystemCount];
+std::atomic<uint64_t> totalCounts[AllocationTracker::subsystemCount];
+std::atomic<uint64_t> totalBytes[AllocationTracker::subsystemCount];
+
+void *allocate(size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (void *ptr = std::malloc(size)) {
+            const size_t i = size_t(currentSubsystem);
+            threadCounts[i]++;
+            threadBytes[i] += size;
+            totalCounts[i].fetch_add(1, std::memory_order_relaxed);
+            totalBytes[i].fetch_add(size, std::memory_order_relaxed);
+            return ptr;
+        }
+        const std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+}
+
+AllocationTracker::Scope::Scope(Subsystem subsystem) : previous(currentSubsystem) {
+    currentSubsystem = subsystem;
+}
+
+AllocationTracker::Scope::~Scope() {
+    currentSubsystem = previous;
+}
+
+AllocationTracker::Counts AllocationTracker::total() {
+    Counts result;
+    for (size_t i = 0; i < subsystemCount; i++) {
+        result.subsystems[i] = AllocationUsage(totalCounts[i].load(std::memory_order_relaxed),
+                                               totalBytes[i].load(std::memory_order_relaxed));
+    }
+    return result;
+}
+
+AllocationTracker::Counts AllocationTracker::thread() {
+    Counts result;
+    for (size_t i = 0; i < subsystemCount; i++) {
+        result.subsystems[i] = AllocationUsage(threadCounts[i], threadBytes[i]);
+    }
+    return result;
+}
+
+void AllocationTracker::adopt(const Counts &counts) {
+    for (size_t i = 0; i < subsystemCount; i++) {
+        threadCounts[i] += counts.subsystems[i].count;
+        threadBytes[i] += counts.subsystems[i].bytes;
+    }
+}
+
+}
+
+void *operator new(size_t size) {
+    return mbgl::allocate(size);
+}
+
+void *operator new[](size_t size) {
+    return mbgl::allocate(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return mbgl::allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return mbgl::allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+
+#else
+
+AllocationTracker::Counts AllocationTracker::total() {
+    return Counts();
+}
+
+AllocationTracker::Counts AllocationTracker::thread() {
+    return Counts();
+}
+
+void AllocationTracker::adopt(const Counts &) {
+}
+
+}
+
+#endif
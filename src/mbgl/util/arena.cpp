@@ -0,0 +1,49 @@
+#include <mbgl/util/arena.hpp>
+
+#include <cassert>
+
+using namespace mbgl::util;
+
+Arena::Arena(size_t blockSize_) : blockSize(blockSize_) {
+    assert(blockSize > 0);
+}
+
+void *Arena::allocate(size_t size) {
+    // Round up so that the next allocation starts on an aligned boundary, too.
+    size = (size + alignment - 1) & ~(alignment - 1);
+
+    if (blocks.empty() || offset + size > blocks.back().size) {
+        addBlock(size > blockSize ? size : blockSize);
+    }
+
+    void *ptr = blocks.back().begin + offset;
+    offset += size;
+    return ptr;
+}
+
+void Arena::reset() {
+    if (blocks.size() > 1) {
+        const size_t total = capacity();
+        blocks.clear();
+        addBlock(total);
+    }
+    offset = 0;
+}
+
+size_t Arena::capacity() const {
+    size_t total = 0;
+    for (const Block &block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
+
+void Arena::addBlock(size_t size) {
+    // new[] only guarantees alignment for fundamental types, so we over-allocate
+    // and offset into the block.
+    std::unique_ptr<uint8_t[]> data(new uint8_t[size + alignment]);
+    const uintptr_t address = reinterpret_cast<uintptr_t>(data.get());
+    uint8_t *begin = data.get() + (((address + alignment - 1) & ~uintptr_t(alignment - 1)) - address);
+    blocks.push_back({ std::move(data), begin, size });
+    offset = 0;
+}
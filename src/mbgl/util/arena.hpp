@@ -0,0 +1,52 @@
+#ifndef MBGL_UTIL_ARENA
+#define MBGL_UTIL_ARENA
+
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mbgl {
+namespace util {
+
+// A monotonic allocator for short-lived, parse-time scratch memory. Allocations
+// are carved out of large blocks and are never freed individually; instead, the
+// whole arena is rewound with reset(), which keeps the memory around so that the
+// next round of allocations doesn't touch the system allocator at all.
+class Arena : private util::noncopyable {
+public:
+    // Every allocation is aligned to this boundary.
+    static const size_t alignment = 16;
+
+    explicit Arena(size_t blockSize = 64 * 1024);
+
+    void *allocate(size_t size);
+
+    // Releases all allocations at once. After a reset, the arena consists of a
+    // single block that is large enough to hold everything that was allocated
+    // before, so that repeated workloads settle on one block.
+    void reset();
+
+    // Total number of bytes reserved from the system allocator.
+    size_t capacity() const;
+
+private:
+    void addBlock(size_t size);
+
+    struct Block {
+        std::unique_ptr<uint8_t[]> data;
+        uint8_t *begin;
+        size_t size;
+    };
+
+    const size_t blockSize;
+    std::vector<Block> blocks;
+    size_t offset = 0;
+};
+
+}
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include <mbgl/map/tile.hpp>
 
 #include <mbgl/util/math.hpp>
+#include <mbgl/platform/log.hpp>
 
 #include <list>
 #include <vector>
@@ -89,8 +90,46 @@ void ClipIDGenerator::update(std::forward_list<Tile *> tiles) {
     }
 
     if (bit_offset > 8) {
-        fprintf(stderr, "stencil mask overflow\n");
+        Log::Warning(Event::Render, "stencil mask overflow");
     }
 }
 
+void ClipIDCache::update(const std::vector<std::forward_list<Tile *>> &sources) {
+    std::vector<std::vector<Tile::ID>> current;
+    for (const std::forward_list<Tile *> &tiles : sources) {
+        current.emplace_back();
+        for (const Tile *tile : tiles) {
+            if (tile) {
+                current.back().push_back(tile->id);
+            }
+        }
+    }
+
+    if (current == ids) {
+        // Tiles may have been replaced by new ones with the same ID, so the clip IDs are assigned
+        // again rather than assumed to still be there.
+        auto clip = clips.begin();
+        for (const std::forward_list<Tile *> &tiles : sources) {
+            for (Tile *tile : tiles) {
+                if (tile) {
+                    tile->clip = *clip++;
+                }
+            }
+        }
+        return;
+    }
+
+    ClipIDGenerator generator;
+    clips.clear();
+    for (const std::forward_list<Tile *> &tiles : sources) {
+        generator.update(tiles);
+        for (const Tile *tile : tiles) {
+            if (tile) {
+                clips.push_back(tile->clip);
+            }
+        }
+    }
+    ids = std::move(current);
+}
+
 }
@@ -32,6 +32,21 @@ public:
     void update(std::forward_list<Tile *> tiles);
 };
 
+// Keeps the clip IDs of the last frame, so that they are only generated again when the tiles
+// change. Generating them compares every tile with all tiles after it, which is wasted work for
+// the many frames in which the map just pans or zooms over loaded tiles.
+class ClipIDCache {
+public:
+    // Assigns clip IDs to the tiles of all sources, like one ClipIDGenerator::update() call per
+    // source in the given order.
+    void update(const std::vector<std::forward_list<Tile *>> &sources);
+
+private:
+    // The IDs of the tiles of each source, and the clip IDs that they got, in the same order.
+    std::vector<std::vector<Tile::ID>> ids;
+    std::vector<ClipID> clips;
+};
+
 
 }
 
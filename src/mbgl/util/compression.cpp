@@ -43,38 +43,62 @@ std::string compress(const std::string &raw) {
     return result;
 }
 
+// Deflate can't compress better than about 1:1032, so larger sizes in a gzip trailer are bogus.
+const size_t maxDeflateRatio = 1032;
+
+// Returns how large the data will likely be once it's inflated. Gzip streams end with the
+// inflated size modulo 2^32; zlib streams don't record it, so we guess.
+static size_t inflatedSizeHint(const char *data, size_t size) {
+    if (size >= 18 && uint8_t(data[0]) == 0x1F && uint8_t(data[1]) == 0x8B) {
+        const uint8_t *trailer = reinterpret_cast<const uint8_t *>(data + size - 4);
+        const size_t inflated = size_t(trailer[0]) | size_t(trailer[1]) << 8 |
+                                size_t(trailer[2]) << 16 | size_t(trailer[3]) << 24;
+        if (inflated <= size * maxDeflateRatio) {
+            return inflated;
+        }
+    }
+    return size * 4;
+}
+
 std::string decompress(const std::string &raw) {
+    return decompress(raw.data(), raw.size());
+}
+
+std::string decompress(const char *data, size_t size) {
     z_stream inflate_stream;
     memset(&inflate_stream, 0, sizeof(inflate_stream));
 
     // TODO: reuse z_streams
-    if (inflateInit(&inflate_stream) != Z_OK) {
+    // Adding 32 to the window bits enables automatic detection of zlib and gzip headers.
+    if (inflateInit2(&inflate_stream, 32 + MAX_WBITS) != Z_OK) {
         throw std::runtime_error("failed to initialize inflate");
     }
 
-    inflate_stream.next_in = (Bytef *)raw.data();
-    inflate_stream.avail_in = uInt(raw.size());
+    inflate_stream.next_in = (Bytef *)data;
+    inflate_stream.avail_in = uInt(size);
 
+    // Inflate straight into the result so that the data isn't copied once more. The extra byte
+    // lets inflate() read the trailer and finish after it wrote the expected size.
     std::string result;
-    char out[15384];
+    result.resize(inflatedSizeHint(data, size) + 1);
 
     int code;
     do {
-        inflate_stream.next_out = reinterpret_cast<Bytef *>(out);
-        inflate_stream.avail_out = sizeof(out);
-        code = inflate(&inflate_stream, 0);
-        // result.append(out, sizeof(out) - inflate_stream.avail_out);
-        if (result.size() < inflate_stream.total_out) {
-            result.append(out, inflate_stream.total_out - result.size());
+        if (inflate_stream.total_out == result.size()) {
+            result.resize(result.size() * 2);
         }
+        inflate_stream.next_out = reinterpret_cast<Bytef *>(&result[inflate_stream.total_out]);
+        inflate_stream.avail_out = uInt(result.size() - inflate_stream.total_out);
+        code = inflate(&inflate_stream, Z_NO_FLUSH);
     } while (code == Z_OK);
 
     inflateEnd(&inflate_stream);
 
     if (code != Z_STREAM_END) {
-        throw std::runtime_error(inflate_stream.msg);
+        throw std::runtime_error(inflate_stream.msg ? inflate_stream.msg : "incomplete compressed data");
     }
 
+    result.resize(inflate_stream.total_out);
     return result;
 }
 }
@@ -9,6 +9,10 @@ namespace util {
 std::string compress(const std::string &raw);
 std::string decompress(const std::string &raw);
 
+// Inflates zlib or gzip data. The result is allocated once when the gzip trailer tells the
+// inflated size.
+std::string decompress(const char *data, size_t size);
+
 }
 }
 
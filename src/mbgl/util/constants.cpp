@@ -1,6 +1,15 @@
 #include <mbgl/util/constants.hpp>
 
 const float mbgl::util::tileSize = 512.0f;
+const size_t mbgl::util::decodedTileCacheSize = 256 * 1024;
+const size_t mbgl::util::tileCacheSize = 16 * 1024 * 1024;
+const size_t mbgl::util::uploadBudget = 1024 * 1024;
+const uint64_t mbgl::util::afterWorkBudget = 4000000;
+const uint64_t mbgl::util::workerIdleTimeout = 10000000000;
+const int16_t mbgl::util::tileClipBuffer = 512;
+const int64_t mbgl::util::negativeCacheTTL = 24 * 60 * 60;
+const uint64_t mbgl::util::lowBandwidth = 16 * 1024;
+const char *mbgl::util::geojsonLayerName = "_geojsonTileLayer";
 
 #if defined(DEBUG)
 const bool mbgl::debug::tileParseWarnings = false;
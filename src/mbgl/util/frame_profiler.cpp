@@ -0,0 +1,102 @@
+#include <mbgl/util/frame_profiler.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace mbgl;
+
+const char *FrameProfiler::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::UpdateSources: return "updateSources";
+        case Phase::UpdateTiles: return "updateTiles";
+        case Phase::UpdateProperties: return "updateProperties";
+        case Phase::Upload: return "upload";
+        case Phase::ClipIDs: return "clipIDs";
+        case Phase::TileTextures: return "tileTextures";
+        case Phase::OpaquePass: return "opaquePass";
+        case Phase::TranslucentPass: return "translucentPass";
+        case Phase::Swap: return "swap";
+    }
+    return "unknown";
+}
+
+void FrameProfiler::record(Phase phase, timestamp start, timestamp end) {
+    const uint64_t index = written.load(std::memory_order_relaxed);
+    Slot &slot = slots[index % capacity];
+
+    slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.phase.store(uint8_t(phase), std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(end - start, std::memory_order_relaxed);
+    slot.sequence.store(index * 2 + 2, std::memory_order_release);
+
+    written.store(index + 1, std::memory_order_release);
+}
+
+std::vector<FrameProfiler::Sample> FrameProfiler::samples() const {
+    const uint64_t end = written.load(std::memory_order_acquire);
+    const uint64_t begin = end > capacity ? end - capacity : 0;
+
+    std::vector<Sample> result;
+    result.reserve(end - begin);
+    for (uint64_t index = begin; index < end; index++) {
+        const Slot &slot = slots[index % capacity];
+        if (slot.sequence.load(std::memory_order_acquire) != index * 2 + 2) {
+            // Already overwritten by a newer sample.
+            continue;
+        }
+        const Sample sample {
+            Phase(slot.phase.load(std::memory_order_relaxed)),
+            slot.start.load(std::memory_order_relaxed),
+            slot.duration.load(std::memory_order_relaxed)
+        };
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == index * 2 + 2) {
+            result.push_back(sample);
+        }
+    }
+    return result;
+}
+
+std::vector<FrameProfiler::Summary> FrameProfiler::summarize() const {
+    std::array<std::vector<timestamp>, phaseCount> durations;
+    for (const Sample &sample : samples()) {
+        durations[size_t(sample.phase)].push_back(sample.duration);
+    }
+
+    std::vector<Summary> result;
+    for (size_t i = 0; i < phaseCount; i++) {
+        std::vector<timestamp> &values = durations[i];
+        if (values.empty()) {
+            continue;
+        }
+        std::sort(values.begin(), values.end());
+
+        Summary summary;
+        summary.phase = Phase(i);
+        summary.count = values.size();
+        summary.p50 = values[(values.size() - 1) * 50 / 100];
+        summary.p90 = values[(values.size() - 1) * 90 / 100];
+        summary.p99 = values[(values.size() - 1) * 99 / 100];
+        summary.max = values.back();
+        result.push_back(summary);
+    }
+    return result;
+}
+
+std::string FrameProfiler::toChromeTrace() const {
+    std::string result = "{\"traceEvents\":[";
+    bool first = true;
+    for (const Sample &sample : samples()) {
+        // Trace timestamps are in microseconds.
+        char event[160];
+        snprintf(event, sizeof(event),
+                 "%s{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":0}",
+                 first ? "" : ",", phaseName(sample.phase), sample.start / 1e3, sample.duration / 1e3);
+        result += event;
+        first = false;
+    }
+    result += "]}";
+    return result;
+}
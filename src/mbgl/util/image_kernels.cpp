@@ -0,0 +1,161 @@
+#include <mbgl/util/image_kernels.hpp>
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace mbgl {
+namespace util {
+
+namespace {
+
+// Rounds x / 255 down; exact for all x below 65535.
+inline uint32_t div255(uint32_t x) {
+    return (x + 1 + (x >> 8)) >> 8;
+}
+
+inline uint16_t toRGB565(const uint8_t *pixel) {
+    return uint16_t(div255(pixel[0] * 31 + 127) << 11 |
+                    div255(pixel[1] * 63 + 127) << 5 |
+                    div255(pixel[2] * 31 + 127));
+}
+
+#if defined(__SSE2__)
+inline __m128i div255(__m128i x) {
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+
+// Converts the four pixels of a block into four 32 bit lanes that each hold one 565 pixel.
+inline __m128i toRGB565(__m128i pixels) {
+    const __m128i low = _mm_set1_epi32(0xFFFF);
+    // Red and blue, and green and alpha, in 16 bit lanes.
+    const __m128i rb = _mm_and_si128(pixels, _mm_set1_epi16(0xFF));
+    const __m128i ga = _mm_srli_epi16(pixels, 8);
+    const __m128i rb5 = div255(_mm_add_epi16(_mm_mullo_epi16(rb, _mm_set1_epi16(31)), _mm_set1_epi16(127)));
+    const __m128i g6 = div255(_mm_add_epi16(_mm_mullo_epi16(ga, _mm_set1_epi16(63)), _mm_set1_epi16(127)));
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(rb5, low), 11),
+                                     _mm_slli_epi32(_mm_and_si128(g6, low), 5)),
+                        _mm_srli_epi32(rb5, 16));
+}
+#endif
+
+}
+
+bool isOpaque(const uint8_t *rgba, size_t pixels) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i alpha = _mm_set1_epi32(int32_t(0xFF000000));
+    for (; i + 4 <= pixels; i += 4) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgba + i * 4));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(block, alpha), alpha)) != 0xFFFF) {
+            return false;
+        }
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    for (; i + 16 <= pixels; i += 16) {
+        const uint8x16x4_t block = vld4q_u8(rgba + i * 4);
+        const uint8x8_t min = vmin_u8(vget_low_u8(block.val[3]), vget_high_u8(block.val[3]));
+        if (vget_lane_u64(vreinterpret_u64_u8(min), 0) != ~uint64_t(0)) {
+            return false;
+        }
+    }
+#endif
+    for (; i < pixels; i++) {
+        if (rgba[i * 4 + 3] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void convertRGBAToRGB565(const uint8_t *src, uint16_t *dst, size_t pixels) {
+    size_t i = 0;
+    // Both blocks are read before anything is written, so that the 16 bit pixels can replace
+    // the ones they came from.
+#if defined(__SSE2__)
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16(int16_t(0x8000));
+    for (; i + 8 <= pixels; i += 8) {
+        const __m128i first = toRGB565(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4)));
+        const __m128i second = toRGB565(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4 + 16)));
+        // Packing saturates signed values, so the pixels are moved into the signed range and back.
+        const __m128i packed = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(first, bias32),
+                                                             _mm_sub_epi32(second, bias32)), bias16);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const uint16x8_t one = vdupq_n_u16(1);
+    const uint16x8_t round = vdupq_n_u16(127);
+    for (; i + 8 <= pixels; i += 8) {
+        const uint8x8x4_t block = vld4_u8(src + i * 4);
+        uint16x8_t r = vmlaq_n_u16(round, vmovl_u8(block.val[0]), 31);
+        uint16x8_t g = vmlaq_n_u16(round, vmovl_u8(block.val[1]), 63);
+        uint16x8_t b = vmlaq_n_u16(round, vmovl_u8(block.val[2]), 31);
+        r = vshrq_n_u16(vaddq_u16(vaddq_u16(r, one), vshrq_n_u16(r, 8)), 8);
+        g = vshrq_n_u16(vaddq_u16(vaddq_u16(g, one), vshrq_n_u16(g, 8)), 8);
+        b = vshrq_n_u16(vaddq_u16(vaddq_u16(b, one), vshrq_n_u16(b, 8)), 8);
+        vst1q_u16(dst + i, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b));
+    }
+#endif
+    for (; i < pixels; i++) {
+        dst[i] = toRGB565(src + i * 4);
+    }
+}
+
+void convertRGBAToRGB(const uint8_t *src, uint8_t *dst, size_t pixels) {
+    size_t i = 0;
+#if defined(__SSSE3__)
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    // Every block writes 16 bytes of which the last four are overwritten by the next one, so the
+    // last pixels are left to the scalar loop.
+    for (; i + 6 <= pixels; i += 4) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 3), _mm_shuffle_epi8(block, shuffle));
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    for (; i + 16 <= pixels; i += 16) {
+        const uint8x16x4_t block = vld4q_u8(src + i * 4);
+        const uint8x16x3_t rgb = { { block.val[0], block.val[1], block.val[2] } };
+        vst3q_u8(dst + i * 3, rgb);
+    }
+#endif
+    for (; i < pixels; i++) {
+        dst[i * 3 + 0] = src[i * 4 + 0];
+        dst[i * 3 + 1] = src[i * 4 + 1];
+        dst[i * 3 + 2] = src[i * 4 + 2];
+    }
+}
+
+void flipRows(uint32_t *pixels, size_t width, size_t height) {
+    for (size_t top = 0, bottom = height ? height - 1 : 0; top < bottom; top++, bottom--) {
+        uint32_t *a = pixels + top * width;
+        uint32_t *b = pixels + bottom * width;
+        size_t x = 0;
+#if defined(__SSE2__)
+        for (; x + 4 <= width; x += 4) {
+            const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + x));
+            const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(a + x), second);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(b + x), first);
+        }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+        for (; x + 4 <= width; x += 4) {
+            const uint32x4_t first = vld1q_u32(a + x);
+            const uint32x4_t second = vld1q_u32(b + x);
+            vst1q_u32(a + x, second);
+            vst1q_u32(b + x, first);
+        }
+#endif
+        std::swap_ranges(a + x, a + width, b + x);
+    }
+}
+
+}
+}
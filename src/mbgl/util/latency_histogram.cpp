@@ -0,0 +1,63 @@
+#include <mbgl/util/latency_histogram.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace mbgl;
+
+timestamp LatencyHistogram::Snapshot::mean() const {
+    return count ? total / count : 0;
+}
+
+timestamp LatencyHistogram::Snapshot::percentile(double fraction) const {
+    if (!count) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, std::ceil(fraction * count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucketCount; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return bucketLimit(i);
+        }
+    }
+    return bucketLimit(bucketCount - 1);
+}
+
+LatencyHistogram::Snapshot &LatencyHistogram::Snapshot::operator+=(const Snapshot &rhs) {
+    for (size_t i = 0; i < bucketCount; i++) {
+        buckets[i] += rhs.buckets[i];
+    }
+    count += rhs.count;
+    total += rhs.total;
+    return *this;
+}
+
+LatencyHistogram::LatencyHistogram() : total(0) {
+    for (std::atomic<uint64_t> &bucket : buckets) {
+        bucket = 0;
+    }
+}
+
+timestamp LatencyHistogram::bucketLimit(size_t bucket) {
+    return (timestamp(1) << bucket) * 1_microsecond;
+}
+
+void LatencyHistogram::add(timestamp duration) {
+    size_t bucket = 0;
+    for (timestamp us = duration / 1_microsecond; us && bucket < bucketCount - 1; us >>= 1) {
+        bucket++;
+    }
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(duration, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot result;
+    for (size_t i = 0; i < bucketCount; i++) {
+        result.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+        result.count += result.buckets[i];
+    }
+    result.total = total.load(std::memory_order_relaxed);
+    return result;
+}
@@ -39,6 +39,46 @@ std::string normalizeGlyphsURL(const std::string& url, const std::string& access
     return normalizeURL(url, accessToken);
 }
 
+std::string canonicalURL(const std::string& url) {
+    // The part of url that is kept, and what replaces the part before it.
+    size_t begin = 0;
+    const char *prefix = "";
+
+    const size_t protocol = url.find("://");
+    if ((protocol == 4 && url.compare(0, 4, "http") == 0) ||
+        (protocol == 5 && url.compare(0, 5, "https") == 0)) {
+        const std::string domain = ".tiles.mapbox.com";
+        const size_t domainBegin = protocol + 3;
+        const size_t pathSeparator = url.find('/', domainBegin);
+        if (pathSeparator != std::string::npos) {
+            const size_t match = url.find(domain, domainBegin);
+            if (match != std::string::npos && match + domain.length() <= pathSeparator) {
+                begin = pathSeparator + 1;
+                prefix = "mapbox://";
+            }
+        }
+    }
+
+    std::string result { prefix };
+    result.reserve(result.length() + url.length() - begin);
+
+    // Only remove a token that is preceded by either & or ?.
+    const size_t tokenBegin = url.find("access_token=", begin);
+    if (tokenBegin == std::string::npos || tokenBegin == begin ||
+        !(url[tokenBegin - 1] == '&' || url[tokenBegin - 1] == '?')) {
+        return result.append(url, begin, std::string::npos);
+    }
+
+    const size_t tokenEnd = url.find('&', tokenBegin);
+    if (tokenEnd == std::string::npos) {
+        // The token is the last query argument. We slice away the "&access_token=..." part.
+        return result.append(url, begin, tokenBegin - 1 - begin);
+    } else {
+        // We slice away the "access_token=...&" part.
+        return result.append(url, begin, tokenBegin - begin).append(url, tokenEnd + 1, std::string::npos);
+    }
+}
+
 }
 }
 }
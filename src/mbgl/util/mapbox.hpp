@@ -10,6 +10,10 @@ namespace mapbox {
 std::string normalizeSourceURL(const std::string& url, const std::string& accessToken);
 std::string normalizeGlyphsURL(const std::string& url, const std::string& accessToken);
 
+// Returns the key that a response for this URL is cached under: URLs on Mapbox API domains are
+// turned into mapbox:// URLs, and the access token is removed.
+std::string canonicalURL(const std::string& url);
+
 }
 }
 }
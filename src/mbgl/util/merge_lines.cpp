@@ -0,0 +1,104 @@
+#include <mbgl/util/merge_lines.hpp>
+
+#include <unordered_map>
+
+namespace mbgl {
+namespace util {
+
+namespace {
+
+// Endpoints are looked up by the label and the coordinate of the endpoint. Labels are interned
+// so that both fit into one integer.
+typedef uint64_t EndpointKey;
+typedef std::unordered_map<EndpointKey, unsigned int> EndpointIndex;
+
+EndpointKey getKey(uint32_t label, const std::vector<std::vector<Coordinate>> &geom, bool onRight) {
+    const Coordinate &coord = onRight ? geom[0].back() : geom[0].front();
+    return (EndpointKey(label) << 32) | (EndpointKey(uint16_t(coord.x)) << 16) | uint16_t(coord.y);
+}
+
+unsigned int mergeFromRight(
+        std::vector<SymbolFeature> &features,
+        EndpointIndex &rightIndex,
+        EndpointIndex::iterator left,
+        EndpointKey rightKey,
+        std::vector<std::vector<Coordinate>> &geom) {
+
+    unsigned int index = left->second;
+    rightIndex.erase(left);
+    rightIndex[rightKey] = index;
+    features[index].geometry[0].pop_back();
+    features[index].geometry[0].insert(features[index].geometry[0].end(), geom[0].begin(), geom[0].end());
+    geom[0].clear();
+    return index;
+}
+
+unsigned int mergeFromLeft(
+        std::vector<SymbolFeature> &features,
+        EndpointIndex &leftIndex,
+        EndpointKey leftKey,
+        EndpointIndex::iterator right,
+        std::vector<std::vector<Coordinate>> &geom) {
+
+    unsigned int index = right->second;
+    leftIndex.erase(right);
+    leftIndex[leftKey] = index;
+    geom[0].pop_back();
+    geom[0].insert(geom[0].end(), features[index].geometry[0].begin(), features[index].geometry[0].end());
+    features[index].geometry[0].clear();
+    std::swap(features[index].geometry[0], geom[0]);
+    return index;
+}
+
+}
+
+void mergeLines(std::vector<SymbolFeature> &features) {
+    std::unordered_map<std::u32string, uint32_t> labels;
+
+    EndpointIndex leftIndex;
+    EndpointIndex rightIndex;
+    leftIndex.reserve(features.size());
+    rightIndex.reserve(features.size());
+
+    for (unsigned int k = 0; k < features.size(); k++) {
+        SymbolFeature &feature = features[k];
+        std::vector<std::vector<Coordinate>> &geometry = feature.geometry;
+
+        if (!feature.label.length()) {
+            continue;
+        }
+
+        const uint32_t label = labels.emplace(feature.label, uint32_t(labels.size())).first->second;
+        const EndpointKey leftKey = getKey(label, geometry, false);
+        const EndpointKey rightKey = getKey(label, geometry, true);
+
+        auto left = rightIndex.find(leftKey);
+        auto right = leftIndex.find(rightKey);
+
+        if ((left != rightIndex.end()) && (right != leftIndex.end()) && (left->second != right->second)) {
+            // found lines with the same text adjacent to both ends of the current line, merge all three
+            unsigned int j = mergeFromLeft(features, leftIndex, leftKey, right, geometry);
+            unsigned int i = mergeFromRight(features, rightIndex, left, rightKey, features[j].geometry);
+
+            leftIndex.erase(leftKey);
+            rightIndex.erase(rightKey);
+            rightIndex[getKey(label, features[i].geometry, true)] = i;
+
+        } else if (left != rightIndex.end()) {
+            // found mergeable line adjacent to the start of the current line, merge
+            mergeFromRight(features, rightIndex, left, rightKey, geometry);
+
+        } else if (right != leftIndex.end()) {
+            // found mergeable line adjacent to the end of the current line, merge
+            mergeFromLeft(features, leftIndex, leftKey, right, geometry);
+
+        } else {
+            // no adjacent lines, add as a new item
+            leftIndex[leftKey] = k;
+            rightIndex[rightKey] = k;
+        }
+    }
+}
+
+} // end namespace util
+} // end namespace mbgl
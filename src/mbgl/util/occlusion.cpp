@@ -0,0 +1,47 @@
+#include <mbgl/util/occlusion.hpp>
+
+#include <set>
+
+namespace mbgl {
+
+namespace {
+
+// Whether the area of /id/ is covered by the tiles in /ids/. Only the parts of the pyramid that
+// lead to one of the tiles are walked.
+bool isCovered(const Tile::ID &id, const std::set<Tile::ID> &ids, const std::set<Tile::ID> &ancestors) {
+    for (const Tile::ID &child : id.children(id.z + 1)) {
+        if (ids.count(child)) {
+            continue;
+        }
+        if (!ancestors.count(child) || !isCovered(child, ids, ancestors)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+bool updateOcclusion(const std::forward_list<Tile *> &tiles) {
+    std::set<Tile::ID> ids;
+    std::set<Tile::ID> ancestors;
+    for (const Tile *tile : tiles) {
+        ids.insert(tile->id);
+        for (int8_t z = tile->id.z - 1; z >= 0; z--) {
+            if (!ancestors.insert(tile->id.parent(z)).second) {
+                // All further ancestors were added by another tile already.
+                break;
+            }
+        }
+    }
+
+    bool overlapping = false;
+    for (Tile *tile : tiles) {
+        const bool covering = ancestors.count(tile->id);
+        tile->occluded = covering && isCovered(tile->id, ids, ancestors);
+        overlapping = overlapping || (covering && !tile->occluded);
+    }
+    return overlapping;
+}
+
+}
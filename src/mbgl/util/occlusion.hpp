@@ -0,0 +1,19 @@
+#ifndef MBGL_UTIL_OCCLUSION
+#define MBGL_UTIL_OCCLUSION
+
+#include <mbgl/map/tile.hpp>
+
+#include <forward_list>
+
+namespace mbgl {
+
+// Marks the tiles whose area is entirely covered by other tiles of the list, e.g. a parent tile
+// that is retained while all of its children are loaded. The stencil mask doesn't let such a tile
+// show anywhere, so the painter can skip it altogether.
+// Returns whether any tile is covered only partly, so that it has to be clipped to the area that
+// the other tiles leave out.
+bool updateOcclusion(const std::forward_list<Tile *> &tiles);
+
+}
+
+#endif
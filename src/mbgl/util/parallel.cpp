@@ -0,0 +1,98 @@
+#include <mbgl/util/parallel.hpp>
+#include <mbgl/util/uv_detail.hpp>
+#include <mbgl/util/allocation_tracker.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace mbgl {
+namespace util {
+
+namespace {
+
+// Shared by the calling thread and the helpers. Helpers that start after the last task was taken
+// find nothing to do, and only keep the group alive until then.
+class TaskGroup {
+public:
+    explicit TaskGroup(const std::vector<std::function<void ()>> &tasks_)
+        : tasks(tasks_), count(tasks_.size()) {}
+
+    // Runs the next task that no thread took yet; returns false if there is none.
+    bool runNext(bool helper) {
+        const size_t i = next++;
+        if (i >= count) {
+            return false;
+        }
+
+        const AllocationTracker::Counts before = AllocationTracker::thread();
+        std::exception_ptr exception;
+        try {
+            tasks[i]();
+        } catch (...) {
+            exception = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (helper) {
+            allocations += AllocationTracker::thread() - before;
+        }
+        if (exception && !error) {
+            error = exception;
+        }
+        if (++finished == count) {
+            done.notify_all();
+        }
+        return true;
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mtx);
+        done.wait(lock, [this] { return finished == count; });
+        AllocationTracker::adopt(allocations);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    // Only read for indices below /count/, which are all taken before wait() returns.
+    const std::vector<std::function<void ()>> &tasks;
+    const size_t count;
+    std::atomic<size_t> next { 0 };
+
+    std::mutex mtx;
+    std::condition_variable done;
+    size_t finished = 0;
+    std::exception_ptr error;
+    AllocationTracker::Counts allocations;
+};
+
+void runHelper(void *data) {
+    std::unique_ptr<std::shared_ptr<TaskGroup>> group(reinterpret_cast<std::shared_ptr<TaskGroup> *>(data));
+    while ((*group)->runNext(true));
+}
+
+}
+
+void runParallel(uv::worker *worker, const std::vector<std::function<void ()>> &tasks) {
+    if (!worker || tasks.size() < 2) {
+        for (const auto &task : tasks) {
+            task();
+        }
+        return;
+    }
+
+    const auto group = std::make_shared<TaskGroup>(tasks);
+    for (size_t i = 1; i < tasks.size(); i++) {
+        worker->addDetached(new std::shared_ptr<TaskGroup>(group), runHelper);
+    }
+
+    while (group->runNext(false));
+    group->wait();
+}
+
+} // end namespace util
+} // end namespace mbgl
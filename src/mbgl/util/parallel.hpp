@@ -0,0 +1,24 @@
+#ifndef MBGL_UTIL_PARALLEL
+#define MBGL_UTIL_PARALLEL
+
+#include <functional>
+#include <vector>
+
+namespace uv {
+class worker;
+}
+
+namespace mbgl {
+namespace util {
+
+// Runs the tasks on the calling thread and on idle threads of /worker/, and returns once all of
+// them finished. The calling thread takes every task that no other thread picked up, so it never
+// waits for a thread to become free; without a worker, it runs all of them. The allocations that
+// other threads made for the tasks count towards the calling thread. If tasks throw, the first
+// exception is rethrown once all tasks finished.
+void runParallel(uv::worker *worker, const std::vector<std::function<void ()>> &tasks);
+
+} // end namespace util
+} // end namespace mbgl
+
+#endif
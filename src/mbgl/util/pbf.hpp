@@ -10,6 +10,13 @@
 
 #include <string>
 #include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace mbgl {
 
@@ -30,6 +37,9 @@ struct pbf {
     template <typename T = uint32_t> inline T varint();
     template <typename T = uint32_t> inline T svarint();
 
+    // Decodes all remaining bytes as packed varints and appends them to values.
+    inline void varints(std::vector<uint32_t>& values);
+
     template <typename T = uint32_t, int bytes = 4> inline T fixed();
     inline float float32();
     inline double float64();
@@ -114,6 +124,55 @@ T pbf::svarint() {
     return (n >> 1) ^ -(T)(n & 1);
 }
 
+namespace detail {
+
+#if defined(__SSE2__) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+// Returns a mask with bit i set if byte i of the 16 byte block has its continuation bit set.
+inline uint32_t continuationMask(const uint8_t *block) {
+#if defined(__SSE2__)
+    return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(block)));
+#else
+    static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    // Spread the high bit of every byte to the whole byte, then keep one distinct bit per lane.
+    const int8x16_t bytes = vreinterpretq_s8_u8(vld1q_u8(block));
+    const uint8x16_t bits = vandq_u8(vreinterpretq_u8_s8(vshrq_n_s8(bytes, 7)), vld1q_u8(weights));
+    uint8x8_t sum = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+    sum = vpadd_u8(sum, sum);
+    sum = vpadd_u8(sum, sum);
+    return vget_lane_u8(sum, 0) | (uint32_t(vget_lane_u8(sum, 1)) << 8);
+#endif
+}
+
+inline uint32_t countTrailingZeros(uint32_t mask) {
+    return __builtin_ctz(mask);
+}
+#endif
+
+}
+
+void pbf::varints(std::vector<uint32_t>& values) {
+    // Every varint is at least one byte long.
+    values.reserve(values.size() + (end - data));
+
+#if defined(__SSE2__) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+    // Most varints in geometries and tags are a single byte. Find runs of them 16 bytes at a
+    // time and only fall back to the byte-wise decoder for the first multi-byte varint.
+    while (end - data >= 16) {
+        const uint32_t mask = detail::continuationMask(data);
+        const uint32_t single = mask ? detail::countTrailingZeros(mask) : 16;
+        values.insert(values.end(), data, data + single);
+        data += single;
+        if (mask) {
+            values.push_back(varint());
+        }
+    }
+#endif
+
+    while (data < end) {
+        values.push_back(varint());
+    }
+}
+
 template <typename T, int bytes>
 T pbf::fixed() {
     skipBytes(bytes);
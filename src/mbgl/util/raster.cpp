@@ -1,23 +1,88 @@
 #include <mbgl/platform/platform.hpp>
 #include <mbgl/platform/gl.hpp>
+#include <mbgl/platform/gl_state.hpp>
 
 #include <mbgl/util/raster.hpp>
+#include <mbgl/util/image_kernels.hpp>
 #include <mbgl/util/time.hpp>
 #include <mbgl/util/uv_detail.hpp>
 #include <mbgl/util/std.hpp>
+#include <mbgl/platform/log.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
 using namespace mbgl;
 
+namespace {
+
+// Beyond that, anisotropic filtering costs more texture fetches than it gains on flat maps.
+const float maxAnisotropy = 4.0f;
+
+bool isPowerOfTwo(uint32_t value) {
+    return value && !(value & (value - 1));
+}
+
+// Averages every 2x2 block of pixels into one. Sides of one pixel stay one pixel.
+std::string downsample(const std::string &rgba, uint32_t width, uint32_t height) {
+    const uint32_t w = std::max(width / 2, 1u);
+    const uint32_t h = std::max(height / 2, 1u);
+    const uint32_t dx = width > 1 ? 1 : 0;
+    const uint32_t dy = height > 1 ? 1 : 0;
+    const uint8_t *src = reinterpret_cast<const uint8_t *>(rgba.data());
+
+    std::string result(size_t(w) * h * 4, '\0');
+    for (uint32_t y = 0; y < h; y++) {
+        const uint8_t *row0 = src + size_t(y * 2) * width * 4;
+        const uint8_t *row1 = row0 + size_t(dy) * width * 4;
+        for (uint32_t x = 0; x < w; x++) {
+            const size_t a = size_t(x * 2) * 4;
+            const size_t b = a + dx * 4;
+            for (size_t c = 0; c < 4; c++) {
+                result[(size_t(y) * w + x) * 4 + c] =
+                    char((row0[a + c] + row0[b + c] + row1[a + c] + row1[b + c] + 2) / 4);
+            }
+        }
+    }
+    return result;
+}
+
+// KTX 1.1 files hold a texture in the layout that OpenGL takes it: a header with the GL enums of
+// its format and its size, then the size and data of every mipmap level.
+const char ktxIdentifier[12] = { '\xAB', 'K', 'T', 'X', ' ', '1', '1', '\xBB', '\r', '\n', '\x1A', '\n' };
+const size_t ktxHeaderSize = 64;
+
+enum KTXField : size_t {
+    Endianness, GLType, GLTypeSize, GLFormat, GLInternalFormat, GLBaseInternalFormat, PixelWidth,
+    PixelHeight, PixelDepth, NumberOfArrayElements, NumberOfFaces, NumberOfMipmapLevels,
+    BytesOfKeyValueData
+};
+
+uint32_t readUInt32(const std::string &data, size_t offset) {
+    uint32_t value;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+}
+
+// Converts the pixels in place: every 16 bit pixel is written over the first half of the 32 bit
+// pixel it came from or of one that was converted before, so no extra buffer is needed.
+void toRGB565(std::string &rgba) {
+    const size_t pixels = rgba.size() / 4;
+    uint8_t *data = reinterpret_cast<uint8_t *>(&rgba[0]);
+    util::convertRGBAToRGB565(data, reinterpret_cast<uint16_t *>(data), pixels);
+    rgba.resize(pixels * 2);
+}
+
+}
+
 Raster::Raster(TexturePool& texturePool_)
     : texturePool(texturePool_)
 {}
 
 Raster::~Raster() {
     if (textured) {
-        texturePool.removeTextureID(texture);
+        texturePool.removeTextureID(texture, storage());
     }
 }
 
@@ -26,43 +91,202 @@ bool Raster::isLoaded() const {
     return loaded;
 }
 
-bool Raster::load(const std::string &data) {
-    img = util::make_unique<util::Image>(data);
-    width = img->getWidth();
-    height = img->getHeight();
+MemoryUsage Raster::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!loaded) {
+        return MemoryUsage();
+    }
+    // Pixels are kept on the CPU until the texture is uploaded, in the same format.
+    return textured ? MemoryUsage(0, bytes) : MemoryUsage(bytes, 0);
+}
+
+bool Raster::loadKTX(const std::string &data) {
+    const auto field = [&data](KTXField index) {
+        return readUInt32(data, sizeof(ktxIdentifier) + index * sizeof(uint32_t));
+    };
+
+    // Only 2D textures with a compressed format, written with the byte order of this machine.
+    if (field(Endianness) != 0x04030201 || field(GLType) != 0 || field(PixelDepth) != 0 ||
+        field(NumberOfArrayElements) != 0 || field(NumberOfFaces) != 1) {
+        Log::Warning(Event::Image, "KTX file doesn't hold a compressed 2D texture");
+        return false;
+    }
+    compressedFormat = field(GLInternalFormat);
+    if (!gl::isCompressedFormatSupported(compressedFormat)) {
+        Log::Warning(Event::Image, "compressed texture format 0x%04X isn't supported", compressedFormat);
+        return false;
+    }
+
+    width = field(PixelWidth);
+    height = field(PixelHeight);
+    const uint32_t count = std::max(field(NumberOfMipmapLevels), 1u);
+    size_t offset = ktxHeaderSize + field(BytesOfKeyValueData);
+    for (uint32_t level = 0; level < count; level++) {
+        if (offset + sizeof(uint32_t) > data.size()) {
+            break;
+        }
+        const size_t size = readUInt32(data, offset);
+        offset += sizeof(uint32_t);
+        if (size > data.size() - offset) {
+            break;
+        }
+        levels.emplace_back(data, offset, size);
+        // Levels are padded to four bytes.
+        offset += (size + 3) & ~size_t(3);
+    }
+    if (!width || !height || levels.size() != count) {
+        Log::Warning(Event::Image, "KTX file is truncated");
+        levels.clear();
+        return false;
+    }
+
+    // OpenGL ES 2 can't limit the levels that are sampled, so anything but a complete chain of
+    // mipmaps for a texture with sides that are powers of two only keeps the base level.
+    uint32_t complete = 1;
+    for (uint32_t side = std::max(width, height); side > 1; side /= 2) {
+        complete++;
+    }
+    if (levels.size() != complete || !isPowerOfTwo(width) || !isPowerOfTwo(height)) {
+        levels.resize(1);
+    }
+
+    format = Format::Compressed;
+    levelCount = uint32_t(levels.size());
+    bytes = 0;
+    for (const std::string &level : levels) {
+        bytes += level.size();
+    }
 
     std::lock_guard<std::mutex> lock(mtx);
-    if (img->getData()) {
-        loaded = true;
+    loaded = true;
+    return loaded;
+}
+
+bool Raster::load(const std::string &data) {
+    if (data.size() >= ktxHeaderSize && std::memcmp(data.data(), ktxIdentifier, sizeof(ktxIdentifier)) == 0) {
+        return loadKTX(data);
+    }
+
+    util::Image img(data);
+    width = img.getWidth();
+    height = img.getHeight();
+    if (!img.getData()) {
+        return false;
+    }
+
+    // The mipmaps are built here so that the render thread only has to upload them. OpenGL ES 2
+    // can't sample mipmaps of textures whose sides aren't powers of two. The decoded pixels
+    // become the first level without a copy.
+    levels.push_back(img.takeData());
+    if (isPowerOfTwo(width) && isPowerOfTwo(height)) {
+        for (uint32_t w = width, h = height; w > 1 || h > 1; w = std::max(w / 2, 1u), h = std::max(h / 2, 1u)) {
+            levels.push_back(downsample(levels.back(), w, h));
+        }
+    }
+
+    const std::string &first = levels.front();
+    if (util::isOpaque(reinterpret_cast<const uint8_t *>(first.data()), first.size() / 4)) {
+        format = Format::RGB565;
+        for (std::string &level : levels) {
+            toRGB565(level);
+        }
+    }
+
+    levelCount = uint32_t(levels.size());
+    bytes = 0;
+    for (const std::string &level : levels) {
+        bytes += level.size();
     }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    loaded = true;
     return loaded;
 }
 
+TexturePool::Storage Raster::storage() const {
+    TexturePool::Storage result;
+    result.width = width;
+    result.height = height;
+    if (format == Format::Compressed) {
+        result.format = compressedFormat;
+        result.type = 0;
+    } else {
+        result.format = format == Format::RGB565 ? GL_RGB : GL_RGBA;
+        result.type = format == Format::RGB565 ? GL_UNSIGNED_SHORT_5_6_5 : GL_UNSIGNED_BYTE;
+    }
+    result.levels = levelCount;
+    result.bytes = bytes;
+    return result;
+}
+
+void Raster::uploadLevels(bool allocated) {
+#ifndef GL_ES_VERSION_2_0
+    MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1));
+#endif
+    MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+    const TexturePool::Storage layout = storage();
+
+    // Rows of 16 bit pixels are only aligned to two bytes.
+    MBGL_CHECK_ERROR(glPixelStorei(GL_UNPACK_ALIGNMENT, format == Format::RGB565 ? 2 : 4));
+    for (uint32_t level = 0; level < levels.size(); level++) {
+        const GLsizei w = std::max(width >> level, 1u);
+        const GLsizei h = std::max(height >> level, 1u);
+        if (format == Format::Compressed) {
+            // Specified anew even in allocated textures: ETC1 can't replace parts of a texture.
+            MBGL_CHECK_ERROR(glCompressedTexImage2D(GL_TEXTURE_2D, level, compressedFormat, w, h, 0,
+                                                    GLsizei(levels[level].size()), levels[level].data()));
+        } else if (allocated) {
+            // Replacing the pixels keeps the storage that the driver already set up.
+            MBGL_CHECK_ERROR(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, layout.format, layout.type, levels[level].data()));
+        } else {
+            MBGL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, level, layout.format, w, h, 0, layout.format, layout.type, levels[level].data()));
+        }
+    }
+    MBGL_CHECK_ERROR(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+
+    levels.clear();
+    levels.shrink_to_fit();
+}
+
+size_t Raster::upload() {
+    if (levels.empty() || textured) {
+        return 0;
+    }
+
+    bool allocated = false;
+    texture = texturePool.getTextureID(storage(), allocated);
+    gl::State::Get().bindTexture(texture);
+    uploadLevels(allocated);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    textured = true;
+    return bytes;
+}
 
 void Raster::bind(bool linear) {
     if (!width || !height) {
-        fprintf(stderr, "trying to bind texture without dimension\n");
+        Log::Warning(Event::OpenGL, "trying to bind texture without dimension");
         return;
     }
 
-    if (img && !textured) {
-        texture = texturePool.getTextureID();
-        MBGL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
-#ifndef GL_ES_VERSION_2_0
-        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
-#endif
-        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-        MBGL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, img->getData()));
-        img.reset();
-        textured = true;
+    if (!levels.empty() && !textured) {
+        upload();
     } else if (textured) {
-        MBGL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, texture));
+        gl::State::Get().bindTexture(texture);
     }
 
     GLuint new_filter = linear ? GL_LINEAR : GL_NEAREST;
     if (new_filter != this->filter) {
-        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, new_filter));
+        // Tiles are drawn smaller than their size while zooming out, and the parent tiles that
+        // stand in for missing ones may be rendered at any fraction of a zoom level.
+        const bool mipmapped = linear && levelCount > 1;
+        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : new_filter));
+        if (gl::maxTextureAnisotropy > 1) {
+            MBGL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+                                             mipmapped ? std::min(gl::maxTextureAnisotropy, maxAnisotropy) : 1.0f));
+        }
         MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, new_filter));
         filter = new_filter;
     }
@@ -70,20 +294,17 @@ void Raster::bind(bool linear) {
 
 // overload ::bind for prerendered raster textures
 void Raster::bind(const GLuint custom_texture) {
-    if (img && !textured) {
-        MBGL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, custom_texture));
-        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-        MBGL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, img->getData()));
-        img.reset();
+    if (!levels.empty() && !textured) {
+        gl::State::Get().bindTexture(custom_texture);
+        uploadLevels(false);
         textured = true;
     } else if (textured) {
-        MBGL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, custom_texture));
+        gl::State::Get().bindTexture(custom_texture);
     }
 
     GLuint new_filter = GL_LINEAR;
     if (new_filter != this->filter) {
-        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, new_filter));
+        MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : new_filter));
         MBGL_CHECK_ERROR(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, new_filter));
         filter = new_filter;
     }
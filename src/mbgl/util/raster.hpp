@@ -5,8 +5,10 @@
 #include <mbgl/util/texture_pool.hpp>
 #include <mbgl/util/image.hpp>
 #include <mbgl/util/ptr.hpp>
+#include <mbgl/util/memory_usage.hpp>
 
 #include <string>
+#include <vector>
 #include <mutex>
 
 typedef struct uv_loop_s uv_loop_t;
@@ -16,12 +18,22 @@ namespace mbgl {
 class Raster : public std::enable_shared_from_this<Raster> {
 
 public:
+    // Opaque images are kept with 16 bits per pixel, since their alpha channel carries nothing.
+    // KTX files stay in the compressed format that they come in.
+    enum class Format : uint8_t { RGBA, RGB565, Compressed };
+
     Raster(TexturePool&);
     ~Raster();
 
-    // load image data
+    // load image data, and convert it to the format and mipmap levels that it is uploaded in. May
+    // be called on a worker thread. Images in a KTX file with a compressed format that the GL
+    // supports are uploaded as they are.
     bool load(const std::string &img);
 
+    // upload the image to a texture without binding it for drawing; returns the number of bytes
+    // uploaded
+    size_t upload();
+
     // bind current texture
     void bind(bool linear = false);
 
@@ -31,6 +43,9 @@ public:
     // loaded status
     bool isLoaded() const;
 
+    // bytes held by the decoded pixels and the uploaded texture
+    MemoryUsage memoryUsage() const;
+
     // transitions
     void beginFadeInTransition();
     bool needsTransition() const;
@@ -40,6 +55,14 @@ public:
     // loaded image dimensions
     uint32_t width = 0, height = 0;
 
+    // pixel format and number of mipmap levels of the texture; images with a side that isn't a
+    // power of two only have the base level
+    Format format = Format::RGBA;
+    uint32_t levelCount = 0;
+
+    // the GL internal format of compressed images
+    uint32_t compressedFormat = 0;
+
     // has been uploaded to texture
     bool textured = false;
 
@@ -50,6 +73,15 @@ public:
     double opacity = 0;
 
 private:
+    bool loadKTX(const std::string &data);
+
+    // the layout of the texture in the texture pool
+    TexturePool::Storage storage() const;
+
+    // specifies all levels of the bound texture; /allocated/ textures already have storage of
+    // this layout
+    void uploadLevels(bool allocated);
+
     mutable std::mutex mtx;
 
     // raw pixels have been loaded
@@ -61,8 +93,11 @@ private:
     // min/mag filter
     uint32_t filter = 0;
 
-    // the raw pixels
-    std::unique_ptr<util::Image> img;
+    // bytes of all levels, on the CPU or the GPU
+    size_t bytes = 0;
+
+    // the pixels of each mipmap level, until they are uploaded
+    std::vector<std::string> levels;
 
     // fade in transition
     util::ptr<util::transition> fade_transition = nullptr;
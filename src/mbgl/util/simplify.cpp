@@ -0,0 +1,72 @@
+#include <mbgl/util/simplify.hpp>
+
+#include <utility>
+
+namespace mbgl {
+namespace util {
+
+// Squared distance of p to the segment from a to b.
+static double segmentDistanceSquared(const Coordinate &p, const Coordinate &a, const Coordinate &b) {
+    double x = a.x, y = a.y;
+    const double dx = b.x - x, dy = b.y - y;
+
+    if (dx != 0 || dy != 0) {
+        const double t = ((p.x - x) * dx + (p.y - y) * dy) / (dx * dx + dy * dy);
+        if (t > 1) {
+            x = b.x;
+            y = b.y;
+        } else if (t > 0) {
+            x += dx * t;
+            y += dy * t;
+        }
+    }
+
+    return (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y);
+}
+
+std::vector<Coordinate> simplify(const std::vector<Coordinate> &line, double tolerance) {
+    if (line.size() <= 2 || tolerance <= 0) {
+        return line;
+    }
+
+    const double toleranceSquared = tolerance * tolerance;
+    std::vector<bool> keep(line.size(), false);
+    keep.front() = keep.back() = true;
+
+    // Ranges of vertices that still need to be checked, without recursion.
+    std::vector<std::pair<size_t, size_t>> stack;
+    stack.emplace_back(0, line.size() - 1);
+
+    while (!stack.empty()) {
+        const size_t first = stack.back().first;
+        const size_t last = stack.back().second;
+        stack.pop_back();
+
+        double maxDistance = 0;
+        size_t index = 0;
+        for (size_t i = first + 1; i < last; i++) {
+            const double distance = segmentDistanceSquared(line[i], line[first], line[last]);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                index = i;
+            }
+        }
+
+        if (maxDistance > toleranceSquared) {
+            keep[index] = true;
+            stack.emplace_back(first, index);
+            stack.emplace_back(index, last);
+        }
+    }
+
+    std::vector<Coordinate> result;
+    for (size_t i = 0; i < line.size(); i++) {
+        if (keep[i]) {
+            result.push_back(line[i]);
+        }
+    }
+    return result;
+}
+
+}
+}
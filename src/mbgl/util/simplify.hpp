@@ -0,0 +1,19 @@
+#ifndef MBGL_UTIL_SIMPLIFY
+#define MBGL_UTIL_SIMPLIFY
+
+#include <mbgl/util/vec.hpp>
+
+#include <vector>
+
+namespace mbgl {
+namespace util {
+
+// Removes the vertices of a line that are closer than /tolerance/ to the line through their
+// neighbours (Douglas-Peucker). The first and the last vertex are always kept, so closed lines
+// stay closed.
+std::vector<Coordinate> simplify(const std::vector<Coordinate> &line, double tolerance);
+
+}
+}
+
+#endif
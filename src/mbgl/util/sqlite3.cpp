@@ -16,14 +16,18 @@ Database::Database(const std::string &filename, int flags) {
 }
 
 Database::Database(Database &&other)
-    : db(std::move(other.db)) {}
+    : db(std::move(other.db)),
+      statements(std::move(other.statements)) {}
 
 Database &Database::operator=(Database &&other) {
     std::swap(db, other.db);
+    std::swap(statements, other.statements);
     return *this;
 }
 
 Database::~Database() {
+    // Statements need to be finalized before we can close the database.
+    statements.clear();
     if (db) {
         const int err = sqlite3_close(db);
         if (err != SQLITE_OK) {
@@ -54,6 +58,32 @@ Statement Database::prepare(const char *query) {
     return std::move(Statement(db, query));
 }
 
+Statement &Database::prepareCached(const char *query) {
+    assert(db);
+    std::unique_ptr<Statement> &stmt = statements[query];
+    if (!stmt) {
+        stmt.reset(new Statement(db, query));
+    } else {
+        stmt->reset();
+        stmt->clearBindings();
+    }
+    return *stmt;
+}
+
+size_t Database::releaseMemory() {
+    assert(db);
+    int before = 0, after = 0, highwater = 0;
+    sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_USED, &before, &highwater, 0);
+    sqlite3_db_release_memory(db);
+    sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_USED, &after, &highwater, 0);
+    return before > after ? before - after : 0;
+}
+
+int Database::changes() const {
+    assert(db);
+    return sqlite3_changes(db);
+}
+
 Statement::Statement(sqlite3 *db, const char *sql) {
     const int err = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
     if (err != SQLITE_OK) {
@@ -156,10 +186,22 @@ template <> std::string Statement::get(int offset) {
     };
 }
 
+const char *Statement::getBlob(int offset, size_t &size) {
+    assert(stmt);
+    const char *blob = reinterpret_cast<const char *>(sqlite3_column_blob(stmt, offset));
+    size = size_t(sqlite3_column_bytes(stmt, offset));
+    return blob;
+}
+
 void Statement::reset() {
     assert(stmt);
     sqlite3_reset(stmt);
 }
 
+void Statement::clearBindings() {
+    assert(stmt);
+    sqlite3_clear_bindings(stmt);
+}
+
 }
 }
@@ -2,6 +2,8 @@
 
 #include <string>
 #include <stdexcept>
+#include <memory>
+#include <unordered_map>
 
 typedef struct sqlite3 sqlite3;
 typedef struct sqlite3_stmt sqlite3_stmt;
@@ -42,8 +44,22 @@ public:
     void exec(const std::string &sql);
     Statement prepare(const char *query);
 
+    // Returns a statement for this query that is compiled only once and then kept around for
+    // the lifetime of the database. The statement is reset and has all bindings cleared when it
+    // is handed out. Callers should reset() it when they're done so that it doesn't hold on to
+    // a read transaction. The cache is not synchronized; use it from one thread only.
+    Statement &prepareCached(const char *query);
+
+    // Frees as much of the page cache of this connection as possible. Returns the number of bytes
+    // freed.
+    size_t releaseMemory();
+
+    // Returns the number of rows that the most recent INSERT, UPDATE or DELETE changed.
+    int changes() const;
+
 private:
     sqlite3 *db = nullptr;
+    std::unordered_map<std::string, std::unique_ptr<Statement>> statements;
 };
 
 class Statement {
@@ -63,8 +79,13 @@ public:
     void bind(int offset, const std::string &value, bool retain = true);
     template <typename T> T get(int offset);
 
+    // Like get<std::string>(), but without copying the value. The pointer is only valid until the
+    // statement is run again or reset.
+    const char *getBlob(int offset, size_t &size);
+
     bool run();
     void reset();
+    void clearBindings();
 
 private:
     sqlite3_stmt *stmt = nullptr;
@@ -0,0 +1,40 @@
+#include <mbgl/util/startup_profiler.hpp>
+
+using namespace mbgl;
+
+const char *StartupProfiler::stageName(Stage stage) {
+    switch (stage) {
+        case Stage::Start: return "start";
+        case Stage::Shaders: return "shaders";
+        case Stage::Style: return "style";
+        case Stage::Sprite: return "sprite";
+        case Stage::Sources: return "sources";
+        case Stage::FirstFrame: return "firstFrame";
+    }
+    return "unknown";
+}
+
+StartupProfiler::StartupProfiler() {
+    reset();
+}
+
+void StartupProfiler::reset() {
+    for (auto &time : times) {
+        time.store(0, std::memory_order_relaxed);
+    }
+}
+
+void StartupProfiler::record(Stage stage) {
+    uint64_t expected = 0;
+    times[size_t(stage)].compare_exchange_strong(expected, util::now(), std::memory_order_acq_rel);
+}
+
+timestamp StartupProfiler::elapsed(Stage stage) const {
+    const uint64_t start = times[size_t(Stage::Start)].load(std::memory_order_acquire);
+    const uint64_t time = times[size_t(stage)].load(std::memory_order_acquire);
+    if (!start || !time) {
+        return 0;
+    }
+    // Stages such as the style may be reached before the map thread starts.
+    return time > start ? time - start : 0;
+}
@@ -10,16 +10,20 @@
 using namespace mbgl::util;
 
 stopwatch::stopwatch(Event event_)
-    : event(event_), start(now()) {}
+    : event(event_), start(now()), scope(traceName()) {}
 
 stopwatch::stopwatch(EventSeverity severity_, Event event_)
-    : severity(severity_), event(event_), start(now()) {}
+    : severity(severity_), event(event_), start(now()), scope(traceName()) {}
 
 stopwatch::stopwatch(const std::string &name_, Event event_)
-    : name(name_), event(event_), start(now()) {}
+    : name(name_), event(event_), start(now()), scope(traceName()) {}
 
 stopwatch::stopwatch(const std::string &name_, EventSeverity severity_, Event event_)
-    : name(name_), severity(severity_), event(event_), start(now()) {}
+    : name(name_), severity(severity_), event(event_), start(now()), scope(traceName()) {}
+
+const char *stopwatch::traceName() const {
+    return name.empty() ? EventClass(event).c_str() : name.c_str();
+}
 
 void stopwatch::report(const std::string &name_) {
     timestamp duration = now() - start;
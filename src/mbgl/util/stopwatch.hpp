@@ -2,6 +2,7 @@
 #define MBGL_UTIL_STOPWATCH
 
 #include <mbgl/platform/event.hpp>
+#include <mbgl/platform/trace.hpp>
 
 #include <string>
 
@@ -19,10 +20,14 @@ public:
     ~stopwatch();
 
 private:
+    // Names the trace scope that spans the lifetime of the stopwatch.
+    const char *traceName() const;
+
     const std::string name;
     EventSeverity severity = EventSeverity::Debug;
     Event event = Event::General;
     uint64_t start;
+    Trace::Scope scope;
 };
 #else
 class stopwatch {
@@ -1,58 +1,68 @@
 #include <mbgl/util/texture_pool.hpp>
+#include <mbgl/platform/gl_state.hpp>
 
-#include <vector>
-
-const int TextureMax = 64;
+#include <iterator>
 
 using namespace mbgl;
 
-GLuint TexturePool::getTextureID() {
-    if (texture_ids.empty()) {
-        GLuint new_texture_ids[TextureMax];
-        MBGL_CHECK_ERROR(glGenTextures(TextureMax, new_texture_ids));
-        for (uint32_t id = 0; id < TextureMax; id++) {
-            texture_ids.insert(new_texture_ids[id]);
+TexturePool::TexturePool(size_t maximumBytes_) : maximumBytes(maximumBytes_) {}
+
+GLuint TexturePool::getTextureID(const Storage &storage, bool &allocated) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        // The newest matching texture is the most likely to still be resident.
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            if (it->storage == storage) {
+                const GLuint id = it->texture;
+                entryBytes -= it->storage.bytes;
+                entries.erase(std::next(it).base());
+                allocated = true;
+                return id;
+            }
         }
     }
 
     GLuint id = 0;
-
-    if (!texture_ids.empty()) {
-        std::set<GLuint>::iterator id_iterator = texture_ids.begin();
-        id = *id_iterator;
-        texture_ids.erase(id_iterator);
-    }
-
+    MBGL_CHECK_ERROR(glGenTextures(1, &id));
+    allocated = false;
     return id;
 }
 
-void TexturePool::removeTextureID(GLuint texture_id) {
-    bool needs_clear = false;
-
-    texture_ids.insert(texture_id);
+void TexturePool::removeTextureID(GLuint texture_id, const Storage &storage) {
+    std::lock_guard<std::mutex> lock(mtx);
+    entries.push_back({ texture_id, storage });
+    entryBytes += storage.bytes;
 
-    if (texture_ids.size() > TextureMax) {
-        needs_clear = true;
-    }
-
-    if (needs_clear) {
-    // TODO: We need to find a better way to deal with texture pool cleanup
-//        clearTextureIDs();
+    // An image that is larger than the pool can't be reused.
+    while (entryBytes > maximumBytes) {
+        abandoned.push_back(entries.front().texture);
+        entryBytes -= entries.front().storage.bytes;
+        entries.erase(entries.begin());
     }
 }
 
 void TexturePool::clearTextureIDs() {
-    std::vector<GLuint> ids_to_remove;
-    ids_to_remove.reserve(texture_ids.size());
+    std::lock_guard<std::mutex> lock(mtx);
+    for (const Entry &entry : entries) {
+        abandoned.push_back(entry.texture);
+    }
+    entries.clear();
+    entryBytes = 0;
+}
 
-    for (std::set<GLuint>::iterator id_iterator = texture_ids.begin();
-         id_iterator != texture_ids.end(); ++id_iterator) {
-        ids_to_remove.push_back(*id_iterator);
+void TexturePool::collect() {
+    std::vector<GLuint> ids;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        ids.swap(abandoned);
     }
 
-    if (!ids_to_remove.empty()) {
-        MBGL_CHECK_ERROR(glDeleteTextures((GLsizei)ids_to_remove.size(), &ids_to_remove[0]));
+    if (!ids.empty()) {
+        gl::State::Get().deleteTextures((GLsizei)ids.size(), ids.data());
     }
+}
 
-    texture_ids.clear();
+MemoryUsage TexturePool::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return MemoryUsage(0, entryBytes);
 }
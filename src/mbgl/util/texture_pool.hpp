@@ -2,22 +2,71 @@
 #define MBGL_UTIL_TEXTUREPOOL
 
 #include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/memory_usage.hpp>
 #include <mbgl/platform/gl.hpp>
 
-#include <set>
+#include <vector>
 #include <mutex>
 
 namespace mbgl {
 
+// Keeps the textures of images that are no longer needed, so that the next image with the same
+// layout can replace their pixels instead of allocating new storage. The pool holds at most
+// maximumBytes; beyond that, the textures that were returned first are deleted.
 class TexturePool : private util::noncopyable {
 
 public:
-    GLuint getTextureID();
-    void removeTextureID(GLuint texture_id);
+    // The layout of a texture: the size of its base level, its pixel format and type, and its
+    // number of mipmap levels.
+    struct Storage {
+        uint32_t width = 0, height = 0;
+        GLenum format = GL_RGBA;
+        GLenum type = GL_UNSIGNED_BYTE;
+        uint32_t levels = 1;
+        // Bytes of all levels.
+        size_t bytes = 0;
+
+        inline bool operator==(const Storage &rhs) const {
+            return width == rhs.width && height == rhs.height && format == rhs.format &&
+                   type == rhs.type && levels == rhs.levels;
+        }
+    };
+
+    explicit TexturePool(size_t maximumBytes = 16 * 1024 * 1024);
+
+    // Returns a texture for an image with the given layout. /allocated/ is set if the texture
+    // already has storage of that layout, so that its levels can be replaced with
+    // glTexSubImage2D. Must be called with the GL context current.
+    GLuint getTextureID(const Storage &storage, bool &allocated);
+
+    // Returns a texture with the given layout to the pool. May be called on any thread.
+    void removeTextureID(GLuint texture_id, const Storage &storage);
+
+    // Drops all textures, e.g. when the system runs low on memory. They are deleted by the next
+    // collect(). May be called on any thread.
     void clearTextureIDs();
 
+    // Deletes the textures that were dropped or exceed the size of the pool. Must be called with
+    // the GL context current.
+    void collect();
+
+    // Bytes held by the textures in the pool until they are reused or deleted.
+    MemoryUsage memoryUsage() const;
+
 private:
-    std::set<GLuint> texture_ids;
+    struct Entry {
+        GLuint texture;
+        Storage storage;
+    };
+
+    const size_t maximumBytes;
+
+    mutable std::mutex mtx;
+    // Oldest first. There are only a few dozen textures in the pool, so they are searched in
+    // order.
+    std::vector<Entry> entries;
+    size_t entryBytes = 0;
+    std::vector<GLuint> abandoned;
 };
 
 }
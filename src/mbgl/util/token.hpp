@@ -3,6 +3,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <algorithm>
 
 namespace mbgl {
@@ -46,6 +47,75 @@ inline std::string replaceTokens(const std::string &source, const std::map<std::
     });
 }
 
+// A string with {tokens} that is split into literal text and token names once, so that it can be
+// filled in for many features without scanning it again.
+class TokenTemplate {
+public:
+    inline explicit TokenTemplate(const std::string &source) {
+        auto pos = source.begin();
+        const auto end = source.end();
+
+        while (pos != end) {
+            auto brace = std::find(pos, end, '{');
+            literal(pos, brace);
+            pos = brace;
+            if (pos != end) {
+                for (brace++; brace != end && tokenReservedChars.find(*brace) == std::string::npos; brace++);
+                if (brace != end && *brace == '}') {
+                    token({ pos + 1, brace });
+                    pos = brace + 1;
+                } else {
+                    literal(pos, brace);
+                    pos = brace;
+                }
+            }
+        }
+    }
+
+    // The distinct token names, in the order of their first occurrence.
+    inline const std::vector<std::string> &tokens() const { return tokens_; }
+
+    // Appends the filled-in template to result. append(i, result) must append the value of tokens()[i].
+    template <typename Append>
+    void render(std::string &result, const Append &append) const {
+        for (const Segment &segment : segments) {
+            if (segment.token == Segment::Literal) {
+                result.append(segment.text);
+            } else {
+                append(segment.token, result);
+            }
+        }
+    }
+
+private:
+    struct Segment {
+        static const size_t Literal = size_t(-1);
+
+        std::string text;
+        size_t token;
+    };
+
+    inline void literal(std::string::const_iterator begin, std::string::const_iterator end) {
+        if (begin == end) return;
+        if (!segments.empty() && segments.back().token == Segment::Literal) {
+            segments.back().text.append(begin, end);
+        } else {
+            segments.push_back({ { begin, end }, Segment::Literal });
+        }
+    }
+
+    inline void token(const std::string &name) {
+        const auto it = std::find(tokens_.begin(), tokens_.end(), name);
+        segments.push_back({ {}, size_t(it - tokens_.begin()) });
+        if (it == tokens_.end()) {
+            tokens_.push_back(name);
+        }
+    }
+
+    std::vector<Segment> segments;
+    std::vector<std::string> tokens_;
+};
+
 } // end namespace util
 } // end namespace mbgl
 
@@ -16,6 +16,8 @@ int uv_chan_init(uv_chan_t *chan) {
         return r;
 
     QUEUE_INIT(&chan->q);
+    chan->size = 0;
+    chan->waiting = 0;
 
     return uv_cond_init(&chan->cond);
 }
@@ -26,6 +28,7 @@ void uv_chan_send(uv_chan_t *chan, void *data) {
 
     uv_mutex_lock(&chan->mutex);
     QUEUE_INSERT_TAIL(&chan->q, &item->active_queue);
+    chan->size++;
     uv_cond_signal(&chan->cond);
     uv_mutex_unlock(&chan->mutex);
 }
@@ -36,19 +39,106 @@ void *uv_chan_receive(uv_chan_t *chan) {
     void *data = NULL;
 
     uv_mutex_lock(&chan->mutex);
+    chan->waiting++;
     while (QUEUE_EMPTY(&chan->q)) {
         uv_cond_wait(&chan->cond, &chan->mutex);
     }
+    chan->waiting--;
 
     head = QUEUE_HEAD(&chan->q);
     item = QUEUE_DATA(head, uv__chan_item_t, active_queue);
     data = item->data;
     QUEUE_REMOVE(head);
+    chan->size--;
     free(item);
     uv_mutex_unlock(&chan->mutex);
     return data;
 }
 
+// Removes the queued item with the lowest priority. Must be called with the mutex held and a
+// non-empty queue.
+static void *uv__chan_take_prioritized(uv_chan_t *chan, uv_chan_priority_cb priority_cb) {
+    uv__chan_item_t *item;
+    uv__chan_item_t *best = NULL;
+    float best_priority = 0;
+    QUEUE *q;
+    void *data = NULL;
+
+    QUEUE_FOREACH(q, &chan->q) {
+        item = QUEUE_DATA(q, uv__chan_item_t, active_queue);
+        const float priority = priority_cb(item->data);
+        if (best == NULL || priority < best_priority) {
+            best = item;
+            best_priority = priority;
+        }
+    }
+
+    data = best->data;
+    QUEUE_REMOVE(&best->active_queue);
+    chan->size--;
+    free(best);
+    return data;
+}
+
+// Evaluates the priorities at the time of receiving, so that items can be
+// re-prioritized while they are queued. Items with equal priority are received
+// in the order they were sent.
+void *uv_chan_receive_prioritized(uv_chan_t *chan, uv_chan_priority_cb priority_cb) {
+    void *data = NULL;
+
+    uv_mutex_lock(&chan->mutex);
+    chan->waiting++;
+    while (QUEUE_EMPTY(&chan->q)) {
+        uv_cond_wait(&chan->cond, &chan->mutex);
+    }
+    chan->waiting--;
+
+    data = uv__chan_take_prioritized(chan, priority_cb);
+    uv_mutex_unlock(&chan->mutex);
+    return data;
+}
+
+int uv_chan_receive_prioritized_timeout(uv_chan_t *chan, uv_chan_priority_cb priority_cb,
+                                        uint64_t timeout, void **data) {
+    const uint64_t deadline = uv_hrtime() + timeout;
+
+    uv_mutex_lock(&chan->mutex);
+    chan->waiting++;
+    while (QUEUE_EMPTY(&chan->q)) {
+        // Wakeups may be spurious, so the remaining time is measured again every time. The result
+        // of the wait doesn't matter: an item that arrived just in time is still taken.
+        const uint64_t now = uv_hrtime();
+        if (now >= deadline) {
+            break;
+        }
+        uv_cond_timedwait(&chan->cond, &chan->mutex, deadline - now);
+    }
+    chan->waiting--;
+
+    if (QUEUE_EMPTY(&chan->q)) {
+        uv_mutex_unlock(&chan->mutex);
+        return -1;
+    }
+
+    *data = uv__chan_take_prioritized(chan, priority_cb);
+    uv_mutex_unlock(&chan->mutex);
+    return 0;
+}
+
+size_t uv_chan_size(uv_chan_t *chan) {
+    uv_mutex_lock(&chan->mutex);
+    const size_t size = chan->size;
+    uv_mutex_unlock(&chan->mutex);
+    return size;
+}
+
+size_t uv_chan_backlog(uv_chan_t *chan) {
+    uv_mutex_lock(&chan->mutex);
+    const size_t backlog = chan->size > chan->waiting ? chan->size - chan->waiting : 0;
+    uv_mutex_unlock(&chan->mutex);
+    return backlog;
+}
+
 void uv_chan_clear(uv_chan_t *chan) {
     uv_mutex_lock(&chan->mutex);
     uv__chan_item_t *item = NULL;
@@ -59,6 +149,7 @@ void uv_chan_clear(uv_chan_t *chan) {
         QUEUE_REMOVE(head);
         free(item);
     }
+    chan->size = 0;
     uv_mutex_unlock(&chan->mutex);
 }
 
@@ -11,15 +11,33 @@ extern "C" {
 
 typedef struct uv_chan_s uv_chan_t;
 
+// Returns the priority of a queued item. Items with lower values are received first.
+typedef float (*uv_chan_priority_cb)(void *data);
+
 struct uv_chan_s {
     uv_mutex_t mutex;
     uv_cond_t cond;
     void *q[2];
+    // Queued items, and receivers that wait for one.
+    size_t size;
+    unsigned int waiting;
 };
 
 int uv_chan_init(uv_chan_t *chan);
 void uv_chan_send(uv_chan_t *chan, void *data);
 void *uv_chan_receive(uv_chan_t *chan);
+void *uv_chan_receive_prioritized(uv_chan_t *chan, uv_chan_priority_cb priority_cb);
+
+// Like uv_chan_receive_prioritized, but gives up when no item arrives within /timeout/
+// nanoseconds. Returns 0 and stores the item in *data, or -1 on timeout.
+int uv_chan_receive_prioritized_timeout(uv_chan_t *chan, uv_chan_priority_cb priority_cb,
+                                        uint64_t timeout, void **data);
+
+// The number of queued items.
+size_t uv_chan_size(uv_chan_t *chan);
+
+// The number of queued items that no waiting receiver is about to take.
+size_t uv_chan_backlog(uv_chan_t *chan);
 void uv_chan_destroy(uv_chan_t *chan);
 
 #ifdef __cplusplus
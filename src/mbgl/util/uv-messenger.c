@@ -1,12 +1,14 @@
 #include <mbgl/util/uv-messenger.h>
-#include <mbgl/util/queue.h>
 
 #include <stdlib.h>
 #include <assert.h>
 
-typedef struct {
+// Messages are pushed onto a lock-free stack, which the loop thread takes as a whole on every
+// wakeup. Producers only wake the loop when they push onto an empty stack; the producer that pushed
+// the first message of a batch sends the wakeup that drains the rest of it.
+typedef struct uv__messenger_item_s {
     void *data;
-    void *queue[2];
+    struct uv__messenger_item_s *next;
 } uv__messenger_item_t;
 
 #if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
@@ -18,38 +20,49 @@ void uv__messenger_callback(uv_async_t *async, int status) {
 void uv__messenger_callback(uv_async_t *async) {
 #endif
     uv_messenger_t *msgr = (uv_messenger_t *)async->data;
-
-    uv__messenger_item_t *item;
-    QUEUE *head;
+    const uint64_t start = msgr->budget ? uv_hrtime() : 0;
 
     while (1) {
-        uv_mutex_lock(&msgr->mutex);
-        if (QUEUE_EMPTY(&msgr->queue)) {
-            uv_mutex_unlock(&msgr->mutex);
-            break;
+        if (!msgr->backlog) {
+            uv__messenger_item_t *batch = (uv__messenger_item_t *)__atomic_exchange_n(&msgr->head, NULL, __ATOMIC_ACQUIRE);
+            if (!batch) {
+                break;
+            }
+
+            // The stack holds the newest message first; deliver them in the order they were sent.
+            uv__messenger_item_t *item = NULL;
+            while (batch) {
+                uv__messenger_item_t *next = batch->next;
+                batch->next = item;
+                item = batch;
+                batch = next;
+            }
+            msgr->backlog = item;
         }
 
-        head = QUEUE_HEAD(&msgr->queue);
-        item = QUEUE_DATA(head, uv__messenger_item_t, queue);
-        QUEUE_REMOVE(head);
-        uv_mutex_unlock(&msgr->mutex);
-
-        msgr->callback(item->data);
-
-        free(item);
+        while (msgr->backlog) {
+            uv__messenger_item_t *item = (uv__messenger_item_t *)msgr->backlog;
+            msgr->backlog = item->next;
+            msgr->callback(item->data);
+            free(item);
+
+            // Leave the rest for the next loop iteration, so that other handles get to run.
+            if (msgr->budget && uv_hrtime() - start >= msgr->budget) {
+                if (msgr->backlog || __atomic_load_n(&msgr->head, __ATOMIC_RELAXED)) {
+                    uv_async_send(&msgr->async);
+                }
+                return;
+            }
+        }
     }
 }
 
 int uv_messenger_init(uv_loop_t *loop, uv_messenger_t *msgr, uv_messenger_cb callback) {
-    int ret = uv_mutex_init(&msgr->mutex);
-    if (ret < 0) {
-        return ret;
-    }
-
     msgr->callback = callback;
     msgr->stop_callback = NULL;
-
-    QUEUE_INIT(&msgr->queue);
+    msgr->head = NULL;
+    msgr->backlog = NULL;
+    msgr->budget = 0;
 
     msgr->async.data = msgr;
     return uv_async_init(loop, &msgr->async, uv__messenger_callback);
@@ -59,11 +72,18 @@ void uv_messenger_send(uv_messenger_t *msgr, void *data) {
     uv__messenger_item_t *item = (uv__messenger_item_t *)malloc(sizeof(uv__messenger_item_t));
     item->data = data;
 
-    uv_mutex_lock(&msgr->mutex);
-    QUEUE_INSERT_TAIL(&msgr->queue, &item->queue);
-    uv_mutex_unlock(&msgr->mutex);
+    void *head = __atomic_load_n(&msgr->head, __ATOMIC_RELAXED);
+    do {
+        item->next = (uv__messenger_item_t *)head;
+    } while (!__atomic_compare_exchange_n(&msgr->head, &head, item, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    if (!head) {
+        uv_async_send(&msgr->async);
+    }
+}
 
-    uv_async_send(&msgr->async);
+void uv_messenger_set_budget(uv_messenger_t *msgr, uint64_t budget) {
+    msgr->budget = budget;
 }
 
 void uv_messenger_ref(uv_messenger_t *msgr) {
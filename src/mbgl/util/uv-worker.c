@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <assert.h>
+#include <math.h>
 
 typedef struct uv__worker_item_s uv__worker_item_t;
 struct uv__worker_item_s {
@@ -10,16 +11,53 @@ struct uv__worker_item_s {
     void *data;
     uv_worker_cb work_cb;
     uv_worker_after_cb after_work_cb;
+    uv_worker_priority_cb priority_cb;
+    // Detached items are freed on the thread that ran them; the loop thread only sees the
+    // requests for more threads that come with them.
+    int detached;
 };
 
+void uv__worker_free_messenger(uv_messenger_t *msgr) {
+    free(msgr);
+}
+
 typedef struct uv__worker_thread_s uv__worker_thread_t;
 struct uv__worker_thread_s {
     uv_worker_t *worker;
     uv_thread_t thread;
 };
 
-void uv__worker_free_messenger(uv_messenger_t *msgr) {
-    free(msgr);
+void uv__worker_thread_loop(void *ptr);
+
+int uv__worker_spawn(uv_worker_t *worker) {
+    uv__worker_thread_t *worker_thread = (uv__worker_thread_t *)malloc(sizeof(uv__worker_thread_t));
+    worker_thread->worker = worker;
+    int ret = uv_thread_create(&worker_thread->thread, uv__worker_thread_loop, worker_thread);
+    if (ret < 0) {
+        free(worker_thread);
+        return ret;
+    }
+    worker->count++;
+    if (worker->count > worker->peak_count) {
+        worker->peak_count = worker->count;
+    }
+    return 0;
+}
+
+// Starts another thread when the queued items outnumber the idle threads.
+void uv__worker_grow(uv_worker_t *worker) {
+    if (worker->count < worker->max_count && uv_chan_backlog(&worker->chan) > 0) {
+        uv__worker_spawn(worker);
+    }
+}
+
+void uv__worker_destroy(uv_worker_t *worker) {
+    uv_chan_destroy(&worker->chan);
+    uv_mutex_destroy(&worker->stats_mutex);
+    uv_messenger_stop(worker->msgr, uv__worker_free_messenger);
+    if (worker->close_cb) {
+        worker->close_cb(worker);
+    }
 }
 
 void uv__worker_thread_finished(uv__worker_thread_t *worker_thread) {
@@ -37,11 +75,16 @@ void uv__worker_thread_finished(uv__worker_thread_t *worker_thread) {
 
     assert(worker->count > 0);
     worker->count--;
-    if (worker->count == 0) {
-        uv_chan_destroy(&worker->chan);
-        uv_messenger_stop(worker->msgr, uv__worker_free_messenger);
-        if (worker->close_cb) {
-            worker->close_cb(worker);
+    if (!worker->close_cb) {
+        // Items that were sent while this thread was exiting may not have found a thread.
+        uv__worker_grow(worker);
+    } else if (worker->count == 0) {
+        // Threads that exit on the termination flag pass it on, so it is the only item left,
+        // unless the last thread went idle right before the worker was closed.
+        if (uv_chan_size(&worker->chan) > 1) {
+            uv__worker_spawn(worker);
+        } else {
+            uv__worker_destroy(worker);
         }
     }
 }
@@ -49,7 +92,13 @@ void uv__worker_thread_finished(uv__worker_thread_t *worker_thread) {
 void uv__worker_after(void *ptr) {
     uv__worker_item_t *item = (uv__worker_item_t *)ptr;
 
-    if (item->work_cb) {
+    if (item->detached) {
+        // A thread sent detached items and asks for threads to take them.
+        uv_worker_t *worker = item->worker;
+        if (!worker->close_cb) {
+            uv__worker_grow(worker);
+        }
+    } else if (item->work_cb) {
         // We are finishing a regular work request.
         if (item->after_work_cb) {
             assert(item->after_work_cb);
@@ -70,6 +119,19 @@ void uv__worker_after(void *ptr) {
     free(item);
 }
 
+float uv__worker_item_priority(void *ptr) {
+    uv__worker_item_t *item = (uv__worker_item_t *)ptr;
+    if (item == NULL) {
+        // The termination flag goes last so that all queued work gets done.
+        return HUGE_VALF;
+    }
+    if (item->detached) {
+        // They help with work that is under way already.
+        return -HUGE_VALF;
+    }
+    return item->priority_cb ? item->priority_cb(item->data) : 0;
+}
+
 void uv__worker_thread_loop(void *ptr) {
     uv__worker_thread_t *worker_thread = (uv__worker_thread_t *)ptr;
     uv_worker_t *worker = worker_thread->worker;
@@ -81,22 +143,49 @@ void uv__worker_thread_loop(void *ptr) {
 #endif
 
     uv__worker_item_t *item = NULL;
-    while ((item = (uv__worker_item_t *)uv_chan_receive(&worker->chan)) != NULL) {
+    for (;;) {
+        if (worker->idle_timeout) {
+            void *data = NULL;
+            if (uv_chan_receive_prioritized_timeout(&worker->chan, uv__worker_item_priority,
+                                                    worker->idle_timeout, &data) < 0) {
+                break;
+            }
+            item = (uv__worker_item_t *)data;
+        } else {
+            item = (uv__worker_item_t *)uv_chan_receive_prioritized(&worker->chan, uv__worker_item_priority);
+        }
+
+        if (item == NULL) {
+            // Make sure to close all other workers too.
+            uv_chan_send(&worker->chan, NULL);
+            break;
+        }
+
         assert(item->work_cb);
+        const uint64_t start = uv_hrtime();
         item->work_cb(item->data);
+        const uint64_t duration = uv_hrtime() - start;
 
-        // Trigger the after callback in the main thread.
-        uv_messenger_send(worker->msgr, item);
-    }
+        uv_mutex_lock(&worker->stats_mutex);
+        worker->completed++;
+        worker->busy_time += duration;
+        uv_mutex_unlock(&worker->stats_mutex);
 
-    // Make sure to close all other workers too.
-    uv_chan_send(&worker->chan, NULL);
+        if (item->detached) {
+            free(item);
+        } else {
+            // Trigger the after callback in the main thread.
+            uv_messenger_send(worker->msgr, item);
+        }
+    }
 
     // Create a new worker item that acts as a terminate flag for this thread.
     item = (uv__worker_item_t *)malloc(sizeof(uv__worker_item_t));
     item->data = worker_thread;
     item->work_cb = NULL;
     item->after_work_cb = NULL;
+    item->priority_cb = NULL;
+    item->detached = 0;
     uv_messenger_send(worker->msgr, item);
 }
 
@@ -107,8 +196,13 @@ int uv_worker_init(uv_worker_t *worker, uv_loop_t *loop, int count, const char *
     worker->loop = loop;
     worker->name = name;
     worker->count = 0;
+    worker->max_count = count > 0 ? count : 1;
+    worker->peak_count = 0;
+    worker->idle_timeout = 0;
     worker->close_cb = NULL;
     worker->active_items = 0;
+    worker->completed = 0;
+    worker->busy_time = 0;
     worker->msgr = (uv_messenger_t *)malloc(sizeof(uv_messenger_t));
     int ret = uv_messenger_init(loop, worker->msgr, uv__worker_after);
     if (ret < 0) {
@@ -119,21 +213,18 @@ int uv_worker_init(uv_worker_t *worker, uv_loop_t *loop, int count, const char *
     ret = uv_chan_init(&worker->chan);
     if (ret < 0) return ret;
 
-    // Initialize all worker threads.
-    int i;
-    for (i = 0; i < count; i++) {
-        uv__worker_thread_t *worker_thread = (uv__worker_thread_t *)malloc(sizeof(uv__worker_thread_t));
-        worker_thread->worker = worker;
-        ret = uv_thread_create(&worker_thread->thread, uv__worker_thread_loop, worker_thread);
-        if (ret < 0) return ret;
-        worker->count++;
-    }
-
-    return 0;
+    // Threads are started once there's work for them.
+    return uv_mutex_init(&worker->stats_mutex);
 }
 
 void uv_worker_send(uv_worker_t *worker, void *data, uv_worker_cb work_cb,
                     uv_worker_after_cb after_work_cb) {
+    uv_worker_send_prioritized(worker, data, work_cb, after_work_cb, NULL);
+}
+
+void uv_worker_send_prioritized(uv_worker_t *worker, void *data, uv_worker_cb work_cb,
+                                uv_worker_after_cb after_work_cb,
+                                uv_worker_priority_cb priority_cb) {
 #ifndef NDEBUG
     assert(uv_thread_self() == worker->thread_id);
 #endif
@@ -147,11 +238,40 @@ void uv_worker_send(uv_worker_t *worker, void *data, uv_worker_cb work_cb,
     item->worker = worker;
     item->work_cb = work_cb;
     item->after_work_cb = after_work_cb;
+    item->priority_cb = priority_cb;
     item->data = data;
+    item->detached = 0;
     uv_chan_send(&worker->chan, item);
     if (worker->active_items++ == 0) {
         uv_messenger_ref(worker->msgr);
     }
+    uv__worker_grow(worker);
+}
+
+void uv_worker_send_detached(uv_worker_t *worker, void *data, uv_worker_cb work_cb) {
+    assert(work_cb);
+
+    uv__worker_item_t *item = (uv__worker_item_t *)malloc(sizeof(uv__worker_item_t));
+    item->worker = worker;
+    item->work_cb = work_cb;
+    item->after_work_cb = NULL;
+    item->priority_cb = NULL;
+    item->data = data;
+    item->detached = 1;
+    uv_chan_send(&worker->chan, item);
+
+    // Threads are only started on the loop thread, so it is asked to start one if no idle thread
+    // is about to take the item. The item may well be done by the time it gets there.
+    if (uv_chan_backlog(&worker->chan) > 0) {
+        uv__worker_item_t *request = (uv__worker_item_t *)malloc(sizeof(uv__worker_item_t));
+        request->worker = worker;
+        request->work_cb = NULL;
+        request->after_work_cb = NULL;
+        request->priority_cb = NULL;
+        request->data = NULL;
+        request->detached = 1;
+        uv_messenger_send(worker->msgr, request);
+    }
 }
 
 void uv_worker_close(uv_worker_t *worker, uv_worker_close_cb close_cb) {
@@ -163,8 +283,40 @@ void uv_worker_close(uv_worker_t *worker, uv_worker_close_cb close_cb) {
     assert(worker->close_cb == NULL);
 
     worker->close_cb = close_cb;
+    if (worker->count == 0) {
+        // All threads exited while they were idle, and all their items are done.
+        uv__worker_destroy(worker);
+        return;
+    }
+
     uv_chan_send(&worker->chan, NULL);
     if (worker->active_items++ == 0) {
         uv_messenger_ref(worker->msgr);
     }
 }
+
+void uv_worker_set_after_work_budget(uv_worker_t *worker, uint64_t budget) {
+    uv_messenger_set_budget(worker->msgr, budget);
+}
+
+void uv_worker_set_idle_timeout(uv_worker_t *worker, uint64_t timeout) {
+#ifndef NDEBUG
+    assert(uv_thread_self() == worker->thread_id);
+#endif
+    // Threads read the timeout without locking.
+    assert(worker->count == 0);
+    worker->idle_timeout = timeout;
+}
+
+void uv_worker_get_stats(uv_worker_t *worker, uv_worker_stats_t *stats) {
+#ifndef NDEBUG
+    assert(uv_thread_self() == worker->thread_id);
+#endif
+    stats->threads = worker->count;
+    stats->peak_threads = worker->peak_count;
+    stats->queued = uv_chan_size(&worker->chan);
+    uv_mutex_lock(&worker->stats_mutex);
+    stats->completed = worker->completed;
+    stats->busy_time = worker->busy_time;
+    uv_mutex_unlock(&worker->stats_mutex);
+}
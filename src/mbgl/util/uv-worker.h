@@ -15,6 +15,20 @@ typedef struct uv_worker_s uv_worker_t;
 typedef void (*uv_worker_cb)(void *data);
 typedef void (*uv_worker_after_cb)(void *data);
 typedef void (*uv_worker_close_cb)(uv_worker_t *worker);
+typedef float (*uv_worker_priority_cb)(void *data);
+
+typedef struct uv_worker_stats_s uv_worker_stats_t;
+
+struct uv_worker_stats_s {
+    // Threads that are running, and the most that ran at once.
+    int threads;
+    int peak_threads;
+    // Items that no thread has picked up yet.
+    size_t queued;
+    // Items that were done, and the nanoseconds that threads spent in their work callbacks.
+    uint64_t completed;
+    uint64_t busy_time;
+};
 
 struct uv_worker_s {
 #ifndef NDEBUG
@@ -24,16 +38,50 @@ struct uv_worker_s {
     uv_messenger_t *msgr;
     uv_chan_t chan;
     const char *name;
+    // Threads that were started and not joined yet, and how many may run at once.
     int count;
+    int max_count;
+    int peak_count;
+    uint64_t idle_timeout;
     uv_worker_close_cb close_cb;
     unsigned int active_items;
+    // Guards completed and busy_time, which the threads update.
+    uv_mutex_t stats_mutex;
+    uint64_t completed;
+    uint64_t busy_time;
 };
 
+// Threads are started when items are sent and no idle thread can take them, up to
+// /count/ threads.
 int uv_worker_init(uv_worker_t *worker, uv_loop_t *loop, int count, const char *name);
 void uv_worker_send(uv_worker_t *worker, void *data, uv_worker_cb work_cb,
                     uv_worker_after_cb after_work_cb);
+
+// Like uv_worker_send, but queued items are picked up in order of the value
+// returned by priority_cb, lowest first. The callback is invoked on a worker
+// thread each time an item is dequeued, so it must be thread-safe. Items sent
+// with uv_worker_send have priority 0.
+void uv_worker_send_prioritized(uv_worker_t *worker, void *data, uv_worker_cb work_cb,
+                                uv_worker_after_cb after_work_cb,
+                                uv_worker_priority_cb priority_cb);
+
+// Queues an item that runs ahead of all other items, and has no after_work_cb. Unlike the other
+// functions, it may be called from any thread, as long as the worker isn't closed before the item
+// ran; typically by an item that hands off parts of its work. Threads are started for it on the
+// next loop iteration, so the sender should be prepared to do the work itself.
+void uv_worker_send_detached(uv_worker_t *worker, void *data, uv_worker_cb work_cb);
 void uv_worker_close(uv_worker_t *worker, uv_worker_close_cb close_cb);
 
+// Limits the time that one loop iteration spends in after_work callbacks, in nanoseconds.
+void uv_worker_set_after_work_budget(uv_worker_t *worker, uint64_t budget);
+
+// Lets threads that had nothing to do for /timeout/ nanoseconds exit; they are started again
+// when there's more work. 0, the default, keeps them running until the worker is closed. Must be
+// called before any items are sent.
+void uv_worker_set_idle_timeout(uv_worker_t *worker, uint64_t timeout);
+
+void uv_worker_get_stats(uv_worker_t *worker, uv_worker_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -72,6 +72,15 @@ public:
         }
     }
 
+    // Whether the handle keeps the loop running.
+    inline void ref() {
+        uv_ref(reinterpret_cast<uv_handle_t*>(a.get()));
+    }
+
+    inline void unref() {
+        uv_unref(reinterpret_cast<uv_handle_t*>(a.get()));
+    }
+
 private:
 #if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
     static void async_cb(uv_async_t* a, int) {
@@ -85,6 +94,47 @@ private:
     std::function<void ()> fn;
 };
 
+class timer : public mbgl::util::noncopyable {
+public:
+    inline timer(uv_loop_t* loop, std::function<void ()> fn_)
+        : t(new uv_timer_t)
+        , fn(fn_)
+    {
+        t->data = this;
+        if (uv_timer_init(loop, t.get()) != 0) {
+            throw std::runtime_error("failed to initialize timer");
+        }
+    }
+
+    inline ~timer() {
+        close(std::move(t));
+    }
+
+    // Calls the function once after the timeout in milliseconds. Starting the timer again replaces
+    // the pending call.
+    inline void start(uint64_t timeout) {
+        if (uv_timer_start(t.get(), timer_cb, timeout, 0) != 0) {
+            throw std::runtime_error("failed to start timer");
+        }
+    }
+
+    inline void stop() {
+        uv_timer_stop(t.get());
+    }
+
+private:
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
+    static void timer_cb(uv_timer_t* t, int) {
+#else
+    static void timer_cb(uv_timer_t* t) {
+#endif
+        reinterpret_cast<timer*>(t->data)->fn();
+    }
+
+    std::unique_ptr<uv_timer_t> t;
+    std::function<void ()> fn;
+};
+
 class rwlock : public mbgl::util::noncopyable {
 public:
     inline rwlock() {
@@ -132,8 +182,29 @@ public:
             delete worker_;
         });
     }
-    inline void add(void *data, uv_worker_cb work_cb, uv_worker_after_cb after_work_cb) {
-        uv_worker_send(w, data, work_cb, after_work_cb);
+    // Nanoseconds per loop iteration that after_work callbacks may take; 0 means no limit.
+    inline void setAfterWorkBudget(uint64_t budget) {
+        uv_worker_set_after_work_budget(w, budget);
+    }
+
+    // Nanoseconds after which threads that have nothing to do exit; 0 keeps them running.
+    inline void setIdleTimeout(uint64_t timeout) {
+        uv_worker_set_idle_timeout(w, timeout);
+    }
+    inline uv_worker_stats_t getStats() const {
+        uv_worker_stats_t stats;
+        uv_worker_get_stats(w, &stats);
+        return stats;
+    }
+
+    inline void add(void *data, uv_worker_cb work_cb, uv_worker_after_cb after_work_cb,
+                    uv_worker_priority_cb priority_cb = nullptr) {
+        uv_worker_send_prioritized(w, data, work_cb, after_work_cb, priority_cb);
+    }
+
+    // May be called from any thread; see uv_worker_send_detached().
+    inline void addDetached(void *data, uv_worker_cb work_cb) {
+        uv_worker_send_detached(w, data, work_cb);
     }
 
 private:
@@ -145,13 +216,17 @@ class work : public mbgl::util::noncopyable {
 public:
     typedef std::function<void (T&)> work_callback;
     typedef std::function<void (T&)> after_work_callback;
+    // Invoked on a worker thread whenever the queue is consulted; lower values run first.
+    typedef std::function<float (T&)> priority_callback;
 
     template<typename... Args>
-    work(worker &worker, work_callback work_cb_, after_work_callback after_work_cb_, Args&&... args)
+    work(worker &worker, work_callback work_cb_, after_work_callback after_work_cb_,
+         priority_callback priority_cb_, Args&&... args)
         : data(std::forward<Args>(args)...),
           work_cb(work_cb_),
-          after_work_cb(after_work_cb_) {
-        worker.add(this, do_work, after_work);
+          after_work_cb(after_work_cb_),
+          priority_cb(priority_cb_) {
+        worker.add(this, do_work, after_work, priority_cb ? get_priority : nullptr);
     }
 
 private:
@@ -166,10 +241,16 @@ private:
         delete w;
     }
 
+    static float get_priority(void *data) {
+        work<T> *w = reinterpret_cast<work<T> *>(data);
+        return w->priority_cb(w->data);
+    }
+
 private:
     T data;
     work_callback work_cb;
     after_work_callback after_work_cb;
+    priority_callback priority_cb;
 };
 
 }
@@ -0,0 +1,61 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/util/allocation_tracker.hpp>
+
+#include <new>
+
+using namespace mbgl;
+
+typedef AllocationTracker::Subsystem Subsystem;
+
+TEST(AllocationTracker, Counts) {
+    AllocationTracker::Counts before, after;
+    after.subsystems[size_t(Subsystem::TileParser)] = AllocationUsage(5, 400);
+    after.subsystems[size_t(Subsystem::Painter)] = AllocationUsage(2, 64);
+    before.subsystems[size_t(Subsystem::TileParser)] = AllocationUsage(3, 100);
+
+    AllocationTracker::Counts sum = after - before;
+    sum += before;
+    EXPECT_EQ(5u, sum[Subsystem::TileParser].count);
+    EXPECT_EQ(400u, sum[Subsystem::TileParser].bytes);
+
+    const auto map = (after - before).toMap();
+    ASSERT_EQ(2u, map.size());
+    EXPECT_EQ(2u, map.at("TileParser").count);
+    EXPECT_EQ(300u, map.at("TileParser").bytes);
+    EXPECT_EQ(64u, map.at("Painter").bytes);
+}
+
+namespace {
+
+// Calls operator new directly, since compilers may leave out the allocations of new expressions.
+void allocate(size_t size) {
+    ::operator delete(::operator new(size));
+}
+
+}
+
+TEST(AllocationTracker, Scopes) {
+    const AllocationTracker::Counts before = AllocationTracker::thread();
+    {
+        AllocationTracker::Scope parser(Subsystem::TileParser);
+        allocate(100);
+        {
+            AllocationTracker::Scope symbols(Subsystem::SymbolBucket);
+            allocate(30);
+        }
+        allocate(20);
+    }
+    const AllocationTracker::Counts counts = AllocationTracker::thread() - before;
+
+    if (AllocationTracker::isEnabled()) {
+        EXPECT_EQ(2u, counts[Subsystem::TileParser].count);
+        EXPECT_EQ(120u, counts[Subsystem::TileParser].bytes);
+        EXPECT_EQ(1u, counts[Subsystem::SymbolBucket].count);
+        EXPECT_EQ(30u, counts[Subsystem::SymbolBucket].bytes);
+        EXPECT_GE(AllocationTracker::total()[Subsystem::TileParser].count, 2u);
+    } else {
+        EXPECT_TRUE(counts.toMap().empty());
+        EXPECT_TRUE(AllocationTracker::total().toMap().empty());
+    }
+}
@@ -0,0 +1,55 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/style/applied_class_properties.hpp>
+#include <mbgl/style/property_key_map.hpp>
+
+#include <vector>
+
+using namespace mbgl;
+
+TEST(AppliedClassProperties, NextTransition) {
+    const PropertyValue value = std::string("value");
+
+    AppliedClassProperties applied;
+    applied.add(ClassID::Default, 0, 0, value);
+    EXPECT_EQ(noTransition, applied.nextTransition(10));
+
+    // A transition that is under way needs a frame right away.
+    applied.add(ClassID::Named, 5, 20, value);
+    EXPECT_EQ(10, applied.nextTransition(10));
+    EXPECT_EQ(noTransition, applied.nextTransition(20));
+
+    // A delayed one only once it starts.
+    applied.add(ClassID::Named, 25, 30, value);
+    EXPECT_EQ(25, applied.nextTransition(20));
+    EXPECT_EQ(28, applied.nextTransition(28));
+    EXPECT_EQ(noTransition, applied.nextTransition(30));
+}
+
+TEST(AppliedClassProperties, PropertyKeyMap) {
+    PropertyKeyMap<PropertyValue> map;
+    EXPECT_TRUE(map.empty());
+
+    map.emplace(PropertyKey::LineWidth, std::string("width"));
+    map.emplace(PropertyKey::FillOpacity, std::string("opacity"));
+    // Existing values are kept, like with std::map.
+    map.emplace(PropertyKey::FillOpacity, std::string("other"));
+    EXPECT_FALSE(map.empty());
+    ASSERT_TRUE(map.find(PropertyKey::FillOpacity));
+    EXPECT_EQ("opacity", map.find(PropertyKey::FillOpacity)->get<std::string>());
+    EXPECT_EQ(nullptr, map.find(PropertyKey::FillColor));
+
+    // Iterates in key order.
+    std::vector<PropertyKey> keys;
+    for (std::pair<PropertyKey, const PropertyValue &> pair : map) {
+        keys.push_back(pair.first);
+    }
+    EXPECT_EQ((std::vector<PropertyKey> { PropertyKey::FillOpacity, PropertyKey::LineWidth }), keys);
+
+    const PropertyKeyMap<PropertyValue> copy(map);
+    map.erase(PropertyKey::FillOpacity);
+    map.erase(PropertyKey::LineWidth);
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ("width", copy.find(PropertyKey::LineWidth)->get<std::string>());
+}
@@ -0,0 +1,37 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/util/arena.hpp>
+
+#include <cstring>
+
+using namespace mbgl;
+
+TEST(Arena, Alignment) {
+    util::Arena arena(256);
+
+    for (size_t size : { 1, 3, 16, 17, 100, 1000 }) {
+        void *ptr = arena.allocate(size);
+        ASSERT_NE(nullptr, ptr);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % util::Arena::alignment);
+        std::memset(ptr, 0xAB, size);
+    }
+}
+
+TEST(Arena, Reset) {
+    util::Arena arena(256);
+
+    for (int i = 0; i < 100; i++) {
+        arena.allocate(64);
+    }
+    const size_t capacity = arena.capacity();
+    EXPECT_LE(6400u, capacity);
+
+    // After a reset, the same workload must not grow the arena any further.
+    arena.reset();
+    EXPECT_EQ(capacity, arena.capacity());
+    for (int i = 0; i < 100; i++) {
+        arena.allocate(64);
+    }
+    EXPECT_EQ(capacity, arena.capacity());
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/platform/async_log.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <cstdarg>
+#include <thread>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+struct Message {
+    EventSeverity severity;
+    Event event;
+    int64_t code;
+    std::string msg;
+};
+
+class TestLogBackend : public LogBackend {
+public:
+    void record(EventSeverity severity, Event event, const std::string &msg) {
+        messages.push_back({ severity, event, 0, msg });
+    }
+
+    void record(EventSeverity severity, Event event, const char* format, ...) {
+        char msg[1024];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(msg, sizeof(msg), format, args);
+        va_end(args);
+        messages.push_back({ severity, event, 0, msg });
+    }
+
+    void record(EventSeverity severity, Event event, int64_t code) {
+        messages.push_back({ severity, event, code, "" });
+    }
+
+    void record(EventSeverity severity, Event event, int64_t code, const std::string &msg) {
+        messages.push_back({ severity, event, code, msg });
+    }
+
+    size_t count(EventSeverity severity, Event event) const {
+        size_t result = 0;
+        for (const Message &message : messages) {
+            if (message.severity == severity && message.event == event) {
+                result++;
+            }
+        }
+        return result;
+    }
+
+    std::vector<Message> messages;
+};
+
+}
+
+TEST(AsyncLog, ForwardsMessages) {
+    auto backend = util::make_unique<TestLogBackend>();
+    const TestLogBackend &log = *backend;
+    AsyncLogBackend async(std::move(backend));
+
+    async.record(EventSeverity::Info, Event::General, "plain");
+    async.record(EventSeverity::Warning, Event::ParseTile, "tile %d/%d/%d", 1, 2, 3);
+    async.record(EventSeverity::Error, Event::HttpRequest, 404);
+    async.record(EventSeverity::Error, Event::HttpRequest, 500, "server error");
+    async.flush();
+
+    ASSERT_EQ(4u, log.messages.size());
+    EXPECT_EQ(EventSeverity::Info, log.messages[0].severity);
+    EXPECT_EQ(Event::General, log.messages[0].event);
+    EXPECT_EQ("plain", log.messages[0].msg);
+    EXPECT_EQ(Event::ParseTile, log.messages[1].event);
+    EXPECT_EQ("tile 1/2/3", log.messages[1].msg);
+    EXPECT_EQ(404, log.messages[2].code);
+    EXPECT_EQ("", log.messages[2].msg);
+    EXPECT_EQ(500, log.messages[3].code);
+    EXPECT_EQ("server error", log.messages[3].msg);
+    EXPECT_EQ(0u, async.dropped());
+}
+
+TEST(AsyncLog, TruncatesLongMessages) {
+    auto backend = util::make_unique<TestLogBackend>();
+    const TestLogBackend &log = *backend;
+    AsyncLogBackend async(std::move(backend));
+
+    async.record(EventSeverity::Info, Event::General, std::string(1000, 'x'));
+    async.flush();
+
+    ASSERT_EQ(1u, log.messages.size());
+    EXPECT_EQ(AsyncLogBackend::maxLength - 1, log.messages[0].msg.size());
+}
+
+TEST(AsyncLog, RateLimitsEvents) {
+    auto backend = util::make_unique<TestLogBackend>();
+    const TestLogBackend &log = *backend;
+    AsyncLogBackend async(std::move(backend), 5);
+
+    for (int i = 0; i < 50; i++) {
+        async.record(EventSeverity::Warning, Event::ParseTile, "warning %d", i);
+        async.record(EventSeverity::Error, Event::ParseTile, "error %d", i);
+    }
+    async.record(EventSeverity::Warning, Event::Render, "other event");
+    async.flush();
+
+    // Unless the second changed in between, the first five warnings went through. Errors aren't
+    // rate limited, and other events have their own limit.
+    EXPECT_LE(5u, log.count(EventSeverity::Warning, Event::ParseTile));
+    EXPECT_GE(12u, log.count(EventSeverity::Warning, Event::ParseTile));
+    EXPECT_EQ(50u, log.count(EventSeverity::Error, Event::ParseTile));
+    EXPECT_EQ(1u, log.count(EventSeverity::Warning, Event::Render));
+    EXPECT_LE(38u, async.dropped());
+}
+
+TEST(AsyncLog, ConcurrentLoggers) {
+    auto backend = util::make_unique<TestLogBackend>();
+    const TestLogBackend &log = *backend;
+    AsyncLogBackend async(std::move(backend), 1000000);
+
+    const int threads = 4;
+    const int messages = 2000;
+    std::vector<std::thread> loggers;
+    for (int i = 0; i < threads; i++) {
+        loggers.emplace_back([&async, i] {
+            for (int j = 0; j < messages; j++) {
+                async.record(EventSeverity::Info, Event::General, "%d:%d", i, j);
+            }
+        });
+    }
+    for (std::thread &logger : loggers) {
+        logger.join();
+    }
+    async.flush();
+
+    // Messages that didn't fit into the buffer are dropped, but none are lost otherwise.
+    EXPECT_EQ(size_t(threads * messages), log.messages.size() + async.dropped());
+    EXPECT_LE(AsyncLogBackend::capacity, log.messages.size());
+}
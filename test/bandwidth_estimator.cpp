@@ -0,0 +1,47 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/storage/bandwidth_estimator.hpp>
+
+using namespace mbgl;
+
+TEST(BandwidthEstimator, Concurrent) {
+    BandwidthEstimator estimator;
+    EXPECT_EQ(0u, estimator.estimate());
+
+    // Two transfers that overlap count the time they share once.
+    estimator.start(0);
+    estimator.start(500_milliseconds);
+    estimator.finish(1_second, 50000);
+    EXPECT_EQ(50000u, estimator.estimate());
+    estimator.finish(2_seconds, 50000);
+    EXPECT_EQ(50000u, estimator.estimate());
+
+    // Idle time doesn't count, but canceled transfers do.
+    estimator.start(10_seconds);
+    estimator.finish(12_seconds, 0);
+    EXPECT_EQ(25000u, estimator.estimate());
+}
+
+TEST(BandwidthEstimator, Minimum) {
+    BandwidthEstimator estimator(10_seconds, 1_second);
+    estimator.start(0);
+    estimator.finish(500_milliseconds, 1000);
+    EXPECT_EQ(0u, estimator.estimate());
+    estimator.start(1_second);
+    estimator.finish(1500_milliseconds, 1000);
+    EXPECT_EQ(2000u, estimator.estimate());
+}
+
+TEST(BandwidthEstimator, Window) {
+    BandwidthEstimator estimator(4_seconds, 1_second);
+
+    // A fast network, then a slow one for a whole window.
+    estimator.start(0);
+    estimator.finish(4_seconds, 4000000);
+    EXPECT_EQ(1000000u, estimator.estimate());
+    for (int i = 0; i < 20; i++) {
+        estimator.start(4_seconds + i * 1_second);
+        estimator.finish(5_seconds + i * 1_second, 1000);
+    }
+    EXPECT_GT(20000u, estimator.estimate());
+}
@@ -0,0 +1,144 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/renderer/bucket_cache.hpp>
+#include <mbgl/style/style_bucket.hpp>
+#include <mbgl/util/io.hpp>
+
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace mbgl;
+
+namespace {
+
+std::string temporaryDirectory() {
+    char path[] = "/tmp/mbgl-bucket-cache-XXXXXX";
+    return mkdtemp(path);
+}
+
+BucketCache::TileKey tileKey(const std::string &data) {
+    BucketCache::TileKey key;
+    key.dataHash = BucketCache::hashData(data);
+    key.dataSize = uint32_t(data.size());
+    key.z = 3;
+    key.depth = 1;
+    key.tileSize = 512;
+    key.triangleElementSize = 6;
+    key.lineElementSize = 4;
+    return key;
+}
+
+CachedBucket::Group group(uint32_t vertices, uint32_t elements, int16_t minX) {
+    CachedBucket::Group result { vertices, elements, ElementBounds() };
+    result.bounds.extend(minX, 10);
+    result.bounds.extend(100, 200);
+    return result;
+}
+
+}
+
+TEST(BucketCache, StoreAndLoad) {
+    const std::string directory = temporaryDirectory();
+    BucketCache cache(directory);
+    const BucketCache::TileKey key = tileKey("tile data");
+
+    EXPECT_FALSE(cache.load(key));
+
+    const std::string vertices = "vertices", triangles = "triangles!!!", lines = "lines";
+    std::vector<std::pair<uint64_t, CachedBucket>> buckets(1);
+    buckets[0].first = 42;
+    buckets[0].second.triangleGroups = {{ group(2, 2, 5) }};
+    buckets[0].second.lineGroups = {{ group(2, 1, 6) }};
+    buckets[0].second.vertices = { vertices.data(), vertices.size() };
+    buckets[0].second.triangles = { triangles.data(), triangles.size() };
+    buckets[0].second.lines = { lines.data(), lines.size() };
+    cache.store(key, buckets, nullptr);
+
+    std::unique_ptr<BucketCache::File> file = cache.load(key);
+    ASSERT_TRUE(file.get());
+    CachedBucket bucket;
+    EXPECT_FALSE(file->find(43, bucket));
+    ASSERT_TRUE(file->find(42, bucket));
+    ASSERT_EQ(1u, bucket.triangleGroups.size());
+    EXPECT_EQ(2u, bucket.triangleGroups[0].vertex_length);
+    EXPECT_EQ(2u, bucket.triangleGroups[0].elements_length);
+    EXPECT_EQ(5, bucket.triangleGroups[0].bounds.minX);
+    EXPECT_EQ(200, bucket.triangleGroups[0].bounds.maxY);
+    ASSERT_EQ(1u, bucket.lineGroups.size());
+    EXPECT_EQ(6, bucket.lineGroups[0].bounds.minX);
+    EXPECT_EQ(vertices, std::string(bucket.vertices.data, bucket.vertices.size));
+    EXPECT_EQ(0u, bucket.colors.size);
+    EXPECT_EQ(triangles, std::string(bucket.triangles.data, bucket.triangles.size));
+    EXPECT_EQ(lines, std::string(bucket.lines.data, bucket.lines.size));
+
+    // Storing other buckets keeps the ones that weren't replaced.
+    const std::string other = "other";
+    std::vector<std::pair<uint64_t, CachedBucket>> more(1);
+    more[0].first = 7;
+    more[0].second.vertices = { other.data(), other.size() };
+    cache.store(key, more, file.get());
+    file.reset();
+
+    file = cache.load(key);
+    ASSERT_TRUE(file.get());
+    ASSERT_TRUE(file->find(42, bucket));
+    EXPECT_EQ(triangles, std::string(bucket.triangles.data, bucket.triangles.size));
+    ASSERT_TRUE(file->find(7, bucket));
+    EXPECT_EQ(other, std::string(bucket.vertices.data, bucket.vertices.size));
+
+    // Tiles with other data, or element sizes of another GL, don't match.
+    EXPECT_FALSE(cache.load(tileKey("other data")));
+    BucketCache::TileKey narrow = key;
+    narrow.triangleElementSize = 3;
+    EXPECT_FALSE(cache.load(narrow));
+}
+
+TEST(BucketCache, Corrupt) {
+    const std::string directory = temporaryDirectory();
+    BucketCache cache(directory);
+    const BucketCache::TileKey key = tileKey("tile data");
+
+    const std::string vertices = "vertices";
+    std::vector<std::pair<uint64_t, CachedBucket>> buckets(1);
+    buckets[0].first = 42;
+    buckets[0].second.vertices = { vertices.data(), vertices.size() };
+    cache.store(key, buckets, nullptr);
+
+    char name[48];
+    snprintf(name, sizeof(name), "/3-%016llx.buckets", (unsigned long long)key.dataHash);
+    const std::string path = directory + name;
+    const std::string data = util::read_file(path);
+
+    // Buckets that reach beyond the end of the file aren't found.
+    util::write_file(path, data.substr(0, data.size() - 2));
+    std::unique_ptr<BucketCache::File> file = cache.load(key);
+    ASSERT_TRUE(file.get());
+    CachedBucket bucket;
+    EXPECT_FALSE(file->find(42, bucket));
+
+    util::write_file(path, "not a bucket cache");
+    EXPECT_FALSE(cache.load(key));
+}
+
+TEST(BucketCache, LayoutHash) {
+    StyleBucket fill(StyleLayerType::Fill);
+    fill.source_layer = "water";
+
+    // Zoom levels and paint properties don't change the geometry.
+    StyleBucket other(StyleLayerType::Fill);
+    other.source_layer = "water";
+    other.min_zoom = 4;
+    EXPECT_EQ(BucketCache::hashLayout(fill), BucketCache::hashLayout(other));
+
+    other.render.get<StyleBucketFill>().winding = WindingType::EvenOdd;
+    EXPECT_NE(BucketCache::hashLayout(fill), BucketCache::hashLayout(other));
+
+    other.render.get<StyleBucketFill>().winding = WindingType::NonZero;
+    other.source_layer = "landuse";
+    EXPECT_NE(BucketCache::hashLayout(fill), BucketCache::hashLayout(other));
+
+    StyleBucket line(StyleLayerType::Line);
+    line.source_layer = "water";
+    EXPECT_NE(BucketCache::hashLayout(fill), BucketCache::hashLayout(line));
+}
@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/geometry/buffer_pool.hpp>
+
+using namespace mbgl;
+
+TEST(BufferPool, SizeClasses) {
+    BufferPool pool;
+
+    size_t size = 1;
+    void *small = pool.allocate(size);
+    EXPECT_EQ(BufferPool::minimumSize, size);
+    pool.release(small, size);
+
+    size = 5000;
+    void *array = pool.allocate(size);
+    EXPECT_EQ(8192u, size);
+    pool.release(array, size);
+    EXPECT_EQ(8192u + BufferPool::minimumSize, pool.memoryUsage());
+
+    // Arrays are reused for all requests of their size class.
+    size = 6000;
+    EXPECT_EQ(array, pool.allocate(size));
+    EXPECT_EQ(8192u, size);
+    EXPECT_EQ(BufferPool::minimumSize, pool.memoryUsage());
+    pool.release(array, size);
+
+    // Larger arrays aren't kept.
+    size = BufferPool::maximumSize + 1;
+    void *large = pool.allocate(size);
+    EXPECT_EQ(BufferPool::maximumSize + 1, size);
+    pool.release(large, size);
+    EXPECT_EQ(8192u + BufferPool::minimumSize, pool.memoryUsage());
+
+    EXPECT_EQ(8192u + BufferPool::minimumSize, pool.clear());
+    EXPECT_EQ(0u, pool.memoryUsage());
+}
+
+TEST(BufferPool, Limit) {
+    BufferPool pool(3 * BufferPool::minimumSize);
+
+    std::vector<void *> arrays;
+    for (int i = 0; i < 4; i++) {
+        size_t size = BufferPool::minimumSize;
+        arrays.push_back(pool.allocate(size));
+    }
+    for (void *array : arrays) {
+        pool.release(array, BufferPool::minimumSize);
+    }
+
+    // The last array didn't fit.
+    EXPECT_EQ(3 * BufferPool::minimumSize, pool.memoryUsage());
+}
@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/renderer/circle_bucket.hpp>
+#include <mbgl/style/style.hpp>
+#include <mbgl/style/style_layer.hpp>
+#include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/util/time.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+const GeometryCollection points = {
+    { { 10, 10 }, { 3000, 3000 } },
+    { { -3, 5 } },
+    // Too far outside of the tile.
+    { { -5000, 0 } },
+};
+
+const char *styleJSON = R"JSON({
+    "version": 6,
+    "sources": {
+        "vehicles": { "type": "vector", "url": "mapbox://vehicles" }
+    },
+    "layers": [{
+        "id": "vehicles",
+        "type": "circle",
+        "source": "vehicles",
+        "source-layer": "position",
+        "paint": { "circle-radius": { "base": 1, "stops": [[10, 2], [20, 12]] }, "circle-color": "#ff0000" }
+    }]
+})JSON";
+
+}
+
+TEST(CircleBucket, Vertices) {
+    CircleVertexBuffer vertices;
+    TriangleElementsBuffer triangles;
+    StyleBucketCircle properties;
+
+    CircleBucket bucket(vertices, triangles, properties, false);
+    EXPECT_FALSE(bucket.hasData());
+    bucket.addGeometry(points);
+    bucket.flush();
+    EXPECT_TRUE(bucket.hasData());
+
+    // Four vertices and two triangles per point.
+    EXPECT_EQ(12u, vertices.index());
+    EXPECT_EQ(6u, triangles.index());
+    EXPECT_EQ(12 * 4 + 6 * 6, bucket.memoryUsage().cpu);
+
+    // Points are sorted by the cell of the tile they're in, and carry the corner in the lowest bit.
+    const int16_t *data = reinterpret_cast<const int16_t *>(vertices.data(0));
+    const std::vector<int16_t> first(data, data + 8);
+    EXPECT_EQ((std::vector<int16_t> { -6, 10, -5, 10, -6, 11, -5, 11 }), first);
+    EXPECT_EQ(20, data[8]);
+    EXPECT_EQ(6000, data[16]);
+}
+
+TEST(CircleBucket, Instances) {
+    CircleVertexBuffer vertices;
+    TriangleElementsBuffer triangles;
+    StyleBucketCircle properties;
+
+    CircleBucket bucket(vertices, triangles, properties, true);
+    bucket.addGeometry(points);
+    bucket.flush();
+
+    // One instance per point, and no elements.
+    EXPECT_EQ(3u, vertices.index());
+    EXPECT_EQ(0u, triangles.index());
+    EXPECT_EQ(3 * 4, bucket.memoryUsage().cpu);
+
+    const int16_t *data = reinterpret_cast<const int16_t *>(vertices.data(0));
+    const std::vector<int16_t> all(data, data + 6);
+    EXPECT_EQ((std::vector<int16_t> { -3, 5, 10, 10, 3000, 3000 }), all);
+}
+
+TEST(CircleBucket, StyleProperties) {
+    Style style;
+    style.loadJSON((const uint8_t *)styleJSON);
+    style.cascadeClasses({});
+    style.updateProperties(15, util::now());
+
+    util::ptr<StyleLayer> layer = style.layers->getLayer("vehicles");
+    ASSERT_TRUE(bool(layer));
+    EXPECT_EQ(StyleLayerType::Circle, layer->type);
+    EXPECT_TRUE(layer->bucket->render.is<StyleBucketCircle>());
+
+    const CircleProperties &properties = layer->getProperties<CircleProperties>();
+    EXPECT_FLOAT_EQ(7.0f, properties.radius);
+    EXPECT_EQ(1.0f, properties.color[0]);
+    EXPECT_EQ(0.0f, properties.color[1]);
+    EXPECT_EQ(1.0f, properties.opacity);
+    EXPECT_TRUE(properties.isVisible());
+}
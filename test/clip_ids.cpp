@@ -249,3 +249,32 @@ TEST(ClipIDs, DuplicateIDs) {
     ASSERT_EQ(ClipID("00000011", "00000010"), sources[1][1]->clip);
     ASSERT_EQ(ClipID("00000011", "00000010"), sources[1][2]->clip);
 }
+
+TEST(ClipIDs, Cache) {
+    std::vector<std::shared_ptr<Tile>> tiles = {
+        std::make_shared<Tile>(Tile::ID { 1, 0, 0 }),
+        std::make_shared<Tile>(Tile::ID { 1, 0, 1 }),
+        std::make_shared<Tile>(Tile::ID { 0, 0, 0 }),
+    };
+    const auto ptrs = [&]() {
+        std::forward_list<Tile *> result;
+        std::transform(tiles.begin(), tiles.end(), std::front_inserter(result), [](const std::shared_ptr<Tile> &tile) { return tile.get(); });
+        return std::vector<std::forward_list<Tile *>> { result };
+    };
+
+    ClipIDCache cache;
+    cache.update(ptrs());
+    const ClipID parent = tiles[2]->clip;
+    ASSERT_EQ(ClipID("00000011", "00000001"), parent);
+
+    // A tile that replaced one with the same ID gets the same clip ID.
+    tiles[2] = std::make_shared<Tile>(Tile::ID { 0, 0, 0 });
+    cache.update(ptrs());
+    ASSERT_EQ(parent, tiles[2]->clip);
+
+    // A new tile makes the cache generate all clip IDs again.
+    tiles.push_back(std::make_shared<Tile>(Tile::ID { 1, 1, 0 }));
+    cache.update(ptrs());
+    ASSERT_EQ(ClipID("00000111", "00000100"), tiles[3]->clip);
+    ASSERT_EQ(ClipID("00000111", "00000001"), tiles[2]->clip);
+}
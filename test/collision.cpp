@@ -0,0 +1,50 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/text/collision.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+GlyphBoxes label(float x, float y) {
+    return {{ GlyphBox(CollisionRect(-50, -10, 50, 10), CollisionAnchor(x, y), 1, 0, 0) }};
+}
+
+}
+
+TEST(Collision, Tile) {
+    Collision collision(1, 4096, 512);
+    EXPECT_EQ(1, collision.getPlacementScale(label(1000, 1000), 1, false));
+    collision.insert(label(1000, 1000), CollisionAnchor(1000, 1000), 1, {{ 2 * M_PI, 0 }}, true);
+
+    // The same label right next to it doesn't fit before the maximum placement scale.
+    EXPECT_EQ(0, collision.getPlacementScale(label(1010, 1000), 1, false));
+    EXPECT_EQ(1, collision.getPlacementScale(label(3000, 1000), 1, false));
+}
+
+TEST(Collision, Neighbors) {
+    const util::ptr<CollisionIndex> index = std::make_shared<CollisionIndex>();
+
+    Collision left(Tile::ID(1, 0, 0), index, 4096, 512);
+    left.insert(label(4090, 100), CollisionAnchor(4090, 100), 1, {{ 2 * M_PI, 0 }}, true);
+    left.insert(label(5, 2000), CollisionAnchor(5, 2000), 1, {{ 2 * M_PI, 0 }}, true);
+
+    // Labels across the edge of the neighboring tile collide, also across the antimeridian.
+    Collision right(Tile::ID(1, 1, 0), index, 4096, 512);
+    EXPECT_EQ(0, right.getPlacementScale(label(5, 100), 1, false));
+    EXPECT_EQ(0, right.getPlacementScale(label(4090, 2000), 1, false));
+    EXPECT_EQ(1, right.getPlacementScale(label(4090, 100), 1, false));
+
+    Collision below(Tile::ID(1, 0, 1), index, 4096, 512);
+    EXPECT_EQ(1, below.getPlacementScale(label(4090, 100), 1, false));
+
+    // Tiles of other zoom levels don't collide.
+    Collision child(Tile::ID(2, 2, 0), index, 4096, 512);
+    EXPECT_EQ(1, child.getPlacementScale(label(5, 100), 1, false));
+
+    // Once the tile is gone, so are its labels.
+    index->remove(Tile::ID(1, 0, 0));
+    Collision replaced(Tile::ID(1, 1, 0), index, 4096, 512);
+    EXPECT_EQ(1, replaced.getPlacementScale(label(5, 100), 1, false));
+}
@@ -0,0 +1,172 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/text/collision_grid.hpp>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wshadow"
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wdeprecated-register"
+#else
+#pragma GCC diagnostic ignored "-Wunused-local-typedefs"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <boost/geometry/index/rtree.hpp>
+#pragma GCC diagnostic pop
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <tuple>
+
+using namespace mbgl;
+
+namespace {
+
+typedef bg::index::rtree<PlacementValue, bg::index::linear<16,4>> RTree;
+
+PlacementValue value(float x, float y, float w, float h) {
+    PlacementBox placement;
+    placement.anchor = CollisionAnchor(x, y);
+    return PlacementValue(Box(Point(x - w / 2, y - h / 2), Point(x + w / 2, y + h / 2)), placement);
+}
+
+// Candidate labels the way a dense city tile at z14 produces them: street names with one box per
+// glyph and wide point labels, some of them reaching over the tile edge.
+std::vector<std::vector<PlacementValue>> labelDenseTile() {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> coord(-256, 4352);
+    std::uniform_real_distribution<float> length(4, 16);
+
+    std::vector<std::vector<PlacementValue>> labels;
+    for (int i = 0; i < 4000; i++) {
+        const float x = coord(gen), y = coord(gen);
+        std::vector<PlacementValue> glyphs;
+        if (i % 5 == 4) {
+            glyphs.push_back(value(x, y, 480, 96));
+        } else {
+            const bool vertical = i % 2;
+            const int count = length(gen);
+            for (int g = 0; g < count; g++) {
+                glyphs.push_back(vertical ? value(x, y + g * 56, 96, 56) : value(x + g * 56, y, 56, 96));
+            }
+        }
+        labels.push_back(std::move(glyphs));
+    }
+    return labels;
+}
+
+bool byBox(const PlacementValue &a, const PlacementValue &b) {
+    const Box &x = a.first, &y = b.first;
+    return std::make_tuple(x.min_corner().get<0>(), x.min_corner().get<1>(), x.max_corner().get<0>(), x.max_corner().get<1>()) <
+           std::make_tuple(y.min_corner().get<0>(), y.min_corner().get<1>(), y.max_corner().get<0>(), y.max_corner().get<1>());
+}
+
+}
+
+TEST(CollisionGrid, Query) {
+    CollisionGrid grid;
+    grid.insert(value(100, 100, 20, 20));
+    grid.insert(value(4000, 4000, 400, 20));
+    grid.insert(value(5000, -100, 20, 20));
+    EXPECT_EQ(3, grid.size());
+
+    std::vector<PlacementValue> result;
+    grid.query(Box(Point(105, 105), Point(200, 200)), result);
+    EXPECT_EQ(1, result.size());
+
+    // Touching counts as intersecting.
+    result.clear();
+    grid.query(Box(Point(110, 0), Point(200, 200)), result);
+    EXPECT_EQ(1, result.size());
+
+    // Boxes that span several cells are reported once.
+    result.clear();
+    grid.query(Box(Point(3700, 3990), Point(4300, 4010)), result);
+    EXPECT_EQ(1, result.size());
+
+    // Boxes outside of the extent are found too.
+    result.clear();
+    grid.query(Box(Point(4990, -120), Point(6000, -90)), result);
+    EXPECT_EQ(1, result.size());
+
+    result.clear();
+    grid.query(Box(Point(1000, 1000), Point(2000, 2000)), result);
+    EXPECT_EQ(0, result.size());
+}
+
+TEST(CollisionGrid, CellCapacity) {
+    // Boxes at one spot overflow the cell and are still found.
+    CollisionGrid grid(4096, 16, 4);
+    for (int i = 0; i < 10; i++) {
+        grid.insert(value(100, 100, 10, 10));
+    }
+    std::vector<PlacementValue> result;
+    grid.query(Box(Point(90, 90), Point(110, 110)), result);
+    EXPECT_EQ(10, result.size());
+}
+
+// Places the labels of a tile the way Collision does: a label is only inserted when none of its
+// glyph boxes intersect an earlier one. Returns the number of placed labels.
+template <typename Index, typename Query>
+size_t place(Index &index, const std::vector<std::vector<PlacementValue>> &labels, Query query) {
+    size_t placed = 0;
+    std::vector<PlacementValue> blocking;
+    for (const std::vector<PlacementValue> &glyphs : labels) {
+        blocking.clear();
+        for (const PlacementValue &glyph : glyphs) {
+            query(index, glyph.first, blocking);
+        }
+        if (blocking.empty()) {
+            index.insert(glyphs.begin(), glyphs.end());
+            placed++;
+        }
+    }
+    return placed;
+}
+
+TEST(CollisionGrid, Benchmark) {
+    using namespace std::chrono;
+    const std::vector<std::vector<PlacementValue>> labels = labelDenseTile();
+    size_t glyphs = 0;
+    for (const std::vector<PlacementValue> &label : labels) {
+        glyphs += label.size();
+    }
+
+    const auto t0 = steady_clock::now();
+    RTree tree;
+    const size_t treePlaced = place(tree, labels, [](RTree &t, const Box &box, std::vector<PlacementValue> &result) {
+        t.query(bg::index::intersects(box), std::back_inserter(result));
+    });
+    const auto t1 = steady_clock::now();
+    CollisionGrid grid;
+    const size_t gridPlaced = place(grid, labels, [](CollisionGrid &g, const Box &box, std::vector<PlacementValue> &result) {
+        g.query(box, result);
+    });
+    const auto t2 = steady_clock::now();
+
+    EXPECT_EQ(treePlaced, gridPlaced);
+    EXPECT_EQ(tree.size(), grid.size());
+
+    // Both indices must find the same boxes.
+    for (const std::vector<PlacementValue> &label : labels) {
+        for (const PlacementValue &glyph : label) {
+            std::vector<PlacementValue> expected, actual;
+            tree.query(bg::index::intersects(glyph.first), std::back_inserter(expected));
+            grid.query(glyph.first, actual);
+            std::sort(expected.begin(), expected.end(), byBox);
+            std::sort(actual.begin(), actual.end(), byBox);
+            ASSERT_EQ(expected.size(), actual.size());
+            for (size_t i = 0; i < expected.size(); i++) {
+                EXPECT_FALSE(byBox(expected[i], actual[i]) || byBox(actual[i], expected[i]));
+            }
+        }
+    }
+
+    auto us = [](steady_clock::duration d) { return duration_cast<microseconds>(d).count(); };
+    std::cout << labels.size() << " labels with " << glyphs << " glyphs, " << gridPlaced << " placed" << std::endl
+              << "rtree: " << us(t1 - t0) << "us" << std::endl
+              << "grid:  " << us(t2 - t1) << "us" << std::endl;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/util/compression.hpp>
+
+#include <zlib.h>
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace mbgl;
+
+namespace {
+
+std::string gzip(const std::string &raw) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // Adding 16 to the window bits writes a gzip header and trailer.
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    std::string result(deflateBound(&stream, uLong(raw.size())) + 32, '\0');
+    stream.next_in = (Bytef *)raw.data();
+    stream.avail_in = uInt(raw.size());
+    stream.next_out = reinterpret_cast<Bytef *>(&result[0]);
+    stream.avail_out = uInt(result.size());
+    deflate(&stream, Z_FINISH);
+    result.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result;
+}
+
+std::string sample(size_t size) {
+    std::string result;
+    for (size_t i = 0; result.size() < size; i++) {
+        result += std::to_string(i * i % 977) + ",";
+    }
+    result.resize(size);
+    return result;
+}
+
+}
+
+TEST(Compression, Zlib) {
+    for (size_t size : { 0, 1, 1000, 100000, 1000000 }) {
+        const std::string raw = sample(size);
+        EXPECT_EQ(raw, util::decompress(util::compress(raw)));
+    }
+}
+
+TEST(Compression, Gzip) {
+    for (size_t size : { 0, 1, 1000, 100000, 1000000 }) {
+        const std::string raw = sample(size);
+        const std::string compressed = gzip(raw);
+        EXPECT_EQ(raw, util::decompress(compressed.data(), compressed.size()));
+    }
+
+    // A wrong size in the trailer is only a hint for the allocation. zlib rejects the stream once it
+    // checks the trailer, but mustn't write past the buffer before that.
+    const std::string raw = sample(100000);
+    std::string compressed = gzip(raw);
+    compressed[compressed.size() - 4] = 1;
+    compressed[compressed.size() - 3] = 0;
+    compressed[compressed.size() - 2] = 0;
+    compressed[compressed.size() - 1] = 0;
+    EXPECT_THROW(util::decompress(compressed), std::runtime_error);
+}
+
+TEST(Compression, Truncated) {
+    const std::string compressed = util::compress(sample(100000));
+    EXPECT_THROW(util::decompress(compressed.substr(0, compressed.size() / 2)), std::runtime_error);
+    EXPECT_THROW(util::decompress("garbage"), std::runtime_error);
+}
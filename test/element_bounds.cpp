@@ -0,0 +1,73 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/geometry/element_bounds.hpp>
+
+#include <cmath>
+
+using namespace mbgl;
+
+namespace {
+
+ElementBounds bounds(int16_t minX, int16_t minY, int16_t maxX, int16_t maxY, float extent = 0) {
+    ElementBounds result;
+    result.extend(minX, minY);
+    result.extend(maxX, maxY);
+    result.extent = extent;
+    return result;
+}
+
+// Maps tile coordinates 1:1 to the pixels of a 100x100 viewport.
+mat4 viewport() {
+    mat4 matrix;
+    matrix::ortho(matrix, 0, 100, 100, 0, 0, 1);
+    return matrix;
+}
+
+}
+
+TEST(ElementBounds, Extend) {
+    ElementBounds a;
+    EXPECT_TRUE(a.empty());
+
+    a.extend(10, -5);
+    EXPECT_FALSE(a.empty());
+    a.extend(bounds(-20, 0, 0, 30, 2));
+    EXPECT_EQ(-20, a.minX);
+    EXPECT_EQ(-5, a.minY);
+    EXPECT_EQ(10, a.maxX);
+    EXPECT_EQ(30, a.maxY);
+    EXPECT_EQ(2, a.extent);
+}
+
+TEST(ElementBounds, Cull) {
+    EXPECT_TRUE(ElementCuller().isVisible(bounds(1000, 1000, 2000, 2000)));
+    EXPECT_FALSE(ElementCuller().isVisible(ElementBounds()));
+
+    const ElementCuller culler(viewport(), 100, 100, 0);
+    EXPECT_TRUE(culler.isVisible(bounds(10, 10, 20, 20)));
+    EXPECT_TRUE(culler.isVisible(bounds(-50, -50, 150, 150)));
+    EXPECT_TRUE(culler.isVisible(bounds(90, 90, 120, 120)));
+    EXPECT_FALSE(culler.isVisible(bounds(110, 10, 120, 20)));
+    EXPECT_FALSE(culler.isVisible(bounds(10, -30, 20, -10)));
+
+    // Geometry that is extruded beyond the bounds still shows.
+    EXPECT_TRUE(ElementCuller(viewport(), 100, 100, 15).isVisible(bounds(110, 10, 120, 20)));
+    EXPECT_TRUE(ElementCuller(viewport(), 100, 100, 0, 2).isVisible(bounds(10, -30, 20, -10, 6)));
+    EXPECT_FALSE(ElementCuller(viewport(), 100, 100, 0, 2).isVisible(bounds(10, -30, 20, -10, 4)));
+}
+
+TEST(ElementBounds, CullRotated) {
+    // Rotates the tile by 45° around the center of the viewport.
+    mat4 matrix = viewport();
+    matrix::translate(matrix, matrix, 50, 50, 0);
+    matrix::rotate_z(matrix, matrix, M_PI / 4);
+    matrix::translate(matrix, matrix, -50, -50, 0);
+    const ElementCuller culler(matrix, 100, 100, 0);
+
+    // The corners of the box are off screen, but its middle isn't.
+    EXPECT_TRUE(culler.isVisible(bounds(-10, 40, 110, 60)));
+    // Corners of the tile rotate out of the viewport.
+    EXPECT_FALSE(culler.isVisible(bounds(0, 0, 10, 10)));
+    EXPECT_TRUE(culler.isVisible(bounds(20, 20, 30, 30)));
+}
@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/map/feature_index.hpp>
+
+using namespace mbgl;
+
+TEST(FeatureIndex, Query) {
+    FeatureIndex index;
+    const uint16_t roads = index.addBucket("roads");
+    const uint16_t water = index.addBucket("water");
+    EXPECT_EQ(roads, index.addBucket("roads"));
+
+    index.insert({ { { 100, 100 }, { 300, 100 } } }, 3, roads);
+    index.insert({ { { 1000, 1000 }, { 1200, 1300 } } }, 5, roads);
+    // Covers the whole tile and goes to the overflow list.
+    index.insert({ { { -10, -10 }, { 4100, -10 }, { 4100, 4100 }, { -10, -10 } } }, 0, water);
+    // A second geometry of the same feature.
+    index.insert({ { { 280, 90 }, { 290, 110 } } }, 3, roads);
+
+    std::vector<uint32_t> result;
+    index.query("roads", 250, 90, 260, 110, result);
+    EXPECT_EQ(std::vector<uint32_t>({ 3 }), result);
+
+    result.clear();
+    index.query("roads", 0, 0, 4096, 4096, result);
+    EXPECT_EQ(std::vector<uint32_t>({ 3, 5 }), result);
+
+    result.clear();
+    index.query("water", 2000, 2000, 2001, 2001, result);
+    EXPECT_EQ(std::vector<uint32_t>({ 0 }), result);
+
+    result.clear();
+    index.query("roads", 2000, 2000, 2001, 2001, result);
+    index.query("missing", 0, 0, 4096, 4096, result);
+    EXPECT_TRUE(result.empty());
+
+    EXPECT_LT(0u, index.memoryUsage());
+}
+
+TEST(FeatureIndex, Intersects) {
+    const GeometryCollection line = { { { 0, 0 }, { 100, 0 } } };
+    EXPECT_TRUE(FeatureIndex::intersects(line, FeatureType::LineString, 50, 5, 5));
+    EXPECT_FALSE(FeatureIndex::intersects(line, FeatureType::LineString, 50, 6, 5));
+    EXPECT_FALSE(FeatureIndex::intersects(line, FeatureType::LineString, 106, 0, 5));
+
+    const GeometryCollection points = { { { 10, 10 } }, { { 50, 50 } } };
+    EXPECT_TRUE(FeatureIndex::intersects(points, FeatureType::Point, 53, 54, 5));
+    EXPECT_FALSE(FeatureIndex::intersects(points, FeatureType::Point, 30, 30, 5));
+
+    // A square with a hole.
+    const GeometryCollection polygon = {
+        { { 0, 0 }, { 100, 0 }, { 100, 100 }, { 0, 100 }, { 0, 0 } },
+        { { 40, 40 }, { 60, 40 }, { 60, 60 }, { 40, 60 }, { 40, 40 } },
+    };
+    EXPECT_TRUE(FeatureIndex::intersects(polygon, FeatureType::Polygon, 20, 20, 1));
+    EXPECT_FALSE(FeatureIndex::intersects(polygon, FeatureType::Polygon, 50, 50, 1));
+    EXPECT_TRUE(FeatureIndex::intersects(polygon, FeatureType::Polygon, 50, 50, 10));
+    EXPECT_FALSE(FeatureIndex::intersects(polygon, FeatureType::Polygon, 150, 50, 10));
+}
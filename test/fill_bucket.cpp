@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/renderer/fill_bucket.hpp>
+#include <mbgl/renderer/bucket_cache.hpp>
+#include <mbgl/util/arena.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+const GeometryCollection square = {
+    { { 0, 0 }, { 100, 0 }, { 100, 100 }, { 0, 100 }, { 0, 0 } },
+};
+
+}
+
+TEST(FillBucket, Outline) {
+    FillVertexBuffer vertices;
+    FillColorBuffer colors;
+    FillFringeBuffer fringes;
+    TriangleElementsBuffer triangles;
+    LineElementsBuffer lines;
+    StyleBucketFill properties;
+    util::Arena arena;
+
+    FillBucket bucket(vertices, colors, fringes, triangles, lines, properties, arena);
+    bucket.addGeometry(square);
+    bucket.flush();
+    EXPECT_FALSE(bucket.hasFringes());
+
+    // The outline is drawn from the vertices of the triangles.
+    EXPECT_EQ(4u, vertices.index());
+    EXPECT_EQ(2u, triangles.index());
+    EXPECT_EQ(4u, lines.index());
+    EXPECT_EQ(0u, fringes.index());
+}
+
+TEST(FillBucket, Fringes) {
+    FillVertexBuffer vertices;
+    FillColorBuffer colors;
+    FillFringeBuffer fringes;
+    TriangleElementsBuffer triangles;
+    LineElementsBuffer lines;
+    StyleBucketFill properties;
+    util::Arena arena;
+
+    FillBucket bucket(vertices, colors, fringes, triangles, lines, properties, arena, true);
+    bucket.addGeometry(square);
+    bucket.flush();
+    EXPECT_TRUE(bucket.hasFringes());
+
+    // Every vertex of the outline has an extruded copy, which is connected to the outline with two
+    // triangles per edge.
+    ASSERT_EQ(8u, vertices.index());
+    ASSERT_EQ(8u, fringes.index());
+    EXPECT_EQ(2u + 8u, triangles.index());
+    EXPECT_EQ(4u, lines.index());
+
+    const int16_t *positions = reinterpret_cast<const int16_t *>(vertices.data(0));
+    const int8_t *extrusions = reinterpret_cast<const int8_t *>(fringes.data(0));
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(0, extrusions[i * 4]);
+        EXPECT_EQ(0, extrusions[i * 4 + 1]);
+
+        // The corners are extruded away from the center of the square, along their miter.
+        const int16_t x = positions[(i + 4) * 2], y = positions[(i + 4) * 2 + 1];
+        EXPECT_EQ(x == 0 ? -63 : 63, extrusions[(i + 4) * 4]);
+        EXPECT_EQ(y == 0 ? -63 : 63, extrusions[(i + 4) * 4 + 1]);
+    }
+}
+
+TEST(FillBucket, CachedFringes) {
+    FillVertexBuffer vertices;
+    FillColorBuffer colors;
+    FillFringeBuffer fringes;
+    TriangleElementsBuffer triangles;
+    LineElementsBuffer lines;
+    StyleBucketFill properties;
+    util::Arena arena;
+
+    FillBucket bucket(vertices, colors, fringes, triangles, lines, properties, arena, true);
+    bucket.addGeometry(square);
+    bucket.flush();
+    CachedBucket cached;
+    bucket.save(cached);
+    EXPECT_EQ(8u * 4, cached.fringes.size);
+
+    // Buckets only load cached geometry with the same kind of antialiasing.
+    FillBucket plain(vertices, colors, fringes, triangles, lines, properties, arena);
+    EXPECT_FALSE(plain.load(cached));
+    FillBucket fringed(vertices, colors, fringes, triangles, lines, properties, arena, true);
+    EXPECT_TRUE(fringed.load(cached));
+    EXPECT_EQ(16u, fringes.index());
+}
+
+TEST(FillBucket, HoleFringes) {
+    FillVertexBuffer vertices;
+    FillColorBuffer colors;
+    FillFringeBuffer fringes;
+    TriangleElementsBuffer triangles;
+    LineElementsBuffer lines;
+    StyleBucketFill properties;
+    util::Arena arena;
+
+    FillBucket bucket(vertices, colors, fringes, triangles, lines, properties, arena, true);
+    bucket.addGeometry({
+        { { 0, 0 }, { 100, 0 }, { 100, 100 }, { 0, 100 }, { 0, 0 } },
+        { { 25, 25 }, { 25, 75 }, { 75, 75 }, { 75, 25 }, { 25, 25 } },
+    });
+    bucket.flush();
+
+    // The fringe of a hole extends into the hole.
+    const int16_t *positions = reinterpret_cast<const int16_t *>(vertices.data(0));
+    const int8_t *extrusions = reinterpret_cast<const int8_t *>(fringes.data(0));
+    size_t extruded = 0;
+    for (size_t i = 0; i < vertices.index(); i++) {
+        const int16_t x = positions[i * 2], y = positions[i * 2 + 1];
+        const int8_t ex = extrusions[i * 4], ey = extrusions[i * 4 + 1];
+        if (ex == 0 && ey == 0) {
+            continue;
+        }
+        extruded++;
+        const int inside = (x == 25 || x == 75) ? -1 : 1;
+        EXPECT_EQ(inside * (x < 50 ? -63 : 63), ex);
+        EXPECT_EQ(inside * (y < 50 ? -63 : 63), ey);
+    }
+    EXPECT_EQ(8u, extruded);
+}
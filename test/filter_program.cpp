@@ -0,0 +1,144 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/map/vector_tile.hpp>
+#include <mbgl/style/filter_expression.hpp>
+#include <mbgl/style/filter_expression_private.hpp>
+#include <mbgl/style/filter_program_private.hpp>
+
+#include <chrono>
+#include <map>
+
+using namespace mbgl;
+
+typedef std::multimap<std::string, mbgl::Value> Properties;
+
+class Extractor {
+public:
+    inline Extractor(const Properties& properties_, FeatureType type_)
+        : properties(properties_)
+        , type(type_)
+    {}
+
+    mapbox::util::optional<Value> getValue(const std::string &key) const {
+        if (key == "$type")
+            return Value(uint64_t(type));
+        auto it = properties.find(key);
+        if (it == properties.end())
+            return mapbox::util::optional<Value>();
+        return it->second;
+    }
+
+private:
+    const Properties properties;
+    FeatureType type;
+};
+
+FilterExpression parse(const char * expression) {
+    rapidjson::Document doc;
+    doc.Parse<0>(expression);
+    return parseFilterExpression(doc);
+}
+
+// Evaluates the filter both as an expression tree and as a compiled program and makes sure
+// they agree.
+bool evaluate(const char * expression, const Properties& properties, FeatureType type = FeatureType::Unknown) {
+    const FilterExpression filter = parse(expression);
+    const Extractor extractor(properties, type);
+    const bool expected = mbgl::evaluate(filter, extractor);
+    EXPECT_EQ(expected, FilterProgram(filter).evaluate(extractor)) << expression;
+    return expected;
+}
+
+TEST(FilterProgram, Empty) {
+    FilterProgram program;
+    ASSERT_TRUE(program.empty());
+    ASSERT_TRUE(program.evaluate(Extractor({{}}, FeatureType::Point)));
+}
+
+TEST(FilterProgram, Comparisons) {
+    const Properties properties = {{ "foo", int64_t(1) }, { "bar", std::string("baz") }, { "big", uint64_t(10) }};
+    ASSERT_TRUE(evaluate("[\"==\", \"foo\", 1]", properties));
+    ASSERT_TRUE(evaluate("[\"==\", \"foo\", 1.0]", properties));
+    ASSERT_FALSE(evaluate("[\"==\", \"foo\", \"1\"]", properties));
+    ASSERT_FALSE(evaluate("[\"!=\", \"foo\", 1]", properties));
+    ASSERT_TRUE(evaluate("[\"!=\", \"missing\", 1]", properties));
+    ASSERT_TRUE(evaluate("[\"<\", \"foo\", 2]", properties));
+    ASSERT_TRUE(evaluate("[\"<=\", \"foo\", 1]", properties));
+    ASSERT_FALSE(evaluate("[\">\", \"foo\", 1]", properties));
+    ASSERT_TRUE(evaluate("[\">=\", \"big\", 1.5]", properties));
+    ASSERT_TRUE(evaluate("[\">\", \"bar\", \"bay\"]", properties));
+    ASSERT_FALSE(evaluate("[\"<\", \"missing\", 1]", properties));
+    ASSERT_TRUE(evaluate("[\"==\", \"$type\", \"Polygon\"]", properties, FeatureType::Polygon));
+    ASSERT_FALSE(evaluate("[\"==\", \"$type\", \"Polygon\"]", properties, FeatureType::Point));
+}
+
+TEST(FilterProgram, Sets) {
+    const Properties properties = {{ "foo", int64_t(1) }, { "bar", std::string("baz") }};
+    ASSERT_TRUE(evaluate("[\"in\", \"foo\", 0, 1, 2]", properties));
+    ASSERT_FALSE(evaluate("[\"in\", \"foo\", 2, 3]", properties));
+    ASSERT_FALSE(evaluate("[\"in\", \"foo\"]", properties));
+    ASSERT_FALSE(evaluate("[\"in\", \"missing\", 1]", properties));
+    ASSERT_TRUE(evaluate("[\"in\", \"bar\", \"qux\", \"baz\"]", properties));
+    ASSERT_FALSE(evaluate("[\"!in\", \"foo\", 0, 1]", properties));
+    ASSERT_TRUE(evaluate("[\"!in\", \"foo\"]", properties));
+    ASSERT_TRUE(evaluate("[\"!in\", \"missing\", 1]", properties));
+}
+
+TEST(FilterProgram, Compound) {
+    const Properties properties = {{ "foo", int64_t(1) }, { "bar", std::string("baz") }};
+    ASSERT_FALSE(evaluate("[\"any\"]", properties));
+    ASSERT_TRUE(evaluate("[\"all\"]", properties));
+    ASSERT_TRUE(evaluate("[\"none\"]", properties));
+    ASSERT_TRUE(evaluate("[\"any\", [\"==\", \"foo\", 0], [\"==\", \"foo\", 1]]", properties));
+    ASSERT_FALSE(evaluate("[\"all\", [\"==\", \"foo\", 0], [\"==\", \"foo\", 1]]", properties));
+    ASSERT_FALSE(evaluate("[\"none\", [\"==\", \"foo\", 0], [\"==\", \"foo\", 1]]", properties));
+    ASSERT_TRUE(evaluate("[\"none\", [\"==\", \"foo\", 0], [\"==\", \"foo\", 2]]", properties));
+    ASSERT_TRUE(evaluate("[\"all\", [\"any\", [\"==\", \"foo\", 0], [\"==\", \"bar\", \"baz\"]], "
+                         "[\"none\", [\"in\", \"foo\", 2, 3]], [\"all\"]]", properties));
+    ASSERT_FALSE(evaluate("[\"any\", [\"all\", [\"==\", \"foo\", 1], [\"==\", \"bar\", \"qux\"]], "
+                          "[\"any\"], [\"none\", [\"all\"]]]", properties));
+}
+
+// Run with --gtest_also_run_disabled_tests to compare the evaluation speed of the expression
+// tree and the compiled program.
+TEST(FilterProgram, DISABLED_Benchmark) {
+    const FilterExpression filter = parse(
+        "[\"all\", [\"==\", \"$type\", \"Point\"], [\"in\", \"class\", \"park\", \"school\", \"hospital\"], "
+        "[\"any\", [\">=\", \"scalerank\", 3], [\"==\", \"name\", \"Central Park\"]], [\"!=\", \"capital\", true]]");
+    const FilterProgram program(filter);
+
+    std::vector<Extractor> features;
+    const char *classes[] = { "park", "school", "shop", "hospital", "bar" };
+    for (int i = 0; i < 1000; ++i) {
+        features.emplace_back(Properties {
+            { "class", std::string(classes[i % 5]) },
+            { "scalerank", int64_t(i % 7) },
+            { "name", std::string(i % 11 ? "Some Street" : "Central Park") },
+            { "capital", bool(i % 13 == 0) }
+        }, i % 3 ? FeatureType::Point : FeatureType::Polygon);
+    }
+
+    const int iterations = 1000;
+    size_t expressionMatches = 0, programMatches = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        for (const auto& feature : features) {
+            expressionMatches += mbgl::evaluate(filter, feature);
+        }
+    }
+    auto expressionTime = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        for (const auto& feature : features) {
+            programMatches += program.evaluate(feature);
+        }
+    }
+    auto programTime = std::chrono::steady_clock::now() - start;
+
+    ASSERT_EQ(expressionMatches, programMatches);
+    std::cerr << "expression: " << std::chrono::duration_cast<std::chrono::microseconds>(expressionTime).count() << "us, "
+              << "program: " << std::chrono::duration_cast<std::chrono::microseconds>(programTime).count() << "us" << std::endl;
+}
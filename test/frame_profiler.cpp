@@ -0,0 +1,50 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/util/frame_profiler.hpp>
+
+using namespace mbgl;
+
+TEST(FrameProfiler, Summary) {
+    FrameProfiler profiler;
+    EXPECT_TRUE(profiler.summarize().empty());
+
+    for (timestamp i = 1; i <= 100; i++) {
+        profiler.record(FrameProfiler::Phase::Upload, i * 1000, i * 1000 + i);
+    }
+    profiler.record(FrameProfiler::Phase::Swap, 0, 5);
+
+    const auto summary = profiler.summarize();
+    ASSERT_EQ(2u, summary.size());
+    EXPECT_EQ(FrameProfiler::Phase::Upload, summary[0].phase);
+    EXPECT_EQ(100u, summary[0].count);
+    EXPECT_EQ(50u, summary[0].p50);
+    EXPECT_EQ(90u, summary[0].p90);
+    EXPECT_EQ(99u, summary[0].p99);
+    EXPECT_EQ(100u, summary[0].max);
+    EXPECT_EQ(FrameProfiler::Phase::Swap, summary[1].phase);
+    EXPECT_EQ(1u, summary[1].count);
+    EXPECT_EQ(5u, summary[1].max);
+}
+
+TEST(FrameProfiler, Wraparound) {
+    FrameProfiler profiler;
+    for (timestamp i = 0; i < 10000; i++) {
+        profiler.record(FrameProfiler::Phase::ClipIDs, i, i + i);
+    }
+
+    // Only the most recent samples are kept.
+    const auto summary = profiler.summarize();
+    ASSERT_EQ(1u, summary.size());
+    EXPECT_EQ(4096u, summary[0].count);
+    EXPECT_EQ(9999u, summary[0].max);
+}
+
+TEST(FrameProfiler, ChromeTrace) {
+    FrameProfiler profiler;
+    EXPECT_EQ("{\"traceEvents\":[]}", profiler.toChromeTrace());
+
+    profiler.record(FrameProfiler::Phase::OpaquePass, 2000, 3500);
+    EXPECT_EQ("{\"traceEvents\":[{\"name\":\"opaquePass\",\"cat\":\"frame\",\"ph\":\"X\","
+              "\"ts\":2.000,\"dur\":1.500,\"pid\":0,\"tid\":0}]}",
+              profiler.toChromeTrace());
+}
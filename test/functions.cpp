@@ -1,4 +1,5 @@
 #include <iostream>
+#include <limits>
 #include "gtest/gtest.h"
 
 #include <mbgl/style/function_properties.hpp>
@@ -56,3 +57,27 @@ TEST(Function, Stops) {
     EXPECT_EQ(4.75, slope_4.evaluate(2.75));
     EXPECT_EQ(10, slope_4.evaluate(8));
 }
+
+TEST(Function, UnsortedStops) {
+    // Stops are found regardless of their order; of stops at the same zoom level, the first wins.
+    mbgl::StopsFunction<float> slope({ { 8, 10 }, { 0, 2 }, { 8, 20 } }, 1);
+    EXPECT_EQ(2, slope.evaluate(-1));
+    EXPECT_EQ(3, slope.evaluate(1));
+    EXPECT_EQ(10, slope.evaluate(8));
+    EXPECT_EQ(10, slope.evaluate(9));
+}
+
+TEST(Function, ConstantRange) {
+    const float inf = std::numeric_limits<float>::infinity();
+
+    mbgl::StopsFunction<float> slope_1({ { 0, 1.5 }, { 6, 1.5 }, { 8, 3 }, { 22, 3 } }, 1.75);
+    EXPECT_EQ(std::make_pair(-inf, 0.0f), slope_1.constantRange(-1));
+    EXPECT_EQ(std::make_pair(0.0f, 6.0f), slope_1.constantRange(4));
+    EXPECT_EQ(std::make_pair(6.0f, 6.0f), slope_1.constantRange(6));
+    EXPECT_EQ(std::make_pair(7.0f, 7.0f), slope_1.constantRange(7));
+    EXPECT_EQ(std::make_pair(8.0f, 22.0f), slope_1.constantRange(15));
+    EXPECT_EQ(std::make_pair(22.0f, inf), slope_1.constantRange(23));
+
+    mbgl::StopsFunction<float> slope_2({}, 1.75);
+    EXPECT_EQ(std::make_pair(-inf, inf), slope_2.constantRange(12));
+}
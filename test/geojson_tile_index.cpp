@@ -0,0 +1,233 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/map/geojson_tile_index.hpp>
+#include <mbgl/map/vector_tile.hpp>
+#include <mbgl/geometry/geometry.hpp>
+#include <mbgl/util/constants.hpp>
+
+#include <cmath>
+
+using namespace mbgl;
+
+namespace {
+
+struct DecodedFeature {
+    uint64_t id;
+    FeatureType type;
+    GeometryCollection geometry;
+    std::vector<std::pair<std::string, Value>> properties;
+};
+
+std::vector<DecodedFeature> decode(const std::shared_ptr<const std::string> &data) {
+    std::vector<DecodedFeature> result;
+    VectorTile tile(data);
+    const auto layer = tile.getLayer(util::geojsonLayerName);
+    if (!layer) {
+        return result;
+    }
+    EXPECT_EQ(4096u, layer->extent);
+
+    GeometryDecoder decoder;
+    pbf features = layer->data;
+    while (features.next(2)) {
+        const VectorTileFeature feature(features.message(), *layer);
+        result.push_back({ feature.id, feature.type, decoder.decode(feature.geometry), {} });
+        for (const auto &tag : feature.tags) {
+            result.back().properties.emplace_back(layer->keys[tag.first], layer->values[tag.second]);
+        }
+    }
+    return result;
+}
+
+const std::string collection = R"JSON({
+    "type": "FeatureCollection",
+    "features": [{
+        "type": "Feature",
+        "id": 1,
+        "properties": { "name": "truck", "speed": 12.5, "count": 3, "offset": -2, "moving": true },
+        "geometry": { "type": "Point", "coordinates": [0, 0] }
+    }, {
+        "type": "Feature",
+        "id": "route",
+        "properties": { "name": "route" },
+        "geometry": { "type": "LineString", "coordinates": [[-10, 10], [10, 10]] }
+    }, {
+        "type": "Feature",
+        "geometry": { "type": "Polygon", "coordinates": [[[-20, -20], [-10, -20], [-10, -10], [-20, -10], [-20, -20]]] }
+    }]
+})JSON";
+
+}
+
+TEST(GeoJSONTileIndex, Features) {
+    GeoJSONTileIndex index(collection);
+    EXPECT_EQ(3u, index.getFeatureCount());
+
+    const std::vector<DecodedFeature> features = decode(index.getTile(Tile::ID(0, 0, 0)));
+    ASSERT_EQ(3u, features.size());
+
+    const DecodedFeature &point = features[0];
+    EXPECT_EQ(1u, point.id);
+    EXPECT_EQ(FeatureType::Point, point.type);
+    ASSERT_EQ(1u, point.geometry.size());
+    ASSERT_EQ(1u, point.geometry[0].size());
+    EXPECT_EQ(Coordinate(2048, 2048), point.geometry[0][0]);
+
+    ASSERT_EQ(5u, point.properties.size());
+    EXPECT_EQ("name", point.properties[0].first);
+    EXPECT_EQ("truck", point.properties[0].second.get<std::string>());
+    EXPECT_EQ(12.5, point.properties[1].second.get<double>());
+    EXPECT_EQ(3u, point.properties[2].second.get<uint64_t>());
+    EXPECT_EQ(-2, point.properties[3].second.get<int64_t>());
+    EXPECT_EQ(true, point.properties[4].second.get<bool>());
+
+    const DecodedFeature &line = features[1];
+    EXPECT_EQ(FeatureType::LineString, line.type);
+    ASSERT_EQ(1u, line.geometry.size());
+    ASSERT_EQ(2u, line.geometry[0].size());
+    EXPECT_EQ(line.geometry[0][0].y, line.geometry[0][1].y);
+    EXPECT_LT(line.geometry[0][1].y, 2048);
+
+    // Rings are closed by the decoder.
+    const DecodedFeature &polygon = features[2];
+    EXPECT_EQ(FeatureType::Polygon, polygon.type);
+    ASSERT_EQ(1u, polygon.geometry.size());
+    ASSERT_EQ(5u, polygon.geometry[0].size());
+    EXPECT_EQ(polygon.geometry[0].front(), polygon.geometry[0].back());
+}
+
+TEST(GeoJSONTileIndex, Clipping) {
+    GeoJSONTileIndex index(collection);
+
+    // The line crosses the prime meridian, which is an edge of the tiles at z3. The point is in
+    // the buffer of both tiles.
+    for (int32_t x : { 3, 4 }) {
+        const std::vector<DecodedFeature> features = decode(index.getTile(Tile::ID(3, x, 3)));
+        ASSERT_EQ(2u, features.size());
+        EXPECT_EQ(FeatureType::Point, features[0].type);
+        EXPECT_EQ(FeatureType::LineString, features[1].type);
+        ASSERT_EQ(1u, features[1].geometry.size());
+        for (const Coordinate &coordinate : features[1].geometry[0]) {
+            EXPECT_GE(coordinate.x, -64);
+            EXPECT_LE(coordinate.x, 4096 + 64);
+        }
+    }
+
+    // Deeper than the index, the tile is clipped out of its ancestor.
+    const std::vector<DecodedFeature> features = decode(index.getTile(Tile::ID(12, 2048, 2048)));
+    ASSERT_EQ(1u, features.size());
+    EXPECT_EQ(Coordinate(0, 0), features[0].geometry[0][0]);
+
+    // A clipped polygon stays closed.
+    const std::vector<DecodedFeature> polygons = decode(index.getTile(Tile::ID(6, 28, 34)));
+    ASSERT_EQ(1u, polygons.size());
+    ASSERT_EQ(1u, polygons[0].geometry.size());
+    EXPECT_EQ(polygons[0].geometry[0].front(), polygons[0].geometry[0].back());
+
+    EXPECT_EQ("", *index.getTile(Tile::ID(4, 0, 0)));
+}
+
+TEST(GeoJSONTileIndex, Simplification) {
+    // A line with a zigzag that is far smaller than a pixel at low zoom levels.
+    std::string coordinates;
+    for (int i = 0; i <= 1000; i++) {
+        coordinates += (i ? ",[" : "[") + std::to_string(i * 0.001) + "," + std::to_string((i % 2) * 0.001) + "]";
+    }
+    GeoJSONTileIndex index(R"({"type":"LineString","coordinates":[)" + coordinates + "]}");
+
+    const std::vector<DecodedFeature> low = decode(index.getTile(Tile::ID(0, 0, 0)));
+    ASSERT_EQ(1u, low.size());
+    EXPECT_EQ(2u, low[0].geometry[0].size());
+
+    const std::vector<DecodedFeature> high = decode(index.getTile(Tile::ID(12, 2048, 2047)));
+    ASSERT_EQ(1u, high.size());
+    EXPECT_LT(50u, high[0].geometry[0].size());
+}
+
+TEST(GeoJSONTileIndex, Update) {
+    auto index = std::make_shared<const GeoJSONTileIndex>(collection);
+    ASSERT_EQ(1u, decode(index->getTile(Tile::ID(12, 2048, 2048))).size());
+
+    GeoJSONTileIndex::Bounds changed;
+    const auto updated = index->update(R"JSON({
+        "type": "FeatureCollection",
+        "features": [
+            { "type": "Feature", "id": 1, "geometry": null },
+            { "type": "Feature", "id": "route", "geometry": { "type": "LineString", "coordinates": [[-10, 20], [10, 20]] } },
+            { "type": "Feature", "geometry": { "type": "Point", "coordinates": [100, 0] } }
+        ]
+    })JSON", changed);
+
+    EXPECT_EQ(3u, updated->getFeatureCount());
+    EXPECT_EQ(3u, index->getFeatureCount());
+
+    // The changes cover the old and the new position of every changed feature.
+    EXPECT_TRUE(changed.intersects(Tile::ID(12, 2048, 2048)));
+    EXPECT_TRUE(changed.intersects(Tile::ID(3, 3, 3)));
+    EXPECT_FALSE(changed.intersects(Tile::ID(6, 28, 34)));
+
+    EXPECT_EQ(0u, decode(updated->getTile(Tile::ID(12, 2048, 2048))).size());
+    EXPECT_EQ(1u, decode(index->getTile(Tile::ID(12, 2048, 2048))).size());
+    EXPECT_EQ(1u, decode(updated->getTile(Tile::ID(6, 28, 34))).size());
+
+    const std::vector<DecodedFeature> features = decode(updated->getTile(Tile::ID(0, 0, 0)));
+    ASSERT_EQ(3u, features.size());
+    EXPECT_EQ(FeatureType::LineString, features[0].type);
+    EXPECT_LT(features[0].geometry[0][0].y, decode(index->getTile(Tile::ID(0, 0, 0)))[1].geometry[0][0].y);
+    EXPECT_EQ(FeatureType::Polygon, features[1].type);
+    EXPECT_EQ(FeatureType::Point, features[2].type);
+}
+
+TEST(GeoJSONTileIndex, InvalidData) {
+    EXPECT_EQ(0u, GeoJSONTileIndex("{").getFeatureCount());
+    EXPECT_EQ(0u, GeoJSONTileIndex(R"({"type":"Point","coordinates":["a"]})").getFeatureCount());
+    EXPECT_EQ(1u, GeoJSONTileIndex(R"JSON({"type":"FeatureCollection","features":[
+        {"type":"Feature","geometry":{"type":"Point","coordinates":[1,2]}},
+        {"type":"Feature","geometry":{"type":"GeometryCollection","geometries":[]}}
+    ]})JSON").getFeatureCount());
+}
+
+TEST(GeoJSONTileIndex, Clusters) {
+    // A hundred points close to each other, and one far away.
+    std::string features = R"({"type":"Feature","id":7,"properties":{"name":"far"},"geometry":{"type":"Point","coordinates":[-100,-40]}})";
+    for (int i = 0; i < 100; i++) {
+        features += R"(,{"type":"Feature","geometry":{"type":"Point","coordinates":[)" +
+                    std::to_string((i % 10) * 0.01) + "," + std::to_string((i / 10) * 0.01) + "]}}";
+    }
+    GeoJSONTileOptions options;
+    options.cluster = true;
+    options.clusterMaxZoom = 4;
+    auto index = std::make_shared<const GeoJSONTileIndex>(R"({"type":"FeatureCollection","features":[)" + features + "]}", options);
+
+    // Clusters are in the order of the points they start with.
+    const std::vector<DecodedFeature> low = decode(index->getTile(Tile::ID(0, 0, 0)));
+    ASSERT_EQ(2u, low.size());
+
+    // Points that aren't merged keep their id and properties.
+    EXPECT_EQ(7u, low[0].id);
+    ASSERT_EQ(1u, low[0].properties.size());
+    EXPECT_EQ("far", low[0].properties[0].second.get<std::string>());
+
+    EXPECT_EQ(FeatureType::Point, low[1].type);
+    ASSERT_EQ(4u, low[1].properties.size());
+    EXPECT_EQ("cluster", low[1].properties[0].first);
+    EXPECT_EQ(true, low[1].properties[0].second.get<bool>());
+    EXPECT_EQ("point_count", low[1].properties[2].first);
+    EXPECT_EQ(100u, low[1].properties[2].second.get<uint64_t>());
+    EXPECT_EQ("100", low[1].properties[3].second.get<std::string>());
+
+    // Below the maximum zoom level of the clusters, the points are in the tiles as they are.
+    const std::vector<DecodedFeature> high = decode(index->getTile(Tile::ID(5, 16, 15)));
+    EXPECT_EQ(100u, high.size());
+    for (const DecodedFeature &feature : high) {
+        EXPECT_TRUE(feature.properties.empty());
+    }
+
+    // Moving a point rebuilds the clusters, which may change anywhere.
+    GeoJSONTileIndex::Bounds changed;
+    const auto updated = index->update(R"({"type":"Feature","id":7,"geometry":{"type":"Point","coordinates":[0.05,0.05]}})", changed);
+    EXPECT_TRUE(changed.intersects(Tile::ID(4, 0, 0)));
+    const std::vector<DecodedFeature> merged = decode(updated->getTile(Tile::ID(0, 0, 0)));
+    ASSERT_EQ(1u, merged.size());
+    EXPECT_EQ(101u, merged[0].properties[2].second.get<uint64_t>());
+}
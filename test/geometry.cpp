@@ -0,0 +1,113 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/geometry/geometry.hpp>
+#include <mbgl/geometry/clip.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+void writeVarint(std::string& buffer, uint32_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(char(value));
+}
+
+uint32_t zigzag(int32_t value) {
+    return (value << 1) ^ (value >> 31);
+}
+
+pbf toPbf(const std::string& buffer) {
+    return pbf(reinterpret_cast<const unsigned char *>(buffer.data()), buffer.size());
+}
+
+}
+
+TEST(Geometry, Varints) {
+    // Long enough to exercise the block decoder, with multi-byte varints at and across block
+    // boundaries.
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < 200; ++i) {
+        expected.push_back(i % 17 == 0 ? i * 1000 : i % 100);
+    }
+    expected.push_back(0xFFFFFFFF);
+
+    std::string buffer;
+    for (uint32_t value : expected) {
+        writeVarint(buffer, value);
+    }
+
+    std::vector<uint32_t> values;
+    pbf data = toPbf(buffer);
+    data.varints(values);
+    EXPECT_EQ(expected, values);
+    EXPECT_FALSE(data);
+}
+
+TEST(Geometry, Decode) {
+    std::string buffer;
+    // A ring with three vertices that is closed, followed by a two vertex line.
+    writeVarint(buffer, (1 << 3) | GeometryDecoder::move_to);
+    writeVarint(buffer, zigzag(10));
+    writeVarint(buffer, zigzag(20));
+    writeVarint(buffer, (2 << 3) | GeometryDecoder::line_to);
+    writeVarint(buffer, zigzag(5));
+    writeVarint(buffer, zigzag(0));
+    writeVarint(buffer, zigzag(-5));
+    writeVarint(buffer, zigzag(-300));
+    writeVarint(buffer, (1 << 3) | GeometryDecoder::close);
+    writeVarint(buffer, (1 << 3) | GeometryDecoder::move_to);
+    writeVarint(buffer, zigzag(100));
+    writeVarint(buffer, zigzag(100));
+    writeVarint(buffer, (1 << 3) | GeometryDecoder::line_to);
+    writeVarint(buffer, zigzag(1));
+    writeVarint(buffer, zigzag(-1));
+
+    GeometryDecoder decoder;
+    const GeometryCollection& lines = decoder.decode(toPbf(buffer));
+
+    ASSERT_EQ(2u, lines.size());
+    EXPECT_EQ((std::vector<Coordinate> {{ 10, 20 }, { 15, 20 }, { 10, -280 }, { 10, 20 }}), lines[0]);
+    EXPECT_EQ((std::vector<Coordinate> {{ 110, -180 }, { 111, -181 }}), lines[1]);
+
+    // Decoding again reuses the collection.
+    EXPECT_EQ(0u, decoder.decode(pbf()).size());
+}
+
+TEST(Geometry, ClipPolygons) {
+    GeometryClipper clipper(0, 100);
+
+    // Geometry that is inside isn't copied.
+    const GeometryCollection inside {{{ 10, 10 }, { 90, 10 }, { 90, 90 }, { 10, 10 }}};
+    EXPECT_EQ(&inside, &clipper.clipPolygons(inside));
+
+    const GeometryCollection rings {
+        {{ -50, 50 }, { 50, -50 }, { 150, 50 }, { 50, 150 }, { -50, 50 }},
+        {{ 200, 200 }, { 300, 200 }, { 300, 300 }, { 200, 200 }},
+    };
+    const GeometryCollection& clipped = clipper.clipPolygons(rings);
+
+    // The ring outside is dropped, the other one stays closed.
+    ASSERT_EQ(1u, clipped.size());
+    EXPECT_EQ((std::vector<Coordinate> {
+        { 0, 100 }, { 0, 0 }, { 100, 0 }, { 100, 100 }, { 0, 100 }
+    }), clipped[0]);
+}
+
+TEST(Geometry, ClipLines) {
+    GeometryClipper clipper(0, 100);
+
+    // A line that leaves and re-enters is split.
+    const GeometryCollection lines {
+        {{ 50, 50 }, { 150, 50 }, { 150, 80 }, { 50, 80 }, { -50, 80 }},
+        {{ -10, -10 }, { -10, 200 }},
+    };
+    const GeometryCollection& clipped = clipper.clipLines(lines);
+
+    ASSERT_EQ(2u, clipped.size());
+    EXPECT_EQ((std::vector<Coordinate> {{ 50, 50 }, { 100, 50 }}), clipped[0]);
+    EXPECT_EQ((std::vector<Coordinate> {{ 100, 80 }, { 50, 80 }, { 0, 80 }}), clipped[1]);
+}
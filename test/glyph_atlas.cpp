@@ -0,0 +1,109 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/geometry/glyph_atlas.hpp>
+#include <mbgl/geometry/shelf_pack.hpp>
+
+using namespace mbgl;
+
+TEST(ShelfPack, Shelves) {
+    ShelfPack<uint16_t> pack(64, 64);
+
+    const Rect<uint16_t> a = pack.allocate(32, 16);
+    const Rect<uint16_t> b = pack.allocate(32, 16);
+    const Rect<uint16_t> c = pack.allocate(16, 16);
+    EXPECT_EQ(0, a.x); EXPECT_EQ(0, a.y);
+    EXPECT_EQ(32, b.x); EXPECT_EQ(0, b.y);
+    EXPECT_EQ(0, c.x); EXPECT_EQ(16, c.y);
+
+    // Slightly lower rectangles share a shelf; much lower ones get their own.
+    const Rect<uint16_t> d = pack.allocate(16, 12);
+    EXPECT_EQ(16, d.x); EXPECT_EQ(16, d.y);
+    const Rect<uint16_t> e = pack.allocate(16, 4);
+    EXPECT_EQ(0, e.x); EXPECT_EQ(32, e.y);
+
+    // Released space is reused by rectangles of the same height.
+    pack.release(a);
+    const Rect<uint16_t> f = pack.allocate(32, 16);
+    EXPECT_EQ(0, f.x); EXPECT_EQ(0, f.y);
+
+    EXPECT_FALSE(pack.allocate(65, 4));
+    EXPECT_FALSE(pack.allocate(16, 32));
+}
+
+TEST(ShelfPack, NoFragmentation) {
+    // Filling the whole area and releasing everything in random order makes all of it available
+    // again.
+    ShelfPack<uint16_t> pack(64, 64);
+    std::vector<Rect<uint16_t>> rects;
+    for (int i = 0; i < 16; i++) {
+        rects.push_back(pack.allocate(16, 16));
+        ASSERT_TRUE(rects.back());
+    }
+    EXPECT_FALSE(pack.allocate(16, 16));
+
+    for (size_t i : { 5, 0, 15, 6, 1, 7, 9, 2, 12, 10, 3, 14, 8, 11, 4, 13 }) {
+        pack.release(rects[i]);
+    }
+
+    const Rect<uint16_t> all = pack.allocate(64, 64);
+    EXPECT_EQ(0, all.x);
+    EXPECT_EQ(0, all.y);
+    EXPECT_EQ(64, all.w);
+}
+
+namespace {
+
+SDFGlyphRef glyph(uint32_t id) {
+    static const std::string bitmap(14 * 14, '\x7F');
+    SDFGlyphRef sdf;
+    sdf.id = id;
+    // Packed as 16x16 pixels, including the buffer.
+    sdf.metrics.width = 8;
+    sdf.metrics.height = 8;
+    sdf.bitmap = bitmap.data();
+    sdf.bitmapSize = uint32_t(bitmap.size());
+    return sdf;
+}
+
+}
+
+TEST(GlyphAtlas, Evict) {
+    GlyphAtlas atlas(64, 64);
+    for (uint32_t i = 0; i < 16; i++) {
+        EXPECT_TRUE(atlas.addGlyph(1, "Font", glyph(i)));
+    }
+    EXPECT_FALSE(atlas.addGlyph(2, "Font", glyph(16)));
+
+    // Glyphs of removed tiles stay until the space is needed.
+    const Rect<uint16_t> kept = atlas.addGlyph(2, "Font", glyph(3));
+    atlas.removeGlyphs(1);
+    const Rect<uint16_t> again = atlas.addGlyph(3, "Font", glyph(5));
+    EXPECT_TRUE(again);
+
+    for (uint32_t i = 16; i < 30; i++) {
+        EXPECT_TRUE(atlas.addGlyph(4, "Font", glyph(i)));
+    }
+
+    // Glyphs that are still in use are never evicted.
+    const Rect<uint16_t> still = atlas.addGlyph(2, "Font", glyph(3));
+    EXPECT_EQ(kept.x, still.x);
+    EXPECT_EQ(kept.y, still.y);
+    EXPECT_FALSE(atlas.addGlyph(4, "Font", glyph(30)));
+}
+
+TEST(GlyphAtlas, FontStacks) {
+    GlyphAtlas atlas(64, 64);
+
+    // The same code point of another font stack is another glyph.
+    const Rect<uint16_t> a = atlas.addGlyph(1, "Font", glyph(65));
+    const Rect<uint16_t> b = atlas.addGlyph(1, "Other Font", glyph(65));
+    EXPECT_FALSE(a.x == b.x && a.y == b.y);
+
+    // Adding a glyph again in the same tile doesn't keep it alive any longer.
+    EXPECT_EQ(a.x, atlas.addGlyph(1, "Font", glyph(65)).x);
+    atlas.removeGlyphs(1);
+    for (uint32_t i = 0; i < 16; i++) {
+        EXPECT_TRUE(atlas.addGlyph(2, "Font", glyph(100 + i)));
+    }
+}
@@ -0,0 +1,142 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/text/glyph_cache.hpp>
+#include <mbgl/text/glyph_store.hpp>
+#include <mbgl/util/io.hpp>
+
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace mbgl;
+
+namespace {
+
+std::string temporaryDirectory() {
+    char path[] = "/tmp/mbgl-glyph-cache-XXXXXX";
+    return mkdtemp(path);
+}
+
+SDFGlyph glyph(uint32_t id, const std::string &bitmap, int32_t left) {
+    SDFGlyph sdf;
+    sdf.id = id;
+    sdf.bitmap = bitmap;
+    sdf.metrics.width = 10;
+    sdf.metrics.height = 12;
+    sdf.metrics.left = left;
+    sdf.metrics.top = -8;
+    sdf.metrics.advance = 11;
+    return sdf;
+}
+
+// Points into the bitmap of /glyph/.
+SDFGlyphRef ref(const SDFGlyph &glyph) {
+    SDFGlyphRef result;
+    result.id = glyph.id;
+    result.bitmap = glyph.bitmap.data();
+    result.bitmapSize = uint32_t(glyph.bitmap.size());
+    result.metrics = glyph.metrics;
+    return result;
+}
+
+std::string bitmap(const SDFGlyphRef *glyph) {
+    return std::string(glyph->bitmap, glyph->bitmapSize);
+}
+
+}
+
+TEST(GlyphCache, StoreAndLoad) {
+    const std::string directory = temporaryDirectory();
+    GlyphCache cache(directory);
+    const GlyphRange range { 0, 255 };
+
+    FontStack empty;
+    EXPECT_FALSE(cache.load("Open Sans Regular,Arial Unicode MS Regular", range, empty));
+
+    const SDFGlyph a = glyph(65, std::string("\x01\x02\x03\0\x05", 5), -1);
+    const SDFGlyph b = glyph(66, "", 2);
+    cache.store("Open Sans Regular,Arial Unicode MS Regular", range, {{ ref(a), ref(b) }});
+
+    FontStack stack;
+    ASSERT_TRUE(cache.load("Open Sans Regular,Arial Unicode MS Regular", range, stack));
+    ASSERT_TRUE(stack.getSDF(65));
+    EXPECT_EQ(std::string("\x01\x02\x03\0\x05", 5), bitmap(stack.getSDF(65)));
+    EXPECT_EQ(10, stack.getSDF(65)->metrics.width);
+    EXPECT_EQ(12, stack.getSDF(65)->metrics.height);
+    EXPECT_EQ(-1, stack.getSDF(65)->metrics.left);
+    EXPECT_EQ(-8, stack.getSDF(65)->metrics.top);
+    EXPECT_EQ(11, stack.getSDF(65)->metrics.advance);
+    ASSERT_TRUE(stack.getSDF(66));
+    EXPECT_EQ("", bitmap(stack.getSDF(66)));
+    EXPECT_EQ(2, stack.getMetrics(66)->left);
+    EXPECT_FALSE(stack.getSDF(67));
+
+    // Other font stacks and ranges are separate.
+    FontStack other;
+    EXPECT_FALSE(cache.load("Open Sans Regular", range, other));
+    EXPECT_FALSE(cache.load("Open Sans Regular,Arial Unicode MS Regular", { 256, 511 }, other));
+}
+
+TEST(GlyphCache, Corrupt) {
+    const std::string directory = temporaryDirectory();
+    GlyphCache cache(directory);
+    const GlyphRange range { 0, 255 };
+
+    const SDFGlyph a = glyph(65, "abcdef", 0);
+    cache.store("Font", range, {{ ref(a) }});
+    const std::string path = directory + "/Font-0-255.glyphs";
+    const std::string data = util::read_file(path);
+
+    // Truncated files are rejected as a whole.
+    util::write_file(path, data.substr(0, data.size() - 2));
+    FontStack truncated;
+    EXPECT_FALSE(cache.load("Font", range, truncated));
+    EXPECT_FALSE(truncated.getSDF(65));
+
+    util::write_file(path, "not a glyph cache");
+    FontStack garbage;
+    EXPECT_FALSE(cache.load("Font", range, garbage));
+    EXPECT_FALSE(garbage.getSDF(65));
+}
+
+TEST(FontStack, Insert) {
+    FontStack stack;
+    stack.insert({{ glyph(65, "a", 0), glyph(0x4E00, "b", 0) }});
+    EXPECT_EQ("a", bitmap(stack.getSDF(65)));
+    EXPECT_EQ("b", bitmap(stack.getSDF(0x4E00)));
+    EXPECT_FALSE(stack.getSDF(66));
+    EXPECT_FALSE(stack.getSDF(0x20000));
+
+    // Glyphs that were looked up before stay valid when their range is inserted again.
+    const SDFGlyphRef *a = stack.getSDF(65);
+    stack.insert({{ glyph(66, "c", 0) }});
+    EXPECT_EQ("a", bitmap(a));
+    EXPECT_EQ("a", bitmap(stack.getSDF(65)));
+    EXPECT_EQ("c", bitmap(stack.getSDF(66)));
+}
+
+TEST(FontStack, InsertBuffer) {
+    FontStack stack;
+    std::weak_ptr<const std::string> weak;
+    {
+        auto buffer = std::make_shared<const std::string>("xyz");
+        weak = buffer;
+        SDFGlyphRef y;
+        y.id = 66;
+        y.bitmap = buffer->data() + 1;
+        y.bitmapSize = 2;
+        stack.insert(buffer, {{ y }});
+    }
+
+    // The bitmap isn't copied; the font stack keeps the buffer alive.
+    ASSERT_FALSE(weak.expired());
+    EXPECT_EQ(weak.lock()->data() + 1, stack.getSDF(66)->bitmap);
+    EXPECT_EQ("yz", bitmap(stack.getSDF(66)));
+
+    // Glyphs are found in a block regardless of the order they were inserted in.
+    stack.insert({{ glyph(67, "c", 0), glyph(65, "a", 0) }});
+    EXPECT_EQ("a", bitmap(stack.getSDF(65)));
+    EXPECT_EQ("yz", bitmap(stack.getSDF(66)));
+    EXPECT_EQ("c", bitmap(stack.getSDF(67)));
+    EXPECT_FALSE(stack.getSDF(68));
+}
@@ -7,6 +7,7 @@
 #include <mbgl/util/io.hpp>
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
+#include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
 
 #include <mbgl/platform/default/headless_view.hpp>
@@ -22,8 +23,107 @@
 #include <sys/prctl.h>
 #endif
 
+#include <cstdlib>
+#include <map>
+
+std::string test_directory;
 std::string base_directory;
 
+// Each fixture records how long parsing its tiles and drawing the frame took in milliseconds, the
+// draw calls and GL state changes of the frame, and the bytes that the map held afterwards. Runs
+// fail when a metric exceeds its value in the checked-in baseline by more than the budget allows:
+// baseline * ratio + slack. Fixtures or metrics that aren't in the baseline aren't checked. Set
+// MBGL_RECORD_PERFORMANCE to a file name to write the metrics of the run there as a new baseline.
+typedef std::map<std::string, double> Metrics;
+
+struct Budget {
+    double ratio = 1;
+    double slack = 0;
+};
+
+std::map<std::string, Budget> budgets;
+std::map<std::string, Metrics> baseline;
+std::map<std::string, Metrics> measured;
+
+void readPerformanceBaseline(const std::string &file) {
+    const std::string json = mbgl::util::read_file(file);
+    rapidjson::Document document;
+    document.Parse<0>(json.c_str());
+    if (document.HasParseError() || !document.IsObject()) {
+        throw std::runtime_error("Cannot parse " + file);
+    }
+
+    if (document.HasMember("budgets") && document["budgets"].IsObject()) {
+        const rapidjson::Value &list = document["budgets"];
+        for (auto it = list.MemberBegin(); it != list.MemberEnd(); it++) {
+            Budget &budget = budgets[it->name.GetString()];
+            if (it->value.HasMember("ratio")) budget.ratio = it->value["ratio"].GetDouble();
+            if (it->value.HasMember("slack")) budget.slack = it->value["slack"].GetDouble();
+        }
+    }
+
+    if (document.HasMember("baseline") && document["baseline"].IsObject()) {
+        const rapidjson::Value &fixtures = document["baseline"];
+        for (auto fixture = fixtures.MemberBegin(); fixture != fixtures.MemberEnd(); fixture++) {
+            Metrics &metrics = baseline[fixture->name.GetString()];
+            for (auto it = fixture->value.MemberBegin(); it != fixture->value.MemberEnd(); it++) {
+                metrics[it->name.GetString()] = it->value.GetDouble();
+            }
+        }
+    }
+}
+
+// Keeps the budgets, so that the file can replace the checked-in baseline as it is.
+void writePerformanceBaseline(const std::string &file) {
+    rapidjson::StringBuffer buffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.String("budgets");
+    writer.StartObject();
+    for (const auto &budget : budgets) {
+        writer.String(budget.first.c_str());
+        writer.StartObject();
+        writer.String("ratio");
+        writer.Double(budget.second.ratio);
+        writer.String("slack");
+        writer.Double(budget.second.slack);
+        writer.EndObject();
+    }
+    writer.EndObject();
+    writer.String("baseline");
+    writer.StartObject();
+    for (const auto &fixture : measured) {
+        writer.String(fixture.first.c_str());
+        writer.StartObject();
+        for (const auto &metric : fixture.second) {
+            writer.String(metric.first.c_str());
+            writer.Double(metric.second);
+        }
+        writer.EndObject();
+    }
+    writer.EndObject();
+    writer.EndObject();
+    mbgl::util::write_file(file, std::string(buffer.GetString()) + "\n");
+}
+
+void checkPerformance(const std::string &fixture, const Metrics &metrics) {
+    measured[fixture] = metrics;
+
+    const auto expected = baseline.find(fixture);
+    if (expected == baseline.end()) {
+        return;
+    }
+    for (const auto &metric : metrics) {
+        const auto value = expected->second.find(metric.first);
+        if (value == expected->second.end()) {
+            continue;
+        }
+        const Budget budget = budgets[metric.first];
+        EXPECT_LE(metric.second, value->second * budget.ratio + budget.slack)
+            << fixture << ": " << metric.first << " regressed from " << value->second;
+    }
+}
+
 namespace mbgl {
 namespace platform {
 
@@ -77,16 +177,24 @@ GTEST_API_ int main(int argc, char *argv[]) {
     std::string file { __FILE__ }; file = dirname(const_cast<char *>(file.c_str()));
     if (file[0] == '/') {
         // If __FILE__ is an absolute path, we don't have to guess from the argv 0.
-        base_directory = file + "/suite/";
+        test_directory = file + "/";
     } else {
         std::string argv0 { argv[0] }; argv0 = dirname(const_cast<char *>(argv0.c_str()));
-        base_directory = argv0 + "/" + file + "/suite/";
+        test_directory = argv0 + "/" + file + "/";
     }
+    base_directory = test_directory + "suite/";
+
+    readPerformanceBaseline(test_directory + "fixtures/headless/performance.json");
 
     testing::InitGoogleTest(&argc, argv);
     env = new ServerEnvironment();
     ::testing::AddGlobalTestEnvironment(env);
-    return RUN_ALL_TESTS();
+    const int result = RUN_ALL_TESTS();
+
+    if (const char *record = getenv("MBGL_RECORD_PERFORMANCE")) {
+        writePerformanceBaseline(record);
+    }
+    return result;
 }
 
 void rewriteLocalScheme(rapidjson::Value &value, rapidjson::Document::AllocatorType &allocator) {
@@ -203,6 +311,15 @@ TEST_P(HeadlessTest, render) {
         map.setBearing(bearing);
 
 
+        // Asking from the complete callback reports the memory usage right after the frame was
+        // drawn, when all tiles are loaded.
+        uint64_t memory = 0;
+        map.onComplete([&] {
+            map.getMemoryUsage([&](const MapMemoryUsage &usage) {
+                memory = usage.total.total();
+            });
+        });
+
         // Run the loop. It will terminate when we don't have any further listeners.
         map.run();
 
@@ -213,6 +330,29 @@ TEST_P(HeadlessTest, render) {
 
         const std::string image = util::compress_png(w, h, pixels.get());
         util::write_file(actual_image, image);
+
+        timestamp parse = 0;
+        for (const auto &source : map.getTileLatencies()) {
+            const auto phase = source.second.find("parse");
+            if (phase != source.second.end()) {
+                parse += phase->second.total;
+            }
+        }
+
+        // A static render draws a single frame.
+        timestamp frame = 0;
+        for (const FrameProfiler::Summary &summary : map.getFrameProfiler().summarize()) {
+            frame += summary.max;
+        }
+
+        const FrameStatistics statistics = map.getFrameStatistics();
+        checkPerformance(base + "/" + name, {
+            { "parse", double(parse) / 1e6 },
+            { "frame", double(frame) / 1e6 },
+            { "drawCalls", double(statistics.drawCalls) },
+            { "stateChanges", double(statistics.stateChanges) },
+            { "memory", double(memory) },
+        });
     }
 }
 
@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/util/image_kernels.hpp>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+// Sizes around the block sizes of the vectorized loops, so that every tail length is covered.
+const size_t maxPixels = 40;
+
+std::vector<uint8_t> randomPixels(size_t pixels, std::mt19937 &random) {
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> rgba(pixels * 4);
+    for (uint8_t &value : rgba) {
+        value = uint8_t(byte(random));
+    }
+    return rgba;
+}
+
+}
+
+TEST(ImageKernels, IsOpaque) {
+    for (size_t pixels = 0; pixels <= maxPixels; pixels++) {
+        std::vector<uint8_t> rgba(pixels * 4, 0x20);
+        for (size_t i = 0; i < pixels; i++) {
+            rgba[i * 4 + 3] = 0xFF;
+        }
+        EXPECT_TRUE(util::isOpaque(rgba.data(), pixels));
+
+        for (size_t i = 0; i < pixels; i++) {
+            rgba[i * 4 + 3] = 0xFE;
+            EXPECT_FALSE(util::isOpaque(rgba.data(), pixels)) << pixels << " " << i;
+            rgba[i * 4 + 3] = 0xFF;
+        }
+    }
+}
+
+TEST(ImageKernels, RGB565) {
+    std::mt19937 random(42);
+    for (size_t pixels = 0; pixels <= maxPixels; pixels++) {
+        const std::vector<uint8_t> rgba = randomPixels(pixels, random);
+
+        std::vector<uint16_t> expected(pixels);
+        for (size_t i = 0; i < pixels; i++) {
+            const uint8_t *src = rgba.data() + i * 4;
+            expected[i] = uint16_t(((src[0] * 31 + 127) / 255) << 11 |
+                                   ((src[1] * 63 + 127) / 255) << 5 |
+                                   ((src[2] * 31 + 127) / 255));
+        }
+
+        std::vector<uint16_t> converted(pixels);
+        util::convertRGBAToRGB565(rgba.data(), converted.data(), pixels);
+        EXPECT_EQ(expected, converted) << pixels;
+
+        std::vector<uint8_t> inPlace = rgba;
+        util::convertRGBAToRGB565(inPlace.data(), reinterpret_cast<uint16_t *>(inPlace.data()), pixels);
+        EXPECT_EQ(0, std::memcmp(expected.data(), inPlace.data(), pixels * 2)) << pixels;
+    }
+
+    // Every value of a channel rounds like the division does.
+    std::vector<uint8_t> ramp(256 * 4);
+    for (size_t i = 0; i < 256; i++) {
+        ramp[i * 4 + 0] = ramp[i * 4 + 1] = ramp[i * 4 + 2] = uint8_t(i);
+    }
+    std::vector<uint16_t> converted(256);
+    util::convertRGBAToRGB565(ramp.data(), converted.data(), 256);
+    for (uint32_t i = 0; i < 256; i++) {
+        EXPECT_EQ(uint16_t((i * 31 + 127) / 255 << 11 | (i * 63 + 127) / 255 << 5 | (i * 31 + 127) / 255), converted[i]);
+    }
+}
+
+TEST(ImageKernels, RGB) {
+    std::mt19937 random(7);
+    for (size_t pixels = 0; pixels <= maxPixels; pixels++) {
+        const std::vector<uint8_t> rgba = randomPixels(pixels, random);
+
+        std::vector<uint8_t> expected;
+        for (size_t i = 0; i < pixels; i++) {
+            expected.insert(expected.end(), rgba.begin() + i * 4, rgba.begin() + i * 4 + 3);
+        }
+
+        std::vector<uint8_t> converted(pixels * 3);
+        util::convertRGBAToRGB(rgba.data(), converted.data(), pixels);
+        EXPECT_EQ(expected, converted) << pixels;
+
+        std::vector<uint8_t> inPlace = rgba;
+        util::convertRGBAToRGB(inPlace.data(), inPlace.data(), pixels);
+        inPlace.resize(pixels * 3);
+        EXPECT_EQ(expected, inPlace) << pixels;
+    }
+}
+
+TEST(ImageKernels, FlipRows) {
+    for (size_t width : { 1, 3, 4, 5, 17 }) {
+        for (size_t height : { 0, 1, 2, 5 }) {
+            std::vector<uint32_t> pixels(width * height);
+            for (size_t i = 0; i < pixels.size(); i++) {
+                pixels[i] = uint32_t(i);
+            }
+            util::flipRows(pixels.data(), width, height);
+            for (size_t y = 0; y < height; y++) {
+                for (size_t x = 0; x < width; x++) {
+                    EXPECT_EQ((height - 1 - y) * width + x, pixels[y * width + x]);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/util/latency_histogram.hpp>
+#include <mbgl/map/tile_trace.hpp>
+
+using namespace mbgl;
+
+TEST(LatencyHistogram, Buckets) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.snapshot().count);
+    EXPECT_EQ(0u, histogram.snapshot().percentile(0.5));
+
+    histogram.add(500_nanoseconds);
+    histogram.add(1_microsecond);
+    histogram.add(3_microseconds);
+    histogram.add(3_milliseconds);
+
+    const LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+    EXPECT_EQ(4u, snapshot.count);
+    EXPECT_EQ(1u, snapshot.buckets[0]);
+    EXPECT_EQ(1u, snapshot.buckets[1]);
+    EXPECT_EQ(1u, snapshot.buckets[2]);
+    EXPECT_EQ(1u, snapshot.buckets[12]);
+    EXPECT_EQ((500 + 1000 + 3000 + 3000000) / 4u, snapshot.mean());
+
+    EXPECT_EQ(1_microsecond, snapshot.percentile(0));
+    EXPECT_EQ(2_microseconds, snapshot.percentile(0.5));
+    EXPECT_EQ(4_microseconds, snapshot.percentile(0.75));
+    EXPECT_EQ(4096_microseconds, snapshot.percentile(1));
+}
+
+TEST(LatencyHistogram, Overflow) {
+    LatencyHistogram histogram;
+    histogram.add(10000_seconds);
+    EXPECT_EQ(1u, histogram.snapshot().buckets[LatencyHistogram::bucketCount - 1]);
+}
+
+TEST(LatencyHistogram, Merge) {
+    LatencyHistogram a, b;
+    a.add(1_microsecond);
+    b.add(1_microsecond);
+    b.add(1_millisecond);
+
+    LatencyHistogram::Snapshot snapshot = a.snapshot();
+    snapshot += b.snapshot();
+    EXPECT_EQ(3u, snapshot.count);
+    EXPECT_EQ(2u, snapshot.buckets[1]);
+    EXPECT_EQ(1002_microseconds, snapshot.total);
+}
+
+TEST(TileTrace, Latencies) {
+    TileTrace trace;
+    EXPECT_TRUE(trace.latencies().empty());
+
+    trace.add("mapbox", TileTrace::Phase::Network, 20_milliseconds);
+    trace.add("mapbox", TileTrace::Phase::Network, 30_milliseconds);
+    trace.add("mapbox", TileTrace::Phase::Parse, 5_milliseconds);
+    trace.add("satellite", TileTrace::Phase::Upload, 1_millisecond);
+
+    const TileLatencies latencies = trace.latencies();
+    ASSERT_EQ(2u, latencies.size());
+    ASSERT_EQ(2u, latencies.at("mapbox").size());
+    EXPECT_EQ(2u, latencies.at("mapbox").at("network").count);
+    EXPECT_EQ(1u, latencies.at("mapbox").at("parse").count);
+    ASSERT_EQ(1u, latencies.at("satellite").size());
+    EXPECT_EQ(1u, latencies.at("satellite").at("upload").count);
+}
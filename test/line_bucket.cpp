@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/renderer/line_bucket.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+struct Vertex {
+    int16_t x, y;
+    int8_t extrudeX, extrudeY;
+    int32_t linesofar;
+};
+
+std::vector<Vertex> vertices(const LineVertexBuffer &buffer) {
+    std::vector<Vertex> result;
+    for (size_t i = 0; i < buffer.index(); i++) {
+        const int16_t *coords = reinterpret_cast<const int16_t *>(buffer.data(i));
+        const int8_t *extrude = reinterpret_cast<const int8_t *>(coords);
+        result.push_back({ coords[0], coords[1], extrude[4], extrude[5], extrude[6] * 128 + extrude[7] });
+    }
+    return result;
+}
+
+}
+
+TEST(LineBucket, MiterJoin) {
+    LineVertexBuffer buffer;
+    TriangleElementsBuffer triangles;
+    StyleBucketLine properties;
+
+    LineBucket bucket(buffer, triangles, properties);
+    bucket.addGeometry(std::vector<Coordinate> { { 0, 0 }, { 10, 0 }, { 10, 10 } });
+
+    // Two vertices per vertex of the line, and two triangles per segment.
+    const std::vector<Vertex> all = vertices(buffer);
+    ASSERT_EQ(6u, all.size());
+    EXPECT_EQ(4u, triangles.index());
+
+    // The ends are extruded perpendicular to the line, and the corner along the bisector. The
+    // lowest bit of the position tells the sides apart.
+    EXPECT_EQ(0, all[0].x);
+    EXPECT_EQ(0, all[0].y);
+    EXPECT_EQ(1, all[1].y);
+    EXPECT_EQ(0, all[0].extrudeX);
+    EXPECT_EQ(63, all[0].extrudeY);
+    EXPECT_EQ(-63, all[1].extrudeY);
+    EXPECT_EQ(-63, all[2].extrudeX);
+    EXPECT_EQ(63, all[2].extrudeY);
+    EXPECT_EQ(63, all[3].extrudeX);
+    EXPECT_EQ(-63, all[3].extrudeY);
+    EXPECT_EQ(-63, all[4].extrudeX);
+    EXPECT_EQ(0, all[4].extrudeY);
+
+    EXPECT_EQ(0, all[1].linesofar);
+    EXPECT_EQ(10, all[2].linesofar);
+    EXPECT_EQ(20, all[5].linesofar);
+}
+
+TEST(LineBucket, DuplicateVertices) {
+    StyleBucketLine properties;
+    properties.join = JoinType::Round;
+    properties.cap = CapType::Round;
+
+    LineVertexBuffer buffer;
+    TriangleElementsBuffer triangles;
+    LineBucket bucket(buffer, triangles, properties);
+    bucket.addGeometry(std::vector<Coordinate> { { 0, 0 }, { 10, 0 }, { 10, 5 }, { 0, 5 } });
+
+    LineVertexBuffer duplicateBuffer;
+    TriangleElementsBuffer duplicateTriangles;
+    LineBucket duplicateBucket(duplicateBuffer, duplicateTriangles, properties);
+    duplicateBucket.addGeometry(std::vector<Coordinate> { { 0, 0 }, { 10, 0 }, { 10, 0 }, { 10, 5 }, { 0, 5 } });
+
+    // Vertices that are followed by a duplicate are skipped.
+    ASSERT_EQ(buffer.index(), duplicateBuffer.index());
+    EXPECT_EQ(triangles.index(), duplicateTriangles.index());
+    const std::vector<Vertex> all = vertices(buffer), duplicate = vertices(duplicateBuffer);
+    for (size_t i = 0; i < all.size(); i++) {
+        EXPECT_EQ(all[i].x, duplicate[i].x);
+        EXPECT_EQ(all[i].y, duplicate[i].y);
+        EXPECT_EQ(all[i].extrudeX, duplicate[i].extrudeX);
+        EXPECT_EQ(all[i].extrudeY, duplicate[i].extrudeY);
+        EXPECT_EQ(all[i].linesofar, duplicate[i].linesofar);
+    }
+
+    // Lines without a segment add nothing.
+    bucket.addGeometry(std::vector<Coordinate> { { 3, 3 }, { 3, 3 }, { 3, 3 } });
+    EXPECT_EQ(duplicateBuffer.index(), buffer.index());
+}
+
+TEST(LineBucket, ClosedLine) {
+    LineVertexBuffer buffer;
+    TriangleElementsBuffer triangles;
+    StyleBucketLine properties;
+    properties.cap = CapType::Square;
+
+    LineBucket bucket(buffer, triangles, properties);
+    bucket.addGeometry(std::vector<Coordinate> { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 }, { 0, 0 } });
+
+    // Closed lines have no caps, and join their last vertex like the first.
+    const std::vector<Vertex> all = vertices(buffer);
+    ASSERT_EQ(10u, all.size());
+    EXPECT_EQ(8u, triangles.index());
+    EXPECT_EQ(all[0].extrudeX, all[8].extrudeX);
+    EXPECT_EQ(all[0].extrudeY, all[8].extrudeY);
+    EXPECT_EQ(63, all[0].extrudeX);
+    EXPECT_EQ(63, all[0].extrudeY);
+
+    // The distance starts with the length of the last segment.
+    EXPECT_EQ(10, all[0].linesofar);
+    EXPECT_EQ(50, all[8].linesofar);
+}
@@ -0,0 +1,186 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/text/glyph_sdf.hpp>
+#include <mbgl/text/glyph_store.hpp>
+#include <mbgl/platform/glyph_rasterizer.hpp>
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/util/std.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+GlyphBitmap square(uint32_t size) {
+    GlyphBitmap bitmap;
+    bitmap.width = size;
+    bitmap.height = size;
+    bitmap.coverage.assign(size * size, char(255));
+    bitmap.left = 1;
+    bitmap.top = -4;
+    bitmap.advance = size + 2;
+    return bitmap;
+}
+
+uint8_t at(const SDFGlyph &glyph, uint32_t x, uint32_t y) {
+    return glyph.bitmap[y * (glyph.metrics.width + 6) + x];
+}
+
+// Draws a square for every glyph but the ones at the end of a range.
+class SquareRasterizer : public GlyphRasterizer {
+public:
+    SquareRasterizer(uint32_t &calls_) : calls(calls_) {}
+
+    bool rasterize(const std::string &, char32_t glyph, GlyphBitmap &bitmap) {
+        calls++;
+        if ((glyph & 0xFF) == 0xFF) {
+            return false;
+        }
+        bitmap = square(8);
+        return true;
+    }
+
+private:
+    uint32_t &calls;
+};
+
+class NoFileSource : public FileSource {
+public:
+    void setLoop(uv_loop_t *) {}
+    bool hasLoop() { return true; }
+    void clearLoop() {}
+    void setBase(std::string) {}
+    std::unique_ptr<Request> request(ResourceType, const std::string &) { return nullptr; }
+    void prepare(std::function<void()>) { prepared++; }
+    size_t releaseMemory() { return 0; }
+
+    uint32_t prepared = 0;
+};
+
+}
+
+TEST(LocalGlyphs, SDFOfSquare) {
+    const SDFGlyph glyph = makeSDFGlyph(0x4E00, square(10));
+    EXPECT_EQ(0x4E00u, glyph.id);
+    EXPECT_EQ(10u, glyph.metrics.width);
+    EXPECT_EQ(10u, glyph.metrics.height);
+    EXPECT_EQ(1, glyph.metrics.left);
+    EXPECT_EQ(-4, glyph.metrics.top);
+    EXPECT_EQ(12u, glyph.metrics.advance);
+    ASSERT_EQ(16u * 16u, glyph.bitmap.size());
+
+    // Deep inside, the distance is clamped.
+    EXPECT_EQ(255, at(glyph, 8, 8));
+
+    // The outline lies between the border and the first row of the glyph.
+    EXPECT_GT(at(glyph, 8, 3), 192);
+    EXPECT_LT(at(glyph, 8, 2), 192);
+
+    // Values fall off with the distance from the glyph.
+    EXPECT_GT(at(glyph, 8, 2), at(glyph, 8, 1));
+    EXPECT_GT(at(glyph, 8, 1), at(glyph, 8, 0));
+    EXPECT_GT(at(glyph, 1, 8), at(glyph, 0, 0));
+
+    // The field is symmetric.
+    for (uint32_t y = 0; y < 16; y++) {
+        for (uint32_t x = 0; x < 16; x++) {
+            EXPECT_EQ(at(glyph, x, y), at(glyph, 15 - x, y));
+            EXPECT_EQ(at(glyph, x, y), at(glyph, y, x));
+        }
+    }
+}
+
+TEST(LocalGlyphs, EmptyBitmap) {
+    GlyphBitmap space;
+    space.advance = 6;
+    const SDFGlyph glyph = makeSDFGlyph(0x3000, space);
+    EXPECT_TRUE(glyph.bitmap.empty());
+    EXPECT_EQ(0u, glyph.metrics.width);
+    EXPECT_EQ(6u, glyph.metrics.advance);
+}
+
+TEST(LocalGlyphs, CoveredRangesAreDrawn) {
+    NoFileSource fileSource;
+    GlyphStore store(fileSource);
+    uint32_t calls = 0;
+    store.setLocalGlyphRasterizer(util::make_unique<SquareRasterizer>(calls), { { 0x4E00, 0x9FFF } });
+
+    const std::string fontStack = "Open Sans Regular";
+    EXPECT_TRUE(store.requestGlyphRanges(fontStack, { GlyphRange { 0x4E00, 0x4EFF } }));
+    EXPECT_EQ(0u, fileSource.prepared);
+    EXPECT_EQ(256u, calls);
+
+    const FontStack &stack = store.getFontStack(fontStack);
+    ASSERT_NE(nullptr, stack.getSDF(0x4E01));
+    EXPECT_EQ(8u, stack.getSDF(0x4E01)->metrics.width);
+    EXPECT_EQ(nullptr, stack.getSDF(0x4EFF));
+
+    // The range is only drawn once.
+    EXPECT_TRUE(store.requestGlyphRanges(fontStack, { GlyphRange { 0x4E00, 0x4EFF } }));
+    EXPECT_EQ(256u, calls);
+
+    // Ranges that are only partially covered are loaded from the glyph URL.
+    EXPECT_FALSE(store.requestGlyphRanges(fontStack, { GlyphRange { 0x9F00, 0xA0FF } }));
+    EXPECT_EQ(1u, fileSource.prepared);
+    EXPECT_EQ(256u, calls);
+}
+
+namespace {
+
+void appendVarint(std::string &pbf, uint64_t value) {
+    while (value >= 0x80) {
+        pbf += char(0x80 | (value & 0x7F));
+        value >>= 7;
+    }
+    pbf += char(value);
+}
+
+void appendField(std::string &pbf, uint32_t tag, uint64_t value) {
+    appendVarint(pbf, tag << 3);
+    appendVarint(pbf, value);
+}
+
+void appendMessage(std::string &pbf, uint32_t tag, const std::string &message) {
+    appendVarint(pbf, tag << 3 | 2);
+    appendVarint(pbf, message.size());
+    pbf += message;
+}
+
+// A glyph PBF with a single glyph of the given size, without a bitmap.
+std::string glyphPBF(uint32_t id, uint32_t size) {
+    std::string glyph;
+    appendField(glyph, 1, id);
+    appendField(glyph, 3, size);
+    appendField(glyph, 4, size);
+    appendField(glyph, 7, size + 2);
+
+    std::string stack;
+    appendMessage(stack, 3, glyph);
+
+    std::string pbf;
+    appendMessage(pbf, 1, stack);
+    return pbf;
+}
+
+}
+
+TEST(LocalGlyphs, AddedRangesAreParsed) {
+    NoFileSource fileSource;
+    GlyphStore store(fileSource);
+
+    const std::string fontStack = "Open Sans Regular";
+    const GlyphRange range { 0, 255 };
+    store.addGlyphRange(fontStack, range, std::make_shared<const std::string>(glyphPBF(65, 10)));
+
+    // Adding a range again doesn't replace it.
+    store.addGlyphRange(fontStack, range, std::make_shared<const std::string>(glyphPBF(65, 20)));
+
+    EXPECT_TRUE(store.requestGlyphRanges(fontStack, { range }));
+    EXPECT_EQ(0u, fileSource.prepared);
+
+    const FontStack &stack = store.getFontStack(fontStack);
+    ASSERT_NE(nullptr, stack.getMetrics(65));
+    EXPECT_EQ(10u, stack.getMetrics(65)->width);
+    EXPECT_EQ(12u, stack.getMetrics(65)->advance);
+    EXPECT_EQ(nullptr, stack.getMetrics(66));
+}
@@ -0,0 +1,164 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/geometry/elements_buffer.hpp>
+#include <mbgl/geometry/fill_buffer.hpp>
+#include <mbgl/geometry/glyph_atlas.hpp>
+#include <mbgl/geometry/symbol_instance_buffer.hpp>
+#include <mbgl/geometry/symbol_placement_buffer.hpp>
+#include <mbgl/geometry/text_buffer.hpp>
+#include <mbgl/util/memory_usage.hpp>
+#include <mbgl/util/image.hpp>
+#include <mbgl/util/raster.hpp>
+#include <mbgl/util/texture_pool.hpp>
+
+#include <vector>
+
+using namespace mbgl;
+
+TEST(MemoryUsage, Buffer) {
+    FillVertexBuffer buffer;
+    EXPECT_EQ(0, buffer.memoryUsage().total());
+
+    for (int16_t i = 0; i < 10; i++) {
+        buffer.add(i, i);
+    }
+
+    // Buffers grow in steps, and nothing is on the GPU before the buffer was bound.
+    EXPECT_EQ(8192, buffer.memoryUsage().cpu);
+    EXPECT_EQ(0, buffer.memoryUsage().gpu);
+
+    // Buckets only count the elements they use.
+    EXPECT_EQ(4 * buffer.itemSize, buffer.memoryUsage(4).cpu);
+    EXPECT_EQ(0, buffer.memoryUsage(4).gpu);
+}
+
+TEST(MemoryUsage, BufferGrowth) {
+    FillVertexBuffer buffer;
+
+    // Reserved space is allocated at once.
+    buffer.reserve(5000);
+    EXPECT_EQ(5000 * buffer.itemSize, buffer.memoryUsage().cpu);
+    for (int16_t i = 0; i < 5000; i++) {
+        buffer.add(i, i);
+    }
+    EXPECT_EQ(5000 * buffer.itemSize, buffer.memoryUsage().cpu);
+
+    // Beyond that, the buffer doubles in size.
+    buffer.add(0, 0);
+    EXPECT_EQ(2 * 5000 * buffer.itemSize, buffer.memoryUsage().cpu);
+    EXPECT_EQ(5001, buffer.index());
+}
+
+TEST(MemoryUsage, ElementWidth) {
+    TriangleElementsBuffer narrow;
+    TriangleElementsBuffer wide(true);
+    narrow.add(0, 1, 2);
+    wide.add(0, 1, 70000);
+
+    // Unsigned int indices take twice the space, but let a group address all vertices.
+    EXPECT_EQ(6, narrow.memoryUsage(1).cpu);
+    EXPECT_EQ(12, wide.memoryUsage(1).cpu);
+    EXPECT_EQ(65535, narrow.maxGroupVertices());
+    EXPECT_EQ(std::numeric_limits<uint32_t>::max(), wide.maxGroupVertices());
+    EXPECT_EQ(GLenum(GL_UNSIGNED_INT), wide.elementType);
+}
+
+TEST(MemoryUsage, SymbolInstances) {
+    TextVertexBuffer vertices;
+    TriangleElementsBuffer triangles;
+    SymbolInstanceBuffer instances;
+    SymbolPlacementBuffer placements;
+
+    const vec2<float> tl(-1, -1), tr(1, -1), bl(-1, 1), br(1, 1);
+    EXPECT_EQ(0u, instances.add(10, 20, tl, tr, bl, br, Rect<uint16_t>(8, 8, 16, 16), 0, 25));
+    EXPECT_EQ(1u, instances.index());
+    EXPECT_EQ(0u, placements.add(1));
+
+    // An instance and its placement take less than half of the space of four vertices, their
+    // placements and two triangles.
+    const size_t quad = 4 * (vertices.itemSize + placements.itemSize) + 2 * triangles.itemSize;
+    const size_t instance = instances.memoryUsage(1).cpu + placements.memoryUsage(1).cpu;
+    EXPECT_EQ(28, instances.memoryUsage(1).cpu);
+    EXPECT_EQ(32u, instance);
+    EXPECT_LT(2 * instance, quad);
+}
+
+TEST(MemoryUsage, SymbolPlacements) {
+    SymbolPlacementBuffer placements;
+
+    // Quads are hidden until they are placed, and can be placed again.
+    EXPECT_EQ(0u, placements.add(4));
+    EXPECT_EQ(4u, placements.add(4));
+    const uint8_t *entries = reinterpret_cast<const uint8_t *>(placements.data(0));
+    EXPECT_EQ(255, entries[4 * 4 + 1]);
+
+    placements.set(4, 4, 12.5f, {{ 0, 2 * M_PI }}, 14);
+    EXPECT_EQ(140, entries[4 * 7 + 0]);
+    EXPECT_EQ(125, entries[4 * 7 + 1]);
+    EXPECT_EQ(255, entries[4 * 3 + 1]);
+
+    placements.hide(4, 4);
+    EXPECT_EQ(255, entries[4 * 7 + 1]);
+}
+
+TEST(MemoryUsage, GlyphAtlas) {
+    GlyphAtlas atlas(256, 128);
+    EXPECT_EQ(256 * 128, atlas.memoryUsage().cpu);
+    EXPECT_EQ(0, atlas.memoryUsage().gpu);
+}
+
+TEST(MemoryUsage, Raster) {
+    TexturePool pool;
+
+    // Opaque images are kept as RGB565 with all mipmap levels: 4x4, 2x2 and 1x1.
+    std::vector<uint8_t> pixels(4 * 4 * 4, 0xFF);
+    Raster opaque(pool);
+    ASSERT_TRUE(opaque.load(util::compress_png(4, 4, pixels.data())));
+    EXPECT_EQ(Raster::Format::RGB565, opaque.format);
+    EXPECT_EQ(3, opaque.levelCount);
+    EXPECT_EQ((16 + 4 + 1) * 2, opaque.memoryUsage().cpu);
+
+    pixels[3] = 0;
+    Raster translucent(pool);
+    ASSERT_TRUE(translucent.load(util::compress_png(4, 4, pixels.data())));
+    EXPECT_EQ(Raster::Format::RGBA, translucent.format);
+    EXPECT_EQ((16 + 4 + 1) * 4, translucent.memoryUsage().cpu);
+
+    // Only sides that are powers of two get mipmaps.
+    Raster npot(pool);
+    ASSERT_TRUE(npot.load(util::compress_png(3, 2, pixels.data())));
+    EXPECT_EQ(1, npot.levelCount);
+    EXPECT_EQ(3 * 2 * 4, npot.memoryUsage().cpu);
+}
+
+TEST(MemoryUsage, TexturePool) {
+    TexturePool pool(100);
+    TexturePool::Storage storage;
+    storage.bytes = 40;
+
+    pool.removeTextureID(1, storage);
+    pool.removeTextureID(2, storage);
+    EXPECT_EQ(80, pool.memoryUsage().gpu);
+
+    // Beyond its size, the pool lets go of the oldest textures.
+    pool.removeTextureID(3, storage);
+    EXPECT_EQ(80, pool.memoryUsage().gpu);
+
+    pool.clearTextureIDs();
+    EXPECT_EQ(0, pool.memoryUsage().total());
+}
+
+TEST(MemoryUsage, Sum) {
+    MemoryUsage usage(10, 20);
+    usage += MemoryUsage(1, 2);
+    EXPECT_EQ(11, usage.cpu);
+    EXPECT_EQ(22, usage.gpu);
+    EXPECT_EQ(33, usage.total());
+    EXPECT_EQ(36, (usage + MemoryUsage(3, 0)).total());
+}
+
+TEST(MemoryUsage, Difference) {
+    const MemoryUsage freed = MemoryUsage(10, 20) - MemoryUsage(4, 25);
+    EXPECT_EQ(6, freed.cpu);
+    EXPECT_EQ(0, freed.gpu);
+}
@@ -71,3 +71,16 @@ TEST(mergeLines, mergeLines) {
         EXPECT_EQ(input3[i].geometry, expected3[i].geometry);
     }
 }
+
+TEST(mergeLines, distinctLabels) {
+    // Labels that only differ outside of the lowest byte aren't merged.
+    std::vector<mbgl::SymbolFeature> input = {
+        { {{{0, 0}, {1, 0}}}, U"š", "" },
+        { {{{1, 0}, {2, 0}}}, U"ɡ", "" }
+    };
+
+    mbgl::util::mergeLines(input);
+
+    EXPECT_EQ(2u, input[0].geometry[0].size());
+    EXPECT_EQ(2u, input[1].geometry[0].size());
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/util/occlusion.hpp>
+
+#include <memory>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+std::vector<bool> occlusion(const std::vector<Tile::ID> &ids, bool *overlapping = nullptr) {
+    std::vector<std::unique_ptr<Tile>> tiles;
+    std::forward_list<Tile *> ptrs;
+    for (const Tile::ID &id : ids) {
+        tiles.emplace_back(new Tile(id));
+        ptrs.push_front(tiles.back().get());
+    }
+
+    const bool partly = updateOcclusion(ptrs);
+    if (overlapping) {
+        *overlapping = partly;
+    }
+
+    std::vector<bool> result;
+    for (const std::unique_ptr<Tile> &tile : tiles) {
+        result.push_back(tile->occluded);
+    }
+    return result;
+}
+
+}
+
+TEST(Occlusion, ParentAndFourChildren) {
+    EXPECT_EQ((std::vector<bool> { false, false, false, false, true }), occlusion({
+        Tile::ID { 1, 0, 0 }, Tile::ID { 1, 0, 1 }, Tile::ID { 1, 1, 0 }, Tile::ID { 1, 1, 1 },
+        Tile::ID { 0, 0, 0 },
+    }));
+}
+
+TEST(Occlusion, ParentAndThreeChildren) {
+    EXPECT_EQ((std::vector<bool> { false, false, false, false }), occlusion({
+        Tile::ID { 1, 0, 0 }, Tile::ID { 1, 0, 1 }, Tile::ID { 1, 1, 1 }, Tile::ID { 0, 0, 0 },
+    }));
+}
+
+TEST(Occlusion, Grandchildren) {
+    // One of the children is replaced by its own four children.
+    EXPECT_EQ((std::vector<bool> { true, false, false, false, false, false, false, false }), occlusion({
+        Tile::ID { 0, 0, 0 },
+        Tile::ID { 1, 0, 0 }, Tile::ID { 1, 0, 1 }, Tile::ID { 1, 1, 0 },
+        Tile::ID { 2, 2, 2 }, Tile::ID { 2, 2, 3 }, Tile::ID { 2, 3, 2 }, Tile::ID { 2, 3, 3 },
+    }));
+
+    // Without one of the grandchildren, the parent shows through.
+    EXPECT_EQ((std::vector<bool> { false, false, false, false, false, false, false }), occlusion({
+        Tile::ID { 0, 0, 0 },
+        Tile::ID { 1, 0, 0 }, Tile::ID { 1, 0, 1 }, Tile::ID { 1, 1, 0 },
+        Tile::ID { 2, 2, 2 }, Tile::ID { 2, 2, 3 }, Tile::ID { 2, 3, 2 },
+    }));
+}
+
+TEST(Occlusion, Wrapped) {
+    EXPECT_EQ((std::vector<bool> { false, false, false, false, true, false }), occlusion({
+        Tile::ID { 1, -2, 0 }, Tile::ID { 1, -2, 1 }, Tile::ID { 1, -1, 0 }, Tile::ID { 1, -1, 1 },
+        Tile::ID { 0, -1, 0 }, Tile::ID { 0, 0, 0 },
+    }));
+}
+
+TEST(Occlusion, Overlapping) {
+    bool overlapping = true;
+    occlusion({ Tile::ID { 1, 0, 0 }, Tile::ID { 1, 0, 1 }, Tile::ID { 1, 1, 0 } }, &overlapping);
+    EXPECT_FALSE(overlapping);
+
+    // An occluded parent isn't drawn, so it doesn't need to be clipped.
+    occlusion({
+        Tile::ID { 1, 0, 0 }, Tile::ID { 1, 0, 1 }, Tile::ID { 1, 1, 0 }, Tile::ID { 1, 1, 1 },
+        Tile::ID { 0, 0, 0 },
+    }, &overlapping);
+    EXPECT_FALSE(overlapping);
+
+    occlusion({ Tile::ID { 1, 0, 0 }, Tile::ID { 0, 0, 0 } }, &overlapping);
+    EXPECT_TRUE(overlapping);
+}
@@ -0,0 +1,45 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/renderer/render_item.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+RenderItem item(RenderPass pass, uint32_t order, RenderItem::Shader shader, uint16_t clip) {
+    return RenderItem { pass, order, shader, RenderItem::Texture::None, clip, 0, nullptr, nullptr };
+}
+
+}
+
+TEST(RenderItems, Sort) {
+    typedef RenderItem::Shader Shader;
+    std::vector<RenderItem> items {
+        item(RenderPass::Opaque, 0, Shader::Pattern, 1),
+        item(RenderPass::Opaque, 0, Shader::Plain, 2),
+        item(RenderPass::Translucent, 0, Shader::Symbol, 2),
+        item(RenderPass::Opaque, 1, Shader::Plain, 1),
+        item(RenderPass::Translucent, 0, Shader::Line, 1),
+        item(RenderPass::Opaque, 2, Shader::Plain, 1),
+        item(RenderPass::Translucent, 1, Shader::Plain, 1),
+    };
+
+    sortRenderItems(items);
+    ASSERT_EQ(7, items.size());
+
+    // Opaque items go top to bottom, and are grouped by shader and tile within a layer.
+    EXPECT_EQ(0, items[0].order);
+    EXPECT_EQ(Shader::Plain, items[0].shader);
+    EXPECT_EQ(2, items[0].clip);
+    EXPECT_EQ(0, items[1].order);
+    EXPECT_EQ(Shader::Pattern, items[1].shader);
+    EXPECT_EQ(1, items[2].order);
+    EXPECT_EQ(2, items[3].order);
+
+    // Translucent items keep their order.
+    EXPECT_EQ(RenderPass::Translucent, items[4].pass);
+    EXPECT_EQ(Shader::Symbol, items[4].shader);
+    EXPECT_EQ(Shader::Line, items[5].shader);
+    EXPECT_EQ(Shader::Plain, items[6].shader);
+}
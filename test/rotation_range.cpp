@@ -137,3 +137,37 @@ TEST(RotationRange, rotatingRotatingCollisions) {
         EXPECT_EQ(static_cast<std::size_t>(0), c.size());
     }
 }
+
+TEST(RotationRange, rotationRange) {
+    GlyphBox inserting(CollisionRect{{-1, -1}, {1, 1}}, CollisionAnchor{0, 0}, 0, 10, 0);
+    inserting.hBox = inserting.box;
+
+    PlacementBox blocker;
+    blocker.box = CollisionRect{{-1, -1}, {1, 1}};
+    blocker.hBox = blocker.box;
+    blocker.placementRange = {{0, 0}};
+
+    {
+        // boxes that can't reach each other at any rotation don't collide
+        blocker.anchor = CollisionAnchor{3, 0};
+        EXPECT_EQ(CollisionRange({{2.0f * float(M_PI), 0}}),
+                  rotationRange(inserting, blocker, 1));
+    }
+
+    {
+        // but do once the scale brings them close enough
+        blocker.anchor = CollisionAnchor{3, 0};
+        EXPECT_NE(CollisionRange({{2.0f * float(M_PI), 0}}),
+                  rotationRange(inserting, blocker, 0.85f));
+    }
+
+    {
+        // a rotating box against a fixed one
+        blocker.hBox = mapbox::util::optional<CollisionRect>();
+        blocker.anchor = CollisionAnchor{2.2f, 0};
+        EXPECT_NE(CollisionRange({{2.0f * float(M_PI), 0}}),
+                  rotationRange(inserting, blocker, 1));
+        EXPECT_EQ(CollisionRange({{2.0f * float(M_PI), 0}}),
+                  rotationRange(inserting, blocker, 2));
+    }
+}
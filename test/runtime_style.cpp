@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/style/style.hpp>
+#include <mbgl/style/style_layer.hpp>
+#include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/style/style_bucket.hpp>
+#include <mbgl/util/time.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+const char *styleJSON = R"JSON({
+    "version": 6,
+    "sources": {
+        "streets": { "type": "vector", "url": "mapbox://mapbox.mapbox-streets-v6" }
+    },
+    "layers": [{
+        "id": "road",
+        "type": "line",
+        "source": "streets",
+        "source-layer": "road",
+        "paint": { "line-color": "#000000", "line-width": 2 }
+    }, {
+        "id": "road-casing",
+        "type": "line",
+        "source": "streets",
+        "source-layer": "road",
+        "paint": { "line-color": "#ffffff", "line-width": 4 }
+    }]
+})JSON";
+
+void loadStyle(Style &style) {
+    style.loadJSON((const uint8_t *)styleJSON);
+    style.cascadeClasses({});
+    style.updateProperties(10, util::now());
+}
+
+}
+
+TEST(RuntimeStyle, PaintProperty) {
+    Style style;
+    loadStyle(style);
+
+    util::ptr<StyleLayer> road = style.layers->getLayer("road");
+    ASSERT_TRUE(bool(road));
+    EXPECT_EQ(2.0f, road->getProperties<LineProperties>().width);
+
+    const uint64_t generation = style.getGeneration();
+    const uint64_t layoutGeneration = style.getLayoutGeneration();
+    const util::ptr<StyleBucket> bucket = road->bucket;
+
+    EXPECT_TRUE(style.setPaintProperty("road", "line-width", "5", ""));
+    EXPECT_TRUE(style.setPaintProperty("road", "line-color", "\"#ff0000\"", ""));
+    style.updateProperties(10, util::now());
+
+    const LineProperties &properties = road->getProperties<LineProperties>();
+    EXPECT_EQ(5.0f, properties.width);
+    EXPECT_EQ(1.0f, properties.color[0]);
+    EXPECT_EQ(0.0f, properties.color[1]);
+
+    // Paint properties don't touch the buckets.
+    EXPECT_NE(generation, style.getGeneration());
+    EXPECT_EQ(layoutGeneration, style.getLayoutGeneration());
+    EXPECT_EQ(bucket, road->bucket);
+
+    // The other layer keeps its values.
+    EXPECT_EQ(4.0f, style.layers->getLayer("road-casing")->getProperties<LineProperties>().width);
+}
+
+TEST(RuntimeStyle, PaintPropertyInClass) {
+    Style style;
+    loadStyle(style);
+
+    util::ptr<StyleLayer> road = style.layers->getLayer("road");
+    EXPECT_TRUE(style.setPaintProperty("road", "line-width", "8", "night"));
+    style.updateProperties(10, util::now());
+    EXPECT_EQ(2.0f, road->getProperties<LineProperties>().width);
+
+    style.cascadeClasses({ "night" });
+    style.updateProperties(10, util::now());
+    EXPECT_EQ(8.0f, road->getProperties<LineProperties>().width);
+
+    // Changing the class while it is applied takes effect right away.
+    EXPECT_TRUE(style.setPaintProperty("road", "line-width", "6", "night"));
+    style.updateProperties(10, util::now());
+    EXPECT_EQ(6.0f, road->getProperties<LineProperties>().width);
+}
+
+TEST(RuntimeStyle, InvalidPaintProperty) {
+    Style style;
+    loadStyle(style);
+
+    const uint64_t generation = style.getGeneration();
+    EXPECT_FALSE(style.setPaintProperty("missing", "line-width", "5", ""));
+    EXPECT_FALSE(style.setPaintProperty("road", "line-wdith", "5", ""));
+    EXPECT_FALSE(style.setPaintProperty("road", "line-width", "{", ""));
+    EXPECT_EQ(generation, style.getGeneration());
+}
+
+TEST(RuntimeStyle, LayoutProperty) {
+    Style style;
+    loadStyle(style);
+
+    util::ptr<StyleLayer> road = style.layers->getLayer("road");
+    util::ptr<StyleLayer> casing = style.layers->getLayer("road-casing");
+
+    // Both layers read the same source layer with the same layout, so they share their bucket.
+    const util::ptr<StyleBucket> bucket = road->bucket;
+    ASSERT_EQ(bucket, casing->bucket);
+
+    const uint64_t layoutGeneration = style.getLayoutGeneration();
+    EXPECT_TRUE(style.setLayoutProperty("road", "visibility", "\"none\""));
+    EXPECT_NE(layoutGeneration, style.getLayoutGeneration());
+
+    // Only the changed layer gets a new bucket, under a name of its own.
+    EXPECT_NE(bucket, road->bucket);
+    EXPECT_EQ(bucket, casing->bucket);
+    EXPECT_NE(bucket->name, road->bucket->name);
+    EXPECT_EQ(VisibilityType::None, road->bucket->visibility);
+    EXPECT_EQ(VisibilityType::Visible, casing->bucket->visibility);
+    EXPECT_EQ(bucket->source_layer, road->bucket->source_layer);
+
+    // A bucket that isn't shared keeps its name.
+    const std::string name = road->bucket->name;
+    EXPECT_TRUE(style.setLayoutProperty("road", "line-join", "\"round\""));
+    EXPECT_EQ(name, road->bucket->name);
+    EXPECT_EQ(JoinType::Round, road->bucket->render.get<StyleBucketLine>().join);
+    EXPECT_EQ(VisibilityType::None, road->bucket->visibility);
+
+    EXPECT_FALSE(style.setLayoutProperty("missing", "visibility", "\"none\""));
+}
+
+TEST(RuntimeStyle, KeepUnchangedSourcesAndBuckets) {
+    Style style;
+    loadStyle(style);
+
+    const util::ptr<StyleBucket> bucket = style.layers->getLayer("road")->bucket;
+    const util::ptr<StyleSource> source = bucket->style_source;
+    const uint64_t layoutGeneration = style.getLayoutGeneration();
+
+    // The same source, a road with another layout, a casing with another paint, and a layer from
+    // a new source.
+    style.loadJSON((const uint8_t *)R"JSON({
+        "version": 6,
+        "sources": {
+            "streets": { "type": "vector", "url": "mapbox://mapbox.mapbox-streets-v6" },
+            "terrain": { "type": "vector", "url": "mapbox://mapbox.mapbox-terrain-v2" }
+        },
+        "layers": [{
+            "id": "road",
+            "type": "line",
+            "source": "streets",
+            "source-layer": "road",
+            "layout": { "line-join": "round" },
+            "paint": { "line-color": "#000000", "line-width": 2 }
+        }, {
+            "id": "road-casing",
+            "type": "line",
+            "source": "streets",
+            "source-layer": "road",
+            "paint": { "line-color": "#ff0000", "line-width": 6 }
+        }, {
+            "id": "contour",
+            "type": "line",
+            "source": "terrain",
+            "source-layer": "contour"
+        }]
+    })JSON");
+    EXPECT_NE(layoutGeneration, style.getLayoutGeneration());
+
+    util::ptr<StyleLayer> road = style.layers->getLayer("road");
+    util::ptr<StyleLayer> casing = style.layers->getLayer("road-casing");
+    EXPECT_EQ(bucket, casing->bucket);
+    EXPECT_EQ(source, casing->bucket->style_source);
+
+    EXPECT_NE(bucket, road->bucket);
+    EXPECT_NE(bucket->name, road->bucket->name);
+    EXPECT_EQ(source, road->bucket->style_source);
+    EXPECT_NE(source, style.layers->getLayer("contour")->bucket->style_source);
+
+    // A source with a different definition isn't kept, nor are its buckets.
+    style.loadJSON((const uint8_t *)R"JSON({
+        "version": 6,
+        "sources": {
+            "streets": { "type": "vector", "url": "mapbox://mapbox.mapbox-streets-v7" }
+        },
+        "layers": [{
+            "id": "road",
+            "type": "line",
+            "source": "streets",
+            "source-layer": "road"
+        }]
+    })JSON");
+    EXPECT_NE(source, style.layers->getLayer("road")->bucket->style_source);
+    EXPECT_NE(bucket, style.layers->getLayer("road")->bucket);
+}
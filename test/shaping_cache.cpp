@@ -0,0 +1,51 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/text/shaping_cache.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+ShapingCache::Key key(const std::u32string &text, float maxWidth = 10) {
+    return ShapingCache::Key { text, "Open Sans Regular", maxWidth, 1.2, 0.5, 0.5, 0.5, 0, { 0, 0 } };
+}
+
+util::ptr<const Shaping> shaping(uint32_t glyph) {
+    return std::make_shared<const Shaping>(Shaping { PositionedGlyph(glyph, 0, 0) });
+}
+
+}
+
+TEST(ShapingCache, Get) {
+    ShapingCache cache;
+    EXPECT_FALSE(bool(cache.get(key(U"Main Street"))));
+
+    const util::ptr<const Shaping> main = shaping(1);
+    cache.add(key(U"Main Street"), main);
+    EXPECT_EQ(main, cache.get(key(U"Main Street")));
+
+    // Every layout property is part of the key.
+    EXPECT_FALSE(bool(cache.get(key(U"Main Street", 20))));
+    EXPECT_FALSE(bool(cache.get(key(U"Main St"))));
+
+    // Adding the same key again replaces the shaping.
+    const util::ptr<const Shaping> replaced = shaping(2);
+    cache.add(key(U"Main Street"), replaced);
+    EXPECT_EQ(replaced, cache.get(key(U"Main Street")));
+    EXPECT_EQ(1, cache.size());
+}
+
+TEST(ShapingCache, Evict) {
+    ShapingCache cache(2);
+    cache.add(key(U"a"), shaping(1));
+    cache.add(key(U"b"), shaping(2));
+
+    // Using a makes b the least recently used shaping.
+    EXPECT_TRUE(bool(cache.get(key(U"a"))));
+    cache.add(key(U"c"), shaping(3));
+    EXPECT_EQ(2, cache.size());
+    EXPECT_TRUE(bool(cache.get(key(U"a"))));
+    EXPECT_FALSE(bool(cache.get(key(U"b"))));
+    EXPECT_TRUE(bool(cache.get(key(U"c"))));
+}
@@ -0,0 +1,28 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/util/simplify.hpp>
+
+using namespace mbgl;
+
+TEST(Simplify, Straight) {
+    // Vertices on the line between their neighbours don't contribute anything.
+    const std::vector<Coordinate> line = { { 0, 0 }, { 10, 0 }, { 20, 1 }, { 30, 0 }, { 40, 0 } };
+    const std::vector<Coordinate> expected = { { 0, 0 }, { 40, 0 } };
+    EXPECT_EQ(expected, util::simplify(line, 2));
+}
+
+TEST(Simplify, Corner) {
+    const std::vector<Coordinate> line = { { 0, 0 }, { 10, 1 }, { 20, 0 }, { 20, 10 }, { 20, 20 } };
+    const std::vector<Coordinate> expected = { { 0, 0 }, { 20, 0 }, { 20, 20 } };
+    EXPECT_EQ(expected, util::simplify(line, 2));
+
+    // Nothing is removed without a tolerance.
+    EXPECT_EQ(line, util::simplify(line, 0));
+}
+
+TEST(Simplify, Closed) {
+    // Rings keep their first and last vertex, so they stay closed.
+    const std::vector<Coordinate> ring = { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 5, 11 }, { 0, 10 }, { 0, 0 } };
+    const std::vector<Coordinate> expected = { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 }, { 0, 0 } };
+    EXPECT_EQ(expected, util::simplify(ring, 2));
+}
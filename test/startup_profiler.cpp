@@ -0,0 +1,34 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/util/startup_profiler.hpp>
+
+#include <thread>
+
+using namespace mbgl;
+
+TEST(StartupProfiler, Stages) {
+    StartupProfiler profiler;
+    EXPECT_FALSE(profiler.reached(StartupProfiler::Stage::Start));
+    EXPECT_EQ(0u, profiler.elapsed(StartupProfiler::Stage::Start));
+
+    // Stages before the start are reached, but take no time.
+    profiler.record(StartupProfiler::Stage::Style);
+    profiler.record(StartupProfiler::Stage::Start);
+    EXPECT_TRUE(profiler.reached(StartupProfiler::Stage::Style));
+    EXPECT_EQ(0u, profiler.elapsed(StartupProfiler::Stage::Style));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    profiler.record(StartupProfiler::Stage::FirstFrame);
+    const timestamp firstFrame = profiler.elapsed(StartupProfiler::Stage::FirstFrame);
+    EXPECT_GE(firstFrame, 2_millisecond);
+    EXPECT_FALSE(profiler.reached(StartupProfiler::Stage::Sprite));
+
+    // Only the first time a stage is reached counts.
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    profiler.record(StartupProfiler::Stage::FirstFrame);
+    EXPECT_EQ(firstFrame, profiler.elapsed(StartupProfiler::Stage::FirstFrame));
+
+    profiler.reset();
+    EXPECT_FALSE(profiler.reached(StartupProfiler::Stage::FirstFrame));
+    EXPECT_FALSE(profiler.reached(StartupProfiler::Stage::Start));
+}
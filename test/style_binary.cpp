@@ -0,0 +1,121 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/style/style.hpp>
+#include <mbgl/style/style_binary.hpp>
+#include <mbgl/style/style_layer.hpp>
+#include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/util/io.hpp>
+#include <mbgl/util/time.hpp>
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <cstdio>
+
+#include <unistd.h>
+
+using namespace mbgl;
+
+namespace {
+
+const char *styleJSON = R"JSON({
+    "version": 6,
+    "constants": { "@width": 3, "@road": "#ff0000", "@filter": ["==", "class", "@road"] },
+    "sources": {
+        "streets": { "type": "vector", "url": "mapbox://mapbox.mapbox-streets-v6" }
+    },
+    "layers": [{
+        "id": "road",
+        "type": "line",
+        "source": "streets",
+        "source-layer": "road",
+        "filter": "@filter",
+        "paint": { "line-color": "@road", "line-width": { "stops": [[10, "@width"], [20, 12.5]] } },
+        "paint.night": { "line-width": "@width" }
+    }],
+    "sprite": "mapbox://sprites/streets",
+    "glyphs": "mapbox://fonts/{fontstack}/{range}.pbf"
+})JSON";
+
+std::string compile(const char *json) {
+    rapidjson::Document doc;
+    doc.Parse<0>(json);
+    EXPECT_FALSE(doc.HasParseError());
+    return StyleBinary::compile(doc);
+}
+
+std::string stringify(const rapidjson::Value &value) {
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    value.Accept(writer);
+    return buffer.GetString();
+}
+
+}
+
+TEST(StyleBinary, RoundTrip) {
+    const std::string binary = compile(styleJSON);
+
+    rapidjson::Document doc;
+    ASSERT_TRUE(StyleBinary::decode(binary.data(), binary.size(), doc));
+
+    // The constants are gone, and the values that referred to them are resolved. Filters and the
+    // values of constants don't resolve any further.
+    EXPECT_EQ(R"({"version":6,"sources":{"streets":{"type":"vector","url":"mapbox://mapbox.mapbox-streets-v6"}},)"
+              R"("layers":[{"id":"road","type":"line","source":"streets","source-layer":"road",)"
+              R"("filter":["==","class","@road"],)"
+              R"("paint":{"line-color":"#ff0000","line-width":{"stops":[[10,3],[20,12.5]]}},)"
+              R"("paint.night":{"line-width":3}}],)"
+              R"("sprite":"mapbox://sprites/streets","glyphs":"mapbox://fonts/{fontstack}/{range}.pbf"})",
+              stringify(doc));
+
+    // Strings point into the compiled data.
+    const rapidjson::Value &id = doc["layers"][rapidjson::SizeType(0)]["id"];
+    EXPECT_GE(id.GetString(), binary.data());
+    EXPECT_LT(id.GetString(), binary.data() + binary.size());
+
+    // Numbers keep their type.
+    EXPECT_TRUE(doc["version"].IsInt());
+    EXPECT_TRUE(doc["layers"][rapidjson::SizeType(0)]["paint"]["line-width"]["stops"][rapidjson::SizeType(1)][rapidjson::SizeType(1)].IsDouble());
+}
+
+TEST(StyleBinary, InvalidData) {
+    const std::string binary = compile(styleJSON);
+    rapidjson::Document doc;
+
+    EXPECT_FALSE(StyleBinary::decode(binary.data(), 0, doc));
+    for (size_t length : { size_t(8), size_t(16), binary.size() / 2, binary.size() - 1 }) {
+        EXPECT_FALSE(StyleBinary::decode(binary.data(), length, doc)) << length;
+    }
+
+    std::string magic = binary;
+    magic[0] = 'X';
+    EXPECT_FALSE(StyleBinary::decode(magic.data(), magic.size(), doc));
+
+    std::string trailing = binary + '\0';
+    EXPECT_FALSE(StyleBinary::decode(trailing.data(), trailing.size(), doc));
+}
+
+TEST(StyleBinary, LoadStyle) {
+    char temp[] = "/tmp/mbgl-style-binary-XXXXXX";
+    close(mkstemp(temp));
+    const std::string path = temp;
+    util::write_file(path, compile(styleJSON));
+
+    Style style;
+    style.loadBinary(path);
+    std::remove(path.c_str());
+
+    style.cascadeClasses({ "night" });
+    style.updateProperties(10, util::now());
+
+    util::ptr<StyleLayer> road = style.layers->getLayer("road");
+    ASSERT_TRUE(bool(road));
+    EXPECT_EQ(3.0f, road->getProperties<LineProperties>().width);
+    EXPECT_EQ(1.0f, road->getProperties<LineProperties>().color[0]);
+    EXPECT_EQ("mapbox://sprites/streets", style.getSpriteURL());
+    EXPECT_EQ("mapbox://fonts/{fontstack}/{range}.pbf", style.glyph_url);
+
+    EXPECT_THROW(style.loadBinary(path), Style::exception);
+}
@@ -92,12 +92,506 @@
         }]
       ]
     },
+    { 'target_name': 'runtime_style',
+      'product_name': 'test_runtime_style',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './runtime_style.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone'
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'style_binary',
+      'product_name': 'test_style_binary',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './style_binary.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone'
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'geojson_tile_index',
+      'product_name': 'test_geojson_tile_index',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './geojson_tile_index.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone'
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'feature_index',
+      'product_name': 'test_feature_index',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './feature_index.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone'
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
     { 'target_name': 'variant',
       'product_name': 'test_variant',
       'type': 'executable',
       'sources': [
         './main.cpp',
-        './variant.cpp',
+        './variant.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'comparisons',
+      'product_name': 'test_comparisons',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './comparisons.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'filter_program',
+      'product_name': 'test_filter_program',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './filter_program.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'geometry',
+      'product_name': 'test_geometry',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './geometry.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'arena',
+      'product_name': 'test_arena',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './arena.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'buffer_pool',
+      'product_name': 'test_buffer_pool',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './buffer_pool.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'tile',
+      'product_name': 'test_tile',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './tile.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'functions',
+      'product_name': 'test_functions',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './functions.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'transform',
+      'product_name': 'test_transform',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './transform.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'tile_cache',
+      'product_name': 'test_tile_cache',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './tile_cache.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'memory_usage',
+      'product_name': 'test_memory_usage',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './memory_usage.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'allocation_tracker',
+      'product_name': 'test_allocation_tracker',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './allocation_tracker.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'circle_bucket',
+      'product_name': 'test_circle_bucket',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './circle_bucket.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'line_bucket',
+      'product_name': 'test_line_bucket',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './line_bucket.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'fill_bucket',
+      'product_name': 'test_fill_bucket',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './fill_bucket.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'merge_lines',
+      'product_name': 'test_merge_lines',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './merge_lines.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'token',
+      'product_name': 'test_token',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './token.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'simplify',
+      'product_name': 'test_simplify',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './simplify.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'triangulate',
+      'product_name': 'test_triangulate',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './triangulate.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'vertex_cache',
+      'product_name': 'test_vertex_cache',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './vertex_cache.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'collision',
+      'product_name': 'test_collision',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './collision.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'collision_grid',
+      'product_name': 'test_collision_grid',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './collision_grid.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'glyph_cache',
+      'product_name': 'test_glyph_cache',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './glyph_cache.cpp',
       ],
       'dependencies': [
         '../deps/gtest/gtest.gyp:gtest',
@@ -111,12 +605,12 @@
         }]
       ]
     },
-    { 'target_name': 'comparisons',
-      'product_name': 'test_comparisons',
+    { 'target_name': 'bucket_cache',
+      'product_name': 'test_bucket_cache',
       'type': 'executable',
       'sources': [
         './main.cpp',
-        './comparisons.cpp',
+        './bucket_cache.cpp',
       ],
       'dependencies': [
         '../deps/gtest/gtest.gyp:gtest',
@@ -130,12 +624,12 @@
         }]
       ]
     },
-    { 'target_name': 'tile',
-      'product_name': 'test_tile',
+    { 'target_name': 'glyph_atlas',
+      'product_name': 'test_glyph_atlas',
       'type': 'executable',
       'sources': [
         './main.cpp',
-        './tile.cpp',
+        './glyph_atlas.cpp',
       ],
       'dependencies': [
         '../deps/gtest/gtest.gyp:gtest',
@@ -149,12 +643,12 @@
         }]
       ]
     },
-    { 'target_name': 'functions',
-      'product_name': 'test_functions',
+    { 'target_name': 'shaping_cache',
+      'product_name': 'test_shaping_cache',
       'type': 'executable',
       'sources': [
         './main.cpp',
-        './functions.cpp',
+        './shaping_cache.cpp',
       ],
       'dependencies': [
         '../deps/gtest/gtest.gyp:gtest',
@@ -168,12 +662,259 @@
         }]
       ]
     },
-    { 'target_name': 'merge_lines',
-      'product_name': 'test_merge_lines',
+    { 'target_name': 'render_items',
+      'product_name': 'test_render_items',
       'type': 'executable',
       'sources': [
         './main.cpp',
-        './merge_lines.cpp',
+        './render_items.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'frame_profiler',
+      'product_name': 'test_frame_profiler',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './frame_profiler.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'trace',
+      'product_name': 'test_trace',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './trace.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'async_log',
+      'product_name': 'test_async_log',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './async_log.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'compression',
+      'product_name': 'test_compression',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './compression.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'image_kernels',
+      'product_name': 'test_image_kernels',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './image_kernels.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'local_glyphs',
+      'product_name': 'test_local_glyphs',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './local_glyphs.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'startup_profiler',
+      'product_name': 'test_startup_profiler',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './startup_profiler.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'vector_tile',
+      'product_name': 'test_vector_tile',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './vector_tile.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'latency_histogram',
+      'product_name': 'test_latency_histogram',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './latency_histogram.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'bandwidth_estimator',
+      'product_name': 'test_bandwidth_estimator',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './bandwidth_estimator.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'occlusion',
+      'product_name': 'test_occlusion',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './occlusion.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'element_bounds',
+      'product_name': 'test_element_bounds',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './element_bounds.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', { 'xcode_settings': { 'OTHER_LDFLAGS': [ '<@(ldflags)' ] }
+        }, {
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'applied_class_properties',
+      'product_name': 'test_applied_class_properties',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './applied_class_properties.cpp',
       ],
       'dependencies': [
         '../deps/gtest/gtest.gyp:gtest',
@@ -246,21 +987,110 @@
         }]
       ]
     },
+    { 'target_name': 'timer_wheel',
+      'product_name': 'test_timer_wheel',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './timer_wheel.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', {
+          'xcode_settings': {
+            'OTHER_CPLUSPLUSFLAGS': [ '<@(uv_cflags)' ],
+            'OTHER_LDFLAGS': [ '<@(ldflags)' ],
+          }
+        }, {
+          'cflags': [ '<@(uv_cflags)' ],
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
+    { 'target_name': 'worker',
+      'product_name': 'test_worker',
+      'type': 'executable',
+      'sources': [
+        './main.cpp',
+        './worker.cpp',
+      ],
+      'dependencies': [
+        '../deps/gtest/gtest.gyp:gtest',
+        '../mapboxgl.gyp:mbgl-standalone',
+      ],
+      'include_dirs': [ '../src' ],
+      'conditions': [
+        ['OS == "mac"', {
+          'xcode_settings': {
+            'OTHER_CPLUSPLUSFLAGS': [ '<@(uv_cflags)' ],
+            'OTHER_LDFLAGS': [ '<@(ldflags)' ],
+          }
+        }, {
+          'cflags': [ '<@(uv_cflags)' ],
+          'libraries': [ '<@(ldflags)' ],
+        }]
+      ]
+    },
     # Build all targets
     { 'target_name': 'test',
       'type': 'none',
       'dependencies': [
         'rotation_range',
+        'collision',
+        'collision_grid',
         'clip_ids',
         'enums',
         'variant',
         'tile',
         'functions',
         'merge_lines',
+        'token',
+        'applied_class_properties',
+        'render_items',
+        'frame_profiler',
+        'trace',
+        'startup_profiler',
+        'async_log',
+        'compression',
+        'image_kernels',
+        'local_glyphs',
+        'vector_tile',
+        'latency_histogram',
+        'bandwidth_estimator',
+        'occlusion',
+        'element_bounds',
+        'glyph_cache',
+        'bucket_cache',
+        'glyph_atlas',
+        'shaping_cache',
+        'simplify',
+        'triangulate',
+        'vertex_cache',
+        'transform',
+        'tile_cache',
+        'memory_usage',
+        'allocation_tracker',
+        'circle_bucket',
+        'line_bucket',
+        'fill_bucket',
         'headless',
         'style_parser',
+        'runtime_style',
+        'style_binary',
+        'geojson_tile_index',
+        'feature_index',
         'comparisons',
+        'filter_program',
+        'geometry',
+        'arena',
+        'buffer_pool',
         'text_conversions',
+        'timer_wheel',
+        'worker',
       ],
     }
   ]
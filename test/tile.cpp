@@ -2,6 +2,7 @@
 #include "gtest/gtest.h"
 
 #include <mbgl/map/tile.hpp>
+#include <mbgl/style/style_source.hpp>
 
 using namespace mbgl;
 
@@ -48,3 +49,37 @@ TEST(Variant, isChild) {
     ASSERT_TRUE(Tile::ID(3, -4, 0).isChildOf(Tile::ID(1, -1, 0)));
     ASSERT_TRUE(Tile::ID(3, -5, 0).isChildOf(Tile::ID(1, -2, 0)));
 }
+
+TEST(Source, ZoomOffset) {
+    SourceInfo vector;
+    EXPECT_EQ(0, vector.getZoomOffset(1));
+    EXPECT_EQ(0, vector.getZoomOffset(2));
+    vector.tile_size = 256;
+    EXPECT_EQ(1, vector.getZoomOffset(2));
+
+    // Raster tiles are scaled up on high resolution screens unless there is a variant for them.
+    SourceInfo raster;
+    raster.type = SourceType::Raster;
+    raster.tile_size = 256;
+    raster.tiles = { "http://example.com/{z}/{x}/{y}.png" };
+    EXPECT_EQ(1, raster.getZoomOffset(1));
+    EXPECT_EQ(2, raster.getZoomOffset(2));
+    raster.tiles = { "http://example.com/{z}/{x}/{y}{ratio}.png" };
+    EXPECT_EQ(1, raster.getZoomOffset(2));
+}
+
+TEST(Source, TileURL) {
+    rapidjson::Document document;
+    document.Parse<0>(R"JSON({ "tiles": [
+        "http://a.example.com/{z}/{x}/{y}{ratio}.png?key={prefix}&u={unknown}{",
+        "http://b.example.com/{z}/{x}/{y}.png"
+    ] })JSON");
+
+    SourceInfo info;
+    EXPECT_EQ("", info.tileURL(Tile::ID(1, 0, 0), 1));
+
+    info.parseTileJSONProperties(document);
+    EXPECT_EQ("http://a.example.com/14/8190/5454.png?key=ee&u={", info.tileURL(Tile::ID(14, 8190, 5454), 1));
+    EXPECT_EQ("http://a.example.com/3/1/1@2x.png?key=11&u={", info.tileURL(Tile::ID(3, 1, 1), 2));
+    EXPECT_EQ("http://b.example.com/3/1/2.png", info.tileURL(Tile::ID(3, 1, 2), 2));
+}
@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/map/tile_cache.hpp>
+#include <mbgl/map/tile_data.hpp>
+#include <mbgl/style/style_source.hpp>
+
+using namespace mbgl;
+
+class TileCacheTestData : public TileData {
+public:
+    TileCacheTestData(const Tile::ID &id_, const SourceInfo &info) : TileData(id_, info) {}
+
+    void parse() {}
+    void render(Painter &, const util::ptr<StyleLayer> &, const mat4 &) {}
+    bool hasData(StyleLayer const &) const { return false; }
+};
+
+TEST(TileCache, EvictsLeastRecentlyUsed) {
+    SourceInfo info;
+    TileCache cache(300);
+
+    cache.add(std::make_shared<TileCacheTestData>(Tile::ID(1, 0, 0), info), 100);
+    cache.add(std::make_shared<TileCacheTestData>(Tile::ID(1, 1, 0), info), 100);
+    cache.add(std::make_shared<TileCacheTestData>(Tile::ID(1, 0, 1), info), 100);
+    EXPECT_EQ(3, cache.size());
+    EXPECT_EQ(300, cache.getBytes());
+
+    // Taking a tile and putting it back makes it the most recently used one.
+    util::ptr<TileData> data = cache.take(Tile::ID(1, 0, 0));
+    ASSERT_TRUE(data.get());
+    EXPECT_EQ(Tile::ID(1, 0, 0), data->id);
+    EXPECT_FALSE(cache.has(Tile::ID(1, 0, 0)));
+    cache.add(data, 100);
+
+    cache.add(std::make_shared<TileCacheTestData>(Tile::ID(1, 1, 1), info), 150);
+    EXPECT_FALSE(cache.has(Tile::ID(1, 1, 0)));
+    EXPECT_FALSE(cache.has(Tile::ID(1, 0, 1)));
+    EXPECT_TRUE(cache.has(Tile::ID(1, 0, 0)));
+    EXPECT_TRUE(cache.has(Tile::ID(1, 1, 1)));
+    EXPECT_EQ(250, cache.getBytes());
+}
+
+TEST(TileCache, Budget) {
+    SourceInfo info;
+    TileCache cache(1000);
+
+    cache.add(std::make_shared<TileCacheTestData>(Tile::ID(2, 0, 0), info), 400);
+    cache.add(std::make_shared<TileCacheTestData>(Tile::ID(2, 1, 0), info), 400);
+
+    // Tiles that are larger than the whole budget aren't kept at all.
+    cache.add(std::make_shared<TileCacheTestData>(Tile::ID(2, 2, 0), info), 2000);
+    EXPECT_EQ(0, cache.size());
+    EXPECT_EQ(0, cache.getBytes());
+
+    cache.add(std::make_shared<TileCacheTestData>(Tile::ID(2, 0, 0), info), 400);
+    cache.add(std::make_shared<TileCacheTestData>(Tile::ID(2, 1, 0), info), 400);
+    cache.setMaxBytes(500);
+    EXPECT_EQ(1, cache.size());
+    EXPECT_TRUE(cache.has(Tile::ID(2, 1, 0)));
+
+    // Adding a tile again replaces it.
+    cache.add(std::make_shared<TileCacheTestData>(Tile::ID(2, 1, 0), info), 200);
+    EXPECT_EQ(1, cache.size());
+    EXPECT_EQ(200, cache.getBytes());
+
+    cache.clear();
+    EXPECT_EQ(0, cache.size());
+    EXPECT_EQ(0, cache.getBytes());
+    EXPECT_FALSE(cache.take(Tile::ID(2, 1, 0)).get());
+}
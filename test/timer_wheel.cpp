@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/storage/timer_wheel.hpp>
+
+#include <uv.h>
+
+#include <vector>
+
+using namespace mbgl;
+
+TEST(TimerWheel, Order) {
+    uv_loop_t *loop = uv_loop_new();
+    std::vector<int> fired;
+    {
+        TimerWheel timers(loop, 10, 4);
+
+        // Due after more than one turn of the wheel.
+        timers.schedule(95, [&] { fired.push_back(3); });
+        timers.schedule(30, [&] { fired.push_back(2); });
+        const TimerWheel::ID cancelled = timers.schedule(20, [&] { fired.push_back(0); });
+        timers.schedule(5, [&] {
+            fired.push_back(1);
+            // Callbacks may schedule others.
+            timers.schedule(200, [&] { fired.push_back(4); });
+        });
+        EXPECT_EQ(4u, timers.size());
+
+        EXPECT_TRUE(timers.cancel(cancelled));
+        EXPECT_FALSE(timers.cancel(cancelled));
+        EXPECT_FALSE(timers.cancel(0));
+        EXPECT_EQ(3u, timers.size());
+
+        const uint64_t start = uv_now(loop);
+        uv_run(loop, UV_RUN_DEFAULT);
+        EXPECT_LE(start + 200, uv_now(loop));
+        EXPECT_EQ(0u, timers.size());
+    }
+    uv_run(loop, UV_RUN_DEFAULT);
+    uv_loop_delete(loop);
+
+    EXPECT_EQ((std::vector<int> { 1, 2, 3, 4 }), fired);
+}
+
+TEST(TimerWheel, CancelDue) {
+    uv_loop_t *loop = uv_loop_new();
+    std::vector<int> fired;
+    {
+        TimerWheel timers(loop, 10, 4);
+
+        // Both are due in the same tick; the first one cancels the second.
+        TimerWheel::ID second = 0;
+        timers.schedule(5, [&] {
+            fired.push_back(1);
+            EXPECT_TRUE(timers.cancel(second));
+        });
+        second = timers.schedule(5, [&] { fired.push_back(2); });
+
+        uv_run(loop, UV_RUN_DEFAULT);
+    }
+    uv_run(loop, UV_RUN_DEFAULT);
+    uv_loop_delete(loop);
+
+    EXPECT_EQ(std::vector<int> { 1 }, fired);
+}
@@ -0,0 +1,48 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/util/token.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+std::string render(const util::TokenTemplate &tokens, const std::map<std::string, std::string> &values) {
+    std::string result;
+    tokens.render(result, [&](size_t token, std::string &out) {
+        const auto it = values.find(tokens.tokens()[token]);
+        if (it != values.end()) {
+            out.append(it->second);
+        }
+    });
+    return result;
+}
+
+}
+
+TEST(TokenTemplate, Tokens) {
+    const util::TokenTemplate tokens("{name} ({ref}) {name}");
+    ASSERT_EQ(2u, tokens.tokens().size());
+    EXPECT_EQ("name", tokens.tokens()[0]);
+    EXPECT_EQ("ref", tokens.tokens()[1]);
+}
+
+TEST(TokenTemplate, Render) {
+    const std::map<std::string, std::string> values = {{ "name", "Main St" }, { "ref", "A1" }};
+
+    EXPECT_EQ("Main St (A1)", render(util::TokenTemplate("{name} ({ref})"), values));
+    EXPECT_EQ("Main St", render(util::TokenTemplate("{name}{missing}"), values));
+    EXPECT_EQ("literal", render(util::TokenTemplate("literal"), values));
+    EXPECT_EQ("", render(util::TokenTemplate(""), values));
+}
+
+TEST(TokenTemplate, MatchesReplaceTokens) {
+    const std::map<std::string, std::string> values = {{ "name", "Main St" }, { "ref", "A1" }};
+    for (const std::string source : { "{name", "{na me}", "{{name}}", "{name}{ref}", "a {ref} b {" }) {
+        const std::string expected = util::replaceTokens(source, [&](const std::string &token) -> std::string {
+            const auto it = values.find(token);
+            return it != values.end() ? it->second : "";
+        });
+        EXPECT_EQ(expected, render(util::TokenTemplate(source), values)) << source;
+    }
+}
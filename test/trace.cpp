@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/platform/trace.hpp>
+#include <mbgl/util/frame_profiler.hpp>
+#include <mbgl/util/stopwatch.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+class RecordingTraceBackend : public TraceBackend {
+public:
+    void begin(const char *name) { events.push_back(std::string("B ") + name); }
+    void end() { events.push_back("E"); }
+    void beginAsync(const char *name, uint64_t cookie) {
+        events.push_back(std::string("S ") + name + " " + std::to_string(cookie));
+    }
+    void endAsync(const char *name, uint64_t cookie) {
+        events.push_back(std::string("F ") + name + " " + std::to_string(cookie));
+    }
+
+    std::vector<std::string> events;
+};
+
+}
+
+// Runs first, before the backend is set.
+TEST(Trace, Disabled) {
+    EXPECT_FALSE(Trace::isEnabled());
+    Trace::Scope scope("nothing");
+    Trace::BeginAsync("nothing", 1);
+    Trace::EndAsync("nothing", 1);
+}
+
+TEST(Trace, Scopes) {
+    const RecordingTraceBackend &backend = Trace::Set<RecordingTraceBackend>();
+    EXPECT_TRUE(Trace::isEnabled());
+
+    FrameProfiler profiler;
+    {
+        FrameProfiler::Scope frame(profiler, FrameProfiler::Phase::Upload);
+        util::stopwatch named("shader compilation", Event::Shader);
+        util::stopwatch unnamed(Event::ParseTile);
+        Trace::BeginAsync("tile request", 7);
+    }
+    Trace::EndAsync("tile request", 7);
+
+    const std::vector<std::string> expected = {
+        "B upload", "B shader compilation", "B ParseTile", "S tile request 7",
+        "E", "E", "E", "F tile request 7",
+    };
+    EXPECT_EQ(expected, backend.events);
+}
@@ -0,0 +1,103 @@
+#include <iostream>
+#include "gtest/gtest.h"
+
+#include <mbgl/map/transform.hpp>
+#include <mbgl/map/view.hpp>
+
+#include <atomic>
+#include <thread>
+
+using namespace mbgl;
+
+class TransformTestView : public View {
+public:
+    void swap() {}
+    void activate() {}
+    void deactivate() {}
+    void notify() {}
+    void notifyMapChange(MapChange, timestamp) {}
+};
+
+TEST(Transform, PredictedStateIsTransitionTarget) {
+    TransformTestView view;
+    Transform transform(view);
+    transform.resize(512, 512, 1, 512, 512);
+    transform.setLonLatZoom(0, 0, 2);
+
+    transform.setLonLatZoom(10, 20, 5, 1_second);
+
+    double lon, lat;
+    const TransformState current = transform.currentState();
+    EXPECT_DOUBLE_EQ(2, current.getZoom());
+    current.getLonLat(lon, lat);
+    EXPECT_NEAR(0, lon, 1e-6);
+
+    const TransformState predicted = transform.predictedState(500_milliseconds);
+    EXPECT_DOUBLE_EQ(5, predicted.getZoom());
+    predicted.getLonLat(lon, lat);
+    EXPECT_NEAR(10, lon, 1e-6);
+    EXPECT_NEAR(20, lat, 1e-6);
+}
+
+TEST(Transform, PredictedStateExtrapolatesPanning) {
+    TransformTestView view;
+    Transform transform(view);
+    transform.resize(512, 512, 1, 512, 512);
+    transform.setLonLatZoom(0, 0, 2);
+
+    // Without panning, we stay where we are.
+    double lon, lat;
+    transform.predictedState(500_milliseconds).getLonLat(lon, lat);
+    EXPECT_NEAR(0, lon, 1e-6);
+
+    transform.startPanning();
+    for (int i = 0; i < 5; i++) {
+        transform.moveBy(-10, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    double currentLon, currentLat;
+    transform.currentState().getLonLat(currentLon, currentLat);
+    EXPECT_GT(currentLon, 0);
+
+    // The map keeps moving east.
+    transform.predictedState(500_milliseconds).getLonLat(lon, lat);
+    EXPECT_GT(lon, currentLon);
+    EXPECT_NEAR(currentLat, lat, 1e-6);
+
+    transform.stopPanning();
+    transform.predictedState(500_milliseconds).getLonLat(lon, lat);
+    EXPECT_NEAR(currentLon, lon, 1e-6);
+}
+
+TEST(Transform, ConcurrentReadsSeeCompleteStates) {
+    TransformTestView view;
+    Transform transform(view);
+    transform.resize(512, 512, 1, 512, 512);
+    transform.setLonLatZoom(0, 0, 2);
+
+    // The writer only ever moves along the equator at zoom 2, so every state that a reader observes
+    // must have both of these, and never a mix of two states.
+    std::atomic<bool> done { false };
+    std::thread reader([&] {
+        while (!done) {
+            const TransformState state = transform.currentState();
+            double lon, lat;
+            state.getLonLat(lon, lat);
+            EXPECT_NEAR(0, lat, 1e-6);
+            EXPECT_DOUBLE_EQ(2, state.getZoom());
+            EXPECT_EQ(512, state.getWidth());
+        }
+    });
+
+    for (int i = 0; i < 10000; i++) {
+        transform.moveBy(i % 2 ? 7 : -7, 0);
+    }
+    done = true;
+    reader.join();
+
+    double lon, lat, zoom;
+    transform.getLonLatZoom(lon, lat, zoom);
+    EXPECT_NEAR(0, lon, 1e-6);
+    EXPECT_DOUBLE_EQ(2, zoom);
+}
@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/geometry/triangulate.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace mbgl;
+
+namespace {
+
+// Sums up the absolute area of all triangles.
+double area(const ClipperLib::Path &ring, const std::vector<uint32_t> &triangles) {
+    double sum = 0;
+    for (size_t i = 0; i < triangles.size(); i += 3) {
+        const ClipperLib::IntPoint &a = ring[triangles[i]];
+        const ClipperLib::IntPoint &b = ring[triangles[i + 1]];
+        const ClipperLib::IntPoint &c = ring[triangles[i + 2]];
+        sum += std::abs(double((b.X - a.X) * (c.Y - a.Y) - (b.Y - a.Y) * (c.X - a.X))) / 2;
+    }
+    return sum;
+}
+
+}
+
+TEST(Triangulate, Square) {
+    const ClipperLib::Path ring = { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 } };
+    std::vector<uint32_t> triangles;
+    ASSERT_TRUE(triangulate(ring, triangles));
+    EXPECT_EQ(6u, triangles.size());
+    EXPECT_EQ(100, area(ring, triangles));
+}
+
+TEST(Triangulate, Concave) {
+    // An L-shaped building in both orientations; the triangles must not cover the notch.
+    ClipperLib::Path ring = { { 0, 0 }, { 20, 0 }, { 20, 10 }, { 10, 10 }, { 10, 20 }, { 0, 20 } };
+    for (int i = 0; i < 2; i++) {
+        std::vector<uint32_t> triangles;
+        ASSERT_TRUE(triangulate(ring, triangles));
+        EXPECT_EQ(12u, triangles.size());
+        EXPECT_EQ(300, area(ring, triangles));
+        std::reverse(ring.begin(), ring.end());
+    }
+}
+
+TEST(Triangulate, Degenerate) {
+    std::vector<uint32_t> triangles = { 1, 2, 3 };
+    EXPECT_FALSE(triangulate({ { 0, 0 }, { 10, 0 }, { 20, 0 } }, triangles));
+    EXPECT_FALSE(triangulate({ { 0, 0 }, { 10, 0 } }, triangles));
+
+    // Failures leave the previous triangles alone.
+    EXPECT_EQ(3u, triangles.size());
+}
@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/map/vector_tile.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+// A tile with a single layer "water" that has the key "name" and the value "sea".
+std::shared_ptr<const std::string> makeTile() {
+    const std::string layer = std::string("\x0A\x05water", 7) +      // name
+                              std::string("\x1A\x04name", 6) +       // keys
+                              std::string("\x22\x05\x0A\x03sea", 7); // values
+    return std::make_shared<const std::string>(std::string("\x1A", 1) + char(layer.size()) + layer);
+}
+
+}
+
+TEST(VectorTile, SharedDecoding) {
+    const auto data = makeTile();
+
+    const util::ptr<VectorTile> tile = VectorTile::get(data);
+    EXPECT_EQ(tile, VectorTile::get(data));
+
+    // Equal data in another object is decoded separately.
+    EXPECT_NE(tile, VectorTile::get(makeTile()));
+
+    const auto layer = tile->getLayer("water");
+    ASSERT_TRUE(layer != nullptr);
+    EXPECT_EQ("water", layer->name);
+    ASSERT_EQ(1u, layer->keys.size());
+    EXPECT_EQ("name", layer->keys[0]);
+    ASSERT_EQ(1u, layer->values.size());
+    EXPECT_EQ("sea", layer->values[0].get<std::string>());
+    EXPECT_EQ(layer, tile->getLayer("water"));
+    EXPECT_EQ(nullptr, tile->getLayer("roads"));
+
+    // Layers that are still in use survive a trim; the tile decodes the layer again when it is
+    // asked for it the next time.
+    tile->trim(0);
+    EXPECT_EQ(0u, tile->memoryUsage());
+    EXPECT_EQ("water", layer->name);
+    EXPECT_NE(layer, tile->getLayer("water"));
+}
+
+TEST(VectorTile, Append) {
+    const std::string water = *makeTile();
+    const std::string roads = std::string("\x1A\x07\x0A\x05roads", 9);
+    const auto data = std::make_shared<const std::string>(water + roads);
+
+    // Layers are indexed as soon as all of their bytes arrived, regardless of how the data is
+    // split up.
+    const auto tile = std::make_shared<VectorTile>();
+    EXPECT_TRUE(tile->append(data->data(), 1).empty());
+    EXPECT_TRUE(tile->append(data->data() + 1, water.size() - 2).empty());
+    EXPECT_EQ(nullptr, tile->getLayer("water"));
+    EXPECT_EQ(std::vector<std::string>({ "water" }), tile->append(data->data() + water.size() - 1, 3));
+    EXPECT_EQ(water.size() + 2, tile->appendedSize());
+
+    const auto layer = tile->getLayer("water");
+    ASSERT_TRUE(layer != nullptr);
+    ASSERT_EQ(1u, layer->values.size());
+    EXPECT_EQ("sea", layer->values[0].get<std::string>());
+    EXPECT_EQ(nullptr, tile->getLayer("roads"));
+
+    EXPECT_EQ(std::vector<std::string>({ "roads" }),
+              tile->append(data->data() + water.size() + 2, roads.size() - 2));
+
+    // The complete data takes over the tile, along with the layers it decoded.
+    EXPECT_EQ(tile, VectorTile::get(data, tile));
+    EXPECT_EQ(layer, tile->getLayer("water"));
+    ASSERT_TRUE(tile->getLayer("roads") != nullptr);
+    EXPECT_EQ("roads", tile->getLayer("roads")->name);
+}
+
+TEST(VectorTile, AppendMismatch) {
+    const auto data = makeTile();
+
+    // Data that isn't what was appended gets a tile of its own.
+    const auto partial = std::make_shared<VectorTile>();
+    partial->append(data->data(), data->size() - 1);
+    EXPECT_NE(partial, VectorTile::get(data, partial));
+
+    std::string other = *data;
+    other.back() = 'x';
+    const auto changed = std::make_shared<VectorTile>();
+    changed->append(other.data(), other.size());
+    EXPECT_NE(changed, VectorTile::get(makeTile(), changed));
+
+    // Compressed data isn't indexed at all.
+    const auto compressed = std::make_shared<VectorTile>();
+    EXPECT_TRUE(compressed->append("\x1F\x8B\x08\x00", 4).empty());
+    EXPECT_TRUE(compressed->append(data->data(), data->size()).empty());
+    EXPECT_EQ(nullptr, compressed->getLayer("water"));
+}
@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/geometry/vertex_cache.hpp>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+using namespace mbgl;
+
+namespace {
+
+// Two triangles per cell of a grid with /size/ by /size/ cells, in random order.
+std::vector<TESSindex> shuffledGrid(int size) {
+    std::vector<std::array<TESSindex, 3>> triangles;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            const TESSindex a = y * (size + 1) + x, b = a + 1, c = a + size + 1, d = c + 1;
+            triangles.push_back({{ a, b, c }});
+            triangles.push_back({{ b, d, c }});
+        }
+    }
+    std::mt19937 random(42);
+    std::shuffle(triangles.begin(), triangles.end(), random);
+
+    std::vector<TESSindex> elements;
+    for (const std::array<TESSindex, 3> &triangle : triangles) {
+        elements.insert(elements.end(), triangle.begin(), triangle.end());
+    }
+    return elements;
+}
+
+// The triangles rotated to start with their smallest index, which keeps the winding, and sorted.
+std::vector<std::array<TESSindex, 3>> normalized(const std::vector<TESSindex> &elements) {
+    std::vector<std::array<TESSindex, 3>> triangles;
+    for (size_t i = 0; i + 2 < elements.size(); i += 3) {
+        std::array<TESSindex, 3> triangle {{ elements[i], elements[i + 1], elements[i + 2] }};
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+}
+
+TEST(VertexCache, Grid) {
+    const int size = 32;
+    const size_t vertex_count = (size + 1) * (size + 1);
+    const std::vector<TESSindex> original = shuffledGrid(size);
+    std::vector<TESSindex> elements = original;
+
+    ASSERT_TRUE(optimizeVertexCache(elements, vertex_count));
+    EXPECT_EQ(normalized(original), normalized(elements));
+
+    // Each vertex of a grid is shared by six triangles, so an ideal order transforms it about
+    // once. A random order transforms it nearly six times.
+    const size_t before = vertexCacheMisses(original), after = vertexCacheMisses(elements);
+    EXPECT_GT(before, 5 * vertex_count);
+    EXPECT_LT(after, 2 * vertex_count);
+    EXPECT_GE(after, vertex_count);
+}
+
+TEST(VertexCache, Undefined) {
+    std::vector<TESSindex> elements { 0, 1, 2, 2, 1, TESS_UNDEF };
+    const std::vector<TESSindex> original = elements;
+    EXPECT_FALSE(optimizeVertexCache(elements, 3));
+    EXPECT_EQ(original, elements);
+
+    // Indices must refer to one of the vertices.
+    elements = { 0, 1, 2, 2, 1, 3 };
+    EXPECT_FALSE(optimizeVertexCache(elements, 3));
+    EXPECT_TRUE(optimizeVertexCache(elements, 4));
+
+    elements.clear();
+    EXPECT_TRUE(optimizeVertexCache(elements, 0));
+}
+
+TEST(VertexCache, Misses) {
+    // The second triangle reuses two vertices. The last one needs the first vertex again after the
+    // fifth one evicted it.
+    EXPECT_EQ(4u, vertexCacheMisses({ 0, 1, 2, 2, 1, 3 }, 4));
+    EXPECT_EQ(6u, vertexCacheMisses({ 0, 1, 2, 2, 1, 3, 3, 4, 0 }, 4));
+}
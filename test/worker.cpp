@@ -0,0 +1,151 @@
+#include "gtest/gtest.h"
+
+#include <mbgl/util/uv_detail.hpp>
+#include <mbgl/util/parallel.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+std::atomic<int> done { 0 };
+
+void work(void *) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+void afterWork(void *) {
+    done++;
+}
+
+void runFor(uv_loop_t *loop, uint64_t ms) {
+    uv_timer_t timer;
+    uv_timer_init(loop, &timer);
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
+    uv_timer_start(&timer, [](uv_timer_t *, int) {}, ms, 0);
+#else
+    uv_timer_start(&timer, [](uv_timer_t *) {}, ms, 0);
+#endif
+    uv_run(loop, UV_RUN_DEFAULT);
+    uv_close((uv_handle_t *)&timer, nullptr);
+    uv_run(loop, UV_RUN_DEFAULT);
+}
+
+}
+
+TEST(Worker, GrowAndPark) {
+    uv_loop_t *loop = uv_loop_new();
+    {
+        uv::worker worker(loop, 2, "Test Worker");
+        worker.setIdleTimeout(50000000);
+
+        // No threads run until there's work.
+        EXPECT_EQ(0, worker.getStats().threads);
+
+        for (int i = 0; i < 6; i++) {
+            worker.add(nullptr, work, afterWork);
+        }
+        EXPECT_EQ(2, worker.getStats().threads);
+
+        uv_run(loop, UV_RUN_DEFAULT);
+        EXPECT_EQ(6, done);
+
+        uv_worker_stats_t stats = worker.getStats();
+        EXPECT_EQ(2, stats.peak_threads);
+        EXPECT_EQ(0u, stats.queued);
+        EXPECT_EQ(6u, stats.completed);
+        EXPECT_LE(6u * 20000000, stats.busy_time);
+
+        // Idle threads exit, and start again for new work.
+        runFor(loop, 200);
+        EXPECT_EQ(0, worker.getStats().threads);
+
+        worker.add(nullptr, work, afterWork);
+        EXPECT_EQ(1, worker.getStats().threads);
+        uv_run(loop, UV_RUN_DEFAULT);
+        EXPECT_EQ(7, done);
+    }
+    uv_run(loop, UV_RUN_DEFAULT);
+    uv_loop_delete(loop);
+}
+
+TEST(Worker, CloseWhileIdle) {
+    uv_loop_t *loop = uv_loop_new();
+    {
+        uv::worker worker(loop, 1);
+        worker.setIdleTimeout(10000000);
+        worker.add(nullptr, work, nullptr);
+        uv_run(loop, UV_RUN_DEFAULT);
+
+        // The thread may be exiting or gone when the worker closes.
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+    }
+    uv_run(loop, UV_RUN_DEFAULT);
+    uv_loop_delete(loop);
+}
+
+namespace {
+
+struct ParallelJob {
+    uv::worker *worker;
+    std::mutex mtx;
+    std::set<std::thread::id> threads;
+    int tasks = 0;
+    bool threw = false;
+};
+
+}
+
+TEST(Worker, Parallel) {
+    uv_loop_t *loop = uv_loop_new();
+    {
+        uv::worker worker(loop, 4);
+        ParallelJob job;
+        job.worker = &worker;
+
+        // The tasks are handed off by an item, like the buckets of a tile parse.
+        worker.add(&job, [](void *data) {
+            ParallelJob &parallel = *reinterpret_cast<ParallelJob *>(data);
+            std::vector<std::function<void ()>> tasks;
+            for (int i = 0; i < 8; i++) {
+                tasks.emplace_back([&parallel] {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    std::lock_guard<std::mutex> lock(parallel.mtx);
+                    parallel.threads.insert(std::this_thread::get_id());
+                    parallel.tasks++;
+                });
+            }
+            mbgl::util::runParallel(parallel.worker, tasks);
+            EXPECT_EQ(8, parallel.tasks);
+
+            tasks.emplace_back([] { throw std::runtime_error("failed"); });
+            try {
+                mbgl::util::runParallel(parallel.worker, tasks);
+            } catch (const std::runtime_error &) {
+                parallel.threw = true;
+            }
+            EXPECT_EQ(16, parallel.tasks);
+        }, nullptr);
+        uv_run(loop, UV_RUN_DEFAULT);
+
+        EXPECT_TRUE(job.threw);
+        EXPECT_LT(1u, job.threads.size());
+        EXPECT_GE(4u, job.threads.size());
+    }
+    uv_run(loop, UV_RUN_DEFAULT);
+    uv_loop_delete(loop);
+}
+
+TEST(Worker, ParallelWithoutWorker) {
+    int tasks = 0;
+    const std::thread::id thread = std::this_thread::get_id();
+    mbgl::util::runParallel(nullptr, {
+        [&] { tasks++; EXPECT_EQ(thread, std::this_thread::get_id()); },
+        [&] { tasks++; EXPECT_EQ(thread, std::this_thread::get_id()); },
+    });
+    EXPECT_EQ(2, tasks);
+}